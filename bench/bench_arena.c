@@ -0,0 +1,172 @@
+#define X_IMPL_ARENA
+#include <stdx_arena.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ALLOC_COUNT 1024
+#define CHUNK_SIZE (64 * 1024)
+
+// Mixed small sizes typical of parsers and string handling, 8 to 256 bytes
+static size_t s_sizes[ALLOC_COUNT];
+static void* s_ptrs[ALLOC_COUNT];
+
+static void s_init_sizes(void)
+{
+  uint32_t x = 2463534242u;
+  for (int32_t i = 0; i < ALLOC_COUNT; i++)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    s_sizes[i] = 8 + (x % 249);
+  }
+}
+
+static void bench_arena_alloc(XBench* b)
+{
+  XArena* arena = x_arena_create(CHUNK_SIZE);
+  x_bench_set_items(b, ALLOC_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    for (int32_t i = 0; i < ALLOC_COUNT; i++)
+      s_ptrs[i] = x_arena_alloc(arena, s_sizes[i]);
+    x_bench_keep(s_ptrs);
+    x_arena_reset(arena);
+  }
+  x_bench_pause(b);
+  x_arena_destroy(arena);
+}
+
+static void bench_arena_alloc_zero(XBench* b)
+{
+  XArena* arena = x_arena_create(CHUNK_SIZE);
+  x_bench_set_items(b, ALLOC_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    for (int32_t i = 0; i < ALLOC_COUNT; i++)
+      s_ptrs[i] = x_arena_alloc_zero(arena, s_sizes[i]);
+    x_bench_keep(s_ptrs);
+    x_arena_reset(arena);
+  }
+  x_bench_pause(b);
+  x_arena_destroy(arena);
+}
+
+static void bench_arena_mark_release(XBench* b)
+{
+  XArena* arena = x_arena_create(CHUNK_SIZE);
+  x_bench_set_items(b, ALLOC_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    // Scratch scopes of 16 allocations each
+    for (int32_t i = 0; i < ALLOC_COUNT; i += 16)
+    {
+      XArenaMark mark = x_arena_mark(arena);
+      for (int32_t k = i; k < i + 16; k++)
+        s_ptrs[k] = x_arena_alloc(arena, s_sizes[k]);
+      x_bench_keep(s_ptrs);
+      x_arena_release(arena, mark);
+    }
+  }
+  x_bench_pause(b);
+  x_arena_destroy(arena);
+}
+
+static void bench_arena_create_destroy(XBench* b)
+{
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XArena* arena = x_arena_create(CHUNK_SIZE);
+    x_bench_keep(x_arena_alloc(arena, 64));
+    x_arena_destroy(arena);
+  }
+}
+
+static void bench_malloc_free(XBench* b)
+{
+  x_bench_set_items(b, ALLOC_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    for (int32_t i = 0; i < ALLOC_COUNT; i++)
+      s_ptrs[i] = malloc(s_sizes[i]);
+    x_bench_keep(s_ptrs);
+    for (int32_t i = 0; i < ALLOC_COUNT; i++)
+      free(s_ptrs[i]);
+  }
+}
+
+static void bench_calloc_free(XBench* b)
+{
+  x_bench_set_items(b, ALLOC_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    for (int32_t i = 0; i < ALLOC_COUNT; i++)
+      s_ptrs[i] = calloc(1, s_sizes[i]);
+    x_bench_keep(s_ptrs);
+    for (int32_t i = 0; i < ALLOC_COUNT; i++)
+      free(s_ptrs[i]);
+  }
+}
+
+// Growing one buffer in place, the way builders use the last allocation
+static void bench_arena_realloc_last(XBench* b)
+{
+  XArena* arena = x_arena_create(CHUNK_SIZE);
+  x_bench_set_items(b, ALLOC_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    size_t size = 16;
+    void* p = x_arena_alloc(arena, size);
+    for (int32_t i = 0; i < ALLOC_COUNT; i++)
+    {
+      p = x_arena_realloc_last(arena, p, size, size + 16);
+      size += 16;
+    }
+    x_bench_keep(p);
+    x_arena_reset(arena);
+  }
+  x_bench_pause(b);
+  x_arena_destroy(arena);
+}
+
+static void bench_malloc_realloc(XBench* b)
+{
+  x_bench_set_items(b, ALLOC_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    size_t size = 16;
+    void* p = malloc(size);
+    for (int32_t i = 0; i < ALLOC_COUNT; i++)
+    {
+      size += 16;
+      p = realloc(p, size);
+    }
+    x_bench_keep(p);
+    free(p);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_arena_alloc),
+    X_BENCH(bench_arena_alloc_zero),
+    X_BENCH(bench_arena_mark_release),
+    X_BENCH(bench_arena_create_destroy),
+    X_BENCH(bench_arena_realloc_last),
+    X_BENCH(bench_malloc_free),
+    X_BENCH(bench_calloc_free),
+    X_BENCH(bench_malloc_realloc),
+  };
+
+  s_init_sizes();
+  return x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+}
@@ -0,0 +1,148 @@
+#define X_IMPL_ARRAY
+#include <stdx_array.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdlib.h>
+
+#define PUSH_COUNT 16384
+
+typedef struct Vertex
+{
+  float position[3];
+  float normal[3];
+  float uv[2];
+} Vertex;
+
+X_ARRAY_TYPE(int32_t)
+X_ARRAY_TYPE(Vertex)
+
+static void bench_array_push_i32(XBench* b)
+{
+  x_bench_set_items(b, PUSH_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XArray_int32_t* arr = x_array_int32_t_create(1);
+    for (int32_t i = 0; i < PUSH_COUNT; i++)
+      x_array_int32_t_push(arr, i);
+    x_bench_keep(x_array_int32_t_get(arr, PUSH_COUNT - 1));
+    x_array_int32_t_destroy(arr);
+  }
+}
+
+static void bench_array_push_i32_reserved(XBench* b)
+{
+  x_bench_set_items(b, PUSH_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XArray_int32_t* arr = x_array_int32_t_create(PUSH_COUNT);
+    for (int32_t i = 0; i < PUSH_COUNT; i++)
+      x_array_int32_t_push(arr, i);
+    x_bench_keep(x_array_int32_t_get(arr, PUSH_COUNT - 1));
+    x_array_int32_t_destroy(arr);
+  }
+}
+
+static void bench_array_push_i32_growth_1_5(XBench* b)
+{
+  x_bench_set_items(b, PUSH_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XArray* arr = x_array_create(sizeof(int32_t), 1);
+    x_array_set_growth(arr, 1.5f);
+    for (int32_t i = 0; i < PUSH_COUNT; i++)
+      x_array_add(arr, &i);
+    x_bench_keep(x_array_get(arr, PUSH_COUNT - 1));
+    x_array_destroy(arr);
+  }
+}
+
+static void bench_array_push_vertex(XBench* b)
+{
+  Vertex v = {{1.0f, 2.0f, 3.0f}, {0.0f, 1.0f, 0.0f}, {0.5f, 0.5f}};
+  x_bench_set_items(b, PUSH_COUNT);
+  x_bench_set_bytes(b, PUSH_COUNT * sizeof(Vertex));
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XArray_Vertex* arr = x_array_Vertex_create(1);
+    for (int32_t i = 0; i < PUSH_COUNT; i++)
+    {
+      v.uv[0] = (float)i;
+      x_array_Vertex_push_ptr(arr, &v);
+    }
+    x_bench_keep(x_array_Vertex_get(arr, PUSH_COUNT - 1));
+    x_array_Vertex_destroy(arr);
+  }
+}
+
+// Short-lived small arrays that never leave their inline storage
+static void bench_array_push_inline(XBench* b)
+{
+  int32_t storage[16];
+  x_bench_set_items(b, 16);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XArray arr;
+    x_array_init(&arr, sizeof(int32_t), storage, 16);
+    for (int32_t i = 0; i < 16; i++)
+      x_array_add(&arr, &i);
+    x_bench_keep(x_array_get(&arr, 15));
+    x_array_term(&arr);
+  }
+}
+
+static void bench_array_get_i32(XBench* b)
+{
+  XArray_int32_t* arr = x_array_int32_t_create(PUSH_COUNT);
+  for (int32_t i = 0; i < PUSH_COUNT; i++)
+    x_array_int32_t_push(arr, i);
+  x_bench_set_items(b, PUSH_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < PUSH_COUNT; i++)
+      sum += (uint64_t)*x_array_int32_t_get(arr, i);
+    x_bench_keep_u64(sum);
+  }
+  x_bench_pause(b);
+  x_array_int32_t_destroy(arr);
+}
+
+// Reference point: a hand-written doubling buffer
+static void bench_realloc_push_i32(XBench* b)
+{
+  x_bench_set_items(b, PUSH_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    size_t count = 0, capacity = 1;
+    int32_t* data = (int32_t*)malloc(capacity * sizeof(int32_t));
+    for (int32_t i = 0; i < PUSH_COUNT; i++)
+    {
+      if (count == capacity)
+      {
+        capacity *= 2;
+        data = (int32_t*)realloc(data, capacity * sizeof(int32_t));
+      }
+      data[count++] = i;
+    }
+    x_bench_keep(data);
+    free(data);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_array_push_i32),
+    X_BENCH(bench_array_push_i32_reserved),
+    X_BENCH(bench_array_push_i32_growth_1_5),
+    X_BENCH(bench_array_push_vertex),
+    X_BENCH(bench_array_push_inline),
+    X_BENCH(bench_array_get_i32),
+    X_BENCH(bench_realloc_push_i32),
+  };
+
+  return x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+}
@@ -0,0 +1,377 @@
+#define X_IMPL_HASHTABLE
+#include <stdx_hashtable.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KEY_COUNT 4096
+#define LOAD_CAPACITY 16384
+
+typedef struct BenchKey
+{
+  uint32_t a, b, c, d;
+} BenchKey;
+
+static char* s_str_keys[KEY_COUNT];
+static BenchKey s_struct_keys[KEY_COUNT];
+
+// Distinct, well spread integers: multiplying by an odd constant is a bijection
+static int32_t s_i32_key(uint32_t i)
+{
+  return (int32_t)(i * 2654435761u);
+}
+
+static void s_init_keys(void)
+{
+  for (uint32_t i = 0; i < KEY_COUNT; i++)
+  {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "user:%08x:session", (uint32_t)s_i32_key(i));
+    s_str_keys[i] = (char*)malloc(strlen(buf) + 1);
+    strcpy(s_str_keys[i], buf);
+    s_struct_keys[i].a = i;
+    s_struct_keys[i].b = i ^ 0x5bd1e995u;
+    s_struct_keys[i].c = (uint32_t)s_i32_key(i);
+    s_struct_keys[i].d = 7;
+  }
+}
+
+static void s_free_keys(void)
+{
+  for (uint32_t i = 0; i < KEY_COUNT; i++)
+    free(s_str_keys[i]);
+}
+
+static XHashtable* s_create_i32(void)
+{
+  return x_hashtable_create_ex(sizeof(int32_t), false, false, sizeof(int32_t), false, false);
+}
+
+static XHashtable* s_create_cstr(void)
+{
+  return x_hashtable_create_ex(sizeof(char*), true, true, sizeof(int32_t), false, false);
+}
+
+static XHashtable* s_create_struct(void)
+{
+  return x_hashtable_create_ex(sizeof(BenchKey), false, false, sizeof(int32_t), false, false);
+}
+
+static XHashtable* s_fill_i32(uint32_t count)
+{
+  XHashtable* t = s_create_i32();
+  x_hashtable_reserve(t, count);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    int32_t key = s_i32_key(i);
+    int32_t value = (int32_t)i;
+    x_hashtable_set(t, &key, &value);
+  }
+  return t;
+}
+
+//
+// Inserts into a fresh table, including its growth
+//
+
+static void bench_hashtable_set_i32(XBench* b)
+{
+  x_bench_set_items(b, KEY_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XHashtable* t = s_create_i32();
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+    {
+      int32_t key = s_i32_key(i);
+      int32_t value = (int32_t)i;
+      x_hashtable_set(t, &key, &value);
+    }
+    x_bench_keep(t);
+    x_hashtable_destroy(t);
+  }
+}
+
+static void bench_hashtable_set_i32_reserved(XBench* b)
+{
+  x_bench_set_items(b, KEY_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XHashtable* t = s_create_i32();
+    x_hashtable_reserve(t, KEY_COUNT);
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+    {
+      int32_t key = s_i32_key(i);
+      int32_t value = (int32_t)i;
+      x_hashtable_set(t, &key, &value);
+    }
+    x_bench_keep(t);
+    x_hashtable_destroy(t);
+  }
+}
+
+static void bench_hashtable_set_cstr(XBench* b)
+{
+  x_bench_set_items(b, KEY_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XHashtable* t = s_create_cstr();
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+    {
+      int32_t value = (int32_t)i;
+      x_hashtable_set(t, s_str_keys[i], &value);
+    }
+    x_bench_keep(t);
+    x_hashtable_destroy(t);
+  }
+}
+
+static void bench_hashtable_set_struct(XBench* b)
+{
+  x_bench_set_items(b, KEY_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XHashtable* t = s_create_struct();
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+    {
+      int32_t value = (int32_t)i;
+      x_hashtable_set(t, &s_struct_keys[i], &value);
+    }
+    x_bench_keep(t);
+    x_hashtable_destroy(t);
+  }
+}
+
+//
+// Lookups of every key in a filled table
+//
+
+static void bench_hashtable_get_i32(XBench* b)
+{
+  XHashtable* t = s_fill_i32(KEY_COUNT);
+  x_bench_set_items(b, KEY_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+    {
+      int32_t key = s_i32_key(i);
+      int32_t value = 0;
+      x_hashtable_get(t, &key, &value);
+      sum += (uint64_t)value;
+    }
+    x_bench_keep_u64(sum);
+  }
+  x_bench_pause(b);
+  x_hashtable_destroy(t);
+}
+
+static void bench_hashtable_get_many_i32(XBench* b)
+{
+  XHashtable* t = s_fill_i32(KEY_COUNT);
+  int32_t* keys = (int32_t*)malloc(KEY_COUNT * sizeof(int32_t));
+  int32_t* values = (int32_t*)malloc(KEY_COUNT * sizeof(int32_t));
+  bool* found = (bool*)malloc(KEY_COUNT * sizeof(bool));
+  for (uint32_t i = 0; i < KEY_COUNT; i++)
+    keys[i] = s_i32_key(i);
+  x_bench_set_items(b, KEY_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(keys);
+    x_bench_keep_u64(x_hashtable_get_many(t, keys, KEY_COUNT, values, found));
+  }
+  x_bench_pause(b);
+  free(keys);
+  free(values);
+  free(found);
+  x_hashtable_destroy(t);
+}
+
+static void bench_hashtable_get_cstr(XBench* b)
+{
+  XHashtable* t = s_create_cstr();
+  for (uint32_t i = 0; i < KEY_COUNT; i++)
+  {
+    int32_t value = (int32_t)i;
+    x_hashtable_set(t, s_str_keys[i], &value);
+  }
+  x_bench_set_items(b, KEY_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+    {
+      int32_t value = 0;
+      x_hashtable_get(t, s_str_keys[i], &value);
+      sum += (uint64_t)value;
+    }
+    x_bench_keep_u64(sum);
+  }
+  x_bench_pause(b);
+  x_hashtable_destroy(t);
+}
+
+static void bench_hashtable_get_struct(XBench* b)
+{
+  XHashtable* t = s_create_struct();
+  for (uint32_t i = 0; i < KEY_COUNT; i++)
+  {
+    int32_t value = (int32_t)i;
+    x_hashtable_set(t, &s_struct_keys[i], &value);
+  }
+  x_bench_set_items(b, KEY_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+    {
+      int32_t value = 0;
+      x_hashtable_get(t, &s_struct_keys[i], &value);
+      sum += (uint64_t)value;
+    }
+    x_bench_keep_u64(sum);
+  }
+  x_bench_pause(b);
+  x_hashtable_destroy(t);
+}
+
+//
+// Lookups at a given fill of a fixed capacity
+//
+
+static void s_get_at_load(XBench* b, double load, bool hit)
+{
+  XHashtable* t = s_create_i32();
+  x_hashtable_reserve(t, LOAD_CAPACITY);
+  uint32_t count = (uint32_t)((double)t->capacity * load);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    int32_t key = s_i32_key(i);
+    int32_t value = (int32_t)i;
+    x_hashtable_set(t, &key, &value);
+  }
+
+  // Misses probe keys past the inserted range
+  uint32_t first = hit ? 0 : count;
+  x_bench_set_items(b, count);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    uint64_t found = 0;
+    for (uint32_t i = first; i < first + count; i++)
+    {
+      int32_t key = s_i32_key(i);
+      found += x_hashtable_has(t, &key);
+    }
+    x_bench_keep_u64(found);
+  }
+  x_bench_pause(b);
+  x_hashtable_destroy(t);
+}
+
+static void bench_hashtable_has_load25(XBench* b) { s_get_at_load(b, 0.25, true); }
+static void bench_hashtable_has_load50(XBench* b) { s_get_at_load(b, 0.50, true); }
+static void bench_hashtable_has_load75(XBench* b) { s_get_at_load(b, X_HASHTABLE_LOAD_FACTOR, true); }
+static void bench_hashtable_miss_load25(XBench* b) { s_get_at_load(b, 0.25, false); }
+static void bench_hashtable_miss_load75(XBench* b) { s_get_at_load(b, X_HASHTABLE_LOAD_FACTOR, false); }
+
+//
+// Flat hashtable, same workloads
+//
+
+static XFlatHashtable* s_flat_fill_i32(uint32_t count)
+{
+  XFlatHashtable* t = x_flat_hashtable_create_ex(sizeof(int32_t), false, false, sizeof(int32_t), false, false);
+  for (uint32_t i = 0; i < count; i++)
+  {
+    int32_t key = s_i32_key(i);
+    int32_t value = (int32_t)i;
+    x_flat_hashtable_set(t, &key, &value);
+  }
+  return t;
+}
+
+static void bench_flat_hashtable_set_i32(XBench* b)
+{
+  x_bench_set_items(b, KEY_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XFlatHashtable* t = s_flat_fill_i32(KEY_COUNT);
+    x_bench_keep(t);
+    x_flat_hashtable_destroy(t);
+  }
+}
+
+static void bench_flat_hashtable_get_i32(XBench* b)
+{
+  XFlatHashtable* t = s_flat_fill_i32(KEY_COUNT);
+  x_bench_set_items(b, KEY_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+    {
+      int32_t key = s_i32_key(i);
+      int32_t value = 0;
+      x_flat_hashtable_get(t, &key, &value);
+      sum += (uint64_t)value;
+    }
+    x_bench_keep_u64(sum);
+  }
+  x_bench_pause(b);
+  x_flat_hashtable_destroy(t);
+}
+
+static void bench_flat_hashtable_miss_i32(XBench* b)
+{
+  XFlatHashtable* t = s_flat_fill_i32(KEY_COUNT);
+  x_bench_set_items(b, KEY_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    uint64_t found = 0;
+    for (uint32_t i = KEY_COUNT; i < 2 * KEY_COUNT; i++)
+    {
+      int32_t key = s_i32_key(i);
+      found += x_flat_hashtable_has(t, &key);
+    }
+    x_bench_keep_u64(found);
+  }
+  x_bench_pause(b);
+  x_flat_hashtable_destroy(t);
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_hashtable_set_i32),
+    X_BENCH(bench_hashtable_set_i32_reserved),
+    X_BENCH(bench_hashtable_set_cstr),
+    X_BENCH(bench_hashtable_set_struct),
+    X_BENCH(bench_hashtable_get_i32),
+    X_BENCH(bench_hashtable_get_many_i32),
+    X_BENCH(bench_hashtable_get_cstr),
+    X_BENCH(bench_hashtable_get_struct),
+    X_BENCH(bench_hashtable_has_load25),
+    X_BENCH(bench_hashtable_has_load50),
+    X_BENCH(bench_hashtable_has_load75),
+    X_BENCH(bench_hashtable_miss_load25),
+    X_BENCH(bench_hashtable_miss_load75),
+    X_BENCH(bench_flat_hashtable_set_i32),
+    X_BENCH(bench_flat_hashtable_get_i32),
+    X_BENCH(bench_flat_hashtable_miss_i32),
+  };
+
+  s_init_keys();
+  int result = x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+  s_free_keys();
+  return result;
+}
@@ -0,0 +1,216 @@
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_IMPL_HPOOL
+#include <stdx_hpool.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdlib.h>
+
+#define ITEM_COUNT 16384
+
+// A typical game or simulation object
+typedef struct Particle
+{
+  float position[3];
+  float velocity[3];
+  float age;
+  uint32_t flags;
+  float pad[8];
+} Particle;
+
+static XHandle s_handles[ITEM_COUNT];
+static uint32_t s_order[ITEM_COUNT];
+
+static void s_init_order(void)
+{
+  for (uint32_t i = 0; i < ITEM_COUNT; i++)
+    s_order[i] = i;
+  // Fisher-Yates with a fixed seed, so random access patterns repeat between runs
+  uint32_t x = 2463534242u;
+  for (uint32_t i = ITEM_COUNT - 1; i > 0; i--)
+  {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    uint32_t j = x % (i + 1);
+    uint32_t t = s_order[i];
+    s_order[i] = s_order[j];
+    s_order[j] = t;
+  }
+}
+
+static void s_init_pool(XHPool* pool, XHPoolLayout layout, int concurrent)
+{
+  XHPoolConfig cfg = {0};
+  cfg.page_capacity = 1024;
+  cfg.initial_pages = 1;
+  cfg.layout = layout;
+  cfg.concurrent = concurrent;
+  x_hpool_init(pool, sizeof(Particle), cfg, NULL, NULL, NULL);
+}
+
+static void s_fill(XHPool* pool)
+{
+  for (uint32_t i = 0; i < ITEM_COUNT; i++)
+  {
+    s_handles[i] = x_hpool_alloc(pool);
+    Particle* p = (Particle*)x_hpool_get(pool, s_handles[i]);
+    p->position[0] = (float)i;
+    p->velocity[0] = 1.0f;
+    p->age = 0.0f;
+  }
+}
+
+static void s_alloc_free(XBench* b, XHPoolLayout layout, int concurrent)
+{
+  XHPool pool;
+  s_init_pool(&pool, layout, concurrent);
+  // The first pass grows the pages; measure the steady state
+  s_fill(&pool);
+  for (uint32_t i = 0; i < ITEM_COUNT; i++)
+    x_hpool_free(&pool, s_handles[i]);
+
+  x_bench_set_items(b, ITEM_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    for (uint32_t i = 0; i < ITEM_COUNT; i++)
+      s_handles[i] = x_hpool_alloc(&pool);
+    // Free in random order, like objects dying during a frame
+    for (uint32_t i = 0; i < ITEM_COUNT; i++)
+      x_hpool_free(&pool, s_handles[s_order[i]]);
+  }
+  x_bench_pause(b);
+  x_hpool_term(&pool);
+}
+
+static void bench_hpool_alloc_free(XBench* b) { s_alloc_free(b, XHPOOL_LAYOUT_INTERLEAVED, 0); }
+static void bench_hpool_alloc_free_dense(XBench* b) { s_alloc_free(b, XHPOOL_LAYOUT_DENSE, 0); }
+static void bench_hpool_alloc_free_concurrent(XBench* b) { s_alloc_free(b, XHPOOL_LAYOUT_INTERLEAVED, 1); }
+
+static void s_get_random(XBench* b, XHPoolLayout layout)
+{
+  XHPool pool;
+  s_init_pool(&pool, layout, 0);
+  s_fill(&pool);
+  x_bench_set_items(b, ITEM_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < ITEM_COUNT; i++)
+    {
+      Particle* p = (Particle*)x_hpool_get(&pool, s_handles[s_order[i]]);
+      sum += p->position[0];
+    }
+    x_bench_keep(&sum);
+  }
+  x_bench_pause(b);
+  x_hpool_term(&pool);
+}
+
+static void bench_hpool_get_random(XBench* b) { s_get_random(b, XHPOOL_LAYOUT_INTERLEAVED); }
+static void bench_hpool_get_random_dense(XBench* b) { s_get_random(b, XHPOOL_LAYOUT_DENSE); }
+
+static void s_iterate(XBench* b, XHPoolLayout layout)
+{
+  XHPool pool;
+  s_init_pool(&pool, layout, 0);
+  s_fill(&pool);
+  // Leave holes so iteration has to skip dead slots
+  for (uint32_t i = 0; i < ITEM_COUNT; i += 4)
+    x_hpool_free(&pool, s_handles[s_order[i]]);
+
+  x_bench_set_items(b, x_hpool_alive_count(&pool));
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XHPoolIter it;
+    XHandle h;
+    for (Particle* p = (Particle*)x_hpool_iter_begin(&pool, &it, &h); p; p = (Particle*)x_hpool_iter_next(&pool, &it, &h))
+    {
+      p->position[0] += p->velocity[0];
+      p->age += 1.0f;
+    }
+    x_bench_keep(&pool);
+  }
+  x_bench_pause(b);
+  x_hpool_term(&pool);
+}
+
+static void bench_hpool_iterate(XBench* b) { s_iterate(b, XHPOOL_LAYOUT_INTERLEAVED); }
+static void bench_hpool_iterate_dense(XBench* b) { s_iterate(b, XHPOOL_LAYOUT_DENSE); }
+
+static void bench_hpool_dense_items(XBench* b)
+{
+  XHPool pool;
+  s_init_pool(&pool, XHPOOL_LAYOUT_DENSE, 0);
+  s_fill(&pool);
+  for (uint32_t i = 0; i < ITEM_COUNT; i += 4)
+    x_hpool_free(&pool, s_handles[s_order[i]]);
+
+  uint32_t count = x_hpool_alive_count(&pool);
+  x_bench_set_items(b, count);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    Particle* items = (Particle*)x_hpool_dense_items(&pool);
+    for (uint32_t i = 0; i < count; i++)
+    {
+      items[i].position[0] += items[i].velocity[0];
+      items[i].age += 1.0f;
+    }
+    x_bench_keep(items);
+  }
+  x_bench_pause(b);
+  x_hpool_term(&pool);
+}
+
+// Reference point: the same loop over malloc'ed objects reached through pointers
+static void bench_malloc_objects_iterate(XBench* b)
+{
+  Particle** objects = (Particle**)malloc(ITEM_COUNT * sizeof(Particle*));
+  for (uint32_t i = 0; i < ITEM_COUNT; i++)
+  {
+    objects[i] = (Particle*)calloc(1, sizeof(Particle));
+    objects[i]->velocity[0] = 1.0f;
+  }
+  x_bench_set_items(b, ITEM_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    for (uint32_t i = 0; i < ITEM_COUNT; i++)
+    {
+      Particle* p = objects[s_order[i]];
+      p->position[0] += p->velocity[0];
+      p->age += 1.0f;
+    }
+    x_bench_keep(objects);
+  }
+  x_bench_pause(b);
+  for (uint32_t i = 0; i < ITEM_COUNT; i++)
+    free(objects[i]);
+  free(objects);
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_hpool_alloc_free),
+    X_BENCH(bench_hpool_alloc_free_dense),
+    X_BENCH(bench_hpool_alloc_free_concurrent),
+    X_BENCH(bench_hpool_get_random),
+    X_BENCH(bench_hpool_get_random_dense),
+    X_BENCH(bench_hpool_iterate),
+    X_BENCH(bench_hpool_iterate_dense),
+    X_BENCH(bench_hpool_dense_items),
+    X_BENCH(bench_malloc_objects_iterate),
+  };
+
+  s_init_order();
+  int result = x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+  x_hpool_thread_detach();
+  return result;
+}
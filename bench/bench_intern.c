@@ -0,0 +1,134 @@
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_IMPL_STRING
+#include <stdx_string.h>
+#define X_IMPL_ARENA
+#include <stdx_arena.h>
+#define X_IMPL_HASHTABLE
+#include <stdx_hashtable.h>
+#define X_IMPL_INTERN
+#include <stdx_intern.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define KEY_COUNT 4096
+
+static char s_keys[KEY_COUNT][32];
+static size_t s_key_lengths[KEY_COUNT];
+
+static void s_init_keys(void)
+{
+  for (uint32_t i = 0; i < KEY_COUNT; i++)
+    s_key_lengths[i] = (size_t)snprintf(s_keys[i], sizeof(s_keys[i]), "identifier_%08x", i * 2654435761u);
+}
+
+static XSlice s_key(uint32_t i)
+{
+  return x_slice_init(s_keys[i], s_key_lengths[i]);
+}
+
+// Fill an empty pool: every call is a miss followed by an insert
+static void s_fill(XBench* b, uint32_t flags)
+{
+  x_bench_set_items(b, KEY_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_pause(b);
+    XIntern* pool = x_intern_create_ex(flags, 0);
+    x_bench_resume(b);
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+      x_bench_keep_u64(x_intern(pool, s_key(i)));
+    x_bench_pause(b);
+    x_intern_destroy(pool);
+    x_bench_resume(b);
+  }
+}
+
+static void bench_intern_insert(XBench* b) { s_fill(b, X_INTERN_DEFAULT); }
+static void bench_intern_insert_concurrent(XBench* b) { s_fill(b, X_INTERN_CONCURRENT); }
+
+// Re-intern strings already in the pool, the common case for identifiers
+static void s_rehit(XBench* b, uint32_t flags)
+{
+  XIntern* pool = x_intern_create_ex(flags, KEY_COUNT);
+  for (uint32_t i = 0; i < KEY_COUNT; i++)
+    x_intern(pool, s_key(i));
+  x_bench_set_items(b, KEY_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+      x_bench_keep_u64(x_intern(pool, s_key(i)));
+  }
+  x_bench_pause(b);
+  x_intern_destroy(pool);
+}
+
+static void bench_intern_hit(XBench* b) { s_rehit(b, X_INTERN_DEFAULT); }
+static void bench_intern_hit_concurrent(XBench* b) { s_rehit(b, X_INTERN_CONCURRENT); }
+
+X_HASHTABLE_TYPE_NAMED(XAtom, int32_t, atom)
+X_HASHTABLE_TYPE_CSTR_KEY_NAMED(int32_t, cstr)
+
+// Lookups in a table keyed by atoms: 4-byte hash and compare
+static void bench_intern_atom_table_get(XBench* b)
+{
+  XIntern* pool = x_intern_create();
+  XHashtable_atom* ht = x_hashtable_atom_create();
+  XAtom atoms[KEY_COUNT];
+  for (uint32_t i = 0; i < KEY_COUNT; i++)
+  {
+    atoms[i] = x_intern(pool, s_key(i));
+    x_hashtable_atom_set(ht, atoms[i], (int32_t)i);
+  }
+  x_bench_set_items(b, KEY_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    int32_t v = 0;
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+      x_hashtable_atom_get(ht, atoms[i], &v);
+    x_bench_keep_u64((uint64_t)v);
+  }
+  x_bench_pause(b);
+  x_hashtable_atom_destroy(ht);
+  x_intern_destroy(pool);
+}
+
+// Reference point: the same lookups keyed by string
+static void bench_intern_cstr_table_get(XBench* b)
+{
+  XHashtable_cstr* ht = x_hashtable_cstr_create();
+  for (uint32_t i = 0; i < KEY_COUNT; i++)
+    x_hashtable_cstr_set(ht, s_keys[i], (int32_t)i);
+  x_bench_set_items(b, KEY_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    int32_t v = 0;
+    for (uint32_t i = 0; i < KEY_COUNT; i++)
+      x_hashtable_cstr_get(ht, s_keys[i], &v);
+    x_bench_keep_u64((uint64_t)v);
+  }
+  x_bench_pause(b);
+  x_hashtable_cstr_destroy(ht);
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_intern_insert),
+    X_BENCH(bench_intern_insert_concurrent),
+    X_BENCH(bench_intern_hit),
+    X_BENCH(bench_intern_hit_concurrent),
+    X_BENCH(bench_intern_atom_table_get),
+    X_BENCH(bench_intern_cstr_table_get),
+  };
+
+  s_init_keys();
+  return x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+}
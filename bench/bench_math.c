@@ -0,0 +1,268 @@
+#define X_IMPL_MATH
+#include <stdx_math.h>
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdlib.h>
+
+#define BATCH 4096
+#define STREAM_SIZE (1024 * 1024)
+#define WORKERS 4
+
+static Mat4* s_a;
+static Mat4* s_b;
+static Mat4* s_out;
+static Vec3* s_points;
+static Vec3* s_points_out;
+static float* s_soa;      // xs, ys, zs, radii: BATCH each
+static float* s_soa_out;  // xs, ys, zs
+static float* s_stream;   // xs, ys, zs: STREAM_SIZE each, transformed in place
+static uint32_t s_mask[BATCH / 32];
+static Vec3* s_t;
+static Quat* s_r;
+static Vec3* s_s;
+
+static void s_init_batch(void)
+{
+  s_a = (Mat4*)malloc(BATCH * sizeof(Mat4));
+  s_b = (Mat4*)malloc(BATCH * sizeof(Mat4));
+  s_out = (Mat4*)malloc(BATCH * sizeof(Mat4));
+  s_points = (Vec3*)malloc(BATCH * sizeof(Vec3));
+  s_points_out = (Vec3*)malloc(BATCH * sizeof(Vec3));
+  s_soa = (float*)malloc(4 * BATCH * sizeof(float));
+  s_soa_out = (float*)malloc(3 * BATCH * sizeof(float));
+  s_stream = (float*)malloc(3 * STREAM_SIZE * sizeof(float));
+  s_t = (Vec3*)malloc(BATCH * sizeof(Vec3));
+  s_r = (Quat*)malloc(BATCH * sizeof(Quat));
+  s_s = (Vec3*)malloc(BATCH * sizeof(Vec3));
+  for (int32_t i = 0; i < BATCH; i++)
+  {
+    float f = (float)i;
+    s_a[i] = mat4_mul(mat4_translate(vec3_make(f, 1.0f, -f)), mat4_rot_y(f * 0.01f));
+    s_b[i] = mat4_mul(mat4_rot_x(f * 0.02f), mat4_scale(vec3_make(1.0f, 2.0f, 0.5f)));
+    s_points[i] = vec3_make(f, f * 0.5f, 1.0f);
+    s_soa[i] = f;
+    s_soa[BATCH + i] = f * 0.5f;
+    s_soa[2 * BATCH + i] = -f * 0.05f;
+    s_soa[3 * BATCH + i] = 1.0f + (float)(i % 8);
+    s_t[i] = vec3_make(f, 1.0f, -f);
+    s_r[i] = quat_axis_angle(vec3_make(0.0f, 1.0f, 0.0f), f * 0.01f);
+    s_s[i] = vec3_make(1.0f, 2.0f, 0.5f);
+  }
+  for (int32_t i = 0; i < 3 * STREAM_SIZE; i++)
+    s_stream[i] = (float)(i % 1000) * 0.01f;
+}
+
+static void s_free_batch(void)
+{
+  free(s_a);
+  free(s_b);
+  free(s_out);
+  free(s_points);
+  free(s_points_out);
+  free(s_soa);
+  free(s_soa_out);
+  free(s_stream);
+  free(s_t);
+  free(s_r);
+  free(s_s);
+}
+
+static void bench_mat4_mul(XBench* b)
+{
+  x_bench_set_items(b, BATCH);
+  x_bench_set_bytes(b, BATCH * 3 * sizeof(Mat4));
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_a);
+    for (int32_t i = 0; i < BATCH; i++)
+      s_out[i] = mat4_mul(s_a[i], s_b[i]);
+    x_bench_keep(s_out);
+  }
+}
+
+// One parent transform applied to many children, as in a scene graph update
+static void bench_mat4_mul_parent(XBench* b)
+{
+  Mat4 parent = mat4_mul(mat4_translate(vec3_make(10.0f, 0.0f, 5.0f)), mat4_rot_z(0.3f));
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_b);
+    for (int32_t i = 0; i < BATCH; i++)
+      s_out[i] = mat4_mul(parent, s_b[i]);
+    x_bench_keep(s_out);
+  }
+}
+
+static void bench_mat4_mul_point(XBench* b)
+{
+  Mat4 m = s_a[BATCH / 2];
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_points);
+    for (int32_t i = 0; i < BATCH; i++)
+      s_points_out[i] = mat4_mul_point(m, s_points[i]);
+    x_bench_keep(s_points_out);
+  }
+}
+
+static void bench_mat4_inverse_affine(XBench* b)
+{
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_a);
+    for (int32_t i = 0; i < BATCH; i++)
+      s_out[i] = mat4_inverse_affine(s_a[i]);
+    x_bench_keep(s_out);
+  }
+}
+
+static void bench_mat4_inverse(XBench* b)
+{
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_a);
+    for (int32_t i = 0; i < BATCH; i++)
+      s_out[i] = mat4_inverse(s_a[i], NULL);
+    x_bench_keep(s_out);
+  }
+}
+
+static void bench_mat4_inverse_full(XBench* b)
+{
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_a);
+    for (int32_t i = 0; i < BATCH; i++)
+      s_out[i] = mat4_inverse_full(s_a[i], NULL);
+    x_bench_keep(s_out);
+  }
+}
+
+static void bench_quat_mul(XBench* b)
+{
+  Quat r = quat_axis_angle(vec3_make(0.0f, 1.0f, 0.0f), 0.01f);
+  Quat acc = quat_id();
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    for (int32_t i = 0; i < BATCH; i++)
+      acc = quat_mul(acc, r);
+    x_bench_keep(&acc);
+  }
+}
+
+// Same work as bench_mat4_mul_point on structure-of-arrays input
+static void bench_mat4_transform_points(XBench* b)
+{
+  Mat4 m = s_a[BATCH / 2];
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_soa);
+    mat4_transform_points(m, s_soa, s_soa + BATCH, s_soa + 2 * BATCH,
+        s_soa_out, s_soa_out + BATCH, s_soa_out + 2 * BATCH, BATCH);
+    x_bench_keep(s_soa_out);
+  }
+}
+
+static void s_transform_range(int64_t begin, int64_t end, void* ctx)
+{
+  Mat4* m = (Mat4*)ctx;
+  float* xs = s_stream + begin;
+  float* ys = s_stream + STREAM_SIZE + begin;
+  float* zs = s_stream + 2 * STREAM_SIZE + begin;
+  mat4_transform_points(*m, xs, ys, zs, xs, ys, zs, (size_t)(end - begin));
+}
+
+static void bench_mat4_transform_points_stream(XBench* b)
+{
+  Mat4 m = mat4_rot_y(0.001f);
+  x_bench_set_items(b, STREAM_SIZE);
+  for (uint64_t n = 0; n < b->iterations; n++)
+    s_transform_range(0, STREAM_SIZE, &m);
+  x_bench_keep(s_stream);
+}
+
+// The stream split across a thread pool
+static void bench_mat4_transform_points_parallel(XBench* b)
+{
+  Mat4 m = mat4_rot_y(0.001f);
+  XThreadPool* pool = x_threadpool_create(WORKERS);
+  x_bench_set_items(b, STREAM_SIZE);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+    x_threadpool_parallel_for(pool, 0, STREAM_SIZE, 0, s_transform_range, &m);
+  x_bench_pause(b);
+  x_bench_keep(s_stream);
+  x_threadpool_destroy(pool);
+}
+
+static void bench_frustum_cull_spheres(XBench* b)
+{
+  Mat4 vp = mat4_mul(mat4_perspective_rh_zo(1.0f, 1.5f, 0.1f, 500.0f),
+      mat4_look_at_rh(vec3_make(0.0f, 0.0f, 50.0f), vec3_make(0.0f, 0.0f, 0.0f), vec3_make(0.0f, 1.0f, 0.0f)));
+  Frustum f = frustum_from_mat4(vp, true);
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_soa);
+    frustum_cull_spheres(&f, s_soa, s_soa + BATCH, s_soa + 2 * BATCH, s_soa + 3 * BATCH, BATCH, s_mask);
+    x_bench_keep(s_mask);
+  }
+}
+
+static void bench_mat4_compose(XBench* b)
+{
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_r);
+    for (int32_t i = 0; i < BATCH; i++)
+      s_out[i] = mat4_compose(s_t[i], s_r[i], s_s[i]);
+    x_bench_keep(s_out);
+  }
+}
+
+static void bench_mat4_compose_array(XBench* b)
+{
+  x_bench_set_items(b, BATCH);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_r);
+    mat4_compose_array(s_t, s_r, s_s, BATCH, s_out);
+    x_bench_keep(s_out);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_mat4_mul),
+    X_BENCH(bench_mat4_mul_parent),
+    X_BENCH(bench_mat4_mul_point),
+    X_BENCH(bench_mat4_inverse_affine),
+    X_BENCH(bench_mat4_inverse),
+    X_BENCH(bench_mat4_inverse_full),
+    X_BENCH(bench_quat_mul),
+    X_BENCH(bench_mat4_transform_points),
+    X_BENCH(bench_mat4_transform_points_stream),
+    X_BENCH(bench_mat4_transform_points_parallel),
+    X_BENCH(bench_frustum_cull_spheres),
+    X_BENCH(bench_mat4_compose),
+    X_BENCH(bench_mat4_compose_array),
+  };
+
+  s_init_batch();
+  int result = x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+  s_free_batch();
+  return result;
+}
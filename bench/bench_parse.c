@@ -0,0 +1,326 @@
+#define X_IMPL_STRING
+#include <stdx_string.h>
+#define X_IMPL_IO
+#include <stdx_io.h>
+#define X_IMPL_TML
+#include <stdx_tml.h>
+#define X_IMPL_INI
+#include <stdx_ini.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DOC_SECTIONS 256
+
+static char* s_tml;
+static uint32_t s_tml_len;
+static char* s_ini;
+static size_t s_ini_len;
+
+// A level description in the shape of the TML header example, repeated
+static void s_init_tml(void)
+{
+  size_t cap = DOC_SECTIONS * 1024;
+  size_t len = 0;
+  s_tml = (char*)malloc(cap);
+  len += (size_t)snprintf(s_tml + len, cap - len, "levels:\n");
+  for (int32_t i = 0; i < DOC_SECTIONS; i++)
+  {
+    len += (size_t)snprintf(s_tml + len, cap - len,
+        "  level_%d:\n"
+        "    name: \"Level %d\"\n"
+        "    enabled: %s\n"
+        "    seed: %d\n"
+        "    gravity: %.3f\n"
+        "    # spawn points\n"
+        "    objects:\n"
+        "      - position: %d.0, 2.5, 0.0\n"
+        "        scale: 1.0, 1.0, 1.0\n"
+        "        weights: 10, 20, 40, 103,\n"
+        "                 99, 71, 44, -1\n"
+        "      - position: 7.0, %d.0, 0.0\n"
+        "        scale: 2.0, 2.0, 2.0\n"
+        "        tags: \"enemy\", \"boss\", \"flying\"\n",
+        i, i, (i & 1) ? "true" : "false", i * 7919, 9.81 + i * 0.01, i, i);
+  }
+  s_tml_len = (uint32_t)len;
+}
+
+// A server configuration with many sections, comments and typed values
+static void s_init_ini(void)
+{
+  size_t cap = DOC_SECTIONS * 512;
+  size_t len = 0;
+  s_ini = (char*)malloc(cap);
+  for (int32_t i = 0; i < DOC_SECTIONS; i++)
+  {
+    len += (size_t)snprintf(s_ini + len, cap - len,
+        "; virtual host %d\n"
+        "[host_%d]\n"
+        "name      = \"site%d.example.com\"\n"
+        "port      = %d\n"
+        "docroot   = \"/var/www/site%d\"\n"
+        "list_dirs = %s\n"
+        "threads   = %d\n"
+        "keepalive_ms = 15000\n"
+        "cache_kb  = 16384\n"
+        "ratio     = %.2f\n\n",
+        i, i, i, 8000 + i, i, (i & 1) ? "true" : "false", 1 + (i & 7), 0.5 + i * 0.01);
+  }
+  s_ini_len = len;
+}
+
+static void s_run_tml_load(XBench* b, uint32_t flags)
+{
+  x_bench_set_bytes(b, s_tml_len);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XTml* doc = NULL;
+    x_bench_keep(s_tml);
+    if (x_tml_load(s_tml, s_tml_len, flags, &doc) != 1)
+    {
+      fprintf(stderr, "bench_tml_load: the generated document did not parse\n");
+      exit(1);
+    }
+    x_bench_keep(doc);
+    x_tml_unload(doc);
+  }
+}
+
+static void bench_tml_load(XBench* b) { s_run_tml_load(b, XTML_OPEN_DEFAULT); }
+static void bench_tml_load_indexed(XBench* b) { s_run_tml_load(b, XTML_OPEN_INDEX); }
+
+static int s_count_kv(void* user, const char* key, uint32_t key_len, const XTmlScalar* value)
+{
+  (void)key; (void)key_len; (void)value;
+  (*(uint64_t*)user)++;
+  return 1;
+}
+
+static int s_count_element(void* user, const XTmlScalar* value)
+{
+  (void)value;
+  (*(uint64_t*)user)++;
+  return 1;
+}
+
+// Push parsing in 4 KiB chunks: nothing is built, memory stays at one record
+static void bench_tml_stream(XBench* b)
+{
+  XTmlStreamCallbacks cb = { NULL, NULL, s_count_kv, NULL, s_count_element, NULL };
+  uint64_t values = 0;
+  x_bench_set_bytes(b, s_tml_len);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XTmlStream* st = x_tml_stream_create(&cb, &values, 0);
+    int ok = 1;
+    for (uint32_t at = 0; at < s_tml_len && ok; at += 4096)
+      ok = x_tml_stream_feed(st, s_tml + at, (s_tml_len - at < 4096) ? s_tml_len - at : 4096);
+    if (!ok || !x_tml_stream_finish(st))
+    {
+      fprintf(stderr, "bench_tml_stream: the generated document did not parse\n");
+      exit(1);
+    }
+    x_tml_stream_destroy(st);
+  }
+  x_bench_keep(&values);
+}
+
+#define TML_BINARY_PATH "bench_parse_tmp.btml"
+
+// Mapping a saved blob: no parsing, so the cost no longer grows with the text
+static void bench_tml_load_binary(XBench* b)
+{
+  XTml* doc = NULL;
+  x_tml_load(s_tml, s_tml_len, XTML_OPEN_INDEX, &doc);
+  if (!x_tml_save_binary(doc, TML_BINARY_PATH))
+  {
+    fprintf(stderr, "bench_tml_load_binary: could not write %s\n", TML_BINARY_PATH);
+    exit(1);
+  }
+  x_tml_unload(doc);
+
+  x_bench_set_bytes(b, s_tml_len);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    if (x_tml_load_binary(TML_BINARY_PATH, &doc) != 1)
+    {
+      fprintf(stderr, "bench_tml_load_binary: the saved document did not load\n");
+      exit(1);
+    }
+    x_bench_keep(doc);
+    x_tml_unload(doc);
+  }
+  x_bench_pause(b);
+  remove(TML_BINARY_PATH);
+}
+
+static void s_run_tml_lookup(XBench* b, uint32_t flags)
+{
+  XTml* doc = NULL;
+  x_tml_load(s_tml, s_tml_len, flags, &doc);
+  XTmlCursor levels = x_tml_root(doc);
+  x_tml_find_child(doc, levels, "levels", 6, &levels);
+  x_bench_set_items(b, DOC_SECTIONS);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    int64_t sum = 0;
+    for (int32_t i = 0; i < DOC_SECTIONS; i++)
+    {
+      char name[32];
+      int len = snprintf(name, sizeof(name), "level_%d", i);
+      XTmlCursor level;
+      int64_t seed = 0;
+      if (x_tml_find_child(doc, levels, name, (uint32_t)len, &level) == 1 && x_tml_get_i64(doc, level, "seed", &seed) == 1)
+        sum += seed;
+    }
+    x_bench_keep_u64((uint64_t)sum);
+  }
+  x_bench_pause(b);
+  x_tml_unload(doc);
+}
+
+static void bench_tml_lookup(XBench* b) { s_run_tml_lookup(b, XTML_OPEN_DEFAULT); }
+static void bench_tml_lookup_indexed(XBench* b) { s_run_tml_lookup(b, XTML_OPEN_INDEX); }
+
+// The same deep path every time, parsed once
+static void bench_tml_path_resolve(XBench* b)
+{
+  XTml* doc = NULL;
+  XTmlPath path;
+  x_tml_load(s_tml, s_tml_len, XTML_OPEN_INDEX, &doc);
+  x_tml_path_compile("levels.level_100.objects.1", &path);
+  x_bench_set_items(b, 1);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XTmlCursor obj;
+    x_bench_keep(&path);
+    x_tml_path_resolve(doc, x_tml_root(doc), &path, &obj);
+    x_bench_keep_u64((uint64_t)obj.node);
+  }
+  x_bench_pause(b);
+  x_tml_unload(doc);
+}
+
+static void bench_ini_load_mem(XBench* b)
+{
+  x_bench_set_bytes(b, s_ini_len);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XIni ini;
+    XIniError err;
+    x_bench_keep(s_ini);
+    if (!x_ini_load_mem(s_ini, s_ini_len, &ini, &err))
+    {
+      fprintf(stderr, "bench_ini_load_mem: the generated document did not parse\n");
+      exit(1);
+    }
+    x_bench_keep(&ini);
+    x_ini_free(&ini);
+  }
+}
+
+static void bench_ini_get(XBench* b)
+{
+  XIni ini;
+  XIniError err;
+  x_ini_load_mem(s_ini, s_ini_len, &ini, &err);
+  x_bench_set_items(b, DOC_SECTIONS);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    int64_t sum = 0;
+    for (int32_t i = 0; i < DOC_SECTIONS; i++)
+    {
+      char section[32];
+      snprintf(section, sizeof(section), "host_%d", i);
+      sum += x_ini_get_i32(&ini, section, "port", 0);
+    }
+    x_bench_keep_u64((uint64_t)sum);
+  }
+  x_bench_pause(b);
+  x_ini_free(&ini);
+}
+
+typedef struct
+{
+  const char* name;
+  int32_t port;
+  const char* docroot;
+  bool list_dirs;
+  int32_t threads;
+  int32_t keepalive_ms;
+  int32_t cache_kb;
+  float ratio;
+} BenchHost;
+
+// One x_ini_bind per section: every key of a host in one call
+static void bench_ini_bind(XBench* b)
+{
+  XIni ini;
+  XIniError err;
+  x_ini_load_mem(s_ini, s_ini_len, &ini, &err);
+  char sections[DOC_SECTIONS][16];
+  XIniField fields[DOC_SECTIONS][8];
+  for (int32_t i = 0; i < DOC_SECTIONS; i++)
+  {
+    const char* sec = sections[i];
+    XIniField f[8] =
+    {
+      X_INI_FIELD(sec, "name",         XINI_FIELD_STR,  BenchHost, name),
+      X_INI_FIELD(sec, "port",         XINI_FIELD_I32,  BenchHost, port),
+      X_INI_FIELD(sec, "docroot",      XINI_FIELD_STR,  BenchHost, docroot),
+      X_INI_FIELD(sec, "list_dirs",    XINI_FIELD_BOOL, BenchHost, list_dirs),
+      X_INI_FIELD(sec, "threads",      XINI_FIELD_I32,  BenchHost, threads),
+      X_INI_FIELD(sec, "keepalive_ms", XINI_FIELD_I32,  BenchHost, keepalive_ms),
+      X_INI_FIELD(sec, "cache_kb",     XINI_FIELD_I32,  BenchHost, cache_kb),
+      X_INI_FIELD(sec, "ratio",        XINI_FIELD_F32,  BenchHost, ratio),
+    };
+    snprintf(sections[i], sizeof(sections[i]), "host_%d", i);
+    memcpy(fields[i], f, sizeof(f));
+  }
+  x_bench_set_items(b, DOC_SECTIONS);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    int64_t sum = 0;
+    for (int32_t i = 0; i < DOC_SECTIONS; i++)
+    {
+      BenchHost host = {0};
+      sum += x_ini_bind(&ini, fields[i], 8, &host) + host.port;
+    }
+    x_bench_keep_u64((uint64_t)sum);
+  }
+  x_bench_pause(b);
+  x_ini_free(&ini);
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_tml_load),
+    X_BENCH(bench_tml_load_indexed),
+    X_BENCH(bench_tml_load_binary),
+    X_BENCH(bench_tml_stream),
+    X_BENCH(bench_tml_lookup),
+    X_BENCH(bench_tml_lookup_indexed),
+    X_BENCH(bench_tml_path_resolve),
+    X_BENCH(bench_ini_load_mem),
+    X_BENCH(bench_ini_get),
+    X_BENCH(bench_ini_bind),
+  };
+
+  s_init_tml();
+  s_init_ini();
+  int result = x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+  free(s_tml);
+  free(s_ini);
+  return result;
+}
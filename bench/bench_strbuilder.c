@@ -0,0 +1,202 @@
+#define X_IMPL_STRBUILDER
+#include <stdx_strbuilder.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#define APPEND_COUNT 1024
+
+static const char* s_words[] =
+{
+  "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+  "india", "juliett", "kilo", "lima", "mike", "november", "oscar", "papa"
+};
+
+#define WORD_COUNT (sizeof(s_words) / sizeof(s_words[0]))
+
+// The builder is reused, as request handlers and writers do, so these
+// measure appends rather than the first growth
+static void bench_strbuilder_append(XBench* b)
+{
+  XStrBuilder* sb = x_strbuilder_create();
+  x_bench_set_items(b, APPEND_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_strbuilder_clear(sb);
+    for (int32_t i = 0; i < APPEND_COUNT; i++)
+      x_strbuilder_append(sb, s_words[i % WORD_COUNT]);
+    x_bench_set_bytes(b, x_strbuilder_length(sb));
+    x_bench_keep(sb->data);
+  }
+  x_strbuilder_destroy(sb);
+}
+
+static void bench_strbuilder_append_fresh(XBench* b)
+{
+  x_bench_set_items(b, APPEND_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XStrBuilder* sb = x_strbuilder_create();
+    for (int32_t i = 0; i < APPEND_COUNT; i++)
+      x_strbuilder_append(sb, s_words[i % WORD_COUNT]);
+    x_bench_set_bytes(b, x_strbuilder_length(sb));
+    x_bench_keep(sb->data);
+    x_strbuilder_destroy(sb);
+  }
+}
+
+static void bench_strbuilder_append_char(XBench* b)
+{
+  XStrBuilder* sb = x_strbuilder_create();
+  x_bench_set_items(b, APPEND_COUNT);
+  x_bench_set_bytes(b, APPEND_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_strbuilder_clear(sb);
+    for (int32_t i = 0; i < APPEND_COUNT; i++)
+      x_strbuilder_append_char(sb, (char)('a' + (i & 15)));
+    x_bench_keep(sb->data);
+  }
+  x_strbuilder_destroy(sb);
+}
+
+static void bench_strbuilder_append_substring(XBench* b)
+{
+  static const char text[] = "GET /index.html HTTP/1.1\r\nHost: localhost\r\n";
+  XStrBuilder* sb = x_strbuilder_create();
+  x_bench_set_items(b, APPEND_COUNT);
+  x_bench_set_bytes(b, APPEND_COUNT * 16);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_strbuilder_clear(sb);
+    for (int32_t i = 0; i < APPEND_COUNT; i++)
+      x_strbuilder_append_substring(sb, text + (i & 15), 16);
+    x_bench_keep(sb->data);
+  }
+  x_strbuilder_destroy(sb);
+}
+
+static void bench_strbuilder_append_format(XBench* b)
+{
+  XStrBuilder* sb = x_strbuilder_create();
+  x_bench_set_items(b, APPEND_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_strbuilder_clear(sb);
+    for (int32_t i = 0; i < APPEND_COUNT; i++)
+      x_strbuilder_append_format(sb, "%s=%d,", s_words[i % WORD_COUNT], i);
+    x_bench_set_bytes(b, x_strbuilder_length(sb));
+    x_bench_keep(sb->data);
+  }
+  x_strbuilder_destroy(sb);
+}
+
+// Same output as bench_strbuilder_append_format, without printf
+static void bench_strbuilder_append_u64(XBench* b)
+{
+  XStrBuilder* sb = x_strbuilder_create();
+  x_bench_set_items(b, APPEND_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_strbuilder_clear(sb);
+    for (int32_t i = 0; i < APPEND_COUNT; i++)
+    {
+      x_strbuilder_append(sb, s_words[i % WORD_COUNT]);
+      x_strbuilder_append_char(sb, '=');
+      x_strbuilder_append_u64(sb, (uint64_t)i);
+      x_strbuilder_append_char(sb, ',');
+    }
+    x_bench_set_bytes(b, x_strbuilder_length(sb));
+    x_bench_keep(sb->data);
+  }
+  x_strbuilder_destroy(sb);
+}
+
+static void bench_strbuilder_append_f64(XBench* b)
+{
+  XStrBuilder* sb = x_strbuilder_create();
+  x_bench_set_items(b, APPEND_COUNT);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_strbuilder_clear(sb);
+    for (int32_t i = 0; i < APPEND_COUNT; i++)
+    {
+      x_strbuilder_append_f64(sb, (double)i * 0.125 + 1.0 / 3.0);
+      x_strbuilder_append_char(sb, ',');
+    }
+    x_bench_set_bytes(b, x_strbuilder_length(sb));
+    x_bench_keep(sb->data);
+  }
+  x_strbuilder_destroy(sb);
+}
+
+static void bench_strbuilder_append_ref(XBench* b)
+{
+  static char blob[4096];
+  XStrBuilder* sb = x_strbuilder_create();
+  memset(blob, 'x', sizeof(blob));
+  x_bench_set_items(b, 64);
+  x_bench_set_bytes(b, 64 * sizeof(blob));
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_strbuilder_clear(sb);
+    for (int32_t i = 0; i < 64; i++)
+    {
+      x_strbuilder_append(sb, "chunk:");
+      x_strbuilder_append_ref(sb, blob, sizeof(blob));
+    }
+    x_bench_keep_u64(x_strbuilder_segment_count(sb));
+  }
+  x_strbuilder_destroy(sb);
+}
+
+// What socket and file writers do with a builder holding borrowed chunks
+static void bench_strbuilder_gather(XBench* b)
+{
+  static char blob[4096];
+  XStrBuilder* sb = x_strbuilder_create();
+  XSlice parts[16];
+  memset(blob, 'x', sizeof(blob));
+  for (int32_t i = 0; i < 64; i++)
+  {
+    x_strbuilder_append(sb, "chunk:");
+    x_strbuilder_append_ref(sb, blob, sizeof(blob));
+  }
+  size_t segments = x_strbuilder_segment_count(sb);
+  x_bench_set_items(b, segments);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    size_t total = 0;
+    for (size_t first = 0; first < segments; )
+    {
+      size_t count = x_strbuilder_gather(sb, first, parts, 16);
+      for (size_t i = 0; i < count; i++)
+        total += parts[i].length;
+      first += count;
+    }
+    x_bench_keep_u64(total);
+  }
+  x_bench_pause(b);
+  x_strbuilder_destroy(sb);
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_strbuilder_append),
+    X_BENCH(bench_strbuilder_append_fresh),
+    X_BENCH(bench_strbuilder_append_char),
+    X_BENCH(bench_strbuilder_append_substring),
+    X_BENCH(bench_strbuilder_append_format),
+    X_BENCH(bench_strbuilder_append_u64),
+    X_BENCH(bench_strbuilder_append_f64),
+    X_BENCH(bench_strbuilder_append_ref),
+    X_BENCH(bench_strbuilder_gather),
+  };
+
+  return x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+}
@@ -0,0 +1,267 @@
+#define X_IMPL_STRING
+#include <stdx_string.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEXT_LINES 1024
+
+static char* s_csv;           // "id,name,score,city\n" rows
+static size_t s_csv_len;
+static char* s_prose;         // words separated by spaces and tabs
+static size_t s_prose_len;
+static char s_long[64 * 1024];
+static char s_utf8[64 * 1024];  // mostly ASCII with accented letters, symbols and emoji
+static size_t s_utf8_len;
+static uint16_t s_utf16[64 * 1024];
+
+static void s_init_text(void)
+{
+  static const char* cities[] = { "Lisbon", "Recife", "Osaka", "Tallinn", "Quito", "Perth" };
+  size_t cap = TEXT_LINES * 64;
+  s_csv = (char*)malloc(cap);
+  s_csv_len = 0;
+  for (int32_t i = 0; i < TEXT_LINES; i++)
+    s_csv_len += (size_t)snprintf(s_csv + s_csv_len, cap - s_csv_len, "%d,user%d,%d,%s\n", i, i * 7, (i * 37) % 100, cities[i % 6]);
+
+  s_prose = (char*)malloc(cap);
+  s_prose_len = 0;
+  for (int32_t i = 0; i < TEXT_LINES * 4; i++)
+    s_prose_len += (size_t)snprintf(s_prose + s_prose_len, cap - s_prose_len, "%s%c", cities[(i * 5) % 6], (i & 7) == 7 ? '\t' : ' ');
+
+  static const char* words[] = { "caf\xC3\xA9 ", "na\xC3\xAFve ", "price ", "\xE2\x82\xAC" "10 ", "ok ", "\xF0\x9F\x98\x80 ", "plain ascii words " };
+  s_utf8_len = 0;
+  for (int32_t i = 0; s_utf8_len + 32 < sizeof(s_utf8); i++)
+    s_utf8_len += (size_t)snprintf(s_utf8 + s_utf8_len, sizeof(s_utf8) - s_utf8_len, "%s", words[(i * 3) % 7]);
+
+  // A long run without the searched byte, found only at the very end
+  memset(s_long, 'a', sizeof(s_long));
+  s_long[sizeof(s_long) - 1] = '#';
+}
+
+static void bench_slice_find(XBench* b)
+{
+  XSlice sv = { s_long, sizeof(s_long) };
+  x_bench_set_bytes(b, sv.length);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(sv.ptr);
+    x_bench_keep_u64((uint64_t)x_slice_find(sv, '#'));
+  }
+}
+
+static void bench_slice_rfind(XBench* b)
+{
+  XSlice sv = { s_long, sizeof(s_long) - 1 };
+  s_long[0] = '#';
+  x_bench_set_bytes(b, sv.length);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(sv.ptr);
+    x_bench_keep_u64((uint64_t)x_slice_rfind(sv, '#'));
+  }
+  s_long[0] = 'a';
+}
+
+static void bench_slice_find_white_space(XBench* b)
+{
+  XSlice sv = { s_long, sizeof(s_long) };
+  s_long[sizeof(s_long) - 1] = ' ';
+  x_bench_set_bytes(b, sv.length);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(sv.ptr);
+    x_bench_keep_u64((uint64_t)x_slice_find_white_space(sv));
+  }
+  s_long[sizeof(s_long) - 1] = '#';
+}
+
+// More delimiters than the small-set kernel takes: nibble table path
+static void bench_slice_find_any(XBench* b)
+{
+  XSlice sv = { s_long, sizeof(s_long) };
+  x_bench_set_bytes(b, sv.length);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(sv.ptr);
+    x_bench_keep_u64((uint64_t)x_slice_find_any(sv, "{}[]:,#"));
+  }
+}
+
+// The cities never appear in this order, so the whole text is scanned
+static void bench_slice_find_slice(XBench* b)
+{
+  XSlice sv = { s_prose, s_prose_len };
+  XSlice needle = x_slice("Tallinn\tQuito");
+  x_bench_set_bytes(b, sv.length);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(sv.ptr);
+    x_bench_keep_u64((uint64_t)x_slice_find_slice(sv, needle));
+  }
+}
+
+static void bench_utf8_validate(XBench* b)
+{
+  x_bench_set_bytes(b, s_utf8_len);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_utf8);
+    x_bench_keep_u64(x_utf8_validate(s_utf8, s_utf8_len, NULL));
+  }
+}
+
+static void bench_utf8_count(XBench* b)
+{
+  x_bench_set_bytes(b, s_utf8_len);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_utf8);
+    x_bench_keep_u64(x_utf8_count(s_utf8, s_utf8_len));
+  }
+}
+
+static void bench_utf8_to_utf16(XBench* b)
+{
+  x_bench_set_bytes(b, s_utf8_len);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(s_utf8);
+    x_bench_keep_u64(x_utf8_to_utf16(s_utf8, s_utf8_len, s_utf16, sizeof(s_utf16) / sizeof(s_utf16[0])));
+    x_bench_keep(s_utf16);
+  }
+}
+
+static void bench_slice_contains_char(XBench* b)
+{
+  XSlice sv = { s_long, sizeof(s_long) };
+  x_bench_set_bytes(b, sv.length);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(sv.ptr);
+    x_bench_keep_u64(x_slice_contains_char(sv, '#'));
+  }
+}
+
+// Lines, then fields: the shape of every line-oriented parser
+static void bench_slice_split_csv(XBench* b)
+{
+  x_bench_set_bytes(b, s_csv_len);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XSlice input = { s_csv, s_csv_len };
+    XSlice line, field;
+    uint64_t fields = 0;
+    while (x_slice_next_token(&input, '\n', &line))
+    {
+      while (x_slice_next_token(&line, ',', &field))
+        fields += field.length;
+    }
+    x_bench_keep_u64(fields);
+  }
+}
+
+static void bench_slice_split_white_space(XBench* b)
+{
+  x_bench_set_bytes(b, s_prose_len);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XSlice input = { s_prose, s_prose_len };
+    XSlice word;
+    uint64_t words = 0;
+    while (x_slice_next_token_white_space(&input, &word))
+      words++;
+    x_bench_keep_u64(words);
+  }
+}
+
+static void bench_slice_split_at(XBench* b)
+{
+  static const char* headers[] =
+  {
+    "Host: localhost:8080", "User-Agent: curl/8.5.0", "Accept: */*",
+    "Accept-Encoding: gzip, deflate", "Connection: keep-alive", "Cache-Control: no-cache"
+  };
+  x_bench_set_items(b, 6);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    uint64_t total = 0;
+    for (int32_t i = 0; i < 6; i++)
+    {
+      XSlice name, value;
+      if (x_slice_split_at(x_slice_from_cstr(headers[i]), ':', &name, &value))
+        total += x_slice_trim(value).length + name.length;
+    }
+    x_bench_keep_u64(total);
+  }
+}
+
+static void bench_slice_eq_ci(XBench* b)
+{
+  static const char* names[] = { "content-length", "Content-Type", "CONNECTION", "host", "Accept-Encoding" };
+  XSlice target = x_slice_from_cstr("Connection");
+  x_bench_set_items(b, 5);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    uint64_t matches = 0;
+    for (int32_t i = 0; i < 5; i++)
+      matches += x_slice_eq_ci(x_slice_from_cstr(names[i]), target);
+    x_bench_keep_u64(matches);
+  }
+}
+
+static void bench_slice_eq_long(XBench* b)
+{
+  static char copy[sizeof(s_long)];
+  memcpy(copy, s_long, sizeof(s_long));
+  XSlice a = { s_long, sizeof(s_long) };
+  XSlice c = { copy, sizeof(copy) };
+  x_bench_set_bytes(b, a.length);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(copy);
+    x_bench_keep_u64(x_slice_eq(a, c));
+  }
+}
+
+static void bench_slice_trim(XBench* b)
+{
+  static const char text[] = "   \t  padded value with spaces inside   \t ";
+  XSlice sv = { text, sizeof(text) - 1 };
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_bench_keep(sv.ptr);
+    x_bench_keep_u64(x_slice_trim(sv).length);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_slice_find),
+    X_BENCH(bench_slice_rfind),
+    X_BENCH(bench_slice_find_white_space),
+    X_BENCH(bench_slice_find_any),
+    X_BENCH(bench_slice_find_slice),
+    X_BENCH(bench_utf8_validate),
+    X_BENCH(bench_utf8_count),
+    X_BENCH(bench_utf8_to_utf16),
+    X_BENCH(bench_slice_contains_char),
+    X_BENCH(bench_slice_split_csv),
+    X_BENCH(bench_slice_split_white_space),
+    X_BENCH(bench_slice_split_at),
+    X_BENCH(bench_slice_eq_ci),
+    X_BENCH(bench_slice_eq_long),
+    X_BENCH(bench_slice_trim),
+  };
+
+  s_init_text();
+  int result = x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+  free(s_csv);
+  free(s_prose);
+  return result;
+}
@@ -0,0 +1,137 @@
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdlib.h>
+
+#define WORKERS 4
+#define TASK_COUNT 4096
+#define RANGE_SIZE (1024 * 1024)
+
+static volatile int64_t s_done;
+static float* s_data;
+
+static void s_tiny_task(void* arg)
+{
+  (void)arg;
+  x_atomic_fetch_add_i64(&s_done, 1);
+}
+
+// Enough work per task that scheduling is not the only cost
+static void s_small_task(void* arg)
+{
+  float* p = (float*)arg;
+  for (int32_t i = 0; i < 256; i++)
+    p[i] = p[i] * 0.5f + 1.0f;
+}
+
+static void s_scale_range(int64_t begin, int64_t end, void* ctx)
+{
+  float* p = (float*)ctx;
+  for (int64_t i = begin; i < end; i++)
+    p[i] = p[i] * 0.5f + 1.0f;
+}
+
+static void s_enqueue_tiny(XBench* b, XThreadPoolMode mode)
+{
+  XThreadPool* pool = x_threadpool_create_ex(WORKERS, mode);
+  XTaskGroup group;
+  x_bench_set_items(b, TASK_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_taskgroup_init(&group, pool);
+    for (int32_t i = 0; i < TASK_COUNT; i++)
+      x_taskgroup_run(&group, s_tiny_task, NULL);
+    x_taskgroup_wait(&group);
+  }
+  x_bench_pause(b);
+  x_threadpool_destroy(pool);
+}
+
+static void bench_threadpool_enqueue(XBench* b) { s_enqueue_tiny(b, XTHREADPOOL_MODE_SHARED_QUEUE); }
+static void bench_threadpool_enqueue_stealing(XBench* b) { s_enqueue_tiny(b, XTHREADPOOL_MODE_WORK_STEALING); }
+
+// Caller-owned task nodes: no allocation per task
+static void bench_threadpool_submit(XBench* b)
+{
+  XThreadPool* pool = x_threadpool_create(WORKERS);
+  XTask* tasks = (XTask*)malloc(TASK_COUNT * sizeof(XTask));
+  XTaskGroup group;
+  x_bench_set_items(b, TASK_COUNT);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_taskgroup_init(&group, pool);
+    for (int32_t i = 0; i < TASK_COUNT; i++)
+    {
+      x_task_init(&tasks[i], s_small_task, s_data + (size_t)i * 256);
+      x_taskgroup_submit(&group, &tasks[i]);
+    }
+    x_taskgroup_wait(&group);
+  }
+  x_bench_pause(b);
+  x_threadpool_destroy(pool);
+  free(tasks);
+}
+
+static void bench_threadpool_parallel_for(XBench* b)
+{
+  XThreadPool* pool = x_threadpool_create(WORKERS);
+  x_bench_set_bytes(b, RANGE_SIZE * sizeof(float));
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+    x_threadpool_parallel_for(pool, 0, RANGE_SIZE, 0, s_scale_range, s_data);
+  x_bench_pause(b);
+  x_threadpool_destroy(pool);
+}
+
+// Reference point for bench_threadpool_parallel_for
+static void bench_serial_for(XBench* b)
+{
+  x_bench_set_bytes(b, RANGE_SIZE * sizeof(float));
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    s_scale_range(0, RANGE_SIZE, s_data);
+    x_bench_keep(s_data);
+  }
+}
+
+// Round trip of one task through an idle pool: enqueue until it has run
+static void s_latency(XBench* b, XThreadPoolMode mode)
+{
+  XThreadPool* pool = x_threadpool_create_ex(WORKERS, mode);
+  x_atomic_store_i64(&s_done, 0);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    x_threadpool_enqueue(pool, s_tiny_task, NULL);
+    while (x_atomic_load_i64(&s_done) != (int64_t)(n + 1))
+      x_thread_yield();
+  }
+  x_bench_pause(b);
+  x_threadpool_destroy(pool);
+}
+
+static void bench_threadpool_latency(XBench* b) { s_latency(b, XTHREADPOOL_MODE_SHARED_QUEUE); }
+static void bench_threadpool_latency_stealing(XBench* b) { s_latency(b, XTHREADPOOL_MODE_WORK_STEALING); }
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_threadpool_enqueue),
+    X_BENCH(bench_threadpool_enqueue_stealing),
+    X_BENCH(bench_threadpool_submit),
+    X_BENCH(bench_threadpool_parallel_for),
+    X_BENCH(bench_serial_for),
+    X_BENCH(bench_threadpool_latency),
+    X_BENCH(bench_threadpool_latency_stealing),
+  };
+
+  s_data = (float*)calloc(RANGE_SIZE, sizeof(float));
+  int result = x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+  free(s_data);
+  return result;
+}
@@ -0,0 +1,233 @@
+// Measures requests/s against a running HTTP server, by default the demo
+// webserver. Set STDX_BENCH_WEBSERVER to "ip:port" (127.0.0.1:8080) and
+// STDX_BENCH_WEBSERVER_PATH to the resource to request ("/").
+// Nothing is measured when no server is listening.
+
+#define X_IMPL_STRING
+#include <stdx_string.h>
+#define X_IMPL_IO
+#include <stdx_io.h>
+#define X_IMPL_NETWORK
+#include <stdx_network.h>
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CLIENTS 4
+#define RESPONSE_BUFFER_SIZE (64 * 1024)
+
+static XAddress s_addr;
+static char s_request_keepalive[512];
+static char s_request_close[512];
+static size_t s_request_keepalive_len;
+static size_t s_request_close_len;
+
+static XSocket s_connect(void)
+{
+  XSocket sock = x_net_socket_tcp4();
+  if (!x_net_socket_is_valid(sock))
+    return sock;
+  if (x_net_connect(sock, &s_addr) != 0)
+  {
+    x_net_close(sock);
+    return (XSocket)-1;
+  }
+  return sock;
+}
+
+static bool s_send_all(XSocket sock, const char* data, size_t len)
+{
+  while (len > 0)
+  {
+    size_t sent = x_net_send(sock, data, len);
+    if (sent == 0 || sent == (size_t)-1)
+      return false;
+    data += sent;
+    len -= sent;
+  }
+  return true;
+}
+
+// Reads one response: headers, then Content-Length bytes of body, or up to
+// the close when there is no length. Returns the body size, or -1.
+static int64_t s_read_response(XSocket sock, char* buf)
+{
+  size_t len = 0;
+  char* body = NULL;
+  int64_t content_length = -1;
+  while (!body)
+  {
+    size_t got = x_net_recv(sock, buf + len, RESPONSE_BUFFER_SIZE - 1 - len);
+    if (got == 0 || got == (size_t)-1)
+      return -1;
+    len += got;
+    buf[len] = 0;
+    body = strstr(buf, "\r\n\r\n");
+    if (!body && len == RESPONSE_BUFFER_SIZE - 1)
+      return -1;
+  }
+  body += 4;
+
+  XSlice headers = { buf, (size_t)(body - buf) };
+  XSlice line, name, value;
+  while (x_slice_next_token(&headers, '\n', &line))
+  {
+    if (x_slice_split_at(line, ':', &name, &value) && x_slice_eq_ci(x_slice_trim(name), x_slice_from_cstr("Content-Length")))
+      content_length = strtoll(value.ptr, NULL, 10);
+  }
+
+  size_t have = len - (size_t)(body - buf);
+  while (content_length < 0 || have < (size_t)content_length)
+  {
+    size_t got = x_net_recv(sock, buf, RESPONSE_BUFFER_SIZE);
+    if (got == 0 || got == (size_t)-1)
+      return content_length < 0 ? (int64_t)have : -1;
+    have += got;
+  }
+  return (int64_t)have;
+}
+
+// Sequential requests over one connection
+static void bench_webserver_keepalive(XBench* b)
+{
+  char* buf = (char*)malloc(RESPONSE_BUFFER_SIZE);
+  XSocket sock = s_connect();
+  uint64_t bytes = 0;
+  x_bench_set_items(b, 1);
+  x_bench_reset_timer(b);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    int64_t body;
+    if (!s_send_all(sock, s_request_keepalive, s_request_keepalive_len) || (body = s_read_response(sock, buf)) < 0)
+    {
+      fprintf(stderr, "bench_webserver_keepalive: request failed\n");
+      exit(1);
+    }
+    bytes += (uint64_t)body;
+  }
+  x_bench_pause(b);
+  x_bench_set_bytes(b, b->iterations ? bytes / b->iterations : 0);
+  x_net_close(sock);
+  free(buf);
+}
+
+// Connect, request, read to close: includes the TCP handshake every time
+static void bench_webserver_new_connection(XBench* b)
+{
+  char* buf = (char*)malloc(RESPONSE_BUFFER_SIZE);
+  x_bench_set_items(b, 1);
+  for (uint64_t n = 0; n < b->iterations; n++)
+  {
+    XSocket sock = s_connect();
+    if (!x_net_socket_is_valid(sock)
+        || !s_send_all(sock, s_request_close, s_request_close_len)
+        || s_read_response(sock, buf) < 0)
+    {
+      fprintf(stderr, "bench_webserver_new_connection: request failed\n");
+      exit(1);
+    }
+    x_net_close(sock);
+  }
+  free(buf);
+}
+
+typedef struct
+{
+  uint64_t requests;
+  bool failed;
+} ClientJob;
+
+static void* s_client_main(void* arg)
+{
+  ClientJob* job = (ClientJob*)arg;
+  char* buf = (char*)malloc(RESPONSE_BUFFER_SIZE);
+  XSocket sock = s_connect();
+  job->failed = !x_net_socket_is_valid(sock);
+  for (uint64_t n = 0; n < job->requests && !job->failed; n++)
+  {
+    if (!s_send_all(sock, s_request_keepalive, s_request_keepalive_len) || s_read_response(sock, buf) < 0)
+      job->failed = true;
+  }
+  if (x_net_socket_is_valid(sock))
+    x_net_close(sock);
+  free(buf);
+  return NULL;
+}
+
+// Several keep-alive clients sharing the iterations: server throughput
+static void bench_webserver_concurrent(XBench* b)
+{
+  XThread* threads[CLIENTS];
+  ClientJob jobs[CLIENTS];
+  x_bench_set_items(b, 1);
+  for (int32_t i = 0; i < CLIENTS; i++)
+  {
+    jobs[i].requests = b->iterations / CLIENTS + ((uint64_t)i < b->iterations % CLIENTS ? 1 : 0);
+    jobs[i].failed = false;
+    x_thread_create(&threads[i], s_client_main, &jobs[i]);
+  }
+  for (int32_t i = 0; i < CLIENTS; i++)
+  {
+    x_thread_join(threads[i]);
+    x_thread_destroy(threads[i]);
+    if (jobs[i].failed)
+    {
+      fprintf(stderr, "bench_webserver_concurrent: request failed\n");
+      exit(1);
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  XBenchCase benches[] =
+  {
+    X_BENCH(bench_webserver_keepalive),
+    X_BENCH(bench_webserver_new_connection),
+    X_BENCH(bench_webserver_concurrent),
+  };
+
+  const char* target = getenv("STDX_BENCH_WEBSERVER");
+  const char* path = getenv("STDX_BENCH_WEBSERVER_PATH");
+  char ip[64] = "127.0.0.1";
+  uint16_t port = 8080;
+  if (!path) path = "/";
+  if (target)
+  {
+    const char* colon = strrchr(target, ':');
+    size_t ip_len = colon ? (size_t)(colon - target) : strlen(target);
+    if (ip_len >= sizeof(ip)) ip_len = sizeof(ip) - 1;
+    memcpy(ip, target, ip_len);
+    ip[ip_len] = 0;
+    if (colon) port = (uint16_t)atoi(colon + 1);
+  }
+
+  if (!x_net_init() || x_net_address_from_ip_port((const int8_t*)ip, port, &s_addr) != 0)
+  {
+    fprintf(stderr, "bench_webserver: invalid address %s:%u\n", ip, port);
+    return 1;
+  }
+
+  XSocket probe = s_connect();
+  if (!x_net_socket_is_valid(probe))
+  {
+    printf("bench_webserver: no server at %s:%u, skipping (set STDX_BENCH_WEBSERVER)\n", ip, port);
+    x_net_shutdown();
+    return 0;
+  }
+  x_net_close(probe);
+
+  s_request_keepalive_len = (size_t)snprintf(s_request_keepalive, sizeof(s_request_keepalive),
+      "GET %s HTTP/1.1\r\nHost: %s:%u\r\nConnection: keep-alive\r\n\r\n", path, ip, port);
+  s_request_close_len = (size_t)snprintf(s_request_close, sizeof(s_request_close),
+      "GET %s HTTP/1.1\r\nHost: %s:%u\r\nConnection: close\r\n\r\n", path, ip, port);
+
+  int result = x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+  x_net_shutdown();
+  return result;
+}
@@ -26,6 +26,49 @@
 #include <stdlib.h>
 #include <ctype.h>
 
+#ifndef BAKE_WRITE_CHUNK_SIZE
+/**
+ * @brief Size of the buffer embedded bytes are formatted into before each write.
+ * Can be overriden when compiling.
+ */
+#define BAKE_WRITE_CHUNK_SIZE (256 * 1024)
+#endif
+
+#ifndef BAKE_STRING_BYTES_PER_LINE
+/**
+ * @brief Input bytes per line with `format = string`.
+ * Can be overriden when compiling.
+ */
+#define BAKE_STRING_BYTES_PER_LINE 64
+#endif
+
+#define BAKE_LZ4_HASH_BITS  16
+#define BAKE_LZ4_MIN_MATCH  4
+#define BAKE_LZ4_MF_LIMIT   12  // A match may not start within the last 12 bytes
+#define BAKE_LZ4_LAST_LITERALS 5
+
+/**
+ * How embedded file bytes appear in the generated header.
+ */
+typedef enum
+{
+  BAKE_FORMAT_HEX,     // Array of 0xNNu initializers. Portable, slowest to compile.
+  BAKE_FORMAT_STRING,  // String literal initializer. Much faster to compile.
+  BAKE_FORMAT_EMBED,   // C23 #embed of the source file
+  BAKE_FORMAT_INCBIN   // GNU assembler .incbin of the source file
+} BakeFormat;
+
+/**
+ * Buffers formatted output so large files cost one fwrite per chunk rather
+ * than one fprintf per byte.
+ */
+typedef struct
+{
+  FILE*  out;
+  size_t len;
+  char   buf[BAKE_WRITE_CHUNK_SIZE];
+} BakeWriter;
+
 
 static void s_print_usage(const char* exe)
 {
@@ -42,6 +85,8 @@ static void s_print_usage(const char* exe)
       "  no_strings     = 0|1               # If 0, do NOT emit const char* array for each [section].\n"
       "  no_crc         = 0|1               # If 0, do NOT compute CRC32 for embedded file contents.\n"
       "  bytes_per_line = N                 # Bytes per line for byte arrays (default: 8)\n"
+      "  format         = hex|string|embed|incbin  # How file bytes are embedded (default: hex)\n"
+      "  compress       = none|lz4          # Compress embedded files; the header gets a decompressor\n"
       "  comment        = \"text...\"          # Comment emitted at the top of the generated header\n"
       "                                     # Supports \\n and \\t escapes\n"
       "\n"
@@ -262,62 +307,392 @@ static u32 s_count_total_items(const XIni* ini)
   return total;
 }
 
-static u32 s_crc32_update(u32 crc, const u8* data, size_t size)
-{
-  u32 c = crc ^ 0xFFFFFFFFu;
+static u32 s_crc32_table[8][256];
 
-  for (u32 i = 0; i < size; i++)
+static void s_crc32_init(void)
+{
+  for (u32 i = 0; i < 256; i++)
   {
-    c ^= (u32)data[i];
+    u32 c = i;
     for (u32 b = 0; b < 8; b++)
     {
-      u32 mask = (u32)-(int)(c & 1u);
-      c = (c >> 1) ^ (0xEDB88320u & mask);
+      c = (c >> 1) ^ (0xEDB88320u & (u32)-(int)(c & 1u));
     }
+    s_crc32_table[0][i] = c;
+  }
+
+  for (u32 i = 0; i < 256; i++)
+  {
+    for (u32 t = 1; t < 8; t++)
+    {
+      u32 prev = s_crc32_table[t - 1][i];
+      s_crc32_table[t][i] = (prev >> 8) ^ s_crc32_table[0][prev & 0xFFu];
+    }
+  }
+}
+
+/* CRC-32 (IEEE), slicing-by-8: eight table lookups per 8 input bytes */
+static u32 s_crc32_update(u32 crc, const u8* data, size_t size)
+{
+  u32 c = crc ^ 0xFFFFFFFFu;
+
+  if (s_crc32_table[0][1] == 0)
+  {
+    s_crc32_init();
+  }
+
+  while (size >= 8)
+  {
+    u32 lo = c ^ ((u32)data[0] | ((u32)data[1] << 8) | ((u32)data[2] << 16) | ((u32)data[3] << 24));
+    u32 hi = (u32)data[4] | ((u32)data[5] << 8) | ((u32)data[6] << 16) | ((u32)data[7] << 24);
+
+    c = s_crc32_table[7][lo & 0xFFu]
+      ^ s_crc32_table[6][(lo >> 8) & 0xFFu]
+      ^ s_crc32_table[5][(lo >> 16) & 0xFFu]
+      ^ s_crc32_table[4][lo >> 24]
+      ^ s_crc32_table[3][hi & 0xFFu]
+      ^ s_crc32_table[2][(hi >> 8) & 0xFFu]
+      ^ s_crc32_table[1][(hi >> 16) & 0xFFu]
+      ^ s_crc32_table[0][hi >> 24];
+
+    data += 8;
+    size -= 8;
+  }
+
+  while (size--)
+  {
+    c = (c >> 8) ^ s_crc32_table[0][(c ^ *data++) & 0xFFu];
   }
 
   return c ^ 0xFFFFFFFFu;
 }
 
-static void s_emit_baked_bytes(FILE* out, const char* base, const u8* data, size_t size, int null_terminate, u32 bytes_per_line)
+static void s_writer_flush(BakeWriter* w)
 {
-  fprintf(out, "static const unsigned char %s_BYTES[] =\n{\n", base);
+  if (w->len)
+  {
+    fwrite(w->buf, 1, w->len, w->out);
+    w->len = 0;
+  }
+}
+
+static void s_writer_put(BakeWriter* w, const char* data, size_t size)
+{
+  if (w->len + size > sizeof(w->buf))
+  {
+    s_writer_flush(w);
+  }
 
-  u32 emitted = 0;
+  memcpy(w->buf + w->len, data, size);
+  w->len += size;
+}
+
+/* Emits "  0xNNu, 0xNNu, ...\n" lines, byte for byte what one fprintf per value printed */
+static void s_emit_hex_bytes(BakeWriter* w, const u8* data, size_t size, int null_terminate, u32 bytes_per_line)
+{
+  static const char digits[] = "0123456789ABCDEF";
+  char item[8] = { '0', 'x', 0, 0, 'u', ',', ' ', 0 };
   size_t total = size + (null_terminate ? 1u : 0u);
 
-  while (emitted < total)
+  for (size_t i = 0; i < total; )
   {
-    fprintf(out, "  ");
+    s_writer_put(w, "  ", 2);
+
+    for (u32 n = 0; n < bytes_per_line && i < total; n++, i++)
+    {
+      u8 b = i < size ? data[i] : 0;
+      item[2] = digits[b >> 4];
+      item[3] = digits[b & 0xF];
+      s_writer_put(w, item, i + 1 < total ? 7 : 5);
+    }
 
-    u32 line_count = 0;
-    while (line_count < bytes_per_line && emitted < total)
+    s_writer_put(w, "\n", 1);
+  }
+}
+
+/* One escape per byte value. Octal escapes are always 3 digits, so a
+ * following digit can never extend them, and '?' is escaped to avoid trigraphs. */
+static void s_emit_string_bytes(BakeWriter* w, const u8* data, size_t size, int null_terminate)
+{
+  size_t total = size + (null_terminate ? 1u : 0u);
+
+  static char table[256][4];
+  static u8 table_len[256];
+
+  if (table_len[0] == 0)
+  {
+    for (u32 c = 0; c < 256; c++)
     {
-      u8 b = 0;
-      if (emitted < size)
+      if (c >= 32 && c < 127 && c != '\\' && c != '"' && c != '?')
       {
-        b = data[emitted];
+        table[c][0] = (char)c;
+        table_len[c] = 1;
       }
       else
       {
-        b = 0;
+        table[c][0] = '\\';
+        table[c][1] = (char)('0' + ((c >> 6) & 7));
+        table[c][2] = (char)('0' + ((c >> 3) & 7));
+        table[c][3] = (char)('0' + (c & 7));
+        table_len[c] = 4;
       }
+    }
+  }
 
-      fprintf(out, "0x%02Xu", (unsigned int)b);
+  if (total == 0)
+  {
+    s_writer_put(w, "  \"\"\n", 5);
+    return;
+  }
 
-      emitted++;
-      line_count++;
+  for (size_t i = 0; i < total; )
+  {
+    s_writer_put(w, "  \"", 3);
 
-      if (emitted < total)
-      {
-        fprintf(out, ", ");
-      }
+    for (u32 n = 0; n < BAKE_STRING_BYTES_PER_LINE && i < total; n++, i++)
+    {
+      u8 b = i < size ? data[i] : 0;
+      s_writer_put(w, table[b], table_len[b]);
     }
 
-    fprintf(out, "\n");
+    s_writer_put(w, "\"\n", 2);
+  }
+}
+
+static void s_emit_array(FILE* out, const char* name, const u8* data, size_t size, int null_terminate, BakeFormat format, u32 bytes_per_line)
+{
+  BakeWriter* w = (BakeWriter*)malloc(sizeof(BakeWriter));
+
+  if (!w)
+  {
+    log_error("error: out of memory writing %s\n", name);
+    return;
+  }
+
+  w->out = out;
+  w->len = 0;
+
+  if (format == BAKE_FORMAT_STRING)
+  {
+    // The literal's own terminator lands one past the data, so sizeof is size + 1
+    fprintf(out, "static const unsigned char %s[] =\n", name);
+    s_emit_string_bytes(w, data, size, null_terminate);
+    s_writer_put(w, ";\n", 2);
+  }
+  else
+  {
+    fprintf(out, "static const unsigned char %s[] =\n{\n", name);
+    s_emit_hex_bytes(w, data, size, null_terminate, bytes_per_line);
+    s_writer_put(w, "};\n", 3);
   }
 
-  fprintf(out, "};\n");
+  s_writer_flush(w);
+  free(w);
+}
+
+static void s_emit_baked_bytes(FILE* out, const char* base, const u8* data, size_t size, int null_terminate, BakeFormat format, u32 bytes_per_line)
+{
+  char name[640];
+  snprintf(name, sizeof(name), "%s_BYTES", base);
+  s_emit_array(out, name, data, size, null_terminate, format, bytes_per_line);
+}
+
+/* Length continuation bytes shared by literal and match lengths */
+static u8* s_lz4_put_length(u8* op, size_t len)
+{
+  while (len >= 255)
+  {
+    *op++ = 255;
+    len -= 255;
+  }
+
+  *op++ = (u8)len;
+  return op;
+}
+
+static size_t s_lz4_bound(size_t size)
+{
+  return size + size / 255 + 16;
+}
+
+/**
+ * Compress into the LZ4 block format (no frame). Greedy, one hash probe per
+ * position: bake runs once per build, so the ratio matters more than the speed.
+ */
+static size_t s_lz4_compress(const u8* src, size_t size, u8* dst)
+{
+  u32* table = (u32*)calloc((size_t)1 << BAKE_LZ4_HASH_BITS, sizeof(u32));
+  const u8* anchor = src;
+  const u8* ip = src;
+  const u8* iend = src + size;
+  const u8* mflimit = size > BAKE_LZ4_MF_LIMIT ? iend - BAKE_LZ4_MF_LIMIT : src;
+  const u8* matchlimit = size > BAKE_LZ4_LAST_LITERALS ? iend - BAKE_LZ4_LAST_LITERALS : src;
+  u8* op = dst;
+
+  if (!table)
+  {
+    return 0;
+  }
+
+  while (ip < mflimit)
+  {
+    u32 seq;
+    memcpy(&seq, ip, 4);
+    u32 h = (seq * 2654435761u) >> (32 - BAKE_LZ4_HASH_BITS);
+    const u8* ref = src + table[h];
+    table[h] = (u32)(ip - src);
+
+    u32 ref_seq;
+    memcpy(&ref_seq, ref, 4);
+
+    if (ref >= ip || ip - ref > 0xFFFF || ref_seq != seq)
+    {
+      ip++;
+      continue;
+    }
+
+    const u8* match_end = ip + BAKE_LZ4_MIN_MATCH;
+    const u8* ref_end = ref + BAKE_LZ4_MIN_MATCH;
+    while (match_end < matchlimit && *match_end == *ref_end)
+    {
+      match_end++;
+      ref_end++;
+    }
+
+    size_t lit_len = (size_t)(ip - anchor);
+    size_t match_len = (size_t)(match_end - ip) - BAKE_LZ4_MIN_MATCH;
+    u8* token = op++;
+
+    *token = (u8)(((lit_len < 15 ? lit_len : 15) << 4) | (match_len < 15 ? match_len : 15));
+    if (lit_len >= 15)
+    {
+      op = s_lz4_put_length(op, lit_len - 15);
+    }
+
+    memcpy(op, anchor, lit_len);
+    op += lit_len;
+
+    u32 offset = (u32)(ip - ref);
+    *op++ = (u8)(offset & 0xFF);
+    *op++ = (u8)(offset >> 8);
+
+    if (match_len >= 15)
+    {
+      op = s_lz4_put_length(op, match_len - 15);
+    }
+
+    ip = match_end;
+    anchor = ip;
+  }
+
+  // The last sequence is literals only
+  size_t lit_len = (size_t)(iend - anchor);
+  *op++ = (u8)((lit_len < 15 ? lit_len : 15) << 4);
+  if (lit_len >= 15)
+  {
+    op = s_lz4_put_length(op, lit_len - 15);
+  }
+
+  memcpy(op, anchor, lit_len);
+  op += lit_len;
+
+  free(table);
+  return (size_t)(op - dst);
+}
+
+/* Emitted once per header; guarded so several baked headers can share a translation unit */
+static void s_emit_lz4_decompressor(FILE* out)
+{
+  fputs(
+      "#ifndef BAKE_LZ4_DECOMPRESS\n"
+      "#define BAKE_LZ4_DECOMPRESS\n"
+      "#include <stddef.h>\n"
+      "#include <string.h>\n"
+      "\n"
+      "/* Decompress an LZ4 block. Returns 1 when exactly dst_size bytes were produced. */\n"
+      "static int bake_lz4_decompress(const unsigned char* src, size_t src_size, unsigned char* dst, size_t dst_size)\n"
+      "{\n"
+      "  const unsigned char* ip = src;\n"
+      "  const unsigned char* iend = src + src_size;\n"
+      "  unsigned char* op = dst;\n"
+      "  unsigned char* oend = dst + dst_size;\n"
+      "  while (ip < iend)\n"
+      "  {\n"
+      "    unsigned token = *ip++;\n"
+      "    size_t len = token >> 4;\n"
+      "    size_t offset;\n"
+      "    const unsigned char* match;\n"
+      "    if (len == 15) { unsigned char b; do { if (ip >= iend) return 0; b = *ip++; len += b; } while (b == 255); }\n"
+      "    if ((size_t)(iend - ip) < len || (size_t)(oend - op) < len) return 0;\n"
+      "    while (len--) *op++ = *ip++;\n"
+      "    if (ip == iend) break;\n"
+      "    if (iend - ip < 2) return 0;\n"
+      "    offset = (size_t)ip[0] | ((size_t)ip[1] << 8);\n"
+      "    ip += 2;\n"
+      "    if (offset == 0 || offset > (size_t)(op - dst)) return 0;\n"
+      "    len = token & 15;\n"
+      "    if (len == 15) { unsigned char b; do { if (ip >= iend) return 0; b = *ip++; len += b; } while (b == 255); }\n"
+      "    len += 4;\n"
+      "    if ((size_t)(oend - op) < len) return 0;\n"
+      "    for (match = op - offset; len--; ) *op++ = *match++;\n"
+      "  }\n"
+      "  return op == oend;\n"
+      "}\n"
+      "#endif /* BAKE_LZ4_DECOMPRESS */\n\n",
+      out);
+}
+
+/* Absolute, normalized form of a path relative to the working directory */
+static void s_path_absolute(const XFSPath* path, XFSPath* out)
+{
+  if (x_fs_path_is_absolute(path))
+  {
+    x_fs_path_clone(out, path);
+  }
+  else
+  {
+    XFSPath cwd;
+    x_fs_cwd_get(&cwd);
+    x_fs_path(out, cwd.buf, path->buf);
+  }
+
+  x_fs_path_normalize(out);
+}
+
+/* #embed resolves paths like #include "...": relative to the generated header */
+static void s_emit_embed_bytes(FILE* out, const char* base, const XFSPath* header_dir, const XFSPath* file_path, int null_terminate)
+{
+  XFSPath rel;
+  x_fs_path_relative_to(header_dir, file_path, &rel);
+
+  fprintf(out, "static const unsigned char %s_BYTES[] =\n{\n#embed ", base);
+  s_emit_c_string(out, rel.buf);
+  // suffix() is dropped for an empty file, which if_empty() covers instead
+  fprintf(out, "%s\n};\n", null_terminate ? " suffix(, 0) if_empty(0)" : "");
+}
+
+/* .incbin paths resolve against the compiler's working directory. The path
+ * is written as given (the .ini path from the command line joined with the
+ * entry), never made absolute, so the header is the same on every machine.
+ * Symbols are weak so the header may be included from several translation
+ * units. */
+static void s_emit_incbin_bytes(FILE* out, const char* base, const XFSPath* file_path, int null_terminate)
+{
+  fprintf(out, "__asm__(\n"
+      "  \".pushsection .rodata\\n\"\n"
+      "  \".balign 16\\n\"\n"
+      "  \".weak %s_BYTES\\n\"\n"
+      "  \"%s_BYTES:\\n\"\n"
+      "  \".incbin \\\"%s\\\"\\n\"\n",
+      base, base, file_path->buf);
+
+  if (null_terminate)
+  {
+    fprintf(out, "  \".byte 0\\n\"\n");
+  }
+
+  fprintf(out, "  \".popsection\\n\");\n"
+      "extern const unsigned char %s_BYTES[];\n", base);
 }
 
 static int s_parse_args(int argc, char** argv, const char** out_ini_path, const char** out_out_override)
@@ -378,6 +753,39 @@ static int s_run(const char* ini_path, const char* out_override)
   int bake_crc = x_ini_get_bool(&ini, "", "no_crc", false) ? 1 : 0;
   int bake_bytes_line_size_i = x_ini_get_i32(&ini, "", "bytes_per_line", 8);
   u32 bake_bytes_line_size = 8u;
+  const char* format_name = x_ini_get(&ini, "", "format", "hex");
+  const char* compress_name = x_ini_get(&ini, "", "compress", "none");
+  BakeFormat format = BAKE_FORMAT_HEX;
+  int compress = 0;
+
+  if (strcmp(format_name, "string") == 0)
+    format = BAKE_FORMAT_STRING;
+  else if (strcmp(format_name, "embed") == 0)
+    format = BAKE_FORMAT_EMBED;
+  else if (strcmp(format_name, "incbin") == 0)
+    format = BAKE_FORMAT_INCBIN;
+  else if (strcmp(format_name, "hex") != 0)
+  {
+    log_error("error: unknown format '%s'. Expected hex, string, embed or incbin\n", format_name);
+    x_ini_free(&ini);
+    return 1;
+  }
+
+  if (strcmp(compress_name, "lz4") == 0)
+    compress = 1;
+  else if (strcmp(compress_name, "none") != 0)
+  {
+    log_error("error: unknown compression '%s'. Expected none or lz4\n", compress_name);
+    x_ini_free(&ini);
+    return 1;
+  }
+
+  if (compress && (format == BAKE_FORMAT_EMBED || format == BAKE_FORMAT_INCBIN))
+  {
+    log_error("error: compress = lz4 needs format = hex or string; %s embeds files as they are\n", format_name);
+    x_ini_free(&ini);
+    return 1;
+  }
 
   if (bake_bytes_line_size_i > 0)
   {
@@ -431,6 +839,19 @@ static int s_run(const char* ini_path, const char* out_override)
   u32 total_count = s_count_total_items(&ini);
   fprintf(out, "#define %s_COUNT %uu\n\n", include_guard, (unsigned int) total_count);
 
+  if (compress)
+  {
+    s_emit_lz4_decompressor(out);
+  }
+
+  /* #embed paths are relative to the header being written */
+  XFSPath header_dir;
+  {
+    XFSPath abs_out;
+    s_path_absolute(&out_path, &abs_out);
+    x_fs_path_dirname(&abs_out, &header_dir);
+  }
+
   /* ini dir for @paths */
   XFSPath ini_dir;
   x_fs_path_from_slice(x_fs_path_dirname_cstr(ini_path), &ini_dir);
@@ -530,14 +951,73 @@ static int s_run(const char* ini_path, const char* out_override)
         fprintf(out, "#define %s_SIZE %uu\n", base, (unsigned int)baked_size);
         fprintf(out, "#define %s_LEN %uu\n\n", base, (unsigned int)baked_size);
 
-        s_emit_baked_bytes(out, base, file_data, file_size, null_terminate, bake_bytes_line_size);
+        if (compress)
+        {
+          /* The terminator is compressed along with the data, so _SIZE bytes come back out */
+          u8* baked = (u8*)malloc(baked_size ? baked_size : 1);
+          u8* packed = (u8*)malloc(s_lz4_bound(baked_size));
+          size_t packed_size = 0;
 
-        fprintf(out, "#define %s_STR ((const char*)%s_BYTES)\n", base, base);
+          if (baked && packed)
+          {
+            memcpy(baked, file_data, file_size);
+            if (null_terminate)
+              baked[file_size] = 0;
+            packed_size = s_lz4_compress(baked, baked_size, packed);
+          }
 
-        if (null_terminate)
+          if (!packed_size)
+          {
+            log_error("error: failed to compress %s\n", base);
+            free(baked);
+            free(packed);
+            free((void*) file_data);
+            fclose(out);
+            x_ini_free(&ini);
+            return 1;
+          }
+
+          /* Data LZ4 cannot shrink is stored as it is, flagged by _LZ4_RAW.
+           * An empty entry keeps its one-byte block: C has no empty arrays. */
+          int raw = baked_size > 0 && packed_size >= baked_size;
+          char name[640];
+          snprintf(name, sizeof(name), "%s_LZ4", base);
+          fprintf(out, "#define %s_LZ4_RAW %d\n", base, raw);
+          fprintf(out, "#define %s_LZ4_SIZE %uu\n", base, (unsigned int)(raw ? baked_size : packed_size));
+          s_emit_array(out, name, raw ? baked : packed, raw ? baked_size : packed_size, 0, format, bake_bytes_line_size);
+          if (raw)
+            fprintf(out, "#define %s_DECOMPRESS(dst) (memcpy((dst), %s_LZ4, %s_SIZE), 1)\n", base, base, base);
+          else
+            fprintf(out, "#define %s_DECOMPRESS(dst) bake_lz4_decompress(%s_LZ4, %s_LZ4_SIZE, (dst), %s_SIZE)\n",
+                base, base, base, base);
+
+          free(baked);
+          free(packed);
+        }
+        else
         {
-          /* Convenience alias for explicit "this is a C-string" use */
-          fprintf(out, "#define %s_CSTR ((const char*)%s_BYTES)\n", base, base);
+          if (format == BAKE_FORMAT_EMBED)
+          {
+            XFSPath abs_file;
+            s_path_absolute(&full_path, &abs_file);
+            s_emit_embed_bytes(out, base, &header_dir, &abs_file, null_terminate);
+          }
+          else if (format == BAKE_FORMAT_INCBIN)
+          {
+            s_emit_incbin_bytes(out, base, &full_path, null_terminate);
+          }
+          else
+          {
+            s_emit_baked_bytes(out, base, file_data, file_size, null_terminate, format, bake_bytes_line_size);
+          }
+
+          fprintf(out, "#define %s_STR ((const char*)%s_BYTES)\n", base, base);
+
+          if (null_terminate)
+          {
+            /* Convenience alias for explicit "this is a C-string" use */
+            fprintf(out, "#define %s_CSTR ((const char*)%s_BYTES)\n", base, base);
+          }
         }
 
         if (bake_crc)
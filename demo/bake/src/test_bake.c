@@ -0,0 +1,116 @@
+// Runs bake on generated inputs and checks the headers it writes.
+// bake.c is compiled into this file so s_run is reachable.
+
+#define main bake_main
+#include "bake.c"
+#undef main
+
+#define X_IMPL_TEST
+#include <stdx_test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEMP_INI  "test_tmp_bake.ini"
+#define TEMP_DATA "test_tmp_bake_data.bin"
+#define TEMP_OUT  "test_tmp_bake.h"
+#define DATA_SIZE 100000
+
+static bool s_write_file(const char* path, const void* data, size_t size)
+{
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  bool ok = fwrite(data, 1, size, f) == size;
+  fclose(f);
+  return ok;
+}
+
+// Bakes TEMP_DATA with the given top-level options and returns the header text
+static char* s_bake(const char* options)
+{
+  char ini[256];
+  int len = snprintf(ini, sizeof(ini), "guard = TEST_BAKE_H\n%s\n[files]\nDATA = @" TEMP_DATA "\n", options);
+  if (!s_write_file(TEMP_INI, ini, (size_t) len)) return NULL;
+  if (s_run(TEMP_INI, TEMP_OUT) != 0) return NULL;
+  size_t size = 0;
+  return x_io_read_text(TEMP_OUT, &size);
+}
+
+static void s_cleanup(void)
+{
+  remove(TEMP_INI);
+  remove(TEMP_DATA);
+  remove(TEMP_OUT);
+}
+
+int test_lz4_keeps_incompressible_data_raw(void)
+{
+  u8* data = (u8*) malloc(DATA_SIZE);
+  ASSERT_TRUE(data != NULL);
+  u32 seed = 0x12345678u;
+  for (size_t i = 0; i < DATA_SIZE; i++)
+  {
+    seed = seed * 1664525u + 1013904223u;
+    data[i] = (u8) (seed >> 24);
+  }
+  ASSERT_TRUE(s_write_file(TEMP_DATA, data, DATA_SIZE));
+  free(data);
+
+  char* header = s_bake("compress = lz4");
+  ASSERT_TRUE(header != NULL);
+  ASSERT_TRUE(strstr(header, "#define FILES_DATA_LZ4_RAW 1\n") != NULL);
+  ASSERT_TRUE(strstr(header, "#define FILES_DATA_LZ4_SIZE 100000u\n") != NULL);
+  ASSERT_TRUE(strstr(header, "#define FILES_DATA_DECOMPRESS(dst) (memcpy(") != NULL);
+  free(header);
+  s_cleanup();
+  return 0;
+}
+
+int test_lz4_compresses_repetitive_data(void)
+{
+  char* data = (char*) malloc(DATA_SIZE);
+  ASSERT_TRUE(data != NULL);
+  for (size_t i = 0; i < DATA_SIZE; i++)
+    data[i] = "bake "[i % 5];
+  ASSERT_TRUE(s_write_file(TEMP_DATA, data, DATA_SIZE));
+  free(data);
+
+  char* header = s_bake("compress = lz4");
+  ASSERT_TRUE(header != NULL);
+  ASSERT_TRUE(strstr(header, "#define FILES_DATA_LZ4_RAW 0\n") != NULL);
+  const char* size = strstr(header, "#define FILES_DATA_LZ4_SIZE ");
+  ASSERT_TRUE(size != NULL);
+  ASSERT_TRUE(strtoul(size + strlen("#define FILES_DATA_LZ4_SIZE "), NULL, 10) < DATA_SIZE);
+  ASSERT_TRUE(strstr(header, "bake_lz4_decompress(FILES_DATA_LZ4") != NULL);
+  free(header);
+  s_cleanup();
+  return 0;
+}
+
+int test_incbin_path_is_not_absolute(void)
+{
+  ASSERT_TRUE(s_write_file(TEMP_DATA, "incbin", 6));
+  char* header = s_bake("format = incbin");
+  ASSERT_TRUE(header != NULL);
+  ASSERT_TRUE(strstr(header, ".incbin \\\"" TEMP_DATA "\\\"") != NULL);
+
+  XFSPath cwd;
+  x_fs_cwd_get(&cwd);
+  ASSERT_TRUE(cwd.length <= 1 || strstr(header, cwd.buf) == NULL);
+  free(header);
+  s_cleanup();
+  return 0;
+}
+
+int main()
+{
+  STDXTestCase tests[] =
+  {
+    X_TEST(test_lz4_keeps_incompressible_data_raw),
+    X_TEST(test_lz4_compresses_repetitive_data),
+    X_TEST(test_incbin_path_is_not_absolute),
+  };
+
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
+}
@@ -8,6 +8,7 @@
 #define X_IMPL_STRING
 #define X_IMPL_HASHTABLE
 #define X_IMPL_LOG
+#define X_IMPL_THREAD
 #include <stdx_array.h>
 #include <stdx_arena.h>
 #include <stdx_filesystem.h>
@@ -17,6 +18,7 @@
 #include <stdx_string.h>
 #include <stdx_hashtable.h>
 #include <stdx_log.h>
+#include <stdx_thread.h>
 #define MD_IMPL
 #include <markdown.h>
 
@@ -45,6 +47,8 @@ typedef struct DoxterCmdLine
   bool          skip_empty_defines;
   bool          markdown_gobal_comments;
   bool          markdown_index_page;
+  bool          no_cache;
+  u32           jobs;
   u32           num_input_files;
 } DoxterCmdLine;
 
@@ -436,13 +440,14 @@ static void s_render_template(const char *tmpl,
     const char *open = strstr(p, "{{");
     if (!open)
     {
-      x_strbuilder_append(out, p);
+      x_strbuilder_append_ref(out, p, strlen(p));
       break;
     }
 
+    // Literal template text outlives the builder, so reference it
     if (open > p)
     {
-      x_strbuilder_append_substring(out, p, (size_t) (open - p));
+      x_strbuilder_append_ref(out, p, (size_t) (open - p));
     }
 
     const char *close = strstr(open + 2, "}}");
@@ -593,14 +598,14 @@ static void s_render_params_block(const DoxterSymbol *sym,
       }
     }
 
-    if (items->length > 0)
+    if (x_strbuilder_length(items) > 0)
     {
       char *items_str = x_strbuilder_to_string(items);
 
       DoxterTemplateCtx backup;
       s_template_ctx_push(&backup);
       s_template_ctx.role = DOX_TMPL_ROLE_PARAMS;
-      s_template_ctx.params_items = x_slice_init(items_str, (size_t)items->length);
+      s_template_ctx.params_items = x_slice_init(items_str, x_strbuilder_length(items));
       s_template_ctx.symbol = sym;
 
       s_render_template(templates->params_html,
@@ -898,9 +903,7 @@ static void s_template_resolve_placeholder(const char *placeholder,
 
     if (project->config.markdown_gobal_comments)
     {
-      const char* markdown = md_to_html(b.ptr, b.length);
-      u32 len = (u32) (markdown ? strlen(markdown) : 0);
-      x_strbuilder_append_substring(out, markdown, len);
+      md_render_to_strbuilder(b.ptr, b.length, out);
     }
     else
     {
@@ -1255,7 +1258,7 @@ static void s_template_resolve_placeholder(const char *placeholder,
     if (s_placeholder_match(placeholder, hash,
           DOX_PH_BORDER_RADIUS_STR, DOX_PH_BORDER_RADIUS_HASH))
     {
-      x_strbuilder_append_format(out, "%d", cfg->border_radius);
+      x_strbuilder_append_i64(out, cfg->border_radius);
       return;
     }
 
@@ -1341,6 +1344,7 @@ static bool s_cmdline_parse(i32 argc, char** argv, DoxterCmdLine* out)
 {
   memset(out, 0, sizeof(DoxterCmdLine));
   out->output_directory = ".";
+  out->jobs = (u32)x_cpu_info().logical_cpus;
 
   if (argc < 2)
   {
@@ -1352,6 +1356,8 @@ static bool s_cmdline_parse(i32 argc, char** argv, DoxterCmdLine* out)
     printf("  %-32s = %s\n", "--skip-static", "Skip static functions.");
     printf("  %-32s = %s\n", "--skip-undocumented", "Skip undocumented symbols.");
     printf("  %-32s = %s\n", "--skip-empty-defines", "Skip empty defines.");
+    printf("  %-32s = %s\n", "-j <jobs>", "Parse on this many threads. Defaults to the CPU count.");
+    printf("  %-32s = %s\n", "--no-cache", "Parse every file, ignoring the parse cache.");
     return false;
   }
 
@@ -1416,6 +1422,20 @@ static bool s_cmdline_parse(i32 argc, char** argv, DoxterCmdLine* out)
       out->markdown_index_page = 1;
       i++;
     }
+    else if (strcmp(a, "-j") == 0)
+    {
+      if (++i >= argc || atoi(argv[i]) < 1)
+      {
+        fprintf(stderr, "Invalid command line: -j requires a positive number of jobs.\n");
+        return false;
+      }
+      out->jobs = (u32)atoi(argv[i++]);
+    }
+    else if (strcmp(a, "--no-cache") == 0)
+    {
+      out->no_cache = 1;
+      i++;
+    }
     else
     {
       fprintf(stderr, "Invalid command line: Unknown option '%s'.\n", a);
@@ -1512,6 +1532,28 @@ static DoxterProject* s_doxter_project_create(DoxterCmdLine* args)
   return proj;
 }
 
+/**
+ * Writes the builder segments straight to the file, without flattening them
+ */
+static bool s_write_output(const char *path, XStrBuilder *sb)
+{
+  XFile *f = x_io_open(path, "wb");
+  if (!f)
+  {
+    return false;
+  }
+
+  XSlice parts[64];
+  size_t first = 0, n, written = 0;
+  while ((n = x_strbuilder_gather(sb, first, parts, 64)) > 0)
+  {
+    written += x_io_writev(f, parts, n);
+    first += n;
+  }
+  x_io_close(f);
+  return written == x_strbuilder_length(sb);
+}
+
 /**
  * Destroys a DoxterProject instance
  */
@@ -1523,6 +1565,95 @@ static void s_doxter_project_destroy(DoxterProject* proj)
   free(proj);
 }
 
+// --------------------------------------------------------
+// Parsing
+// --------------------------------------------------------
+
+/**
+ * One parsing thread. Workers pull source indices from a shared counter and
+ * leave one unit per source; strings live in the worker's own arena.
+ */
+typedef struct
+{
+  DoxterProject     *project;
+  DoxterCache       *cache;
+  DoxterSourceUnit  *units;
+  volatile int32_t  *next;
+  XArena            *arena;
+  u32                parsed;
+  u32                cached;
+  bool               failed;
+} DoxterParseWorker;
+
+static bool s_source_parse(DoxterParseWorker* worker, u32 source_index)
+{
+  DoxterProject* proj = worker->project;
+  DoxterSourceInfo* source = &proj->sources[source_index];
+  DoxterSourceUnit* unit = &worker->units[source_index];
+  const DoxterCacheEntry* entry = doxter_cache_find(worker->cache, source->path);
+  FSFileStat st;
+  bool has_stat = x_fs_file_stat(source->path, &st);
+
+  if (!doxter_source_unit_init(unit, &proj->config, worker->arena))
+    return false;
+
+  if (has_stat)
+  {
+    source->size = st.size;
+    source->mtime = st.modification_time;
+  }
+
+  // Same size and time: trust the cache without reading the file
+  if (entry && has_stat && entry->size == source->size && entry->mtime == source->mtime
+      && doxter_cache_entry_decode(entry, unit))
+  {
+    source->hash = entry->hash;
+    worker->cached++;
+    return true;
+  }
+
+  size_t size = 0;
+  char* text = x_io_read_text(source->path, &size);
+  if (!text)
+    return false;
+
+  source->size = size;
+  source->hash = doxter_hash(text, size);
+
+  // Touched but unchanged
+  if (entry && entry->size == size && entry->hash == source->hash
+      && doxter_cache_entry_decode(entry, unit))
+  {
+    free(text);
+    worker->cached++;
+    return true;
+  }
+
+  doxter_info("Parsing %s\n", source->path);
+  doxter_source_parse(unit, text, size);
+  free(text);
+  worker->parsed++;
+  return true;
+}
+
+static void s_parse_worker(void* arg)
+{
+  DoxterParseWorker* worker = (DoxterParseWorker*) arg;
+
+  for (;;)
+  {
+    i32 index = x_atomic_fetch_add_i32(worker->next, 1);
+    if (index >= (i32)worker->project->source_count)
+      break;
+
+    if (!s_source_parse(worker, (u32)index))
+    {
+      doxter_error("Error parsing %s. Failed to open file.\n", worker->project->sources[index].path);
+      worker->failed = true;
+    }
+  }
+}
+
 // --------------------------------------------------------
 // Main
 // --------------------------------------------------------
@@ -1559,15 +1690,71 @@ i32 main(i32 argc, char **argv)
   // --------------------------------------------------------
   // Parse all files, collect symbols and comments
   // --------------------------------------------------------
-  for (u32 arg_i = 0; arg_i < proj->source_count; arg_i++)
+  XFSPath cache_path;
+  x_fs_path(&cache_path, args.output_directory, DOXTER_CACHE_FILE);
+  DoxterCache* cache = args.no_cache ? NULL : doxter_cache_load(cache_path.buf, &proj->config);
+
+  u32 jobs = args.jobs < proj->source_count ? args.jobs : proj->source_count;
+  if (jobs < 1)
+    jobs = 1;
+
+  // The calling thread parses too, so the pool gets one thread less
+  XThreadPool* pool = jobs > 1 ? x_threadpool_create((i32)jobs - 1) : NULL;
+  if (!pool)
+    jobs = 1;
+
+  volatile int32_t next_source = 0;
+  DoxterSourceUnit units[DOXTER_MAX_MODULES];
+  DoxterParseWorker* workers = (DoxterParseWorker*) calloc(jobs, sizeof(DoxterParseWorker));
+  memset(units, 0, sizeof(units));
+
+  for (u32 i = 0; i < jobs; i++)
   {
-    const char* path = proj->sources[arg_i].path;
-    doxter_info("Parsing %s\n", path);
-    i32 count = doxter_source_parse(proj, arg_i);
-    if (count < 0)
-      doxter_error("Error parsing %s. Failed to open file.", path);
+    workers[i].project = proj;
+    workers[i].cache   = cache;
+    workers[i].units   = units;
+    workers[i].next    = &next_source;
+    workers[i].arena   = x_arena_create(1024 * 1024);
   }
 
+  if (pool)
+  {
+    XTaskGroup group;
+    x_taskgroup_init(&group, pool);
+
+    for (u32 i = 0; i < jobs; i++)
+    {
+      if (x_taskgroup_run(&group, s_parse_worker, &workers[i]) != 0)
+        s_parse_worker(&workers[i]);
+    }
+
+    x_taskgroup_wait(&group);
+    x_threadpool_destroy(pool);
+  }
+  else
+  {
+    s_parse_worker(&workers[0]);
+  }
+
+  u32 parsed = 0, cached = 0;
+  for (u32 i = 0; i < jobs; i++)
+  {
+    parsed += workers[i].parsed;
+    cached += workers[i].cached;
+    had_error |= workers[i].failed;
+  }
+
+  // Source order, so the output does not depend on which thread parsed what
+  doxter_project_merge(proj, units);
+  doxter_info("Parsed %u files, %u from cache\n", parsed, cached);
+
+  if (!args.no_cache && !doxter_cache_save(cache_path.buf, &proj->config, proj, units))
+    doxter_warning("Failed to write parse cache '%s'\n", cache_path.buf);
+
+  doxter_cache_destroy(cache);
+  for (u32 i = 0; i < proj->source_count; i++)
+    doxter_source_unit_term(&units[i]);
+
   // --------------------------------------------------------
   // Save each symbol from each source into the stdx_hashtable
   // for cross links later.
@@ -1632,10 +1819,8 @@ i32 main(i32 argc, char **argv)
     s_render_template(proj->templates.file_index_html,
         proj, source_i, sb);
 
-    char *html = x_strbuilder_to_string(sb);
-
     x_fs_path(&full_path, args.output_directory, source->output_name);
-    if (!x_io_write_text(full_path.buf, html))
+    if (!s_write_output(full_path.buf, sb))
     {
       fprintf(stderr, "Failed to write output file '%s'\n", full_path.buf);
       had_error = true;
@@ -1654,9 +1839,8 @@ i32 main(i32 argc, char **argv)
     s_template_ctx_pop(&backup);
   }
 
-  char *html = x_strbuilder_to_string(sb);
   x_fs_path(&full_path, args.output_directory, "index.html");
-  if (!x_io_write_text(full_path.buf, html))
+  if (!s_write_output(full_path.buf, sb))
   {
     fprintf(stderr,
         "Failed to write project index file '%s'\\n", full_path.buf);
@@ -1677,9 +1861,7 @@ i32 main(i32 argc, char **argv)
   s_render_template(proj->templates.style_css,
       proj, 0, sb); s_template_ctx_pop(&backup);
 
-  char *css = x_strbuilder_to_string(sb);
-
-  if (!x_io_write_text(full_path.buf, css))
+  if (!s_write_output(full_path.buf, sb))
   {
     fprintf(stderr, "Failed to write project css file '%s'\\n", full_path.buf);
     had_error = true;
@@ -1727,6 +1909,11 @@ i32 main(i32 argc, char **argv)
   x_strbuilder_destroy(sb);
   s_doxter_project_destroy(proj);
 
+  // Symbol strings live in the worker arenas
+  for (u32 i = 0; i < jobs; i++)
+    x_arena_destroy(workers[i].arena);
+  free(workers);
+
   return had_error ? 1 : 0;
 }
 
@@ -7,6 +7,7 @@
 #include <stdx_array.h>
 #include <stdx_arena.h>
 #include <stdx_strbuilder.h>
+#include <time.h>
 
 #ifndef DOXTER_COMMENT_MAX_ARGS
 #define DOXTER_COMMENT_MAX_ARGS 32
@@ -16,6 +17,14 @@
 #define DOXTER_MAX_MODULES 64
 #endif
 
+#ifndef DOXTER_CACHE_FILE
+/**
+ * @brief Name of the parse cache, written to the output directory.
+ * Can be overriden when compiling.
+ */
+#define DOXTER_CACHE_FILE ".doxter_cache"
+#endif
+
 
 typedef enum DoxterTokenKind
 {
@@ -200,6 +209,9 @@ typedef struct
   char *output_name;        // source output file name with html extension
   u32   num_symbols;        // number of symbols for this source in DoxterProject.symbols
   u32   first_symbol_index; // index of first symbol in DoxterProject.symbols
+  u64   size;               // source size in bytes when parsed
+  time_t mtime;             // source modification time when parsed
+  u64   hash;               // hash of the source text, 0 when not read
 } DoxterSourceInfo;
 
 typedef struct
@@ -215,13 +227,83 @@ typedef struct
 } DoxterProject;
 
 /**
- * @brief Collects all symbols from a source file. Comments are also collected
- * when present.
- * @param source Source file to scan for symbols
- * @param aray An XArray for storing the symbols
+ * Symbols and tokens of a single source file. Files are parsed into units
+ * independently, so they can be parsed on any thread, and merged into the
+ * project afterwards. Token indices are local to the unit until merged.
+ */
+typedef struct
+{
+  const DoxterConfig *config;
+  XArena             *scratch;  // Owns token and symbol strings. Must outlive the project.
+  XArray             *tokens;   // Index 0 is a placeholder, so 0 still means "no token"
+  XArray             *symbols;
+} DoxterSourceUnit;
+
+bool doxter_source_unit_init(DoxterSourceUnit* unit, const DoxterConfig* config, XArena* scratch);
+
+void doxter_source_unit_term(DoxterSourceUnit* unit);
+
+/**
+ * @brief Collects all symbols from a source text into a unit. Comments are
+ * also collected when present.
+ * @param unit Unit receiving the tokens and symbols
+ * @param input Source text to scan for symbols
+ * @param file_size Length of the source text
  * @return the number or symbols found
  */
-i32 doxter_source_parse(DoxterProject* proj, u32 source_index);
+i32 doxter_source_parse(DoxterSourceUnit* unit, const char* input, size_t file_size);
+
+/**
+ * @brief Appends one unit per project source, in source order, to the
+ * project tokens and symbols. Declarations already documented by an earlier
+ * file are dropped, as if all files had been parsed one after the other.
+ * @param proj Project receiving the symbols
+ * @param units One unit per entry of proj->sources
+ */
+void doxter_project_merge(DoxterProject* proj, DoxterSourceUnit* units);
+
+typedef struct DoxterCache DoxterCache;
+
+typedef struct
+{
+  u64         size;
+  time_t      mtime;
+  u64         hash;
+  const u8   *data;      // Encoded tokens and symbols, inside the loaded cache file
+  size_t      data_size;
+} DoxterCacheEntry;
+
+/**
+ * @brief Hash of a source text, as stored in the parse cache.
+ */
+u64 doxter_hash(const void* data, size_t size);
+
+/**
+ * @brief Loads the parse cache. A missing, corrupt or outdated file, or one
+ * written with different parsing options, yields an empty cache.
+ * @return The cache or NULL when out of memory
+ */
+DoxterCache* doxter_cache_load(const char* path, const DoxterConfig* config);
+
+/**
+ * @brief Finds the entry of a source path. The cache is read only after
+ * loading, so lookups are safe from any thread.
+ */
+const DoxterCacheEntry* doxter_cache_find(DoxterCache* cache, const char* path);
+
+/**
+ * @brief Decodes a cache entry into an initialized, empty unit.
+ * @return false if the entry is malformed. The unit is left empty.
+ */
+bool doxter_cache_entry_decode(const DoxterCacheEntry* entry, DoxterSourceUnit* unit);
+
+/**
+ * @brief Writes every parsed source of the project to the cache file.
+ * Sources without a hash are left out.
+ */
+bool doxter_cache_save(const char* path, const DoxterConfig* config, const DoxterProject* proj, const DoxterSourceUnit* units);
+
+void doxter_cache_destroy(DoxterCache* cache);
 
 bool doxter_symbol_map_get(DoxterProject *project, XSlice text, DoxterSymbol *out_sym);
 
@@ -0,0 +1,390 @@
+#include "doxter.h"
+#include <stdx_io.h>
+#include <stdx_filesystem.h>
+#include <stdx_hashtable.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// --------------------------------------------------------
+// Parse cache
+//
+// One binary file holding, per source path, its size, modification time and
+// text hash followed by the unit it parsed into. The cache is only valid for
+// the binary that wrote it: symbols are stored as raw structs, and the header
+// records their size together with the options that affect parsing.
+// --------------------------------------------------------
+
+#define DOXTER_CACHE_MAGIC    0x43584f44u /* "DOXC" */
+#define DOXTER_CACHE_VERSION  1u
+
+X_HASHTABLE_TYPE_CSTR_KEY_NAMED(u32, dox_cache_index)
+
+struct DoxterCache
+{
+  u8                      *data;        // The whole cache file. Entries point into it.
+  u32                      entry_count;
+  DoxterCacheEntry        *entries;
+  XHashtable_dox_cache_index *index;    // Path -> entry
+};
+
+typedef struct
+{
+  const u8 *ptr;
+  const u8 *end;
+  bool      ok;
+} DoxterCacheReader;
+
+typedef struct
+{
+  u8     *data;
+  size_t  size;
+  size_t  capacity;
+  bool    ok;
+} DoxterCacheWriter;
+
+u64 doxter_hash(const void* data, size_t size)
+{
+  // FNV-1a
+  const u8* p = (const u8*)data;
+  u64 hash = 0xcbf29ce484222325ull;
+
+  for (size_t i = 0; i < size; i++)
+  {
+    hash ^= p[i];
+    hash *= 0x100000001b3ull;
+  }
+
+  // 0 marks a source that was never read
+  return hash ? hash : 1;
+}
+
+static u32 s_cache_options(const DoxterConfig* config)
+{
+  return (config->skip_static_functions ? 1u : 0u)
+    | (config->skip_undocumented ? 2u : 0u)
+    | (config->skip_empty_defines ? 4u : 0u);
+}
+
+static const u8* s_read_bytes(DoxterCacheReader* r, size_t n)
+{
+  const u8* p = r->ptr;
+
+  if (!r->ok || (size_t)(r->end - r->ptr) < n)
+  {
+    r->ok = false;
+    return NULL;
+  }
+
+  r->ptr += n;
+  return p;
+}
+
+static u32 s_read_u32(DoxterCacheReader* r)
+{
+  u32 v = 0;
+  const u8* p = s_read_bytes(r, sizeof(v));
+  if (p)
+    memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static u64 s_read_u64(DoxterCacheReader* r)
+{
+  u64 v = 0;
+  const u8* p = s_read_bytes(r, sizeof(v));
+  if (p)
+    memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static XSlice s_read_slice(DoxterCacheReader* r)
+{
+  u32 length = s_read_u32(r);
+  const u8* p = s_read_bytes(r, length);
+  return p ? x_slice_init((const char*)p, length) : x_slice_empty();
+}
+
+static void s_write_bytes(DoxterCacheWriter* w, const void* data, size_t n)
+{
+  if (!w->ok)
+    return;
+
+  if (w->size + n > w->capacity)
+  {
+    size_t capacity = w->capacity ? w->capacity : 64 * 1024;
+    while (capacity < w->size + n)
+      capacity *= 2;
+
+    u8* grown = (u8*)realloc(w->data, capacity);
+    if (!grown)
+    {
+      w->ok = false;
+      return;
+    }
+
+    w->data = grown;
+    w->capacity = capacity;
+  }
+
+  memcpy(w->data + w->size, data, n);
+  w->size += n;
+}
+
+static void s_write_u32(DoxterCacheWriter* w, u32 v)
+{
+  s_write_bytes(w, &v, sizeof(v));
+}
+
+static void s_write_u64(DoxterCacheWriter* w, u64 v)
+{
+  s_write_bytes(w, &v, sizeof(v));
+}
+
+static void s_write_slice(DoxterCacheWriter* w, XSlice s)
+{
+  s_write_u32(w, (u32)s.length);
+  s_write_bytes(w, s.ptr, s.length);
+}
+
+// Skips over one encoded unit, so entries can be indexed without decoding them
+static void s_skip_unit(DoxterCacheReader* r)
+{
+  u32 token_count = s_read_u32(r);
+  u32 symbol_count = s_read_u32(r);
+
+  for (u32 i = 0; i < token_count && r->ok; i++)
+  {
+    s_read_u32(r);
+    s_read_slice(r);
+  }
+
+  for (u32 i = 0; i < symbol_count && r->ok; i++)
+  {
+    s_read_bytes(r, sizeof(DoxterSymbol));
+    s_read_slice(r);
+    s_read_slice(r);
+    s_read_slice(r);
+  }
+}
+
+static bool s_cache_index(DoxterCache* cache, size_t size, const DoxterConfig* config)
+{
+  DoxterCacheReader r = { cache->data, cache->data + size, true };
+
+  if (s_read_u32(&r) != DOXTER_CACHE_MAGIC
+      || s_read_u32(&r) != DOXTER_CACHE_VERSION
+      || s_read_u32(&r) != (u32)sizeof(DoxterSymbol)
+      || s_read_u32(&r) != s_cache_options(config))
+  {
+    return false;
+  }
+
+  u32 count = s_read_u32(&r);
+  if (!r.ok || count > DOXTER_MAX_MODULES)
+    return false;
+
+  cache->entries = (DoxterCacheEntry*)calloc(count ? count : 1, sizeof(DoxterCacheEntry));
+  if (!cache->entries)
+    return false;
+
+  for (u32 i = 0; i < count; i++)
+  {
+    DoxterCacheEntry* entry = &cache->entries[i];
+    XSlice path = s_read_slice(&r);
+    char path_cstr[X_FS_PAHT_MAX_LENGTH];
+
+    entry->size = s_read_u64(&r);
+    entry->mtime = (time_t)s_read_u64(&r);
+    entry->hash = s_read_u64(&r);
+    entry->data = r.ptr;
+    s_skip_unit(&r);
+    entry->data_size = r.ok ? (size_t)(r.ptr - entry->data) : 0;
+
+    if (!r.ok || path.length >= sizeof(path_cstr))
+      return false;
+
+    memcpy(path_cstr, path.ptr, path.length);
+    path_cstr[path.length] = 0;
+    x_hashtable_dox_cache_index_set(cache->index, path_cstr, i);
+  }
+
+  cache->entry_count = count;
+  return true;
+}
+
+DoxterCache* doxter_cache_load(const char* path, const DoxterConfig* config)
+{
+  DoxterCache* cache = (DoxterCache*)calloc(1, sizeof(DoxterCache));
+  if (!cache)
+    return NULL;
+
+  cache->index = x_hashtable_dox_cache_index_create();
+  if (!cache->index)
+  {
+    free(cache);
+    return NULL;
+  }
+
+  XFile* f = x_io_open(path, "rb");
+  if (!f)
+    return cache;
+
+  size_t size = 0;
+  cache->data = (u8*)x_io_read_all(f, &size);
+  x_io_close(f);
+
+  if (cache->data && !s_cache_index(cache, size, config))
+  {
+    // Start over rather than trusting part of a damaged file
+    x_hashtable_dox_cache_index_destroy(cache->index);
+    free(cache->entries);
+    free(cache->data);
+    memset(cache, 0, sizeof(*cache));
+    cache->index = x_hashtable_dox_cache_index_create();
+  }
+
+  return cache;
+}
+
+const DoxterCacheEntry* doxter_cache_find(DoxterCache* cache, const char* path)
+{
+  u32 i;
+
+  if (!cache || !cache->index || !x_hashtable_dox_cache_index_get(cache->index, path, &i))
+    return NULL;
+
+  return &cache->entries[i];
+}
+
+static const char* s_dup(XArena* arena, XSlice s)
+{
+  return s.length ? x_arena_slicedup(arena, s.ptr, s.length, true) : "";
+}
+
+bool doxter_cache_entry_decode(const DoxterCacheEntry* entry, DoxterSourceUnit* unit)
+{
+  DoxterCacheReader r = { entry->data, entry->data + entry->data_size, true };
+  u32 token_count = s_read_u32(&r);
+  u32 symbol_count = s_read_u32(&r);
+
+  for (u32 i = 0; i < token_count && r.ok; i++)
+  {
+    DoxterToken t;
+    t.kind = (DoxterTokenKind)s_read_u32(&r);
+    t.text = s_read_slice(&r);
+    t.text.ptr = s_dup(unit->scratch, t.text);
+    t.start = t.text.ptr;
+    x_array_push(unit->tokens, &t);
+  }
+
+  for (u32 i = 0; i < symbol_count && r.ok; i++)
+  {
+    DoxterSymbol sym;
+    const u8* raw = s_read_bytes(&r, sizeof(sym));
+    if (!raw)
+      break;
+
+    memcpy(&sym, raw, sizeof(sym));
+    sym.comment = s_read_slice(&r);
+    sym.declaration = s_read_slice(&r);
+    sym.name = s_read_slice(&r);
+    sym.comment.ptr = s_dup(unit->scratch, sym.comment);
+    sym.declaration.ptr = s_dup(unit->scratch, sym.declaration);
+    sym.name.ptr = s_dup(unit->scratch, sym.name);
+    x_array_push(unit->symbols, &sym);
+  }
+
+  if (!r.ok || x_array_count(unit->tokens) != token_count + 1)
+  {
+    // Back to an empty unit, so the caller can parse instead
+    doxter_source_unit_term(unit);
+    doxter_source_unit_init(unit, unit->config, unit->scratch);
+    return false;
+  }
+
+  return true;
+}
+
+static void s_write_unit(DoxterCacheWriter* w, const DoxterSourceUnit* unit)
+{
+  u32 token_count = x_array_count(unit->tokens);
+  u32 symbol_count = x_array_count(unit->symbols);
+
+  // The placeholder token is recreated by doxter_source_unit_init()
+  s_write_u32(w, token_count - 1);
+  s_write_u32(w, symbol_count);
+
+  for (u32 i = 1; i < token_count; i++)
+  {
+    const DoxterToken* t = x_array_get(unit->tokens, i);
+    s_write_u32(w, (u32)t->kind);
+    s_write_slice(w, t->text);
+  }
+
+  for (u32 i = 0; i < symbol_count; i++)
+  {
+    const DoxterSymbol* sym = x_array_get(unit->symbols, i);
+    s_write_bytes(w, sym, sizeof(*sym));
+    s_write_slice(w, sym->comment);
+    s_write_slice(w, sym->declaration);
+    s_write_slice(w, sym->name);
+  }
+}
+
+bool doxter_cache_save(const char* path, const DoxterConfig* config, const DoxterProject* proj, const DoxterSourceUnit* units)
+{
+  DoxterCacheWriter w = { NULL, 0, 0, true };
+  u32 count = 0;
+
+  for (u32 i = 0; i < proj->source_count; i++)
+  {
+    if (proj->sources[i].hash && units[i].tokens)
+      count++;
+  }
+
+  s_write_u32(&w, DOXTER_CACHE_MAGIC);
+  s_write_u32(&w, DOXTER_CACHE_VERSION);
+  s_write_u32(&w, (u32)sizeof(DoxterSymbol));
+  s_write_u32(&w, s_cache_options(config));
+  s_write_u32(&w, count);
+
+  for (u32 i = 0; i < proj->source_count; i++)
+  {
+    const DoxterSourceInfo* source = &proj->sources[i];
+
+    if (!source->hash || !units[i].tokens)
+      continue;
+
+    s_write_slice(&w, x_slice(source->path));
+    s_write_u64(&w, source->size);
+    s_write_u64(&w, (u64)source->mtime);
+    s_write_u64(&w, source->hash);
+    s_write_unit(&w, &units[i]);
+  }
+
+  bool ok = w.ok;
+  if (ok)
+  {
+    XFile* f = x_io_open(path, "wb");
+    ok = f && x_io_write(f, w.data, w.size) == w.size;
+    if (f)
+      x_io_close(f);
+  }
+
+  free(w.data);
+  return ok;
+}
+
+void doxter_cache_destroy(DoxterCache* cache)
+{
+  if (!cache)
+    return;
+
+  if (cache->index)
+    x_hashtable_dox_cache_index_destroy(cache->index);
+
+  free(cache->entries);
+  free(cache->data);
+  free(cache);
+}
@@ -38,7 +38,7 @@ static bool s_char_is_ident_char(char c)
   return false;
 }
 
-static XSlice s_cleanup_comment(DoxterProject* proj, XSlice comment)
+static XSlice s_cleanup_comment(DoxterSourceUnit* unit, XSlice comment)
 {
   comment = x_slice_trim(comment);
 
@@ -54,7 +54,7 @@ static XSlice s_cleanup_comment(DoxterProject* proj, XSlice comment)
   }
 
   // Worst-case output is <= input length (+1 for NUL).
-  char* out = x_arena_alloc(proj->scratch, comment.length + 1);
+  char* out = x_arena_alloc(unit->scratch, comment.length + 1);
   size_t out_len = 0;
 
   XSlice c = comment;
@@ -437,11 +437,11 @@ static bool s_token_is_punct(DoxterToken t, char c)
   return t.kind == DOXTER_PUNCT && t.text.length == 1 && t.text.ptr[0] == c;
 }
 
-static DoxterToken s_token_dup(DoxterProject* proj, DoxterToken t)
+static DoxterToken s_token_dup(DoxterSourceUnit* unit, DoxterToken t)
 {
   if (t.text.length > 0)
   {
-    char* dup = x_arena_slicedup(proj->scratch, t.text.ptr, t.text.length, true);
+    char* dup = x_arena_slicedup(unit->scratch, t.text.ptr, t.text.length, true);
     t.text.ptr = dup;
   }
   else
@@ -454,12 +454,12 @@ static DoxterToken s_token_dup(DoxterProject* proj, DoxterToken t)
   return t;
 }
 
-static u32 s_find_matching_paren(DoxterProject* proj, u32 open_i, u32 first, u32 end)
+static u32 s_find_matching_paren(DoxterSourceUnit* unit, u32 open_i, u32 end)
 {
   u32 depth = 0;
   for (u32 i = open_i; i < end; ++i)
   {
-    DoxterToken* t = x_array_get(proj->tokens, i);
+    DoxterToken* t = x_array_get(unit->tokens, i);
 
     if (s_tok_is_punct_text(t, '('))
     {
@@ -477,12 +477,12 @@ static u32 s_find_matching_paren(DoxterProject* proj, u32 open_i, u32 first, u32
   return 0;
 }
 
-static u32 s_find_matching_brace(DoxterProject* proj, u32 open_i, u32 first, u32 end)
+static u32 s_find_matching_brace(DoxterSourceUnit* unit, u32 open_i, u32 end)
 {
   u32 depth = 0;
   for (u32 i = open_i; i < end; ++i)
   {
-    DoxterToken* t = x_array_get(proj->tokens, i);
+    DoxterToken* t = x_array_get(unit->tokens, i);
 
     if (s_tok_is_punct_text(t, '{'))
     {
@@ -504,7 +504,7 @@ static u32 s_find_matching_brace(DoxterProject* proj, u32 open_i, u32 first, u32
 // Symbol composing
 // --------------------------------------------------------
 
-static void s_symbol_fill_function_stmt(DoxterProject* proj, DoxterSymbol* sym)
+static void s_symbol_fill_function_stmt(DoxterSourceUnit* unit, DoxterSymbol* sym)
 {
   sym->stmt.fn.name_tok = 0;
   sym->stmt.fn.return_ts.first = 0;
@@ -521,7 +521,7 @@ static void s_symbol_fill_function_stmt(DoxterProject* proj, DoxterSymbol* sym)
 
   for (u32 i = first; i < end; ++i)
   {
-    DoxterToken* t = x_array_get(proj->tokens, i);
+    DoxterToken* t = x_array_get(unit->tokens, i);
 
     if (s_tok_is_punct_text(t, '('))
     {
@@ -548,7 +548,7 @@ static void s_symbol_fill_function_stmt(DoxterProject* proj, DoxterSymbol* sym)
 
   /* Name token: the identifier right before '(' (common prototypes) */
   u32 name_i = open_paren - 1;
-  DoxterToken* name_t = x_array_get(proj->tokens, name_i);
+  DoxterToken* name_t = x_array_get(unit->tokens, name_i);
   if (name_t->kind != DOXTER_IDENT)
   {
     return;
@@ -557,7 +557,7 @@ static void s_symbol_fill_function_stmt(DoxterProject* proj, DoxterSymbol* sym)
   sym->stmt.fn.name_tok = name_i;
 
   /* Params span: ( ... ) including parens */
-  u32 close_paren = s_find_matching_paren(proj, open_paren, first, end);
+  u32 close_paren = s_find_matching_paren(unit, open_paren, end);
   if (close_paren != 0 && close_paren >= open_paren)
   {
     sym->stmt.fn.params_ts.first = open_paren;
@@ -576,7 +576,7 @@ static void s_symbol_fill_function_stmt(DoxterProject* proj, DoxterSymbol* sym)
 
     for (u32 i = start; i < end; ++i)
     {
-      const DoxterToken *t = x_array_get(proj->tokens, i);
+      const DoxterToken *t = x_array_get(unit->tokens, i);
 
       if (t->kind == DOXTER_PUNCT && t->text.length == 1)
       {
@@ -626,7 +626,7 @@ static void s_symbol_fill_function_stmt(DoxterProject* proj, DoxterSymbol* sym)
   sym->stmt.fn.return_ts.count = (name_i > first) ? (name_i - first) : 0;
 }
 
-static void s_symbol_fill_macro_stmt(DoxterProject* proj, DoxterSymbol* sym)
+static void s_symbol_fill_macro_stmt(DoxterSourceUnit* unit, DoxterSymbol* sym)
 {
   sym->stmt.macro.name_tok = 0;
   sym->stmt.macro.args_ts.first = 0;
@@ -644,7 +644,7 @@ static void s_symbol_fill_macro_stmt(DoxterProject* proj, DoxterSymbol* sym)
     return;
   }
 
-  DoxterToken* d = x_array_get(proj->tokens, i);
+  DoxterToken* d = x_array_get(unit->tokens, i);
   if (d->kind != DOXTER_MACRO_DIRECTIVE)
   {
     return;
@@ -653,7 +653,7 @@ static void s_symbol_fill_macro_stmt(DoxterProject* proj, DoxterSymbol* sym)
   i++;
   while (i < end)
   {
-    DoxterToken* t = x_array_get(proj->tokens, i);
+    DoxterToken* t = x_array_get(unit->tokens, i);
     if (t->kind == DOXTER_IDENT)
     {
       sym->stmt.macro.name_tok = i;
@@ -671,10 +671,10 @@ static void s_symbol_fill_macro_stmt(DoxterProject* proj, DoxterSymbol* sym)
   /* Optional function-like args: immediately following '(' */
   if (i < end)
   {
-    DoxterToken* t = x_array_get(proj->tokens, i);
+    DoxterToken* t = x_array_get(unit->tokens, i);
     if (s_tok_is_punct_text(t, '('))
     {
-      u32 close_paren = s_find_matching_paren(proj, i, first, end);
+      u32 close_paren = s_find_matching_paren(unit, i, end);
       if (close_paren != 0)
       {
         sym->stmt.macro.args_ts.first = i;
@@ -692,7 +692,7 @@ static void s_symbol_fill_macro_stmt(DoxterProject* proj, DoxterSymbol* sym)
   }
 }
 
-static void s_symbol_fill_record_stmt(DoxterProject* proj, DoxterSymbol* sym)
+static void s_symbol_fill_record_stmt(DoxterSourceUnit* unit, DoxterSymbol* sym)
 {
   sym->stmt.record.name_tok = 0;
   sym->stmt.record.body_ts.first = 0;
@@ -704,7 +704,7 @@ static void s_symbol_fill_record_stmt(DoxterProject* proj, DoxterSymbol* sym)
   /* Find 'struct/union/enum' keyword then optional tag name */
   for (u32 i = first; i + 1 < end; ++i)
   {
-    DoxterToken* t = x_array_get(proj->tokens, i);
+    DoxterToken* t = x_array_get(unit->tokens, i);
 
     if (t->kind == DOXTER_IDENT)
     {
@@ -712,7 +712,7 @@ static void s_symbol_fill_record_stmt(DoxterProject* proj, DoxterSymbol* sym)
       if ((sym->type == DOXTER_STRUCT || sym->type == DOXTER_UNION || sym->type == DOXTER_ENUM) &&
           (x_slice_eq_cstr(t->text, "struct") || x_slice_eq_cstr(t->text, "union") || x_slice_eq_cstr(t->text, "enum")))
       {
-        DoxterToken* n = x_array_get(proj->tokens, i + 1);
+        DoxterToken* n = x_array_get(unit->tokens, i + 1);
         if (n->kind == DOXTER_IDENT)
         {
           sym->stmt.record.name_tok = i + 1;
@@ -722,7 +722,7 @@ static void s_symbol_fill_record_stmt(DoxterProject* proj, DoxterSymbol* sym)
 
     if (s_tok_is_punct_text(t, '{'))
     {
-      u32 close_brace = s_find_matching_brace(proj, i, first, end);
+      u32 close_brace = s_find_matching_brace(unit, i, end);
       if (close_brace != 0)
       {
         sym->stmt.record.body_ts.first = i;
@@ -733,7 +733,7 @@ static void s_symbol_fill_record_stmt(DoxterProject* proj, DoxterSymbol* sym)
   }
 }
 
-static void s_symbol_fill_typedef_stmt(DoxterProject* proj, DoxterSymbol* sym)
+static void s_symbol_fill_typedef_stmt(DoxterSourceUnit* unit, DoxterSymbol* sym)
 {
   sym->stmt.tdef.name_tok = 0;
   sym->stmt.tdef.value_ts.first = 0;
@@ -747,7 +747,7 @@ static void s_symbol_fill_typedef_stmt(DoxterProject* proj, DoxterSymbol* sym)
 
   for (u32 i = first; i < end; ++i)
   {
-    DoxterToken* t = x_array_get(proj->tokens, i);
+    DoxterToken* t = x_array_get(unit->tokens, i);
     if (t->kind == DOXTER_IDENT)
     {
       last_ident = i;
@@ -864,25 +864,25 @@ static DoxterToken s_tokenizer_next_token(DoxterTokenizer* s, u32* out_line, u32
   }
 }
 
-static void s_symbol_dup_slices(DoxterProject* proj, DoxterSymbol* sym)
+static void s_symbol_dup_slices(DoxterSourceUnit* unit, DoxterSymbol* sym)
 {
   sym->comment.ptr = (sym->comment.length ?
-      x_arena_slicedup(proj->scratch,
+      x_arena_slicedup(unit->scratch,
         sym->comment.ptr, sym->comment.length, true)
       : "");
   sym->declaration.ptr = (sym->declaration.length ?
-      x_arena_slicedup(proj->scratch,
+      x_arena_slicedup(unit->scratch,
         sym->declaration.ptr, sym->declaration.length, true)
       : "");
   sym->name.ptr = (sym->name.length ?
-      x_arena_slicedup(proj->scratch,
+      x_arena_slicedup(unit->scratch,
         sym->name.ptr, sym->name.length, true)
       : "");
 }
 
-static void s_symbol_collect_tokens(DoxterProject* proj, XSlice declaration, u32* out_first, u32* out_count)
+static void s_symbol_collect_tokens(DoxterSourceUnit* unit, XSlice declaration, u32* out_first, u32* out_count)
 {
-  *out_first = x_array_count(proj->tokens);
+  *out_first = x_array_count(unit->tokens);
   *out_count = 0;
 
   if (declaration.length == 0)
@@ -912,15 +912,15 @@ static void s_symbol_collect_tokens(DoxterProject* proj, XSlice declaration, u32
       continue;
     }
 
-    t = s_token_dup(proj, t);
-    x_array_push(proj->tokens, &t);
+    t = s_token_dup(unit, t);
+    x_array_push(unit->tokens, &t);
     (*out_count)++;
   }
 }
 
 #ifdef DOXTER_DEBUG_PRINT
 
-static void s_debug_print_token_span( DoxterProject* proj, const char* label, DoxterTokenSpan span)
+static void s_debug_print_token_span( DoxterSourceUnit* unit, const char* label, DoxterTokenSpan span)
 {
   printf("    %s: ", label);
 
@@ -933,7 +933,7 @@ static void s_debug_print_token_span( DoxterProject* proj, const char* label, Do
   for (u32 i = 0; i < span.count; ++i)
   {
     u32 ti = span.first + i;
-    DoxterToken* t = x_array_get(proj->tokens, ti);
+    DoxterToken* t = x_array_get(unit->tokens, ti);
 
     printf("'%.*s'", (int)t->text.length, t->text.ptr);
 
@@ -946,7 +946,7 @@ static void s_debug_print_token_span( DoxterProject* proj, const char* label, Do
   printf("\n");
 }
 
-static void s_debug_print_token_at( DoxterProject* proj, const char* label, u32 tok_index)
+static void s_debug_print_token_at( DoxterSourceUnit* unit, const char* label, u32 tok_index)
 {
   if (tok_index == 0)
   {
@@ -954,7 +954,7 @@ static void s_debug_print_token_at( DoxterProject* proj, const char* label, u32
     return;
   }
 
-  DoxterToken* t = x_array_get(proj->tokens, tok_index);
+  DoxterToken* t = x_array_get(unit->tokens, tok_index);
   printf(
       "    %s: '%.*s'\n",
       label,
@@ -962,7 +962,7 @@ static void s_debug_print_token_at( DoxterProject* proj, const char* label, u32
       t->text.ptr);
 }
 
-void doxter_debug_print_symbol( DoxterProject* proj, const DoxterSymbol* sym)
+void doxter_debug_print_symbol( DoxterSourceUnit* unit, const DoxterSymbol* sym)
 {
   printf("--------------------------------------------------\n");
   printf("Symbol\n");
@@ -992,9 +992,9 @@ void doxter_debug_print_symbol( DoxterProject* proj, const DoxterSymbol* sym)
         const DoxterSymbolFunction* fn = &sym->stmt.fn;
         printf("  FUNCTION\n");
 
-        s_debug_print_token_at(proj, "name_tok", fn->name_tok);
-        s_debug_print_token_span(proj, "params_span", fn->params_ts);
-        s_debug_print_token_span(proj, "return_span", fn->return_ts);
+        s_debug_print_token_at(unit, "name_tok", fn->name_tok);
+        s_debug_print_token_span(unit, "params_span", fn->params_ts);
+        s_debug_print_token_span(unit, "return_span", fn->return_ts);
       } break;
 
     case DOXTER_MACRO:
@@ -1002,9 +1002,9 @@ void doxter_debug_print_symbol( DoxterProject* proj, const DoxterSymbol* sym)
         const DoxterSymbolMacro* m = &sym->stmt.macro;
         printf("  MACRO\n");
 
-        s_debug_print_token_at(proj, "name_tok", m->name_tok);
-        s_debug_print_token_span(proj, "args_span", m->args_ts);
-        s_debug_print_token_span(proj, "value_span", m->value_ts);
+        s_debug_print_token_at(unit, "name_tok", m->name_tok);
+        s_debug_print_token_span(unit, "args_span", m->args_ts);
+        s_debug_print_token_span(unit, "value_span", m->value_ts);
       } break;
 
     case DOXTER_STRUCT:
@@ -1014,8 +1014,8 @@ void doxter_debug_print_symbol( DoxterProject* proj, const DoxterSymbol* sym)
         const DoxterSymbolRecord* r = &sym->stmt.record;
         printf("  RECORD\n");
 
-        s_debug_print_token_at(proj, "tag_tok", r->name_tok);
-        s_debug_print_token_span(proj, "body_span", r->body_ts);
+        s_debug_print_token_at(unit, "tag_tok", r->name_tok);
+        s_debug_print_token_span(unit, "body_span", r->body_ts);
       } break;
 
     case DOXTER_TYPEDEF:
@@ -1023,8 +1023,8 @@ void doxter_debug_print_symbol( DoxterProject* proj, const DoxterSymbol* sym)
         const DoxterSymbolTypedef* td = &sym->stmt.tdef;
         printf("  TYPEDEF\n");
 
-        s_debug_print_token_at(proj, "name_tok", td->name_tok);
-        s_debug_print_token_span(proj, "value_span", td->value_ts);
+        s_debug_print_token_at(unit, "name_tok", td->name_tok);
+        s_debug_print_token_span(unit, "value_span", td->value_ts);
       } break;
 
     default:
@@ -1185,7 +1185,7 @@ static DoxterSymbol* s_find_symbol(XArray* symbols, XSlice name)
   return NULL;
 }
 
-static bool s_filter_symbol(DoxterSymbol* sym, DoxterConfig* cfg)
+static bool s_filter_symbol(DoxterSymbol* sym, const DoxterConfig* cfg)
 {
   if (cfg->skip_empty_defines && sym->is_empty_macro)
     return false;
@@ -1394,34 +1394,34 @@ static bool s_classify_statement(XSlice stmt, XSlice comment, u32 line, u32 col,
   return false;
 }
 
-static bool s_symbol_push(DoxterProject* proj, DoxterSymbol* sym)
+static bool s_symbol_push(DoxterSourceUnit* unit, DoxterSymbol* sym)
 {
-  if (! s_filter_symbol(sym, &proj->config))
+  if (! s_filter_symbol(sym, unit->config))
     return false;
 
   memset(&sym->stmt, 0, sizeof(sym->stmt));
   if (sym->type == DOXTER_FUNCTION)
   {
-    s_symbol_fill_function_stmt(proj, sym);
+    s_symbol_fill_function_stmt(unit, sym);
   }
   else if (sym->type == DOXTER_MACRO)
   {
-    s_symbol_fill_macro_stmt(proj, sym);
+    s_symbol_fill_macro_stmt(unit, sym);
   }
   else if (sym->type == DOXTER_STRUCT || sym->type == DOXTER_UNION || sym->type == DOXTER_ENUM)
   {
-    s_symbol_fill_record_stmt(proj, sym);
+    s_symbol_fill_record_stmt(unit, sym);
   }
   else if (sym->type == DOXTER_TYPEDEF)
   {
-    s_symbol_fill_typedef_stmt(proj, sym);
+    s_symbol_fill_typedef_stmt(unit, sym);
   }
 
 #ifdef DOXTER_DEBUG_PRINT
-  doxter_debug_print_symbol(proj, sym);
+  doxter_debug_print_symbol(unit, sym);
 #endif
 
-  x_array_push(proj->symbols, sym);
+  x_array_push(unit->symbols, sym);
   return true;
 }
 
@@ -1442,7 +1442,7 @@ static void s_reset_stmt_state(
 }
 
 static void s_emit_symbol_from_stmt(
-    DoxterProject* proj,
+    DoxterSourceUnit* unit,
     XSlice stmt,
     XSlice pending_doc,
     u32 stmt_line,
@@ -1462,31 +1462,19 @@ static void s_emit_symbol_from_stmt(
     return;
   }
 
-  if (s_find_symbol(proj->symbols, sym.name))
+  if (s_find_symbol(unit->symbols, sym.name))
   {
     return;
   }
 
-  s_symbol_dup_slices(proj, &sym);
-  s_symbol_collect_tokens(proj, sym.declaration, &sym.first_token_index, &sym.num_tokens);
-  if (s_symbol_push(proj, &sym))
+  s_symbol_dup_slices(unit, &sym);
+  s_symbol_collect_tokens(unit, sym.declaration, &sym.first_token_index, &sym.num_tokens);
+  if (s_symbol_push(unit, &sym))
     (*count)++;
 }
 
-i32 doxter_source_parse(DoxterProject* proj, u32 source_index)
+i32 doxter_source_parse(DoxterSourceUnit* unit, const char* input, size_t file_size)
 {
-  DoxterSourceInfo* source_info = &proj->sources[source_index];
-  source_info->first_symbol_index = x_array_count(proj->symbols);
-  source_info->num_symbols = 0;
-
-  size_t file_size = 0;
-  const char* source_file_name = source_info->path;
-  char* input = x_io_read_text(source_file_name, &file_size);
-  if (!input)
-  {
-    return -1;
-  }
-
   XSlice source = x_slice_init(input, file_size);
 
   DoxterTokenizer ts;
@@ -1509,7 +1497,7 @@ i32 doxter_source_parse(DoxterProject* proj, u32 source_index)
     DoxterToken ft = s_tokenizer_next_token(&tmp, &tok_line, &tok_col);
     if (ft.kind == DOXTER_DOX_COMMENT && ft.text.ptr == source.ptr)
     {
-      XSlice file_comment = s_cleanup_comment(proj, ft.text);
+      XSlice file_comment = s_cleanup_comment(unit, ft.text);
 
       DoxterSymbol sym;
       memset(&sym, 0, sizeof(sym));
@@ -1519,11 +1507,11 @@ i32 doxter_source_parse(DoxterProject* proj, u32 source_index)
       sym.comment = file_comment;
       sym.declaration = x_slice_empty();
       sym.name = x_slice_empty();
-      sym.first_token_index = x_array_count(proj->tokens);
+      sym.first_token_index = x_array_count(unit->tokens);
       sym.num_tokens = 0;
 
-      s_symbol_dup_slices(proj, &sym);
-      if (s_symbol_push(proj, &sym))
+      s_symbol_dup_slices(unit, &sym);
+      if (s_symbol_push(unit, &sym))
         count++;
       ts = tmp;
     }
@@ -1553,7 +1541,7 @@ i32 doxter_source_parse(DoxterProject* proj, u32 source_index)
     if (t.kind == DOXTER_DOX_COMMENT)
     {
       /* Keep parser deterministic: comment becomes pending doc and nothing else. */
-      pending_doc = s_cleanup_comment(proj, t.text);
+      pending_doc = s_cleanup_comment(unit, t.text);
       continue;
     }
 
@@ -1610,9 +1598,9 @@ i32 doxter_source_parse(DoxterProject* proj, u32 source_index)
         sym.name = macro_name;
         sym.is_empty_macro = empty_macro;
 
-        s_symbol_dup_slices(proj, &sym);
-        s_symbol_collect_tokens(proj, sym.declaration, &sym.first_token_index, &sym.num_tokens);
-        if (s_symbol_push(proj, &sym))
+        s_symbol_dup_slices(unit, &sym);
+        s_symbol_collect_tokens(unit, sym.declaration, &sym.first_token_index, &sym.num_tokens);
+        if (s_symbol_push(unit, &sym))
           count++;
       }
 
@@ -1661,7 +1649,7 @@ i32 doxter_source_parse(DoxterProject* proj, u32 source_index)
         sig.ptr = stmt_start ? stmt_start : t.text.ptr;
         sig.length = (size_t)(t.text.ptr - sig.ptr);
 
-        s_emit_symbol_from_stmt(proj, sig, pending_doc, stmt_line, stmt_col, &count);
+        s_emit_symbol_from_stmt(unit, sig, pending_doc, stmt_line, stmt_col, &count);
 
         pending_doc = x_slice_empty();
         stmt_start = NULL;
@@ -1742,7 +1730,7 @@ i32 doxter_source_parse(DoxterProject* proj, u32 source_index)
       stmt.ptr = stmt_start;
       stmt.length = (size_t)((t.text.ptr + t.text.length) - stmt_start);
 
-      s_emit_symbol_from_stmt(proj, stmt, pending_doc, stmt_line, stmt_col, &count);
+      s_emit_symbol_from_stmt(unit, stmt, pending_doc, stmt_line, stmt_col, &count);
 
       pending_doc = x_slice_empty();
       stmt_start = NULL;
@@ -1757,8 +1745,137 @@ i32 doxter_source_parse(DoxterProject* proj, u32 source_index)
     prev_sig = t;
     }
 
-    free(input);
-
-    source_info->num_symbols = count;
     return count;
   }
+
+bool doxter_source_unit_init(DoxterSourceUnit* unit, const DoxterConfig* config, XArena* scratch)
+{
+  DoxterToken placeholder;
+
+  unit->config = config;
+  unit->scratch = scratch;
+  unit->tokens = x_array_create(sizeof(DoxterToken), 64);
+  unit->symbols = x_array_create(sizeof(DoxterSymbol), 32);
+
+  if (!unit->tokens || !unit->symbols)
+  {
+    doxter_source_unit_term(unit);
+    return false;
+  }
+
+  // Symbols use token index 0 as "no token", so no real token may live there
+  memset(&placeholder, 0, sizeof(placeholder));
+  placeholder.text.ptr = "";
+  placeholder.start = placeholder.text.ptr;
+  x_array_push(unit->tokens, &placeholder);
+  return true;
+}
+
+void doxter_source_unit_term(DoxterSourceUnit* unit)
+{
+  if (unit->tokens)
+    x_array_destroy(unit->tokens);
+
+  if (unit->symbols)
+    x_array_destroy(unit->symbols);
+
+  unit->tokens = NULL;
+  unit->symbols = NULL;
+}
+
+static void s_span_rebase(DoxterTokenSpan* ts, u32 delta)
+{
+  if (ts->count > 0)
+    ts->first += delta;
+}
+
+static void s_index_rebase(u32* index, u32 delta)
+{
+  if (*index != 0)
+    *index += delta;
+}
+
+static void s_symbol_rebase(DoxterSymbol* sym, u32 delta)
+{
+  sym->first_token_index += delta;
+
+  switch (sym->type)
+  {
+    case DOXTER_FUNCTION:
+      s_index_rebase(&sym->stmt.fn.name_tok, delta);
+      s_span_rebase(&sym->stmt.fn.return_ts, delta);
+      s_span_rebase(&sym->stmt.fn.params_ts, delta);
+      for (u32 i = 0; i < sym->stmt.fn.param_count; i++)
+        s_span_rebase(&sym->stmt.fn.param_ts[i], delta);
+      break;
+
+    case DOXTER_MACRO:
+      s_index_rebase(&sym->stmt.macro.name_tok, delta);
+      s_span_rebase(&sym->stmt.macro.args_ts, delta);
+      s_span_rebase(&sym->stmt.macro.value_ts, delta);
+      break;
+
+    case DOXTER_STRUCT:
+    case DOXTER_UNION:
+    case DOXTER_ENUM:
+      s_index_rebase(&sym->stmt.record.name_tok, delta);
+      s_span_rebase(&sym->stmt.record.body_ts, delta);
+      break;
+
+    case DOXTER_TYPEDEF:
+      s_index_rebase(&sym->stmt.tdef.name_tok, delta);
+      s_span_rebase(&sym->stmt.tdef.value_ts, delta);
+      break;
+
+    default:
+      break;
+  }
+}
+
+X_HASHTABLE_TYPE_CSTR_KEY_NAMED(u32, dox_name_set)
+
+void doxter_project_merge(DoxterProject* proj, DoxterSourceUnit* units)
+{
+  // Names seen in earlier files. A declaration is only documented where it
+  // first appears; macros and file comments are always kept.
+  XHashtable_dox_name_set* seen = x_hashtable_dox_name_set_create();
+
+  for (u32 source_i = 0; source_i < proj->source_count; source_i++)
+  {
+    DoxterSourceInfo* source_info = &proj->sources[source_i];
+    DoxterSourceUnit* unit = &units[source_i];
+    u32 token_count = unit->tokens ? x_array_count(unit->tokens) : 0;
+    u32 symbol_count = unit->symbols ? x_array_count(unit->symbols) : 0;
+    u32 first_symbol = x_array_count(proj->symbols);
+
+    // Unit token 0 is the placeholder, so unit index i lands at base + i - 1
+    u32 delta = x_array_count(proj->tokens) - 1;
+
+    for (u32 i = 1; i < token_count; i++)
+      x_array_push(proj->tokens, x_array_get(unit->tokens, i));
+
+    for (u32 i = 0; i < symbol_count; i++)
+    {
+      DoxterSymbol sym = *(DoxterSymbol*)x_array_get(unit->symbols, i);
+      bool unique = sym.type == DOXTER_MACRO || sym.type == DOXTER_FILE;
+
+      if (!unique && x_hashtable_dox_name_set_has(seen, sym.name.ptr))
+        continue;
+
+      s_symbol_rebase(&sym, delta);
+      x_array_push(proj->symbols, &sym);
+    }
+
+    // Later files only check against names of files merged before them
+    for (u32 i = first_symbol; i < x_array_count(proj->symbols); i++)
+    {
+      DoxterSymbol* sym = x_array_get(proj->symbols, i);
+      x_hashtable_dox_name_set_set(seen, sym->name.ptr, 0);
+    }
+
+    source_info->first_symbol_index = first_symbol;
+    source_info->num_symbols = x_array_count(proj->symbols) - first_symbol;
+  }
+
+  x_hashtable_dox_name_set_destroy(seen);
+}
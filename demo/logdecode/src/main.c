@@ -0,0 +1,45 @@
+#define X_IMPL_LOG
+#include <stdx_log.h>
+
+#define log_info(msg, ...)     x_log_raw(NULL, stdout, XLOG_LEVEL_INFO, XLOG_COLOR_WHITE, XLOG_COLOR_BLACK, 0, msg, __VA_ARGS__, 0)
+#define log_error(msg, ...)    x_log_raw(NULL, stderr, XLOG_LEVEL_INFO, XLOG_COLOR_RED, XLOG_COLOR_BLACK, 0, msg, __VA_ARGS__, 0)
+
+int main(int argc, char** argv)
+{
+  if (argc != 2 && argc != 3)
+  {
+    log_info("usage:\n logdecode <binary log> [output]\n", 0);
+    return 1;
+  }
+
+  const char* in_file = argv[1];
+  const char* out_file = argc == 3 ? argv[2] : NULL;
+
+  FILE* in = fopen(in_file, "rb");
+  if (!in)
+  {
+    log_error("Failed to read from file '%s'\n", in_file);
+    return 1;
+  }
+
+  FILE* out = out_file ? fopen(out_file, "w") : stdout;
+  if (!out)
+  {
+    log_error("Failed to write to file '%s'\n", out_file);
+    fclose(in);
+    return 1;
+  }
+
+  // Whatever decoded before a damaged entry is still written out
+  bool ok = x_log_decode(in, out);
+  fclose(in);
+  if (out != stdout)
+    fclose(out);
+
+  if (!ok)
+  {
+    log_error("'%s' is not a binary log or is damaged\n", in_file);
+    return 1;
+  }
+  return 0;
+}
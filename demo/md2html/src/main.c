@@ -1,9 +1,9 @@
 #include <stdx_common.h>
+#define X_IMPL_STRING
 #define X_IMPL_IO
 #include <stdx_io.h>
 #define X_IMPL_LOG
 #include <stdx_log.h>
-#define X_IMPL_STRING
 #define X_IMPL_STRBUILDER
 #define MD_IMPL
 #include "markdown.h"
@@ -11,6 +11,11 @@
 #define log_info(msg, ...)     x_log_raw(NULL, stdout, XLOG_LEVEL_INFO, XLOG_COLOR_WHITE, XLOG_COLOR_BLACK, 0, msg, __VA_ARGS__, 0)
 #define log_error(msg, ...)    x_log_raw(NULL, stderr, XLOG_LEVEL_INFO, XLOG_COLOR_RED, XLOG_COLOR_BLACK, 0, msg, __VA_ARGS__, 0)
 
+static bool s_write_sink(void* user, const char* data, size_t len)
+{
+  return x_writer_write((XWriter*) user, data, len);
+}
+
 int main(int argc, char** argv)
 {
   if (argc != 3)
@@ -22,21 +27,27 @@ int main(int argc, char** argv)
   const char* in_file = argv[1];
   const char* out_file = argv[2];
 
-  size_t buf_size;
-  const char* buf = x_io_read_text(in_file, &buf_size);
-  if (!buf)
+  // md_render() reads the mapping in place and streams the html out, so memory
+  // stays bounded whatever the size of the document
+  XFileMapping mapping;
+  if (!x_io_map(in_file, X_IO_MAP_SEQUENTIAL, &mapping))
   {
     log_error("Failed to read from file '%s'\n", in_file);
     return 1;
   }
 
-  char* html = md_to_html(buf, buf_size);
-  if (! x_io_write_text(out_file, html))
+  XFile* file = x_io_open(out_file, "wb");
+  XWriter* writer = file ? x_writer_create(file, 0) : NULL;
+  bool ok = writer != NULL;
+  if (ok) ok = md_render(mapping.data ? (const char*) mapping.data : "", mapping.size, s_write_sink, writer);
+  if (writer && !x_writer_destroy(writer)) ok = false;
+  if (file) x_io_close(file);
+  x_io_unmap(&mapping);
+  if (!ok)
   {
     log_error("Failed to write to file '%s'\n", out_file);
     return 1;
   }
 
-  md_free(html);
   return 0;
 }
@@ -28,13 +28,11 @@
    human visually parses Markdown—recognizing code fences before thinking
    about paragraphs, for example.
 
-   • Phase 0 — Normalize newlines
-   Convert CRLF and CR into '\n'.  No further processing assumes Windows line endings.
-
    • Phase 1 — Fence and code extraction
    Splits the document into TEXT and CODE chunks based on ``` or ~~~ fences.
-   These are emitted verbatim later as <pre><code> blocks and skipped during
+   These are emitted verbatim as <pre><code> blocks and skipped during
    inline/structural parsing, isolating code content from further rewriting.
+   Lines end at LF, CRLF or CR; line endings inside code are written as '\n'.
 
    • Phase 2 — TEXT block rendering
    Each TEXT chunk is processed line by line.
@@ -47,8 +45,13 @@
    - Inline syntax: escapes, code spans, links, images, emphasis, deletion, insertion
 
    • Phase 3 — Merge and emit
-   Concatenates rendered TEXT and CODE chunks into final HTML.
-   Adjacent fenced code blocks with the same type are coalesced for compactness.
+   Chunks are rendered as they are found, in a single pass over the input,
+   and written straight to the output. Adjacent fenced code blocks are
+   coalesced for compactness.
+
+   Output goes to an MDSink callback through a fixed MD_SINK_BUFFER_SIZE
+   buffer, or directly into an XStrBuilder. Nothing else is allocated, so
+   memory does not grow with the document.
 
    Implementation Notes
    --------------------
@@ -86,6 +89,41 @@ Final considerations
 #include <stdx_strbuilder.h>
 #include <stdbool.h>
 
+/**
+ * Size of the buffer md_render() collects output in before calling the sink.
+ * Can be overriden before including this header.
+ */
+#ifndef MD_SINK_BUFFER_SIZE
+#define MD_SINK_BUFFER_SIZE (16 * 1024)
+#endif
+
+/**
+ * @brief Receives rendered HTML from md_render().
+ * @param user The pointer passed to md_render()
+ * @param data Next piece of output; not null-terminated
+ * @param len Number of bytes in `data`
+ * @return false to stop rendering
+ */
+typedef bool (*MDSink)(void *user, const char *data, size_t len);
+
+/**
+ * @brief Renders markdown to html through a sink, in a single pass.
+ * @param markdown A buffer with markdown to be converted to html
+ * @param len Length of `markdown` in bytes
+ * @param sink Callback that receives the output in order
+ * @param user Passed to `sink`
+ * @return false if the sink failed
+ */
+bool md_render(const char *markdown, size_t len, MDSink sink, void *user);
+
+/**
+ * @brief Renders markdown to html, appending to a string builder.
+ * @param markdown A buffer with markdown to be converted to html
+ * @param len Length of `markdown` in bytes
+ * @param out Builder the html is appended to
+ */
+void md_render_to_strbuilder(const char *markdown, size_t len, XStrBuilder *out);
+
 /**
  * @brief Converts a markdown to html.
  * @param markdown A buffer with markdown to be converted to html
@@ -122,81 +160,77 @@ void md_free(char *p);
 
 typedef struct Str
 {
-  XStrBuilder* sb;
+  XStrBuilder* sb;                // Direct target, or NULL when writing through `sink`
+  MDSink sink;
+  void *user;
+  bool failed;                    // The sink returned false; later output is dropped
+  size_t len;
+  char buf[MD_SINK_BUFFER_SIZE];
 } Str;
 
-static void str_init(Str *s)
+static void str_flush(Str *s)
 {
-  s->sb = x_strbuilder_create();
+  if (s->len == 0) return;
+  if (!s->failed && !s->sink(s->user, s->buf, s->len)) s->failed = true;
+  s->len = 0;
 }
 
-static void str_free(Str *s)
+static void str_putn(Str *s, const char *p, size_t n)
 {
+  if (!p || n == 0) return;
   if (s->sb)
   {
-    x_strbuilder_destroy(s->sb);
-    s->sb = NULL;
+    x_strbuilder_append_substring(s->sb, p, n);
+    return;
+  }
+  if (s->len + n > sizeof(s->buf))
+  {
+    str_flush(s);
+    if (n > sizeof(s->buf))
+    {
+      if (!s->failed && !s->sink(s->user, p, n)) s->failed = true;
+      return;
+    }
   }
+  memcpy(s->buf + s->len, p, n);
+  s->len += n;
 }
 
 static void str_putc(Str *s, char c)
 {
-  if (!s->sb) return;
-  x_strbuilder_append_char(s->sb, c);
-}
-
-static void str_putn(Str *s, const char *p, size_t n)
-{
-  if (!s->sb || !p || n == 0) return;
-  x_strbuilder_append_substring(s->sb, p, n);
+  if (s->sb)
+  {
+    x_strbuilder_append_char(s->sb, c);
+    return;
+  }
+  if (s->len == sizeof(s->buf)) str_flush(s);
+  s->buf[s->len] = c;
+  s->len += 1;
 }
 
 static void str_puts(Str *s, const char *p)
 {
-  if (!s->sb || !p) return;
-  x_strbuilder_append(s->sb, p);
-}
-
-static void str_clear(Str *s)
-{
-  if (!s->sb) return;
-  x_strbuilder_clear(s->sb);
-}
-
-static size_t str_length(const Str *s)
-{
-  if (!s || !s->sb) return 0;
-  return x_strbuilder_length((XStrBuilder*)s->sb);
-}
-
-static char* str_data(const Str *s)
-{
-  if (!s || !s->sb) return NULL;
-  return x_strbuilder_to_string((const XStrBuilder*)s->sb);
-}
-
-static void str_append_str(Str *dst, const Str *src)
-{
-  if (!dst || !dst->sb || !src || !src->sb) return;
-  char *data = x_strbuilder_to_string((const XStrBuilder*)src->sb);
-  size_t len = x_strbuilder_length((XStrBuilder*)src->sb);
-  if (len > 0 && data)
-  {
-    x_strbuilder_append_substring(dst->sb, data, len);
-  }
+  if (!p) return;
+  str_putn(s, p, strlen(p));
 }
 
 static void html_escape(Str *s, const char *p, size_t n)
 {
+  size_t run = 0;
   size_t i = 0;
   for (i = 0; i < n; ++i)
   {
+    const char *entity;
     char c = p[i];
-    if (c == '&') str_puts(s, "&amp;");
-    else if (c == '<') str_puts(s, "&lt;");
-    else if (c == '>') str_puts(s, "&gt;");
-    else str_putc(s, c);
+    if (c == '&') entity = "&amp;";
+    else if (c == '<') entity = "&lt;";
+    else if (c == '>') entity = "&gt;";
+    else continue;
+    str_putn(s, p + run, i - run);
+    str_puts(s, entity);
+    run = i + 1;
   }
+  str_putn(s, p + run, n - run);
 }
 
 static void attr_escape(Str *s, const char *p, size_t n)
@@ -218,32 +252,21 @@ static void attr_escape(Str *s, const char *p, size_t n)
   }
 }
 
-typedef struct Src
-{
-  const char *p;
-  const char *end;
-  size_t line;
-} Src;
-
-static void src_init(Src *s, const char *text)
-{
-  s->p = text;
-  s->end = text + strlen(text);
-  s->line = 1;
-}
-
-static bool src_eof(const Src *s)
-{
-  return s->p >= s->end;
-}
-
+// Lines end at '\n', "\r\n" or a lone '\r'
 static const char *src_line_end(const char *p, const char *end)
 {
   const char *q = p;
-  while (q < end && *q != '\n') q++;
+  while (q < end && *q != '\n' && *q != '\r') q++;
   return q;
 }
 
+static const char *src_line_next(const char *eol, const char *end)
+{
+  if (eol >= end) return end;
+  if (*eol == '\r' && eol + 1 < end && eol[1] == '\n') return eol + 2;
+  return eol + 1;
+}
+
 static bool starts_with(const char *p, const char *end, const char *lit)
 {
   size_t n = strlen(lit);
@@ -251,170 +274,15 @@ static bool starts_with(const char *p, const char *end, const char *lit)
   return memcmp(p, lit, n) == 0;
 }
 
-// Phase 0
-static char *md_normalize_newlines(const char *in, size_t n)
-{
-  char *out = (char*)MD_MALLOC(n + 1);
-  if (!out) return NULL;
-  size_t j = 0;
-  size_t i = 0;
-  for (i = 0; i < n; ++i)
-  {
-    char c = in[i];
-    if (c == '\r')
-    {
-      if (i + 1 < n && in[i + 1] == '\n')
-      {
-        // skip CR in CRLF
-      }
-      else
-      {
-        out[j] = '\n';
-        j += 1;
-      }
-    }
-    else
-    {
-      out[j] = c;
-      j += 1;
-    }
-  }
-  out[j] = '\0';
-  return out;
-}
-
-// Phase 1: split into text and code chunks
-typedef enum
-{
-  MD_CHUNK_TEXT,
-  MD_CHUNK_CODE
-} MDChunkKind;
-
-typedef struct
-{
-  MDChunkKind kind;
-  const char *begin;
-  const char *end;
-  const char *info_begin;
-  const char *info_end;
-} MDChunk;
-
-typedef struct
-{
-  MDChunk *v;
-  size_t n;
-  size_t cap;
-} MDChunks;
-
-static void chunks_push(MDChunks *cs, MDChunk c)
-{
-  if (cs->n == cs->cap)
-  {
-    size_t nc = cs->cap ? cs->cap * 2 : 16;
-    MDChunk *nv = (MDChunk*)MD_MALLOC(nc * sizeof(*nv));
-    if (!nv) MD_ABORT();
-    if (cs->v && cs->n > 0)
-    {
-      memcpy(nv, cs->v, cs->n * sizeof(*nv));
-      MD_FREE(cs->v);
-    }
-    cs->v = nv;
-    cs->cap = nc;
-  }
-  cs->v[cs->n] = c;
-  cs->n += 1;
-}
-
-static void md_split_fences(const char *buf, MDChunks *out)
+// Escapes a multi-line span, writing every line ending as '\n'
+static void html_escape_lines(Str *s, const char *p, const char *end)
 {
-  Src s;
-  src_init(&s, buf);
-  const char *cursor = s.p;
-  while (!src_eof(&s))
-  {
-    const char *line = s.p;
-    const char *eol = src_line_end(s.p, s.end);
-    bool fence = false;
-    size_t fence_len = 0;
-
-    const char *p = line;
-    while (p < eol && (*p == ' ' || *p == '\t')) p++;
-    const char *f = p;
-    while (f < eol && (*f == '`' || *f == '~')) f++;
-    if (f > p && (size_t)(f - p) >= 3)
-    {
-      fence = true;
-      fence_len = (size_t)(f - p);
-    }
-
-    if (!fence)
-    {
-      s.p = (eol < s.end) ? eol + 1 : eol;
-      continue;
-    }
-
-    if (cursor < line)
-    {
-      MDChunk ctext;
-      ctext.kind = MD_CHUNK_TEXT;
-      ctext.begin = cursor;
-      ctext.end = line;
-      ctext.info_begin = NULL;
-      ctext.info_end = NULL;
-      chunks_push(out, ctext);
-    }
-
-    const char *info_begin = f;
-    while (info_begin < eol && (*info_begin == ' ' || *info_begin == '\t')) info_begin++;
-    const char *info_end = eol;
-    while (info_end > info_begin && (info_end[-1] == ' ' || info_end[-1] == '\t')) info_end--;
-
-    char tick = *p;
-    const char *body_begin = (eol < s.end) ? eol + 1 : eol;
-    const char *q = body_begin;
-    const char *body_end = q;
-
-    for (;;)
-    {
-      if (q >= s.end)
-      {
-        body_end = s.end;
-        break;
-      }
-      const char *qeol = src_line_end(q, s.end);
-      const char *r = q;
-      while (r < qeol && (*r == ' ' || *r == '\t')) r++;
-      const char *u = r;
-      while (u < qeol && *u == tick) u++;
-      if ((size_t)(u - r) >= fence_len)
-      {
-        body_end = q;
-        s.p = (qeol < s.end) ? qeol + 1 : qeol;
-        break;
-      }
-      q = (qeol < s.end) ? qeol + 1 : qeol;
-    }
-
-    MDChunk code;
-    code.kind = MD_CHUNK_CODE;
-    code.begin = body_begin;
-    code.end = body_end;
-    code.info_begin = info_begin;
-    code.info_end = info_end;
-    chunks_push(out, code);
-
-    cursor = s.p;
-  }
-
-  if (cursor < s.end)
+  while (p < end)
   {
-    MDChunk ctail;
-    ctail.kind = MD_CHUNK_TEXT;
-    ctail.begin = cursor;
-    ctail.end = s.end;
-    ctail.info_begin = NULL;
-    ctail.info_end = NULL;
-    chunks_push(out, ctail);
+    const char *eol = src_line_end(p, end);
+    html_escape(s, p, (size_t)(eol - p));
+    if (eol < end) str_putc(s, '\n');
+    p = src_line_next(eol, end);
   }
 }
 
@@ -1014,12 +882,11 @@ static void open_list(Str *out, ListStack *st, int *depth_ref, bool ordered)
   *depth_ref += 1;
 }
 
-static void render_indented_code(Str *out, const char **pp, const char *block_end)
+// Returns false, consuming nothing, when the first line is not code
+static bool render_indented_code(Str *out, const char **pp, const char *block_end)
 {
   const char *p = *pp;
   bool any = false;
-  Str body;
-  str_init(&body);
   while (p < block_end)
   {
     const char *eol = src_line_end(p, block_end);
@@ -1028,11 +895,12 @@ static void render_indented_code(Str *out, const char **pp, const char *block_en
     while (q < eol && *q == ' ' && spaces < 10) { spaces += 1; q += 1; }
     bool tab = (p < eol && *p == '\t');
     if (!(tab || spaces >= 4)) break;
+    if (!any) str_puts(out, "<pre><code>");
     any = true;
     if (tab) q = p + 1;
-    html_escape(&body, q, (size_t)(eol - q));
-    str_putc(&body, '\n');
-    p = (eol < block_end) ? eol + 1 : eol;
+    html_escape(out, q, (size_t)(eol - q));
+    str_putc(out, '\n');
+    p = src_line_next(eol, block_end);
     const char *ne = src_line_end(p, block_end);
     const char *rt = ne;
     while (rt > p && (rt[-1] == ' ' || rt[-1] == '\t')) rt--;
@@ -1040,12 +908,10 @@ static void render_indented_code(Str *out, const char **pp, const char *block_en
   }
   if (any)
   {
-    str_puts(out, "<pre><code>");
-    str_append_str(out, &body);
     str_puts(out, "</code></pre>\n");
     *pp = p;
   }
-  str_free(&body);
+  return any;
 }
 
 static void render_list_group(Str *out, const char **pp, const char *block_end)
@@ -1063,13 +929,9 @@ static void render_list_group(Str *out, const char **pp, const char *block_end)
 
   open_list(out, &st, &depth, ord);
   str_puts(out, "<li>");
-  Str tmp;
-  str_init(&tmp);
-  render_inline(&tmp, after, eol);
-  str_append_str(out, &tmp);
-  str_free(&tmp);
+  render_inline(out, after, eol);
 
-  const char *cur = (eol < block_end) ? eol + 1 : eol;
+  const char *cur = src_line_next(eol, block_end);
   while (cur < block_end)
   {
     const char *le = src_line_end(cur, block_end);
@@ -1077,7 +939,7 @@ static void render_list_group(Str *out, const char **pp, const char *block_end)
     while (rt > cur && (rt[-1] == ' ' || rt[-1] == '\t')) rt--;
     if (rt == cur)
     {
-      cur = (le < block_end) ? le + 1 : le;
+      cur = src_line_next(le, block_end);
       break;
     }
 
@@ -1113,13 +975,9 @@ static void render_list_group(Str *out, const char **pp, const char *block_end)
       str_puts(out, "<li>");
     }
 
-    Str t2;
-    str_init(&t2);
-    render_inline(&t2, after2, le);
-    str_append_str(out, &t2);
-    str_free(&t2);
+    render_inline(out, after2, le);
 
-    cur = (le < block_end) ? le + 1 : le;
+    cur = src_line_next(le, block_end);
   }
 
   close_lists_to(out, &st, &depth, 0);
@@ -1134,6 +992,13 @@ static void render_list_group(Str *out, const char **pp, const char *block_end)
 }
 
 // Blockquotes and text block rendering
+static bool is_quote_line(const char *p, const char *eol)
+{
+  const char *q = p;
+  while (q < eol && *q == '>') q++;
+  return q > p && (q == eol || *q == ' ');
+}
+
 static void render_blockquote_group(Str *out, const char **pp, const char *block_end)
 {
   const char *p = *pp;
@@ -1162,13 +1027,9 @@ static void render_blockquote_group(Str *out, const char **pp, const char *block
       while (open_depth < depth) { str_puts(out, "<blockquote>"); open_depth += 1; }
     }
 
-    Str tmp;
-    str_init(&tmp);
-    render_inline(&tmp, q, eol);
-    str_append_str(out, &tmp);
-    str_free(&tmp);
+    render_inline(out, q, eol);
 
-    const char *next = (eol < block_end) ? eol + 1 : eol;
+    const char *next = src_line_next(eol, block_end);
     if (next < block_end)
     {
       const char *neol = src_line_end(next, block_end);
@@ -1193,14 +1054,20 @@ static void render_blockquote_group(Str *out, const char **pp, const char *block
   *pp = p;
 }
 
+// Paragraphs are written as they are read: "<p>" goes out with the first line
+static void para_close(Str *out, bool *in_para)
+{
+  if (!*in_para) return;
+  str_puts(out, "</p>\n");
+  *in_para = false;
+}
+
 static void render_text_block(Str *out, const char *begin, const char *end)
 {
   const char *p = begin;
-  Str para;
-  str_init(&para);
   bool in_para = false;
 
-  while (p < end)
+  while (p < end && !out->failed)
   {
     const char *eol = src_line_end(p, end);
     const char *rt = eol;
@@ -1210,32 +1077,19 @@ static void render_text_block(Str *out, const char *begin, const char *end)
 
     if (!is_blank && is_html_block_line(p, eol))
     {
-      if (in_para)
-      {
-        str_puts(out, "<p>");
-        str_append_str(out, &para);
-        str_puts(out, "</p>\n");
-        str_clear(&para);
-        in_para = false;
-      }
+      para_close(out, &in_para);
 
       str_putn(out, p, (size_t)(eol - p));
       str_putc(out, '\n');
 
-      p = (eol < end) ? eol + 1 : eol;
+      p = src_line_next(eol, end);
       continue;
     }
 
-    if (!is_blank && *p == '>')
+    // A '>' line that is not a quote, like ">x", is paragraph text
+    if (!is_blank && is_quote_line(p, eol))
     {
-      if (in_para)
-      {
-        str_puts(out, "<p>");
-        str_append_str(out, &para);
-        str_puts(out, "</p>\n");
-        str_clear(&para);
-        in_para = false;
-      }
+      para_close(out, &in_para);
       render_blockquote_group(out, &p, end);
       while (p < end)
       {
@@ -1258,16 +1112,8 @@ static void render_text_block(Str *out, const char *begin, const char *end)
       while (q3 < rt && *q3 == ' ') q3++;
       if (!(q3 < rt && (*q3 == '-' || *q3 == '+' || *q3 == '*' || isdigit((unsigned char)*q3))))
       {
-        if (in_para)
-        {
-          str_puts(out, "<p>");
-          str_append_str(out, &para);
-          str_puts(out, "</p>\n");
-          str_clear(&para);
-          in_para = false;
-        }
-        render_indented_code(out, &p, end);
-        continue;
+        para_close(out, &in_para);
+        if (render_indented_code(out, &p, end)) continue;
       }
     }
 
@@ -1278,14 +1124,7 @@ static void render_text_block(Str *out, const char *begin, const char *end)
       if (!is_blank && parse_bullet(p, rt, &dummy_ord, &am)) is_list = true;
       if (is_list)
       {
-        if (in_para)
-        {
-          str_puts(out, "<p>");
-          str_append_str(out, &para);
-          str_puts(out, "</p>\n");
-          str_clear(&para);
-          in_para = false;
-        }
+        para_close(out, &in_para);
         render_list_group(out, &p, end);
         continue;
       }
@@ -1306,16 +1145,9 @@ static void render_text_block(Str *out, const char *begin, const char *end)
     }
     if (is_hr)
     {
-      if (in_para)
-      {
-        str_puts(out, "<p>");
-        str_append_str(out, &para);
-        str_puts(out, "</p>\n");
-        str_clear(&para);
-        in_para = false;
-      }
+      para_close(out, &in_para);
       str_puts(out, "<hr/>\n");
-      p = (eol < end) ? eol + 1 : eol;
+      p = src_line_next(eol, end);
       continue;
     }
 
@@ -1326,153 +1158,160 @@ static void render_text_block(Str *out, const char *begin, const char *end)
     if (header_hashes >= 1 && header_hashes <= 5 && (qh < eol && *qh == ' ')) is_header = true;
     if (is_header)
     {
-      if (in_para)
-      {
-        str_puts(out, "<p>");
-        str_append_str(out, &para);
-        str_puts(out, "</p>\n");
-        str_clear(&para);
-        in_para = false;
-      }
-      Str h;
-      str_init(&h);
-      render_header_line(&h, p, rt);
-      str_append_str(out, &h);
-      str_free(&h);
-      p = (eol < end) ? eol + 1 : eol;
+      para_close(out, &in_para);
+      render_header_line(out, p, rt);
+      p = src_line_next(eol, end);
       continue;
     }
 
     if (is_blank)
     {
-      if (in_para)
-      {
-        str_puts(out, "<p>");
-        str_append_str(out, &para);
-        str_puts(out, "</p>\n");
-        str_clear(&para);
-        in_para = false;
-      }
-      p = (eol < end) ? eol + 1 : eol;
+      para_close(out, &in_para);
+      p = src_line_next(eol, end);
       continue;
     }
 
-    if (!in_para) in_para = true;
-    else str_putc(&para, '\n');
+    if (!in_para)
+    {
+      str_puts(out, "<p>");
+      in_para = true;
+    }
+    else str_putc(out, '\n');
 
-    Str tmp2;
-    str_init(&tmp2);
-    render_inline(&tmp2, p, rt);
-    str_append_str(&para, &tmp2);
-    str_free(&tmp2);
+    render_inline(out, p, rt);
 
     size_t trail_spaces = (size_t)(eol - rt);
     if (trail_spaces >= 1)
     {
-      str_puts(&para, "<br/>");
+      str_puts(out, "<br/>");
     }
 
-    p = (eol < end) ? eol + 1 : eol;
-  }
-
-  if (in_para)
-  {
-    str_puts(out, "<p>");
-    str_append_str(out, &para);
-    str_puts(out, "</p>\n");
+    p = src_line_next(eol, end);
   }
-  str_free(&para);
-}
 
-// Code chunk
-static void render_code_chunk(Str *out, const MDChunk *c)
-{
-  str_puts(out, "<pre><code");
-  if (c->info_begin && c->info_end && c->info_begin < c->info_end)
-  {
-    str_puts(out, " title=\"");
-    attr_escape(out, c->info_begin, (size_t)(c->info_end - c->info_begin));
-    str_puts(out, "\"");
-  }
-  str_puts(out, ">");
-  html_escape(out, c->begin, (size_t)(c->end - c->begin));
-  str_puts(out, "</code></pre>\n");
+  para_close(out, &in_para);
 }
 
-// Public API
-char* md_to_html(const char *markdown, size_t len)
+// Fenced code and document
+static void render_document(Str *out, const char *p, const char *end)
 {
-  if (!markdown) return NULL;
-
-  char *norm = md_normalize_newlines(markdown, len);
-  if (!norm) return NULL;
-
-  MDChunks cs;
-  cs.v = NULL;
-  cs.n = 0;
-  cs.cap = 0;
-  md_split_fences(norm, &cs);
+  const char *text = p;
+  bool code_open = false;
 
-  Str out;
-  str_init(&out);
-
-  size_t i = 0;
-  while (i < cs.n)
+  while (p < end && !out->failed)
   {
-    MDChunk *c = &cs.v[i];
-    if (c->kind == MD_CHUNK_CODE)
+    const char *line = p;
+    const char *eol = src_line_end(p, end);
+    const char *m = skip_ws(line, eol);
+    const char *f = m;
+    while (f < eol && (*f == '`' || *f == '~')) f++;
+    if ((size_t)(f - m) < 3)
     {
-      size_t j = i;
-      const char *info0 = c->info_begin;
-      const char *info1 = c->info_end;
+      p = src_line_next(eol, end);
+      continue;
+    }
 
-      str_puts(&out, "<pre><code");
-      if (info0 && info1 && info0 < info1)
-      {
-        str_puts(&out, " title=\"");
-        attr_escape(&out, info0, (size_t)(info1 - info0));
-        str_puts(&out, "\"");
-      }
-      str_puts(&out, ">");
+    if (text < line)
+    {
+      if (code_open) str_puts(out, "</code></pre>\n");
+      code_open = false;
+      render_text_block(out, text, line);
+    }
+
+    // Fences with nothing in between share one <pre>, titled by the first
+    if (!code_open)
+    {
+      const char *info_begin = skip_ws(f, eol);
+      const char *info_end = eol;
+      while (info_end > info_begin && (info_end[-1] == ' ' || info_end[-1] == '\t')) info_end--;
 
-      bool first = true;
-      while (j < cs.n && cs.v[j].kind == MD_CHUNK_CODE)
+      str_puts(out, "<pre><code");
+      if (info_begin < info_end)
       {
-        if (!first) str_putc(&out, '\n');
-        html_escape(&out, cs.v[j].begin, (size_t)(cs.v[j].end - cs.v[j].begin));
-        first = false;
-        j += 1;
+        str_puts(out, " title=\"");
+        attr_escape(out, info_begin, (size_t)(info_end - info_begin));
+        str_puts(out, "\"");
       }
-
-      str_puts(&out, "</code></pre>\n");
-      i = j;
-      continue;
+      str_puts(out, ">");
+      code_open = true;
     }
-    else
+    else str_putc(out, '\n');
+
+    // The body runs to a closing fence at least as long, or to the end
+    char tick = *m;
+    size_t fence_len = (size_t)(f - m);
+    const char *body = src_line_next(eol, end);
+    const char *q = body;
+    p = end;
+    while (q < end)
     {
-      render_text_block(&out, c->begin, c->end);
-      i += 1;
+      const char *qeol = src_line_end(q, end);
+      const char *r = skip_ws(q, qeol);
+      const char *u = r;
+      while (u < qeol && *u == tick) u++;
+      if ((size_t)(u - r) >= fence_len)
+      {
+        p = src_line_next(qeol, end);
+        break;
+      }
+      q = src_line_next(qeol, end);
     }
-  }
-
-  MD_FREE(cs.v);
-  MD_FREE(norm);
 
-  char* built = str_data(&out);
-  if (!built)
-  {
-    str_free(&out);
-    return NULL;
+    html_escape_lines(out, body, q);
+    text = p;
   }
-  size_t out_len = str_length(&out);
-  char* result = (char*)MD_MALLOC(out_len + 1);
-  if (!result)
+
+  if (text < end)
   {
-    str_free(&out);
-    return NULL;
+    if (code_open) str_puts(out, "</code></pre>\n");
+    code_open = false;
+    render_text_block(out, text, end);
   }
-  memcpy(result, built, out_len + 1);
-  str_free(&out);
+  if (code_open) str_puts(out, "</code></pre>\n");
+}
+
+// Public API
+bool md_render(const char *markdown, size_t len, MDSink sink, void *user)
+{
+  Str out;
+  if (!markdown || !sink) return false;
+
+  out.sb = NULL;
+  out.sink = sink;
+  out.user = user;
+  out.failed = false;
+  out.len = 0;
+  render_document(&out, markdown, markdown + len);
+  str_flush(&out);
+  return !out.failed;
+}
+
+void md_render_to_strbuilder(const char *markdown, size_t len, XStrBuilder *sb)
+{
+  Str out;
+  if (!markdown || !sb) return;
+
+  out.sb = sb;
+  out.sink = NULL;
+  out.user = NULL;
+  out.failed = false;
+  out.len = 0;
+  render_document(&out, markdown, markdown + len);
+}
+
+char* md_to_html(const char *markdown, size_t len)
+{
+  if (!markdown) return NULL;
+
+  XStrBuilder *sb = x_strbuilder_create();
+  if (!sb) return NULL;
+  md_render_to_strbuilder(markdown, len, sb);
+
+  char* built = x_strbuilder_to_string(sb);
+  size_t out_len = x_strbuilder_length(sb);
+  char* result = built ? (char*)MD_MALLOC(out_len + 1) : NULL;
+  if (result) memcpy(result, built, out_len + 1);
+  x_strbuilder_destroy(sb);
   return result;
 }
 
@@ -1,14 +1,17 @@
 #include <stdx_common.h>
 
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+
 #define X_IMPL_ARENA
 #include <stdx_arena.h>
 
-#define X_IMPL_IO
-#include <stdx_io.h>
-
 #define X_IMPL_STRING
 #include <stdx_string.h>
 
+#define X_IMPL_IO
+#include <stdx_io.h>
+
 #define X_IMPL_STRBUILDER
 #include <stdx_strbuilder.h>
 
@@ -25,10 +28,11 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 static void print_usage(const char *exe)
 {
-  fprintf(stderr, "usage: %s <file.mi>\n", exe);
+  fprintf(stderr, "usage: %s [--tree-walk] <file.mi>\n", exe);
 }
 
 int main(int argc, char** argv)
@@ -42,14 +46,18 @@ int main(int argc, char** argv)
   size_t text_size;
   char *text;
   bool ok;
+  bool tree_walk;
+
+  // --tree-walk runs the AST directly instead of the compiled program
+  tree_walk = argc == 3 && strcmp(argv[1], "--tree-walk") == 0;
 
-  if (argc != 2)
+  if (argc != 2 && !tree_walk)
   {
     print_usage(argv[0]);
     return 1;
   }
 
-  filename = argv[1];
+  filename = argv[argc - 1];
 
   text_size = 0;
   text = x_io_read_text(filename, &text_size);
@@ -108,6 +116,16 @@ int main(int argc, char** argv)
     return 1;
   }
 
+  ctx.tree_walk = tree_walk;
+
+  if (!tree_walk && !mi_compile(&ctx, arena, parse_result.root))
+  {
+    fprintf(stderr, "error: failed to compile %s\n", filename);
+    x_arena_destroy(arena);
+    free(text);
+    return 1;
+  }
+
   exec_result = mi_exec_block(&ctx, parse_result.root, false);
 
   if (exec_result.signal == MI_SIGNAL_ERROR)
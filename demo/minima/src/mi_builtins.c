@@ -5,6 +5,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #include "minima.h"
@@ -156,21 +157,6 @@ static bool mi_value_is_truthy(MiValue value)
   return true;
 }
 
-static bool mi_node_is_raw_op(MiNode *node, const char *op)
-{
-  if (!node)
-  {
-    return false;
-  }
-
-  if (node->kind != MI_NODE_RAW)
-  {
-    return false;
-  }
-
-  return x_slice_cmp(node->text, x_slice_from_cstr(op)) == 0;
-}
-
 static MiNode *mi_expr_peek(MiExprParser *p)
 {
   if (p->index >= p->argc)
@@ -223,6 +209,7 @@ static bool mi_expr_match(MiExprParser *p, const char *op)
 static bool mi_expr_value_to_double(MiExprParser *p, MiValue value, double *out_value)
 {
   XSlice slice;
+  char buffer[64];
   char *text;
   char *end;
   double v;
@@ -257,7 +244,18 @@ static bool mi_expr_value_to_double(MiExprParser *p, MiValue value, double *out_
       return false;
   }
 
-  text = x_arena_slicedup(p->ctx->arena, slice.ptr, slice.length, true);
+  // strtod needs a terminated string; numeric literals fit on the stack, so
+  // loop counters do not grow the arena on every iteration
+  if (slice.length < sizeof(buffer))
+  {
+    memcpy(buffer, slice.ptr, slice.length);
+    buffer[slice.length] = '\0';
+    text = buffer;
+  }
+  else
+  {
+    text = x_arena_slicedup(p->ctx->arena, slice.ptr, slice.length, true);
+  }
 
   if (!text)
   {
@@ -698,8 +696,10 @@ static MiExecResult mi_cmd_expr(MiContext *ctx, i32 argc, MiNode **argv)
 MiExecResult mi_cmd_set(MiContext *ctx, i32 argc, MiNode **argv)
 {
   MiValue value;
+  MiValue *slot;
   MiExecResult r;
   MiNode *name_node;
+  uint32_t hash;
 
   if (argc != 2) {
     mi_context_set_error(ctx, "set expects 2 arguments", 0, 0);
@@ -722,13 +722,22 @@ MiExecResult mi_cmd_set(MiContext *ctx, i32 argc, MiNode **argv)
   }
 
   value = r.value;
+  hash = name_node->hash ? name_node->hash : mi_name_hash(name_node->text);
+  slot = mi_scope_find(ctx->current_scope, name_node->text, hash);
+
+  if (!slot)
+  {
+    slot = mi_scope_slot(ctx->current_scope, name_node->text, hash);
+  }
 
-  if (!mi_scope_set(ctx->current_scope, name_node->text, value))
+  if (!slot)
   {
     mi_context_set_error(ctx, "failed to set variable", name_node->line, name_node->column);
     return mi_exec_error();
   }
 
+  *slot = value;
+
   return mi_exec_ok(value);
 }
 
@@ -807,7 +816,7 @@ static XSlice mi_unescape_to_arena(XArena *arena, XSlice src)
 
 MiExecResult mi_cmd_format(MiContext *ctx, int argc, MiNode **argv)
 {
-  static XArena *format_arena = NULL;
+  XArena *format_arena;
   MiExecResult fmt_res;
   XSlice fmt_src;
   XSlice fmt;
@@ -825,11 +834,14 @@ MiExecResult mi_cmd_format(MiContext *ctx, int argc, MiNode **argv)
     return mi_exec_error();
   }
 
-  if (!format_arena)
+  // Per context, so contexts on different threads don't share scratch
+  if (!ctx->format_arena)
   {
-    format_arena = x_arena_create(2048);
+    ctx->format_arena = x_arena_create(2048);
   }
 
+  format_arena = ctx->format_arena;
+
   if (!format_arena)
   {
     mi_context_set_error(ctx, "format failed to create scratch arena", 0, 0);
@@ -1119,18 +1131,19 @@ static void mi_write_value(FILE *out, XArena *arena, MiValue value)
 
 MiExecResult mi_cmd_print(MiContext *ctx, i32 argc, MiNode **argv)
 {
-  static XArena *print_arena = NULL;
+  XArena *print_arena;
 
   if (!ctx)
   {
     return mi_exec_error();
   }
 
-  if (!print_arena)
+  if (!ctx->print_arena)
   {
-    print_arena = x_arena_create(1024);
+    ctx->print_arena = x_arena_create(1024);
   }
 
+  print_arena = ctx->print_arena;
   x_arena_reset(print_arena);
 
   for (i32 i = 0; i < argc; i++)
@@ -1425,9 +1438,9 @@ MiList *mi_list_create(size_t capacity)
 
   list->magic = MI_LIST_MAGIC;
   list->destroyed = false;
-  list->items = x_array_MiValue_create(capacity);
+  list->items = x_array_MiValue_init_inline(&list->item_storage);
 
-  if (!list->items)
+  if (x_array_MiValue_reserve(list->items, capacity) != XARRAY_OK)
   {
     free(list);
     return NULL;
@@ -1451,30 +1464,6 @@ MiValue mi_value_list(i32 capacity)
 
 static MiExecResult mi_list_cmd_create(MiContext *ctx, i32 argc, MiNode **argv);
 
-static bool x_slice_eq_cstr(XSlice slice, const char *cstr)
-{
-  size_t len;
-
-  if (!cstr)
-  {
-    return false;
-  }
-
-  len = strlen(cstr);
-
-  if (slice.length != len)
-  {
-    return false;
-  }
-
-  if (len == 0)
-  {
-    return true;
-  }
-
-  return memcmp(slice.ptr, cstr, len) == 0;
-}
-
 static bool mi_list_value_equals(MiValue a, MiValue b)
 {
   if (a.kind != b.kind)
@@ -1682,7 +1671,7 @@ MiExecResult mi_call_cmd_list_push_value(MiValue list_value, MiValue value)
   XArrayError err = x_array_MiValue_push(list->items, value);
   if (err != XARRAY_OK)
   {
-    x_array_MiValue_destroy(list->items);
+    x_array_MiValue_term(list->items);
     free(list);
     return mi_exec_error();
   }
@@ -1712,7 +1701,7 @@ MiExecResult mi_list_cmd_create(MiContext *ctx, i32 argc, MiNode **argv)
     {
       if (list->items)
       {
-        x_array_MiValue_destroy(list->items);
+        x_array_MiValue_term(list->items);
       }
 
       free(list);
@@ -1722,21 +1711,14 @@ MiExecResult mi_list_cmd_create(MiContext *ctx, i32 argc, MiNode **argv)
     err = x_array_MiValue_push(list->items, value);
     if (err != XARRAY_OK)
     {
-      x_array_MiValue_destroy(list->items);
+      x_array_MiValue_term(list->items);
       free(list);
       mi_context_set_error(ctx, "failed to push item into list", 0, 0);
       return mi_exec_error();
     }
   }
 
-  {
-    MiUser user;
-
-    user.type = &List_type;
-    user.data = list;
-
-    return mi_exec_ok(mi_value_user(&List_type, list));
-  }
+  return mi_exec_ok(mi_value_user(&List_type, list));
 }
 
 MiExecResult mi_list_cmd_len(MiContext *ctx, i32 argc, MiNode **argv)
@@ -2003,7 +1985,7 @@ MiExecResult mi_list_cmd_destroy(MiContext *ctx, i32 argc, MiNode **argv)
     return result;
   }
 
-  x_array_MiValue_destroy(list->items);
+  x_array_MiValue_term(list->items);
   list->items = NULL;
   list->destroyed = true;
 
@@ -2397,6 +2379,11 @@ MiExecResult mi_cmd_eval(MiContext *ctx, int argc, MiNode **argv)
   /*
    * Execute program block.
    */
+  if (!ctx->tree_walk)
+  {
+    mi_compile(ctx, arena, p_res.root);
+  }
+
   result = mi_exec_block(ctx, p_res.root, false);
   x_arena_destroy(arena);
 
@@ -2431,6 +2418,11 @@ MiExecResult mi_call_cmd_eval(MiContext *ctx, XSlice source)
     return mi_exec_error();
   }
 
+  if (!ctx->tree_walk)
+  {
+    mi_compile(ctx, arena, p_res.root);
+  }
+
   result = mi_exec_block(ctx, p_res.root, false);
   x_arena_destroy(arena);
   return result;
@@ -0,0 +1,219 @@
+#include "minima.h"
+
+#include <string.h>
+
+static bool s_compile_node(MiContext *ctx, XArena *arena, MiNode *node);
+
+static bool s_resolve(MiContext *ctx, MiInstr *instr)
+{
+  XSlice name;
+
+  name = instr->node->first_child->text;
+  instr->ctx = ctx;
+  instr->generation = ctx->generation;
+
+  if (mi_lookup_command(ctx, name, &instr->fn))
+  {
+    instr->op = MI_OP_COMMAND;
+    return true;
+  }
+
+  if (mi_lookup_func(ctx, name, &instr->func))
+  {
+    instr->op = MI_OP_FUNC;
+    return true;
+  }
+
+  instr->op = MI_OP_UNRESOLVED;
+  return false;
+}
+
+static bool s_compile_command(MiContext *ctx, XArena *arena, MiInstr *instr, MiNode *command)
+{
+  MiNode *name_node;
+  MiNode *arg_node;
+  i32 argc;
+  i32 i;
+
+  memset(instr, 0, sizeof(*instr));
+  instr->node = command;
+  instr->op = MI_OP_TREE;
+
+  name_node = command->kind == MI_NODE_COMMAND ? command->first_child : NULL;
+
+  if (!name_node || name_node->kind != MI_NODE_RAW)
+  {
+    return true;
+  }
+
+  argc = 0;
+
+  for (arg_node = name_node->next_sibling; arg_node; arg_node = arg_node->next_sibling)
+  {
+    argc += 1;
+  }
+
+  if (argc > MI_MAX_COMMAND_ARGS)
+  {
+    return true;
+  }
+
+  if (argc > 0)
+  {
+    instr->argv = (MiNode **)x_arena_alloc(arena, sizeof(MiNode *) * (size_t)argc);
+
+    if (!instr->argv)
+    {
+      return false;
+    }
+  }
+
+  i = 0;
+
+  for (arg_node = name_node->next_sibling; arg_node; arg_node = arg_node->next_sibling)
+  {
+    instr->argv[i] = arg_node;
+    i += 1;
+  }
+
+  instr->argc = argc;
+  s_resolve(ctx, instr);
+  command->instr = instr;
+
+  for (i = 0; i < argc; i++)
+  {
+    if (!s_compile_node(ctx, arena, instr->argv[i]))
+    {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static bool s_compile_block(MiContext *ctx, XArena *arena, MiNode *block)
+{
+  MiCode *code;
+  MiNode *command;
+  i32 count;
+  i32 i;
+
+  count = 0;
+
+  for (command = block->first_child; command; command = command->next_sibling)
+  {
+    count += 1;
+  }
+
+  code = (MiCode *)x_arena_alloc_zero(arena, sizeof(MiCode));
+
+  if (!code)
+  {
+    return false;
+  }
+
+  if (count > 0)
+  {
+    code->instrs = (MiInstr *)x_arena_alloc(arena, sizeof(MiInstr) * (size_t)count);
+
+    if (!code->instrs)
+    {
+      return false;
+    }
+  }
+
+  i = 0;
+
+  for (command = block->first_child; command; command = command->next_sibling)
+  {
+    if (!s_compile_command(ctx, arena, &code->instrs[i], command))
+    {
+      return false;
+    }
+
+    i += 1;
+  }
+
+  // Published last, so a failure above leaves the block to the tree walker
+  code->count = count;
+  block->code = code;
+  return true;
+}
+
+static bool s_compile_node(MiContext *ctx, XArena *arena, MiNode *node)
+{
+  MiInstr *instr;
+
+  if (!node)
+  {
+    return true;
+  }
+
+  switch (node->kind)
+  {
+    case MI_NODE_BLOCK:
+      return node->code ? true : s_compile_block(ctx, arena, node);
+
+    case MI_NODE_SUBCOMMAND:
+      return s_compile_node(ctx, arena, node->first_child);
+
+    case MI_NODE_COMMAND:
+      if (node->instr)
+      {
+        return true;
+      }
+
+      instr = (MiInstr *)x_arena_alloc(arena, sizeof(MiInstr));
+      return instr && s_compile_command(ctx, arena, instr, node);
+
+    case MI_NODE_VARIABLE:
+    case MI_NODE_RAW:
+      // Names are hashed once here instead of on every scope lookup
+      node->hash = mi_name_hash(node->text);
+      return true;
+
+    default:
+      return true;
+  }
+}
+
+bool mi_compile(MiContext *ctx, XArena *arena, MiNode *root)
+{
+  if (!ctx || !arena || !root)
+  {
+    return false;
+  }
+
+  return s_compile_node(ctx, arena, root);
+}
+
+MiExecResult mi_exec_instr(MiContext *ctx, MiInstr *instr)
+{
+  MiNode *name_node;
+
+  if (instr->ctx != ctx || instr->generation != ctx->generation)
+  {
+    if (instr->op != MI_OP_TREE)
+    {
+      s_resolve(ctx, instr);
+    }
+  }
+
+  switch (instr->op)
+  {
+    case MI_OP_COMMAND:
+      return instr->fn(ctx, instr->argc, instr->argv);
+
+    case MI_OP_FUNC:
+      return mi_call_func(ctx, &instr->func, instr->argc, instr->argv);
+
+    case MI_OP_UNRESOLVED:
+      name_node = instr->node->first_child;
+      mi_context_set_error(ctx, "unknown command", name_node->line, name_node->column);
+      return mi_exec_error();
+
+    case MI_OP_TREE:
+    default:
+      return mi_exec_command(ctx, instr->node);
+  }
+}
@@ -164,117 +164,363 @@ MiScope *mi_scope_create(XArena *arena, MiScope *parent)
     return NULL;
   }
 
+  // Slot storage is allocated on first use: most block scopes never define
+  // anything and only read or update outer variables
   scope->arena = arena;
   scope->parent = parent;
-  scope->vars = x_hashtable_mi_value_table_create();
+  return scope;
+}
+
+uint32_t mi_name_hash(XSlice name)
+{
+  uint32_t hash;
+  size_t i;
 
-  if (!scope->vars)
+  // FNV-1a; 0 is reserved for "not computed" in MiNode.hash
+  hash = 2166136261u;
+
+  for (i = 0; i < name.length; i++)
   {
-    return NULL;
+    hash ^= (uint8_t)name.ptr[i];
+    hash *= 16777619u;
   }
 
-  return scope;
+  return hash ? hash : 1u;
 }
 
-bool mi_scope_get(MiScope *scope, XSlice name, MiValue *out_value)
+static uint64_t s_scope_filter_bit(uint32_t hash)
 {
-  MiScope *it;
-  char *key;
-  bool found;
+  return (uint64_t)1 << (hash >> 26);
+}
 
-  if (!scope || !out_value)
+static bool s_scope_name_eq(const MiVar *var, XSlice name, uint32_t hash)
+{
+  return var->hash == hash
+    && var->name.length == name.length
+    && memcmp(var->name.ptr, name.ptr, name.length) == 0;
+}
+
+static bool s_scope_index_build(MiScope *scope, uint32_t buckets)
+{
+  uint32_t *index;
+  uint32_t i;
+
+  index = (uint32_t *)x_arena_alloc_zero(scope->arena, sizeof(uint32_t) * buckets);
+
+  if (!index)
   {
     return false;
   }
 
-  key = mi_keydup_heap(name);
+  scope->index = index;
+  scope->index_mask = buckets - 1;
 
-  if (!key)
+  for (i = 0; i < scope->count; i++)
   {
-    return false;
+    uint32_t b;
+
+    b = scope->vars[i].hash & scope->index_mask;
+
+    while (index[b])
+    {
+      b = (b + 1) & scope->index_mask;
+    }
+
+    index[b] = i + 1;
   }
 
-  found = false;
-  it = scope;
+  return true;
+}
+
+static MiVar *s_scope_find_local(MiScope *scope, XSlice name, uint32_t hash)
+{
+  uint32_t i;
 
-  while (it)
+  if (!(scope->filter & s_scope_filter_bit(hash)))
   {
-    if (x_hashtable_mi_value_table_get(it->vars, key, out_value))
+    return NULL;
+  }
+
+  if (scope->index)
+  {
+    uint32_t b;
+
+    b = hash & scope->index_mask;
+
+    while (scope->index[b])
     {
-      found = true;
-      break;
+      MiVar *var;
+
+      var = &scope->vars[scope->index[b] - 1];
+
+      if (s_scope_name_eq(var, name, hash))
+      {
+        return var;
+      }
+
+      b = (b + 1) & scope->index_mask;
     }
 
-    it = it->parent;
+    return NULL;
   }
 
-  free(key);
-  return found;
+  for (i = 0; i < scope->count; i++)
+  {
+    if (s_scope_name_eq(&scope->vars[i], name, hash))
+    {
+      return &scope->vars[i];
+    }
+  }
+
+  return NULL;
+}
+
+MiValue *mi_scope_find(MiScope *scope, XSlice name, uint32_t hash)
+{
+  MiVar *var;
+
+  while (scope)
+  {
+    var = s_scope_find_local(scope, name, hash);
+
+    if (var)
+    {
+      return &var->value;
+    }
+
+    scope = scope->parent;
+  }
+
+  return NULL;
+}
+
+MiValue *mi_scope_slot(MiScope *scope, XSlice name, uint32_t hash)
+{
+  MiVar *var;
+
+  if (!scope || !name.ptr)
+  {
+    return NULL;
+  }
+
+  var = s_scope_find_local(scope, name, hash);
+
+  if (var)
+  {
+    return &var->value;
+  }
+
+  if (scope->count == scope->capacity)
+  {
+    MiVar *vars;
+    uint32_t capacity;
+
+    capacity = scope->capacity ? scope->capacity * 2 : 4;
+    vars = (MiVar *)x_arena_alloc_zero(scope->arena, sizeof(MiVar) * capacity);
+
+    if (!vars)
+    {
+      return NULL;
+    }
+
+    if (scope->count > 0)
+    {
+      memcpy(vars, scope->vars, sizeof(MiVar) * scope->count);
+    }
+
+    scope->vars = vars;
+    scope->capacity = capacity;
+  }
+
+  var = &scope->vars[scope->count];
+
+  // A recycled frame usually defines the same names in the same order as
+  // its previous use, so the old name copy can be kept. When another caller
+  // reuses the frame with different names, the copy is overwritten in place.
+  if (!(var->name.ptr && s_scope_name_eq(var, name, hash)))
+  {
+    char *owned;
+
+    if (var->name.ptr && name.length < var->name_capacity)
+    {
+      owned = (char *)var->name.ptr;
+    }
+    else
+    {
+      owned = (char *)x_arena_alloc(scope->arena, name.length + 1);
+
+      if (!owned)
+      {
+        return NULL;
+      }
+
+      var->name_capacity = (uint32_t)name.length + 1;
+    }
+
+    memcpy(owned, name.ptr, name.length);
+    owned[name.length] = 0;
+    var->name = x_slice_init(owned, name.length);
+    var->hash = hash;
+  }
+
+  var->value = mi_value_null();
+  scope->count += 1;
+  scope->filter |= s_scope_filter_bit(hash);
+
+  if (scope->index)
+  {
+    if (scope->count * 2 > scope->index_mask + 1)
+    {
+      if (!s_scope_index_build(scope, (scope->index_mask + 1) * 2))
+      {
+        scope->count -= 1;
+        return NULL;
+      }
+    }
+    else
+    {
+      uint32_t b;
+
+      b = hash & scope->index_mask;
+
+      while (scope->index[b])
+      {
+        b = (b + 1) & scope->index_mask;
+      }
+
+      scope->index[b] = scope->count;
+    }
+  }
+  else if (scope->count >= MI_SCOPE_INDEX_MIN)
+  {
+    uint32_t buckets;
+
+    buckets = 1;
+
+    while (buckets < scope->count * 4)
+    {
+      buckets *= 2;
+    }
+
+    if (!s_scope_index_build(scope, buckets))
+    {
+      scope->count -= 1;
+      return NULL;
+    }
+  }
+
+  return &var->value;
+}
+
+bool mi_scope_get(MiScope *scope, XSlice name, MiValue *out_value)
+{
+  MiValue *slot;
+
+  if (!scope || !out_value || !name.ptr)
+  {
+    return false;
+  }
+
+  slot = mi_scope_find(scope, name, mi_name_hash(name));
+
+  if (!slot)
+  {
+    return false;
+  }
+
+  *out_value = *slot;
+  return true;
 }
 
 bool mi_scope_define(MiScope *scope, XSlice name, MiValue value)
 {
-  char *key;
+  MiValue *slot;
 
-  if (!scope || !scope->vars)
+  if (!scope)
   {
     return false;
   }
 
-  key = mi_keydup_arena(scope->arena, name);
+  slot = mi_scope_slot(scope, name, mi_name_hash(name));
 
-  if (!key)
+  if (!slot)
   {
     return false;
   }
 
-  return x_hashtable_mi_value_table_set(scope->vars, key, value);
+  *slot = value;
+  return true;
 }
 
 bool mi_scope_set(MiScope *scope, XSlice name, MiValue value)
 {
-  MiScope *it;
-  char *lookup_key;
-  char *owned_key;
+  MiValue *slot;
+  uint32_t hash;
 
-  if (!scope)
+  if (!scope || !name.ptr)
   {
     return false;
   }
 
-  lookup_key = mi_keydup_heap(name);
+  hash = mi_name_hash(name);
+  slot = mi_scope_find(scope, name, hash);
+
+  if (!slot)
+  {
+    slot = mi_scope_slot(scope, name, hash);
+  }
 
-  if (!lookup_key)
+  if (!slot)
   {
     return false;
   }
 
-  it = scope;
+  *slot = value;
+  return true;
+}
+
+static MiScope *s_scope_acquire(MiContext *ctx, MiScope *parent)
+{
+  MiScope *scope;
+
+  scope = ctx->scope_pool;
 
-  while (it)
+  if (!scope)
   {
-    if (x_hashtable_mi_value_table_has(it->vars, lookup_key))
-    {
-      bool ok;
+    scope = mi_scope_create(ctx->arena, parent);
 
-      ok = x_hashtable_mi_value_table_set(it->vars, lookup_key, value);
-      free(lookup_key);
-      return ok;
+    if (scope)
+    {
+      scope->pooled = true;
     }
 
-    it = it->parent;
+    return scope;
   }
 
-  free(lookup_key);
+  ctx->scope_pool = scope->next_free;
+  scope->next_free = NULL;
+  scope->parent = parent;
+  return scope;
+}
 
-  owned_key = mi_keydup_arena(scope->arena, name);
+static void s_scope_release(MiContext *ctx, MiScope *scope)
+{
+  if (!scope->pooled)
+  {
+    return;
+  }
 
-  if (!owned_key)
+  // Names and slot storage stay allocated for the next user of the frame
+  if (scope->index)
   {
-    return false;
+    memset(scope->index, 0, sizeof(uint32_t) * (scope->index_mask + 1));
   }
 
-  return x_hashtable_mi_value_table_set(scope->vars, owned_key, value);
+  scope->count = 0;
+  scope->filter = 0;
+  scope->parent = NULL;
+  scope->next_free = ctx->scope_pool;
+  ctx->scope_pool = scope;
 }
 
 bool mi_context_init(MiContext *ctx, XArena *arena, FILE* out_stream, FILE* err_stream)
@@ -310,9 +556,43 @@ bool mi_context_init(MiContext *ctx, XArena *arena, FILE* out_stream, FILE* err_
   ctx->error_message = NULL;
   ctx->error_line = 0;
   ctx->error_column = 0;
+  ctx->generation = 1;
   return true;
 }
 
+void mi_context_term(MiContext *ctx)
+{
+  if (!ctx)
+  {
+    return;
+  }
+
+  x_hashtable_mi_command_table_destroy(ctx->commands);
+  x_hashtable_mi_func_table_destroy(ctx->funcs);
+
+  if (ctx->output)
+  {
+    x_strbuilder_destroy(ctx->output);
+  }
+
+  if (ctx->source_stack)
+  {
+    x_array_destroy(ctx->source_stack);
+  }
+
+  if (ctx->format_arena)
+  {
+    x_arena_destroy(ctx->format_arena);
+  }
+
+  if (ctx->print_arena)
+  {
+    x_arena_destroy(ctx->print_arena);
+  }
+
+  memset(ctx, 0, sizeof(*ctx));
+}
+
 void mi_context_reset(MiContext *ctx)
 {
   if (!ctx)
@@ -365,6 +645,7 @@ bool mi_register_command_slice(MiContext *ctx, XSlice name, MiCommandFn fn)
     return false;
   }
 
+  ctx->generation += 1;
   return x_hashtable_mi_command_table_set(ctx->commands, key, fn);
 }
 
@@ -426,6 +707,7 @@ bool mi_register_func_slice(MiContext *ctx, XSlice name, MiFunc func)
 
   func.name = x_slice_from_cstr(owned_name);
 
+  ctx->generation += 1;
   return x_hashtable_mi_func_table_set(ctx->funcs, key, func);
 }
 
@@ -460,7 +742,7 @@ MiScope *mi_push_scope(MiContext *ctx)
     return NULL;
   }
 
-  scope = mi_scope_create(ctx->arena, ctx->current_scope);
+  scope = s_scope_acquire(ctx, ctx->current_scope);
 
   if (!scope)
   {
@@ -481,13 +763,17 @@ void mi_pop_scope(MiContext *ctx)
 
   if (ctx->current_scope->parent)
   {
-    ctx->current_scope = ctx->current_scope->parent;
+    MiScope *scope;
+
+    scope = ctx->current_scope;
+    ctx->current_scope = scope->parent;
+    s_scope_release(ctx, scope);
   }
 }
 
 MiExecResult mi_eval_node(MiContext *ctx, MiNode *node)
 {
-  MiValue value;
+  MiValue *slot;
 
   if (!ctx || !node)
   {
@@ -507,13 +793,16 @@ MiExecResult mi_eval_node(MiContext *ctx, MiNode *node)
       return mi_exec_ok(mi_value_raw(node->text));
 
     case MI_NODE_VARIABLE:
-      if (!mi_scope_get(ctx->current_scope, node->text, &value))
+      slot = mi_scope_find(ctx->current_scope, node->text,
+          node->hash ? node->hash : mi_name_hash(node->text));
+
+      if (!slot)
       {
         mi_context_set_error(ctx, "undefined variable", node->line, node->column);
         return mi_exec_error();
       }
 
-      return mi_exec_ok(value);
+      return mi_exec_ok(*slot);
 
     case MI_NODE_SUBCOMMAND:
       if (!node->first_child)
@@ -560,7 +849,7 @@ MiExecResult mi_call_func(MiContext *ctx, const MiFunc *func, int argc, MiNode *
   }
 
   old_scope = ctx->current_scope;
-  call_scope = mi_scope_create(ctx->arena, ctx->global_scope);
+  call_scope = s_scope_acquire(ctx, ctx->global_scope);
 
   if (!call_scope)
   {
@@ -579,6 +868,7 @@ MiExecResult mi_call_func(MiContext *ctx, const MiFunc *func, int argc, MiNode *
     if (arg_result.signal != MI_SIGNAL_NONE)
     {
       ctx->current_scope = old_scope;
+      s_scope_release(ctx, call_scope);
       return arg_result;
     }
 
@@ -586,6 +876,7 @@ MiExecResult mi_call_func(MiContext *ctx, const MiFunc *func, int argc, MiNode *
     {
       mi_context_set_error(ctx, "failed to bind function parameter", 0, 0);
       ctx->current_scope = old_scope;
+      s_scope_release(ctx, call_scope);
       return mi_exec_error();
     }
   }
@@ -593,6 +884,7 @@ MiExecResult mi_call_func(MiContext *ctx, const MiFunc *func, int argc, MiNode *
   result = mi_exec_block(ctx, func->body, false);
 
   ctx->current_scope = old_scope;
+  s_scope_release(ctx, call_scope);
 
   if (result.signal == MI_SIGNAL_RETURN)
   {
@@ -609,7 +901,7 @@ MiExecResult mi_exec_command(MiContext *ctx, MiNode *command)
   MiNode *arg_node;
   MiCommandFn fn;
   MiFunc func;
-  MiNode *argv_buf[64];
+  MiNode *argv_buf[MI_MAX_COMMAND_ARGS];
   int argc;
 
   if (!ctx || !command || command->kind != MI_NODE_COMMAND)
@@ -621,6 +913,11 @@ MiExecResult mi_exec_command(MiContext *ctx, MiNode *command)
     return mi_exec_error();
   }
 
+  if (command->instr && !ctx->tree_walk)
+  {
+    return mi_exec_instr(ctx, command->instr);
+  }
+
   name_node = command->first_child;
 
   if (!name_node)
@@ -670,6 +967,7 @@ MiExecResult mi_exec_block(MiContext *ctx, MiNode *block, bool create_scope)
   MiExecResult result;
   MiNode *command;
   MiScope *saved_scope;
+  MiScope *block_scope;
 
   if (!ctx || !block || block->kind != MI_NODE_BLOCK)
   {
@@ -681,38 +979,61 @@ MiExecResult mi_exec_block(MiContext *ctx, MiNode *block, bool create_scope)
   }
 
   saved_scope = ctx->current_scope;
+  block_scope = NULL;
 
   if (create_scope)
   {
-    if (!mi_push_scope(ctx))
+    block_scope = mi_push_scope(ctx);
+
+    if (!block_scope)
     {
       return mi_exec_error();
     }
   }
 
-  command = block->first_child;
   result = mi_exec_null();
 
-  while (command)
+  if (block->code && !ctx->tree_walk)
   {
-    result = mi_exec_command(ctx, command);
+    MiInstr *instr;
+    MiInstr *end;
+
+    instr = block->code->instrs;
+    end = instr + block->code->count;
 
-    if (result.signal != MI_SIGNAL_NONE)
+    while (instr < end)
     {
-      if (create_scope)
+      result = mi_exec_instr(ctx, instr);
+
+      if (result.signal != MI_SIGNAL_NONE)
       {
-        ctx->current_scope = saved_scope;
+        break;
       }
 
-      return result;
+      instr += 1;
     }
+  }
+  else
+  {
+    command = block->first_child;
 
-    command = command->next_sibling;
+    while (command)
+    {
+      result = mi_exec_command(ctx, command);
+
+      if (result.signal != MI_SIGNAL_NONE)
+      {
+        break;
+      }
+
+      command = command->next_sibling;
+    }
   }
 
   if (create_scope)
   {
     ctx->current_scope = saved_scope;
+    s_scope_release(ctx, block_scope);
   }
 
   return result;
@@ -36,6 +36,8 @@ typedef enum MiNodeKind
 } MiNodeKind;
 
 typedef struct MiNode MiNode;
+typedef struct MiInstr MiInstr;
+typedef struct MiCode MiCode;
 
 /**
  * A parsed syntax node.
@@ -53,6 +55,9 @@ struct MiNode
   MiNode *first_child;  // First child node, or NULL when there are no children.
   MiNode *last_child;   // Last child node, or NULL when there are no children.
   MiNode *next_sibling; // Next sibling node in the parent child list.
+  MiInstr *instr;       // Compiled form of a command node, or NULL. See `mi_compile`.
+  MiCode *code;         // Compiled form of a block node, or NULL. See `mi_compile`.
+  uint32_t hash;        // Name hash of a variable or raw node, precomputed by `mi_compile`; 0 when unknown.
 };
 
 /**
@@ -136,11 +141,11 @@ typedef struct MiUserType
 /**
  * Wrapper for host-defined values carried by Minima.
  */
-typedef struct MiUser
+struct MiUser
 {
   const MiUserType *type; // Runtime type descriptor for the stored payload.
   void *data;             // Host-owned payload pointer.
-} MiUser;
+};
 
 /**
  * A dynamically typed Minima runtime value.
@@ -195,26 +200,102 @@ typedef MiExecResult (*MiCommandFn)(MiContext *ctx, i32 argc, MiNode **argv);
 /**
  * A user-defined Minima function.
  */
-typedef struct MiFunc
+struct MiFunc
 {
   XSlice name;        // Function name.
   size_t param_count; // Number of parameters.
   XSlice *params;     // Parameter name array.
   MiNode *body;       // Function body block.
-} MiFunc;
+};
+
+/**
+ * Maximum number of arguments a command can take.
+ */
+#define MI_MAX_COMMAND_ARGS 64
+
+/**
+ * Number of variables a scope holds before it builds a hash index over its
+ * slots. Smaller scopes are searched linearly.
+ * Can be overriden before including this header.
+ */
+#ifndef MI_SCOPE_INDEX_MIN
+#define MI_SCOPE_INDEX_MIN 16
+#endif
+
+/**
+ * Operations of compiled instructions.
+ */
+typedef enum MiOpcode
+{
+  MI_OP_UNRESOLVED, // No command or function had the name when last resolved.
+  MI_OP_COMMAND,    // Call the host command `fn`.
+  MI_OP_FUNC,       // Call the user-defined function `func`.
+  MI_OP_TREE,       // Hand the command node to the tree walker, which reports why it is malformed.
+} MiOpcode;
+
+/**
+ * One compiled command.
+ *
+ * The target is resolved by name once and cached together with the context
+ * generation it was resolved in. Registering a command or function bumps the
+ * generation, so the next execution resolves again.
+ */
+struct MiInstr
+{
+  MiOpcode op;          // Operation to perform.
+  i32 argc;             // Number of argument nodes.
+  MiNode **argv;        // Argument nodes, collected once at compile time.
+  MiNode *node;         // Command node: its first child is the name, and it locates errors.
+  MiCommandFn fn;       // Target when `op == MI_OP_COMMAND`.
+  MiFunc func;          // Target when `op == MI_OP_FUNC`.
+  MiContext *ctx;       // Context the target was resolved against.
+  uint32_t generation;  // `ctx->generation` at resolution time; 0 when never resolved.
+};
 
-X_HASHTABLE_TYPE_CSTR_KEY_NAMED(MiValue, mi_value_table);       // Typed Hashtable for storing variables by name.
-X_HASHTABLE_TYPE_CSTR_KEY_NAMED(MiCommandFn, mi_command_table); // Typed Hashtable  or storing commands by name.
-X_HASHTABLE_TYPE_CSTR_KEY_NAMED(MiFunc, mi_func_table);         // Typed Hashtable  or storing functions by name.
+/**
+ * Compiled block: the instructions of its commands, in order.
+ */
+struct MiCode
+{
+  i32 count;            // Number of instructions.
+  MiInstr *instrs;      // Instruction array.
+};
+
+X_HASHTABLE_TYPE_CSTR_KEY_NAMED(MiCommandFn, mi_command_table)  // Typed Hashtable  or storing commands by name.
+X_HASHTABLE_TYPE_CSTR_KEY_NAMED(MiFunc, mi_func_table)          // Typed Hashtable  or storing functions by name.
+
+/**
+ * A variable slot of a scope.
+ */
+typedef struct MiVar
+{
+  XSlice name;          // Variable name, owned by the scope arena.
+  uint32_t hash;        // `mi_name_hash(name)`.
+  uint32_t name_capacity; // Bytes available at name.ptr, kept when a recycled frame renames the slot.
+  MiValue value;        // Current value.
+} MiVar;
 
 /**
  * A Minima variable scope.
+ *
+ * Variables live in a flat slot array. `filter` has one bit set per name
+ * hash so lookups can skip frames that cannot hold a name, and frames with
+ * at least `MI_SCOPE_INDEX_MIN` variables also keep an open addressing
+ * index over their slots. Frames pushed by the runtime are recycled through
+ * `MiContext.scope_pool` together with their slot storage.
  */
 struct MiScope
 {
-  XArena *arena;                    // Arena used for scope-owned allocations.
-  MiScope *parent;                  // Parent scope, or NULL for the root scope.
-  XHashtable_mi_value_table *vars;  // Variable table for the scope.
+  XArena *arena;        // Arena used for scope-owned allocations.
+  MiScope *parent;      // Parent scope, or NULL for the root scope.
+  MiVar *vars;          // Variable slots; the first `count` are live.
+  uint32_t count;       // Number of live slots.
+  uint32_t capacity;    // Allocated slots. Slots past `count` keep their names for reuse.
+  uint32_t *index;      // Slot index + 1 per bucket, or NULL while the frame is small.
+  uint32_t index_mask;  // Bucket count - 1 of `index`.
+  uint64_t filter;      // Bit `hash >> 26` is set for every live name.
+  bool pooled;          // Frame belongs to the context pool.
+  MiScope *next_free;   // Next frame in the pool while released.
 };
 
 /**
@@ -234,6 +315,7 @@ struct MiContext
   XArena *arena;                          // Arena used for runtime allocations.
   MiScope *global_scope;                  // Global root scope.
   MiScope *current_scope;                 // Currently active scope.
+  MiScope *scope_pool;                    // Released frames, reused by `mi_push_scope` and function calls.
   XArray *source_stack;                   // Stack of MiSourceFrame
   XHashtable_mi_command_table *commands;  // Registered command table.
   XHashtable_mi_func_table *funcs;        // Registered function table.
@@ -244,6 +326,11 @@ struct MiContext
   int error_line;                         // Line associated with the last error.
   int error_column;                       // Column associated with the last error.
   XFSPath error_source_file;
+  uint32_t generation;                    // Bumped whenever a command or function is registered.
+  bool tree_walk;                         // Ignore compiled code and walk the AST, for debugging.
+  void *host;                             // Opaque host state for commands registered by the embedder.
+  XArena *format_arena;                   // Scratch for `format`, created on first use.
+  XArena *print_arena;                    // Scratch for `print`, created on first use.
 };
 
 /**
@@ -371,6 +458,39 @@ bool mi_value_is_user(MiValue value);
  */
 MiScope *mi_scope_create(XArena *arena, MiScope *parent);
 
+/**
+ * Hash a variable name the way scopes do.
+ *
+ * @param name Variable name.
+ * @return Non-zero name hash.
+ */
+uint32_t mi_name_hash(XSlice name);
+
+/**
+ * Find the slot of a variable in a scope chain.
+ *
+ * The returned pointer stays valid until a variable is added to the same
+ * scope or the scope is released.
+ *
+ * @param scope Scope where the lookup begins.
+ * @param name Variable name.
+ * @param hash `mi_name_hash(name)`.
+ * @return Pointer to the value of the nearest binding, or NULL when undefined.
+ */
+MiValue *mi_scope_find(MiScope *scope, XSlice name, uint32_t hash);
+
+/**
+ * Find or create the slot of a variable in one scope, ignoring its parents.
+ *
+ * New slots start as null values.
+ *
+ * @param scope Target scope.
+ * @param name Variable name.
+ * @param hash `mi_name_hash(name)`.
+ * @return Pointer to the value slot, or NULL on allocation failure.
+ */
+MiValue *mi_scope_slot(MiScope *scope, XSlice name, uint32_t hash);
+
 /**
  * Look up a variable in a scope chain.
  *
@@ -415,6 +535,15 @@ bool mi_scope_set(MiScope *scope, XSlice name, MiValue value);
  */
 bool mi_context_init(MiContext *ctx, XArena *arena, FILE* out_stream, FILE* err_stream);
 
+/**
+ * Release the tables, buffers and scratch arenas owned by a context.
+ * The runtime arena passed to `mi_context_init` belongs to the caller.
+ *
+ * @param ctx Context to release.
+ * @return Nothing.
+ */
+void mi_context_term(MiContext *ctx);
+
 /**
  * Reset a context to its initial runtime state.
  *
@@ -495,6 +624,9 @@ MiScope *mi_push_scope(MiContext *ctx);
 /**
  * Pop the current scope and restore its parent.
  *
+ * Scopes created by `mi_push_scope` go back to the context pool, so values
+ * and slots obtained from them must not be used afterwards.
+ *
  * @param ctx Target context.
  * @return Nothing.
  */
@@ -509,6 +641,37 @@ void mi_pop_scope(MiContext *ctx);
  */
 MiExecResult mi_eval_node(MiContext *ctx, MiNode *node);
 
+/**
+ * Compile a parsed program for faster execution.
+ *
+ * Every block gets an instruction array and every command an instruction
+ * with its argument list collected and its target resolved to a direct
+ * pointer. From then on `mi_exec_block` and `mi_exec_command` run the
+ * compiled form and only hash a command name again after a command or
+ * function was registered. Commands still receive their arguments as nodes,
+ * so builtins work unchanged. Set `ctx->tree_walk` to run the AST instead.
+ * Variable and raw nodes get their name hash stored in `MiNode.hash`, so
+ * scope lookups through them skip hashing.
+ *
+ * Compiling the same tree again is a no-op.
+ *
+ * @param ctx Context whose commands and functions are resolved.
+ * @param arena Arena for the compiled code; it must live as long as the tree.
+ * @param root Root node, usually `MiParseResult.root`.
+ * @return True on success, false on allocation failure. Parts that were not
+ * compiled keep running through the tree walker.
+ */
+bool mi_compile(MiContext *ctx, XArena *arena, MiNode *root);
+
+/**
+ * Execute a compiled instruction.
+ *
+ * @param ctx Active execution context.
+ * @param instr Instruction to execute.
+ * @return Execution result.
+ */
+MiExecResult mi_exec_instr(MiContext *ctx, MiInstr *instr);
+
 /**
  * Execute a command node.
  *
@@ -540,14 +703,18 @@ MiExecResult mi_exec_block(MiContext *ctx, MiNode *block, bool create_scope);
 MiExecResult mi_call_func(MiContext *ctx, const MiFunc *func, int argc, MiNode **argv);
 
 
-X_ARRAY_TYPE(MiValue);
-MI_IMPORT_TYPE(List);
+// Most lists are tiny; their items live inside the MiList until they outgrow it.
+#define MI_LIST_INLINE_ITEMS 8
+
+X_ARRAY_TYPE_INLINE(MiValue, MI_LIST_INLINE_ITEMS)
+MI_IMPORT_TYPE(List)
 
 typedef struct MiList
 {
   uint32_t magic;
   bool destroyed;
-  XArray_MiValue *items;
+  XArray_MiValue *items;                  // Points into item_storage
+  XArrayInline_MiValue item_storage;
 } MiList;
 
 
@@ -1,14 +1,17 @@
 #include <stdx_common.h>
 
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+
 #define X_IMPL_ARENA
 #include <stdx_arena.h>
 
-#define X_IMPL_IO
-#include <stdx_io.h>
-
 #define X_IMPL_STRING
 #include <stdx_string.h>
 
+#define X_IMPL_IO
+#include <stdx_io.h>
+
 #define X_IMPL_STRBUILDER
 #include <stdx_strbuilder.h>
 
@@ -28,6 +31,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #define CHUNK_SIZE (1024 * 8)
 static void print_usage(const char *exe)
@@ -265,9 +269,9 @@ static int test_exec_simple_command(void)
 {
   XArena *arena;
   MiContext ctx;
-  MiNode cmd;
-  MiNode arg;
-  MiNode name;
+  MiNode cmd = {0};
+  MiNode arg = {0};
+  MiNode name = {0};
   MiExecResult r;
   bool ok;
 
@@ -306,7 +310,7 @@ static int test_variable_eval(void)
 {
   XArena *arena;
   MiContext ctx;
-  MiNode var;
+  MiNode var = {0};
   MiExecResult r;
   bool ok;
 
@@ -341,10 +345,10 @@ static int test_subcommand(void)
 {
   XArena *arena;
   MiContext ctx;
-  MiNode sub;
-  MiNode cmd;
-  MiNode name;
-  MiNode arg;
+  MiNode sub = {0};
+  MiNode cmd = {0};
+  MiNode name = {0};
+  MiNode arg = {0};
   MiExecResult r;
   bool ok;
 
@@ -522,6 +526,343 @@ static int test_mi_parser_basic_ast(void)
   return 0;
 }
 
+static int s_counter;
+
+static MiExecResult cmd_count(MiContext *ctx, int argc, MiNode **argv)
+{
+  (void)ctx;
+  (void)argc;
+  (void)argv;
+  s_counter += 1;
+  return mi_exec_null();
+}
+
+static MiExecResult cmd_count_twice(MiContext *ctx, int argc, MiNode **argv)
+{
+  (void)ctx;
+  (void)argc;
+  (void)argv;
+  s_counter += 2;
+  return mi_exec_null();
+}
+
+static bool s_run_script(XArena *arena, MiContext *ctx, const char *source, bool compile, MiExecResult *out)
+{
+  MiParseResult parsed;
+
+  parsed = mi_parse(arena, x_slice_from_cstr(source));
+
+  if (!parsed.ok)
+  {
+    return false;
+  }
+
+  if (compile && !mi_compile(ctx, arena, parsed.root))
+  {
+    return false;
+  }
+
+  ctx->tree_walk = !compile;
+  *out = mi_exec_block(ctx, parsed.root, false);
+  return true;
+}
+
+static int test_compiled_matches_tree_walk(void)
+{
+  const char *source =
+    "set i 0\n"
+    "set total 0\n"
+    "while (expr $i < 100) {\n"
+    "  set total (expr $total + $i)\n"
+    "  set i (expr $i + 1)\n"
+    "  if (expr $i == 50) { count } else { }\n"
+    "}\n";
+  int mode;
+
+  for (mode = 0; mode < 2; mode++)
+  {
+    XArena *arena;
+    MiContext ctx;
+    MiExecResult r;
+    MiValue total;
+
+    arena = x_arena_create(CHUNK_SIZE);
+    ASSERT_TRUE(mi_context_init(&ctx, arena, NULL, NULL));
+    ASSERT_TRUE(mi_register_builtins(&ctx));
+    ASSERT_TRUE(mi_register_command(&ctx, "count", cmd_count));
+
+    s_counter = 0;
+    ASSERT_TRUE(s_run_script(arena, &ctx, source, mode == 0, &r));
+    ASSERT_TRUE(r.signal == MI_SIGNAL_NONE);
+    ASSERT_TRUE(s_counter == 1);
+    ASSERT_TRUE(mi_scope_get(ctx.global_scope, x_slice_from_cstr("total"), &total));
+    ASSERT_TRUE(total.kind == MI_VAL_NUMBER && total.as.number == 4950.0);
+
+    x_arena_destroy(arena);
+  }
+
+  return 0;
+}
+
+static int test_compile_resolves_commands(void)
+{
+  XArena *arena;
+  MiContext ctx;
+  MiParseResult parsed;
+  MiExecResult r;
+  MiCode *code;
+
+  arena = x_arena_create(CHUNK_SIZE);
+  ASSERT_TRUE(mi_context_init(&ctx, arena, NULL, NULL));
+  ASSERT_TRUE(mi_register_command(&ctx, "count", cmd_count));
+
+  parsed = mi_parse(arena, x_slice_from_cstr("count\nlater (count)\n"));
+  ASSERT_TRUE(parsed.ok);
+  ASSERT_TRUE(mi_compile(&ctx, arena, parsed.root));
+
+  code = parsed.root->code;
+  ASSERT_TRUE(code != NULL && code->count == 2);
+  ASSERT_TRUE(code->instrs[0].op == MI_OP_COMMAND && code->instrs[0].fn == cmd_count);
+  ASSERT_TRUE(code->instrs[1].op == MI_OP_UNRESOLVED && code->instrs[1].argc == 1);
+  ASSERT_TRUE(parsed.root->first_child->next_sibling->instr == &code->instrs[1]);
+
+  // Unknown at compile time: reported when reached
+  s_counter = 0;
+  r = mi_exec_block(&ctx, parsed.root, false);
+  ASSERT_TRUE(r.signal == MI_SIGNAL_ERROR);
+  ASSERT_TRUE(strcmp(ctx.error_message, "unknown command") == 0);
+  ASSERT_TRUE(s_counter == 1);
+
+  // Registered afterwards: picked up on the next run
+  mi_context_reset(&ctx);
+  ASSERT_TRUE(mi_register_command(&ctx, "later", cmd_count));
+  s_counter = 0;
+  r = mi_exec_block(&ctx, parsed.root, false);
+  ASSERT_TRUE(r.signal == MI_SIGNAL_NONE);
+  ASSERT_TRUE(s_counter == 2);
+  ASSERT_TRUE(code->instrs[1].op == MI_OP_COMMAND);
+
+  // Re-registered: the cached pointer is replaced
+  ASSERT_TRUE(mi_register_command(&ctx, "count", cmd_count_twice));
+  s_counter = 0;
+  r = mi_exec_block(&ctx, parsed.root, false);
+  ASSERT_TRUE(r.signal == MI_SIGNAL_NONE);
+  ASSERT_TRUE(s_counter == 3);
+
+  // Compiling again changes nothing
+  ASSERT_TRUE(mi_compile(&ctx, arena, parsed.root));
+  ASSERT_TRUE(parsed.root->code == code);
+
+  x_arena_destroy(arena);
+  return 0;
+}
+
+static int test_compiled_func_call(void)
+{
+  XArena *arena;
+  MiContext ctx;
+  MiParseResult body;
+  MiExecResult r;
+  MiFunc func = {0};
+
+  arena = x_arena_create(CHUNK_SIZE);
+  ASSERT_TRUE(mi_context_init(&ctx, arena, NULL, NULL));
+  ASSERT_TRUE(mi_register_builtins(&ctx));
+  ASSERT_TRUE(mi_register_command(&ctx, "count", cmd_count));
+
+  body = mi_parse(arena, x_slice_from_cstr("count\ncount\n"));
+  ASSERT_TRUE(body.ok);
+  func.body = body.root;
+  ASSERT_TRUE(mi_register_func_slice(&ctx, x_slice_from_cstr("twice"), func));
+  ASSERT_TRUE(mi_compile(&ctx, arena, body.root));
+
+  s_counter = 0;
+  ASSERT_TRUE(s_run_script(arena, &ctx, "twice\nif 1 { twice }\n", true, &r));
+  ASSERT_TRUE(r.signal == MI_SIGNAL_NONE);
+  ASSERT_TRUE(s_counter == 4);
+
+  // Malformed commands keep the tree walker's diagnostics
+  ASSERT_TRUE(s_run_script(arena, &ctx, "twice 1\n", true, &r));
+  ASSERT_TRUE(r.signal == MI_SIGNAL_ERROR);
+  ASSERT_TRUE(strcmp(ctx.error_message, "wrong number of arguments") == 0);
+
+  x_arena_destroy(arena);
+  return 0;
+}
+
+static int test_scope_slots_and_index(void)
+{
+  XArena *arena;
+  MiScope *global_scope;
+  MiScope *child;
+  MiValue value;
+  char name[16];
+  int i;
+
+  arena = x_arena_create(CHUNK_SIZE);
+  global_scope = mi_scope_create(arena, NULL);
+  child = mi_scope_create(arena, global_scope);
+
+  // Enough names to switch the global frame to its hash index
+  for (i = 0; i < MI_SCOPE_INDEX_MIN * 4; i++)
+  {
+    snprintf(name, sizeof(name), "v%d", i);
+    ASSERT_TRUE(mi_scope_define(global_scope, x_slice_from_cstr(name), mi_value_number((double)i)));
+  }
+
+  ASSERT_TRUE(global_scope->index != NULL);
+  ASSERT_TRUE(child->vars == NULL);
+
+  ASSERT_TRUE(mi_scope_define(child, x_slice_from_cstr("v7"), mi_value_number(-7.0)));
+
+  for (i = 0; i < MI_SCOPE_INDEX_MIN * 4; i++)
+  {
+    snprintf(name, sizeof(name), "v%d", i);
+    ASSERT_TRUE(mi_scope_get(child, x_slice_from_cstr(name), &value));
+    ASSERT_TRUE(value.kind == MI_VAL_NUMBER);
+    ASSERT_TRUE(value.as.number == (i == 7 ? -7.0 : (double)i));
+  }
+
+  ASSERT_TRUE(mi_scope_get(global_scope, x_slice_from_cstr("v7"), &value));
+  ASSERT_TRUE(value.as.number == 7.0);
+  ASSERT_FALSE(mi_scope_get(child, x_slice_from_cstr("v"), &value));
+  ASSERT_TRUE(mi_scope_find(child, x_slice_from_cstr("v7"), mi_name_hash(x_slice_from_cstr("v7")))
+      == &child->vars[0].value);
+
+  x_arena_destroy(arena);
+  return 0;
+}
+
+static int test_scope_pool_recycles_frames(void)
+{
+  XArena *arena;
+  MiContext ctx;
+  MiScope *first;
+  MiValue value;
+
+  arena = x_arena_create(CHUNK_SIZE);
+  ASSERT_TRUE(mi_context_init(&ctx, arena, NULL, NULL));
+
+  first = mi_push_scope(&ctx);
+  ASSERT_TRUE(first != NULL);
+  ASSERT_TRUE(mi_scope_define(first, x_slice_from_cstr("tmp"), mi_value_number(1.0)));
+  mi_pop_scope(&ctx);
+  ASSERT_TRUE(ctx.current_scope == ctx.global_scope);
+
+  // The released frame comes back empty
+  ASSERT_TRUE(mi_push_scope(&ctx) == first);
+  ASSERT_FALSE(mi_scope_get(first, x_slice_from_cstr("tmp"), &value));
+  mi_pop_scope(&ctx);
+
+  // The global scope is never released
+  mi_pop_scope(&ctx);
+  ASSERT_TRUE(ctx.current_scope == ctx.global_scope);
+  ASSERT_TRUE(ctx.scope_pool == first && first->next_free == NULL);
+
+  x_arena_destroy(arena);
+  return 0;
+}
+
+static int test_context_owns_scratch(void)
+{
+  XArena *arena;
+  MiContext a;
+  MiContext b;
+  MiExecResult r;
+  FILE *out;
+
+  arena = x_arena_create(CHUNK_SIZE);
+  out = tmpfile();
+  ASSERT_TRUE(out != NULL);
+  ASSERT_TRUE(mi_context_init(&a, arena, out, NULL));
+  ASSERT_TRUE(mi_context_init(&b, arena, out, NULL));
+  ASSERT_TRUE(mi_register_builtins(&a));
+  ASSERT_TRUE(mi_register_builtins(&b));
+
+  ASSERT_TRUE(s_run_script(arena, &a, "set n 1\nprint (format \"a${n}\")\n", true, &r));
+  ASSERT_TRUE(r.signal == MI_SIGNAL_NONE);
+  ASSERT_TRUE(s_run_script(arena, &b, "print (format \"b\")\n", true, &r));
+  ASSERT_TRUE(r.signal == MI_SIGNAL_NONE);
+
+  // Scratch arenas belong to each context, so contexts can run on different threads
+  ASSERT_TRUE(a.format_arena != NULL && a.print_arena != NULL);
+  ASSERT_TRUE(b.format_arena != NULL && a.format_arena != b.format_arena);
+
+  mi_context_term(&a);
+  mi_context_term(&b);
+  ASSERT_TRUE(a.commands == NULL && a.format_arena == NULL);
+
+  fclose(out);
+  x_arena_destroy(arena);
+  return 0;
+}
+
+static int test_loop_scopes_do_not_allocate(void)
+{
+  const char *source =
+    "set i 0\n"
+    "while (expr $i < $n) {\n"
+    "  set i (expr $i + 1)\n"
+    "  if 1 { set local $i }\n"
+    "  foreach item $xs { set last $item }\n"
+    "}\n";
+  size_t used[2];
+  int run;
+
+  for (run = 0; run < 2; run++)
+  {
+    XArena *arena;
+    MiContext ctx;
+    MiExecResult r;
+    MiValue value;
+
+    arena = x_arena_create(CHUNK_SIZE);
+    ASSERT_TRUE(mi_context_init(&ctx, arena, NULL, NULL));
+    ASSERT_TRUE(mi_register_builtins(&ctx));
+    ASSERT_TRUE(s_run_script(arena, &ctx, "set xs (list create a b c)\n", true, &r));
+    ASSERT_TRUE(mi_scope_define(ctx.global_scope, x_slice_from_cstr("n"), mi_value_number(run == 0 ? 10.0 : 1000.0)));
+
+    ASSERT_TRUE(s_run_script(arena, &ctx, source, true, &r));
+    ASSERT_TRUE(r.signal == MI_SIGNAL_NONE);
+    ASSERT_TRUE(mi_scope_get(ctx.global_scope, x_slice_from_cstr("i"), &value));
+    ASSERT_TRUE(value.as.number == (run == 0 ? 10.0 : 1000.0));
+    // Block locals die with their frame
+    ASSERT_FALSE(mi_scope_get(ctx.global_scope, x_slice_from_cstr("local"), &value));
+    ASSERT_FALSE(mi_scope_get(ctx.global_scope, x_slice_from_cstr("last"), &value));
+
+    used[run] = x_arena_stats(arena).bytes_used;
+    x_arena_destroy(arena);
+  }
+
+  // A hundred times the iterations, same memory
+  ASSERT_TRUE(used[0] == used[1]);
+  return 0;
+}
+
+static int test_compile_hashes_names(void)
+{
+  XArena *arena;
+  MiContext ctx;
+  MiParseResult parsed;
+  MiNode *var_node;
+
+  arena = x_arena_create(CHUNK_SIZE);
+  ASSERT_TRUE(mi_context_init(&ctx, arena, NULL, NULL));
+  ASSERT_TRUE(mi_register_builtins(&ctx));
+
+  parsed = mi_parse(arena, x_slice_from_cstr("set x 1\nprint $x\n"));
+  ASSERT_TRUE(parsed.ok);
+  ASSERT_TRUE(mi_compile(&ctx, arena, parsed.root));
+
+  var_node = parsed.root->first_child->next_sibling->first_child->next_sibling;
+  ASSERT_TRUE(var_node->kind == MI_NODE_VARIABLE);
+  ASSERT_TRUE(var_node->hash == mi_name_hash(x_slice_from_cstr("x")));
+  ASSERT_TRUE(parsed.root->first_child->first_child->next_sibling->hash == var_node->hash);
+
+  x_arena_destroy(arena);
+  return 0;
+}
+
 int run_tests()
 {
   STDXTestCase tests[] =
@@ -538,7 +879,15 @@ int run_tests()
     X_TEST(test_variable_eval),
     X_TEST(test_subcommand),
     X_TEST(test_exec_block),
-    X_TEST(test_mi_parser_basic_ast)
+    X_TEST(test_mi_parser_basic_ast),
+    X_TEST(test_compiled_matches_tree_walk),
+    X_TEST(test_compile_resolves_commands),
+    X_TEST(test_compiled_func_call),
+    X_TEST(test_scope_slots_and_index),
+    X_TEST(test_scope_pool_recycles_frames),
+    X_TEST(test_context_owns_scratch),
+    X_TEST(test_loop_scopes_do_not_allocate),
+    X_TEST(test_compile_hashes_names)
   };
 
   return x_tests_run(tests, sizeof(tests) / sizeof(tests[0]), NULL);
@@ -0,0 +1,607 @@
+#include <stdx_common.h>
+#include <stdx_arena.h>
+#include <stdx_filesystem.h>
+#include <stdx_io.h>
+#include <stdx_thread.h>
+
+#include "slab.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SLAB_MANIFEST_VERSION 1
+#define SLAB_MANIFEST_MAX_FIELDS 6
+
+//
+// Helpers
+//
+
+static u64 s_slab_hash_cstr(u64 h, const char* s)
+{
+  // The terminator is hashed too, so adjacent fields can't run into each other
+  if (!s)
+  {
+    s = "";
+  }
+
+  return slab_hash(s, strlen(s) + 1, h);
+}
+
+static u64 s_slab_config_hash(const SlabConfig* config)
+{
+  u64 h = SLAB_HASH_SEED;
+
+  h = s_slab_hash_cstr(h, config->site_url);
+  h = s_slab_hash_cstr(h, config->site_name);
+  h = s_slab_hash_cstr(h, config->output_dir.buf);
+  h = s_slab_hash_cstr(h, config->content_dir.buf);
+  h = s_slab_hash_cstr(h, config->template_dir.buf);
+  return h;
+}
+
+static bool s_slab_contains(const char* text, size_t length, const char* needle)
+{
+  size_t n = strlen(needle);
+  size_t i;
+
+  if (n > length)
+  {
+    return false;
+  }
+
+  for (i = 0; i + n <= length; i++)
+  {
+    if (text[i] == needle[0] && memcmp(text + i, needle, n) == 0)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static bool s_slab_file_hash(SlabBuildCache* cache, const char* path, u64* out_hash)
+{
+  char* text;
+  size_t size;
+
+  bool found;
+
+  x_thread_mutex_lock(cache->lock);
+  found = x_hashtable_slab_hash_table_get(cache->file_hashes, path, out_hash);
+  x_thread_mutex_unlock(cache->lock);
+
+  if (found)
+  {
+    return true;
+  }
+
+  // Two workers may hash the same file; they agree, so the later set is harmless
+  text = x_io_read_text(path, &size);
+  if (!text)
+  {
+    return false;
+  }
+
+  *out_hash = slab_hash(text, size, SLAB_HASH_SEED);
+  free(text);
+
+  x_thread_mutex_lock(cache->lock);
+  x_hashtable_slab_hash_table_set(cache->file_hashes, path, *out_hash);
+  x_thread_mutex_unlock(cache->lock);
+  return true;
+}
+
+// Splits a manifest line on tabs in place. The last field keeps the rest of the line.
+static u32 s_slab_split_fields(char* line, char** fields, u32 max_fields)
+{
+  u32 count = 0;
+  size_t length = strlen(line);
+
+  if (length > 0 && line[length - 1] == '\r')
+  {
+    line[length - 1] = 0;
+  }
+
+  while (count < max_fields)
+  {
+    char* tab;
+
+    fields[count++] = line;
+
+    if (count == max_fields)
+    {
+      break;
+    }
+
+    tab = strchr(line, '\t');
+    if (!tab)
+    {
+      break;
+    }
+
+    *tab = 0;
+    line = tab + 1;
+  }
+
+  return count;
+}
+
+static void s_slab_cache_read(SlabBuildCache* cache)
+{
+  XArena* arena = cache->arena;
+  char* text;
+  char* line;
+  size_t size;
+  bool header = false;
+  SlabManifestEntry* page = NULL;
+  u32 dep_index = 0;
+
+  text = x_io_read_text(cache->manifest_path.buf, &size);
+  if (!text)
+  {
+    return;
+  }
+
+  line = text;
+
+  while (*line)
+  {
+    char* fields[SLAB_MANIFEST_MAX_FIELDS];
+    char* next = strchr(line, '\n');
+    u32 count;
+
+    if (next)
+    {
+      *next++ = 0;
+    }
+    else
+    {
+      next = line + strlen(line);
+    }
+
+    count = s_slab_split_fields(line, fields, SLAB_MANIFEST_MAX_FIELDS);
+
+    if (!header)
+    {
+      // A different site configuration invalidates every output
+      if (count != 3
+          || strcmp(fields[0], "slab-manifest") != 0
+          || atoi(fields[1]) != SLAB_MANIFEST_VERSION
+          || strtoull(fields[2], NULL, 16) != cache->config_hash)
+      {
+        break;
+      }
+
+      header = true;
+    }
+    else if (count == 3 && strcmp(fields[0], "D") == 0)
+    {
+      if (page && dep_index < page->dep_count)
+      {
+        page->deps[dep_index].hash = strtoull(fields[1], NULL, 16);
+        page->deps[dep_index].path = x_arena_strdup(arena, fields[2]);
+        dep_index++;
+      }
+    }
+    else if (count == 6 && (strcmp(fields[0], "A") == 0 || strcmp(fields[0], "P") == 0))
+    {
+      SlabManifestEntry* entry = (SlabManifestEntry*)x_arena_alloc_zero(arena, sizeof(SlabManifestEntry));
+
+      // A page missing some of its dependency lines can't be trusted
+      if (page && dep_index < page->dep_count)
+      {
+        x_hashtable_slab_manifest_table_remove(cache->previous, page->output_path);
+      }
+
+      page = NULL;
+      entry->is_page = fields[0][0] == 'P';
+      entry->source_hash = strtoull(fields[1], NULL, 16);
+      entry->output_path = x_arena_strdup(arena, fields[4]);
+      entry->source_path = x_arena_strdup(arena, fields[5]);
+
+      if (entry->is_page)
+      {
+        entry->site_hash = strtoull(fields[2], NULL, 16);
+        entry->dep_count = (u32)strtoul(fields[3], NULL, 10);
+        entry->deps = (SlabDep*)x_arena_alloc_zero(arena, sizeof(SlabDep) * (entry->dep_count + 1));
+        page = entry;
+        dep_index = 0;
+      }
+      else
+      {
+        entry->size = strtoull(fields[2], NULL, 10);
+        entry->mtime = (time_t)strtoll(fields[3], NULL, 10);
+      }
+
+      x_hashtable_slab_manifest_table_set(cache->previous, entry->output_path, entry);
+    }
+
+    line = next;
+  }
+
+  if (page && dep_index < page->dep_count)
+  {
+    x_hashtable_slab_manifest_table_remove(cache->previous, page->output_path);
+  }
+
+  free(text);
+}
+
+// Callers hold the cache lock
+static SlabManifestEntry* s_slab_cache_entry(SlabBuildCache* cache, const char* source, const char* output)
+{
+  SlabManifestEntry* entry = (SlabManifestEntry*)x_arena_alloc_zero(cache->arena, sizeof(SlabManifestEntry));
+
+  entry->output_path = x_arena_strdup(cache->arena, output);
+  entry->source_path = x_arena_strdup(cache->arena, source);
+  x_hashtable_slab_manifest_table_set(cache->current, entry->output_path, entry);
+  return entry;
+}
+
+//
+// Public API
+//
+
+u64 slab_hash(const void* data, size_t size, u64 seed)
+{
+  const unsigned char* p = (const unsigned char*)data;
+  u64 h = seed;
+  size_t i;
+
+  for (i = 0; i < size; i++)
+  {
+    h ^= p[i];
+    h *= 0x100000001b3ull;
+  }
+
+  return h;
+}
+
+/**
+ * Hash of everything a listing page can see about the other pages.
+ * Never 0, which the build cache reserves for pages that list nothing.
+ */
+u64 slab_site_hash(const SlabSite* site)
+{
+  u64 h = SLAB_HASH_SEED;
+  size_t i;
+  u32 j;
+
+  for (i = 0; i < site->page_count; i++)
+  {
+    const SlabPage* page = &site->pages[i];
+
+    h = s_slab_hash_cstr(h, page->source_path);
+    h = s_slab_hash_cstr(h, page->url);
+    h = s_slab_hash_cstr(h, page->title);
+    h = s_slab_hash_cstr(h, page->template_name);
+    h = s_slab_hash_cstr(h, page->date);
+    h = s_slab_hash_cstr(h, page->author);
+    h = s_slab_hash_cstr(h, page->tags);
+    h = s_slab_hash_cstr(h, page->category);
+    h = s_slab_hash_cstr(h, page->slug);
+    h = slab_hash(&page->draft, sizeof(page->draft), h);
+
+    for (j = 0; j < page->meta.entry_count; j++)
+    {
+      h = slab_hash(page->meta.entry_key[j].ptr, page->meta.entry_key[j].length, h);
+      h = slab_hash("=", 1, h);
+      h = slab_hash(page->meta.entry_value[j].ptr, page->meta.entry_value[j].length, h);
+      h = slab_hash("\n", 1, h);
+    }
+  }
+
+  for (i = 0; i < site->category_count; i++)
+  {
+    h = s_slab_hash_cstr(h, site->categories[i].name);
+  }
+
+  return h ? h : 1;
+}
+
+/**
+ * Create a build cache, seeded from the manifest left by the previous build.
+ * When `discard` is set the manifest is ignored and everything is rebuilt.
+ */
+SlabBuildCache* slab_cache_load(const SlabConfig* config, bool discard)
+{
+  XArena* arena = x_arena_create(1024 * 1024);
+  SlabBuildCache* cache;
+
+  if (!arena)
+  {
+    return NULL;
+  }
+
+  cache = (SlabBuildCache*)x_arena_alloc_zero(arena, sizeof(SlabBuildCache));
+  cache->arena = arena;
+  cache->config_hash = s_slab_config_hash(config);
+  cache->previous = x_hashtable_slab_manifest_table_create();
+  cache->current = x_hashtable_slab_manifest_table_create();
+  cache->file_hashes = x_hashtable_slab_hash_table_create();
+
+  if (x_thread_mutex_init(&cache->lock) != 0)
+  {
+    x_arena_destroy(arena);
+    return NULL;
+  }
+
+  x_fs_path(&cache->manifest_path, config->output_dir.buf, SLAB_MANIFEST_FILE);
+
+  if (!discard)
+  {
+    s_slab_cache_read(cache);
+  }
+
+  return cache;
+}
+
+/**
+ * Write every output recorded by this build. Outputs whose sources are gone
+ * are dropped, so they are rebuilt if the source comes back.
+ */
+bool slab_cache_save(SlabBuildCache* cache)
+{
+  XHashtableIter it;
+  void* key;
+  void* value;
+  FILE* f;
+
+  f = fopen(cache->manifest_path.buf, "wb");
+  if (!f)
+  {
+    log_error("Failed to write build manifest '%s'\n", cache->manifest_path.buf);
+    return false;
+  }
+
+  fprintf(f, "slab-manifest\t%d\t%016llx\n", SLAB_MANIFEST_VERSION, (unsigned long long)cache->config_hash);
+
+  if (x_hashtable_iter_begin((XHashtable*)cache->current, &it))
+  {
+    while (x_hashtable_iter_next(&it, &key, &value))
+    {
+      SlabManifestEntry* entry = *(SlabManifestEntry**)value;
+      u32 i;
+
+      if (!entry->is_page)
+      {
+        fprintf(f, "A\t%016llx\t%llu\t%lld\t%s\t%s\n",
+            (unsigned long long)entry->source_hash,
+            (unsigned long long)entry->size,
+            (long long)entry->mtime,
+            entry->output_path,
+            entry->source_path);
+        continue;
+      }
+
+      fprintf(f, "P\t%016llx\t%016llx\t%u\t%s\t%s\n",
+          (unsigned long long)entry->source_hash,
+          (unsigned long long)entry->site_hash,
+          entry->dep_count,
+          entry->output_path,
+          entry->source_path);
+
+      for (i = 0; i < entry->dep_count; i++)
+      {
+        fprintf(f, "D\t%016llx\t%s\n", (unsigned long long)entry->deps[i].hash, entry->deps[i].path);
+      }
+    }
+  }
+
+  return fclose(f) == 0;
+}
+
+void slab_cache_destroy(SlabBuildCache* cache)
+{
+  if (!cache)
+  {
+    return;
+  }
+
+  x_hashtable_slab_manifest_table_destroy(cache->previous);
+  x_hashtable_slab_manifest_table_destroy(cache->current);
+  x_hashtable_slab_hash_table_destroy(cache->file_hashes);
+  x_thread_mutex_destroy(cache->lock);
+  x_arena_destroy(cache->arena);
+}
+
+/**
+ * An asset is fresh when size and modification time match the manifest, or,
+ * failing that, when its content hash still does. A touched but unchanged
+ * file is therefore not copied again.
+ */
+bool slab_cache_asset_fresh(SlabBuildCache* cache, const char* source, const char* output, u64 size, time_t mtime)
+{
+  SlabManifestEntry* prev = NULL;
+  SlabManifestEntry* entry;
+  bool candidate;
+  u64 hash;
+
+  x_thread_mutex_lock(cache->lock);
+
+  // Another source already wrote this output during this build
+  candidate = !x_hashtable_slab_manifest_table_has(cache->current, output)
+    && x_hashtable_slab_manifest_table_get(cache->previous, output, &prev)
+    && !prev->is_page
+    && strcmp(prev->source_path, source) == 0
+    && prev->size == size;
+
+  x_thread_mutex_unlock(cache->lock);
+
+  if (!candidate || !x_fs_path_is_file_cstr(output))
+  {
+    return false;
+  }
+
+  if (prev->mtime == mtime)
+  {
+    x_thread_mutex_lock(cache->lock);
+    x_hashtable_slab_manifest_table_set(cache->current, prev->output_path, prev);
+    x_thread_mutex_unlock(cache->lock);
+    return true;
+  }
+
+  if (!s_slab_file_hash(cache, source, &hash) || hash != prev->source_hash)
+  {
+    return false;
+  }
+
+  x_thread_mutex_lock(cache->lock);
+  entry = s_slab_cache_entry(cache, source, output);
+  entry->source_hash = hash;
+  entry->size = size;
+  entry->mtime = mtime;
+  x_thread_mutex_unlock(cache->lock);
+  return true;
+}
+
+void slab_cache_record_asset(SlabBuildCache* cache, const char* source, const char* output, u64 size, time_t mtime)
+{
+  SlabManifestEntry* entry;
+  u64 hash;
+
+  if (!s_slab_file_hash(cache, source, &hash))
+  {
+    return;
+  }
+
+  x_thread_mutex_lock(cache->lock);
+  entry = s_slab_cache_entry(cache, source, output);
+  entry->source_hash = hash;
+  entry->size = size;
+  entry->mtime = mtime;
+  x_thread_mutex_unlock(cache->lock);
+}
+
+/**
+ * A page is fresh when its source, every layout and template it read, and,
+ * for pages that list other pages, the site metadata are all unchanged.
+ */
+bool slab_cache_page_fresh(SlabBuildCache* cache, const SlabPage* page, u64 site_hash)
+{
+  SlabManifestEntry* prev = NULL;
+  bool found;
+  u32 i;
+
+  // Entries of the previous build are only read once loaded
+  x_thread_mutex_lock(cache->lock);
+  found = x_hashtable_slab_manifest_table_get(cache->previous, page->output_path, &prev);
+  x_thread_mutex_unlock(cache->lock);
+
+  if (!found
+      || !prev->is_page
+      || prev->source_hash != page->source_hash
+      || strcmp(prev->source_path, page->source_path) != 0)
+  {
+    return false;
+  }
+
+  if (prev->site_hash != 0 && prev->site_hash != site_hash)
+  {
+    return false;
+  }
+
+  for (i = 0; i < prev->dep_count; i++)
+  {
+    u64 hash;
+
+    if (!s_slab_file_hash(cache, prev->deps[i].path, &hash) || hash != prev->deps[i].hash)
+    {
+      return false;
+    }
+  }
+
+  if (!x_fs_path_is_file_cstr(page->output_path))
+  {
+    return false;
+  }
+
+  x_thread_mutex_lock(cache->lock);
+  x_hashtable_slab_manifest_table_set(cache->current, prev->output_path, prev);
+  x_thread_mutex_unlock(cache->lock);
+  return true;
+}
+
+void slab_cache_record_page(SlabBuildCache* cache, const SlabPage* page, const SlabRenderDeps* deps, u64 site_hash)
+{
+  SlabManifestEntry* entry;
+
+  x_thread_mutex_lock(cache->lock);
+  entry = s_slab_cache_entry(cache, page->source_path, page->output_path);
+
+  // The dependency list already lives in the cache arena
+  entry->is_page = true;
+  entry->source_hash = page->source_hash;
+  entry->site_hash = deps->uses_site ? site_hash : 0;
+  entry->dep_count = deps->count;
+  entry->deps = deps->items;
+  x_thread_mutex_unlock(cache->lock);
+}
+
+//
+// Render dependencies
+//
+
+void slab_render_deps_init(SlabRenderDeps* deps, SlabBuildCache* cache)
+{
+  memset(deps, 0, sizeof(*deps));
+  deps->cache = cache;
+}
+
+void slab_render_deps_add(SlabRenderDeps* deps, const char* path, const char* text, size_t length)
+{
+  SlabBuildCache* cache;
+  SlabDep* items;
+  u64 hash;
+  u32 i;
+
+  if (!deps || !deps->cache)
+  {
+    return;
+  }
+
+  if (s_slab_contains(text, length, "all_pages") || s_slab_contains(text, length, "all_categories"))
+  {
+    deps->uses_site = true;
+  }
+
+  for (i = 0; i < deps->count; i++)
+  {
+    if (strcmp(deps->items[i].path, path) == 0)
+    {
+      return;
+    }
+  }
+
+  hash = slab_hash(text, length, SLAB_HASH_SEED);
+  cache = deps->cache;
+  x_thread_mutex_lock(cache->lock);
+  x_hashtable_slab_hash_table_set(cache->file_hashes, path, hash);
+
+  if (deps->count == deps->capacity)
+  {
+    u32 capacity = deps->capacity ? deps->capacity * 2 : 8;
+
+    items = (SlabDep*)x_arena_alloc(cache->arena, sizeof(SlabDep) * capacity);
+    if (!items)
+    {
+      x_thread_mutex_unlock(cache->lock);
+      return;
+    }
+
+    if (deps->count)
+    {
+      memcpy(items, deps->items, sizeof(SlabDep) * deps->count);
+    }
+
+    deps->items = items;
+    deps->capacity = capacity;
+  }
+
+  deps->items[deps->count].path = x_arena_strdup(cache->arena, path);
+  deps->items[deps->count].hash = hash;
+  deps->count++;
+  x_thread_mutex_unlock(cache->lock);
+}
@@ -179,7 +179,8 @@ typedef enum SlabPageSortMode
   SLAB_PAGE_SORT_CATEGORY_DESC
 } SlabPageSortMode;
 
-static SlabPageSortMode s_page_sort_mode = SLAB_PAGE_SORT_NEWER;
+// Thread local: workers sort their own copies of all_pages concurrently
+static X_THREAD_LOCAL SlabPageSortMode s_page_sort_mode = SLAB_PAGE_SORT_NEWER;
 
 static int s_page_sort_compare_value(const void *pa, const void *pb)
 {
@@ -584,6 +585,8 @@ MiExecResult slab_cmd_template(MiContext *ctx, int argc, MiNode **argv)
 
   path = path_value.as.string;
   x_fs_path_from_slice(path, &path_cstr);
+  // Themes may be written with either separator
+  x_fs_path_normalize(&path_cstr);
 
   f = fopen(path_cstr.buf, "rb");
   if (!f)
@@ -641,6 +644,9 @@ MiExecResult slab_cmd_template(MiContext *ctx, int argc, MiNode **argv)
   fclose(f);
   file_buf[size] = '\0';
 
+  // Lets incremental builds re-render the page when this template changes
+  slab_render_deps_add((SlabRenderDeps*)ctx->host, path_cstr.buf, file_buf, size);
+
   sb = x_strbuilder_create();
   if (!sb)
   {
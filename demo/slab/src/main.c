@@ -1,7 +1,12 @@
 #include <stdx_common.h>
 
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+
 #define X_IMPL_ARENA
 #include <stdx_arena.h>
+#define X_IMPL_STRING
+#include <stdx_string.h>
 #define X_IMPL_IO
 #include <stdx_io.h>
 #define X_IMPL_STRBUILDER
@@ -14,269 +19,519 @@
 #include <stdx_log.h>
 #define X_IMPL_HASHTABLE
 #include <stdx_hashtable.h>
-#define X_IMPL_STRING
-#include <stdx_string.h>
 #define X_IMPL_ARRAY
 #include <stdx_array.h>
 #define X_IMPL_ARENA
 #include <stdx_arena.h>
+#define X_IMPL_TIME
+#include <stdx_time.h>
 #define MD_IMPL
 #include "markdown.h"
 
 #include "slab.h"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SLAB_WATCH_COALESCE_MS
+/**
+ * @brief How long a changed file must stay quiet before watch mode rebuilds.
+ * Can be overriden when compiling.
+ */
+#define SLAB_WATCH_COALESCE_MS 50
+#endif
+
+#ifndef SLAB_WATCH_POLL_MS
+/**
+ * @brief Watch mode sleep between polls while nothing changed.
+ * Can be overriden when compiling.
+ */
+#define SLAB_WATCH_POLL_MS 20
+#endif
+
+#define SLAB_WATCH_MAX_EVENTS 64
 
 MI_DEFINE_TYPE(Page);
 
-i32 slab_generate_site(const char* site_root)
+#ifndef SLAB_RENDER_ARENA_SIZE
+/**
+ * @brief Initial size of each render worker's scratch arena. It is reset
+ * between pages. Can be overriden when compiling.
+ */
+#define SLAB_RENDER_ARENA_SIZE (1024 * 1024 * 2)
+#endif
+
+/**
+ * Per-slot render state. Every worker owns its Minima context, arena and
+ * builder, and pulls page indices from a shared counter.
+ */
+typedef struct
 {
-  if (!x_fs_path_is_directory_cstr(site_root))
-  {
-    log_error("Site path not found: %s\n", site_root);
-    return 1;
-  }
+  SlabSite*       site;
+  SlabBuildCache* cache;
+  u64             site_hash;
+  volatile int32_t* next;
+  XArena*         arena;
+  XStrBuilder*    sb;
+  u32             rendered;
+  u32             up_to_date;
+  bool            failed;
+} SlabRenderWorker;
+
+static void s_slab_define_page_vars(MiContext* ctx, SlabSite* site, SlabPage* page)
+{
+  // 
+  // Exposes Config as variables
+  //
 
-  SlabConfig site_config;
-  slab_config_load(site_root, &site_config);
-  SlabSite* site = slab_site_create(1024 * 1024, &site_config);
+  mi_scope_define(ctx->global_scope, x_slice("site_url"),
+      mi_value_string(x_slice(site->config.site_url)));
 
-  XArena* rt_arena = x_arena_create(1024 * 1024 * 2);
-  XStrBuilder* sb = x_strbuilder_create();
+  mi_scope_define(ctx->global_scope, x_slice("site_name"),
+      mi_value_string(x_slice(site->config.site_name)));
 
-  // Collect metadata
-  x_log_info(NULL, "Processing site folder...");
-  slab_process_site(site);
-  x_log_info(NULL, "Generating pages...");
+  mi_scope_define(ctx->global_scope, x_slice("output_dir"),
+      mi_value_string(x_slice(site->config.output_dir.buf)));
 
-  i32 return_code = 0;
+  mi_scope_define(ctx->global_scope, x_slice("content_dir"),
+      mi_value_string(x_slice(site->config.content_dir.buf)));
 
-  // Process each page
-  for(u32 i = 0; i < site->page_count; i++)
-  {
-    XFSPath out_folder;
-    SlabPage* page = &site->pages[i]; 
-    x_fs_path(&out_folder, page->output_path);
-    x_fs_path_dirname(&out_folder, &out_folder);
-    x_fs_directory_create_recursive(out_folder.buf);
-    FILE* out = fopen(page->output_path, "w");
+  mi_scope_define(ctx->global_scope, x_slice("template_dir"),
+      mi_value_string(x_slice(site->config.template_dir.buf)));
 
-    if (!out)
+
+  //
+  // Exposes post frontmatter as variables
+  //
+
+  X_ASSERT(page->title != NULL);
+  X_ASSERT(page->date != NULL);
+  X_ASSERT(page->year);
+  X_ASSERT(page->month);
+  X_ASSERT(page->day);
+  X_ASSERT(page->slug != NULL);
+  X_ASSERT(page->tags != NULL);
+  X_ASSERT(page->author != NULL);
+  X_ASSERT(page->template_name != NULL);
+
+  mi_scope_define(ctx->global_scope, x_slice("post_title"),
+      mi_value_string(x_slice(page->title ? page->title : "")));
+
+  mi_scope_define(ctx->global_scope, x_slice("post_date"),
+      mi_value_string(x_slice(page->date ? page->date : "1900-01-01")));
+
+  mi_scope_define(ctx->global_scope, x_slice("post_year"),
+      mi_value_number(page->year ? page->year : 1900));
+
+  mi_scope_define(ctx->global_scope, x_slice("post_month"),
+      mi_value_number(page->month ? page->month : 1));
+
+  mi_scope_define(ctx->global_scope, x_slice("post_day"),
+      mi_value_number(page->day ? page->day : 1));
+
+  mi_scope_define(ctx->global_scope, x_slice("post_slug"),
+      mi_value_string(x_slice(page->slug ? page->slug : "")));
+
+  mi_scope_define(ctx->global_scope, x_slice("post_tags"),
+      mi_value_string(x_slice(page->tags ? page->tags : "")));
+
+  mi_scope_define(ctx->global_scope, x_slice("post_author"),
+      mi_value_string(x_slice(page->author ? page->author : "")));
+
+  mi_scope_define(ctx->global_scope, x_slice("post_template"),
+      mi_value_string(x_slice(page->template_name ? page->template_name : "")));
+
+  //
+  // Inject 'all_pages' variable
+  //
+  {
+    // Built per page: the sort command reorders it in place
+    MiValue all_pages = mi_value_list((i32)site->page_count);
+    for (size_t i = 0; i < site->page_count; i++)
     {
-      log_error("[FAIL] %s -> Failed to create file '%s'.\n", page->source_path, page->output_path);
-      return_code = 1;
-      continue;
+      MiValue mi_value = mi_value_Page(&site->pages[i]);
+      mi_call_cmd_list_push_value(all_pages, mi_value);
     }
+    mi_scope_define(ctx->global_scope, x_slice_from_cstr("all_pages"), all_pages);
+  }
 
-    MiContext ctx;
-    mi_context_init(&ctx, rt_arena, out, stderr);
-    if (! slab_register_mi_commands(&ctx) )
+  //
+  // Inject 'all_categories' variable
+  //
+  {
+    MiValue all_categories = mi_value_list((i32)site->category_count);
+    for (i32 i = 0; i < (i32)site->category_count; i++)
     {
-      log_error("[FAIL] %s -> Failed to register commands\n", page->source_path);
-      return_code = 1;
-      continue;
+      SlabCategory* category = &site->categories[i];
+      MiValue mi_value = mi_value_string(x_slice(category->name ? category->name : ""));
+      mi_call_cmd_list_push_value(all_categories, mi_value);
     }
+    mi_scope_define(ctx->global_scope, x_slice_from_cstr("all_categories"), all_categories);
+  }
+}
 
-    // 
-    // Exposes Config as variables
-    //
-
-    mi_scope_define(ctx.global_scope, x_slice("site_url"),
-        mi_value_string(x_slice(site->config.site_url)));
+/**
+ * Render one page into its output file. Returns false after logging the failure.
+ */
+static bool s_slab_render_page(SlabRenderWorker* worker, SlabPage* page, MiContext* ctx)
+{
+  SlabSite* site = worker->site;
 
-    mi_scope_define(ctx.global_scope, x_slice("site_name"),
-        mi_value_string(x_slice(site->config.site_name)));
+  if (! slab_register_mi_commands(ctx) )
+  {
+    log_error("[FAIL] %s -> Failed to register commands\n", page->source_path);
+    return false;
+  }
 
-    mi_scope_define(ctx.global_scope, x_slice("output_dir"),
-        mi_value_string(x_slice(site->config.output_dir.buf)));
+  // Template commands record what they read through the host pointer
+  SlabRenderDeps deps;
+  slab_render_deps_init(&deps, worker->cache);
+  ctx->host = &deps;
 
-    mi_scope_define(ctx.global_scope, x_slice("content_dir"),
-        mi_value_string(x_slice(site->config.content_dir.buf)));
+  s_slab_define_page_vars(ctx, site, page);
 
-    mi_scope_define(ctx.global_scope, x_slice("template_dir"),
-        mi_value_string(x_slice(site->config.template_dir.buf)));
+  size_t source_file_len = 0;
+  char* source_file = x_io_read_text(page->source_path, &source_file_len);
+  if(!source_file)
+  {
+    log_error("[FAIL] %s -> Failed to read contents file\n", page->source_path);
+    return false;
+  }
 
+  const char* post_body = source_file + page->meta.past_meta_offset;
+  const size_t post_body_len = source_file_len - page->meta.past_meta_offset;
 
-    //
-    // Exposes post frontmatter as variables
-    //
+  if (x_cstr_ends_with(page->source_path, ".md"))
+  {
+    char* markdown = md_to_html(post_body, post_body_len);
+    free(source_file);
+    source_file = markdown;
+    post_body = markdown;
+  }
 
-    X_ASSERT(page->title != NULL);
-    X_ASSERT(page->date != NULL);
-    X_ASSERT(page->year);
-    X_ASSERT(page->month);
-    X_ASSERT(page->day);
-    X_ASSERT(page->slug != NULL);
-    X_ASSERT(page->tags != NULL);
-    X_ASSERT(page->author != NULL);
-    X_ASSERT(page->template_name != NULL);
+  mi_scope_define(ctx->global_scope, x_slice("post_body"),
+      mi_value_string(x_slice(post_body)));
 
-    mi_scope_define(ctx.global_scope, x_slice("post_title"),
-        mi_value_string(x_slice(page->title ? page->title : "")));
+  // Append .html to template name
+  XSmallstr template_name;
+  x_smallstr_format(&template_name, "%s.html", page->template_name);
 
-    mi_scope_define(ctx.global_scope, x_slice("post_date"),
-        mi_value_string(x_slice(page->date ? page->date : "1900-01-01")));
+  // Compose full path to template file
+  size_t len;
+  XFSPath template_path;
+  x_fs_path(&template_path, site->config.template_dir.buf, "_layout", template_name.buf);
 
-    mi_scope_define(ctx.global_scope, x_slice("post_year"),
-        mi_value_number(page->year ? page->year : 1900));
+  if (!x_fs_path_is_file(&template_path))
+  {
+    log_error(
+        "[FAIL] %s -> layout not found '%s'\n",
+        page->source_path, template_path.buf);
+    free(source_file);
+    return false;
+  }
 
-    mi_scope_define(ctx.global_scope, x_slice("post_month"),
-        mi_value_number(page->month ? page->month : 1));
+  char* src = x_io_read_text(template_path.buf, &len);
+  if (!src)
+  {
+    log_error("[FAIL] %s -> Failed to read layout '%s'\n", page->source_path, template_path.buf);
+    free(source_file);
+    return false;
+  }
 
-    mi_scope_define(ctx.global_scope, x_slice("post_day"),
-        mi_value_number(page->day ? page->day : 1));
+  slab_render_deps_add(&deps, template_path.buf, src, len);
+  x_strbuilder_clear(worker->sb);
+  slab_expand_minima_template(x_slice_init(src, len), worker->sb);
+  free(src);
 
-    mi_scope_define(ctx.global_scope, x_slice("post_slug"),
-        mi_value_string(x_slice(page->slug ? page->slug : "")));
+  const char* expanded = x_strbuilder_to_string(worker->sb);
 
-    mi_scope_define(ctx.global_scope, x_slice("post_tags"),
-        mi_value_string(x_slice(page->tags ? page->tags : "")));
+  { // Execute page script
+    MiParseResult parse_result = mi_parse(worker->arena, x_slice(expanded));
 
-    mi_scope_define(ctx.global_scope, x_slice("post_author"),
-        mi_value_string(x_slice(page->author ? page->author : "")));
+    if (!parse_result.ok)
+    {
+      log_error("[FAIL] %s -> Parse error at %d:%d: %s\n",
+          page->source_path,
+          parse_result.error_line,
+          parse_result.error_column,
+          parse_result.error_message);
+      free(source_file);
+      return false;
+    }
 
-    mi_scope_define(ctx.global_scope, x_slice("post_template"),
-        mi_value_string(x_slice(page->template_name ? page->template_name : "")));
+    mi_compile(ctx, worker->arena, parse_result.root);
+    MiExecResult exec = mi_exec_block(ctx, parse_result.root, false);
 
-    size_t source_file_len = 0;
-    char* source_file = x_io_read_text(page->source_path, &source_file_len);
-    if(!source_file)
+    if (exec.signal == MI_SIGNAL_ERROR)
     {
-      log_error("[FAIL] %s -> Failed to read contents file\n", page->source_path);
-      return_code = 1;
-      fclose(out);
-      continue;
+      log_error("[FAIL] %s -> Runtime error at %s %d:%d: %s\n",
+          page->source_path,
+          ctx->error_source_file.buf,
+          ctx->error_line,
+          ctx->error_column,
+          ctx->error_message);
+      free(source_file);
+      return false;
     }
+  }
+
+  free(source_file);
 
-    const char* post_body = source_file + page->meta.past_meta_offset;
-    const size_t post_body_len = source_file_len - page->meta.past_meta_offset;
+  if (worker->cache)
+  {
+    slab_cache_record_page(worker->cache, page, &deps, worker->site_hash);
+  }
+
+  return true;
+}
+
+static void s_slab_render_worker(void* arg)
+{
+  SlabRenderWorker* worker = (SlabRenderWorker*)arg;
+  SlabSite* site = worker->site;
 
-    if (x_cstr_ends_with(page->source_path, ".md"))
+  for (;;)
+  {
+    i32 index = x_atomic_fetch_add_i32(worker->next, 1);
+    if (index >= (i32)site->page_count)
     {
-      char* markdown = md_to_html(post_body, post_body_len);
-      free(source_file);
-      source_file = markdown;
-      post_body = markdown;
+      break;
     }
 
-    mi_scope_define(ctx.global_scope, x_slice("post_body"),
-        mi_value_string(x_slice(post_body)));
+    XFSPath out_folder;
+    SlabPage* page = &site->pages[index];
 
-    //
-    // Inject 'all_pages' variable
-    //
+    if (worker->cache && slab_cache_page_fresh(worker->cache, page, worker->site_hash))
     {
-      MiValue all_pages = mi_value_list((i32)site->page_count);
-      for (i32 i = 0; i < site->page_count; i++)
-      {
-        MiValue mi_value = mi_value_Page(&site->pages[i]);
-        mi_call_cmd_list_push_value(all_pages, mi_value);
-      }
-      mi_scope_define(ctx.global_scope, x_slice_from_cstr("all_pages"), all_pages);
+      worker->up_to_date++;
+      continue;
     }
 
-    //
-    // Inject 'all_categories' variable
-    //
+    x_fs_path(&out_folder, page->output_path);
+    x_fs_path_dirname(&out_folder, &out_folder);
+    x_fs_directory_create_recursive(out_folder.buf);
+    FILE* out = fopen(page->output_path, "w");
+
+    if (!out)
     {
-      MiValue all_categories = mi_value_list((i32)site->category_count);
-      for (i32 i = 0; i < (i32)site->category_count; i++)
-      {
-        SlabCategory* category = &site->categories[i];
-        MiValue mi_value = mi_value_string(x_slice(category->name ? category->name : ""));
-        mi_call_cmd_list_push_value(all_categories, mi_value);
-      }
-      mi_scope_define(ctx.global_scope, x_slice_from_cstr("all_categories"), all_categories);
+      log_error("[FAIL] %s -> Failed to create file '%s'.\n", page->source_path, page->output_path);
+      worker->failed = true;
+      continue;
     }
 
-    // Append .html to template name
-    XSmallstr template_name;
-    x_smallstr_format(&template_name, "%s.html", page->template_name);
+    // Nothing a page allocates outlives it
+    x_arena_reset(worker->arena);
 
-    // Compose full path to template file
-    size_t len;
-    XFSPath template_path;
-    x_fs_path(&template_path, site_config.template_dir, "_layout", template_name.buf);
-    XSmallstr full_path;
-    x_smallstr_format(&full_path, "%s.html", template_path.buf);
+    MiContext ctx;
+    mi_context_init(&ctx, worker->arena, out, stderr);
 
-    if (!x_fs_path_is_file(&template_path))
+    if (s_slab_render_page(worker, page, &ctx))
     {
-      log_error(
-          "[FAIL] %s -> layout not found '%s'\n",
-          page->source_path, template_path.buf);
-      return_code = 1;
-      free(source_file);
-      fclose(out);
-      continue;
+      worker->rendered++;
+      log_info("[ OK ] generate %s -> %s\n", page->source_path, page->url);
+    }
+    else
+    {
+      worker->failed = true;
     }
 
-    const char* src = x_io_read_text(template_path.buf, &len);
-    x_strbuilder_clear(sb);
-    slab_expand_minima_template(x_slice_init(src, len), sb);
+    mi_context_term(&ctx);
+    fclose(out);
+  }
+}
+
+i32 slab_generate_site(const char* site_root, bool force, XThreadPool* pool, u32 jobs)
+{
+  if (!x_fs_path_is_directory_cstr(site_root))
+  {
+    log_error("Site path not found: %s\n", site_root);
+    return 1;
+  }
+
+  SlabConfig site_config;
+  slab_config_load(site_root, &site_config);
+  SlabSite* site = slab_site_create(1024 * 1024, &site_config, pool, jobs);
+  SlabBuildCache* cache = slab_cache_load(&site_config, force);
+  site->cache = cache;
 
-    const char* expanded = x_strbuilder_to_string(sb);
+  // Collect metadata
+  x_log_info(NULL, "Processing site folder...");
+  slab_process_site(site);
+  x_log_info(NULL, "Generating pages...");
 
-    { // Execute page script
-      MiParseResult parse_result = mi_parse(rt_arena, x_slice(expanded));
+  i32 return_code = 0;
+  u64 site_hash = slab_site_hash(site);
+  u32 rendered = 0;
+  u32 up_to_date = 0;
+  volatile int32_t next = 0;
 
-      if (!parse_result.ok)
-      {
-        log_error("[FAIL] %s -> Parse error at %d:%d: %s\n",
-            page->source_path,
-            parse_result.error_line,
-            parse_result.error_column,
-            parse_result.error_message);
-        return_code = 1;
-        free(source_file);
-        fclose(out);
-        continue;
-      }
+  SlabRenderWorker* workers = (SlabRenderWorker*)calloc(site->worker_count, sizeof(SlabRenderWorker));
+  X_ASSERT(workers != NULL);
+
+  for (u32 i = 0; i < site->worker_count; i++)
+  {
+    workers[i].site = site;
+    workers[i].cache = cache;
+    workers[i].site_hash = site_hash;
+    workers[i].next = &next;
+    workers[i].arena = x_arena_create(SLAB_RENDER_ARENA_SIZE);
+    workers[i].sb = x_strbuilder_create();
+  }
 
-      MiExecResult exec = mi_exec_block(&ctx, parse_result.root, false);
+  // Process each page
+  slab_run_workers(site, s_slab_render_worker, workers, sizeof(SlabRenderWorker));
 
-      if (exec.signal == MI_SIGNAL_ERROR)
-      {
-        log_error("[FAIL] %s -> Runtime error at %s %d:%d: %s\n",
-            page->source_path,
-            ctx.error_source_file.buf,
-            ctx.error_line,
-            ctx.error_column,
-            ctx.error_message);
-
-        return_code = 1;
-        free(source_file);
-        fclose(out);
-        continue;
-      }
-    }
+  for (u32 i = 0; i < site->worker_count; i++)
+  {
+    rendered += workers[i].rendered;
+    up_to_date += workers[i].up_to_date;
+    if (workers[i].failed)
+      return_code = 1;
 
-    free(source_file);
-    fclose(out);
-    log_info("[ OK ] generate %s -> %s\n", page->source_path, page->url);
+    x_strbuilder_destroy(workers[i].sb);
+    x_arena_destroy(workers[i].arena);
+  }
+
+  free(workers);
+
+  if (cache)
+  {
+    slab_cache_save(cache);
+    slab_cache_destroy(cache);
   }
 
   slab_site_destroy(site);
   slab_config_unload(&site_config);
 
-  x_log_info(NULL, "Done");
+  log_info("Done: %u pages generated, %u up to date\n", rendered, up_to_date);
+  return return_code;
+}
+
+static bool s_slab_path_has_prefix(const char* path, const char* prefix)
+{
+  size_t n = strlen(prefix);
+  return strncmp(path, prefix, n) == 0 && (path[n] == 0 || path[n] == '/' || path[n] == '\\');
+}
+
+/**
+ * Rebuild incrementally whenever something under the content or template
+ * directories changes. Changes under the output directory are our own writes.
+ */
+static i32 s_slab_watch_site(const char* site_root, bool force, XThreadPool* pool, u32 jobs)
+{
+  SlabConfig config;
+  XFSWatchSet* set;
+  XFSWatchEvent events[SLAB_WATCH_MAX_EVENTS];
+  i32 return_code;
+
+  return_code = slab_generate_site(site_root, force, pool, jobs);
+
+  if (!slab_config_load(site_root, &config))
+  {
+    return 1;
+  }
+
+  set = x_fs_watch_set_create(SLAB_WATCH_COALESCE_MS);
+  if (!set
+      || !x_fs_watch_set_add(set, config.content_dir.buf, true)
+      || !x_fs_watch_set_add(set, config.template_dir.buf, true)
+      || !x_fs_watch_set_add(set, site_root, false))
+  {
+    log_error("Failed to watch site folder %s\n", site_root);
+    x_fs_watch_set_destroy(set);
+    slab_config_unload(&config);
+    return 1;
+  }
+
+  log_info("Watching %s for changes. Press Ctrl+C to stop.\n", site_root);
+
+  for (;;)
+  {
+    i32 count = x_fs_watch_set_poll(set, events, SLAB_WATCH_MAX_EVENTS);
+    bool dirty = false;
+    XFSPath changed;
+
+    for (i32 i = 0; i < count; i++)
+    {
+      x_fs_path(&changed, events[i].filename);
+      x_fs_path_normalize(&changed);
+
+      if (!s_slab_path_has_prefix(changed.buf, config.output_dir.buf))
+      {
+        dirty = true;
+      }
+    }
+
+    if (!dirty)
+    {
+      x_thread_sleep_ms(SLAB_WATCH_POLL_MS);
+      continue;
+    }
+
+    XTimer timer;
+    x_timer_start(&timer);
+    return_code = slab_generate_site(site_root, false, pool, jobs);
+    log_info("Rebuilt in %.1f ms\n", x_time_milliseconds(x_timer_elapsed(&timer)));
+    fflush(stdout);
+  }
+
+  x_fs_watch_set_destroy(set);
+  slab_config_unload(&config);
   return return_code;
 }
 
 i32 main(i32 argc, char **argv)
 {
-  if (argc < 2)
+  bool watch = false;
+  bool force = false;
+  bool usage = false;
+  const char* site_root = NULL;
+  i32 jobs = x_cpu_info().logical_cpus;
+
+  for (i32 i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--watch") == 0)
+      watch = true;
+    else if (strcmp(argv[i], "--force") == 0)
+      force = true;
+    else if ((strcmp(argv[i], "--jobs") == 0 || strcmp(argv[i], "-j") == 0) && i + 1 < argc)
+      jobs = atoi(argv[++i]);
+    else if (!site_root)
+      site_root = argv[i];
+    else
+      usage = true;
+  }
+
+  if (usage || !site_root || jobs < 1)
   {
-    fprintf(stderr, "Usage: %s <site_root>\n", argv[0]);
+    fprintf(stderr, "Usage: %s <site_root> [--watch] [--force] [--jobs N]\n", argv[0]);
+    fprintf(stderr, "  --watch   Rebuild whenever content or templates change\n");
+    fprintf(stderr, "  --force   Ignore the build manifest and regenerate everything\n");
+    fprintf(stderr, "  --jobs N  Worker threads, the main thread included. Defaults to the CPU count\n");
     return 1;
   }
 
-  const char* site_root = argv[1];
   if (!x_fs_path_is_directory_cstr(site_root))
   {
     log_error("Site path not found: %s\n", site_root);
     return 1;
   }
 
-  return slab_generate_site(site_root);
+  // The calling thread takes part in every phase, so the pool gets one thread less
+  XThreadPool* pool = jobs > 1 ? x_threadpool_create(jobs - 1) : NULL;
+  if (jobs > 1 && !pool)
+  {
+    log_warning("Failed to start %d worker threads, building serially\n", jobs - 1);
+    jobs = 1;
+  }
+
+  i32 return_code = watch
+    ? s_slab_watch_site(site_root, force, pool, (u32)jobs)
+    : slab_generate_site(site_root, force, pool, (u32)jobs);
+
+  if (pool)
+    x_threadpool_destroy(pool);
+
+  return return_code;
 }
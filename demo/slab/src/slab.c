@@ -5,6 +5,8 @@
 #include <stdx_io.h>
 #include <stdx_log.h>
 
+#include <stdx_thread.h>
+
 #include "slab.h"
 #include "stdx_arena.h"
 
@@ -332,7 +334,8 @@ static void s_slab_path_to_url_separators(XFSPath* path)
 static bool s_slab_copy_file_to_output(
     SlabSite* site,
     const char* root_path,
-    const char* full_path
+    const char* full_path,
+    const XFSWalkEntry* dir_entry
     )
 {
   XFSPath relative_path;
@@ -346,9 +349,15 @@ static bool s_slab_copy_file_to_output(
   }
 
   x_fs_path_normalize(&relative_path);
-  x_fs_path(&output_path, site->config.output_dir, relative_path.buf);
+  x_fs_path(&output_path, site->config.output_dir.buf, relative_path.buf);
   x_fs_path_dirname(&output_path, &output_dir);
 
+  if (site->cache && slab_cache_asset_fresh(site->cache, full_path, output_path.buf,
+        dir_entry->size, dir_entry->last_modified))
+  {
+    return true;
+  }
+
   if (!x_fs_directory_create_recursive(output_dir.buf))
   {
     log_error("[FAIL] copy %s -> Failed to create output directory %s\n",
@@ -363,19 +372,25 @@ static bool s_slab_copy_file_to_output(
     return false;
   }
 
+  if (site->cache)
+  {
+    slab_cache_record_asset(site->cache, full_path, output_path.buf,
+        dir_entry->size, dir_entry->last_modified);
+  }
+
   log_info("[ OK ] copy %s -> %s\n", full_path, output_path.buf);
   return true;
 }
 
 static bool s_slab_build_page_defaults(
     SlabSite* site,
+    XArena* site_arena,
     SlabPage* page,
     const char* root_path,
     const char* full_path,
-    const XFSDireEntry* dir_entry
+    const XFSWalkEntry* dir_entry
     )
 {
-  XArena* site_arena = site->arena;
   XFSPath relative_path;
   XFSPath slug_path;
   XFSPath output_path;
@@ -400,7 +415,7 @@ static bool s_slab_build_page_defaults(
     page->slug = (char*)x_arena_strdup(site_arena, slug_path.buf);
   }
 
-  x_fs_path(&output_path, site->config.output_dir, page->slug);
+  x_fs_path(&output_path, site->config.output_dir.buf, page->slug);
   x_fs_path_change_extension(&output_path, "html");
   page->output_path = (char*)x_arena_strdup(site_arena, output_path.buf);
 
@@ -426,14 +441,17 @@ static bool s_slab_build_page_defaults(
   return true;
 }
 
+// Runs on any worker. Page strings go to the worker's arena and the page is
+// handed back instead of added to the site, so workers share nothing.
 static i32 s_slab_process_content_file(
     SlabSite* site,
+    XArena* site_arena,
     const char* root_path,
-    const char* current_path,
-    const XFSDireEntry* dir_entry
+    const XFSWalkEntry* dir_entry,
+    SlabPage* out_page,
+    bool* out_is_page
     )
 {
-  XArena* site_arena = site->arena;
   XFSPath full_path;
   SlabPage page = {0};
   char* buf;
@@ -443,15 +461,15 @@ static i32 s_slab_process_content_file(
   SlabFrontmatterParseResult status;
   u32 i;
 
-  x_fs_path(&full_path, current_path, dir_entry->name);
+  x_fs_path(&full_path, dir_entry->path);
   x_fs_path_normalize(&full_path);
 
   if (!s_slab_is_processable_content_file(dir_entry->name))
   {
-    return s_slab_copy_file_to_output(site, root_path, full_path.buf) ? 0 : 1;
+    return s_slab_copy_file_to_output(site, root_path, full_path.buf, dir_entry) ? 0 : 1;
   }
 
-  if (!s_slab_build_page_defaults(site, &page, root_path, full_path.buf, dir_entry))
+  if (!s_slab_build_page_defaults(site, site_arena, &page, root_path, full_path.buf, dir_entry))
   {
     return 1;
   }
@@ -463,13 +481,14 @@ static i32 s_slab_process_content_file(
     return 1;
   }
 
+  page.source_hash = slab_hash(buf, buf_size, SLAB_HASH_SEED);
   meta = &page.meta;
   input = x_slice_init(buf, buf_size);
   status = slab_frontammter_parse(&input, meta);
 
   if (status == SLAB_FRONTMATTER_MISSING)
   {
-    return s_slab_copy_file_to_output(site, root_path, full_path.buf) ? 0 : 1;
+    return s_slab_copy_file_to_output(site, root_path, full_path.buf, dir_entry) ? 0 : 1;
   }
 
   if (status != SLAB_FRONTMATTER_SUCCESS)
@@ -488,7 +507,7 @@ static i32 s_slab_process_content_file(
   {
     XFSPath output_path;
 
-    x_fs_path(&output_path, site->config.output_dir, page.slug);
+    x_fs_path(&output_path, site->config.output_dir.buf, page.slug);
     x_fs_path_change_extension(&output_path, "html");
 
     page.output_path = (char*)x_arena_strdup(site_arena, output_path.buf);
@@ -513,74 +532,190 @@ static i32 s_slab_process_content_file(
     }
   }
 
-  if (!s_slab_site_add_page(site, &page, site_arena))
-  {
-    log_error("Failed to register page %s\n", dir_entry->name);
-    return 1;
-  }
-
+  *out_page = page;
+  *out_is_page = true;
   log_info("[ OK ] parse %s -> %s\n", page.source_path, page.output_path);
   return 0;
 }
 
-static i32 s_slab_process_directory_metadata_recursive(SlabSite* site, const char* root_path, const char* current_path)
+typedef struct SlabScanItem
 {
-  XFSDireEntry dir_entry;
-  XFSDireHandle* handle;
-  i32 result = 0;
+  XFSWalkEntry entry;    // path is owned by the site arena
+  SlabPage page;
+  bool is_page;
+  i32 result;
+} SlabScanItem;
+
+typedef struct SlabScan
+{
+  SlabSite* site;
+  const char* root_path;
+  SlabScanItem* items;
+  size_t count;
+  size_t capacity;
+  volatile int32_t next;  // Next item a worker claims
+  i32 result;
+} SlabScan;
+
+typedef struct SlabScanWorker
+{
+  SlabScan* scan;
+  XArena* arena;
+} SlabScanWorker;
 
-  handle = x_fs_find_first_file(current_path, &dir_entry);
-  if (!handle)
+// We ignore anything that starts with '_' and hidden entries
+static bool s_slab_scan_filter(const XFSWalkEntry* entry, void* user)
+{
+  (void)user;
+  return entry->name[0] != '.' && entry->name[0] != '_';
+}
+
+// The walk only lists files; reading and parsing them happens on the workers
+static bool s_slab_scan_entry(const XFSWalkEntry* entry, void* user)
+{
+  SlabScan* scan = (SlabScan*)user;
+  SlabScanItem* item;
+  char* path;
+
+  if (entry->type == X_FS_ENTRY_DIRECTORY)
   {
-    log_error("Failed to scan directory %s\n", current_path);
-    return 1;
+    return true;
   }
 
-  do
+  if (scan->count == scan->capacity)
   {
-    if (strncmp(dir_entry.name, ".", 1) == 0 || strncmp(dir_entry.name, "..", 2) == 0 ||
-        x_cstr_starts_with(dir_entry.name, "_") // We ignore anything that starts with '_'
-       ) 
+    size_t capacity = scan->capacity ? scan->capacity * 2 : 64;
+    SlabScanItem* items = (SlabScanItem*)realloc(scan->items, capacity * sizeof(SlabScanItem));
+
+    if (!items)
     {
-      continue;
+      scan->result = 1;
+      return false;
     }
 
-    if (dir_entry.is_directory)
-    {
-      XFSPath child_path;
+    scan->items = items;
+    scan->capacity = capacity;
+  }
 
-      x_fs_path(&child_path, current_path, dir_entry.name);
-      x_fs_path_normalize(&child_path);
+  path = x_arena_strdup(scan->site->arena, entry->path);
+  if (!path)
+  {
+    scan->result = 1;
+    return false;
+  }
 
-      if (s_slab_process_directory_metadata_recursive(site, root_path, child_path.buf) != 0)
-      {
-        result = 1;
-      }
+  item = &scan->items[scan->count++];
+  memset(item, 0, sizeof(*item));
+  item->entry = *entry;
+  item->entry.path = path;
+  item->entry.name = path + (entry->name - entry->path);
+  return true;
+}
 
-      continue;
-    }
+static void s_slab_scan_worker(void* arg)
+{
+  SlabScanWorker* worker = (SlabScanWorker*)arg;
+  SlabScan* scan = worker->scan;
+  int32_t i;
+
+  while ((i = x_atomic_fetch_add_i32(&scan->next, 1)) < (int32_t)scan->count)
+  {
+    SlabScanItem* item = &scan->items[i];
+    item->result = s_slab_process_content_file(scan->site, worker->arena,
+        scan->root_path, &item->entry, &item->page, &item->is_page);
+  }
+}
+
+static i32 slab_process_directory_metadata(SlabSite* site, const char* path)
+{
+  SlabScan scan = {0};
+  SlabScanWorker* workers;
+  size_t i;
+
+  scan.site = site;
+  scan.root_path = path;
+
+  if (!x_fs_walk(path, X_FS_WALK_RECURSIVE | X_FS_WALK_STAT | X_FS_WALK_FOLLOW_SYMLINKS,
+        s_slab_scan_filter, s_slab_scan_entry, &scan, NULL))
+  {
+    log_error("Failed to scan directory %s\n", path);
+    free(scan.items);
+    return 1;
+  }
 
-    if (s_slab_process_content_file(site, root_path, current_path, &dir_entry) != 0)
+  workers = (SlabScanWorker*)x_arena_alloc(site->arena, sizeof(SlabScanWorker) * site->worker_count);
+  if (!workers)
+  {
+    free(scan.items);
+    return 1;
+  }
+
+  for (i = 0; i < site->worker_count; i++)
+  {
+    workers[i].scan = &scan;
+    workers[i].arena = site->worker_arenas[i];
+  }
+
+  slab_run_workers(site, s_slab_scan_worker, workers, sizeof(SlabScanWorker));
+
+  // Pages are registered in walk order, so the page list does not depend on scheduling
+  for (i = 0; i < scan.count; i++)
+  {
+    SlabScanItem* item = &scan.items[i];
+
+    scan.result |= item->result;
+
+    if (item->is_page && !s_slab_site_add_page(site, &item->page, site->arena))
     {
-      result = 1;
+      log_error("Failed to register page %s\n", item->entry.name);
+      scan.result = 1;
     }
   }
-  while (x_fs_find_next_file(handle, &dir_entry));
 
-  x_fs_find_close(handle);
-  return result;
+  free(scan.items);
+  return scan.result;
 }
 
-static i32 slab_process_directory_metadata(SlabSite* site, const char* path)
+/**
+ * Run `fn` once per worker slot and wait. Slot 0 runs on the calling thread
+ * when there is no pool, so a single worker build never touches threads.
+ */
+void slab_run_workers(SlabSite* site, XThreadTask fn, void* workers, size_t stride)
 {
-  return s_slab_process_directory_metadata_recursive(site, path, path);
+  XTaskGroup group;
+  u32 i;
+
+  if (!site->pool || site->worker_count <= 1)
+  {
+    fn(workers);
+    return;
+  }
+
+  x_taskgroup_init(&group, site->pool);
+
+  for (i = 0; i < site->worker_count; i++)
+  {
+    void* worker = (char*)workers + stride * i;
+
+    if (x_taskgroup_run(&group, fn, worker) != 0)
+    {
+      fn(worker);
+    }
+  }
+
+  x_taskgroup_wait(&group);
 }
 
 i32 slab_process_site(SlabSite* site)
 {
   i32 result = 0;
+
+  // The theme is processed first, so content assets still overwrite theme
+  // assets with the same output path
   result |= slab_process_directory_metadata(site, x_fs_path_cstr(&site->config.template_dir));
   result |= slab_process_directory_metadata(site, x_fs_path_cstr(&site->config.content_dir));
+
+  // Barrier: categories and everything after need the complete page list
   result |= s_slab_collect_categories(site);
   return result;
 }
@@ -750,7 +885,7 @@ void slab_config_unload(SlabConfig* config)
 /**
  * Site creation
  */
-SlabSite* slab_site_create(size_t arena_size, SlabConfig* config)
+SlabSite* slab_site_create(size_t arena_size, SlabConfig* config, XThreadPool* pool, u32 worker_count)
 {
   if (arena_size <= 0)
     return NULL;
@@ -763,6 +898,20 @@ SlabSite* slab_site_create(size_t arena_size, SlabConfig* config)
   SlabSite* site = x_arena_alloc_zero(arena, sizeof(SlabSite));
   site->arena = arena;
   site->config = *config;
+  site->pool = pool;
+  site->worker_count = (pool && worker_count > 1) ? worker_count : 1;
+  site->worker_arenas = (XArena**)x_arena_alloc_zero(arena, sizeof(XArena*) * site->worker_count);
+
+  for (u32 i = 0; i < site->worker_count; i++)
+  {
+    site->worker_arenas[i] = x_arena_create(arena_size);
+    if (!site->worker_arenas[i])
+    {
+      slab_site_destroy(site);
+      return NULL;
+    }
+  }
+
   return site;
 }
 
@@ -774,6 +923,12 @@ void slab_site_destroy(SlabSite* site)
   if (!site)
     return;
 
+  for (u32 i = 0; i < site->worker_count; i++)
+  {
+    if (site->worker_arenas && site->worker_arenas[i])
+      x_arena_destroy(site->worker_arenas[i]);
+  }
+
   x_arena_destroy(site->arena);
 }
 
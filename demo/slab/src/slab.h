@@ -6,12 +6,24 @@
 #include <stdx_string.h>
 #include <stdx_filesystem.h>
 #include <stdx_log.h>
+#include <stdx_hashtable.h>
+#include <stdx_thread.h>
 #include <minima.h>
 
 X_ARRAY_TYPE_NAMED(char*, cstr); // declares Xarray_cstr
 
 #define SLAB_FRONTMATTER_MAX_ENTRIES 32
 
+#ifndef SLAB_MANIFEST_FILE
+/**
+ * @brief Name of the build manifest kept in the output directory.
+ * Can be overriden before including this header.
+ */
+#define SLAB_MANIFEST_FILE ".slab_manifest"
+#endif
+
+#define SLAB_HASH_SEED 0xcbf29ce484222325ull  // FNV-1a offset basis, the seed for a fresh slab_hash()
+
 #define log_info(msg, ...)     x_log_raw(NULL, stdout, XLOG_LEVEL_INFO, XLOG_COLOR_WHITE, XLOG_COLOR_BLACK, XLOG_TIMESTAMP, msg, __VA_ARGS__, 0)
 #define log_warning(msg, ...)  x_log_raw(NULL, stdout, XLOG_LEVEL_WARNING, XLOG_COLOR_YELLOW, XLOG_COLOR_BLACK, XLOG_TIMESTAMP, msg, __VA_ARGS__, 0)
 #define log_error(msg, ...)    x_log_raw(NULL, stderr, XLOG_LEVEL_ERROR, XLOG_COLOR_RED, XLOG_COLOR_BLACK, XLOG_TIMESTAMP, msg, __VA_ARGS__, 0)
@@ -68,6 +80,7 @@ typedef struct SlabPage
   char* category;
   char* slug;
   SlabFrontmatter meta;              // Raw parsed meta block
+  u64 source_hash;                   // Content hash of the whole source file, frontmatter included
   bool draft;
 } SlabPage;
 
@@ -77,6 +90,8 @@ typedef struct SlabCategory
 } SlabCategory;
 
 
+typedef struct SlabBuildCache SlabBuildCache;
+
 typedef struct SlabSite
 {
   XArena*      arena;      // this arena provides memory for everything necessary
@@ -90,14 +105,88 @@ typedef struct SlabSite
   size_t        category_capacity;
 
   SlabConfig   config;
+  SlabBuildCache* cache;   // Optional. When set, unchanged assets are not copied again.
+
+  XThreadPool* pool;           // Optional. Without it every phase runs on the calling thread.
+  u32          worker_count;   // Worker slots per parallel phase, the calling thread included
+  XArena**     worker_arenas;  // One per slot. Page strings allocated during metadata collection live here.
 }
 SlabSite;
 
-SlabSite* slab_site_create(size_t arena_size, SlabConfig* config);                        // Create a Site
+SlabSite* slab_site_create(size_t arena_size, SlabConfig* config, XThreadPool* pool, u32 worker_count); // Create a Site
 void slab_site_destroy(SlabSite* site);                                                   // Destroy the Site
 bool slab_config_load(const char* site_root, SlabConfig* out_config);                     // Load configuration from site root
 void slab_config_unload(SlabConfig* config);                                              // Unload configuration
 i32 slab_process_site(SlabSite* site);  // Processes pages/posts from a directory
+void slab_run_workers(SlabSite* site, XThreadTask fn, void* workers, size_t stride);     // Run fn on every worker slot and wait
+
+//
+// Incremental builds
+//
+
+/**
+ * @brief One input read while producing an output.
+ */
+typedef struct SlabDep
+{
+  char* path;
+  u64   hash;
+} SlabDep;
+
+/**
+ * @brief What an output was built from, as recorded in the manifest.
+ */
+typedef struct SlabManifestEntry
+{
+  char*    output_path;
+  char*    source_path;
+  bool     is_page;      // Rendered page, otherwise a copied asset
+  u64      source_hash;  // Content hash of the page or asset source
+  u64      site_hash;    // slab_site_hash() the page was rendered against, 0 if it never lists other pages
+  u64      size;         // Asset only: source size when hashed
+  time_t   mtime;        // Asset only: source modification time when hashed
+  u32      dep_count;
+  SlabDep* deps;         // Layouts and included templates
+} SlabManifestEntry;
+
+X_HASHTABLE_TYPE_CSTR_KEY_NAMED(SlabManifestEntry*, slab_manifest_table)
+X_HASHTABLE_TYPE_CSTR_KEY_NAMED(u64, slab_hash_table)
+
+struct SlabBuildCache
+{
+  XArena* arena;
+  XFSPath manifest_path;
+  u64 config_hash;
+  XHashtable_slab_manifest_table* previous;  // Loaded from the manifest, keyed by output path
+  XHashtable_slab_manifest_table* current;   // Recorded by this build, keyed by output path
+  XHashtable_slab_hash_table* file_hashes;   // Dependency hashes, computed at most once per build
+  XMutex* lock;                              // Guards the tables and the arena; pages render on several workers
+};
+
+/**
+ * @brief Dependencies collected while rendering one page.
+ * Handed to template commands through MiContext::host.
+ */
+typedef struct SlabRenderDeps
+{
+  SlabBuildCache* cache;
+  SlabDep* items;
+  u32 count;
+  u32 capacity;
+  bool uses_site;  // The page's scripts mention all_pages or all_categories
+} SlabRenderDeps;
+
+u64 slab_site_hash(const SlabSite* site);                                                                  // Hash of every page's metadata and the category list
+u64 slab_hash(const void* data, size_t size, u64 seed);                                                   // 64-bit FNV-1a, chain by passing the previous result as seed
+SlabBuildCache* slab_cache_load(const SlabConfig* config, bool discard);                                  // Load the manifest from the output directory
+bool slab_cache_save(SlabBuildCache* cache);                                                              // Write what this build recorded
+void slab_cache_destroy(SlabBuildCache* cache);
+bool slab_cache_asset_fresh(SlabBuildCache* cache, const char* source, const char* output, u64 size, time_t mtime);  // True if the copy can be skipped
+void slab_cache_record_asset(SlabBuildCache* cache, const char* source, const char* output, u64 size, time_t mtime);
+bool slab_cache_page_fresh(SlabBuildCache* cache, const SlabPage* page, u64 site_hash);                  // True if the page can be skipped
+void slab_cache_record_page(SlabBuildCache* cache, const SlabPage* page, const SlabRenderDeps* deps, u64 site_hash);
+void slab_render_deps_init(SlabRenderDeps* deps, SlabBuildCache* cache);
+void slab_render_deps_add(SlabRenderDeps* deps, const char* path, const char* text, size_t length);       // Record a script the page read
 
 //
 // Template/minima code expansion
@@ -0,0 +1,233 @@
+/*
+   gzip.h — small single-pass gzip encoder for the webserver
+
+   Responses that are cached in memory are compressed once, when they are
+   loaded, so the encoder favours simplicity over ratio: greedy LZ77 over a
+   32 KB window with hash chains, emitted as one deflate block with the fixed
+   Huffman codes of RFC 1951. Text typically shrinks to a third or less;
+   the output is plain gzip (RFC 1952) that every browser accepts.
+
+   gzip_compress() returns false when the data does not get smaller, so
+   the caller simply keeps the identity body.
+*/
+
+#ifndef WS_GZIP_H
+#define WS_GZIP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GZIP_WINDOW_SIZE 32768
+#define GZIP_HASH_BITS 15
+#define GZIP_MAX_CHAIN 32           // candidates tried per position
+#define GZIP_MIN_MATCH 3
+#define GZIP_MAX_MATCH 258
+
+typedef struct
+{
+  uint8_t* out;
+  size_t len;
+  size_t cap;
+  uint32_t bits;
+  uint32_t bit_count;
+  bool overflow;
+} GzipWriter;
+
+static const uint16_t s_gzip_len_base[29] =
+{
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t s_gzip_len_extra[29] =
+{
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t s_gzip_dist_base[30] =
+{
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t s_gzip_dist_extra[30] =
+{
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+static void gzip_put_byte(GzipWriter* w, uint8_t b)
+{
+  if (w->len == w->cap)
+  {
+    w->overflow = true;
+    return;
+  }
+  w->out[w->len++] = b;
+}
+
+// Deflate packs values least significant bit first
+static void gzip_put_bits(GzipWriter* w, uint32_t value, uint32_t count)
+{
+  w->bits |= value << w->bit_count;
+  w->bit_count += count;
+  while (w->bit_count >= 8)
+  {
+    gzip_put_byte(w, (uint8_t) w->bits);
+    w->bits >>= 8;
+    w->bit_count -= 8;
+  }
+}
+
+// ...but Huffman codes most significant bit first
+static void gzip_put_code(GzipWriter* w, uint32_t code, uint32_t length)
+{
+  uint32_t reversed = 0;
+  for (uint32_t i = 0; i < length; i++)
+    reversed |= ((code >> i) & 1u) << (length - 1 - i);
+  gzip_put_bits(w, reversed, length);
+}
+
+static void gzip_put_litlen(GzipWriter* w, uint32_t symbol)
+{
+  if (symbol < 144)      gzip_put_code(w, 0x30 + symbol, 8);
+  else if (symbol < 256) gzip_put_code(w, 0x190 + symbol - 144, 9);
+  else if (symbol < 280) gzip_put_code(w, symbol - 256, 7);
+  else                   gzip_put_code(w, 0xC0 + symbol - 280, 8);
+}
+
+static void gzip_put_match(GzipWriter* w, uint32_t length, uint32_t distance)
+{
+  uint32_t l = 28;
+  while (s_gzip_len_base[l] > length) l--;
+  gzip_put_litlen(w, 257 + l);
+  gzip_put_bits(w, length - s_gzip_len_base[l], s_gzip_len_extra[l]);
+
+  uint32_t d = 29;
+  while (s_gzip_dist_base[d] > distance) d--;
+  gzip_put_code(w, d, 5);
+  gzip_put_bits(w, distance - s_gzip_dist_base[d], s_gzip_dist_extra[d]);
+}
+
+static void gzip_put_u32(GzipWriter* w, uint32_t v)
+{
+  for (int i = 0; i < 4; i++)
+    gzip_put_byte(w, (uint8_t) (v >> (8 * i)));
+}
+
+static uint32_t gzip_crc32(const uint8_t* data, size_t len)
+{
+  uint32_t table[256];
+  for (uint32_t i = 0; i < 256; i++)
+  {
+    uint32_t c = i;
+    for (int k = 0; k < 8; k++)
+      c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+    table[i] = c;
+  }
+
+  uint32_t crc = 0xFFFFFFFFu;
+  for (size_t i = 0; i < len; i++)
+    crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+  return crc ^ 0xFFFFFFFFu;
+}
+
+static uint32_t gzip_hash3(const uint8_t* p)
+{
+  uint32_t v = (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16);
+  return (v * 2654435761u) >> (32 - GZIP_HASH_BITS);
+}
+
+/*
+ * Compresses `len` bytes into a malloc'd gzip stream. Returns false, with
+ * nothing allocated, when it would not be smaller than the input.
+ */
+static bool gzip_compress(const void* data, size_t len, char** out, size_t* out_len)
+{
+  const uint8_t* src = (const uint8_t*) data;
+  GzipWriter w = {0};
+  w.cap = len;    // no point in output that isn't smaller
+  w.out = (uint8_t*) malloc(w.cap ? w.cap : 1);
+  int32_t* head = (int32_t*) malloc(sizeof(int32_t) << GZIP_HASH_BITS);
+  int32_t* prev = (int32_t*) malloc(sizeof(int32_t) * GZIP_WINDOW_SIZE);
+  if (!w.out || !head || !prev || len < 64)
+  {
+    free(w.out);
+    free(head);
+    free(prev);
+    return false;
+  }
+  memset(head, 0xFF, sizeof(int32_t) << GZIP_HASH_BITS);
+
+  static const uint8_t header[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 0xFF };
+  for (int i = 0; i < 10; i++)
+    gzip_put_byte(&w, header[i]);
+
+  gzip_put_bits(&w, 1, 1);    // final block
+  gzip_put_bits(&w, 1, 2);    // fixed Huffman codes
+
+  size_t pos = 0;
+  while (pos < len && !w.overflow)
+  {
+    uint32_t best_len = 0;
+    uint32_t best_dist = 0;
+
+    if (pos + GZIP_MIN_MATCH <= len)
+    {
+      uint32_t h = gzip_hash3(src + pos);
+      size_t max_len = len - pos < GZIP_MAX_MATCH ? len - pos : GZIP_MAX_MATCH;
+      int32_t candidate = head[h];
+      for (int chain = 0; candidate >= 0 && chain < GZIP_MAX_CHAIN; chain++)
+      {
+        size_t dist = pos - (size_t) candidate;
+        if (dist > GZIP_WINDOW_SIZE) break;
+        const uint8_t* a = src + candidate;
+        const uint8_t* b = src + pos;
+        uint32_t n = 0;
+        while (n < max_len && a[n] == b[n]) n++;
+        if (n > best_len)
+        {
+          best_len = n;
+          best_dist = (uint32_t) dist;
+          if (n == max_len) break;
+        }
+        int32_t next = prev[candidate % GZIP_WINDOW_SIZE];
+        if (next >= candidate) break;   // slot already reused by a newer position
+        candidate = next;
+      }
+    }
+
+    size_t advance = best_len >= GZIP_MIN_MATCH ? best_len : 1;
+    if (best_len >= GZIP_MIN_MATCH)
+      gzip_put_match(&w, best_len, best_dist);
+    else
+      gzip_put_litlen(&w, src[pos]);
+
+    // Every position covered enters the chains so later matches can find it
+    for (size_t end = pos + advance; pos < end; pos++)
+    {
+      if (pos + GZIP_MIN_MATCH > len) continue;
+      uint32_t h = gzip_hash3(src + pos);
+      prev[pos % GZIP_WINDOW_SIZE] = head[h];
+      head[h] = (int32_t) pos;
+    }
+  }
+
+  gzip_put_litlen(&w, 256);   // end of block
+  if (w.bit_count > 0) gzip_put_bits(&w, 0, 8 - w.bit_count);
+  gzip_put_u32(&w, gzip_crc32(src, len));
+  gzip_put_u32(&w, (uint32_t) len);
+
+  free(head);
+  free(prev);
+  if (w.overflow)
+  {
+    free(w.out);
+    return false;
+  }
+  *out = (char*) w.out;
+  *out_len = w.len;
+  return true;
+}
+
+#endif // WS_GZIP_H
@@ -0,0 +1,132 @@
+// Exercises the response cache through send_cached, without sockets.
+// webserver.c is compiled into this file so its static helpers are reachable.
+
+#define main webserver_main
+#include "webserver.c"
+#undef main
+
+#define X_IMPL_TEST
+#include <stdx_test.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#define BODY_REPEAT 64
+
+typedef struct
+{
+  char status[64];
+  char etag[64];
+  bool gzip;
+} Response;
+
+// Runs one GET for `entry` with the extra request `headers` and parses what was queued.
+static bool s_fetch(WSCacheEntry* entry, const char* headers, Response* out)
+{
+  char head[512];
+  int head_len = snprintf(head, sizeof(head), "GET /page.html HTTP/1.1\r\nHost: localhost\r\n%s\r\n", headers);
+  WSRequest req = { head, (size_t) head_len, "/page.html" };
+  WSConnection conn;
+  memset(&conn, 0, sizeof(conn));
+
+  entry->refs++;   // send_cached takes over one reference
+  send_cached(&conn, &req, entry);
+  memset(out, 0, sizeof(*out));
+  bool ok = conn.out_len > 0;
+  if (ok)
+  {
+    const char* eol = memchr(conn.out, '\r', conn.out_len);
+    size_t status_len = eol ? (size_t) (eol - conn.out) : 0;
+    snprintf(out->status, sizeof(out->status), "%.*s", (int) status_len, conn.out);
+    size_t etag_len;
+    const char* etag = header_get(conn.out, conn.out_len, "ETag", &etag_len);
+    if (etag) snprintf(out->etag, sizeof(out->etag), "%.*s", (int) etag_len, etag);
+    out->gzip = header_get(conn.out, conn.out_len, "Content-Encoding", &etag_len) != NULL;
+  }
+  free(conn.out);
+  return ok;
+}
+
+int test_gzip_variant_has_its_own_etag(void)
+{
+  char body[BODY_REPEAT * 16 + 1];
+  for (int i = 0; i < BODY_REPEAT; i++)
+    memcpy(body + i * 16, "<p>hello</p>\n   ", 16);
+  body[sizeof(body) - 1] = 0;
+
+  WSCacheEntry* entry = cache_entry_create("page.html", "text/html", "\"0123456789abcdef\"",
+      body, strlen(body), NULL, 0, true);
+  ASSERT_TRUE(entry != NULL);
+  ASSERT_TRUE(entry->gzip_body.length > 0);
+
+  Response identity, gzip;
+  ASSERT_TRUE(s_fetch(entry, "", &identity));
+  ASSERT_TRUE(s_fetch(entry, "Accept-Encoding: gzip\r\n", &gzip));
+  ASSERT_TRUE(strcmp(identity.status, "HTTP/1.1 200 OK") == 0);
+  ASSERT_TRUE(strcmp(gzip.status, "HTTP/1.1 200 OK") == 0);
+  ASSERT_FALSE(identity.gzip);
+  ASSERT_TRUE(gzip.gzip);
+  ASSERT_TRUE(strcmp(identity.etag, "\"0123456789abcdef\"") == 0);
+  ASSERT_TRUE(strcmp(gzip.etag, "\"0123456789abcdef-gz\"") == 0);
+
+  char headers[256];
+  Response r;
+
+  // Each ETag revalidates its own variant only
+  snprintf(headers, sizeof(headers), "If-None-Match: %s\r\n", identity.etag);
+  ASSERT_TRUE(s_fetch(entry, headers, &r));
+  ASSERT_TRUE(strcmp(r.status, "HTTP/1.1 304 Not Modified") == 0);
+  ASSERT_TRUE(strcmp(r.etag, identity.etag) == 0);
+
+  snprintf(headers, sizeof(headers), "Accept-Encoding: gzip\r\nIf-None-Match: %s\r\n", identity.etag);
+  ASSERT_TRUE(s_fetch(entry, headers, &r));
+  ASSERT_TRUE(strcmp(r.status, "HTTP/1.1 200 OK") == 0);
+  ASSERT_TRUE(r.gzip);
+
+  snprintf(headers, sizeof(headers), "Accept-Encoding: gzip\r\nIf-None-Match: %s\r\n", gzip.etag);
+  ASSERT_TRUE(s_fetch(entry, headers, &r));
+  ASSERT_TRUE(strcmp(r.status, "HTTP/1.1 304 Not Modified") == 0);
+  ASSERT_TRUE(strcmp(r.etag, gzip.etag) == 0);
+
+  snprintf(headers, sizeof(headers), "If-None-Match: %s\r\n", gzip.etag);
+  ASSERT_TRUE(s_fetch(entry, headers, &r));
+  ASSERT_TRUE(strcmp(r.status, "HTTP/1.1 200 OK") == 0);
+  ASSERT_FALSE(r.gzip);
+
+  // A list naming both matches whichever variant is served
+  snprintf(headers, sizeof(headers), "Accept-Encoding: gzip\r\nIf-None-Match: %s, W/%s\r\n", identity.etag, gzip.etag);
+  ASSERT_TRUE(s_fetch(entry, headers, &r));
+  ASSERT_TRUE(strcmp(r.etag, gzip.etag) == 0);
+  ASSERT_TRUE(strcmp(r.status, "HTTP/1.1 304 Not Modified") == 0);
+
+  cache_release(entry);
+  return 0;
+}
+
+int test_identity_only_entry_keeps_its_etag(void)
+{
+  const char* body = "\x89PNG not compressed";
+  WSCacheEntry* entry = cache_entry_create("logo.png", "image/png", "\"feed\"",
+      body, strlen(body), NULL, 0, false);
+  ASSERT_TRUE(entry != NULL);
+  ASSERT_EQ(entry->gzip_body.length, 0);
+
+  Response r;
+  ASSERT_TRUE(s_fetch(entry, "Accept-Encoding: gzip\r\nIf-None-Match: \"feed\"\r\n", &r));
+  ASSERT_TRUE(strcmp(r.status, "HTTP/1.1 304 Not Modified") == 0);
+  ASSERT_TRUE(strcmp(r.etag, "\"feed\"") == 0);
+
+  cache_release(entry);
+  return 0;
+}
+
+int main()
+{
+  STDXTestCase tests[] =
+  {
+    X_TEST(test_gzip_variant_has_its_own_etag),
+    X_TEST(test_identity_only_entry_keeps_its_etag),
+  };
+
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
+}
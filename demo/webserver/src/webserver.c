@@ -6,6 +6,10 @@
 #define X_IMPL_IO
 #define X_IMPL_LOG
 #define X_IMPL_INI
+#define X_IMPL_ARENA
+#define X_IMPL_STRBUILDER
+#define X_IMPL_TIME
+#define X_IMPL_PROFILE
 
 #include <stdx_string.h>
 #include <stdx_network.h>
@@ -14,8 +18,27 @@
 #include <stdx_ini.h>
 #include <stdx_io.h>
 #include <stdx_log.h>
+#include <stdx_arena.h>
+#include <stdx_strbuilder.h>
+#include <stdx_time.h>
+#include <stdx_profile.h>
+#include "gzip.h"
+
+#if !defined(_WIN32)
+#include <signal.h>
+#endif
 
 #define BUFFER_SIZE 8192
+#define REQUEST_BUFFER_SIZE (16 * 1024)  // pooled request buffer; heads beyond it are copied out to parse
+#define MAX_REQUEST_SIZE (64 * 1024)    // largest request head we accept
+#define MAX_EVENTS 256
+#define SWEEP_INTERVAL_MS 1000          // how often idle keep-alive connections are reaped
+#define ARENA_CHUNK_SIZE (16 * 1024)
+#define LISTEN_BACKLOG 1024
+#define MAX_URL_PATH 512
+#define WATCH_EVENTS 64
+#define MAX_MEMORY_BODY (256 * 1024)    // larger files are sent from an open descriptor
+#define INLINE_BODY_SIZE (4 * 1024)     // smaller cached bodies are copied behind their headers
 
 #define DEFAULT_CONFIG_FILE_NAME "config.ini"
 
@@ -41,18 +64,130 @@
   "</html>\n"
 
 
-typedef struct 
+typedef struct
 {
   const char* docroot;
   i32  port;
   bool list_dirs;
+  i32  threads;
+  i32  keepalive_ms;
+  i32  open_files;
+  i32  cache_kb;
+  i32  profile_seconds;         // 0 disables the profiler
+  const char* profile_trace;    // Chrome trace rewritten at every report, if set
 } WSConfig;
 
+typedef struct WSWorker WSWorker;
+typedef struct WSConnection WSConnection;
+typedef struct WSCacheEntry WSCacheEntry;
+
+/*
+ * A response ready to be sent, found by the request path it was served
+ * for. Small files and directory listings keep their body in memory, next
+ * to a gzip variant when compressing pays off; larger files keep an open
+ * descriptor and go out with x_net_send_file. The headers of each variant
+ * are built once, up to the Connection line. Connections sending from an
+ * entry hold a reference; an entry dropped from the cache while referenced
+ * is freed by the last release.
+ */
+struct WSCacheEntry
+{
+  char url[MAX_URL_PATH];   // request path, the lookup key
+  XFSPath path;             // normalized file or directory path, matched against watch events
+  uint32_t hash;
+  bool listing;
+  char etag[48];            // identity variant
+  char gzip_etag[52];       // gzip variant: etag with -gz inside the quotes
+  XSlice head;              // identity headers
+  XSlice gzip_head;         // headers of the gzip variant, when gzip_body is not empty
+  XSlice body;              // in-memory body, when file is NULL
+  XSlice gzip_body;
+  char* storage;            // holds the headers and bodies above
+  XFile* file;
+  uint64_t file_size;
+  size_t bytes;             // memory charged to the cache budget
+  i32 refs;
+  bool cached;              // still reachable from the cache
+  WSCacheEntry* bucket_next;
+  WSCacheEntry* lru_prev;   // most recently used first
+  WSCacheEntry* lru_next;
+};
+
+/*
+ * Per-worker LRU response cache, bounded by a byte budget for in-memory
+ * bodies and by a count of open descriptors. A recursive watch on the
+ * docroot drops entries whose file or directory changes, so a hit skips
+ * path resolution, stat and directory scans entirely.
+ */
+typedef struct
+{
+  WSCacheEntry** buckets;
+  u32 bucket_mask;
+  i32 count;
+  i32 open_files;
+  i32 max_open_files;
+  size_t bytes;
+  size_t max_bytes;
+  WSCacheEntry* lru_head;
+  WSCacheEntry* lru_tail;
+  XFSWatchSet* watch;       // NULL when caching is off
+} WSCache;
+
+/* One request head, as handed to the handlers. */
 typedef struct
 {
-  XSocket client;
-  WSConfig* config;
-} WSClientData;
+  const char* head;
+  size_t head_len;
+  const char* path;
+} WSRequest;
+
+/*
+ * One keep-alive connection. Connections are recycled through a per-worker
+ * free list, so the response buffer and the arena chunks of a closed
+ * connection serve the next one without touching the allocator. Request
+ * bytes live in pooled buffers that go back to the worker's pool as soon as
+ * they are parsed, so an idle connection holds none.
+ */
+struct WSConnection
+{
+  XSocket sock;
+  WSWorker* worker;
+  XArena* arena;          // per-request scratch, reset once the responses so far are flushed
+  XNetChain in;           // request bytes, may hold several pipelined requests
+  char* out;              // response bytes not yet sent
+  size_t out_len;
+  size_t out_sent;
+  size_t out_cap;
+  WSCacheEntry* body;     // response body sent after out, or NULL
+  XSlice body_mem;        // the variant being sent, when the body is in memory
+  uint64_t body_sent;
+  bool close_after;       // close once everything queued has been sent
+  bool want_write;        // write interest is armed
+  double last_active;
+  WSConnection* prev;
+  WSConnection* next;
+};
+
+struct WSWorker
+{
+  i32 id;
+  const WSConfig* config;
+  XNetLoop* loop;
+  XSocket listener;       // own SO_REUSEPORT socket, or the one shared socket when hand_off is set
+  bool hand_off;          // only worker 0 accepts and deals connections to the others
+  WSConnection* live;
+  WSConnection* free_list;
+  XMutex* inbox_lock;     // accepted sockets handed over by worker 0
+  XSocket* inbox;
+  i32 inbox_count;
+  i32 inbox_cap;
+  WSWorker* workers;      // all workers, for the hand-off path
+  i32 worker_count;
+  i32 next_worker;
+  WSCache cache;
+  XNetBufferPool* buffers;  // request buffers of every connection of this worker
+  XTask task;
+};
 
 const char* get_mime_type(const char* path)
 {
@@ -69,44 +204,502 @@ const char* get_mime_type(const char* path)
   return "application/octet-stream";
 }
 
-void send_response(XSocket client, int status, const char* content_type, const char* body, size_t body_len)
+static bool is_compressible(const char* mime)
+{
+  return strncmp(mime, "text/", 5) == 0 || strcmp(mime, "application/javascript") == 0;
+}
+
+static bool buffer_reserve(char** buf, size_t* cap, size_t needed)
+{
+  if (needed <= *cap) return true;
+  size_t new_cap = *cap ? *cap : BUFFER_SIZE;
+  while (new_cap < needed) new_cap *= 2;
+  char* p = (char*) realloc(*buf, new_cap);
+  if (!p) return false;
+  *buf = p;
+  *cap = new_cap;
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+// Response cache
+// ---------------------------------------------------------------------------
+
+static uint32_t hash_string(const char* s)
+{
+  uint32_t h = 2166136261u;
+  while (*s) h = (h ^ (uint8_t) *s++) * 16777619u;
+  return h;
+}
+
+static uint64_t hash_bytes(const char* p, size_t len)
+{
+  uint64_t h = 14695981039346656037ull;
+  for (size_t i = 0; i < len; i++) h = (h ^ (uint8_t) p[i]) * 1099511628211ull;
+  return h;
+}
+
+static bool cache_init(WSCache* cache, const WSConfig* config)
+{
+  memset(cache, 0, sizeof(*cache));
+  if (config->open_files <= 0 && config->cache_kb <= 0) return true;
+
+  // Without invalidation a cached response could be served stale forever
+  XFSPath root;
+  x_fs_path(&root, config->docroot);
+  x_fs_path_normalize(&root);
+  cache->watch = x_fs_watch_set_create(0);
+  if (!cache->watch || !x_fs_watch_set_add(cache->watch, x_fs_path_cstr(&root), true))
+  {
+    if (cache->watch) x_fs_watch_set_destroy(cache->watch);
+    cache->watch = NULL;
+    return false;
+  }
+
+  u32 buckets = 64;
+  while (buckets < (u32) config->open_files * 2) buckets *= 2;
+  cache->buckets = (WSCacheEntry**) calloc(buckets, sizeof(WSCacheEntry*));
+  if (!cache->buckets)
+  {
+    x_fs_watch_set_destroy(cache->watch);
+    cache->watch = NULL;
+    return false;
+  }
+  cache->bucket_mask = buckets - 1;
+  cache->max_open_files = config->open_files > 0 ? config->open_files : 0;
+  cache->max_bytes = config->cache_kb > 0 ? (size_t) config->cache_kb * 1024 : 0;
+  return true;
+}
+
+static void cache_release(WSCacheEntry* entry)
+{
+  if (--entry->refs > 0 || entry->cached) return;
+  if (entry->file) x_io_close(entry->file);
+  free(entry->storage);
+  free(entry);
+}
+
+static void cache_unlink(WSCache* cache, WSCacheEntry* entry)
+{
+  WSCacheEntry** link = &cache->buckets[entry->hash & cache->bucket_mask];
+  while (*link != entry) link = &(*link)->bucket_next;
+  *link = entry->bucket_next;
+
+  if (entry->lru_prev) entry->lru_prev->lru_next = entry->lru_next;
+  else cache->lru_head = entry->lru_next;
+  if (entry->lru_next) entry->lru_next->lru_prev = entry->lru_prev;
+  else cache->lru_tail = entry->lru_prev;
+
+  cache->count--;
+  cache->bytes -= entry->bytes;
+  if (entry->file) cache->open_files--;
+  entry->cached = false;
+  entry->refs++;
+  cache_release(entry);   // the cache's own reference
+}
+
+static void cache_push_front(WSCache* cache, WSCacheEntry* entry)
+{
+  entry->lru_prev = NULL;
+  entry->lru_next = cache->lru_head;
+  if (cache->lru_head) cache->lru_head->lru_prev = entry;
+  else cache->lru_tail = entry;
+  cache->lru_head = entry;
+}
+
+/* Returns a referenced entry for `url`, or NULL on a miss. */
+static WSCacheEntry* cache_lookup(WSCache* cache, const char* url)
 {
-  char header[1024];
+  if (cache->count == 0) return NULL;
+  uint32_t hash = hash_string(url);
+  for (WSCacheEntry* e = cache->buckets[hash & cache->bucket_mask]; e; e = e->bucket_next)
+  {
+    if (e->hash != hash || strcmp(e->url, url) != 0) continue;
+    if (cache->lru_head != e)
+    {
+      e->lru_prev->lru_next = e->lru_next;
+      if (e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+      else cache->lru_tail = e->lru_prev;
+      cache_push_front(cache, e);
+    }
+    e->refs++;
+    return e;
+  }
+  return NULL;
+}
+
+/*
+ * Remembers a freshly loaded entry under `url`, evicting from the cold end
+ * until it fits. Entries that can't fit are returned as they are and live
+ * only as long as the responses sending them.
+ */
+static WSCacheEntry* cache_insert(WSCache* cache, WSCacheEntry* entry, const char* url)
+{
+  size_t url_len = strlen(url);
+  if (!cache->watch || url_len >= sizeof(entry->url)) return entry;
+  if (entry->file ? cache->max_open_files == 0 : entry->bytes > cache->max_bytes) return entry;
+
+  while (cache->lru_tail
+      && (entry->file ? cache->open_files >= cache->max_open_files : cache->bytes + entry->bytes > cache->max_bytes))
+    cache_unlink(cache, cache->lru_tail);
+
+  memcpy(entry->url, url, url_len + 1);
+  entry->hash = hash_string(url);
+  WSCacheEntry** bucket = &cache->buckets[entry->hash & cache->bucket_mask];
+  entry->bucket_next = *bucket;
+  *bucket = entry;
+  cache_push_front(cache, entry);
+  entry->cached = true;
+  entry->refs++;
+  cache->count++;
+  cache->bytes += entry->bytes;
+  if (entry->file) cache->open_files++;
+  return entry;
+}
+
+/*
+ * Builds an entry for `path`: either an in-memory `body` (copied, plus a gzip
+ * variant when `compress` is set and it pays off) or an open `file`. The
+ * entry starts with one reference, owned by the caller.
+ */
+static WSCacheEntry* cache_entry_create(const char* path, const char* mime, const char* etag,
+    const char* body, size_t body_len, XFile* file, uint64_t file_size, bool compress)
+{
+  WSCacheEntry* entry = (WSCacheEntry*) calloc(1, sizeof(WSCacheEntry));
+  if (!entry) return NULL;
+
+  // Each representation gets its own strong validator
+  snprintf(entry->etag, sizeof(entry->etag), "%s", etag);
+  size_t etag_len = strlen(entry->etag);
+  if (etag_len >= 2 && entry->etag[etag_len - 1] == '"')
+    snprintf(entry->gzip_etag, sizeof(entry->gzip_etag), "%.*s-gz\"", (int) (etag_len - 1), entry->etag);
+  else
+    snprintf(entry->gzip_etag, sizeof(entry->gzip_etag), "%s-gz", entry->etag);
+
+  char* gzip = NULL;
+  size_t gzip_len = 0;
+  X_PROFILE_BEGIN("gzip_compress");
+  if (!file && compress && !gzip_compress(body, body_len, &gzip, &gzip_len))
+    gzip = NULL;
+  X_PROFILE_END();
+
+  const char* vary = compress ? "Vary: Accept-Encoding\r\n" : "";
+  char head[512];
+  char gzip_head[512];
+  int head_len = snprintf(head, sizeof(head),
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: %s\r\n"
+      "Content-Length: %llu\r\n"
+      "ETag: %s\r\n"
+      "%s",
+      mime, (unsigned long long) (file ? file_size : body_len), etag, vary);
+  int gzip_head_len = !gzip ? 0 : snprintf(gzip_head, sizeof(gzip_head),
+      "HTTP/1.1 200 OK\r\n"
+      "Content-Type: %s\r\n"
+      "Content-Length: %zu\r\n"
+      "Content-Encoding: gzip\r\n"
+      "ETag: %s\r\n"
+      "%s",
+      mime, gzip_len, entry->gzip_etag, vary);
+
+  size_t total = (size_t) head_len + (size_t) gzip_head_len + (file ? 0 : body_len) + gzip_len;
+  entry->storage = (char*) malloc(total ? total : 1);
+  if (!entry->storage)
+  {
+    free(gzip);
+    free(entry);
+    return NULL;
+  }
+
+  char* p = entry->storage;
+  memcpy(p, head, (size_t) head_len);
+  entry->head = x_slice_init(p, (size_t) head_len);
+  p += head_len;
+  memcpy(p, gzip_head, (size_t) gzip_head_len);
+  entry->gzip_head = x_slice_init(p, (size_t) gzip_head_len);
+  p += gzip_head_len;
+  if (!file)
+  {
+    memcpy(p, body, body_len);
+    entry->body = x_slice_init(p, body_len);
+    p += body_len;
+  }
+  if (gzip) memcpy(p, gzip, gzip_len);
+  entry->gzip_body = x_slice_init(p, gzip_len);
+  free(gzip);
+
+  x_fs_path(&entry->path, path);
+  entry->file = file;
+  entry->file_size = file_size;
+  entry->bytes = file ? 0 : sizeof(WSCacheEntry) + total;   // descriptors are counted, not weighed
+  entry->refs = 1;
+  return entry;
+}
+
+/*
+ * Loads `filepath` for `url`. Small files are read into memory, where they
+ * are compressed once; anything larger keeps an open descriptor. Returns a
+ * referenced entry, or NULL if the file can't be read.
+ */
+static WSCacheEntry* cache_load_file(WSCache* cache, const char* url, const char* filepath)
+{
+  FSFileStat st;
+  if (!x_fs_file_stat(filepath, &st)) return NULL;
+  XFile* file = x_io_open(filepath, "rb");
+  if (!file) return NULL;
+
+  const char* mime = get_mime_type(filepath);
+  char etag[48];
+  WSCacheEntry* entry = NULL;
+  size_t memory_limit = cache->max_bytes / 4 < MAX_MEMORY_BODY ? cache->max_bytes / 4 : MAX_MEMORY_BODY;
+
+  if (cache->watch && st.size <= memory_limit)
+  {
+    char* data = (char*) malloc(st.size ? st.size : 1);
+    if (data && x_io_read(file, data, st.size) == st.size)
+    {
+      // Strong validator: the content itself
+      snprintf(etag, sizeof(etag), "\"%016llx\"", (unsigned long long) hash_bytes(data, st.size));
+      entry = cache_entry_create(filepath, mime, etag, data, st.size, NULL, 0, is_compressible(mime));
+    }
+    free(data);
+    x_io_close(file);
+  }
+  else
+  {
+    snprintf(etag, sizeof(etag), "\"%llx-%llx\"", (unsigned long long) st.size, (unsigned long long) st.modification_time);
+    entry = cache_entry_create(filepath, mime, etag, NULL, 0, file, st.size, false);
+    if (!entry) x_io_close(file);
+  }
+
+  return entry ? cache_insert(cache, entry, url) : NULL;
+}
+
+/* True if `path` is `prefix` itself or lies below it, whatever the separators. */
+static bool path_is_within(const char* path, const char* prefix)
+{
+  while (*prefix)
+  {
+    char a = *path++, b = *prefix++;
+    if (a == '\\') a = '/';
+    if (b == '\\') b = '/';
+    if (a != b) return false;
+  }
+  return *path == 0 || *path == '/' || *path == '\\';
+}
+
+/*
+ * Drops every entry affected by a change to `path`: files at or below it,
+ * and listings of directories containing it. NULL drops everything.
+ */
+static void cache_invalidate(WSCache* cache, const char* path)
+{
+  WSCacheEntry* e = cache->lru_head;
+  while (e)
+  {
+    WSCacheEntry* next = e->lru_next;
+    const char* entry_path = x_fs_path_cstr(&e->path);
+    if (!path || path_is_within(entry_path, path) || (e->listing && path_is_within(path, entry_path)))
+      cache_unlink(cache, e);
+    e = next;
+  }
+}
+
+static void cache_poll(WSCache* cache)
+{
+  XFSWatchEvent events[WATCH_EVENTS];
+  i32 n;
+  do
+  {
+    n = x_fs_watch_set_poll(cache->watch, events, WATCH_EVENTS);
+    for (i32 i = 0; i < n; i++)
+      cache_invalidate(cache, events[i].action == x_fs_watch_UNKNOWN ? NULL : events[i].filename);
+  } while (n == WATCH_EVENTS);
+}
+
+// ---------------------------------------------------------------------------
+// Requests
+// ---------------------------------------------------------------------------
+
+static void queue_bytes(WSConnection* conn, const char* data, size_t len)
+{
+  if (!buffer_reserve(&conn->out, &conn->out_cap, conn->out_len + len))
+  {
+    conn->close_after = true;
+    return;
+  }
+  memcpy(conn->out + conn->out_len, data, len);
+  conn->out_len += len;
+}
+
+static void queue_header(WSConnection* conn, int status, const char* content_type, size_t body_len)
+{
+  char header[512];
   int len = snprintf(header, sizeof(header),
       "HTTP/1.1 %d OK\r\n"
       "Content-Type: %s\r\n"
       "Content-Length: %zu\r\n"
-      "Connection: close\r\n"
+      "Connection: %s\r\n"
       "\r\n",
-      status, content_type, body_len);
+      status, content_type, body_len, conn->close_after ? "close" : "keep-alive");
+  queue_bytes(conn, header, (size_t) len);
+}
 
-  x_net_send(client, header, len);
-  x_net_send(client, body, body_len);
+void send_response(WSConnection* conn, int status, const char* content_type, const char* body, size_t body_len)
+{
+  queue_header(conn, status, content_type, body_len);
+  queue_bytes(conn, body, body_len);
 }
 
-void send_file_response(XSocket client, const char* filepath)
+/* Returns the value of header `name`, or NULL when the request doesn't carry it. */
+static const char* header_get(const char* head, size_t head_len, const char* name, size_t* out_len)
 {
+  size_t name_len = strlen(name);
+  const char* end = head + head_len;
+  const char* line = memchr(head, '\n', head_len);
 
+  while (line && line + 1 < end)
+  {
+    line++;
+    const char* eol = memchr(line, '\n', (size_t)(end - line));
+    if (!eol) break;
+    if ((size_t)(eol - line) > name_len && line[name_len] == ':' && strncasecmp(line, name, name_len) == 0)
+    {
+      const char* v = line + name_len + 1;
+      while (v < eol && (*v == ' ' || *v == '\t')) v++;
+      const char* v_end = eol;
+      while (v_end > v && (v_end[-1] == '\r' || v_end[-1] == ' ')) v_end--;
+      *out_len = (size_t)(v_end - v);
+      return v;
+    }
+    line = eol;
+  }
+  return NULL;
+}
+
+static bool header_value_is(const char* head, size_t head_len, const char* name, const char* value)
+{
+  size_t len;
+  size_t value_len = strlen(value);
+  const char* v = header_get(head, head_len, name, &len);
+  return v && len >= value_len && strncasecmp(v, value, value_len) == 0;
+}
+
+static size_t header_content_length(const char* head, size_t head_len)
+{
+  const char* end = head + head_len;
+  for (const char* p = head; p + 15 < end; p++)
+  {
+    if ((p == head || p[-1] == '\n') && strncasecmp(p, "Content-Length:", 15) == 0)
+      return (size_t) strtoull(p + 15, NULL, 10);
+  }
+  return 0;
+}
+
+/* True if the comma separated If-None-Match list names `etag` or is "*". */
+static bool etag_in_list(const char* list, size_t len, const char* etag)
+{
+  size_t etag_len = strlen(etag);
+  const char* end = list + len;
+  const char* p = list;
+  while (p < end)
+  {
+    while (p < end && (*p == ' ' || *p == ',')) p++;
+    const char* item = p;
+    while (p < end && *p != ',') p++;
+    const char* item_end = p;
+    while (item_end > item && item_end[-1] == ' ') item_end--;
+    if (item_end - item >= 2 && item[0] == 'W' && item[1] == '/') item += 2;   // weak comparison
+    size_t item_len = (size_t)(item_end - item);
+    if ((item_len == 1 && *item == '*') || (item_len == etag_len && memcmp(item, etag, etag_len) == 0))
+      return true;
+  }
+  return false;
+}
+
+/* True if Accept-Encoding lists gzip without refusing it through q=0. */
+static bool accepts_gzip(const WSRequest* req)
+{
+  size_t len;
+  const char* v = header_get(req->head, req->head_len, "Accept-Encoding", &len);
+  if (!v) return false;
+  const char* end = v + len;
+  while (v < end)
+  {
+    while (v < end && (*v == ' ' || *v == ',')) v++;
+    const char* token = v;
+    while (v < end && *v != ',' && *v != ';' && *v != ' ') v++;
+    bool is_gzip = (v - token == 4 && strncasecmp(token, "gzip", 4) == 0);
+    bool refused = false;
+    while (v < end && *v != ',')
+    {
+      if (*v == 'q' && v + 1 < end && v[1] == '=')
+        refused = strtod(v + 2, NULL) <= 0.0;
+      v++;
+    }
+    if (is_gzip) return !refused;
+  }
+  return false;
+}
+
+/*
+ * Queues the response held by `entry` and takes over the reference:
+ * the gzip variant when the client takes it, otherwise the identity one,
+ * or a 304 when If-None-Match names the ETag of that variant. Small bodies
+ * are copied behind the headers so pipelined responses leave together;
+ * larger ones are sent from the entry.
+ */
+static void send_cached(WSConnection* conn, const WSRequest* req, WSCacheEntry* entry)
+{
+  const char* connection = conn->close_after ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n";
+  bool gzip = entry->gzip_body.length > 0 && accepts_gzip(req);
+  const char* etag = gzip ? entry->gzip_etag : entry->etag;
+  size_t len;
+  const char* if_none_match = header_get(req->head, req->head_len, "If-None-Match", &len);
+  if (if_none_match && etag_in_list(if_none_match, len, etag))
+  {
+    char header[256];
+    int n = snprintf(header, sizeof(header), "HTTP/1.1 304 Not Modified\r\nETag: %s\r\n%s", etag, connection);
+    queue_bytes(conn, header, (size_t) n);
+    cache_release(entry);
+    return;
+  }
+
+  XSlice head = gzip ? entry->gzip_head : entry->head;
+  queue_bytes(conn, head.ptr, head.length);
+  queue_bytes(conn, connection, strlen(connection));
+
+  XSlice body = gzip ? entry->gzip_body : entry->body;
+  if (!entry->file && body.length <= INLINE_BODY_SIZE)
+  {
+    queue_bytes(conn, body.ptr, body.length);
+    cache_release(entry);
+    return;
+  }
+  conn->body = entry;
+  conn->body_mem = body;
+  conn->body_sent = 0;
+}
+
+void send_file_response(WSConnection* conn, const WSRequest* req, const char* filepath)
+{
   if (!x_fs_path_is_file_cstr(filepath))
   {
     const char *not_found = HTML_ERROR_PAGE(404, "The page you are looking for was not found.");
-    send_response(client, 404, "text/plain", not_found, strlen(not_found));
+    send_response(conn, 404, "text/html", not_found, strlen(not_found));
     return;
   }
 
-  size_t size = 0;
-  const char* buffer = x_io_read_text(filepath, &size);
-
-  if (!buffer)
+  X_PROFILE_BEGIN("cache_load_file");
+  WSCacheEntry* entry = cache_load_file(&conn->worker->cache, req->path, filepath);
+  X_PROFILE_END();
+  if (!entry)
   {
     const char* err = "500 Internal Server Error";
-    send_response(client, 500, "text/plain", err, strlen(err));
+    send_response(conn, 500, "text/plain", err, strlen(err));
     return;
   }
-
-  const char* mime_type = get_mime_type(filepath);
-  send_response(client, 200, mime_type, buffer, size);
-  free((void*) buffer);
+  send_cached(conn, req, entry);
 }
 
 bool is_path_safe(const char* base_path, const char* requested_path)
@@ -122,74 +715,106 @@ bool is_path_safe(const char* base_path, const char* requested_path)
   return false;
 }
 
-void send_directory_listing(XSocket client, const char* dirpath, const char* url_path)
+void send_directory_listing(WSConnection* conn, const WSRequest* req, const char* dirpath)
 {
   XFSDireEntry entry;
   XFSDireHandle* handle = x_fs_find_first_file(dirpath, &entry);
   if (!handle)
   {
     const char* err = "500 Internal Server Error";
-    send_response(client, 500, "text/plain", err, strlen(err));
+    send_response(conn, 500, "text/plain", err, strlen(err));
     return;
   }
 
-  char html[BUFFER_SIZE];
-  size_t offset = snprintf(html, sizeof(html),
-      "<html><body><h1>Index of %s</h1><ul>", url_path);
+  // The listing is built in the connection arena and copied once into its cache entry
+  XAllocator allocator = x_arena_allocator(conn->arena);
+  XStrBuilder* html = x_strbuilder_create_with_allocator(&allocator);
+  x_strbuilder_append_format(html, "<html><body><h1>Index of %s</h1><ul>", req->path);
 
   do
   {
     if (strcmp(entry.name, ".") == 0 || strcmp(entry.name, "..") == 0) continue;
-    offset += snprintf(html + offset, sizeof(html) - offset,
-        "<li><a href=\"%s/%s\">%s</a></li>", url_path, entry.name, entry.name);
+    x_strbuilder_append_format(html, "<li><a href=\"%s/%s\">%s</a></li>", req->path, entry.name, entry.name);
   } while (x_fs_find_next_file(handle, &entry));
 
   x_fs_find_close(handle);
+  x_strbuilder_append(html, "</ul></body></html>");
 
-  offset += snprintf(html + offset, sizeof(html) - offset, "</ul></body></html>");
-  send_response(client, 200, "text/html", html, offset);
+  size_t len = x_strbuilder_length(html);
+  const char* text = x_strbuilder_to_string(html);
+  WSCacheEntry* listing = NULL;
+  if (text)
+  {
+    char etag[48];
+    snprintf(etag, sizeof(etag), "\"%016llx\"", (unsigned long long) hash_bytes(text, len));
+    listing = cache_entry_create(dirpath, "text/html", etag, text, len, NULL, 0, conn->worker->cache.watch != NULL);
+  }
+  if (!listing)
+  {
+    const char* err = "500 Internal Server Error";
+    send_response(conn, 500, "text/plain", err, strlen(err));
+    return;
+  }
+  listing->listing = true;
+  send_cached(conn, req, cache_insert(&conn->worker->cache, listing, req->path));
 }
 
-void handle_directory_request(XSocket client, const char* dirpath, const char* url_path)
+void handle_directory_request(WSConnection* conn, const WSRequest* req, const char* dirpath)
 {
-  char index_path[MAX_PATH];
-  snprintf(index_path, sizeof(index_path), "%s\\index.html", dirpath);
-  if (x_fs_path_exists_cstr(index_path) && x_fs_path_is_file_cstr(index_path))
+  XFSPath index_path;
+  x_fs_path(&index_path, dirpath, "index.html");
+  if (x_fs_path_is_file(&index_path))
   {
-    send_file_response(client, index_path);
-  } else
+    send_file_response(conn, req, x_fs_path_cstr(&index_path));
+  }
+  else if (conn->worker->config->list_dirs)
   {
-    send_directory_listing(client, dirpath, url_path);
+    send_directory_listing(conn, req, dirpath);
+  }
+  else
+  {
+    const char* forbidden = "403 Forbidden";
+    send_response(conn, 403, "text/html", forbidden, strlen(forbidden));
   }
 }
 
-void handle_client(const WSConfig* config, XSocket client)
+/*
+ * Handles one complete request head (up to and including the blank line)
+ * and queues its response.
+ */
+void handle_request(WSConnection* conn, const char* head, size_t head_len)
 {
-  if (!x_net_socket_is_valid(client))
+  const WSConfig* config = conn->worker->config;
+
+  // identify HTTP method
+  char method[8], path[MAX_URL_PATH], version[16];
+  if (sscanf(head, "%7s %511s %15s", method, path, version) != 3)
   {
-    x_log_fatal(NULL, "Invalid client socket");
+    conn->close_after = true;
+    const char* bad = "400 Bad Request";
+    send_response(conn, 400, "text/plain", bad, strlen(bad));
     return;
   }
 
-  char buffer[BUFFER_SIZE] =
-  {0};
-  size_t received = x_net_recv(client, buffer, sizeof(buffer) - 1);
-  x_log_info(NULL, "Received %zu bytes: %.*s", received, (int)received, buffer);
+  // HTTP/1.1 keeps the connection unless told otherwise; 1.0 only when asked to
+  if (strcmp(version, "HTTP/1.1") == 0)
+    conn->close_after = conn->close_after || header_value_is(head, head_len, "Connection", "close");
+  else
+    conn->close_after = conn->close_after || !header_value_is(head, head_len, "Connection", "keep-alive");
 
-  if (received <= 0)
+  if (strcmp(method, "GET") != 0)
   {
-    x_log_error(NULL, "No data received.\n");
+    const char* not_implemented = "501 Not Implemented";
+    send_response(conn, 501, "text/plain", not_implemented, strlen(not_implemented));
     return;
   }
 
-  // identify HTTP method
-  char method[8], path[512];
-  sscanf(buffer, "%7s %511s", method, path);
-
-  if (strcmp(method, "GET") != 0)
+  // Repeat requests are a hash lookup; path resolution and stat only run on a miss
+  WSRequest req = { head, head_len, path };
+  WSCacheEntry* cached = cache_lookup(&conn->worker->cache, path);
+  if (cached)
   {
-    const char* not_implemented = "501 Not Implemented";
-    send_response(client, 501, "text/plain", not_implemented, strlen(not_implemented));
+    send_cached(conn, &req, cached);
     return;
   }
 
@@ -201,38 +826,473 @@ void handle_client(const WSConfig* config, XSocket client)
   if (!is_path_safe(config->docroot, x_fs_path_cstr(&fullpath)))
   {
     const char* forbidden = "403 Forbidden";
-    send_response(client, 403, "text/html", forbidden, strlen(forbidden));
+    send_response(conn, 403, "text/html", forbidden, strlen(forbidden));
     return;
   }
 
   if (!x_fs_path_exists(&fullpath))
   {
     const char *not_found = HTML_ERROR_PAGE(404, "The page you are looking for was not found.");
-    send_response(client, 404, "text/html", not_found, strlen(not_found));
+    send_response(conn, 404, "text/html", not_found, strlen(not_found));
     return;
   }
 
   if (x_fs_path_is_directory(&fullpath))
   {
-    handle_directory_request(client, x_fs_path_cstr(&fullpath), path);
+    handle_directory_request(conn, &req, x_fs_path_cstr(&fullpath));
   }
   else
   {
-    send_file_response(client, x_fs_path_cstr(&fullpath));
+    send_file_response(conn, &req, x_fs_path_cstr(&fullpath));
   }
 }
 
-static void* client_thread(void* arg)
+// ---------------------------------------------------------------------------
+// Connections
+// ---------------------------------------------------------------------------
+
+static WSConnection* connection_open(WSWorker* worker, XSocket sock)
 {
-  WSClientData* data = ((WSClientData*)arg);
-  x_log_info(NULL, "client_thread started for doc_root = %s", data->config->docroot);
-  XSocket client = data->client;
-  handle_client(data->config, client);
-  x_net_close(client);
-  free(arg);
+  WSConnection* conn = worker->free_list;
+  if (conn)
+  {
+    worker->free_list = conn->next;
+  }
+  else
+  {
+    conn = (WSConnection*) calloc(1, sizeof(WSConnection));
+    if (!conn) return NULL;
+    conn->arena = x_arena_create(ARENA_CHUNK_SIZE);
+    if (!conn->arena)
+    {
+      free(conn);
+      return NULL;
+    }
+  }
+
+  conn->sock = sock;
+  conn->worker = worker;
+  memset(&conn->in, 0, sizeof(conn->in));
+  conn->out_len = 0;
+  conn->out_sent = 0;
+  conn->body = NULL;
+  conn->close_after = false;
+  conn->want_write = false;
+  conn->last_active = x_time_now().seconds;
+
+  if (!x_net_loop_add(worker->loop, sock, X_NET_LOOP_READ, conn))
+  {
+    conn->next = worker->free_list;
+    worker->free_list = conn;
+    return NULL;
+  }
+
+  conn->prev = NULL;
+  conn->next = worker->live;
+  if (worker->live) worker->live->prev = conn;
+  worker->live = conn;
+  return conn;
+}
+
+static void connection_close(WSConnection* conn)
+{
+  WSWorker* worker = conn->worker;
+  x_net_loop_remove(worker->loop, conn->sock);
+  x_net_close(conn->sock);
+
+  if (conn->body) cache_release(conn->body);
+  conn->body = NULL;
+  x_net_chain_release(&conn->in);
+  x_arena_reset_keep_head(conn->arena);
+
+  if (conn->prev) conn->prev->next = conn->next;
+  else worker->live = conn->next;
+  if (conn->next) conn->next->prev = conn->prev;
+
+  conn->next = worker->free_list;
+  worker->free_list = conn;
+}
+
+/*
+ * Sends as much of the queued output as the socket takes. Returns true when
+ * nothing is left. Returns false when the socket would block, with write
+ * interest armed, or when it failed, with the output dropped and
+ * close_after set.
+ */
+static bool connection_flush(WSConnection* conn)
+{
+  for (;;)
+  {
+    size_t pending = conn->out_len - conn->out_sent;
+    uint64_t body_pending = 0;
+    if (conn->body)
+      body_pending = (conn->body->file ? conn->body->file_size : conn->body_mem.length) - conn->body_sent;
+    if (pending + body_pending == 0) break;
+
+    if (!conn->body || !conn->body->file)
+    {
+      // Headers and an in-memory body leave in one gather send
+      XSlice parts[2];
+      size_t count = 0;
+      if (pending > 0)
+        parts[count++] = x_slice_init(conn->out + conn->out_sent, pending);
+      if (body_pending > 0)
+        parts[count++] = x_slice_init(conn->body_mem.ptr + conn->body_sent, (size_t) body_pending);
+
+      size_t sent = x_net_sendv(conn->sock, parts, count);
+      size_t from_out = sent < pending ? sent : pending;
+      conn->out_sent += from_out;
+      conn->body_sent += sent - from_out;
+      if (sent == pending + body_pending) continue;
+    }
+    else if (pending > 0)
+    {
+      // Headers first, then the file body without copying it through user memory
+      size_t sent = x_net_send(conn->sock, conn->out + conn->out_sent, pending);
+      if (sent != (size_t) -1 && sent > 0)
+      {
+        conn->out_sent += sent;
+        continue;
+      }
+    }
+    else
+    {
+      size_t chunk = body_pending < SIZE_MAX ? (size_t) body_pending : SIZE_MAX;
+      size_t sent = x_net_send_file(conn->sock, conn->body->file, conn->body_sent, chunk);
+      conn->body_sent += sent;
+      if (sent == chunk) continue;
+    }
+
+    if (!x_net_would_block())
+    {
+      conn->close_after = true;
+      conn->out_len = 0;
+      conn->out_sent = 0;
+      if (conn->body) cache_release(conn->body);
+      conn->body = NULL;
+      return false;
+    }
+    if (!conn->want_write)
+    {
+      conn->want_write = true;
+      x_net_loop_modify(conn->worker->loop, conn->sock, X_NET_LOOP_READ | X_NET_LOOP_WRITE, conn);
+    }
+    return false;
+  }
+
+  conn->out_len = 0;
+  conn->out_sent = 0;
+  if (conn->body)
+  {
+    cache_release(conn->body);
+    conn->body = NULL;
+  }
+  x_arena_reset_keep_head(conn->arena);
+
+  if (conn->want_write)
+  {
+    conn->want_write = false;
+    x_net_loop_modify(conn->worker->loop, conn->sock, X_NET_LOOP_READ, conn);
+  }
+  return true;
+}
+
+static bool connection_has_output(const WSConnection* conn)
+{
+  return conn->out_len > conn->out_sent || conn->body != NULL;
+}
+
+/* Returns one past the blank line ending a request head, or NULL if it hasn't arrived yet. */
+static const char* find_head_end(const char* start, size_t avail)
+{
+  for (size_t i = 3; i < avail; i++)
+  {
+    if (start[i] == '\n' && start[i - 1] == '\r' && start[i - 2] == '\n' && start[i - 3] == '\r')
+      return start + i + 1;
+  }
   return NULL;
 }
 
+/*
+ * Handles every complete request in the input buffer. Responses to
+ * pipelined requests accumulate in the output buffer and go out together;
+ * a large body is flushed before the next request is looked at, and
+ * nothing more is parsed while the socket is not taking data.
+ * Returns false if the connection was closed.
+ */
+static bool connection_process(WSConnection* conn)
+{
+  bool blocked = false;
+  bool incomplete = false;
+
+  while (!conn->close_after)
+  {
+    if ((conn->body || conn->out_len >= BUFFER_SIZE) && !connection_flush(conn))
+    {
+      blocked = true;
+      break;
+    }
+
+    // A request head normally sits inside one buffer and is parsed in place;
+    // one straddling a buffer boundary is copied out into the arena first
+    XNetBuffer* first = conn->in.head;
+    const char* start = first ? first->data + first->start : NULL;
+    size_t avail = first ? first->end - first->start : 0;
+    const char* end = find_head_end(start, avail);
+    if (!end && conn->in.length > avail)
+    {
+      avail = conn->in.length < MAX_REQUEST_SIZE ? conn->in.length : MAX_REQUEST_SIZE;
+      char* flat = (char*) x_arena_alloc(conn->arena, avail);
+      if (!flat)
+      {
+        connection_close(conn);
+        return false;
+      }
+      x_net_chain_copy(&conn->in, flat, avail);
+      start = flat;
+      end = find_head_end(start, avail);
+    }
+
+    size_t head_len = end ? (size_t)(end - start) : 0;
+    size_t body_len = end ? header_content_length(start, head_len) : 0;
+    if (!end || head_len + body_len > conn->in.length)
+    {
+      incomplete = true;    // the rest of the request is still arriving
+      break;
+    }
+
+    X_PROFILE_BEGIN("handle_request");
+    handle_request(conn, start, head_len);
+    X_PROFILE_END();
+    x_net_chain_consume(&conn->in, head_len + body_len);
+  }
+
+  if (incomplete && conn->in.length >= MAX_REQUEST_SIZE)
+  {
+    conn->close_after = true;
+    const char* too_large = "431 Request Header Fields Too Large";
+    send_response(conn, 431, "text/plain", too_large, strlen(too_large));
+  }
+
+  if (!blocked && !connection_flush(conn) && connection_has_output(conn))
+    return true;    // waiting for write readiness
+
+  if (conn->close_after && !connection_has_output(conn))
+  {
+    connection_close(conn);
+    return false;
+  }
+  return true;
+}
+
+static void connection_on_event(WSConnection* conn, uint32_t events)
+{
+  conn->last_active = x_time_now().seconds;
+
+  if (events & X_NET_LOOP_ERROR)
+  {
+    connection_close(conn);
+    return;
+  }
+
+  if (connection_has_output(conn))
+  {
+    if (!connection_flush(conn))
+    {
+      if (!connection_has_output(conn)) connection_close(conn);   // send failed
+      return;
+    }
+    // Output is gone: pick up pipelined requests that waited behind it
+    if (!connection_process(conn)) return;
+  }
+
+  // Edge-triggered: read until the socket is drained
+  for (;;)
+  {
+    size_t received = x_net_recv_chain(conn->sock, conn->worker->buffers, &conn->in);
+    if (received == (size_t) -1 && x_net_would_block()) break;
+    if (received == 0 || received == (size_t) -1)
+    {
+      connection_close(conn);
+      return;
+    }
+
+    if (conn->in.length >= MAX_REQUEST_SIZE)
+    {
+      // Make room before reading more; stop if responses are backing up
+      if (!connection_process(conn)) return;
+      if (connection_has_output(conn)) return;
+    }
+  }
+
+  connection_process(conn);
+}
+
+static void worker_sweep_idle(WSWorker* worker)
+{
+  double now = x_time_now().seconds;
+  double limit = worker->config->keepalive_ms / 1000.0;
+  WSConnection* conn = worker->live;
+  while (conn)
+  {
+    WSConnection* next = conn->next;
+    if (now - conn->last_active > limit) connection_close(conn);
+    conn = next;
+  }
+}
+
+// ---------------------------------------------------------------------------
+// Workers
+// ---------------------------------------------------------------------------
+
+static XSocket open_listener(const WSConfig* config, bool reuse_port)
+{
+  XSocket server = x_net_socket_tcp4();
+  if (!x_net_socket_is_valid(server)) return INVALID_SOCKET;
+
+  x_net_set_reuse_addr(server, true);
+  if (reuse_port && !x_net_set_reuse_port(server, true))
+  {
+    x_net_close(server);
+    return INVALID_SOCKET;
+  }
+
+  if (!x_net_bind_any(server, X_NET_AF_IPV4, (uint16_t) config->port)
+      || !x_net_listen(server, LISTEN_BACKLOG)
+      || x_net_set_nonblocking(server, 1) != 0)
+  {
+    x_net_close(server);
+    return INVALID_SOCKET;
+  }
+  return server;
+}
+
+static void worker_accept(WSWorker* worker)
+{
+  for (;;)
+  {
+    XAddress client_addr;
+    XSocket client = x_net_accept(worker->listener, &client_addr);
+    if (!x_net_socket_is_valid(client)) break;
+    x_net_set_nonblocking(client, 1);
+
+    // Without SO_REUSEPORT only worker 0 listens and deals connections round-robin
+    WSWorker* target = worker;
+    if (worker->hand_off)
+    {
+      target = &worker->workers[worker->next_worker];
+      worker->next_worker = (worker->next_worker + 1) % worker->worker_count;
+    }
+
+    if (target == worker)
+    {
+      if (!connection_open(worker, client)) x_net_close(client);
+      continue;
+    }
+
+    x_thread_mutex_lock(target->inbox_lock);
+    if (target->inbox_count == target->inbox_cap)
+    {
+      i32 cap = target->inbox_cap ? target->inbox_cap * 2 : 64;
+      XSocket* inbox = (XSocket*) realloc(target->inbox, sizeof(XSocket) * (size_t) cap);
+      if (!inbox)
+      {
+        x_thread_mutex_unlock(target->inbox_lock);
+        x_net_close(client);
+        continue;
+      }
+      target->inbox = inbox;
+      target->inbox_cap = cap;
+    }
+    target->inbox[target->inbox_count++] = client;
+    x_thread_mutex_unlock(target->inbox_lock);
+    x_net_loop_wake(target->loop);
+  }
+}
+
+static void worker_drain_inbox(WSWorker* worker)
+{
+  x_thread_mutex_lock(worker->inbox_lock);
+  for (i32 i = 0; i < worker->inbox_count; i++)
+  {
+    if (!connection_open(worker, worker->inbox[i])) x_net_close(worker->inbox[i]);
+  }
+  worker->inbox_count = 0;
+  x_thread_mutex_unlock(worker->inbox_lock);
+}
+
+static void worker_run(void* arg)
+{
+  WSWorker* worker = (WSWorker*) arg;
+  XNetEvent events[MAX_EVENTS];
+  double last_sweep = x_time_now().seconds;
+  double last_report = last_sweep;
+  char name[32];
+  snprintf(name, sizeof(name), "worker %d", worker->id);
+  x_profile_set_thread_name(name);
+
+  if ((!worker->hand_off || worker->id == 0) && !x_net_loop_add(worker->loop, worker->listener, X_NET_LOOP_READ, NULL))
+  {
+    x_log_error(NULL, "Worker %d failed to watch its listening socket", worker->id);
+    return;
+  }
+
+#if !defined(_WIN32)
+  // The inotify descriptor sits in the loop next to the sockets; Windows polls on the sweep instead
+  if (worker->cache.watch
+      && !x_net_loop_add(worker->loop, (XSocket) x_fs_watch_set_handle(worker->cache.watch), X_NET_LOOP_READ, &worker->cache))
+  {
+    x_log_error(NULL, "Worker %d failed to watch the docroot", worker->id);
+    return;
+  }
+#endif
+
+  while (1)
+  {
+    i32 n = x_net_loop_wait(worker->loop, events, MAX_EVENTS, SWEEP_INTERVAL_MS);
+    if (n < 0)
+    {
+      x_log_error(NULL, "Worker %d: event loop failed", worker->id);
+      break;
+    }
+
+    for (i32 i = 0; i < n; i++)
+    {
+      if (events[i].user == NULL)
+        worker_accept(worker);
+      else if (events[i].user == &worker->cache)
+        cache_poll(&worker->cache);
+      else
+      {
+        X_PROFILE_BEGIN("connection_on_event");
+        connection_on_event((WSConnection*) events[i].user, events[i].events);
+        X_PROFILE_END();
+      }
+    }
+    worker_drain_inbox(worker);
+
+    double now = x_time_now().seconds;
+    if ((now - last_sweep) * 1000.0 >= SWEEP_INTERVAL_MS)
+    {
+      worker_sweep_idle(worker);
+#if defined(_WIN32)
+      if (worker->cache.watch) cache_poll(&worker->cache);
+#endif
+      last_sweep = now;
+    }
+
+    const WSConfig* config = worker->config;
+    if (worker->id == 0 && config->profile_seconds > 0 && now - last_report >= config->profile_seconds)
+    {
+      x_profile_report(stdout);
+      fflush(stdout);
+      if (config->profile_trace && !x_profile_write_chrome_trace(config->profile_trace))
+        x_log_warning(NULL, "Failed to write the profile trace '%s'", config->profile_trace);
+      last_report = now;
+    }
+  }
+}
+
 int main()
 {
   XFSPath cwd;
@@ -241,9 +1301,24 @@ int main()
   x_log_info(NULL, "running from %.*s", cwd.length, cwd.buf);
 
   WSConfig config = {0};
-  config.port = 8080;
-  config.docroot = "./";
-  config.list_dirs = false;
+  config.port = 80;
+  config.threads = 4;
+  config.keepalive_ms = 15000;
+  config.open_files = 256;
+  config.cache_kb = 16384;
+
+  static const XIniField config_fields[] =
+  {
+    X_INI_FIELD("webserver", "port",            XINI_FIELD_I32,  WSConfig, port),
+    X_INI_FIELD("webserver", "docroot",         XINI_FIELD_STR,  WSConfig, docroot),
+    X_INI_FIELD("webserver", "list_dirs",       XINI_FIELD_BOOL, WSConfig, list_dirs),
+    X_INI_FIELD("webserver", "threads",         XINI_FIELD_I32,  WSConfig, threads),
+    X_INI_FIELD("webserver", "keepalive_ms",    XINI_FIELD_I32,  WSConfig, keepalive_ms),
+    X_INI_FIELD("webserver", "open_files",      XINI_FIELD_I32,  WSConfig, open_files),
+    X_INI_FIELD("webserver", "cache_kb",        XINI_FIELD_I32,  WSConfig, cache_kb),
+    X_INI_FIELD("webserver", "profile_seconds", XINI_FIELD_I32,  WSConfig, profile_seconds),
+    X_INI_FIELD("webserver", "profile_trace",   XINI_FIELD_STR,  WSConfig, profile_trace),
+  };
 
   XIni ini;
   XIniError iniError;
@@ -258,9 +1333,11 @@ int main()
     x_log_error(NULL, "Using default settings.");
   }
 
-  config.port = x_ini_get_i32(&ini, "webserver", "port", 80);
-  config.docroot = x_ini_get(&ini, "webserver", "docroot", NULL);
-  config.list_dirs = x_ini_get_bool(&ini, "webserver", "list_dirs", false);
+  x_ini_bind(&ini, config_fields, (int)(sizeof(config_fields) / sizeof(config_fields[0])), &config);
+  if (config.threads < 1) config.threads = 1;
+
+  if (config.profile_seconds > 0 && !x_profile_init(X_PROFILE_DEFAULT_EVENTS))
+    x_log_warning(NULL, "Failed to start the profiler.");
 
   if (! x_fs_is_directory(config.docroot))
   {
@@ -274,46 +1351,92 @@ int main()
     return 1;
   }
 
-  XSocket server = x_net_socket_tcp4();
-  if (!x_net_socket_is_valid(server))
+#if !defined(_WIN32)
+  // sendfile() has no MSG_NOSIGNAL; a client hanging up mid-body must not kill the server
+  signal(SIGPIPE, SIG_IGN);
+#endif
+
+  WSWorker* workers = (WSWorker*) calloc((size_t) config.threads, sizeof(WSWorker));
+  if (!workers)
   {
-    fprintf(stderr, "Failed to create socket.");
+    x_log_fatal(NULL, "Out of memory.");
     return 1;
   }
 
-  if (!x_net_bind_any(server, X_NET_AF_IPV4, (uint16_t) config.port) || !x_net_listen(server, 10))
+  for (i32 i = 0; i < config.threads; i++)
   {
-    fprintf(stderr, "Failed to bind/listen on port %d.", config.port);
-    return 1;
+    WSWorker* w = &workers[i];
+    w->id = i;
+    w->config = &config;
+    w->workers = workers;
+    w->worker_count = config.threads;
+    w->listener = INVALID_SOCKET;
+    w->loop = x_net_loop_create(MAX_EVENTS);
+    w->buffers = x_net_buffer_pool_create(REQUEST_BUFFER_SIZE, 0);
+    if (!w->loop || !w->buffers || x_thread_mutex_init(&w->inbox_lock) != 0)
+    {
+      x_log_fatal(NULL, "Failed to create the event loop of worker %d.", i);
+      return 1;
+    }
+    if (!cache_init(&w->cache, &config))
+      x_log_warning(NULL, "Worker %d can't watch the docroot; responses won't be cached.", i);
   }
 
-  x_log_info(NULL, "Serving HTTP on port %d from %s...", config.port, config.docroot);
+  // Every worker gets its own SO_REUSEPORT listener so the kernel spreads accepts
+  bool reuse_port = config.threads > 1;
+  for (i32 i = 0; i < config.threads && reuse_port; i++)
+  {
+    workers[i].listener = open_listener(&config, true);
+    if (!x_net_socket_is_valid(workers[i].listener))
+    {
+      for (i32 j = 0; j < i; j++) x_net_close(workers[j].listener);
+      reuse_port = false;
+    }
+  }
 
-  while (1)
+  if (!reuse_port)
   {
-    XAddress client_addr;
-    XSocket client = x_net_accept(server, &client_addr);
-    if (!x_net_socket_is_valid(client)) continue;
+    if (config.threads > 1)
+      x_log_warning(NULL, "SO_REUSEPORT unavailable; worker 0 accepts for all workers.");
+    XSocket shared = open_listener(&config, false);
+    for (i32 i = 0; i < config.threads; i++)
+    {
+      workers[i].listener = shared;
+      workers[i].hand_off = config.threads > 1;
+    }
+  }
 
-    WSClientData* data = (WSClientData*) malloc(sizeof(WSClientData));
-    data->client = client;
-    data->config = &config;
+  if (!x_net_socket_is_valid(workers[0].listener))
+  {
+    x_log_fatal(NULL, "Failed to bind/listen on port %d.", config.port);
+    return 1;
+  }
+
+  x_log_info(NULL, "Serving HTTP on port %d from %s with %d workers...", config.port, config.docroot, config.threads);
 
-    XThread *t;
-    if (x_thread_create(&t, client_thread, data) != 0)
+  // Worker 0 runs on the main thread; the pool runs the rest
+  XThreadPool* pool = NULL;
+  if (config.threads > 1)
+  {
+    pool = x_threadpool_create(config.threads - 1);
+    if (!pool)
     {
-      x_log_error(NULL, "Failed to Accept client");
-      free(data);
+      x_log_fatal(NULL, "Failed to start the worker threads.");
+      return 1;
     }
-    else
+    for (i32 i = 1; i < config.threads; i++)
     {
-      x_thread_join(t);
-      x_thread_destroy(t);
+      x_task_init(&workers[i].task, worker_run, &workers[i]);
+      x_threadpool_submit(pool, &workers[i].task);
     }
   }
 
+  worker_run(&workers[0]);
+
+  if (pool) x_threadpool_destroy(pool);
+  x_profile_shutdown();
   x_ini_free(&ini);
-  x_net_close(server);
+  x_net_close(workers[0].listener);
   x_net_shutdown();
   return 0;
 }
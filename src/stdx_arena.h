@@ -17,6 +17,56 @@
  *
  * To customize how this module allocates memory, define
  * `X_ARENA_ALLOC` / `X_ARENA_FRE`E before including.
+ *
+ * ## Chunk cache
+ *
+ * Chunks whose capacity is a power of two between
+ * `X_ARENA_CHUNK_CACHE_MIN_SIZE` and `X_ARENA_CHUNK_CACHE_MAX_SIZE` (the
+ * default 16 KB chunk size included) are not freed when an arena lets go
+ * of them. They go to a process-wide, lock-free cache with one bin per
+ * size, and new chunks of that size are taken from it before malloc is
+ * called. A per-request arena pattern therefore stops hitting malloc once
+ * warm. The cache holds at most `x_arena_chunk_cache_set_limit()` bytes
+ * (`X_ARENA_CHUNK_CACHE_LIMIT` by default); `x_arena_chunk_cache_purge()`
+ * frees everything it holds.
+ *
+ * ## Statistics
+ *
+ * Every arena keeps an `XArenaStats` (bytes in use and peak, chunk bytes
+ * held, alignment padding, chunks created vs. reused) readable through
+ * `x_arena_stats()`. `x_arena_chunk_cache_stats()` reports cache hits,
+ * misses and occupancy. Together they show whether `chunk_size` fits the
+ * workload: high waste or frequent misses mean it does not.
+ *
+ * ## Thread-local arenas
+ *
+ * `x_arena_thread_local()` returns an arena owned by the calling thread,
+ * created on first use, so worker code can allocate scratch memory
+ * without threading an arena through every call. It uses chunks of
+ * `X_ARENA_THREAD_CHUNK_SIZE` bytes, and `x_arena_reset()` on it hands
+ * every chunk but the head back to the shared cache. Once the cache is
+ * warm, workers that allocate and reset in a loop never reach malloc.
+ *
+ * Call `x_arena_thread_local_destroy()` before a thread exits to return its
+ * chunks.
+ *
+ * ## Virtual memory arenas
+ *
+ * `x_arena_create_virtual()` reserves one contiguous address range up
+ * front (mmap / VirtualAlloc) and commits it in `X_ARENA_VM_COMMIT_SIZE`
+ * steps as allocations advance. Memory never moves, consecutive
+ * allocations are adjacent, and `x_arena_realloc_last()` grows the most
+ * recent allocation in place. `x_arena_release()`, `x_arena_trim()` and
+ * `x_arena_reset_keep_head()` decommit the tail the arena no longer uses.
+ * Allocation fails once the reservation is exhausted.
+ *
+ * ## Container allocator
+ *
+ * `x_arena_allocator()` wraps an arena in an `XAllocator` (stdx_common.h)
+ * that containers such as XArray, XHashtable and XStrBuilder accept at
+ * creation. Everything they allocate then comes from the arena, frees are
+ * no-ops, and one `x_arena_reset()` drops the lot. Do not destroy such a
+ * container after the reset; just stop using it.
  */
 
 #ifndef X_ARENA_H
@@ -35,10 +85,37 @@
 extern "C" {
 #endif
 
+#include "stdx_common.h"
+#include <stddef.h>
 #include <stdbool.h>
 
   typedef struct XArenaChunk XArenaChunk;
 
+  /**
+   * Per-arena allocation statistics.
+   */
+  typedef struct XArenaStats
+  {
+    size_t bytes_used;       // Bytes handed out and not yet reset/released, padding included.
+    size_t bytes_peak;       // Highest bytes_used seen.
+    size_t bytes_reserved;   // Sum of the capacities of the chunks held (committed bytes for virtual arenas).
+    size_t alignment_waste;  // Padding inserted to honor X_ARENA_ALIGN, accumulated over the arena's life.
+    size_t chunks_created;   // Chunks obtained from X_ARENA_ALLOC.
+    size_t chunks_reused;    // Chunks taken from the shared chunk cache.
+  } XArenaStats;
+
+  /**
+   * Shared chunk cache statistics.
+   */
+  typedef struct XArenaCacheStats
+  {
+    size_t hits;             // Chunk requests served from the cache.
+    size_t misses;           // Requests for a cacheable size that had to allocate.
+    size_t cached_chunks;    // Chunks currently held.
+    size_t cached_bytes;     // Capacity of the chunks currently held.
+    size_t limit_bytes;      // High-water mark; chunks beyond it are freed.
+  } XArenaCacheStats;
+
   /**
    * Arena
    */
@@ -47,6 +124,11 @@ extern "C" {
     size_t       chunk_size;   // Preferred chunk size for growth.
     XArenaChunk* chunks;       // Head of chunk list (most recent first).
     XArenaChunk* current;      // Allocation cursor (first with free space).
+    bool         use_cache;    // Thread-local arena: reset returns all but the head chunk to the cache.
+    void*        vm_base;      // Start of the reserved range for virtual memory arenas, NULL otherwise.
+    size_t       vm_reserved;  // Bytes of address space reserved at vm_base.
+    size_t       vm_committed; // Bytes committed from vm_base.
+    XArenaStats  stats;        // Allocation statistics, see x_arena_stats().
   } XArena;
 
   /**
@@ -64,6 +146,15 @@ extern "C" {
    */
   X_ARENA_API XArena* x_arena_create(size_t chunk_size);
 
+  /**
+   * @brief Create an arena backed by a single reserved virtual address range.
+   * Pages are committed lazily as allocations advance, so reserving far more
+   * than is used only costs address space.
+   * @param reserve_size Bytes of address space to reserve (rounded up to X_ARENA_VM_COMMIT_SIZE).
+   * @return pointer to the new arena or NULL if the range could not be reserved
+   */
+  X_ARENA_API XArena* x_arena_create_virtual(size_t reserve_size);
+
   /**
    * @brief Destroy the arena and free all memory.
    * @param arena The arena to destroy.
@@ -113,6 +204,19 @@ extern "C" {
    */
   X_ARENA_API char* x_arena_strdup(XArena* arena, const char* cstr);
 
+  /**
+   * @brief Resize the most recent allocation, in place when possible.
+   * In place means `ptr` ends at the arena cursor and the chunk (or, for
+   * virtual memory arenas, the reservation) has room. Otherwise a new
+   * block is allocated and the old contents are copied.
+   * @param arena     The arena that owns ptr.
+   * @param ptr       The allocation to resize, or NULL to allocate.
+   * @param old_size  The current size of ptr.
+   * @param new_size  The requested size.
+   * @return          Pointer to the resized block, or NULL on failure (ptr stays valid).
+   */
+  X_ARENA_API void* x_arena_realloc_last(XArena* arena, void* ptr, size_t old_size, size_t new_size);
+
   /**
    * @brief Duplicate a slice into the arena.
    * @param arena   The arena to allocate string from.
@@ -144,17 +248,78 @@ extern "C" {
    */
   X_ARENA_API bool x_arena_has_pointer(const XArena* arena, void* ptr);
 
+  /**
+   * @brief Wrap an arena as a container allocator.
+   * Allocations come from the arena, reallocs use x_arena_realloc_last()
+   * and frees do nothing. The arena must outlive every container using it.
+   * @param arena The arena to allocate from.
+   * @return An allocator whose user pointer is the arena.
+   */
+  X_ARENA_API XAllocator x_arena_allocator(XArena* arena);
+
+  /**
+   * @brief Get the calling thread's arena, creating it on first use.
+   * The arena draws its chunks from the shared chunk cache, and
+   * x_arena_reset() returns all chunks but the head to it.
+   * Never pass this arena to x_arena_destroy(); use x_arena_thread_local_destroy().
+   * @return The thread's arena, or NULL if its first chunk could not be allocated.
+   */
+  X_ARENA_API XArena* x_arena_thread_local(void);
+
+  /**
+   * @brief Release the calling thread's arena, returning its chunks to the shared cache.
+   * Pointers allocated from it become invalid. Safe to call if the thread never used it.
+   */
+  X_ARENA_API void x_arena_thread_local_destroy(void);
+
+  /**
+   * @brief Free every chunk currently held by the shared chunk cache.
+   * Other threads may keep pushing to and popping from the cache meanwhile.
+   */
+  X_ARENA_API void x_arena_chunk_cache_purge(void);
+
+  /**
+   * @brief Set the most bytes of chunk capacity the shared cache may hold.
+   * Chunks released while the cache is at the limit are freed. 0 disables caching.
+   * Does not evict chunks already cached; call x_arena_chunk_cache_purge() for that.
+   * @param max_bytes The new high-water mark.
+   */
+  X_ARENA_API void x_arena_chunk_cache_set_limit(size_t max_bytes);
+
+  /**
+   * @brief Read the shared chunk cache counters.
+   * @return A snapshot of the cache statistics.
+   */
+  X_ARENA_API XArenaCacheStats x_arena_chunk_cache_stats(void);
+
+  /**
+   * @brief Read an arena's allocation statistics.
+   * @param arena The arena to inspect.
+   * @return A copy of the arena's statistics (all zero for NULL).
+   */
+  X_ARENA_API XArenaStats x_arena_stats(const XArena* arena);
+
 #ifdef __cplusplus
 }
 #endif
 
 #ifdef X_IMPL_ARENA
 
+#include "stdx_thread.h"
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
 
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
 #ifndef X_ARENA_ALLOC
 /**
  * @brief Internal macro for allocating memory.
@@ -179,6 +344,32 @@ extern "C" {
 #define X_ARENA_ALIGN (sizeof(void*) > sizeof(double) ? sizeof(void*) : sizeof(double))
 #endif
 
+#ifndef X_ARENA_THREAD_CHUNK_SIZE
+#define X_ARENA_THREAD_CHUNK_SIZE (64u * 1024u) /* Chunk size of thread-local arenas. */
+#endif
+
+#ifndef X_ARENA_CHUNK_CACHE_SLOTS
+#define X_ARENA_CHUNK_CACHE_SLOTS 64 /* Chunks kept per size bin of the shared cache. */
+#endif
+
+#ifndef X_ARENA_CHUNK_CACHE_MIN_SIZE
+#define X_ARENA_CHUNK_CACHE_MIN_SIZE (4u * 1024u) /* Smallest cached chunk capacity; a power of two. */
+#endif
+
+#ifndef X_ARENA_CHUNK_CACHE_BINS
+#define X_ARENA_CHUNK_CACHE_BINS 11 /* Power-of-two bins from MIN_SIZE up (4 KB .. 4 MB by default). */
+#endif
+
+#define X_ARENA_CHUNK_CACHE_MAX_SIZE ((size_t)X_ARENA_CHUNK_CACHE_MIN_SIZE << (X_ARENA_CHUNK_CACHE_BINS - 1))
+
+#ifndef X_ARENA_CHUNK_CACHE_LIMIT
+#define X_ARENA_CHUNK_CACHE_LIMIT (64u * 1024u * 1024u) /* Default high-water mark of the shared cache, in bytes. */
+#endif
+
+#ifndef X_ARENA_VM_COMMIT_SIZE
+#define X_ARENA_VM_COMMIT_SIZE (64u * 1024u) /* Commit granularity of virtual memory arenas; a multiple of the page size. */
+#endif
+
 #ifdef X_ARENA_DEBUG
 #ifndef X_ARENA_DEBUG_FILL
 #define X_ARENA_DEBUG_FILL 0xDD
@@ -231,6 +422,226 @@ static void x_arena_chunk_destroy(XArenaChunk* chunk)
   }
 }
 
+/*
+ * Shared chunk cache. Each size bin is an array of slots holding NULL or
+ * one free chunk. Taking a chunk is an atomic exchange with NULL and
+ * returning one is a CAS from NULL, so a chunk is owned by exactly one
+ * side at any time and there is no ABA hazard. Threads start scanning at
+ * their own offset to spread contention across slots.
+ */
+static void* volatile s_arena_chunk_cache[X_ARENA_CHUNK_CACHE_BINS][X_ARENA_CHUNK_CACHE_SLOTS];
+static volatile int64_t s_arena_cache_bytes;
+static volatile int64_t s_arena_cache_chunks;
+static volatile int64_t s_arena_cache_hits;
+static volatile int64_t s_arena_cache_misses;
+static volatile int64_t s_arena_cache_limit = X_ARENA_CHUNK_CACHE_LIMIT;
+static X_THREAD_LOCAL uint32_t s_arena_cache_hint;
+
+/* Bin of a chunk capacity, or -1 when chunks of that capacity are not cached. */
+static int x_arena_cache_bin(size_t capacity)
+{
+  if (capacity < X_ARENA_CHUNK_CACHE_MIN_SIZE || capacity > X_ARENA_CHUNK_CACHE_MAX_SIZE ||
+      (capacity & (capacity - 1u)) != 0u)
+  {
+    return -1;
+  }
+
+  int bin = 0;
+  while (((size_t)X_ARENA_CHUNK_CACHE_MIN_SIZE << bin) < capacity)
+  {
+    bin++;
+  }
+  return bin;
+}
+
+static XArenaChunk* x_arena_cache_pop(int bin)
+{
+  uint32_t start = s_arena_cache_hint;
+  for (uint32_t i = 0; i < X_ARENA_CHUNK_CACHE_SLOTS; ++i)
+  {
+    uint32_t idx = (start + i) % X_ARENA_CHUNK_CACHE_SLOTS;
+    if (x_atomic_load_ptr(&s_arena_chunk_cache[bin][idx]) == NULL)
+    {
+      continue;
+    }
+
+    XArenaChunk* c = (XArenaChunk*)x_atomic_exchange_ptr(&s_arena_chunk_cache[bin][idx], NULL);
+    if (c)
+    {
+      s_arena_cache_hint = idx;
+      x_atomic_fetch_add_i64(&s_arena_cache_bytes, -(int64_t)c->capacity);
+      x_atomic_fetch_add_i64(&s_arena_cache_chunks, -1);
+      return c;
+    }
+  }
+  return NULL;
+}
+
+static bool x_arena_cache_push(int bin, XArenaChunk* chunk)
+{
+  /* Reserve room under the high-water mark first; undo if no slot is free */
+  int64_t cap = (int64_t)chunk->capacity;
+  if (x_atomic_fetch_add_i64(&s_arena_cache_bytes, cap) + cap > x_atomic_load_i64(&s_arena_cache_limit))
+  {
+    x_atomic_fetch_add_i64(&s_arena_cache_bytes, -cap);
+    return false;
+  }
+
+  uint32_t start = s_arena_cache_hint;
+  for (uint32_t i = 0; i < X_ARENA_CHUNK_CACHE_SLOTS; ++i)
+  {
+    uint32_t idx = (start + i) % X_ARENA_CHUNK_CACHE_SLOTS;
+    if (x_atomic_load_ptr(&s_arena_chunk_cache[bin][idx]) == NULL &&
+        x_atomic_cas_ptr(&s_arena_chunk_cache[bin][idx], NULL, chunk))
+    {
+      s_arena_cache_hint = idx;
+      x_atomic_fetch_add_i64(&s_arena_cache_chunks, 1);
+      return true;
+    }
+  }
+
+  x_atomic_fetch_add_i64(&s_arena_cache_bytes, -cap);
+  return false;
+}
+
+/* Get a chunk for `arena`, from the shared cache when one of that size is available. */
+static XArenaChunk* x_arena_chunk_obtain(XArena* arena, size_t size)
+{
+  int bin = x_arena_cache_bin(size);
+  XArenaChunk* c = NULL;
+
+  if (bin >= 0)
+  {
+    c = x_arena_cache_pop(bin);
+    x_atomic_fetch_add_i64(c ? &s_arena_cache_hits : &s_arena_cache_misses, 1);
+  }
+
+  if (c)
+  {
+    c->next = NULL;
+    c->used = 0u;
+    arena->stats.chunks_reused++;
+  }
+  else
+  {
+    c = x_arena_chunk_create(size);
+    if (!c)
+    {
+      return NULL;
+    }
+    arena->stats.chunks_created++;
+  }
+
+  arena->stats.bytes_reserved += c->capacity;
+  return c;
+}
+
+/* Give a chunk back: to the shared cache when possible, otherwise to the allocator. */
+static void x_arena_chunk_recycle(XArena* arena, XArenaChunk* chunk)
+{
+  int bin = x_arena_cache_bin(chunk->capacity);
+
+  arena->stats.bytes_reserved -= chunk->capacity;
+  if (bin >= 0 && x_arena_cache_push(bin, chunk))
+  {
+    return;
+  }
+  x_arena_chunk_destroy(chunk);
+}
+
+/* Recompute bytes_used after chunks were dropped or rewound. */
+static void x_arena_recount(XArena* arena)
+{
+  size_t used = 0u;
+  for (XArenaChunk* c = arena->chunks; c != NULL; c = c->next)
+  {
+    used += c->used;
+  }
+  arena->stats.bytes_used = used;
+}
+
+/* --- Virtual memory backing ---------------------------------------------- */
+
+static void* x_arena_vm_reserve(size_t size)
+{
+#if defined(_WIN32)
+  return VirtualAlloc(NULL, size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+  void* p = mmap(NULL, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  return p == MAP_FAILED ? NULL : p;
+#endif
+}
+
+static bool x_arena_vm_commit(void* p, size_t size)
+{
+#if defined(_WIN32)
+  return VirtualAlloc(p, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+  return mprotect(p, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+static void x_arena_vm_decommit(void* p, size_t size)
+{
+#if defined(_WIN32)
+  VirtualFree(p, size, MEM_DECOMMIT);
+#else
+  madvise(p, size, MADV_DONTNEED);
+  mprotect(p, size, PROT_NONE);
+#endif
+}
+
+static void x_arena_vm_unreserve(void* p, size_t size)
+{
+#if defined(_WIN32)
+  (void)size;
+  VirtualFree(p, 0, MEM_RELEASE);
+#else
+  munmap(p, size);
+#endif
+}
+
+/* Commit whole steps until `end` bytes from vm_base are backed. */
+static bool x_arena_vm_ensure(XArena* arena, size_t end)
+{
+  if (end <= arena->vm_committed)
+  {
+    return true;
+  }
+
+  size_t target = x_arena_align_up(end, X_ARENA_VM_COMMIT_SIZE);
+  if (target > arena->vm_reserved)
+  {
+    target = arena->vm_reserved;
+  }
+
+  if (!x_arena_vm_commit((uint8_t*)arena->vm_base + arena->vm_committed, target - arena->vm_committed))
+  {
+    return false;
+  }
+  arena->vm_committed = target;
+  arena->stats.bytes_reserved = target;
+  return true;
+}
+
+/* Give back every commit step past the one holding the cursor. */
+static void x_arena_vm_shrink(XArena* arena)
+{
+  XArenaChunk* c = arena->chunks;
+  size_t keep = x_arena_align_up((size_t)(c->data - (uint8_t*)arena->vm_base) + c->used, X_ARENA_VM_COMMIT_SIZE);
+  if (keep < X_ARENA_VM_COMMIT_SIZE)
+  {
+    keep = X_ARENA_VM_COMMIT_SIZE;
+  }
+
+  if (keep < arena->vm_committed)
+  {
+    x_arena_vm_decommit((uint8_t*)arena->vm_base + keep, arena->vm_committed - keep);
+    arena->vm_committed = keep;
+    arena->stats.bytes_reserved = keep;
+  }
+}
+
 /* Push chunk to list head. */
 static inline void x_arena_push_chunk(XArena* arena, XArenaChunk* chunk)
 {
@@ -256,9 +667,14 @@ X_ARENA_API XArena* x_arena_create(size_t chunk_size)
   arena->chunk_size = chunk_size;
   arena->chunks = NULL;
   arena->current = NULL;
+  arena->use_cache = false;
+  arena->vm_base = NULL;
+  arena->vm_reserved = 0u;
+  arena->vm_committed = 0u;
+  memset(&arena->stats, 0, sizeof(arena->stats));
 
   /* Allocate the initial chunk so x_arena_alloc can be fast. */
-  XArenaChunk* head = x_arena_chunk_create(chunk_size);
+  XArenaChunk* head = x_arena_chunk_obtain(arena, chunk_size);
   if (!head)
   {
     X_ARENA_FREE(arena);
@@ -268,6 +684,54 @@ X_ARENA_API XArena* x_arena_create(size_t chunk_size)
   return arena;
 }
 
+X_ARENA_API XArena* x_arena_create_virtual(size_t reserve_size)
+{
+  if (reserve_size == 0u || reserve_size > SIZE_MAX - X_ARENA_VM_COMMIT_SIZE)
+  {
+    return NULL;
+  }
+  reserve_size = x_arena_align_up(reserve_size, X_ARENA_VM_COMMIT_SIZE);
+
+  XArena* arena = (XArena*) X_ARENA_ALLOC(sizeof(XArena));
+  if (!arena)
+  {
+    return NULL;
+  }
+
+  void* base = x_arena_vm_reserve(reserve_size);
+  if (!base)
+  {
+    X_ARENA_FREE(arena);
+    return NULL;
+  }
+
+  arena->chunk_size = reserve_size;
+  arena->chunks = NULL;
+  arena->current = NULL;
+  arena->use_cache = false;
+  arena->vm_base = base;
+  arena->vm_reserved = reserve_size;
+  arena->vm_committed = 0u;
+  memset(&arena->stats, 0, sizeof(arena->stats));
+
+  /* The only chunk header lives at the start of the range; data follows it. */
+  size_t header = x_arena_align_up(sizeof(XArenaChunk), X_ARENA_ALIGN);
+  if (!x_arena_vm_ensure(arena, header))
+  {
+    x_arena_vm_unreserve(base, reserve_size);
+    X_ARENA_FREE(arena);
+    return NULL;
+  }
+
+  XArenaChunk* head = (XArenaChunk*)base;
+  head->next = NULL;
+  head->capacity = reserve_size - header;
+  head->used = 0u;
+  head->data = (uint8_t*)base + header;
+  x_arena_push_chunk(arena, head);
+  return arena;
+}
+
 X_ARENA_API void x_arena_destroy(XArena* arena)
 {
   if (!arena)
@@ -275,11 +739,18 @@ X_ARENA_API void x_arena_destroy(XArena* arena)
     return;
   }
 
+  if (arena->vm_base)
+  {
+    x_arena_vm_unreserve(arena->vm_base, arena->vm_reserved);
+    X_ARENA_FREE(arena);
+    return;
+  }
+
   XArenaChunk* c = arena->chunks;
   while (c)
   {
     XArenaChunk* next = c->next;
-    x_arena_chunk_destroy(c);
+    x_arena_chunk_recycle(arena, c);
     c = next;
   }
 
@@ -293,6 +764,19 @@ X_ARENA_API void x_arena_reset(XArena* arena)
     return;
   }
 
+  if (arena->use_cache && arena->chunks)
+  {
+    /* Thread-local arenas keep only the head and share the rest */
+    XArenaChunk* c = arena->chunks->next;
+    while (c)
+    {
+      XArenaChunk* next = c->next;
+      x_arena_chunk_recycle(arena, c);
+      c = next;
+    }
+    arena->chunks->next = NULL;
+  }
+
   for (XArenaChunk* c = arena->chunks; c != NULL; c = c->next)
   {
 #ifdef X_ARENA_DEBUG
@@ -302,6 +786,7 @@ X_ARENA_API void x_arena_reset(XArena* arena)
   }
 
   arena->current = arena->chunks;
+  arena->stats.bytes_used = 0u;
 }
 
 X_ARENA_API void x_arena_reset_keep_head(XArena* arena)
@@ -311,12 +796,19 @@ X_ARENA_API void x_arena_reset_keep_head(XArena* arena)
     return;
   }
 
+  if (arena->vm_base)
+  {
+    x_arena_reset(arena);
+    x_arena_vm_shrink(arena);
+    return;
+  }
+
   XArenaChunk* head = arena->chunks;
   XArenaChunk* c = head->next;
   while (c)
   {
     XArenaChunk* next = c->next;
-    x_arena_chunk_destroy(c);
+    x_arena_chunk_recycle(arena, c);
     c = next;
   }
 
@@ -327,6 +819,7 @@ X_ARENA_API void x_arena_reset_keep_head(XArena* arena)
   head->used = 0u;
   arena->chunks = head;
   arena->current = head;
+  arena->stats.bytes_used = 0u;
 }
 
 X_ARENA_API void x_arena_trim(XArena* arena, size_t keep_n)
@@ -336,6 +829,12 @@ X_ARENA_API void x_arena_trim(XArena* arena, size_t keep_n)
     return;
   }
 
+  if (arena->vm_base)
+  {
+    x_arena_vm_shrink(arena);
+    return;
+  }
+
   XArenaChunk* c = arena->chunks;
   size_t i = 0u;
   while (c && i + 1u < keep_n)
@@ -355,14 +854,26 @@ X_ARENA_API void x_arena_trim(XArena* arena, size_t keep_n)
   while (to_free)
   {
     XArenaChunk* next = to_free->next;
-    x_arena_chunk_destroy(to_free);
+    x_arena_chunk_recycle(arena, to_free);
     to_free = next;
   }
 
   arena->current = arena->chunks;
+  x_arena_recount(arena);
 }
 
-X_ARENA_API static void* x_arena_alloc_from_chunk(XArenaChunk* c, size_t size)
+/* Account for `size` bytes plus `pad` alignment bytes handed out. */
+static inline void x_arena_count_alloc(XArena* arena, size_t pad, size_t size)
+{
+  arena->stats.alignment_waste += pad;
+  arena->stats.bytes_used += pad + size;
+  if (arena->stats.bytes_used > arena->stats.bytes_peak)
+  {
+    arena->stats.bytes_peak = arena->stats.bytes_used;
+  }
+}
+
+X_ARENA_API static void* x_arena_alloc_from_chunk(XArena* arena, XArenaChunk* c, size_t size)
 {
   size_t off = x_arena_align_up(c->used, X_ARENA_ALIGN);
   if (off > c->capacity)
@@ -375,6 +886,7 @@ X_ARENA_API static void* x_arena_alloc_from_chunk(XArenaChunk* c, size_t size)
     return NULL;
   }
   void* ptr = c->data + off;
+  x_arena_count_alloc(arena, off - c->used, size);
   c->used = off + size;
   return ptr;
 }
@@ -392,10 +904,28 @@ X_ARENA_API void* x_arena_alloc(XArena* arena, size_t size)
     return NULL;
   }
 
+  if (arena->vm_base)
+  {
+    /* One contiguous chunk: commit ahead of the cursor, never grow a new chunk. */
+    XArenaChunk* c = arena->current;
+    size_t off = x_arena_align_up(c->used, X_ARENA_ALIGN);
+    if (off > c->capacity || c->capacity - off < size)
+    {
+      return NULL;
+    }
+    if (!x_arena_vm_ensure(arena, (size_t)(c->data - (uint8_t*)arena->vm_base) + off + size))
+    {
+      return NULL;
+    }
+    x_arena_count_alloc(arena, off - c->used, size);
+    c->used = off + size;
+    return c->data + off;
+  }
+
   /* Fast path: try current chunk. */
   if (arena->current)
   {
-    void* p = x_arena_alloc_from_chunk(arena->current, size);
+    void* p = x_arena_alloc_from_chunk(arena, arena->current, size);
     if (p)
     {
       return p;
@@ -409,7 +939,7 @@ X_ARENA_API void* x_arena_alloc(XArena* arena, size_t size)
     {
       continue;
     }
-    void* p = x_arena_alloc_from_chunk(c, size);
+    void* p = x_arena_alloc_from_chunk(arena, c, size);
     if (p)
     {
       arena->current = c;
@@ -419,14 +949,14 @@ X_ARENA_API void* x_arena_alloc(XArena* arena, size_t size)
 
   /* Need a new chunk: grow by max(request, default chunk size). */
   size_t grow = size > arena->chunk_size ? size : arena->chunk_size;
-  XArenaChunk* n = x_arena_chunk_create(grow);
+  XArenaChunk* n = x_arena_chunk_obtain(arena, grow);
   if (!n)
   {
     return NULL;
   }
 
   x_arena_push_chunk(arena, n);
-  return x_arena_alloc_from_chunk(n, size);
+  return x_arena_alloc_from_chunk(arena, n, size);
 }
 
 X_ARENA_API void* x_arena_alloc_zero(XArena* arena, size_t size)
@@ -439,6 +969,56 @@ X_ARENA_API void* x_arena_alloc_zero(XArena* arena, size_t size)
   return p;
 }
 
+X_ARENA_API void* x_arena_realloc_last(XArena* arena, void* ptr, size_t old_size, size_t new_size)
+{
+  if (!arena)
+  {
+    return NULL;
+  }
+
+  if (!ptr)
+  {
+    return x_arena_alloc(arena, new_size);
+  }
+
+  XArenaChunk* c = arena->current;
+  uint8_t* p = (uint8_t*)ptr;
+  if (c && p >= c->data && p + old_size == c->data + c->used)
+  {
+    size_t off = (size_t)(p - c->data);
+    if (new_size <= c->capacity - off)
+    {
+      if (arena->vm_base &&
+          !x_arena_vm_ensure(arena, (size_t)(c->data - (uint8_t*)arena->vm_base) + off + new_size))
+      {
+        return NULL;
+      }
+      c->used = off + new_size;
+      if (new_size >= old_size)
+      {
+        x_arena_count_alloc(arena, 0u, new_size - old_size);
+      }
+      else
+      {
+        arena->stats.bytes_used -= old_size - new_size;
+      }
+      return ptr;
+    }
+  }
+
+  if (new_size <= old_size)
+  {
+    return ptr;
+  }
+
+  void* n = x_arena_alloc(arena, new_size);
+  if (n)
+  {
+    memcpy(n, ptr, old_size);
+  }
+  return n;
+}
+
 X_ARENA_API char* x_arena_strdup(XArena* arena, const char* cstr)
 {
   if (!cstr)
@@ -495,6 +1075,22 @@ X_ARENA_API void x_arena_release(XArena* arena, XArenaMark mark)
     return;
   }
 
+  if (arena->vm_base)
+  {
+    XArenaChunk* head = arena->chunks;
+    size_t used = mark.chunk ? mark.used : 0u;
+    if (used < head->used)
+    {
+#ifdef X_ARENA_DEBUG
+      memset(head->data + used, X_ARENA_DEBUG_FILL, head->used - used);
+#endif
+      head->used = used;
+    }
+    arena->stats.bytes_used = head->used;
+    x_arena_vm_shrink(arena);
+    return;
+  }
+
   /* If mark.chunk is NULL, clear everything. */
   if (mark.chunk == NULL)
   {
@@ -502,7 +1098,7 @@ X_ARENA_API void x_arena_release(XArena* arena, XArenaMark mark)
     while (c)
     {
       XArenaChunk* next = c->next;
-      x_arena_chunk_destroy(c);
+      x_arena_chunk_recycle(arena, c);
       c = next;
     }
 
@@ -510,11 +1106,12 @@ X_ARENA_API void x_arena_release(XArena* arena, XArenaMark mark)
     arena->current = NULL;
 
     /* Recreate an initial chunk for future fast allocations. */
-    XArenaChunk* head = x_arena_chunk_create(arena->chunk_size);
+    XArenaChunk* head = x_arena_chunk_obtain(arena, arena->chunk_size);
     if (head)
     {
       x_arena_push_chunk(arena, head);
     }
+    arena->stats.bytes_used = 0u;
     return;
   }
 
@@ -523,7 +1120,7 @@ X_ARENA_API void x_arena_release(XArena* arena, XArenaMark mark)
   while (c && c != mark.chunk)
   {
     XArenaChunk* next = c->next;
-    x_arena_chunk_destroy(c);
+    x_arena_chunk_recycle(arena, c);
     c = next;
   }
 
@@ -540,6 +1137,34 @@ X_ARENA_API void x_arena_release(XArena* arena, XArenaMark mark)
 #endif
     c->used = mark.used;
   }
+  x_arena_recount(arena);
+}
+
+static void* x_arena_allocator_alloc(void* user, size_t size)
+{
+  return x_arena_alloc((XArena*)user, size);
+}
+
+static void* x_arena_allocator_realloc(void* user, void* ptr, size_t old_size, size_t new_size)
+{
+  return x_arena_realloc_last((XArena*)user, ptr, old_size, new_size);
+}
+
+static void x_arena_allocator_free(void* user, void* ptr, size_t size)
+{
+  (void)user;
+  (void)ptr;
+  (void)size;
+}
+
+X_ARENA_API XAllocator x_arena_allocator(XArena* arena)
+{
+  XAllocator a;
+  a.alloc_fn = x_arena_allocator_alloc;
+  a.realloc_fn = x_arena_allocator_realloc;
+  a.free_fn = x_arena_allocator_free;
+  a.user = arena;
+  return a;
 }
 
 X_ARENA_API bool x_arena_has_pointer(const XArena* a, void* p)
@@ -563,6 +1188,92 @@ X_ARENA_API bool x_arena_has_pointer(const XArena* a, void* p)
   return false;
 }
 
+static X_THREAD_LOCAL XArena s_arena_thread;
+static X_THREAD_LOCAL bool s_arena_thread_ready;
+
+X_ARENA_API XArena* x_arena_thread_local(void)
+{
+  if (!s_arena_thread_ready)
+  {
+    s_arena_thread.chunk_size = X_ARENA_THREAD_CHUNK_SIZE;
+    s_arena_thread.chunks = NULL;
+    s_arena_thread.current = NULL;
+    s_arena_thread.use_cache = true;
+    s_arena_thread.vm_base = NULL;
+    s_arena_thread.vm_reserved = 0u;
+    s_arena_thread.vm_committed = 0u;
+    memset(&s_arena_thread.stats, 0, sizeof(s_arena_thread.stats));
+    s_arena_cache_hint = (uint32_t)(((uintptr_t)&s_arena_thread >> 6) % X_ARENA_CHUNK_CACHE_SLOTS);
+
+    XArenaChunk* head = x_arena_chunk_obtain(&s_arena_thread, X_ARENA_THREAD_CHUNK_SIZE);
+    if (!head)
+    {
+      return NULL;
+    }
+    x_arena_push_chunk(&s_arena_thread, head);
+    s_arena_thread_ready = true;
+  }
+  return &s_arena_thread;
+}
+
+X_ARENA_API void x_arena_thread_local_destroy(void)
+{
+  if (!s_arena_thread_ready)
+  {
+    return;
+  }
+
+  XArenaChunk* c = s_arena_thread.chunks;
+  while (c)
+  {
+    XArenaChunk* next = c->next;
+    x_arena_chunk_recycle(&s_arena_thread, c);
+    c = next;
+  }
+
+  s_arena_thread.chunks = NULL;
+  s_arena_thread.current = NULL;
+  s_arena_thread_ready = false;
+}
+
+X_ARENA_API void x_arena_chunk_cache_purge(void)
+{
+  for (int bin = 0; bin < X_ARENA_CHUNK_CACHE_BINS; ++bin)
+  {
+    XArenaChunk* c;
+    while ((c = x_arena_cache_pop(bin)) != NULL)
+    {
+      x_arena_chunk_destroy(c);
+    }
+  }
+}
+
+X_ARENA_API void x_arena_chunk_cache_set_limit(size_t max_bytes)
+{
+  x_atomic_store_i64(&s_arena_cache_limit, max_bytes > (size_t)INT64_MAX ? INT64_MAX : (int64_t)max_bytes);
+}
+
+X_ARENA_API XArenaCacheStats x_arena_chunk_cache_stats(void)
+{
+  XArenaCacheStats st;
+  st.hits = (size_t)x_atomic_load_i64(&s_arena_cache_hits);
+  st.misses = (size_t)x_atomic_load_i64(&s_arena_cache_misses);
+  st.cached_chunks = (size_t)x_atomic_load_i64(&s_arena_cache_chunks);
+  st.cached_bytes = (size_t)x_atomic_load_i64(&s_arena_cache_bytes);
+  st.limit_bytes = (size_t)x_atomic_load_i64(&s_arena_cache_limit);
+  return st;
+}
+
+X_ARENA_API XArenaStats x_arena_stats(const XArena* arena)
+{
+  XArenaStats st;
+  if (!arena)
+  {
+    memset(&st, 0, sizeof(st));
+    return st;
+  }
+  return arena->stats;
+}
 
 /* --- Testing helpers (debug-only) ----------------------------------------- */
 #ifdef X_ARENA_TESTING
@@ -1,5 +1,5 @@
 /**
- * STDX - Generic Hashtable 
+ * STDX - Dynamic Array
  * Part of the STDX General Purpose C Library by marciovmf 
  * License: MIT 
  * <https://github.com/marciovmf/stdx>
@@ -18,6 +18,8 @@
  *
  * To customize how this module allocates memory, define
  * `X_ARRAY_ALLOC` / `X_ARRAY_REALLOC` / `X_ARRAY_FREE` before including.
+ * To pick the allocator per array at runtime, create it with
+ * `x_array_create_with_allocator()` and an `XAllocator` (see stdx_common.h).
  *
  * ## Typed usage (recommended)
  *
@@ -75,6 +77,34 @@
  * Internally these wrappers call the generic API, so there is no
  * additional runtime overhead.
  *
+ * ## Growth and capacity
+ *
+ * A full array grows by `X_ARRAY_GROWTH_FACTOR` (2 unless defined before
+ * including), and never to fewer than `X_ARRAY_MIN_CAPACITY` elements.
+ * `x_array_set_growth()` changes the factor for one array.
+ * `x_array_reserve()` grows the array once up front when the final size is
+ * known, and `x_array_shrink_to_fit()` gives back the unused tail.
+ *
+ * ## Inline storage
+ *
+ * Arrays that usually hold a handful of elements can live in a struct or on
+ * the stack and keep their first N elements inline, touching the heap only
+ * when they outgrow them. `X_ARRAY_TYPE_INLINE(T, N)` declares everything
+ * `X_ARRAY_TYPE(T)` does (use it instead, not in addition) plus the storage
+ * type `XArrayInline_T`:
+ *
+ * ```
+ * X_ARRAY_TYPE_INLINE(int, 8)
+ * XArrayInline_int storage;
+ * XArray_int* arr = x_array_int_init_inline(&storage);
+ * x_array_int_push(arr, 1);          // no allocation until the 9th element
+ * x_array_int_term(arr);             // frees the spill buffer, if any
+ * ```
+ *
+ * The array points into its storage, so the storage must not be copied or
+ * moved while in use. Never pass an inline array to `x_array_destroy()`.
+ * Untyped code does the same with `x_array_init()` and its own buffer.
+ *
  * ## Dependencies
  *
  *  stdx_common.h
@@ -87,6 +117,7 @@
 #include "stdx_common.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifndef X_ARRAY_API
 #define X_ARRAY_API
@@ -111,8 +142,29 @@ extern "C" {
     XARRAY_EMPTY                      = 4   /* Array is empty */
   } XArrayError;
 
+#ifndef X_ARRAY_GROWTH_FACTOR
+#define X_ARRAY_GROWTH_FACTOR 2.0f
+#endif
+
+#ifndef X_ARRAY_MIN_CAPACITY
+#define X_ARRAY_MIN_CAPACITY 4
+#endif
+
   typedef struct XArray_t XArray;
 
+  /* Public so arrays can be embedded in other structs with inline storage. */
+  struct XArray_t
+  {
+    void *array;
+    size_t size;
+    size_t capacity;
+    size_t elementSize;
+    float growth;               /* Capacity multiplier applied when full */
+    void *inline_array;         /* Storage used until it overflows, or NULL */
+    size_t inline_capacity;
+    XAllocator allocator;       /* Runtime allocator; alloc_fn NULL means X_ARRAY_ALLOC */
+  };
+
   /**
    * @brief Create a new dynamic array.
    * @param elementSize Size in bytes of a single element stored in the array.
@@ -121,6 +173,67 @@ extern "C" {
    */
   X_ARRAY_API XArray* x_array_create(size_t elementSize, size_t capacity);
 
+  /**
+   * @brief Create a new dynamic array that allocates through `allocator`.
+   * Both the array and its storage come from the allocator.
+   * @param elementSize Size in bytes of a single element stored in the array.
+   * @param capacity Initial number of elements the array can hold.
+   * @param allocator Allocator to copy into the array, or NULL for X_ARRAY_ALLOC.
+   * @return Pointer to the newly created array, or NULL on failure.
+   */
+  X_ARRAY_API XArray* x_array_create_with_allocator(size_t elementSize, size_t capacity, const XAllocator* allocator);
+
+  /**
+   * @brief Initialize an array in caller-owned memory.
+   * Elements are kept in `inline_storage` until more than `inline_capacity`
+   * are added; only then does the array allocate.
+   * @param arr Array to initialize.
+   * @param elementSize Size in bytes of a single element stored in the array.
+   * @param inline_storage Buffer for the first elements, or NULL.
+   * @param inline_capacity Number of elements `inline_storage` holds.
+   * @return Nothing.
+   */
+  X_ARRAY_API void x_array_init(XArray* arr, size_t elementSize, void* inline_storage, size_t inline_capacity);
+
+  /**
+   * @brief Release the heap storage of an array set up with x_array_init().
+   * The array is left empty and may be reused.
+   * @param arr Pointer to the array.
+   * @return Nothing.
+   */
+  X_ARRAY_API void x_array_term(XArray* arr);
+
+  /**
+   * @brief Make room for at least `capacity` elements.
+   * @param arr Pointer to the array.
+   * @param capacity Number of elements the array must hold without growing.
+   * @return Error code indicating success or failure.
+   */
+  X_ARRAY_API XArrayError x_array_reserve(XArray* arr, size_t capacity);
+
+  /**
+   * @brief Reduce capacity to the current element count.
+   * Arrays with inline storage move back into it when the elements fit.
+   * @param arr Pointer to the array.
+   * @return Error code indicating success or failure.
+   */
+  X_ARRAY_API XArrayError x_array_shrink_to_fit(XArray* arr);
+
+  /**
+   * @brief Set the factor capacity is multiplied by when the array is full.
+   * @param arr Pointer to the array.
+   * @param factor Growth factor; values not above 1 restore X_ARRAY_GROWTH_FACTOR.
+   * @return Nothing.
+   */
+  X_ARRAY_API void x_array_set_growth(XArray* arr, float factor);
+
+  /**
+   * @brief Check whether the elements still live in the inline storage.
+   * @param arr Pointer to the array.
+   * @return True if the array has inline storage and has not spilled to the heap.
+   */
+  X_ARRAY_API bool x_array_is_inline(XArray* arr);
+
   /**
    * @brief Get a pointer to the element at the given index.
    * @param arr Pointer to the array.
@@ -239,6 +352,10 @@ extern "C" {
   { \
     return (XArray_##suffix*)x_array_create(sizeof(T), capacity); \
   } \
+  static inline XArray_##suffix* x_array_##suffix##_create_with_allocator(size_t capacity, const XAllocator* allocator) \
+  { \
+    return (XArray_##suffix*)x_array_create_with_allocator(sizeof(T), capacity, allocator); \
+  } \
   static inline void x_array_##suffix##_destroy(XArray_##suffix* arr) \
   { \
     x_array_destroy((XArray*)arr); \
@@ -321,6 +438,39 @@ extern "C" {
   static inline bool x_array_##suffix##_is_empty(XArray_##suffix* arr) \
   { \
     return x_array_is_empty((XArray*)arr); \
+  } \
+  static inline XArrayError x_array_##suffix##_reserve(XArray_##suffix* arr, size_t capacity) \
+  { \
+    return x_array_reserve((XArray*)arr, capacity); \
+  } \
+  static inline XArrayError x_array_##suffix##_shrink_to_fit(XArray_##suffix* arr) \
+  { \
+    return x_array_shrink_to_fit((XArray*)arr); \
+  } \
+  static inline void x_array_##suffix##_set_growth(XArray_##suffix* arr, float factor) \
+  { \
+    x_array_set_growth((XArray*)arr, factor); \
+  }
+
+  /* Typed array whose first N elements live in an XArrayInline_T. */
+#define X_ARRAY_TYPE_INLINE(T, N) \
+  X_ARRAY_TYPE_INLINE_NAMED(T, T, N)
+
+#define X_ARRAY_TYPE_INLINE_NAMED(T, suffix, N) \
+  X_ARRAY_TYPE_NAMED(T, suffix) \
+  typedef struct XArrayInline_##suffix \
+  { \
+    XArray base; \
+    T items[N]; \
+  } XArrayInline_##suffix; \
+  static inline XArray_##suffix* x_array_##suffix##_init_inline(XArrayInline_##suffix* storage) \
+  { \
+    x_array_init(&storage->base, sizeof(T), storage->items, (N)); \
+    return (XArray_##suffix*)&storage->base; \
+  } \
+  static inline void x_array_##suffix##_term(XArray_##suffix* arr) \
+  { \
+    x_array_term((XArray*)arr); \
   }
 
 #ifdef __cplusplus
@@ -369,33 +519,204 @@ extern "C" {
 extern "C" {
 #endif
 
-  struct XArray_t
+  static void* s_array_alloc(const XAllocator* a, size_t size)
   {
-    void *array;
-    size_t size;
-    size_t capacity;
-    size_t elementSize;
-  };
+    return a->alloc_fn ? a->alloc_fn(a->user, size) : X_ARRAY_ALLOC(size);
+  }
+
+  static void* s_array_realloc(const XAllocator* a, void* ptr, size_t old_size, size_t new_size)
+  {
+    return a->alloc_fn ? a->realloc_fn(a->user, ptr, old_size, new_size) : X_ARRAY_REALLOC(ptr, new_size);
+  }
+
+  static void s_array_free(const XAllocator* a, void* ptr, size_t size)
+  {
+    if (a->alloc_fn)
+    {
+      if (ptr)
+      {
+        a->free_fn(a->user, ptr, size);
+      }
+      return;
+    }
+    X_ARRAY_FREE(ptr);
+  }
+
+  static bool s_array_on_heap(const XArray* arr)
+  {
+    return arr->array != NULL && arr->array != arr->inline_array;
+  }
+
+  /* Moves the elements into a buffer of exactly `new_capacity` elements */
+  static XArrayError s_array_set_capacity(XArray* arr, size_t new_capacity)
+  {
+    void* new_array;
+
+    if (s_array_on_heap(arr))
+    {
+      new_array = s_array_realloc(&arr->allocator, arr->array,
+          arr->capacity * arr->elementSize, new_capacity * arr->elementSize);
+      if (new_array == NULL)
+      {
+        return XARRAY_MEMORY_ALLOCATION_FAILED;
+      }
+    }
+    else
+    {
+      /* Spilling out of the inline storage */
+      new_array = s_array_alloc(&arr->allocator, new_capacity * arr->elementSize);
+      if (new_array == NULL)
+      {
+        return XARRAY_MEMORY_ALLOCATION_FAILED;
+      }
+
+      if (arr->size > 0)
+      {
+        memcpy(new_array, arr->array, arr->size * arr->elementSize);
+      }
+    }
+
+    arr->array = new_array;
+    arr->capacity = new_capacity;
+    return XARRAY_OK;
+  }
+
+  static XArrayError s_array_grow(XArray* arr)
+  {
+    size_t new_capacity;
+
+    new_capacity = (size_t)((float)arr->capacity * arr->growth);
+    if (new_capacity <= arr->capacity)
+    {
+      new_capacity = arr->capacity + 1;
+    }
+
+    if (new_capacity < X_ARRAY_MIN_CAPACITY)
+    {
+      new_capacity = X_ARRAY_MIN_CAPACITY;
+    }
+
+    return s_array_set_capacity(arr, new_capacity);
+  }
+
+  void x_array_init(XArray* arr, size_t elementSize, void* inline_storage, size_t inline_capacity)
+  {
+    X_ASSERT(arr != NULL);
+
+    if (inline_storage == NULL)
+    {
+      inline_capacity = 0;
+    }
+
+    arr->array = inline_capacity > 0 ? inline_storage : NULL;
+    arr->size = 0;
+    arr->capacity = inline_capacity;
+    arr->elementSize = elementSize;
+    arr->growth = X_ARRAY_GROWTH_FACTOR;
+    arr->inline_array = arr->array;
+    arr->inline_capacity = inline_capacity;
+    memset(&arr->allocator, 0, sizeof(arr->allocator));
+  }
+
+  void x_array_term(XArray* arr)
+  {
+    X_ASSERT(arr != NULL);
+
+    if (s_array_on_heap(arr))
+    {
+      s_array_free(&arr->allocator, arr->array, arr->capacity * arr->elementSize);
+    }
+
+    arr->array = arr->inline_array;
+    arr->capacity = arr->inline_capacity;
+    arr->size = 0;
+  }
+
+  XArrayError x_array_reserve(XArray* arr, size_t capacity)
+  {
+    X_ASSERT(arr != NULL);
+
+    if (capacity <= arr->capacity)
+    {
+      return XARRAY_OK;
+    }
+
+    return s_array_set_capacity(arr, capacity);
+  }
+
+  XArrayError x_array_shrink_to_fit(XArray* arr)
+  {
+    X_ASSERT(arr != NULL);
+
+    if (!s_array_on_heap(arr) || arr->size == arr->capacity)
+    {
+      return XARRAY_OK;
+    }
+
+    if (arr->inline_array != NULL && arr->size <= arr->inline_capacity)
+    {
+      memcpy(arr->inline_array, arr->array, arr->size * arr->elementSize);
+      s_array_free(&arr->allocator, arr->array, arr->capacity * arr->elementSize);
+      arr->array = arr->inline_array;
+      arr->capacity = arr->inline_capacity;
+      return XARRAY_OK;
+    }
+
+    if (arr->size == 0)
+    {
+      s_array_free(&arr->allocator, arr->array, arr->capacity * arr->elementSize);
+      arr->array = NULL;
+      arr->capacity = 0;
+      return XARRAY_OK;
+    }
+
+    return s_array_set_capacity(arr, arr->size);
+  }
+
+  void x_array_set_growth(XArray* arr, float factor)
+  {
+    X_ASSERT(arr != NULL);
+    arr->growth = factor > 1.0f ? factor : X_ARRAY_GROWTH_FACTOR;
+  }
+
+  bool x_array_is_inline(XArray* arr)
+  {
+    X_ASSERT(arr != NULL);
+    return arr->inline_array != NULL && arr->array == arr->inline_array;
+  }
 
   XArray* x_array_create(size_t elementSize, size_t capacity)
   {
-    XArray* arr = (XArray*) X_ARRAY_ALLOC(sizeof(XArray));
+    return x_array_create_with_allocator(elementSize, capacity, NULL);
+  }
+
+  XArray* x_array_create_with_allocator(size_t elementSize, size_t capacity, const XAllocator* allocator)
+  {
+    XAllocator a;
+    XArray* arr;
+
+    memset(&a, 0, sizeof(a));
+    if (allocator != NULL)
+    {
+      a = *allocator;
+    }
+
+    arr = (XArray*) s_array_alloc(&a, sizeof(XArray));
     if (arr == NULL)
     {
       return NULL;
     }
 
-    arr->array = NULL;
-    arr->size = 0;
+    x_array_init(arr, elementSize, NULL, 0);
+    arr->allocator = a;
     arr->capacity = capacity;
-    arr->elementSize = elementSize;
 
     if (capacity > 0)
     {
-      arr->array = X_ARRAY_ALLOC(capacity * elementSize);
+      arr->array = s_array_alloc(&a, capacity * elementSize);
       if (arr->array == NULL)
       {
-        X_ARRAY_FREE(arr);
+        s_array_free(&a, arr, sizeof(XArray));
         return NULL;
       }
     }
@@ -405,22 +726,11 @@ extern "C" {
 
   XArrayError x_array_add(XArray* arr, void* data)
   {
-    void* new_array;
-    size_t new_capacity;
-
     X_ASSERT(arr != NULL);
 
-    if (arr->size >= arr->capacity)
+    if (arr->size >= arr->capacity && s_array_grow(arr) != XARRAY_OK)
     {
-      new_capacity = arr->capacity == 0 ? 1 : arr->capacity * 2;
-      new_array = X_ARRAY_REALLOC(arr->array, new_capacity * arr->elementSize);
-      if (new_array == NULL)
-      {
-        return XARRAY_MEMORY_ALLOCATION_FAILED;
-      }
-
-      arr->array = new_array;
-      arr->capacity = new_capacity;
+      return XARRAY_MEMORY_ALLOCATION_FAILED;
     }
 
     if (data != NULL)
@@ -434,9 +744,6 @@ extern "C" {
 
   XArrayError x_array_insert(XArray* arr, void* data, unsigned int index)
   {
-    void* new_array;
-    size_t new_capacity;
-
     X_ASSERT(arr != NULL);
 
     if (index > arr->size)
@@ -444,17 +751,9 @@ extern "C" {
       return XARRAY_INDEX_OUT_OF_BOUNDS;
     }
 
-    if (arr->size >= arr->capacity)
+    if (arr->size >= arr->capacity && s_array_grow(arr) != XARRAY_OK)
     {
-      new_capacity = arr->capacity == 0 ? 1 : arr->capacity * 2;
-      new_array = X_ARRAY_REALLOC(arr->array, new_capacity * arr->elementSize);
-      if (new_array == NULL)
-      {
-        return XARRAY_MEMORY_ALLOCATION_FAILED;
-      }
-
-      arr->array = new_array;
-      arr->capacity = new_capacity;
+      return XARRAY_MEMORY_ALLOCATION_FAILED;
     }
 
     memmove((uint8_t*)arr->array + ((index + 1) * arr->elementSize),
@@ -486,8 +785,8 @@ extern "C" {
   {
     X_ASSERT(arr != NULL);
 
-    X_ARRAY_FREE(arr->array);
-    X_ARRAY_FREE(arr);
+    x_array_term(arr);
+    s_array_free(&arr->allocator, arr, sizeof(XArray));
   }
 
   XArrayError x_array_delete_range(XArray* arr, unsigned int start, unsigned int end)
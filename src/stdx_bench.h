@@ -0,0 +1,752 @@
+/**
+ * STDX - Micro benchmark harness
+ * Part of the STDX General Purpose C Library by marciovmf
+ * License: MIT
+ * <https://github.com/marciovmf/stdx>
+ *
+ * ## Overview
+ *
+ * - Companion of stdx_test for timing instead of pass/fail
+ * - Iteration counts calibrated so every repetition runs for a minimum time
+ * - Warmup, repeated measurements, mean/median/stddev and operations per second
+ * - Hardware counters (cycles, instructions, branch and cache misses) via
+ *   perf_event on Linux, when the kernel allows it
+ * - Machine-readable JSON results and comparison against a stored baseline
+ *
+ * ## Usage
+ *
+ * A benchmark receives an XBench and runs its body `b->iterations` times.
+ * Setup done before the loop can be excluded with x_bench_reset_timer(),
+ * and work inside it with x_bench_pause() / x_bench_resume(). Results the
+ * compiler could otherwise discard go through x_bench_keep_u64(), and
+ * inputs it could otherwise treat as loop invariant through x_bench_keep().
+ *
+ *     void bench_sum(XBench* b)
+ *     {
+ *       x_bench_set_bytes(b, sizeof(data));
+ *       for (uint64_t i = 0; i < b->iterations; i++)
+ *       {
+ *         x_bench_keep(data);
+ *         x_bench_keep_u64(sum(data, count));
+ *       }
+ *     }
+ *
+ *     int main(int argc, char** argv)
+ *     {
+ *       XBenchCase benches[] = {
+ *         X_BENCH(bench_sum)
+ *       };
+ *       return x_bench_run(benches, sizeof(benches)/sizeof(benches[0]), argc, argv);
+ *     }
+ *
+ * x_bench_run() understands these arguments:
+ *
+ *     --filter <text>     run only benchmarks whose name contains text
+ *     --reps <n>          repetitions per benchmark (X_BENCH_REPETITIONS)
+ *     --min-time <ms>     minimum duration of one repetition (X_BENCH_MIN_TIME_MS)
+ *     --json <file>       write the results as JSON
+ *     --baseline <file>   compare against JSON written by an earlier run
+ *     --threshold <pct>   median slowdown that counts as a regression (X_BENCH_THRESHOLD)
+ *     --help, -h          print this list and exit without running anything
+ *
+ * The program exits with 1 if any benchmark regressed against the baseline.
+ *
+ * ## How to compile
+ *
+ * To compile the implementation define `X_IMPL_BENCH`
+ * in **one** source file before including this header.
+ * Benchmarks are only meaningful in optimized builds.
+ *
+ * ## Dependencies
+ *
+ *  stdx_time.h (tick counter; the implementation is compiled with X_IMPL_BENCH
+ *  unless `X_IMPL_TIME` is already defined elsewhere)
+ */
+#ifndef X_BENCH_H
+#define X_BENCH_H
+
+#define X_BENCH_VERSION_MAJOR 1
+#define X_BENCH_VERSION_MINOR 0
+#define X_BENCH_VERSION_PATCH 0
+
+#define X_BENCH_VERSION (X_BENCH_VERSION_MAJOR * 10000 + X_BENCH_VERSION_MINOR * 100 + X_BENCH_VERSION_PATCH)
+
+#ifdef X_IMPL_BENCH
+#ifndef X_IMPL_TIME
+#define X_INTERNAL_BENCH_TIME_IMPL
+#define X_IMPL_TIME
+#endif
+#endif
+#include "stdx_time.h"
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifndef X_BENCH_REPETITIONS
+/**
+ * Default number of measured repetitions per benchmark.
+ * Can be overriden before including this header
+ */
+#define X_BENCH_REPETITIONS 5
+#endif  // X_BENCH_REPETITIONS
+
+#ifndef X_BENCH_MIN_TIME_MS
+/**
+ * Default minimum duration of one repetition, in milliseconds.
+ * Can be overriden before including this header
+ */
+#define X_BENCH_MIN_TIME_MS 100
+#endif  // X_BENCH_MIN_TIME_MS
+
+#ifndef X_BENCH_THRESHOLD
+/**
+ * Default median slowdown, in percent, reported as a regression.
+ * Can be overriden before including this header
+ */
+#define X_BENCH_THRESHOLD 10.0
+#endif  // X_BENCH_THRESHOLD
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  typedef enum XBenchCounter
+  {
+    X_BENCH_CYCLES,
+    X_BENCH_INSTRUCTIONS,
+    X_BENCH_BRANCH_MISSES,
+    X_BENCH_CACHE_MISSES,
+    X_BENCH_COUNTER_COUNT
+  } XBenchCounter;
+
+  /**
+   * @brief State handed to a benchmark function.
+   *
+   * `iterations` is the number of times the function must run its body.
+   * The other fields belong to the harness.
+   */
+  typedef struct XBench
+  {
+    uint64_t iterations;
+    uint64_t bytes;                 // per iteration, set with x_bench_set_bytes()
+    uint64_t items;                 // per iteration, set with x_bench_set_items()
+    uint64_t start;
+    uint64_t elapsed;
+    bool running;
+    int32_t perf_fd;                // perf_event group leader, -1 without counters
+    int32_t perf_count;
+    int32_t perf_fds[X_BENCH_COUNTER_COUNT];
+    XBenchCounter perf_ids[X_BENCH_COUNTER_COUNT];
+  } XBench;
+
+  /**
+   * @brief Benchmark function signature.
+   * @param b Harness state; run the body b->iterations times.
+   */
+  typedef void (*XBenchFunction)(XBench* b);
+
+  typedef struct XBenchCase
+  {
+    const char* name;
+    XBenchFunction func;
+  } XBenchCase;
+
+#define X_BENCH(name) {#name, name}
+
+  /**
+   * @brief Measured results of one benchmark.
+   */
+  typedef struct XBenchResult
+  {
+    const char* name;
+    uint64_t iterations;            // per repetition
+    int32_t repetitions;
+    double mean_ns;                 // per iteration
+    double median_ns;
+    double stddev_ns;
+    double min_ns;
+    double ops_per_sec;             // from the median
+    double bytes_per_sec;           // 0 unless the benchmark set bytes
+    double items_per_sec;           // 0 unless the benchmark set items
+    double counters[X_BENCH_COUNTER_COUNT];   // per iteration, -1 if unavailable
+    double baseline_ns;             // baseline median, 0 if none
+    bool regressed;
+  } XBenchResult;
+
+  /**
+   * @brief Options of x_bench_run_ex().
+   */
+  typedef struct XBenchOptions
+  {
+    const char* filter;             // substring of names to run, NULL for all
+    int32_t repetitions;
+    double min_time_ms;
+    const char* json_path;          // NULL for no JSON
+    const char* baseline_path;      // NULL for no comparison
+    double threshold;               // percent
+    bool quiet;                     // no table on stdout
+  } XBenchOptions;
+
+  /**
+   * @brief Fill options with the defaults.
+   * @param options Options to initialize.
+   */
+  void x_bench_options_init(XBenchOptions* options);
+
+  /**
+   * @brief Run benchmarks with options taken from the command line.
+   * @param benches Benchmarks to run.
+   * @param count Number of benchmarks.
+   * @param argc Argument count of main().
+   * @param argv Arguments of main().
+   * @return 0 on success or after printing --help, 1 if a benchmark regressed
+   * or the arguments or files were invalid.
+   */
+  int x_bench_run(XBenchCase* benches, int32_t count, int argc, char** argv);
+
+  /**
+   * @brief Run benchmarks.
+   * @param benches Benchmarks to run.
+   * @param count Number of benchmarks.
+   * @param options Options, or NULL for the defaults.
+   * @param results Receives one result per benchmark run, in order; may be NULL.
+   * @return Number of regressions, or -1 if a file could not be read or written.
+   */
+  int x_bench_run_ex(XBenchCase* benches, int32_t count, const XBenchOptions* options, XBenchResult* results);
+
+  /**
+   * @brief Exclude everything the benchmark did so far from the measurement.
+   * @param b Harness state.
+   */
+  void x_bench_reset_timer(XBench* b);
+
+  /**
+   * @brief Stop measuring, e.g. around per-iteration setup.
+   * @param b Harness state.
+   */
+  void x_bench_pause(XBench* b);
+
+  /**
+   * @brief Resume measuring after x_bench_pause().
+   * @param b Harness state.
+   */
+  void x_bench_resume(XBench* b);
+
+  /**
+   * @brief Report throughput: bytes processed by one iteration.
+   * @param b Harness state.
+   * @param bytes Bytes per iteration.
+   */
+  static inline void x_bench_set_bytes(XBench* b, uint64_t bytes) { b->bytes = bytes; }
+
+  /**
+   * @brief Report throughput: items processed by one iteration.
+   * @param b Harness state.
+   * @param items Items per iteration.
+   */
+  static inline void x_bench_set_items(XBench* b, uint64_t items) { b->items = items; }
+
+  /**
+   * @brief Make the compiler assume the memory at `p` is read, so the work
+   * producing it is not optimized away.
+   * @param p Any pointer.
+   */
+  static inline void x_bench_keep(const void* p)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__ __volatile__("" : : "g"(p) : "memory");
+#else
+    static const void* volatile sink;
+    sink = p;
+#endif
+  }
+
+  /**
+   * @brief Make the compiler assume `v` is used.
+   * @param v Any value.
+   */
+  static inline void x_bench_keep_u64(uint64_t v)
+  {
+#if defined(__GNUC__) || defined(__clang__)
+    __asm__ __volatile__("" : : "r"(v) : "memory");
+#else
+    static volatile uint64_t sink;
+    sink = v;
+#endif
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef X_IMPL_BENCH
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  static const char* s_x_bench_counter_names[X_BENCH_COUNTER_COUNT] =
+  {
+    "cycles", "instructions", "branch_misses", "cache_misses"
+  };
+
+  // Newton's method, so the harness doesn't need libm
+  static double s_x_bench_sqrt(double v)
+  {
+    if (v <= 0.0) return 0.0;
+    double x = v > 1.0 ? v : 1.0;
+    for (int32_t i = 0; i < 64; i++)
+    {
+      double next = 0.5 * (x + v / x);
+      if (next >= x) break;
+      x = next;
+    }
+    return x;
+  }
+
+#if defined(__linux__)
+  static int32_t s_x_bench_perf_open(uint64_t config, int32_t group)
+  {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = group < 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int32_t)syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+  }
+#endif
+
+  /* Opens the counters the kernel lets us have; b->perf_fd stays -1 if none */
+  static void s_x_bench_perf_init(XBench* b)
+  {
+    b->perf_fd = -1;
+    b->perf_count = 0;
+#if defined(__linux__)
+    static const uint64_t configs[X_BENCH_COUNTER_COUNT] =
+    {
+      PERF_COUNT_HW_CPU_CYCLES,
+      PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_BRANCH_MISSES,
+      PERF_COUNT_HW_CACHE_MISSES
+    };
+    for (int32_t i = 0; i < X_BENCH_COUNTER_COUNT; i++)
+    {
+      int32_t fd = s_x_bench_perf_open(configs[i], b->perf_fd);
+      if (fd < 0)
+      {
+        if (b->perf_fd < 0) return;   // no leader, no counters
+        continue;
+      }
+      if (b->perf_fd < 0) b->perf_fd = fd;
+      b->perf_fds[b->perf_count] = fd;
+      b->perf_ids[b->perf_count++] = (XBenchCounter)i;
+    }
+#endif
+  }
+
+  static void s_x_bench_perf_close(XBench* b)
+  {
+#if defined(__linux__)
+    for (int32_t i = 0; i < b->perf_count; i++)
+      close(b->perf_fds[i]);
+#endif
+    b->perf_fd = -1;
+    b->perf_count = 0;
+  }
+
+  static void s_x_bench_perf_enable(XBench* b, bool enable)
+  {
+#if defined(__linux__)
+    if (b->perf_fd >= 0)
+      ioctl(b->perf_fd, enable ? PERF_EVENT_IOC_ENABLE : PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+#else
+    (void)b;
+    (void)enable;
+#endif
+  }
+
+  static void s_x_bench_perf_reset(XBench* b)
+  {
+#if defined(__linux__)
+    if (b->perf_fd >= 0)
+      ioctl(b->perf_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+#else
+    (void)b;
+#endif
+  }
+
+  /* Adds the counter values of the last run to `sums` */
+  static void s_x_bench_perf_read(XBench* b, double* sums)
+  {
+#if defined(__linux__)
+    uint64_t values[1 + X_BENCH_COUNTER_COUNT];
+    if (b->perf_fd < 0)
+      return;
+    if (read(b->perf_fd, values, sizeof(values)) < (ssize_t)sizeof(uint64_t))
+      return;
+    for (uint64_t i = 0; i < values[0] && i < (uint64_t)b->perf_count; i++)
+      sums[b->perf_ids[i]] += (double)values[1 + i];
+#else
+    (void)b;
+    (void)sums;
+#endif
+  }
+
+  void x_bench_reset_timer(XBench* b)
+  {
+    b->elapsed = 0;
+    s_x_bench_perf_reset(b);
+    if (b->running)
+      b->start = x_ticks_now();
+  }
+
+  void x_bench_pause(XBench* b)
+  {
+    if (!b->running) return;
+    b->elapsed += x_ticks_now() - b->start;
+    s_x_bench_perf_enable(b, false);
+    b->running = false;
+  }
+
+  void x_bench_resume(XBench* b)
+  {
+    if (b->running) return;
+    b->running = true;
+    s_x_bench_perf_enable(b, true);
+    b->start = x_ticks_now();
+  }
+
+  /* Runs the benchmark body once for `iterations`. Returns elapsed nanoseconds. */
+  static uint64_t s_x_bench_once(XBenchFunction fn, XBench* b, uint64_t iterations, double* counters)
+  {
+    b->iterations = iterations;
+    b->elapsed = 0;
+    b->running = false;
+    s_x_bench_perf_reset(b);
+    x_bench_resume(b);
+    fn(b);
+    x_bench_pause(b);
+    if (counters)
+      s_x_bench_perf_read(b, counters);
+    return x_ticks_to_ns(b->elapsed);
+  }
+
+  /* Grows the iteration count until one run takes at least `min_ns`; the runs double as warmup */
+  static uint64_t s_x_bench_calibrate(XBenchFunction fn, XBench* b, double min_ns)
+  {
+    uint64_t n = 1;
+    for (;;)
+    {
+      uint64_t ns = s_x_bench_once(fn, b, n, NULL);
+      if ((double)ns >= min_ns || n >= (1ull << 40))
+        return n;
+      // Aim 20% past the target, at most 100x per step, so one slow outlier can't blow it up
+      double next = ns > 0 ? (double)n * min_ns * 1.2 / (double)ns : (double)n * 100.0;
+      if (next > (double)n * 100.0) next = (double)n * 100.0;
+      n = next < (double)(n + 1) ? n + 1 : (uint64_t)next;
+    }
+  }
+
+  static int s_x_bench_cmp_double(const void* a, const void* b)
+  {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+  }
+
+  static void s_x_bench_measure(const XBenchCase* bench, const XBenchOptions* options, XBenchResult* r)
+  {
+    XBench b;
+    memset(&b, 0, sizeof(b));
+    double min_ns = options->min_time_ms * 1e6;
+    int32_t reps = options->repetitions > 0 ? options->repetitions : 1;
+    double* samples = (double*)malloc(sizeof(double) * (size_t)reps);
+    double counters[X_BENCH_COUNTER_COUNT] = {0};
+
+    memset(r, 0, sizeof(*r));
+    r->name = bench->name;
+    r->repetitions = reps;
+
+    s_x_bench_perf_init(&b);
+    uint64_t n = s_x_bench_calibrate(bench->func, &b, min_ns);
+    s_x_bench_once(bench->func, &b, n, NULL);    // one more warmup at the final count
+
+    double sum = 0.0;
+    for (int32_t i = 0; i < reps; i++)
+    {
+      uint64_t ns = s_x_bench_once(bench->func, &b, n, counters);
+      double per = (double)ns / (double)n;
+      if (samples) samples[i] = per;
+      sum += per;
+    }
+
+    r->iterations = n;
+    r->mean_ns = sum / reps;
+    r->min_ns = r->mean_ns;
+    r->median_ns = r->mean_ns;
+    if (samples)
+    {
+      double var = 0.0;
+      for (int32_t i = 0; i < reps; i++)
+        var += (samples[i] - r->mean_ns) * (samples[i] - r->mean_ns);
+      r->stddev_ns = reps > 1 ? s_x_bench_sqrt(var / (reps - 1)) : 0.0;
+
+      qsort(samples, (size_t)reps, sizeof(double), s_x_bench_cmp_double);
+      r->min_ns = samples[0];
+      r->median_ns = (reps & 1) ? samples[reps / 2] : (samples[reps / 2 - 1] + samples[reps / 2]) / 2.0;
+      free(samples);
+    }
+
+    double seconds_per_op = r->median_ns / 1e9;
+    r->ops_per_sec = seconds_per_op > 0.0 ? 1.0 / seconds_per_op : 0.0;
+    r->bytes_per_sec = seconds_per_op > 0.0 ? (double)b.bytes / seconds_per_op : 0.0;
+    r->items_per_sec = seconds_per_op > 0.0 ? (double)b.items / seconds_per_op : 0.0;
+
+    for (int32_t i = 0; i < X_BENCH_COUNTER_COUNT; i++)
+      r->counters[i] = -1.0;
+    for (int32_t i = 0; i < b.perf_count; i++)
+      r->counters[b.perf_ids[i]] = counters[b.perf_ids[i]] / ((double)n * reps);
+
+    s_x_bench_perf_close(&b);
+  }
+
+  /* Finds the median of `name` in JSON written by s_x_bench_write_json. Returns 0 if absent. */
+  static double s_x_bench_baseline(const char* json, const char* name)
+  {
+    char key[256];
+    snprintf(key, sizeof(key), "\"name\":\"%s\"", name);
+    const char* p = strstr(json, key);
+    if (!p) return 0.0;
+    const char* end = strchr(p, '}');
+    const char* m = strstr(p, "\"median_ns\":");
+    if (!m || (end && m > end)) return 0.0;
+    return strtod(m + 12, NULL);
+  }
+
+  static char* s_x_bench_read_file(const char* path)
+  {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    char* text = NULL;
+    if (fseek(f, 0, SEEK_END) == 0)
+    {
+      long len = ftell(f);
+      if (len >= 0 && fseek(f, 0, SEEK_SET) == 0 && (text = (char*)malloc((size_t)len + 1)) != NULL)
+      {
+        size_t got = fread(text, 1, (size_t)len, f);
+        text[got] = 0;
+      }
+    }
+    fclose(f);
+    return text;
+  }
+
+  static bool s_x_bench_write_json(const char* path, const XBenchResult* results, int32_t count)
+  {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    fprintf(f, "{\"benchmarks\":[");
+    for (int32_t i = 0; i < count; i++)
+    {
+      const XBenchResult* r = &results[i];
+      fprintf(f, "%s\n{\"name\":\"%s\",\"iterations\":%llu,\"repetitions\":%d,"
+          "\"mean_ns\":%.4f,\"median_ns\":%.4f,\"stddev_ns\":%.4f,\"min_ns\":%.4f,"
+          "\"ops_per_sec\":%.2f,\"bytes_per_sec\":%.2f,\"items_per_sec\":%.2f",
+          i ? "," : "", r->name, (unsigned long long)r->iterations, r->repetitions,
+          r->mean_ns, r->median_ns, r->stddev_ns, r->min_ns,
+          r->ops_per_sec, r->bytes_per_sec, r->items_per_sec);
+      for (int32_t c = 0; c < X_BENCH_COUNTER_COUNT; c++)
+      {
+        if (r->counters[c] >= 0.0)
+          fprintf(f, ",\"%s\":%.3f", s_x_bench_counter_names[c], r->counters[c]);
+      }
+      if (r->baseline_ns > 0.0)
+        fprintf(f, ",\"baseline_ns\":%.4f,\"regressed\":%s", r->baseline_ns, r->regressed ? "true" : "false");
+      fputc('}', f);
+    }
+    fprintf(f, "\n]}\n");
+    bool ok = !ferror(f);
+    return fclose(f) == 0 && ok;
+  }
+
+  /* Formats `v` with a k/M/G suffix */
+  static const char* s_x_bench_si(double v, char* buf, size_t cap)
+  {
+    if (v <= 0.0) snprintf(buf, cap, "-");
+    else if (v >= 1e9) snprintf(buf, cap, "%.2fG", v / 1e9);
+    else if (v >= 1e6) snprintf(buf, cap, "%.2fM", v / 1e6);
+    else if (v >= 1e3) snprintf(buf, cap, "%.2fk", v / 1e3);
+    else snprintf(buf, cap, "%.2f", v);
+    return buf;
+  }
+
+  static void s_x_bench_print(const XBenchResult* r)
+  {
+    char ops[32], rate[32], items[32], cycles[32], ipc[32], base[32];
+    const double* c = r->counters;
+    double stddev_pct = r->mean_ns > 0.0 ? 100.0 * r->stddev_ns / r->mean_ns : 0.0;
+
+    if (r->bytes_per_sec > 0.0) snprintf(rate, sizeof(rate), "%.1f MB/s", r->bytes_per_sec / 1e6);
+    else if (r->items_per_sec > 0.0) snprintf(rate, sizeof(rate), "%s items/s", s_x_bench_si(r->items_per_sec, items, sizeof(items)));
+    else snprintf(rate, sizeof(rate), "-");
+    if (c[X_BENCH_CYCLES] >= 0.0) snprintf(cycles, sizeof(cycles), "%.1f", c[X_BENCH_CYCLES]);
+    else snprintf(cycles, sizeof(cycles), "-");
+    if (c[X_BENCH_CYCLES] > 0.0 && c[X_BENCH_INSTRUCTIONS] >= 0.0) snprintf(ipc, sizeof(ipc), "%.2f", c[X_BENCH_INSTRUCTIONS] / c[X_BENCH_CYCLES]);
+    else snprintf(ipc, sizeof(ipc), "-");
+    if (r->baseline_ns > 0.0)
+      snprintf(base, sizeof(base), "%+.1f%%%s", 100.0 * (r->median_ns / r->baseline_ns - 1.0), r->regressed ? " REGRESSED" : "");
+    else
+      snprintf(base, sizeof(base), "-");
+
+    printf("%-36.36s %12.2f %7.1f%% %10s %14s %10s %6s  %s\n",
+        r->name, r->median_ns, stddev_pct, s_x_bench_si(r->ops_per_sec, ops, sizeof(ops)), rate, cycles, ipc, base);
+  }
+
+  void x_bench_options_init(XBenchOptions* options)
+  {
+    memset(options, 0, sizeof(*options));
+    options->repetitions = X_BENCH_REPETITIONS;
+    options->min_time_ms = X_BENCH_MIN_TIME_MS;
+    options->threshold = X_BENCH_THRESHOLD;
+  }
+
+  int x_bench_run_ex(XBenchCase* benches, int32_t count, const XBenchOptions* options, XBenchResult* results)
+  {
+    XBenchOptions defaults;
+    if (!options)
+    {
+      x_bench_options_init(&defaults);
+      options = &defaults;
+    }
+
+    char* baseline = NULL;
+    if (options->baseline_path && !(baseline = s_x_bench_read_file(options->baseline_path)))
+    {
+      fprintf(stderr, "Can't read the benchmark baseline '%s'\n", options->baseline_path);
+      return -1;
+    }
+
+    XBenchResult* all = (XBenchResult*)malloc(sizeof(XBenchResult) * (size_t)(count > 0 ? count : 1));
+    if (!all)
+    {
+      free(baseline);
+      return -1;
+    }
+
+    if (!options->quiet)
+      printf("%-36s %12s %8s %10s %14s %10s %6s  %s\n",
+          "benchmark", "ns/op", "+/-", "ops/s", "throughput", "cycles/op", "IPC", "vs baseline");
+
+    int32_t ran = 0;
+    int regressions = 0;
+    for (int32_t i = 0; i < count; i++)
+    {
+      if (options->filter && !strstr(benches[i].name, options->filter))
+        continue;
+
+      XBenchResult* r = &all[ran++];
+      s_x_bench_measure(&benches[i], options, r);
+      if (baseline)
+      {
+        r->baseline_ns = s_x_bench_baseline(baseline, r->name);
+        r->regressed = r->baseline_ns > 0.0 && r->median_ns > r->baseline_ns * (1.0 + options->threshold / 100.0);
+        regressions += r->regressed;
+      }
+      if (!options->quiet)
+      {
+        s_x_bench_print(r);
+        fflush(stdout);
+      }
+    }
+
+    int status = regressions;
+    if (options->json_path && !s_x_bench_write_json(options->json_path, all, ran))
+    {
+      fprintf(stderr, "Can't write the benchmark results '%s'\n", options->json_path);
+      status = -1;
+    }
+    if (results)
+      memcpy(results, all, sizeof(XBenchResult) * (size_t)ran);
+    free(all);
+    free(baseline);
+    return status;
+  }
+
+  static void s_bench_usage(const char* exe)
+  {
+    printf("usage: %s [options]\n"
+        "  --filter <text>     run only benchmarks whose name contains text\n"
+        "  --reps <n>          repetitions per benchmark (default %d)\n"
+        "  --min-time <ms>     minimum duration of one repetition (default %g)\n"
+        "  --json <file>       write the results as JSON\n"
+        "  --baseline <file>   compare against JSON written by an earlier run\n"
+        "  --threshold <pct>   median slowdown that counts as a regression (default %g)\n"
+        "  --help, -h          print this list and exit\n",
+        exe ? exe : "bench", X_BENCH_REPETITIONS, (double) X_BENCH_MIN_TIME_MS, (double) X_BENCH_THRESHOLD);
+  }
+
+  int x_bench_run(XBenchCase* benches, int32_t count, int argc, char** argv)
+  {
+    XBenchOptions options;
+    x_bench_options_init(&options);
+
+    for (int i = 1; i < argc; i++)
+    {
+      const char* arg = argv[i];
+      if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0)
+      {
+        s_bench_usage(argv[0]);
+        return 0;
+      }
+
+      const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+      if (!value)
+      {
+        fprintf(stderr, "Missing value for '%s'\n", arg);
+        return 1;
+      }
+      if (strcmp(arg, "--filter") == 0)         options.filter = value;
+      else if (strcmp(arg, "--reps") == 0)      options.repetitions = atoi(value);
+      else if (strcmp(arg, "--min-time") == 0)  options.min_time_ms = atof(value);
+      else if (strcmp(arg, "--json") == 0)      options.json_path = value;
+      else if (strcmp(arg, "--baseline") == 0)  options.baseline_path = value;
+      else if (strcmp(arg, "--threshold") == 0) options.threshold = atof(value);
+      else
+      {
+        fprintf(stderr, "Unknown argument '%s'\n", arg);
+        return 1;
+      }
+      i++;
+    }
+
+    return x_bench_run_ex(benches, count, &options, NULL) != 0;
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // X_IMPL_BENCH
+
+#ifdef X_INTERNAL_BENCH_TIME_IMPL
+#undef X_IMPL_TIME
+#undef X_INTERNAL_BENCH_TIME_IMPL
+#endif
+
+#endif  // X_BENCH_H
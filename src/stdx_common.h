@@ -222,6 +222,7 @@ extern "C" {
 #endif // X_OS_WINDOWS
 
 #include <stdint.h>
+#include <stddef.h>
 #if defined(_DEBUG) || defined(DEBUG)
 #include <stdio.h>
 #endif
@@ -244,6 +245,24 @@ extern "C" {
 #endif
 
 
+  // -----------------------------------------------------------------------------
+  // A XAllocator routes a container's memory through caller-supplied functions
+  // at runtime, instead of the compile-time X_*_ALLOC macros. Containers take
+  // it at creation and keep a copy; a NULL allocator means "use the macros".
+  // All three functions must be set. Sizes are passed back on realloc/free so
+  // bump allocators can use them.
+  // stdx_arena.h provides x_arena_allocator().
+  // -----------------------------------------------------------------------------
+
+  typedef struct XAllocator
+  {
+    void* (*alloc_fn)(void* user, size_t size);
+    void* (*realloc_fn)(void* user, void* ptr, size_t old_size, size_t new_size);
+    void  (*free_fn)(void* user, void* ptr, size_t size);
+    void* user;
+  } XAllocator;
+
+
   // ----------------------------------------------------------------------------
   // Assertion macros
   // ----------------------------------------------------------------------------
@@ -0,0 +1,1113 @@
+/**
+ * STDX - Concurrent Hashtable
+ * Part of the STDX General Purpose C Library by marciovmf
+ * License: MIT
+ * <https://github.com/marciovmf/stdx>
+ *
+ * ## Overview
+ *
+ * A hashtable for read-mostly data shared between threads (MIME types,
+ * routes, interned strings). It has the same shape as `XHashtable`
+ * (set/get/has/remove/iter, the same key/value traits and callbacks) but
+ * every function may be called from any thread at any time.
+ *
+ * - Reads never lock. A lookup loads the table of one shard, probes its
+ *   slots and copies the value out, touching only shared memory that is
+ *   never written by other readers. Read throughput scales with cores.
+ * - Writes lock one of `X_CONCURRENT_HASHTABLE_SHARDS` shards, chosen by
+ *   the key hash. Writers to different shards do not contend.
+ * - Entries are immutable nodes. Overwriting a key publishes a new node;
+ *   removing it publishes a tombstone. Growing a shard publishes a new
+ *   slot array.
+ * - Replaced nodes and arrays are freed by epoch-based reclamation: a
+ *   writer only frees memory once every thread that was reading when it
+ *   was unpublished has left its read section.
+ *
+ * Pointers obtained from the table (pointer/string values copied out by
+ * `get`, or keys and values produced by the iterator) stay valid until the
+ * enclosing read section ends. Wrap such reads in
+ * `x_concurrent_hashtable_read_begin()` / `x_concurrent_hashtable_read_end()`.
+ * Plain values copied out by `get` need no read section.
+ *
+ * Each reading thread claims one of `X_CONCURRENT_HASHTABLE_MAX_READERS`
+ * reader records on first use. Threads that stop using the table should
+ * call `x_concurrent_hashtable_thread_detach()` before exiting. When all
+ * records are in use, extra threads still read correctly, but memory
+ * reclamation pauses while any of them is inside a read.
+ *
+ * ## How to compile
+ *
+ * To compile the implementation define `X_IMPL_CONCURRENT_HASHTABLE`
+ * in **one** source file before including this header.
+ *
+ * To customize how this module allocates memory, define
+ * `X_CONCURRENT_HASHTABLE_ALLOC` / `X_CONCURRENT_HASHTABLE_FREE` before including.
+ *
+ * ## Typed usage
+ *
+ * ```
+ * X_CONCURRENT_HASHTABLE_TYPE_CSTR_KEY_NAMED(int32_t, routes)
+ * XConcurrentHashtable_routes* ht = x_concurrent_hashtable_routes_create();
+ * x_concurrent_hashtable_routes_set(ht, "/index.html", 1);
+ * int32_t id;
+ * if (x_concurrent_hashtable_routes_get(ht, "/index.html", &id)) { ... }
+ * ```
+ *
+ * The typed macros mirror the `X_HASHTABLE_TYPE*` family.
+ *
+ * ## Dependencies
+ *
+ *  stdx_hashtable.h (hash/compare/clone helpers, implementation required)
+ *  stdx_thread.h (mutexes and atomics, implementation required)
+ *
+ */
+
+#ifndef X_CONCURRENT_HASHTABLE_H
+#define X_CONCURRENT_HASHTABLE_H
+
+#include "stdx_hashtable.h"
+#include "stdx_thread.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef X_CONCURRENT_HASHTABLE_API
+#define X_CONCURRENT_HASHTABLE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define X_CONCURRENT_HASHTABLE_VERSION_MAJOR 1
+#define X_CONCURRENT_HASHTABLE_VERSION_MINOR 0
+#define X_CONCURRENT_HASHTABLE_VERSION_PATCH 0
+
+#define X_CONCURRENT_HASHTABLE_VERSION (X_CONCURRENT_HASHTABLE_VERSION_MAJOR * 10000 + X_CONCURRENT_HASHTABLE_VERSION_MINOR * 100 + X_CONCURRENT_HASHTABLE_VERSION_PATCH)
+
+#ifndef X_CONCURRENT_HASHTABLE_SHARDS
+/**
+ * @brief Number of independently locked shards. Must be a power of two, at most 256.
+ */
+#define X_CONCURRENT_HASHTABLE_SHARDS 16
+#endif
+
+#ifndef X_CONCURRENT_HASHTABLE_MAX_READERS
+/**
+ * @brief Number of reader records shared by all concurrent hashtables in the process.
+ */
+#define X_CONCURRENT_HASHTABLE_MAX_READERS 256
+#endif
+
+#ifndef X_CONCURRENT_HASHTABLE_RECLAIM_THRESHOLD
+/**
+ * @brief Number of retired nodes/arrays a shard accumulates before a writer tries to free them.
+ */
+#define X_CONCURRENT_HASHTABLE_RECLAIM_THRESHOLD 64
+#endif
+
+  typedef struct XConcurrentHashtable XConcurrentHashtable;
+
+  typedef struct
+  {
+    XConcurrentHashtable* table;
+    uint32_t shard;
+    size_t index;
+    void* shard_table;  /* slot array of the shard being walked */
+  } XConcurrentHashtableIter;
+
+  /**
+   * @brief Create a concurrent hashtable using raw size and explicit string/pointer traits.
+   * Traits have the same meaning as in x_hashtable_create_ex().
+   * @param key_size Size in bytes of the key type.
+   * @param key_null_terminated True if the key is a NUL-terminated string (C string).
+   * @param key_is_pointer True if the key is stored as a pointer value.
+   * @param value_size Size in bytes of the value type.
+   * @param value_null_terminated True if the value is a NUL-terminated string (C string).
+   * @param value_is_pointer True if the value is stored as a pointer value.
+   * @return Pointer to a newly created table, or NULL on failure.
+   */
+  X_CONCURRENT_HASHTABLE_API XConcurrentHashtable* x_concurrent_hashtable_create_ex(
+      size_t key_size,
+      bool key_null_terminated,
+      bool key_is_pointer,
+      size_t value_size,
+      bool value_null_terminated,
+      bool value_is_pointer);
+
+  /**
+   * @brief Create a fully-configurable concurrent hashtable.
+   * Callbacks follow the contract of x_hashtable_create_full(). Hash and
+   * compare callbacks run on reader threads and must be thread safe.
+   * @return Pointer to a newly created table, or NULL on failure.
+   */
+  X_CONCURRENT_HASHTABLE_API XConcurrentHashtable* x_concurrent_hashtable_create_full(
+      size_t          key_size,
+      size_t          value_size,
+      XHashFnHash     fn_key_hash,
+      XHashFnCompare  fn_key_compare,
+      XHashFnClone    fn_key_copy,
+      XHashFnDestroy  fn_key_free,
+      XHashFnClone    fn_value_copy,
+      XHashFnDestroy  fn_value_free);
+
+  /**
+   * @brief Destroy a concurrent hashtable. No other thread may be using it.
+   * @param table Table to destroy.
+   * @return Nothing.
+   */
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_destroy(XConcurrentHashtable* table);
+
+  /**
+   * @brief Insert or update a key/value pair. Locks the key's shard.
+   * @param table Table instance.
+   * @param key Pointer to the key data.
+   * @param value Pointer to the value data.
+   * @return True on success, false on failure (e.g., allocation failure).
+   */
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_set(XConcurrentHashtable* table, const void* key, const void* value);
+
+  /**
+   * @brief Retrieve a value by key without locking.
+   * @param table Table instance.
+   * @param key Pointer to the key data.
+   * @param out_value Output buffer to receive the value.
+   * @return True if the key was found and out_value was written, false otherwise.
+   */
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_get(XConcurrentHashtable* table, const void* key, void* out_value);
+
+  /**
+   * @brief Check whether a key exists, without locking.
+   * @param table Table instance.
+   * @param key Pointer to the key data.
+   * @return True if the key exists, false otherwise.
+   */
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_has(XConcurrentHashtable* table, const void* key);
+
+  /**
+   * @brief Remove an entry by key. Locks the key's shard.
+   * @param table Table instance.
+   * @param key Pointer to the key data.
+   * @return True if an entry was removed, false if the key was not found.
+   */
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_remove(XConcurrentHashtable* table, const void* key);
+
+  /**
+   * @brief Get the number of stored entries. Only a snapshot while writers are active.
+   * @param table Table instance.
+   * @return Number of key/value pairs.
+   */
+  X_CONCURRENT_HASHTABLE_API size_t x_concurrent_hashtable_count(XConcurrentHashtable* table);
+
+  /**
+   * @brief Enter a read section on the calling thread. Sections nest.
+   * Memory observed through any concurrent hashtable stays valid until the
+   * matching x_concurrent_hashtable_read_end().
+   * @return Nothing.
+   */
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_read_begin(void);
+
+  /**
+   * @brief Leave a read section entered with x_concurrent_hashtable_read_begin().
+   * @return Nothing.
+   */
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_read_end(void);
+
+  /**
+   * @brief Release the calling thread's reader record. Call before a reading thread exits.
+   * @return Nothing.
+   */
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_thread_detach(void);
+
+  /**
+   * @brief Begin iterating. Enters a read section that lasts until x_concurrent_hashtable_iter_end().
+   * Iteration is weakly consistent: entries changed during the walk may or may not be seen.
+   * @param table Table instance.
+   * @param it Iterator to initialize.
+   * @return True if the iterator was initialized, false on invalid args.
+   */
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_iter_begin(XConcurrentHashtable* table, XConcurrentHashtableIter* it);
+
+  /**
+   * @brief Advance iterator to the next entry.
+   * @param it Iterator.
+   * @param out_key Receives pointer to key (user-facing: dereferenced if stored as pointer/string).
+   * @param out_value Receives pointer to value (user-facing: dereferenced if stored as pointer/string).
+   * @return True if an entry was produced, false if iteration finished or invalid args.
+   */
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_iter_next(XConcurrentHashtableIter* it, void** out_key, void** out_value);
+
+  /**
+   * @brief Finish iterating and leave the read section opened by x_concurrent_hashtable_iter_begin().
+   * @param it Iterator.
+   * @return Nothing.
+   */
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_iter_end(XConcurrentHashtableIter* it);
+
+#define X_CONCURRENT_HASHTABLE__WRAPPERS(tk, tv, suffix, key_ptr, key_term, value_ptr, value_term, key_arg, value_arg) \
+  typedef XConcurrentHashtable XConcurrentHashtable_##suffix; \
+  static inline XConcurrentHashtable_##suffix* x_concurrent_hashtable_##suffix##_create(void) \
+  { \
+    return (XConcurrentHashtable_##suffix*)x_concurrent_hashtable_create_ex(sizeof(tk), key_term, key_ptr, sizeof(tv), value_term, value_ptr); \
+  } \
+  static inline bool x_concurrent_hashtable_##suffix##_set(XConcurrentHashtable_##suffix* table, tk key, tv value) \
+  { \
+    return x_concurrent_hashtable_set((XConcurrentHashtable*)table, key_arg, value_arg); \
+  } \
+  static inline bool x_concurrent_hashtable_##suffix##_get(XConcurrentHashtable_##suffix* table, tk key, tv* out_value) \
+  { \
+    return x_concurrent_hashtable_get((XConcurrentHashtable*)table, key_arg, out_value); \
+  } \
+  static inline bool x_concurrent_hashtable_##suffix##_has(XConcurrentHashtable_##suffix* table, tk key) \
+  { \
+    return x_concurrent_hashtable_has((XConcurrentHashtable*)table, key_arg); \
+  } \
+  static inline bool x_concurrent_hashtable_##suffix##_remove(XConcurrentHashtable_##suffix* table, tk key) \
+  { \
+    return x_concurrent_hashtable_remove((XConcurrentHashtable*)table, key_arg); \
+  } \
+  static inline void x_concurrent_hashtable_##suffix##_destroy(XConcurrentHashtable_##suffix* table) \
+  { \
+    x_concurrent_hashtable_destroy((XConcurrentHashtable*)table); \
+  } \
+  static inline size_t x_concurrent_hashtable_##suffix##_count(XConcurrentHashtable_##suffix* table) \
+  { \
+    return x_concurrent_hashtable_count((XConcurrentHashtable*)table); \
+  }
+
+#define X_CONCURRENT_HASHTABLE_TYPE(tk, tv) X_CONCURRENT_HASHTABLE_TYPE_NAMED(tk, tv, tk##_##tv)
+
+#define X_CONCURRENT_HASHTABLE_TYPE_NAMED(tk, tv, suffix) \
+  X_CONCURRENT_HASHTABLE__WRAPPERS(tk, tv, suffix, false, false, false, false, &key, &value)
+
+#define X_CONCURRENT_HASHTABLE_TYPE_PTR_KEY_NAMED(tk, tv, suffix) \
+  X_CONCURRENT_HASHTABLE__WRAPPERS(tk, tv, suffix, true, false, false, false, key, &value)
+
+#define X_CONCURRENT_HASHTABLE_TYPE_CSTR_KEY_NAMED(tv, suffix) \
+  X_CONCURRENT_HASHTABLE__WRAPPERS(const char*, tv, suffix, true, true, false, false, key, &value)
+
+#define X_CONCURRENT_HASHTABLE_TYPE_PTR_VALUE_NAMED(tk, tv, suffix) \
+  X_CONCURRENT_HASHTABLE__WRAPPERS(tk, tv, suffix, false, false, true, false, &key, value)
+
+#define X_CONCURRENT_HASHTABLE_TYPE_PTR_KEY_PTR_VALUE_NAMED(tk, tv, suffix) \
+  X_CONCURRENT_HASHTABLE__WRAPPERS(tk, tv, suffix, true, false, true, false, key, value)
+
+#define X_CONCURRENT_HASHTABLE_TYPE_CSTR_KEY_PTR_VALUE_NAMED(tv, suffix) \
+  X_CONCURRENT_HASHTABLE__WRAPPERS(const char*, tv, suffix, true, true, true, false, key, value)
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef X_IMPL_CONCURRENT_HASHTABLE
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef X_CONCURRENT_HASHTABLE_ALLOC
+/**
+ * @brief Internal macro for allocating memory.
+ * To override how this header allocates memory, define this macro with a
+ * different implementation before including this header.
+ * @param sz  The size of memory to alloc.
+ */
+#define X_CONCURRENT_HASHTABLE_ALLOC(sz) malloc(sz)
+#endif
+
+#ifndef X_CONCURRENT_HASHTABLE_FREE
+/**
+ * @brief Internal macro for freeing memory.
+ * To override how this header frees memory, define this macro with a
+ * different implementation before including this header.
+ * @param p  The address of memory region to free.
+ */
+#define X_CONCURRENT_HASHTABLE_FREE(p) free(p)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /* Node header; key bytes follow at data_offset, value bytes at value_offset */
+  typedef struct
+  {
+    size_t hash;
+  } XConcNode;
+
+  /* Slot array of one shard. Slots hold NULL (never used), the tombstone, or a node. */
+  typedef struct
+  {
+    size_t capacity;
+    void* volatile slots[];
+  } XConcSlots;
+
+  typedef enum
+  {
+    XCONC_RETIRED_NODE,
+    XCONC_RETIRED_SLOTS
+  } XConcRetiredKind;
+
+  typedef struct
+  {
+    void* ptr;
+    int64_t epoch;
+    XConcRetiredKind kind;
+  } XConcRetired;
+
+  typedef struct
+  {
+    XMutex* lock;
+    XConcSlots* volatile slots;
+    volatile int64_t count;
+    size_t used;              /* non-NULL slots, including tombstones */
+    XConcRetired* retired;
+    size_t retired_count;
+    size_t retired_capacity;
+    char pad[X_THREAD_CACHE_LINE_SIZE];
+  } XConcShard;
+
+  struct XConcurrentHashtable
+  {
+    size_t key_size;
+    size_t value_size;
+    size_t data_offset;
+    size_t value_offset;
+    size_t node_size;
+
+    bool key_is_pointer;
+    bool value_is_pointer;
+    bool key_is_null_terminated;
+    bool value_is_null_terminated;
+
+    XHashFnHash       fn_key_hash;
+    XHashFnCompare    fn_key_compare;
+    XHashFnClone      fn_key_copy;
+    XHashFnDestroy    fn_key_free;
+    XHashFnClone      fn_value_copy;
+    XHashFnDestroy    fn_value_free;
+
+    XConcShard shards[X_CONCURRENT_HASHTABLE_SHARDS];
+  };
+
+  /*
+   * Reader records. A reader publishes the global epoch it observed on
+   * entry; 0 means "not reading". Records are process-wide so a thread can
+   * read any number of tables with a single thread-local slot.
+   */
+  typedef struct
+  {
+    volatile int64_t epoch;
+    volatile int32_t in_use;
+    char pad[X_THREAD_CACHE_LINE_SIZE - sizeof(int64_t) - sizeof(int32_t)];
+  } XConcReader;
+
+#define X_CONC_READER_NONE      -1
+#define X_CONC_READER_OVERFLOW  -2
+
+  static XConcReader s_conc_readers[X_CONCURRENT_HASHTABLE_MAX_READERS];
+  static volatile int64_t s_conc_epoch = 1;
+  static volatile int32_t s_conc_overflow_readers = 0;
+  static X_THREAD_LOCAL int32_t s_conc_reader_slot = X_CONC_READER_NONE;
+  static X_THREAD_LOCAL int32_t s_conc_read_depth = 0;
+  static char s_conc_tombstone_storage;
+
+#define X_CONC_TOMBSTONE ((void*)&s_conc_tombstone_storage)
+
+  static int32_t s_conc_reader_claim(void)
+  {
+    int32_t i;
+    for (i = 0; i < X_CONCURRENT_HASHTABLE_MAX_READERS; i++)
+    {
+      if (x_atomic_load_i32(&s_conc_readers[i].in_use) == 0 &&
+          x_atomic_cas_i32(&s_conc_readers[i].in_use, 0, 1))
+      {
+        return i;
+      }
+    }
+    return X_CONC_READER_OVERFLOW;
+  }
+
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_read_begin(void)
+  {
+    if (s_conc_read_depth++ > 0)
+    {
+      return;
+    }
+
+    if (s_conc_reader_slot == X_CONC_READER_NONE)
+    {
+      s_conc_reader_slot = s_conc_reader_claim();
+    }
+
+    if (s_conc_reader_slot >= 0)
+    {
+      /* Sequentially consistent store: the epoch is visible before any slot load that follows */
+      x_atomic_store_i64(&s_conc_readers[s_conc_reader_slot].epoch, x_atomic_load_i64(&s_conc_epoch));
+    }
+    else
+    {
+      x_atomic_fetch_add_i32(&s_conc_overflow_readers, 1);
+    }
+  }
+
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_read_end(void)
+  {
+    if (--s_conc_read_depth > 0)
+    {
+      return;
+    }
+
+    if (s_conc_reader_slot >= 0)
+    {
+      x_atomic_store_i64(&s_conc_readers[s_conc_reader_slot].epoch, 0);
+    }
+    else
+    {
+      x_atomic_fetch_add_i32(&s_conc_overflow_readers, -1);
+    }
+  }
+
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_thread_detach(void)
+  {
+    if (s_conc_read_depth == 0 && s_conc_reader_slot >= 0)
+    {
+      x_atomic_store_i32(&s_conc_readers[s_conc_reader_slot].in_use, 0);
+    }
+    if (s_conc_read_depth == 0)
+    {
+      s_conc_reader_slot = X_CONC_READER_NONE;
+    }
+  }
+
+  static inline void* s_conc_node_key(const XConcurrentHashtable* t, XConcNode* n)
+  {
+    return (char*)n + t->data_offset;
+  }
+
+  static inline void* s_conc_node_value(const XConcurrentHashtable* t, XConcNode* n)
+  {
+    return (char*)n + t->value_offset;
+  }
+
+  static inline XConcShard* s_conc_shard(XConcurrentHashtable* t, size_t hash)
+  {
+    /* Shards use the high bits; slot indices inside a shard use the low bits */
+    return &t->shards[(hash >> (sizeof(size_t) * 8 - 8)) & (X_CONCURRENT_HASHTABLE_SHARDS - 1)];
+  }
+
+  static inline const void* s_conc_lookup_key(const XConcurrentHashtable* t, const void** key)
+  {
+    return (t->key_is_pointer && !t->key_is_null_terminated) ? (const void*)key : *key;
+  }
+
+  static inline bool s_conc_key_eq(const XConcurrentHashtable* t, XConcNode* n, const void* k)
+  {
+    void* stored = s_conc_node_key(t, n);
+    return t->fn_key_compare ?
+      t->fn_key_compare(stored, &k) :
+      memcmp(stored, k, t->key_size) == 0;
+  }
+
+  static XConcSlots* s_conc_slots_alloc(size_t capacity)
+  {
+    XConcSlots* s = (XConcSlots*)X_CONCURRENT_HASHTABLE_ALLOC(sizeof(XConcSlots) + capacity * sizeof(void*));
+    size_t i;
+
+    if (!s)
+    {
+      return NULL;
+    }
+
+    s->capacity = capacity;
+    for (i = 0; i < capacity; i++)
+    {
+      s->slots[i] = NULL;
+    }
+    return s;
+  }
+
+  static void s_conc_node_free(XConcurrentHashtable* t, XConcNode* n)
+  {
+    if (t->fn_key_free)
+    {
+      t->fn_key_free(s_conc_node_key(t, n));
+    }
+    if (t->fn_value_free)
+    {
+      t->fn_value_free(s_conc_node_value(t, n));
+    }
+    X_CONCURRENT_HASHTABLE_FREE(n);
+  }
+
+  static void s_conc_retired_free(XConcurrentHashtable* t, XConcRetired* r)
+  {
+    if (r->kind == XCONC_RETIRED_NODE)
+    {
+      s_conc_node_free(t, (XConcNode*)r->ptr);
+    }
+    else
+    {
+      X_CONCURRENT_HASHTABLE_FREE(r->ptr);
+    }
+  }
+
+  /*
+   * Frees retired memory no reader can still see. Anything retired at
+   * epoch e is safe once every active reader entered after e.
+   */
+  static void s_conc_reclaim(XConcurrentHashtable* t, XConcShard* shard)
+  {
+    int64_t min_epoch = INT64_MAX;
+    size_t i;
+    size_t kept = 0;
+
+    x_atomic_fetch_add_i64(&s_conc_epoch, 1);
+
+    /* Readers without a record publish no epoch, so nothing is provably safe while one is active */
+    if (x_atomic_load_i32(&s_conc_overflow_readers) > 0)
+    {
+      return;
+    }
+
+    for (i = 0; i < X_CONCURRENT_HASHTABLE_MAX_READERS; i++)
+    {
+      int64_t e = x_atomic_load_i64(&s_conc_readers[i].epoch);
+      if (e != 0 && e < min_epoch)
+      {
+        min_epoch = e;
+      }
+    }
+
+    for (i = 0; i < shard->retired_count; i++)
+    {
+      if (shard->retired[i].epoch < min_epoch)
+      {
+        s_conc_retired_free(t, &shard->retired[i]);
+      }
+      else
+      {
+        shard->retired[kept++] = shard->retired[i];
+      }
+    }
+    shard->retired_count = kept;
+  }
+
+  /* Defers freeing ptr, which must already be unreachable from the shard. Caller holds the shard lock. */
+  static bool s_conc_retire(XConcurrentHashtable* t, XConcShard* shard, void* ptr, XConcRetiredKind kind)
+  {
+    if (shard->retired_count == shard->retired_capacity)
+    {
+      size_t new_capacity = shard->retired_capacity ? shard->retired_capacity * 2 : X_CONCURRENT_HASHTABLE_RECLAIM_THRESHOLD;
+      XConcRetired* r = (XConcRetired*)X_CONCURRENT_HASHTABLE_ALLOC(new_capacity * sizeof(XConcRetired));
+      if (!r)
+      {
+        return false;
+      }
+      if (shard->retired)
+      {
+        memcpy(r, shard->retired, shard->retired_count * sizeof(XConcRetired));
+        X_CONCURRENT_HASHTABLE_FREE(shard->retired);
+      }
+      shard->retired = r;
+      shard->retired_capacity = new_capacity;
+    }
+
+    shard->retired[shard->retired_count].ptr = ptr;
+    shard->retired[shard->retired_count].epoch = x_atomic_load_i64(&s_conc_epoch);
+    shard->retired[shard->retired_count].kind = kind;
+    shard->retired_count++;
+
+    if (shard->retired_count >= X_CONCURRENT_HASHTABLE_RECLAIM_THRESHOLD)
+    {
+      s_conc_reclaim(t, shard);
+    }
+    return true;
+  }
+
+  static XConcNode* s_conc_node_create(XConcurrentHashtable* t, size_t hash, const void* key, const void* value)
+  {
+    XConcNode* n = (XConcNode*)X_CONCURRENT_HASHTABLE_ALLOC(t->node_size);
+    const void* k;
+
+    if (!n)
+    {
+      return NULL;
+    }
+
+    n->hash = hash;
+    k = s_conc_lookup_key(t, &key);
+
+    if (t->fn_key_copy)
+    {
+      t->fn_key_copy(s_conc_node_key(t, n), key);
+    }
+    else
+    {
+      memcpy(s_conc_node_key(t, n), k, t->key_size);
+    }
+
+    if (t->fn_value_copy)
+    {
+      t->fn_value_copy(s_conc_node_value(t, n), value);
+    }
+    else
+    {
+      memcpy(s_conc_node_value(t, n),
+          (t->value_is_pointer && !t->value_is_null_terminated) ? (const void*)&value : value,
+          t->value_size);
+    }
+
+    return n;
+  }
+
+  /* Reader-side probe. The caller is inside a read section or holds the shard lock. */
+  static XConcNode* s_conc_find(const XConcurrentHashtable* t, XConcSlots* s, const void* k, size_t hash)
+  {
+    size_t mask = s->capacity - 1;
+    size_t i;
+
+    for (i = 0; i <= mask; i++)
+    {
+      void* p = x_atomic_load_ptr(&s->slots[(hash + i) & mask]);
+
+      if (p == NULL)
+      {
+        return NULL;
+      }
+
+      if (p != X_CONC_TOMBSTONE)
+      {
+        XConcNode* n = (XConcNode*)p;
+        if (n->hash == hash && s_conc_key_eq(t, n, k))
+        {
+          return n;
+        }
+      }
+    }
+
+    return NULL;
+  }
+
+  /* Publishes a rebuilt slot array without tombstones, sized for the live count. Caller holds the lock. */
+  static bool s_conc_grow(XConcurrentHashtable* t, XConcShard* shard)
+  {
+    XConcSlots* old = shard->slots;
+    XConcSlots* s;
+    size_t capacity = old->capacity;
+    size_t live = (size_t)shard->count;
+    size_t i;
+
+    while ((live + 1) * 2 > capacity)
+    {
+      capacity *= 2;
+    }
+
+    s = s_conc_slots_alloc(capacity);
+    if (!s)
+    {
+      return false;
+    }
+
+    for (i = 0; i < old->capacity; i++)
+    {
+      void* p = old->slots[i];
+      if (p != NULL && p != X_CONC_TOMBSTONE)
+      {
+        size_t idx = ((XConcNode*)p)->hash & (capacity - 1);
+        while (s->slots[idx] != NULL)
+        {
+          idx = (idx + 1) & (capacity - 1);
+        }
+        s->slots[idx] = p;
+      }
+    }
+
+    x_atomic_store_ptr((void* volatile*)&shard->slots, s);
+    shard->used = live;
+    return s_conc_retire(t, shard, old, XCONC_RETIRED_SLOTS);
+  }
+
+  X_CONCURRENT_HASHTABLE_API XConcurrentHashtable* x_concurrent_hashtable_create_ex(size_t key_size, bool key_null_terminated, bool key_is_pointer,
+      size_t value_size, bool value_null_terminated, bool value_is_pointer)
+  {
+    XConcurrentHashtable* ht = x_concurrent_hashtable_create_full(
+        key_size,
+        value_size,
+        key_null_terminated   ? x_hashtable_hash_cstr     : x_hashtable_hash_bytes,
+        key_null_terminated   ? x_hashtable_compare_cstr  : NULL,
+        key_null_terminated   ? x_hashtable_clone_cstr    : NULL,
+        key_null_terminated   ? x_hashtable_free_cstr     : NULL,
+        value_null_terminated ? x_hashtable_clone_cstr    : NULL,
+        value_null_terminated ? x_hashtable_free_cstr     : NULL);
+
+    if (!ht)
+    {
+      return NULL;
+    }
+
+    ht->key_is_pointer = key_is_pointer;
+    ht->key_is_null_terminated = key_null_terminated;
+    ht->value_is_pointer = value_is_pointer;
+    ht->value_is_null_terminated = value_null_terminated;
+    return ht;
+  }
+
+  X_CONCURRENT_HASHTABLE_API XConcurrentHashtable* x_concurrent_hashtable_create_full(
+      size_t          key_size,
+      size_t          value_size,
+      XHashFnHash     fn_key_hash,
+      XHashFnCompare  fn_key_compare,
+      XHashFnClone    fn_key_copy,
+      XHashFnDestroy  fn_key_free,
+      XHashFnClone    fn_value_copy,
+      XHashFnDestroy  fn_value_free)
+  {
+    XConcurrentHashtable* t;
+    uint32_t i;
+
+    if (key_size == 0 || !fn_key_hash)
+    {
+      return NULL;
+    }
+
+    t = (XConcurrentHashtable*)X_CONCURRENT_HASHTABLE_ALLOC(sizeof(XConcurrentHashtable));
+    if (!t)
+    {
+      return NULL;
+    }
+
+    memset(t, 0, sizeof(*t));
+    t->key_size = key_size;
+    t->value_size = value_size;
+    t->data_offset = (sizeof(XConcNode) + 7) & ~(size_t)7;
+    t->value_offset = (t->data_offset + key_size + 7) & ~(size_t)7;
+    t->node_size = t->value_offset + value_size;
+
+    t->fn_key_hash = fn_key_hash;
+    t->fn_key_compare = fn_key_compare;
+    t->fn_key_copy = fn_key_copy;
+    t->fn_key_free = fn_key_free;
+    t->fn_value_copy = fn_value_copy;
+    t->fn_value_free = fn_value_free;
+
+    for (i = 0; i < X_CONCURRENT_HASHTABLE_SHARDS; i++)
+    {
+      XConcShard* shard = &t->shards[i];
+      shard->slots = s_conc_slots_alloc(X_HASHTABLE_INITIAL_CAPACITY);
+      if (!shard->slots || x_thread_mutex_init(&shard->lock) != 0)
+      {
+        x_concurrent_hashtable_destroy(t);
+        return NULL;
+      }
+    }
+
+    return t;
+  }
+
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_destroy(XConcurrentHashtable* table)
+  {
+    uint32_t s;
+    size_t i;
+
+    if (!table)
+    {
+      return;
+    }
+
+    for (s = 0; s < X_CONCURRENT_HASHTABLE_SHARDS; s++)
+    {
+      XConcShard* shard = &table->shards[s];
+
+      if (shard->slots)
+      {
+        for (i = 0; i < shard->slots->capacity; i++)
+        {
+          void* p = shard->slots->slots[i];
+          if (p != NULL && p != X_CONC_TOMBSTONE)
+          {
+            s_conc_node_free(table, (XConcNode*)p);
+          }
+        }
+        X_CONCURRENT_HASHTABLE_FREE(shard->slots);
+      }
+
+      for (i = 0; i < shard->retired_count; i++)
+      {
+        s_conc_retired_free(table, &shard->retired[i]);
+      }
+      X_CONCURRENT_HASHTABLE_FREE(shard->retired);
+
+      if (shard->lock)
+      {
+        x_thread_mutex_destroy(shard->lock);
+      }
+    }
+
+    X_CONCURRENT_HASHTABLE_FREE(table);
+  }
+
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_set(XConcurrentHashtable* table, const void* key, const void* value)
+  {
+    const void* k;
+    size_t hash;
+    XConcShard* shard;
+    XConcSlots* s;
+    XConcNode* node;
+    size_t mask;
+    size_t insert_at = (size_t)-1;
+    size_t i;
+    bool ok = true;
+
+    if (!table || !key)
+    {
+      return false;
+    }
+
+    k = s_conc_lookup_key(table, &key);
+    hash = table->fn_key_hash(k, table->key_size);
+    shard = s_conc_shard(table, hash);
+
+    node = s_conc_node_create(table, hash, key, value);
+    if (!node)
+    {
+      return false;
+    }
+
+    x_thread_mutex_lock(shard->lock);
+
+    if ((shard->used + 1) * 4 > shard->slots->capacity * 3 && !s_conc_grow(table, shard))
+    {
+      x_thread_mutex_unlock(shard->lock);
+      s_conc_node_free(table, node);
+      return false;
+    }
+
+    s = shard->slots;
+    mask = s->capacity - 1;
+
+    for (i = 0; i <= mask; i++)
+    {
+      size_t idx = (hash + i) & mask;
+      void* p = s->slots[idx];
+
+      if (p == NULL)
+      {
+        if (insert_at == (size_t)-1)
+        {
+          insert_at = idx;
+        }
+        break;
+      }
+
+      if (p == X_CONC_TOMBSTONE)
+      {
+        if (insert_at == (size_t)-1)
+        {
+          insert_at = idx;
+        }
+        continue;
+      }
+
+      if (((XConcNode*)p)->hash == hash && s_conc_key_eq(table, (XConcNode*)p, k))
+      {
+        /* Replace: readers see either the old or the new node, never a mix */
+        x_atomic_store_ptr(&s->slots[idx], node);
+        ok = s_conc_retire(table, shard, p, XCONC_RETIRED_NODE);
+        x_thread_mutex_unlock(shard->lock);
+        return ok;
+      }
+    }
+
+    if (s->slots[insert_at] == NULL)
+    {
+      shard->used++;
+    }
+    x_atomic_store_ptr(&s->slots[insert_at], node);
+    x_atomic_store_i64(&shard->count, shard->count + 1);
+
+    x_thread_mutex_unlock(shard->lock);
+    return true;
+  }
+
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_get(XConcurrentHashtable* table, const void* key, void* out_value)
+  {
+    const void* k;
+    size_t hash;
+    XConcNode* node;
+
+    if (!table || !key || !out_value)
+    {
+      return false;
+    }
+
+    k = s_conc_lookup_key(table, &key);
+    hash = table->fn_key_hash(k, table->key_size);
+
+    x_concurrent_hashtable_read_begin();
+    node = s_conc_find(table, (XConcSlots*)x_atomic_load_ptr((void* volatile*)&s_conc_shard(table, hash)->slots), k, hash);
+    if (node)
+    {
+      void* value_ptr = s_conc_node_value(table, node);
+      memcpy(out_value,
+          (table->value_is_pointer && !table->value_is_null_terminated) ? (void*)&value_ptr : value_ptr,
+          table->value_size);
+    }
+    x_concurrent_hashtable_read_end();
+
+    return node != NULL;
+  }
+
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_has(XConcurrentHashtable* table, const void* key)
+  {
+    const void* k;
+    size_t hash;
+    bool found;
+
+    if (!table || !key)
+    {
+      return false;
+    }
+
+    k = s_conc_lookup_key(table, &key);
+    hash = table->fn_key_hash(k, table->key_size);
+
+    x_concurrent_hashtable_read_begin();
+    found = s_conc_find(table, (XConcSlots*)x_atomic_load_ptr((void* volatile*)&s_conc_shard(table, hash)->slots), k, hash) != NULL;
+    x_concurrent_hashtable_read_end();
+
+    return found;
+  }
+
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_remove(XConcurrentHashtable* table, const void* key)
+  {
+    const void* k;
+    size_t hash;
+    XConcShard* shard;
+    XConcSlots* s;
+    size_t mask;
+    size_t i;
+
+    if (!table || !key)
+    {
+      return false;
+    }
+
+    k = s_conc_lookup_key(table, &key);
+    hash = table->fn_key_hash(k, table->key_size);
+    shard = s_conc_shard(table, hash);
+
+    x_thread_mutex_lock(shard->lock);
+
+    s = shard->slots;
+    mask = s->capacity - 1;
+
+    for (i = 0; i <= mask; i++)
+    {
+      size_t idx = (hash + i) & mask;
+      void* p = s->slots[idx];
+
+      if (p == NULL)
+      {
+        break;
+      }
+
+      if (p != X_CONC_TOMBSTONE && ((XConcNode*)p)->hash == hash && s_conc_key_eq(table, (XConcNode*)p, k))
+      {
+        x_atomic_store_ptr(&s->slots[idx], X_CONC_TOMBSTONE);
+        x_atomic_store_i64(&shard->count, shard->count - 1);
+        s_conc_retire(table, shard, p, XCONC_RETIRED_NODE);
+        x_thread_mutex_unlock(shard->lock);
+        return true;
+      }
+    }
+
+    x_thread_mutex_unlock(shard->lock);
+    return false;
+  }
+
+  X_CONCURRENT_HASHTABLE_API size_t x_concurrent_hashtable_count(XConcurrentHashtable* table)
+  {
+    size_t total = 0;
+    uint32_t i;
+
+    if (!table)
+    {
+      return 0;
+    }
+
+    for (i = 0; i < X_CONCURRENT_HASHTABLE_SHARDS; i++)
+    {
+      total += (size_t)x_atomic_load_i64(&table->shards[i].count);
+    }
+    return total;
+  }
+
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_iter_begin(XConcurrentHashtable* table, XConcurrentHashtableIter* it)
+  {
+    if (!table || !it)
+    {
+      return false;
+    }
+
+    x_concurrent_hashtable_read_begin();
+    it->table = table;
+    it->shard = 0;
+    it->index = 0;
+    it->shard_table = x_atomic_load_ptr((void* volatile*)&table->shards[0].slots);
+    return true;
+  }
+
+  X_CONCURRENT_HASHTABLE_API bool x_concurrent_hashtable_iter_next(XConcurrentHashtableIter* it, void** out_key, void** out_value)
+  {
+    XConcurrentHashtable* t;
+
+    if (!it || !it->table || !out_key || !out_value)
+    {
+      return false;
+    }
+
+    t = it->table;
+
+    while (it->shard < X_CONCURRENT_HASHTABLE_SHARDS)
+    {
+      XConcSlots* s = (XConcSlots*)it->shard_table;
+
+      while (it->index < s->capacity)
+      {
+        void* p = x_atomic_load_ptr(&s->slots[it->index++]);
+        if (p != NULL && p != X_CONC_TOMBSTONE)
+        {
+          void* key_slot = s_conc_node_key(t, (XConcNode*)p);
+          void* value_slot = s_conc_node_value(t, (XConcNode*)p);
+          *out_key = (t->key_is_pointer || t->key_is_null_terminated) ? *(void**)key_slot : key_slot;
+          *out_value = (t->value_is_pointer || t->value_is_null_terminated) ? *(void**)value_slot : value_slot;
+          return true;
+        }
+      }
+
+      it->shard++;
+      it->index = 0;
+      if (it->shard < X_CONCURRENT_HASHTABLE_SHARDS)
+      {
+        it->shard_table = x_atomic_load_ptr((void* volatile*)&t->shards[it->shard].slots);
+      }
+    }
+
+    return false;
+  }
+
+  X_CONCURRENT_HASHTABLE_API void x_concurrent_hashtable_iter_end(XConcurrentHashtableIter* it)
+  {
+    if (it && it->table)
+    {
+      it->table = NULL;
+      x_concurrent_hashtable_read_end();
+    }
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* X_IMPL_CONCURRENT_HASHTABLE */
+#endif /* X_CONCURRENT_HASHTABLE_H */
@@ -1,5 +1,5 @@
 /**
- * STDX - IO (file I/O utility functions)
+ * STDX - CPUID (CPU information and runtime dispatch)
  * Part of the STDX General Purpose C Library by marciovmf
  * License: MIT
  * <https://github.com/marciovmf/stdx>
@@ -7,12 +7,38 @@
  * ## Overview
  *
  * This module provides access to basic, read-only information about the
- * host CPU as detected at runtime.
+ * host CPU as detected at runtime, and a small dispatch layer to pick the
+ * best implementation of a kernel for the CPU the program runs on.
+ *
+ * ## Runtime dispatch
+ *
+ * Write each variant of a kernel as its own function, compiling SIMD ones
+ * with X_CPU_TARGET so the rest of the file stays baseline. List them from
+ * best to worst, ending with a portable one that requires nothing:
+ *
+ *     typedef size_t (*FindFn)(const char* p, size_t n, char c);
+ *
+ *     X_CPU_TARGET("avx2") static size_t s_find_avx2(const char* p, size_t n, char c);
+ *     X_CPU_TARGET("sse4.2") static size_t s_find_sse42(const char* p, size_t n, char c);
+ *     static size_t s_find_scalar(const char* p, size_t n, char c);
+ *
+ *     X_CPU_DISPATCH(s_find, FindFn,
+ *         X_CPU_KERNEL(CPU_FEATURE_AVX2, s_find_avx2),
+ *         X_CPU_KERNEL(CPU_FEATURE_SSE42, s_find_sse42),
+ *         X_CPU_KERNEL(CPU_FEATURE_NONE, s_find_scalar))
+ *
+ *     size_t at = X_CPU_CALL(s_find)(text, len, '\n');
+ *
+ * The first X_CPU_CALL resolves the function pointer from x_cpu_features();
+ * every later call is a plain indirect call. X_CPU_RESOLVE() does the same
+ * eagerly, for programs that want all choices made at startup.
  *
  * ## How to compile
  *
  * To compile the implementation define `X_IMPL_CPUID`
- * in **one** source file before including this header.
+ * in **one** source file before including this header. The cpuid
+ * primitives (x_cpuid(), x_cpu_has_invariant_tsc(), ...) are inline and
+ * need no implementation.
  *
  */
 #ifndef X_CPUID_H
@@ -20,6 +46,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifndef X_CPUID_API
 #define X_CPUID_API
@@ -34,10 +61,14 @@ extern "C" {
 #define X_CPUID_VERSION_PATCH 0
 #define X_CPUID_VERSION (X_CPUID_VERSION_MAJOR * 10000 + X_CPUID_VERSION_MINOR * 100 + X_CPUID_VERSION_PATCH)
 
-#if defined(_MSC_VER) || (defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)))
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || (defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)))
 #define X_CPUID_SUPPORTED 1
 #else
 #define X_CPUID_SUPPORTED 0
+#endif
+
+#if X_CPUID_SUPPORTED && defined(_MSC_VER)
+#include <intrin.h>
 #endif
 
   typedef enum
@@ -52,6 +83,11 @@ extern "C" {
     CPU_FEATURE_AVX     = 1 << 6,
     CPU_FEATURE_AVX2    = 1 << 7,
     CPU_FEATURE_AVX512F = 1 << 8,
+    CPU_FEATURE_INVARIANT_TSC = 1 << 9,
+    CPU_FEATURE_POPCNT  = 1 << 10,
+    CPU_FEATURE_BMI2    = 1 << 11,
+    CPU_FEATURE_FMA     = 1 << 12,
+    CPU_FEATURE_AVX512BW = 1 << 13,
     CPU_FEATURE_NEON    = 1 << 16,
     CPU_FEATURE_AES     = 1 << 17,
     CPU_FEATURE_CRC32   = 1 << 18,
@@ -68,8 +104,65 @@ extern "C" {
     int cache_size_l3_kb;
     char brand_string[49];  // 3 * 16bytes + null terminator = 49
     CPUFeature feature_flags;
+    int cache_line_size;    // L1 data cache line, in bytes
   } XCPUInfo;
 
+#ifndef X_CPU_MAX_CPUS
+/**
+ * @brief Highest logical CPU number + 1 that an XCPUSet can hold.
+ * Can be overriden before including this header.
+ */
+#define X_CPU_MAX_CPUS 1024
+#endif
+
+  /**
+   * Set of logical CPUs, by OS CPU number. Plain value type: copy it,
+   * compare it with memcmp, clear it with x_cpuset_clear().
+   */
+  typedef struct
+  {
+    uint64_t bits[(X_CPU_MAX_CPUS + 63) / 64];
+  } XCPUSet;
+
+  typedef enum
+  {
+    XCPU_CACHE_UNIFIED      = 0,
+    XCPU_CACHE_DATA         = 1,
+    XCPU_CACHE_INSTRUCTION  = 2,
+  } XCPUCacheType;
+
+  typedef struct
+  {
+    int32_t level;                // 1, 2 or 3
+    XCPUCacheType type;
+    int32_t size_kb;
+    int32_t line_size;            // bytes
+    XCPUSet cpus;                 // logical CPUs sharing this cache
+  } XCPUCache;
+
+  typedef struct
+  {
+    int32_t cpu;                  // OS CPU number, as used by XCPUSet and affinity
+    int32_t core;                 // physical core, numbered 0..core_count-1 across the system
+    int32_t package;              // socket, numbered 0..package_count-1
+    int32_t numa_node;            // NUMA node, numbered 0..numa_node_count-1
+    int32_t smt_index;            // 0 for the first hardware thread of its core
+    int32_t smt_sibling;          // another logical CPU on the same core, or -1
+    int32_t cache[3];             // index in XCPUTopology.caches of the L1 data, L2 and L3 caches; -1 if unknown
+  } XCPULogical;
+
+  typedef struct
+  {
+    int32_t cpu_count;            // entries in cpus: the online logical CPUs
+    int32_t core_count;
+    int32_t package_count;
+    int32_t numa_node_count;
+    int32_t cache_count;          // entries in caches
+    int32_t cache_line_size;      // bytes
+    XCPULogical* cpus;            // sorted by OS CPU number
+    XCPUCache* caches;            // one entry per physical cache
+  } XCPUTopology;
+
   /**
    * @brief Query static information about the host CPU.
    * All data is gathered once per call and returned by value.
@@ -79,24 +172,310 @@ extern "C" {
    */
   X_CPUID_API XCPUInfo x_cpu_info(void);
 
+  /**
+   * @brief Describe every online logical CPU: its core, package, NUMA node
+   * and caches. Read from sysfs on Linux and from
+   * GetLogicalProcessorInformationEx on Windows. Elsewhere each CPU is
+   * reported on its own node and package, cores are inferred from the SMT
+   * ratio and no caches are listed.
+   * @param out Topology to fill. Release it with x_cpu_topology_free().
+   * @return true on success, false if memory could not be allocated.
+   */
+  X_CPUID_API bool x_cpu_topology(XCPUTopology* out);
+
+  /**
+   * @brief Release the arrays of a topology from x_cpu_topology().
+   * @param topology Topology to release; its fields are zeroed.
+   */
+  X_CPUID_API void x_cpu_topology_free(XCPUTopology* topology);
+
+  /**
+   * @brief Find a logical CPU by OS CPU number.
+   * @return The CPU description, or NULL if it is not online.
+   */
+  X_CPUID_API const XCPULogical* x_cpu_topology_find(const XCPUTopology* topology, int32_t cpu);
+
+  /**
+   * @brief Collect the first hardware thread of every physical core,
+   * optionally limited to one package. Pinning one worker to each CPU of
+   * this set gives every worker a core of its own.
+   * @param topology Topology.
+   * @param package Package to keep, or -1 for all of them.
+   * @param out Set to fill.
+   * @return Number of CPUs in the set.
+   */
+  X_CPUID_API int32_t x_cpu_topology_cores(const XCPUTopology* topology, int32_t package, XCPUSet* out);
+
+  /**
+   * @brief Collect every logical CPU of a NUMA node.
+   * @param topology Topology.
+   * @param node NUMA node.
+   * @param out Set to fill.
+   * @return Number of CPUs in the set.
+   */
+  X_CPUID_API int32_t x_cpu_topology_node(const XCPUTopology* topology, int32_t node, XCPUSet* out);
+
+  /** @brief Remove every CPU from a set. */
+  static inline void x_cpuset_clear(XCPUSet* set)
+  {
+    for (size_t i = 0; i < sizeof(set->bits) / sizeof(set->bits[0]); i++)
+      set->bits[i] = 0;
+  }
+
+  /** @brief Add a CPU to a set. Numbers outside [0, X_CPU_MAX_CPUS) are ignored. */
+  static inline void x_cpuset_add(XCPUSet* set, int32_t cpu)
+  {
+    if (cpu >= 0 && cpu < X_CPU_MAX_CPUS)
+      set->bits[cpu >> 6] |= (uint64_t)1 << (cpu & 63);
+  }
+
+  /** @brief Remove a CPU from a set. */
+  static inline void x_cpuset_remove(XCPUSet* set, int32_t cpu)
+  {
+    if (cpu >= 0 && cpu < X_CPU_MAX_CPUS)
+      set->bits[cpu >> 6] &= ~((uint64_t)1 << (cpu & 63));
+  }
+
+  /** @brief Test whether a CPU is in a set. */
+  static inline bool x_cpuset_has(const XCPUSet* set, int32_t cpu)
+  {
+    return cpu >= 0 && cpu < X_CPU_MAX_CPUS && (set->bits[cpu >> 6] >> (cpu & 63)) & 1;
+  }
+
+  /** @brief Count the CPUs in a set. */
+  static inline int32_t x_cpuset_count(const XCPUSet* set)
+  {
+    int32_t n = 0;
+    for (size_t i = 0; i < sizeof(set->bits) / sizeof(set->bits[0]); i++)
+    {
+      uint64_t w = set->bits[i];
+      while (w) { w &= w - 1; n++; }
+    }
+    return n;
+  }
+
+  /**
+   * @brief Iterate a set in increasing order.
+   *     for (int32_t cpu = x_cpuset_next(&set, -1); cpu >= 0; cpu = x_cpuset_next(&set, cpu))
+   * @param set Set.
+   * @param after Last CPU returned, or -1 to start.
+   * @return The next CPU in the set, or -1 when there are no more.
+   */
+  static inline int32_t x_cpuset_next(const XCPUSet* set, int32_t after)
+  {
+    for (int32_t cpu = after + 1; cpu < X_CPU_MAX_CPUS; cpu++)
+    {
+      uint64_t w = set->bits[cpu >> 6] >> (cpu & 63);
+      if (w == 0)
+      {
+        cpu |= 63;  // rest of this word is empty
+        continue;
+      }
+      while (!(w & 1)) { w >>= 1; cpu++; }
+      return cpu;
+    }
+    return -1;
+  }
+
+  /**
+   * @brief Get the features of the host CPU that the program may use.
+   * Detected on the first call and cached; safe to call from any thread.
+   * AVX and AVX-512 features are only reported when the OS saves their
+   * registers. The result is limited by x_cpu_set_feature_mask().
+   * @return Bitwise OR of CPUFeature flags.
+   */
+  X_CPUID_API CPUFeature x_cpu_features(void);
+
+  /**
+   * @brief Limit the features reported by x_cpu_features().
+   * Used to exercise fallback kernels on a machine that has everything.
+   * Dispatch sites already resolved keep their choice; see X_CPU_RESET().
+   * @param mask Features to keep; ~0u reports everything again.
+   */
+  X_CPUID_API void x_cpu_set_feature_mask(uint32_t mask);
+
+  typedef void (*XCPUKernelFn)(void);
+
+  typedef struct
+  {
+    uint32_t required;            // CPUFeature flags the kernel needs
+    XCPUKernelFn fn;              // the kernel, cast to a generic function pointer
+    const char* name;             // function name, for diagnostics
+  } XCPUKernel;
+
+  /**
+   * @brief Pick the first kernel whose required features are all available.
+   * @param kernels Candidates, best first.
+   * @param count Number of candidates.
+   * @return The chosen kernel, or NULL if none can run on this CPU.
+   */
+  X_CPUID_API const XCPUKernel* x_cpu_select(const XCPUKernel* kernels, size_t count);
+
+  /**
+   * @brief Compile one function for an instruction set the build does not target.
+   * Expands to a GCC/Clang target attribute, e.g. X_CPU_TARGET("avx2"), and
+   * to nothing on MSVC, which accepts intrinsics in any function.
+   */
+#if defined(__GNUC__) || defined(__clang__)
+#define X_CPU_TARGET(spec) __attribute__((target(spec)))
+#else
+#define X_CPU_TARGET(spec)
+#endif
+
+  /**
+   * @brief Describe one implementation of a dispatched kernel.
+   * @param features CPUFeature flags it requires, CPU_FEATURE_NONE for the portable one.
+   * @param fn The function.
+   */
+#define X_CPU_KERNEL(features, fn) { (uint32_t)(features), (XCPUKernelFn)(fn), #fn }
+
+  /**
+   * @brief Define a dispatched kernel: a function pointer of type fn_type
+   * named name, resolved from the X_CPU_KERNEL list on first use.
+   * Resolving is idempotent, so threads racing on the first call store the
+   * same pointer.
+   */
+#define X_CPU_DISPATCH(name, fn_type, ...) \
+  static fn_type volatile name = NULL; \
+  static fn_type name##_resolve(void) \
+  { \
+    static const XCPUKernel kernels[] = { __VA_ARGS__ }; \
+    const XCPUKernel* k = x_cpu_select(kernels, sizeof(kernels) / sizeof(kernels[0])); \
+    name = k ? (fn_type)k->fn : NULL; \
+    return name; \
+  }
+
+  /** @brief The kernel chosen for name, resolving it on the first call. */
+#define X_CPU_CALL(name) ((name) ? (name) : name##_resolve())
+
+  /** @brief Resolve name now instead of on its first call. */
+#define X_CPU_RESOLVE(name) ((void)name##_resolve())
+
+  /** @brief Forget the choice for name; the next call resolves it again. */
+#define X_CPU_RESET(name) ((void)((name) = NULL))
+
+  /**
+   * @brief Execute the cpuid instruction.
+   * Outputs are zero where cpuid is not available (X_CPUID_SUPPORTED is 0).
+   * @param eax Leaf.
+   * @param ecx Sub-leaf.
+   * @param out_eax, out_ebx, out_ecx, out_edx Registers returned; each may be NULL.
+   */
+  static inline void x_cpuid(
+      uint32_t eax,
+      uint32_t ecx,
+      uint32_t* out_eax,
+      uint32_t* out_ebx,
+      uint32_t* out_ecx,
+      uint32_t* out_edx)
+  {
+#if X_CPUID_SUPPORTED && defined(_MSC_VER)
+    int regs[4];
+    __cpuidex(regs, eax, ecx);
+    if (out_eax) *out_eax = regs[0];
+    if (out_ebx) *out_ebx = regs[1];
+    if (out_ecx) *out_ecx = regs[2];
+    if (out_edx) *out_edx = regs[3];
+#elif X_CPUID_SUPPORTED
+    uint32_t a, b, c, d;
+    __asm__ __volatile__(
+        "cpuid"
+        : "=a"(a), "=b"(b), "=c"(c), "=d"(d)
+        : "a"(eax), "c"(ecx));
+    if (out_eax) *out_eax = a;
+    if (out_ebx) *out_ebx = b;
+    if (out_ecx) *out_ecx = c;
+    if (out_edx) *out_edx = d;
+#else
+    (void)eax;
+    (void)ecx;
+    if (out_eax) *out_eax = 0;
+    if (out_ebx) *out_ebx = 0;
+    if (out_ecx) *out_ecx = 0;
+    if (out_edx) *out_edx = 0;
+#endif
+  }
+
+  /**
+   * @brief Read an extended control register (xgetbv).
+   * Only valid when cpuid reports OSXSAVE (leaf 1, ECX bit 27).
+   * @param index Register; 0 is XCR0, the OS-enabled state components.
+   * @return Register value, or 0 without cpuid.
+   */
+  static inline uint64_t x_xgetbv(uint32_t index)
+  {
+#if X_CPUID_SUPPORTED && defined(_MSC_VER)
+    return _xgetbv(index);
+#elif X_CPUID_SUPPORTED
+    uint32_t lo, hi;
+    __asm__ __volatile__("xgetbv" : "=a"(lo), "=d"(hi) : "c"(index));
+    return ((uint64_t)hi << 32) | lo;
+#else
+    (void)index;
+    return 0;
+#endif
+  }
+
+  /**
+   * @brief Get the highest cpuid leaf of a range.
+   * @param leaf_type 0 for the basic leaves, 0x80000000 for the extended ones.
+   * @return Highest supported leaf, or 0 without cpuid.
+   */
+  static inline uint32_t x_cpuid_max_leaf(uint32_t leaf_type)
+  {
+    uint32_t a = 0;
+    x_cpuid(leaf_type, 0, &a, NULL, NULL, NULL);
+    return a;
+  }
+
+  /**
+   * @brief Test whether the time stamp counter runs at a constant rate in
+   * every power state (cpuid 0x80000007, EDX bit 8).
+   * @return true if rdtsc is usable as a wall-clock rate timer.
+   */
+  static inline bool x_cpu_has_invariant_tsc(void)
+  {
+    uint32_t edx = 0;
+    if (x_cpuid_max_leaf(0x80000000u) < 0x80000007u)
+      return false;
+    x_cpuid(0x80000007u, 0, NULL, NULL, NULL, &edx);
+    return (edx & (1u << 8)) != 0;
+  }
+
+  /**
+   * @brief Get the time stamp counter rate reported by the CPU (cpuid 0x15).
+   * @return Ticks per second, or 0 if the CPU does not enumerate it.
+   */
+  static inline uint64_t x_cpu_tsc_frequency(void)
+  {
+    uint32_t den = 0, num = 0, crystal = 0;
+    if (x_cpuid_max_leaf(0) < 0x15)
+      return 0;
+    x_cpuid(0x15, 0, &den, &num, &crystal, NULL);
+    if (den == 0 || num == 0 || crystal == 0)
+      return 0;
+    return (uint64_t)crystal * num / den;
+  }
+
 #ifdef __cplusplus
 }
 #endif
 
-#ifdef X_IMPL_CPUID
+#endif // X_CPUID_H
 
-#if defined(_MSC_VER)
-#include <intrin.h>
-#elif defined(__GNUC__) || defined(__clang__)
-#include <cpuid.h>
-#endif
+// Outside the include guard: stdx_time.h includes this header for the inline
+// helpers, so X_IMPL_CPUID may only be seen by a later include.
+#if defined(X_IMPL_CPUID) && !defined(X_CPUID_IMPL_DONE)
+#define X_CPUID_IMPL_DONE
 
 #if defined(__linux__) || defined(__ANDROID__)
 #include <unistd.h>
 #include <stdio.h>
 #include <string.h>
+#if defined(__aarch64__) || defined(__arm__)
 #include <sys/auxv.h>
 #include <asm/hwcap.h>
+#endif
 #elif defined(__APPLE__)
 #include <sys/types.h>
 #include <sys/sysctl.h>
@@ -109,46 +488,156 @@ extern "C" {
 #endif
 
 #include <string.h>
+#include <stdlib.h>
 
-static void x_cpuid(
-    uint32_t eax,
-    uint32_t ecx,
-    uint32_t* out_eax,
-    uint32_t* out_ebx,
-    uint32_t* out_ecx,
-    uint32_t* out_edx)
+#ifndef X_CPUID_ALLOC
+/**
+ * @brief Internal macro for allocating memory.
+ * To override how this header allocates memory, define this macro with a
+ * different implementation before including this header.
+ * @param sz  The size of memory to alloc.
+ */
+#define X_CPUID_ALLOC(sz)        malloc(sz)
+#endif
+
+#ifndef X_CPUID_FREE
+/**
+ * @brief Internal macro for freeing memory.
+ * To override how this header frees memory, define this macro with a
+ * different implementation before including this header.
+ * @param p  The address of memory region to free.
+ */
+#define X_CPUID_FREE(p)          free(p)
+#endif
+
+#define X_CPU_FEATURES_DETECTED 0x80000000u
+
+static volatile uint32_t s_x_cpu_features = 0;
+static volatile uint32_t s_x_cpu_feature_mask = ~0u;
+
+static CPUFeature s_x_cpu_detect_features(void)
 {
-#if defined(_MSC_VER)
-  int regs[4];
-  __cpuidex(regs, eax, ecx);
-  if (out_eax) *out_eax = regs[0];
-  if (out_ebx) *out_ebx = regs[1];
-  if (out_ecx) *out_ecx = regs[2];
-  if (out_edx) *out_edx = regs[3];
-
-#elif defined(__GNUC__) || defined(__clang__)
-  uint32_t a, b, c, d;
-  __asm__ __volatile__(
-      "cpuid"
-      : "=a"(a), "=b"(b), "=c"(c), "=d"(d)
-      : "a"(eax), "c"(ecx));
-  if (out_eax) *out_eax = a;
-  if (out_ebx) *out_ebx = b;
-  if (out_ecx) *out_ecx = c;
-  if (out_edx) *out_edx = d;
-#else
-  if (out_eax) *out_eax = 0;
-  if (out_ebx) *out_ebx = 0;
-  if (out_ecx) *out_ecx = 0;
-  if (out_edx) *out_edx = 0;
+  uint32_t flags = CPU_FEATURE_NONE;
+
+#if X_CPUID_SUPPORTED
+  {
+    uint32_t eax, ebx, ecx, edx;
+    bool os_avx = false;
+    bool os_avx512 = false;
+
+    // Basic feature bits
+    x_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+
+    if (edx & (1 << 25)) flags |= CPU_FEATURE_SSE;
+    if (edx & (1 << 26)) flags |= CPU_FEATURE_SSE2;
+    if (ecx & (1 << 0))  flags |= CPU_FEATURE_SSE3;
+    if (ecx & (1 << 9))  flags |= CPU_FEATURE_SSSE3;
+    if (ecx & (1 << 19)) flags |= CPU_FEATURE_SSE41;
+    if (ecx & (1 << 20)) flags |= CPU_FEATURE_SSE42 | CPU_FEATURE_CRC32;
+    if (ecx & (1 << 23)) flags |= CPU_FEATURE_POPCNT;
+    if (ecx & (1 << 25)) flags |= CPU_FEATURE_AES;
+
+    // The CPU having AVX is not enough: the OS must save the wider
+    // registers on a context switch (XCR0 bits 1-2, and 5-7 for AVX-512)
+    if (ecx & (1u << 27))
+    {
+      uint64_t xcr0 = x_xgetbv(0);
+      os_avx = (xcr0 & 0x6) == 0x6;
+      os_avx512 = os_avx && (xcr0 & 0xE0) == 0xE0;
+    }
+
+    if (os_avx)
+    {
+      if (ecx & (1 << 28)) flags |= CPU_FEATURE_AVX;
+      if (ecx & (1 << 12)) flags |= CPU_FEATURE_FMA;
+    }
+
+    if (x_cpuid_max_leaf(0) >= 7)
+    {
+      x_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+      if (ebx & (1 << 8))  flags |= CPU_FEATURE_BMI2;
+      if (os_avx && (ebx & (1 << 5)))  flags |= CPU_FEATURE_AVX2;
+      if (os_avx512 && (ebx & (1 << 16))) flags |= CPU_FEATURE_AVX512F;
+      if (os_avx512 && (ebx & (1u << 30))) flags |= CPU_FEATURE_AVX512BW;
+    }
+
+    if (x_cpu_has_invariant_tsc()) flags |= CPU_FEATURE_INVARIANT_TSC;
+  }
 #endif
+
+#if defined(__aarch64__) || defined(__arm__)
+  {
+    unsigned long hwcap = 0;
+
+#if defined(__linux__) || defined(__ANDROID__)
+    hwcap = getauxval(AT_HWCAP);
+#endif
+
+    // Advanced SIMD is part of the baseline on 64-bit ARM
+#if defined(__aarch64__)
+    flags |= CPU_FEATURE_NEON;
+#elif defined(HWCAP_NEON)
+    if (hwcap & HWCAP_NEON)  flags |= CPU_FEATURE_NEON;
+#endif
+#if defined(HWCAP_CRC32)
+    if (hwcap & HWCAP_CRC32) flags |= CPU_FEATURE_CRC32;
+#endif
+#if defined(HWCAP_AES)
+    if (hwcap & HWCAP_AES)   flags |= CPU_FEATURE_AES;
+#endif
+    (void)hwcap;
+
+    // On Apple ARM, assume NEON/AES/CRC32 are supported
+#if defined(__APPLE__) && defined(__aarch64__)
+    flags |= CPU_FEATURE_NEON | CPU_FEATURE_AES | CPU_FEATURE_CRC32;
+#endif
+  }
+#endif
+
+  return (CPUFeature)flags;
+}
+
+X_CPUID_API CPUFeature x_cpu_features(void)
+{
+  uint32_t flags = s_x_cpu_features;
+  if (!(flags & X_CPU_FEATURES_DETECTED))
+  {
+    // Detection always gives the same answer, so threads racing here
+    // store the same value
+    flags = (uint32_t)s_x_cpu_detect_features() | X_CPU_FEATURES_DETECTED;
+    s_x_cpu_features = flags;
+  }
+  return (CPUFeature)(flags & s_x_cpu_feature_mask & ~X_CPU_FEATURES_DETECTED);
 }
 
-X_CPUID_API static inline uint32_t x_cpuid_max_leaf(uint32_t leaf_type)
+X_CPUID_API void x_cpu_set_feature_mask(uint32_t mask)
 {
-  uint32_t a = 0;
-  x_cpuid(leaf_type, 0, &a, NULL, NULL, NULL);
-  return a;
+  s_x_cpu_feature_mask = mask;
+}
+
+X_CPUID_API const XCPUKernel* x_cpu_select(const XCPUKernel* kernels, size_t count)
+{
+  uint32_t flags = (uint32_t)x_cpu_features();
+  for (size_t i = 0; i < count; i++)
+  {
+    if ((kernels[i].required & flags) == kernels[i].required)
+      return &kernels[i];
+  }
+  return NULL;
+}
+
+static int s_x_cpu_os_cache_line_size(void)
+{
+  int line = 0;
+#if defined(__linux__) && defined(_SC_LEVEL1_DCACHE_LINESIZE)
+  line = (int)sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#elif defined(__APPLE__)
+  int64_t v = 0;
+  size_t sz = sizeof(v);
+  if (sysctlbyname("hw.cachelinesize", &v, &sz, NULL, 0) == 0)
+    line = (int)v;
+#endif
+  return line > 0 ? line : 64;
 }
 
 X_CPUID_API XCPUInfo x_cpu_info()
@@ -255,6 +744,7 @@ X_CPUID_API XCPUInfo x_cpu_info()
       if (type == 0) continue;
       int lvl = (eax >> 5) & 0x7;
       if (lvl != level) continue;
+      if (type == 2) continue;  // instruction cache
 
       int ways  = ((ebx >> 22) & 0x3FF) + 1;
       int parts = ((ebx >> 12) & 0x3FF) + 1;
@@ -262,6 +752,7 @@ X_CPUID_API XCPUInfo x_cpu_info()
       int sets  = ecx + 1;
       int size_kb = (ways * parts * lines * sets) / 1024;
 
+      if (level == 1) info.cache_line_size = lines;
       if (level == 1) info.cache_size_l1_kb = size_kb;
       if (level == 2) info.cache_size_l2_kb = size_kb;
       if (level == 3) info.cache_size_l3_kb = size_kb;
@@ -269,64 +760,409 @@ X_CPUID_API XCPUInfo x_cpu_info()
   }
 #endif
 
+  if (info.cache_line_size == 0)
+    info.cache_line_size = s_x_cpu_os_cache_line_size();
+
   //--------------------------------------------
   // Features
   //--------------------------------------------
 
-  info.feature_flags = CPU_FEATURE_NONE;
+  info.feature_flags = s_x_cpu_detect_features();
 
-#if X_CPUID_SUPPORTED
+  return info;
+}
+
+//--------------------------------------------
+// Topology
+//--------------------------------------------
+
+// Scratch state while building a topology, indexed by OS CPU number
+typedef struct
+{
+  XCPUSet online;
+  int32_t core[X_CPU_MAX_CPUS];
+  int32_t package[X_CPU_MAX_CPUS];
+  int32_t node[X_CPU_MAX_CPUS];
+  int32_t core_count;
+  int32_t package_count;
+  int32_t node_count;
+  XCPUCache* caches;
+  int32_t cache_count;
+  int32_t cache_capacity;
+  int32_t cache_line_size;
+} XCPUTopologyScratch;
+
+static bool s_x_cpu_topology_add_cache(XCPUTopologyScratch* sc, const XCPUCache* cache)
+{
+  if (sc->cache_count == sc->cache_capacity)
   {
-    uint32_t eax, ebx, ecx, edx;
+    int32_t capacity = sc->cache_capacity ? sc->cache_capacity * 2 : 16;
+    XCPUCache* caches = (XCPUCache*)X_CPUID_ALLOC((size_t)capacity * sizeof(XCPUCache));
+    if (!caches)
+      return false;
+    if (sc->caches)
+    {
+      memcpy(caches, sc->caches, (size_t)sc->cache_count * sizeof(XCPUCache));
+      X_CPUID_FREE(sc->caches);
+    }
+    sc->caches = caches;
+    sc->cache_capacity = capacity;
+  }
+  sc->caches[sc->cache_count++] = *cache;
+  return true;
+}
 
-    // Basic feature bits
-    x_cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+#if defined(__linux__)
 
-    if (edx & (1 << 25)) info.feature_flags |= CPU_FEATURE_SSE;
-    if (edx & (1 << 26)) info.feature_flags |= CPU_FEATURE_SSE2;
-    if (ecx & (1 << 0))  info.feature_flags |= CPU_FEATURE_SSE3;
-    if (ecx & (1 << 9))  info.feature_flags |= CPU_FEATURE_SSSE3;
-    if (ecx & (1 << 19)) info.feature_flags |= CPU_FEATURE_SSE41;
-    if (ecx & (1 << 20)) info.feature_flags |= CPU_FEATURE_SSE42;
-    if (ecx & (1 << 28)) info.feature_flags |= CPU_FEATURE_AVX;
+static bool s_x_cpu_read_line(const char* path, char* buf, size_t size)
+{
+  FILE* f = fopen(path, "r");
+  if (!f)
+    return false;
+  bool ok = fgets(buf, (int)size, f) != NULL;
+  fclose(f);
+  return ok;
+}
 
-    if (x_cpuid_max_leaf(0) >= 7)
+static int32_t s_x_cpu_read_int(const char* path, int32_t fallback)
+{
+  char buf[64];
+  return s_x_cpu_read_line(path, buf, sizeof(buf)) ? (int32_t)strtol(buf, NULL, 10) : fallback;
+}
+
+// Parses the kernel's cpu list format: "0-3,8,10-11"
+static bool s_x_cpu_read_list(const char* path, XCPUSet* out)
+{
+  char buf[4096];
+  x_cpuset_clear(out);
+  if (!s_x_cpu_read_line(path, buf, sizeof(buf)))
+    return false;
+  char* p = buf;
+  while (*p >= '0' && *p <= '9')
+  {
+    long first = strtol(p, &p, 10);
+    long last = first;
+    if (*p == '-')
+      last = strtol(p + 1, &p, 10);
+    for (long cpu = first; cpu <= last && cpu < X_CPU_MAX_CPUS; cpu++)
+      x_cpuset_add(out, (int32_t)cpu);
+    if (*p == ',')
+      p++;
+  }
+  return true;
+}
+
+static bool s_x_cpu_topology_os(XCPUTopologyScratch* sc)
+{
+  char path[128];
+  int32_t package_ids[X_CPU_MAX_CPUS];
+  XCPUSet nodes;
+
+  if (!s_x_cpu_read_list("/sys/devices/system/cpu/online", &sc->online))
+    return false;
+
+  for (int32_t cpu = x_cpuset_next(&sc->online, -1); cpu >= 0; cpu = x_cpuset_next(&sc->online, cpu))
+  {
+    XCPUSet siblings;
+
+    // Packages: dense numbers in order of first appearance
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    int32_t package_id = s_x_cpu_read_int(path, 0);
+    int32_t package = 0;
+    while (package < sc->package_count && package_ids[package] != package_id)
+      package++;
+    if (package == sc->package_count)
+      package_ids[sc->package_count++] = package_id;
+    sc->package[cpu] = package;
+
+    // Cores: the lowest thread of a core numbers it, the others reuse that
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/thread_siblings_list", cpu);
+    int32_t first = cpu;
+    if (s_x_cpu_read_list(path, &siblings) && x_cpuset_has(&siblings, cpu))
+      first = x_cpuset_next(&siblings, -1);
+    sc->core[cpu] = (first == cpu || !x_cpuset_has(&sc->online, first)) ? sc->core_count++ : sc->core[first];
+
+    // Caches: listed by the lowest CPU sharing them
+    for (int32_t index = 0; index < 16; index++)
     {
-      x_cpuid(7, 0, &eax, &ebx, &ecx, &edx);
-      if (ebx & (1 << 5))   info.feature_flags |= CPU_FEATURE_AVX2;
-      if (ebx & (1 << 16))  info.feature_flags |= CPU_FEATURE_AVX512F;
+      char buf[64];
+      XCPUCache cache;
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/level", cpu, index);
+      cache.level = s_x_cpu_read_int(path, 0);
+      if (cache.level == 0)
+        break;
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/shared_cpu_list", cpu, index);
+      if (!s_x_cpu_read_list(path, &cache.cpus))
+        x_cpuset_add(&cache.cpus, cpu);
+      if (x_cpuset_next(&cache.cpus, -1) != cpu)
+        continue;
+
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/type", cpu, index);
+      cache.type = XCPU_CACHE_UNIFIED;
+      if (s_x_cpu_read_line(path, buf, sizeof(buf)))
+      {
+        if (buf[0] == 'D') cache.type = XCPU_CACHE_DATA;
+        if (buf[0] == 'I') cache.type = XCPU_CACHE_INSTRUCTION;
+      }
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/size", cpu, index);
+      cache.size_kb = 0;
+      if (s_x_cpu_read_line(path, buf, sizeof(buf)))
+      {
+        char* unit;
+        cache.size_kb = (int32_t)strtol(buf, &unit, 10);
+        if (*unit == 'M') cache.size_kb *= 1024;
+      }
+      snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cache/index%d/coherency_line_size", cpu, index);
+      cache.line_size = s_x_cpu_read_int(path, 0);
+      if (!s_x_cpu_topology_add_cache(sc, &cache))
+        return false;
     }
   }
-#endif
 
-#if defined(__aarch64__) || defined(__arm__)
+  // NUMA nodes; kernels without NUMA support have no node directory
+  for (int32_t cpu = 0; cpu < X_CPU_MAX_CPUS; cpu++)
+    sc->node[cpu] = 0;
+  sc->node_count = 1;
+  if (s_x_cpu_read_list("/sys/devices/system/node/online", &nodes) && x_cpuset_count(&nodes) > 0)
   {
-    unsigned long hwcap = 0;
+    sc->node_count = 0;
+    for (int32_t node = x_cpuset_next(&nodes, -1); node >= 0; node = x_cpuset_next(&nodes, node))
+    {
+      XCPUSet cpus;
+      snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+      if (!s_x_cpu_read_list(path, &cpus))
+        continue;
+      for (int32_t cpu = x_cpuset_next(&cpus, -1); cpu >= 0; cpu = x_cpuset_next(&cpus, cpu))
+        sc->node[cpu] = sc->node_count;
+      sc->node_count++;
+    }
+    if (sc->node_count == 0)
+      sc->node_count = 1;
+  }
 
-#if defined(__linux__) || defined(__ANDROID__)
-    hwcap = getauxval(AT_HWCAP);
-#elif defined(__APPLE__)
-    hwcap = 0; // NEON is always available on Apple ARM
-#endif
+  return sc->core_count > 0;
+}
 
-    if (hwcap & HWCAP_NEON)  info.feature_flags |= CPU_FEATURE_NEON;
-#if defined(HWCAP_CRC32)
-    if (hwcap & HWCAP_CRC32) info.feature_flags |= CPU_FEATURE_CRC32;
-#endif
-#if defined(HWCAP_AES)
-    if (hwcap & HWCAP_AES)   info.feature_flags |= CPU_FEATURE_AES;
-#endif
+#elif defined(_WIN32)
 
-    // On Apple ARM, assume NEON/AES/CRC32 are supported
-#if defined(__APPLE__) && defined(__aarch64__)
-    info.feature_flags |= CPU_FEATURE_NEON | CPU_FEATURE_AES | CPU_FEATURE_CRC32;
-#endif
+static void s_x_cpu_group_mask_to_set(const GROUP_AFFINITY* mask, XCPUSet* out)
+{
+  for (int32_t bit = 0; bit < (int32_t)(sizeof(KAFFINITY) * 8); bit++)
+  {
+    if (mask->Mask & ((KAFFINITY)1 << bit))
+      x_cpuset_add(out, (int32_t)mask->Group * 64 + bit);
+  }
+}
+
+static bool s_x_cpu_topology_os(XCPUTopologyScratch* sc)
+{
+  DWORD len = 0;
+  GetLogicalProcessorInformationEx(RelationAll, NULL, &len);
+  char* buf = (char*)X_CPUID_ALLOC(len);
+  if (!buf || !GetLogicalProcessorInformationEx(RelationAll, (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)buf, &len))
+  {
+    X_CPUID_FREE(buf);
+    return false;
+  }
+
+  for (int32_t cpu = 0; cpu < X_CPU_MAX_CPUS; cpu++)
+    sc->node[cpu] = 0;
+
+  bool ok = true;
+  for (char* p = buf; ok && p < buf + len; p += ((SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)p)->Size)
+  {
+    SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX* e = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*)p;
+    XCPUSet cpus;
+    x_cpuset_clear(&cpus);
+
+    if (e->Relationship == RelationProcessorCore || e->Relationship == RelationProcessorPackage)
+    {
+      for (WORD g = 0; g < e->Processor.GroupCount; g++)
+        s_x_cpu_group_mask_to_set(&e->Processor.GroupMask[g], &cpus);
+      int32_t* field = e->Relationship == RelationProcessorCore ? sc->core : sc->package;
+      int32_t id = e->Relationship == RelationProcessorCore ? sc->core_count++ : sc->package_count++;
+      for (int32_t cpu = x_cpuset_next(&cpus, -1); cpu >= 0; cpu = x_cpuset_next(&cpus, cpu))
+      {
+        field[cpu] = id;
+        if (e->Relationship == RelationProcessorCore)
+          x_cpuset_add(&sc->online, cpu);
+      }
+    }
+    else if (e->Relationship == RelationNumaNode)
+    {
+      s_x_cpu_group_mask_to_set(&e->NumaNode.GroupMask, &cpus);
+      for (int32_t cpu = x_cpuset_next(&cpus, -1); cpu >= 0; cpu = x_cpuset_next(&cpus, cpu))
+        sc->node[cpu] = sc->node_count;
+      sc->node_count++;
+    }
+    else if (e->Relationship == RelationCache && e->Cache.Level >= 1 && e->Cache.Level <= 3 && e->Cache.Type != CacheTrace)
+    {
+      XCPUCache cache;
+      cache.level = e->Cache.Level;
+      cache.type = e->Cache.Type == CacheData ? XCPU_CACHE_DATA
+        : e->Cache.Type == CacheInstruction ? XCPU_CACHE_INSTRUCTION : XCPU_CACHE_UNIFIED;
+      cache.size_kb = (int32_t)(e->Cache.CacheSize / 1024);
+      cache.line_size = e->Cache.LineSize;
+      x_cpuset_clear(&cache.cpus);
+      s_x_cpu_group_mask_to_set(&e->Cache.GroupMask, &cache.cpus);
+      ok = s_x_cpu_topology_add_cache(sc, &cache);
+    }
   }
+
+  X_CPUID_FREE(buf);
+  if (sc->node_count == 0)
+    sc->node_count = 1;
+  if (sc->package_count == 0)
+    sc->package_count = 1;
+  return ok && sc->core_count > 0;
+}
+
+#else
+
+static bool s_x_cpu_topology_os(XCPUTopologyScratch* sc)
+{
+  (void)sc;
+  return false;
+}
+
 #endif
 
+// Without OS topology: consecutive CPUs share a core, in the SMT ratio
+static void s_x_cpu_topology_guess(XCPUTopologyScratch* sc)
+{
+  XCPUInfo info = x_cpu_info();
+  int32_t logical = info.logical_cpus > 0 ? info.logical_cpus : 1;
+  int32_t per_core = (info.physical_cores > 0 && logical >= info.physical_cores) ? logical / info.physical_cores : 1;
+  if (logical > X_CPU_MAX_CPUS)
+    logical = X_CPU_MAX_CPUS;
 
-  return info;
+  x_cpuset_clear(&sc->online);
+  for (int32_t cpu = 0; cpu < logical; cpu++)
+  {
+    x_cpuset_add(&sc->online, cpu);
+    sc->core[cpu] = cpu / per_core;
+    sc->package[cpu] = 0;
+    sc->node[cpu] = 0;
+  }
+  sc->core_count = (logical + per_core - 1) / per_core;
+  sc->package_count = 1;
+  sc->node_count = 1;
+  sc->cache_count = 0;
+}
+
+X_CPUID_API bool x_cpu_topology(XCPUTopology* out)
+{
+  XCPUTopologyScratch* sc = (XCPUTopologyScratch*)X_CPUID_ALLOC(sizeof(XCPUTopologyScratch));
+  memset(out, 0, sizeof(*out));
+  if (!sc)
+    return false;
+  memset(sc, 0, sizeof(*sc));
+
+  if (!s_x_cpu_topology_os(sc))
+    s_x_cpu_topology_guess(sc);
+
+  out->cpu_count = x_cpuset_count(&sc->online);
+  out->core_count = sc->core_count;
+  out->package_count = sc->package_count;
+  out->numa_node_count = sc->node_count;
+  out->cache_count = sc->cache_count;
+  out->caches = sc->caches;
+  out->cpus = (XCPULogical*)X_CPUID_ALLOC((size_t)out->cpu_count * sizeof(XCPULogical));
+  if (!out->cpus)
+  {
+    X_CPUID_FREE(sc->caches);
+    X_CPUID_FREE(sc);
+    memset(out, 0, sizeof(*out));
+    return false;
+  }
+
+  int32_t i = 0;
+  for (int32_t cpu = x_cpuset_next(&sc->online, -1); cpu >= 0; cpu = x_cpuset_next(&sc->online, cpu), i++)
+  {
+    XCPULogical* l = &out->cpus[i];
+    l->cpu = cpu;
+    l->core = sc->core[cpu];
+    l->package = sc->package[cpu];
+    l->numa_node = sc->node[cpu];
+    l->smt_index = 0;
+    l->smt_sibling = -1;
+    for (int32_t j = 0; j < i; j++)
+    {
+      if (out->cpus[j].core != l->core)
+        continue;
+      l->smt_index++;
+      if (out->cpus[j].smt_sibling < 0)
+        out->cpus[j].smt_sibling = cpu;
+      if (l->smt_sibling < 0)
+        l->smt_sibling = out->cpus[j].cpu;
+    }
+
+    l->cache[0] = l->cache[1] = l->cache[2] = -1;
+    for (int32_t c = 0; c < sc->cache_count; c++)
+    {
+      const XCPUCache* cache = &sc->caches[c];
+      if (cache->type != XCPU_CACHE_INSTRUCTION && x_cpuset_has(&cache->cpus, cpu))
+        l->cache[cache->level - 1] = c;
+    }
+  }
+
+  // The L1 data line is the coherence granule false sharing is about
+  out->cache_line_size = 0;
+  for (int32_t c = 0; c < sc->cache_count; c++)
+  {
+    if (sc->caches[c].level == 1 && sc->caches[c].type != XCPU_CACHE_INSTRUCTION && sc->caches[c].line_size > 0)
+    {
+      out->cache_line_size = sc->caches[c].line_size;
+      break;
+    }
+  }
+  if (out->cache_line_size == 0)
+    out->cache_line_size = x_cpu_info().cache_line_size;
+
+  X_CPUID_FREE(sc);
+  return true;
+}
+
+X_CPUID_API void x_cpu_topology_free(XCPUTopology* topology)
+{
+  if (!topology)
+    return;
+  X_CPUID_FREE(topology->cpus);
+  X_CPUID_FREE(topology->caches);
+  memset(topology, 0, sizeof(*topology));
+}
+
+X_CPUID_API const XCPULogical* x_cpu_topology_find(const XCPUTopology* topology, int32_t cpu)
+{
+  for (int32_t i = 0; i < topology->cpu_count; i++)
+  {
+    if (topology->cpus[i].cpu == cpu)
+      return &topology->cpus[i];
+  }
+  return NULL;
+}
+
+X_CPUID_API int32_t x_cpu_topology_cores(const XCPUTopology* topology, int32_t package, XCPUSet* out)
+{
+  x_cpuset_clear(out);
+  for (int32_t i = 0; i < topology->cpu_count; i++)
+  {
+    const XCPULogical* l = &topology->cpus[i];
+    if (l->smt_index == 0 && (package < 0 || l->package == package))
+      x_cpuset_add(out, l->cpu);
+  }
+  return x_cpuset_count(out);
+}
+
+X_CPUID_API int32_t x_cpu_topology_node(const XCPUTopology* topology, int32_t node, XCPUSet* out)
+{
+  x_cpuset_clear(out);
+  for (int32_t i = 0; i < topology->cpu_count; i++)
+  {
+    if (topology->cpus[i].numa_node == node)
+      x_cpuset_add(out, topology->cpus[i].cpu);
+  }
+  return x_cpuset_count(out);
 }
 
 #endif // X_IMPL_CPUID
-#endif // X_CPUID_H
@@ -16,6 +16,43 @@
  * - Temporary file and directory creation
  * - Functions accepts and preserves valid UTF-8 paths.
  *
+ * ## Copying
+ *
+ * `x_fs_file_copy()` lets the kernel move the bytes: a reflink (FICLONE)
+ * where the filesystem supports it, then `copy_file_range()` and
+ * `sendfile()` on Linux, `clonefile()`/`fcopyfile()` on macOS and
+ * `CopyFile()` on Windows, with a large-buffer read/write loop as the last
+ * resort. `x_fs_copy_tree()` mirrors a directory, optionally fanning the
+ * file copies out over an `XThreadPool` and skipping files whose size and
+ * modification time already match.
+ *
+ * ## Walking directory trees
+ *
+ * `x_fs_walk()` visits every entry below a root and hands the callback its
+ * path, type and, with `X_FS_WALK_STAT`, size and modification time. The type
+ * comes straight from the directory read (`d_type`, or the find data on
+ * Windows, fetched with `FIND_FIRST_EX_LARGE_FETCH`), so a walk that only
+ * needs names and types makes no per-entry stat calls. On POSIX the size and
+ * time cost one `fstatat()` relative to the open directory. Returning false
+ * from the filter skips an entry and, for a directory, everything below it.
+ * Given an `XThreadPool`, each subdirectory becomes a pool task and the
+ * callbacks run concurrently on the workers.
+ *
+ * ## Watch sets
+ *
+ * An `XFSWatchSet` multiplexes any number of (optionally recursive) watches
+ * on one inotify descriptor or one I/O completion port, exposed through
+ * `x_fs_watch_set_handle()` so it can sit in the same event loop as sockets.
+ * Events are coalesced per path: the burst of writes, temporary files and
+ * renames of an editor save turns into a single event, reported once the
+ * path has been quiet for the coalescing window. A file created and deleted
+ * within one window is not reported at all. `x_fs_watch_set_timeout()`
+ * tells an event loop when the next coalesced event becomes due.
+ *
+ * On Linux, recursive watches add one inotify watch per directory and pick
+ * up directories created later; files that appear inside a new directory
+ * before its watch is in place are reported as created.
+ *
  * ## How to compile
  * To compile the implementation define `X_IMPL_FILESYSTEM` 
  * in **one** source file before including this header.
@@ -26,6 +63,7 @@
  *
  * ## Dependencies
  *  stdx_string.h
+ *  stdx_thread.h (thread pool for x_fs_copy_tree and x_fs_walk)
  */
 
 #ifndef X_FILESYSTEM_H
@@ -36,8 +74,13 @@
 #define X_INTERNAL_STRING_IMPL
 #define X_IMPL_STRING
 #endif
+#ifndef X_IMPL_THREAD
+#define X_INTERNAL_THREAD_IMPL
+#define X_IMPL_THREAD
+#endif
 #endif
 #include "stdx_string.h"
+#include "stdx_thread.h"
 #include <stdint.h>
 #include <stdbool.h>
 #include <time.h>
@@ -51,6 +94,14 @@
 #define X_FILESYSTEM_VERSION_PATCH 0
 #define X_FILESYSTEM_VERSION (X_FILESYSTEM_VERSION_MAJOR * 10000 + X_FILESYSTEM_VERSION_MINOR * 100 + X_FILESYSTEM_VERSION_PATCH)
 
+#ifndef X_FS_COPY_BUFFER_SIZE
+#define X_FS_COPY_BUFFER_SIZE (256 * 1024)   /* read/write fallback buffer of x_fs_file_copy */
+#endif
+
+#ifndef X_FS_WATCH_SET_BUFFER_SIZE
+#define X_FS_WATCH_SET_BUFFER_SIZE (64 * 1024)   /* kernel event buffer of an XFSWatchSet (per root on Windows) */
+#endif
+
 #ifndef X_FS_PAHT_MAX_LENGTH
 # define X_FS_PAHT_MAX_LENGTH 512
 #endif
@@ -71,6 +122,7 @@ extern "C" {
   typedef struct XFSDireEntry_t XFSDireEntry;
   typedef struct XFSDireHandle_t XFSDireHandle;
   typedef struct XFSWatch_t XFSWatch;
+  typedef struct XFSWatchSet_t XFSWatchSet;
 
   struct XFSDireEntry_t
   {
@@ -96,6 +148,52 @@ extern "C" {
     const char* filename; // Valid until next poll
   } XFSWatchEvent;
 
+  typedef enum
+  {
+    X_FS_COPY_DEFAULT         = 0,
+    X_FS_COPY_SKIP_UNCHANGED  = 1 << 0,   // Skip files whose size and modification time match the destination
+  } XFSCopyFlags;
+
+  typedef struct XFSCopyStats
+  {
+    int32_t files_copied;
+    int32_t files_skipped;
+    int32_t failures;
+    int64_t bytes_copied;
+  } XFSCopyStats;
+
+  typedef enum
+  {
+    X_FS_WALK_DEFAULT         = 0,        // Immediate children only, type but no size/time
+    X_FS_WALK_RECURSIVE       = 1 << 0,   // Descend into subdirectories
+    X_FS_WALK_STAT            = 1 << 1,   // Fill size and last_modified
+    X_FS_WALK_FOLLOW_SYMLINKS = 1 << 2,   // Report links as their target and descend into linked directories
+  } XFSWalkFlags;
+
+  typedef enum
+  {
+    X_FS_ENTRY_FILE,
+    X_FS_ENTRY_DIRECTORY,
+    X_FS_ENTRY_SYMLINK,
+    X_FS_ENTRY_OTHER
+  } XFSEntryType;
+
+  typedef struct XFSWalkEntry
+  {
+    const char* path;       // Root joined with the entry's relative path. Valid during the call.
+    const char* name;       // Last component of path
+    size_t path_length;
+    XFSEntryType type;
+    uint32_t depth;         // 0 for children of the root
+    uint64_t size;          // Only with X_FS_WALK_STAT
+    time_t last_modified;   // Only with X_FS_WALK_STAT
+  } XFSWalkEntry;
+
+  /* Return false to skip an entry (and a directory's subtree) */
+  typedef bool (*XFSWalkFilter)(const XFSWalkEntry* entry, void* user);
+  /* Return false to stop the walk */
+  typedef bool (*XFSWalkCallback)(const XFSWalkEntry* entry, void* user);
+
   typedef struct XFSTime
   {
     int year;
@@ -158,6 +256,35 @@ extern "C" {
    */
   X_FILESYSTEM_API bool x_fs_file_copy(const char* file, const char* newFile);
 
+  /**
+   * @brief Copy a directory tree. Missing destination directories are created.
+   * Copied files keep the source modification time, so a later call with
+   * X_FS_COPY_SKIP_UNCHANGED only copies what changed.
+   * @param src_dir Source directory.
+   * @param dst_dir Destination directory.
+   * @param flags Combination of XFSCopyFlags.
+   * @param pool Thread pool that runs the file copies, or NULL to copy on the calling thread.
+   * @param out_stats Optional output receiving copy counters.
+   * @return True if every file was copied or skipped, false on any failure.
+   */
+  X_FILESYSTEM_API bool x_fs_copy_tree(const char* src_dir, const char* dst_dir, uint32_t flags, XThreadPool* pool, XFSCopyStats* out_stats);
+
+  /**
+   * @brief Visit the entries below a directory.
+   * Entries of a directory are reported before its subtree when walking
+   * serially. With a pool there is no ordering, callbacks run on worker
+   * threads at the same time, and stopping is best effort. Directories that
+   * cannot be opened below the root are skipped.
+   * @param root Directory to walk.
+   * @param flags Combination of XFSWalkFlags.
+   * @param filter Optional filter run before the callback.
+   * @param callback Function called for every entry that passes the filter.
+   * @param user User pointer passed to filter and callback.
+   * @param pool Thread pool to fan subdirectories out on, or NULL to walk on the calling thread.
+   * @return False if the root could not be opened or the callback stopped the walk, true otherwise.
+   */
+  X_FILESYSTEM_API bool x_fs_walk(const char* root, uint32_t flags, XFSWalkFilter filter, XFSWalkCallback callback, void* user, XThreadPool* pool);
+
   /**
    * @brief Rename (move) a file to a new path.
    * @param file Source file path.
@@ -231,6 +358,56 @@ extern "C" {
    */
   X_FILESYSTEM_API int32_t x_fs_watch_poll(XFSWatch* fw, XFSWatchEvent* out_events, int32_t max_events);
 
+  /**
+   * @brief Create an empty watch set.
+   * @param coalesce_ms How long a path must stay quiet before its coalesced event is reported. 0 reports on the next poll.
+   * @return Watch set, or NULL on failure.
+   */
+  X_FILESYSTEM_API XFSWatchSet* x_fs_watch_set_create(uint32_t coalesce_ms);
+
+  /**
+   * @brief Close every watch of a set and free it.
+   * @param set Watch set to destroy.
+   * @return Nothing.
+   */
+  X_FILESYSTEM_API void x_fs_watch_set_destroy(XFSWatchSet* set);
+
+  /**
+   * @brief Start watching a directory.
+   * @param set Watch set.
+   * @param path Directory to watch.
+   * @param recursive True to include every subdirectory, current and future.
+   * @return True on success, false on failure.
+   */
+  X_FILESYSTEM_API bool x_fs_watch_set_add(XFSWatchSet* set, const char* path, bool recursive);
+
+  /**
+   * @brief Read pending kernel events without blocking and report coalesced events that are due.
+   * Event filenames are full paths (watched directory joined with the
+   * changed entry), valid until the next poll. An x_fs_watch_UNKNOWN event
+   * on a watched directory means events were lost and it should be rescanned.
+   * @param set Watch set.
+   * @param out_events Output array to receive events.
+   * @param max_events Maximum number of events to write to out_events.
+   * @return Number of events written. Events that did not fit stay queued.
+   */
+  X_FILESYSTEM_API int32_t x_fs_watch_set_poll(XFSWatchSet* set, XFSWatchEvent* out_events, int32_t max_events);
+
+  /**
+   * @brief Milliseconds until the next coalesced event becomes due.
+   * @param set Watch set.
+   * @return Delay in milliseconds, or -1 when nothing is pending.
+   */
+  X_FILESYSTEM_API int32_t x_fs_watch_set_timeout(const XFSWatchSet* set);
+
+  /**
+   * @brief Native handle that becomes ready when kernel events arrive.
+   * An inotify file descriptor on Linux (for poll/epoll), an I/O completion port HANDLE on Windows.
+   * @param set Watch set.
+   * @return Handle, or -1 on failure.
+   */
+  X_FILESYSTEM_API intptr_t x_fs_watch_set_handle(const XFSWatchSet* set);
+
   /**
    * @brief Normalize a path in-place (e.g., separators, ".", ".." where possible).
    * @param input Path to normalize.
@@ -646,6 +823,13 @@ extern "C" {
 #include <errno.h>
 #include <limits.h>     // for PATH_MAX
 #include <fcntl.h>
+#include <sys/ioctl.h>
+
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#include <linux/fs.h>   // for FICLONE
+#endif
 
 #ifndef MAX_PATH
 #define MAX_PATH PATH_MAX
@@ -653,6 +837,8 @@ extern "C" {
 
 #ifdef __APPLE__
 #include <mach-o/dyld.h> // for _NSGetExecutablePath
+#include <copyfile.h>
+#include <sys/clonefile.h>
 #endif
 #endif
 
@@ -881,31 +1067,468 @@ extern "C" {
     return bytesCopied;
   }
 
+#ifndef _WIN32
+  /* Copies from the current offsets of `in` to `out`, trying the cheapest method first */
+  static bool s_fs_copy_fd(int in, int out, uint64_t size)
+  {
+#if defined(__linux__)
+    if (size > 0)
+    {
+#ifdef FICLONE
+      // Share extents instead of copying (btrfs, XFS, bcachefs)
+      if (ioctl(out, FICLONE, in) == 0)
+        return true;
+#endif
+      // Every stage below advances both offsets, so a stage that stops
+      // early hands over to the next one where it left off.
+      uint64_t done = 0;
+#ifdef __NR_copy_file_range
+      while (done < size)
+      {
+        ssize_t n = (ssize_t)syscall(__NR_copy_file_range, in, NULL, out, NULL, (size_t)(size - done), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += (uint64_t)n;
+      }
+#endif
+      while (done < size)
+      {
+        ssize_t n = sendfile(out, in, NULL, (size_t)(size - done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        done += (uint64_t)n;
+      }
+      if (done == size)
+        return true;
+    }
+#elif defined(__APPLE__)
+    if (size > 0 && fcopyfile(in, out, NULL, COPYFILE_DATA) == 0)
+      return true;
+#else
+    (void)size;
+#endif
+
+    // Files that report size 0 (procfs) or filesystems that refused the above
+    char* buf = (char*)X_FILESYSTEM_ALLOC(X_FS_COPY_BUFFER_SIZE);
+    if (!buf) return false;
+    bool ok = true;
+    for (;;)
+    {
+      ssize_t n = read(in, buf, X_FS_COPY_BUFFER_SIZE);
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0) { ok = false; break; }
+      if (n == 0) break;
+
+      ssize_t written = 0;
+      while (written < n)
+      {
+        ssize_t w = write(out, buf + written, (size_t)(n - written));
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) { ok = false; break; }
+        written += w;
+      }
+      if (!ok) break;
+    }
+    X_FILESYSTEM_FREE(buf);
+    return ok;
+  }
+#endif
+
   X_FILESYSTEM_API bool x_fs_file_copy(const char* file, const char* newFile)
   {
 #ifdef _WIN32
     return CopyFile(file, newFile, FALSE) != 0;
 #else
-    FILE *src = fopen(file, "rb");
-    if (!src) return false;
-    FILE *dst = fopen(newFile, "wb");
-    if (!dst)
-    { fclose(src); return false; }
+#ifdef __APPLE__
+    // Copy-on-write clone on APFS; only possible when the target does not exist yet
+    if (clonefile(file, newFile, 0) == 0)
+      return true;
+#endif
+    int in = open(file, O_RDONLY | O_CLOEXEC);
+    if (in < 0) return false;
+
+    struct stat st;
+    if (fstat(in, &st) != 0 || !S_ISREG(st.st_mode))
+    { close(in); return false; }
+
+    int out = open(newFile, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777);
+    if (out < 0)
+    { close(in); return false; }
+
+    bool ok = s_fs_copy_fd(in, out, (uint64_t)st.st_size);
+    close(in);
+    if (close(out) != 0) ok = false;
+    return ok;
+#endif
+  }
+
+  typedef struct XFSCopyJob XFSCopyJob;
+
+  typedef struct
+  {
+    uint32_t flags;
+    XTaskGroup group;
+    bool parallel;
+    XFSCopyJob* jobs;
+    volatile int32_t files_copied;
+    volatile int32_t files_skipped;
+    volatile int32_t failures;
+    volatile int64_t bytes_copied;
+  } XFSCopyTree;
+
+  struct XFSCopyJob
+  {
+    XFSCopyJob* next;
+    XFSCopyTree* tree;
+    XFSPath src;
+    XFSPath dst;
+    size_t size;
+    time_t mtime;
+  };
+
+  static bool s_fs_copy_is_unchanged(const XFSCopyJob* job)
+  {
+#ifdef _WIN32
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesEx(job->dst.buf, GetFileExInfoStandard, &data)) return false;
+    size_t size = ((size_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    return size == job->size && s_x_fs_filetime_to_time_t_(&data.ftLastWriteTime) == job->mtime;
+#else
+    struct stat st;
+    if (stat(job->dst.buf, &st) != 0) return false;
+    return (size_t)st.st_size == job->size && st.st_mtime == job->mtime;
+#endif
+  }
+
+  static void s_fs_copy_job_run(void* arg)
+  {
+    XFSCopyJob* job = (XFSCopyJob*)arg;
+    XFSCopyTree* tree = job->tree;
+
+    if ((tree->flags & X_FS_COPY_SKIP_UNCHANGED) && s_fs_copy_is_unchanged(job))
+    {
+      x_atomic_fetch_add_i32(&tree->files_skipped, 1);
+      return;
+    }
+
+    if (!x_fs_file_copy(job->src.buf, job->dst.buf))
+    {
+      x_atomic_fetch_add_i32(&tree->failures, 1);
+      return;
+    }
+
+#ifndef _WIN32
+    // CopyFile already keeps the timestamp on Windows
+    struct timespec times[2];
+    times[0].tv_sec = 0;
+    times[0].tv_nsec = UTIME_OMIT;
+    times[1].tv_sec = job->mtime;
+    times[1].tv_nsec = 0;
+    utimensat(AT_FDCWD, job->dst.buf, times, 0);
+#endif
+    x_atomic_fetch_add_i32(&tree->files_copied, 1);
+    x_atomic_fetch_add_i64(&tree->bytes_copied, (int64_t)job->size);
+  }
+
+  /* Walks one directory on the calling thread; directories are created before their files are queued */
+  static void s_fs_copy_tree_dir(XFSCopyTree* tree, const char* src_dir, const char* dst_dir)
+  {
+    if (!x_fs_directory_create_recursive(dst_dir))
+    {
+      x_atomic_fetch_add_i32(&tree->failures, 1);
+      return;
+    }
+
+    XFSDireEntry entry;
+    XFSDireHandle* handle = x_fs_find_first_file(src_dir, &entry);
+    if (!handle)
+    {
+      x_atomic_fetch_add_i32(&tree->failures, 1);
+      return;
+    }
+
+    do
+    {
+      if (strcmp(entry.name, ".") == 0 || strcmp(entry.name, "..") == 0)
+        continue;
+
+      XFSPath src, dst;
+      if (!x_fs_path(&src, src_dir, entry.name) || !x_fs_path(&dst, dst_dir, entry.name))
+      {
+        x_atomic_fetch_add_i32(&tree->failures, 1);
+        continue;
+      }
+
+      if (entry.is_directory)
+      {
+        s_fs_copy_tree_dir(tree, src.buf, dst.buf);
+        continue;
+      }
+
+      XFSCopyJob* job = (XFSCopyJob*)X_FILESYSTEM_ALLOC(sizeof(XFSCopyJob));
+      if (!job)
+      {
+        x_atomic_fetch_add_i32(&tree->failures, 1);
+        continue;
+      }
+      job->tree = tree;
+      job->src = src;
+      job->dst = dst;
+      job->size = entry.size;
+      job->mtime = entry.last_modified;
+      job->next = tree->jobs;
+      tree->jobs = job;
+
+      if (!tree->parallel || x_taskgroup_run(&tree->group, s_fs_copy_job_run, job) != 0)
+        s_fs_copy_job_run(job);
+    }
+    while (x_fs_find_next_file(handle, &entry));
+
+    x_fs_find_close(handle);
+  }
+
+  X_FILESYSTEM_API bool x_fs_copy_tree(const char* src_dir, const char* dst_dir, uint32_t flags, XThreadPool* pool, XFSCopyStats* out_stats)
+  {
+    if (!src_dir || !dst_dir) return false;
+
+    XFSCopyTree tree;
+    memset(&tree, 0, sizeof(tree));
+    tree.flags = flags;
+    tree.parallel = pool != NULL;
+    if (pool)
+      x_taskgroup_init(&tree.group, pool);
+
+    if (!x_fs_path_is_directory_cstr(src_dir))
+      tree.failures = 1;
+    else
+      s_fs_copy_tree_dir(&tree, src_dir, dst_dir);
+
+    if (pool)
+      x_taskgroup_wait(&tree.group);
+
+    while (tree.jobs)
+    {
+      XFSCopyJob* next = tree.jobs->next;
+      X_FILESYSTEM_FREE(tree.jobs);
+      tree.jobs = next;
+    }
+
+    if (out_stats)
+    {
+      out_stats->files_copied = tree.files_copied;
+      out_stats->files_skipped = tree.files_skipped;
+      out_stats->failures = tree.failures;
+      out_stats->bytes_copied = tree.bytes_copied;
+    }
+    return tree.failures == 0;
+  }
+
+  typedef struct
+  {
+    uint32_t flags;
+    XFSWalkFilter filter;
+    XFSWalkCallback callback;
+    void* user;
+    XTaskGroup group;
+    bool parallel;
+    volatile int32_t stop;
+  } XFSWalk;
+
+  typedef struct
+  {
+    XFSWalk* walk;
+    uint32_t depth;
+    size_t length;
+    char path[1];   /* allocated to length + 1 */
+  } XFSWalkDir;
+
+  static void s_fs_walk_dir(XFSWalk* walk, char* path, size_t length, uint32_t depth);
+
+  static void s_fs_walk_task(void* arg)
+  {
+    XFSWalkDir* dir = (XFSWalkDir*)arg;
+    char path[X_FS_MAX_PATH];
+    memcpy(path, dir->path, dir->length + 1);
+    s_fs_walk_dir(dir->walk, path, dir->length, dir->depth);
+    X_FILESYSTEM_FREE(dir);
+  }
+
+  /* Descends on this thread, or hands the subdirectory to the pool */
+  static void s_fs_walk_descend(XFSWalk* walk, char* path, size_t length, uint32_t depth)
+  {
+    if (walk->parallel)
+    {
+      XFSWalkDir* dir = (XFSWalkDir*)X_FILESYSTEM_ALLOC(sizeof(XFSWalkDir) + length);
+      if (dir)
+      {
+        dir->walk = walk;
+        dir->depth = depth;
+        dir->length = length;
+        memcpy(dir->path, path, length + 1);
+        if (x_taskgroup_run(&walk->group, s_fs_walk_task, dir) == 0)
+          return;
+        X_FILESYSTEM_FREE(dir);
+      }
+    }
+    s_fs_walk_dir(walk, path, length, depth);
+    path[length] = 0;
+  }
+
+  /* Reports one entry; returns true if the walk should descend into it */
+  static bool s_fs_walk_visit(XFSWalk* walk, XFSWalkEntry* entry)
+  {
+    if (walk->filter && !walk->filter(entry, walk->user))
+      return false;
+    if (walk->callback && !walk->callback(entry, walk->user))
+    {
+      x_atomic_store_i32(&walk->stop, 1);
+      return false;
+    }
+    return entry->type == X_FS_ENTRY_DIRECTORY && (walk->flags & X_FS_WALK_RECURSIVE);
+  }
+
+  /* `path` has room for X_FS_MAX_PATH bytes; children are appended in place */
+  static void s_fs_walk_dir(XFSWalk* walk, char* path, size_t length, uint32_t depth)
+  {
+    XFSWalkEntry entry;
+    entry.path = path;
+    entry.depth = depth;
+
+#ifdef _WIN32
+    if (length + 3 > X_FS_MAX_PATH) return;
+    path[length] = X_FS_PATH_SEPARATOR;
+    path[length + 1] = '*';
+    path[length + 2] = 0;
+
+    WIN32_FIND_DATAA data;
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0601
+    HANDLE h = FindFirstFileExA(path, FindExInfoBasic, &data, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+#else
+    HANDLE h = FindFirstFileExA(path, FindExInfoStandard, &data, FindExSearchNameMatch, NULL, 0);
+#endif
+    path[length] = 0;
+    if (h == INVALID_HANDLE_VALUE) return;
 
-    char buf[4096];
-    size_t n;
-    while ((n = fread(buf, 1, sizeof(buf), src)) > 0)
+    do
     {
-      if (fwrite(buf, 1, n, dst) != n)
+      const char* name = data.cFileName;
+      if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0) continue;
+
+      size_t name_length = strlen(name);
+      if (length + 1 + name_length >= X_FS_MAX_PATH) continue;
+      path[length] = X_FS_PATH_SEPARATOR;
+      memcpy(path + length + 1, name, name_length + 1);
+
+      entry.name = path + length + 1;
+      entry.path_length = length + 1 + name_length;
+      if ((data.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && !(walk->flags & X_FS_WALK_FOLLOW_SYMLINKS))
+        entry.type = X_FS_ENTRY_SYMLINK;
+      else if (data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        entry.type = X_FS_ENTRY_DIRECTORY;
+      else
+        entry.type = X_FS_ENTRY_FILE;
+      entry.size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+      entry.last_modified = s_x_fs_filetime_to_time_t_(&data.ftLastWriteTime);
+
+      if (s_fs_walk_visit(walk, &entry))
+        s_fs_walk_descend(walk, path, entry.path_length, depth + 1);
+      path[length] = 0;
+    }
+    while (!x_atomic_load_i32(&walk->stop) && FindNextFileA(h, &data));
+
+    FindClose(h);
+#else
+    DIR* dir = opendir(length > 0 ? path : "/");
+    if (!dir) return;
+
+    struct dirent* de;
+    while (!x_atomic_load_i32(&walk->stop) && (de = readdir(dir)) != NULL)
+    {
+      const char* name = de->d_name;
+      if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) continue;
+
+      size_t name_length = strlen(name);
+      if (length + 1 + name_length >= X_FS_MAX_PATH) continue;
+      path[length] = X_FS_PATH_SEPARATOR;
+      memcpy(path + length + 1, name, name_length + 1);
+
+      entry.name = path + length + 1;
+      entry.path_length = length + 1 + name_length;
+      entry.size = 0;
+      entry.last_modified = 0;
+      entry.type = X_FS_ENTRY_OTHER;
+
+      bool need_stat = (walk->flags & X_FS_WALK_STAT) != 0;
+#ifdef DT_UNKNOWN
+      switch (de->d_type)
       {
-        fclose(src); fclose(dst); return false;
+        case DT_REG: entry.type = X_FS_ENTRY_FILE; break;
+        case DT_DIR: entry.type = X_FS_ENTRY_DIRECTORY; break;
+        case DT_LNK: entry.type = X_FS_ENTRY_SYMLINK; break;
+        case DT_UNKNOWN: need_stat = true; break;
+        default: break;
       }
+#else
+      need_stat = true;
+#endif
+      if (entry.type == X_FS_ENTRY_SYMLINK && (walk->flags & X_FS_WALK_FOLLOW_SYMLINKS))
+        need_stat = true;
+
+      if (need_stat)
+      {
+        struct stat st;
+        int stat_flags = (walk->flags & X_FS_WALK_FOLLOW_SYMLINKS) ? 0 : AT_SYMLINK_NOFOLLOW;
+        if (fstatat(dirfd(dir), name, &st, stat_flags) == 0)
+        {
+          if (S_ISREG(st.st_mode)) entry.type = X_FS_ENTRY_FILE;
+          else if (S_ISDIR(st.st_mode)) entry.type = X_FS_ENTRY_DIRECTORY;
+          else if (S_ISLNK(st.st_mode)) entry.type = X_FS_ENTRY_SYMLINK;
+          else entry.type = X_FS_ENTRY_OTHER;
+          entry.size = (uint64_t)st.st_size;
+          entry.last_modified = st.st_mtime;
+        }
+      }
+
+      if (s_fs_walk_visit(walk, &entry))
+        s_fs_walk_descend(walk, path, entry.path_length, depth + 1);
+      path[length] = 0;
     }
-    fclose(src); fclose(dst);
-    return true;
+
+    closedir(dir);
 #endif
   }
 
+  X_FILESYSTEM_API bool x_fs_walk(const char* root, uint32_t flags, XFSWalkFilter filter, XFSWalkCallback callback, void* user, XThreadPool* pool)
+  {
+    if (!root) return false;
+    char path[X_FS_MAX_PATH];
+    size_t length = strlen(root);
+    if (length >= X_FS_MAX_PATH) return false;
+    memcpy(path, root, length + 1);
+
+    // Joining appends a separator, so drop the root's own trailing ones
+    while (length > 0 && (path[length - 1] == '/' || path[length - 1] == '\\'))
+      path[--length] = 0;
+
+    if (!x_fs_path_is_directory_cstr(length > 0 ? path : root)) return false;
+
+    XFSWalk walk;
+    memset(&walk, 0, sizeof(walk));
+    walk.flags = flags;
+    walk.filter = filter;
+    walk.callback = callback;
+    walk.user = user;
+    walk.parallel = pool != NULL;
+    if (pool)
+      x_taskgroup_init(&walk.group, pool);
+
+    s_fs_walk_dir(&walk, path, length, 0);
+
+    if (pool)
+      x_taskgroup_wait(&walk.group);
+    return walk.stop == 0;
+  }
+
   X_FILESYSTEM_API bool x_fs_file_rename(const char* file, const char* newFile)
   {
 #ifdef _WIN32
@@ -1116,7 +1739,7 @@ extern "C" {
 
 #ifdef _WIN32
     wchar_t wpath[X_FS_MAX_PATH];
-    MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, X_FS_MAX_PATH);
+    x_utf8_to_utf16(path, strlen(path), (uint16_t*)wpath, X_FS_MAX_PATH);
 
     fw->dir = CreateFileW(wpath, FILE_LIST_DIRECTORY,
         FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
@@ -1194,9 +1817,9 @@ extern "C" {
     while (fw->last_bytes && count < max_events) {
       fni = (FILE_NOTIFY_INFORMATION*)ptr;
 
-      int32_t len = WideCharToMultiByte(CP_UTF8, 0, fni->FileName,
-          fni->FileNameLength / 2, filename, sizeof(filename) - 1, NULL, NULL);
-      filename[len] = 0;
+      // A name with an unpaired surrogate is not valid UTF-16 and is reported empty
+      if (x_utf16_to_utf8((const uint16_t*)fni->FileName, fni->FileNameLength / 2, filename, sizeof(filename)) == (size_t)-1)
+        filename[0] = 0;
 
       XFSWatchEvent ev = { x_fs_watch_UNKNOWN, filename };
 
@@ -1250,6 +1873,573 @@ extern "C" {
     return count;
   }
 
+  typedef struct
+  {
+    char* path;
+    uint32_t hash;
+    int32_t next;             // next entry in the same bucket, -1 ends the chain
+    XFSWatchEventType action;
+    uint64_t last_ms;         // time of the latest event for this path
+  } XFSWatchPending;
+
+#ifdef _WIN32
+  typedef struct
+  {
+    OVERLAPPED overlapped;    // first: completions hand back this address
+    HANDLE dir;
+    bool recursive;
+    char* path;
+    DWORD buffer[X_FS_WATCH_SET_BUFFER_SIZE / sizeof(DWORD)];
+  } XFSWatchRoot;
+#endif
+
+  struct XFSWatchSet_t
+  {
+    uint32_t coalesce_ms;
+    XFSWatchPending* pending;
+    int32_t pending_count;
+    int32_t pending_capacity;
+    int32_t* buckets;
+    int32_t bucket_count;     // power of two, >= 2 * pending_capacity
+    char** emitted;           // paths handed out by the last poll
+    int32_t emitted_count;
+    int32_t emitted_capacity;
+#ifdef _WIN32
+    HANDLE port;
+    XFSWatchRoot** roots;
+    int32_t root_count;
+    int32_t root_capacity;
+#elif defined(__linux__)
+    int32_t fd;
+    char** wd_paths;          // watched directory per watch descriptor
+    bool* wd_recursive;
+    bool* wd_root;
+    int32_t wd_capacity;
+    uint64_t buffer[X_FS_WATCH_SET_BUFFER_SIZE / sizeof(uint64_t)];
+#endif
+  };
+
+  static uint64_t s_fs_watch_now_ms(void)
+  {
+#ifdef _WIN32
+    return (uint64_t)GetTickCount64();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+#endif
+  }
+
+  static uint32_t s_fs_watch_hash(const char* s, size_t length)
+  {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+      h ^= (uint8_t)s[i];
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  static void s_fs_watch_reindex(XFSWatchSet* set)
+  {
+    for (int32_t i = 0; i < set->bucket_count; i++)
+      set->buckets[i] = -1;
+    for (int32_t i = 0; i < set->pending_count; i++)
+    {
+      int32_t b = (int32_t)(set->pending[i].hash & (uint32_t)(set->bucket_count - 1));
+      set->pending[i].next = set->buckets[b];
+      set->buckets[b] = i;
+    }
+  }
+
+  static bool s_fs_watch_grow(XFSWatchSet* set)
+  {
+    int32_t capacity = set->pending_capacity ? set->pending_capacity * 2 : 64;
+    XFSWatchPending* pending = (XFSWatchPending*)X_FILESYSTEM_ALLOC(sizeof(XFSWatchPending) * (size_t)capacity);
+    int32_t* buckets = (int32_t*)X_FILESYSTEM_ALLOC(sizeof(int32_t) * (size_t)capacity * 2);
+    if (!pending || !buckets)
+    {
+      X_FILESYSTEM_FREE(pending);
+      X_FILESYSTEM_FREE(buckets);
+      return false;
+    }
+    if (set->pending_count > 0)
+      memcpy(pending, set->pending, sizeof(XFSWatchPending) * (size_t)set->pending_count);
+    X_FILESYSTEM_FREE(set->pending);
+    X_FILESYSTEM_FREE(set->buckets);
+    set->pending = pending;
+    set->buckets = buckets;
+    set->pending_capacity = capacity;
+    set->bucket_count = capacity * 2;
+    s_fs_watch_reindex(set);
+    return true;
+  }
+
+  static void s_fs_watch_drop(XFSWatchSet* set, int32_t index)
+  {
+    X_FILESYSTEM_FREE(set->pending[index].path);
+    set->pending[index] = set->pending[--set->pending_count];
+    s_fs_watch_reindex(set);
+  }
+
+  /* Records an event for `dir` joined with `name`, merging it with the one pending for that path */
+  static void s_fs_watch_note(XFSWatchSet* set, const char* dir, const char* name, size_t name_length, XFSWatchEventType action, uint64_t now)
+  {
+    char path[X_FS_MAX_PATH];
+    size_t dir_length = strlen(dir);
+    size_t length = dir_length;
+    if (dir_length + 1 + name_length >= sizeof(path)) return;
+    memcpy(path, dir, dir_length);
+    if (name_length > 0)
+    {
+      path[length++] = X_FS_PATH_SEPARATOR;
+      memcpy(path + length, name, name_length);
+      length += name_length;
+    }
+    path[length] = 0;
+
+    uint32_t hash = s_fs_watch_hash(path, length);
+    if (set->bucket_count > 0)
+    {
+      for (int32_t i = set->buckets[hash & (uint32_t)(set->bucket_count - 1)]; i >= 0; i = set->pending[i].next)
+      {
+        XFSWatchPending* p = &set->pending[i];
+        if (p->hash != hash || strcmp(p->path, path) != 0) continue;
+
+        XFSWatchEventType prev = p->action;
+        bool gone = action == x_fs_watch_DELETED || action == x_fs_watch_RENAMED_FROM;
+        bool back = action == x_fs_watch_CREATED || action == x_fs_watch_RENAMED_TO;
+
+        if ((prev == x_fs_watch_CREATED || prev == x_fs_watch_RENAMED_TO) && gone)
+        {
+          // Appeared and vanished inside one window: temporary file
+          s_fs_watch_drop(set, i);
+          return;
+        }
+        if ((prev == x_fs_watch_DELETED || prev == x_fs_watch_RENAMED_FROM) && back)
+          p->action = x_fs_watch_MODIFIED;   // replaced, e.g. by an atomic save
+        else if (!((prev == x_fs_watch_CREATED || prev == x_fs_watch_RENAMED_TO) && action == x_fs_watch_MODIFIED))
+          p->action = action;
+        p->last_ms = now;
+        return;
+      }
+    }
+
+    if (set->pending_count == set->pending_capacity && !s_fs_watch_grow(set)) return;
+    char* copy = (char*)X_FILESYSTEM_ALLOC(length + 1);
+    if (!copy) return;
+    memcpy(copy, path, length + 1);
+
+    XFSWatchPending* p = &set->pending[set->pending_count];
+    p->path = copy;
+    p->hash = hash;
+    p->action = action;
+    p->last_ms = now;
+    int32_t b = (int32_t)(hash & (uint32_t)(set->bucket_count - 1));
+    p->next = set->buckets[b];
+    set->buckets[b] = set->pending_count++;
+  }
+
+#ifdef _WIN32
+  static bool s_fs_watch_root_arm(XFSWatchRoot* root)
+  {
+    memset(&root->overlapped, 0, sizeof(root->overlapped));
+    return ReadDirectoryChangesW(root->dir, root->buffer, sizeof(root->buffer), root->recursive,
+        FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_DIR_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_CREATION,
+        NULL, &root->overlapped, NULL) != 0;
+  }
+
+  static void s_fs_watch_set_drain(XFSWatchSet* set, uint64_t now)
+  {
+    DWORD bytes;
+    ULONG_PTR key;
+    OVERLAPPED* ov;
+
+    while (GetQueuedCompletionStatus(set->port, &bytes, &key, &ov, 0) || ov)
+    {
+      if (!ov) break;
+      XFSWatchRoot* root = (XFSWatchRoot*)ov;
+
+      if (bytes == 0)
+      {
+        // The notification buffer overflowed
+        s_fs_watch_note(set, root->path, "", 0, x_fs_watch_UNKNOWN, now);
+      }
+      else
+      {
+        BYTE* ptr = (BYTE*)root->buffer;
+        for (;;)
+        {
+          FILE_NOTIFY_INFORMATION* fni = (FILE_NOTIFY_INFORMATION*)ptr;
+          char name[X_FS_MAX_PATH];
+          size_t utf8_len = x_utf16_to_utf8((const uint16_t*)fni->FileName, fni->FileNameLength / 2, name, sizeof(name));
+          int32_t len = utf8_len == (size_t)-1 ? 0 : (int32_t)utf8_len;
+          XFSWatchEventType action = x_fs_watch_UNKNOWN;
+          switch (fni->Action)
+          {
+            case FILE_ACTION_ADDED: action = x_fs_watch_CREATED; break;
+            case FILE_ACTION_REMOVED: action = x_fs_watch_DELETED; break;
+            case FILE_ACTION_MODIFIED: action = x_fs_watch_MODIFIED; break;
+            case FILE_ACTION_RENAMED_OLD_NAME: action = x_fs_watch_RENAMED_FROM; break;
+            case FILE_ACTION_RENAMED_NEW_NAME: action = x_fs_watch_RENAMED_TO; break;
+          }
+          if (len > 0)
+            s_fs_watch_note(set, root->path, name, (size_t)len, action, now);
+
+          if (!fni->NextEntryOffset) break;
+          ptr += fni->NextEntryOffset;
+        }
+      }
+
+      if (!s_fs_watch_root_arm(root))
+        s_fs_watch_note(set, root->path, "", 0, x_fs_watch_UNKNOWN, now);
+    }
+  }
+
+#elif defined(__linux__)
+#define X_FS_WATCH_SET_MASK (IN_CREATE | IN_DELETE | IN_MODIFY | IN_MOVED_FROM | IN_MOVED_TO | IN_MOVE_SELF)
+
+  static bool s_fs_watch_add_one(XFSWatchSet* set, const char* path, bool recursive, bool is_root)
+  {
+    int32_t wd = inotify_add_watch(set->fd, path, X_FS_WATCH_SET_MASK);
+    if (wd < 0) return false;
+
+    if (wd >= set->wd_capacity)
+    {
+      int32_t capacity = set->wd_capacity ? set->wd_capacity : 64;
+      while (capacity <= wd) capacity *= 2;
+      char** paths = (char**)X_FILESYSTEM_CALLOC((size_t)capacity, sizeof(char*));
+      bool* rec = (bool*)X_FILESYSTEM_CALLOC((size_t)capacity, sizeof(bool));
+      bool* roots = (bool*)X_FILESYSTEM_CALLOC((size_t)capacity, sizeof(bool));
+      if (!paths || !rec || !roots)
+      {
+        X_FILESYSTEM_FREE(paths);
+        X_FILESYSTEM_FREE(rec);
+        X_FILESYSTEM_FREE(roots);
+        inotify_rm_watch(set->fd, wd);
+        return false;
+      }
+      if (set->wd_capacity > 0)
+      {
+        memcpy(paths, set->wd_paths, sizeof(char*) * (size_t)set->wd_capacity);
+        memcpy(rec, set->wd_recursive, sizeof(bool) * (size_t)set->wd_capacity);
+        memcpy(roots, set->wd_root, sizeof(bool) * (size_t)set->wd_capacity);
+      }
+      X_FILESYSTEM_FREE(set->wd_paths);
+      X_FILESYSTEM_FREE(set->wd_recursive);
+      X_FILESYSTEM_FREE(set->wd_root);
+      set->wd_paths = paths;
+      set->wd_recursive = rec;
+      set->wd_root = roots;
+      set->wd_capacity = capacity;
+    }
+
+    // Adding a directory that is already watched returns its existing descriptor
+    size_t length = strlen(path);
+    char* copy = (char*)X_FILESYSTEM_ALLOC(length + 1);
+    if (!copy) return false;
+    memcpy(copy, path, length + 1);
+    X_FILESYSTEM_FREE(set->wd_paths[wd]);
+    set->wd_paths[wd] = copy;
+    set->wd_recursive[wd] = set->wd_recursive[wd] || recursive;
+    set->wd_root[wd] = set->wd_root[wd] || is_root;
+    return true;
+  }
+
+  typedef struct
+  {
+    XFSWatchSet* set;
+    uint64_t now;
+    bool report;
+  } XFSWatchTree;
+
+  static bool s_fs_watch_tree_entry(const XFSWalkEntry* entry, void* user)
+  {
+    XFSWatchTree* tree = (XFSWatchTree*)user;
+    if (entry->type == X_FS_ENTRY_DIRECTORY)
+      s_fs_watch_add_one(tree->set, entry->path, true, false);
+
+    // Entries that appeared in a new directory before its watch existed
+    if (tree->report)
+      s_fs_watch_note(tree->set, entry->path, "", 0, x_fs_watch_CREATED, tree->now);
+    return true;
+  }
+
+  static void s_fs_watch_add_tree(XFSWatchSet* set, const char* path, bool report, uint64_t now)
+  {
+    XFSWatchTree tree;
+    tree.set = set;
+    tree.now = now;
+    tree.report = report;
+    x_fs_walk(path, X_FS_WALK_RECURSIVE, NULL, s_fs_watch_tree_entry, &tree, NULL);
+  }
+
+  static void s_fs_watch_set_drain(XFSWatchSet* set, uint64_t now)
+  {
+    for (;;)
+    {
+      ssize_t len = read(set->fd, set->buffer, sizeof(set->buffer));
+      if (len <= 0) break;
+
+      for (ssize_t offset = 0; offset < len; )
+      {
+        struct inotify_event* e = (struct inotify_event*)((char*)set->buffer + offset);
+        offset += (ssize_t)(sizeof(struct inotify_event) + e->len);
+
+        if (e->mask & IN_Q_OVERFLOW)
+        {
+          for (int32_t wd = 0; wd < set->wd_capacity; wd++)
+          {
+            if (set->wd_paths[wd] && set->wd_root[wd])
+              s_fs_watch_note(set, set->wd_paths[wd], "", 0, x_fs_watch_UNKNOWN, now);
+          }
+          continue;
+        }
+        if (e->wd < 0 || e->wd >= set->wd_capacity || !set->wd_paths[e->wd]) continue;
+
+        if (e->mask & IN_IGNORED)
+        {
+          // The kernel dropped the watch: directory deleted or unmounted
+          X_FILESYSTEM_FREE(set->wd_paths[e->wd]);
+          set->wd_paths[e->wd] = NULL;
+          set->wd_recursive[e->wd] = false;
+          set->wd_root[e->wd] = false;
+          continue;
+        }
+        if (e->mask & IN_MOVE_SELF)
+        {
+          // A subdirectory moved away; its events now arrive as RENAMED_FROM on the parent
+          if (!set->wd_root[e->wd])
+            inotify_rm_watch(set->fd, e->wd);
+          continue;
+        }
+        if (e->len == 0) continue;
+
+        const char* dir = set->wd_paths[e->wd];
+        size_t name_length = strlen(e->name);
+        XFSWatchEventType action = x_fs_watch_UNKNOWN;
+        if (e->mask & IN_CREATE)     action = x_fs_watch_CREATED;
+        if (e->mask & IN_DELETE)     action = x_fs_watch_DELETED;
+        if (e->mask & IN_MODIFY)     action = x_fs_watch_MODIFIED;
+        if (e->mask & IN_MOVED_FROM) action = x_fs_watch_RENAMED_FROM;
+        if (e->mask & IN_MOVED_TO)   action = x_fs_watch_RENAMED_TO;
+        s_fs_watch_note(set, dir, e->name, name_length, action, now);
+
+        if ((e->mask & IN_ISDIR) && (e->mask & (IN_CREATE | IN_MOVED_TO)) && set->wd_recursive[e->wd])
+        {
+          char path[X_FS_MAX_PATH];
+          int n = snprintf(path, sizeof(path), "%s%c%s", dir, X_FS_PATH_SEPARATOR, e->name);
+          if (n > 0 && (size_t)n < sizeof(path) && s_fs_watch_add_one(set, path, true, false))
+            s_fs_watch_add_tree(set, path, true, now);
+        }
+      }
+    }
+  }
+#endif
+
+  X_FILESYSTEM_API XFSWatchSet* x_fs_watch_set_create(uint32_t coalesce_ms)
+  {
+    XFSWatchSet* set = (XFSWatchSet*)X_FILESYSTEM_CALLOC(1, sizeof(XFSWatchSet));
+    if (!set) return NULL;
+    set->coalesce_ms = coalesce_ms;
+
+#ifdef _WIN32
+    set->port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (!set->port)
+    {
+      X_FILESYSTEM_FREE(set);
+      return NULL;
+    }
+#elif defined(__linux__)
+    set->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (set->fd < 0)
+    {
+      X_FILESYSTEM_FREE(set);
+      return NULL;
+    }
+#else
+#error "x_fs_watch_set_create: Unsupported platform"
+#endif
+
+    if (!s_fs_watch_grow(set))
+    {
+      x_fs_watch_set_destroy(set);
+      return NULL;
+    }
+    return set;
+  }
+
+  X_FILESYSTEM_API void x_fs_watch_set_destroy(XFSWatchSet* set)
+  {
+    if (!set) return;
+
+#ifdef _WIN32
+    for (int32_t i = 0; i < set->root_count; i++)
+    {
+      XFSWatchRoot* root = set->roots[i];
+      CancelIoEx(root->dir, &root->overlapped);
+      DWORD bytes;
+      GetOverlappedResult(root->dir, &root->overlapped, &bytes, TRUE);
+      CloseHandle(root->dir);
+      X_FILESYSTEM_FREE(root->path);
+      X_FILESYSTEM_FREE(root);
+    }
+    X_FILESYSTEM_FREE(set->roots);
+    CloseHandle(set->port);
+#elif defined(__linux__)
+    for (int32_t wd = 0; wd < set->wd_capacity; wd++)
+      X_FILESYSTEM_FREE(set->wd_paths[wd]);
+    X_FILESYSTEM_FREE(set->wd_paths);
+    X_FILESYSTEM_FREE(set->wd_recursive);
+    X_FILESYSTEM_FREE(set->wd_root);
+    close(set->fd);
+#endif
+
+    for (int32_t i = 0; i < set->pending_count; i++)
+      X_FILESYSTEM_FREE(set->pending[i].path);
+    for (int32_t i = 0; i < set->emitted_count; i++)
+      X_FILESYSTEM_FREE(set->emitted[i]);
+    X_FILESYSTEM_FREE(set->pending);
+    X_FILESYSTEM_FREE(set->buckets);
+    X_FILESYSTEM_FREE(set->emitted);
+    X_FILESYSTEM_FREE(set);
+  }
+
+  X_FILESYSTEM_API bool x_fs_watch_set_add(XFSWatchSet* set, const char* path, bool recursive)
+  {
+    if (!set || !path || !x_fs_is_directory(path)) return false;
+
+#ifdef _WIN32
+    if (set->root_count == set->root_capacity)
+    {
+      int32_t capacity = set->root_capacity ? set->root_capacity * 2 : 8;
+      XFSWatchRoot** roots = (XFSWatchRoot**)X_FILESYSTEM_ALLOC(sizeof(XFSWatchRoot*) * (size_t)capacity);
+      if (!roots) return false;
+      if (set->root_count > 0)
+        memcpy(roots, set->roots, sizeof(XFSWatchRoot*) * (size_t)set->root_count);
+      X_FILESYSTEM_FREE(set->roots);
+      set->roots = roots;
+      set->root_capacity = capacity;
+    }
+
+    XFSWatchRoot* root = (XFSWatchRoot*)X_FILESYSTEM_CALLOC(1, sizeof(XFSWatchRoot));
+    size_t length = strlen(path);
+    char* copy = (char*)X_FILESYSTEM_ALLOC(length + 1);
+    if (!root || !copy)
+    {
+      X_FILESYSTEM_FREE(root);
+      X_FILESYSTEM_FREE(copy);
+      return false;
+    }
+    memcpy(copy, path, length + 1);
+    // Child paths are joined to the root, so drop a trailing separator
+    while (length > 1 && (copy[length - 1] == '/' || copy[length - 1] == '\\'))
+      copy[--length] = 0;
+
+    wchar_t wpath[X_FS_MAX_PATH];
+    x_utf8_to_utf16(path, strlen(path), (uint16_t*)wpath, X_FS_MAX_PATH);
+    root->dir = CreateFileW(wpath, FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        NULL, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    root->recursive = recursive;
+    root->path = copy;
+
+    if (root->dir == INVALID_HANDLE_VALUE
+        || !CreateIoCompletionPort(root->dir, set->port, (ULONG_PTR)root, 0)
+        || !s_fs_watch_root_arm(root))
+    {
+      if (root->dir != INVALID_HANDLE_VALUE) CloseHandle(root->dir);
+      X_FILESYSTEM_FREE(copy);
+      X_FILESYSTEM_FREE(root);
+      return false;
+    }
+    set->roots[set->root_count++] = root;
+    return true;
+
+#elif defined(__linux__)
+    char dir[X_FS_MAX_PATH];
+    size_t length = strlen(path);
+    if (length >= sizeof(dir)) return false;
+    memcpy(dir, path, length + 1);
+    while (length > 1 && dir[length - 1] == '/')
+      dir[--length] = 0;
+
+    if (!s_fs_watch_add_one(set, dir, recursive, true)) return false;
+    if (recursive)
+      s_fs_watch_add_tree(set, dir, false, 0);
+    return true;
+#endif
+  }
+
+  X_FILESYSTEM_API int32_t x_fs_watch_set_poll(XFSWatchSet* set, XFSWatchEvent* out_events, int32_t max_events)
+  {
+    if (!set || !out_events || max_events <= 0) return 0;
+
+    for (int32_t i = 0; i < set->emitted_count; i++)
+      X_FILESYSTEM_FREE(set->emitted[i]);
+    set->emitted_count = 0;
+
+    uint64_t now = s_fs_watch_now_ms();
+    s_fs_watch_set_drain(set, now);
+
+    if (max_events > set->emitted_capacity)
+    {
+      char** emitted = (char**)X_FILESYSTEM_ALLOC(sizeof(char*) * (size_t)max_events);
+      if (!emitted) return 0;
+      X_FILESYSTEM_FREE(set->emitted);
+      set->emitted = emitted;
+      set->emitted_capacity = max_events;
+    }
+
+    int32_t count = 0;
+    int32_t i = 0;
+    while (i < set->pending_count && count < max_events)
+    {
+      XFSWatchPending* p = &set->pending[i];
+      if (now - p->last_ms < set->coalesce_ms)
+      {
+        i++;
+        continue;
+      }
+      out_events[count].action = p->action;
+      out_events[count].filename = p->path;
+      set->emitted[count++] = p->path;
+      set->pending[i] = set->pending[--set->pending_count];
+    }
+
+    if (count > 0)
+      s_fs_watch_reindex(set);
+    set->emitted_count = count;
+    return count;
+  }
+
+  X_FILESYSTEM_API int32_t x_fs_watch_set_timeout(const XFSWatchSet* set)
+  {
+    if (!set || set->pending_count == 0) return -1;
+
+    uint64_t now = s_fs_watch_now_ms();
+    uint64_t wait = set->coalesce_ms;
+    for (int32_t i = 0; i < set->pending_count; i++)
+    {
+      uint64_t elapsed = now - set->pending[i].last_ms;
+      uint64_t left = elapsed >= set->coalesce_ms ? 0 : set->coalesce_ms - elapsed;
+      if (left < wait) wait = left;
+    }
+    return (int32_t)wait;
+  }
+
+  X_FILESYSTEM_API intptr_t x_fs_watch_set_handle(const XFSWatchSet* set)
+  {
+    if (!set) return -1;
+#ifdef _WIN32
+    return (intptr_t)set->port;
+#else
+    return (intptr_t)set->fd;
+#endif
+  }
+
   X_FILESYSTEM_API size_t x_fs_get_temp_folder(XFSPath* out)
   {
 #ifdef _WIN32
@@ -2279,6 +3469,7 @@ extern "C" {
     const char* from;
     const char* to;
     size_t common;
+    size_t from_common;
     size_t up_count;
     char tmp[sizeof(out_path->buf)];
     size_t pos = 0;
@@ -2300,9 +3491,12 @@ extern "C" {
 
     common = s_x_fs_find_common_prefix_boundary(from, to);
 
-    while (from[common] && s_x_fs_is_separator(from[common]))
+    // The boundary skips the separator after a base that ends where `to` continues
+    from_common = common < from_norm.length ? common : from_norm.length;
+
+    while (from[from_common] && s_x_fs_is_separator(from[from_common]))
     {
-      common++;
+      from_common++;
     }
 
     while (to[common] && s_x_fs_is_separator(to[common]))
@@ -2310,7 +3504,7 @@ extern "C" {
       common++;
     }
 
-    up_count = s_x_fs_count_remaining_segments(from + common);
+    up_count = s_x_fs_count_remaining_segments(from + from_common);
 
     for (i = 0; i < up_count; i++)
     {
@@ -2388,4 +3582,8 @@ extern "C" {
 #undef X_IMPL_STRING
 #undef X_INTERNAL_STRING_IMPL
 #endif
+#ifdef X_INTERNAL_THREAD_IMPL
+#undef X_IMPL_THREAD
+#undef X_INTERNAL_THREAD_IMPL
+#endif
 #endif  // X_FILESYSTEM_H
@@ -18,6 +18,8 @@
  * 
  * To customize how this module allocates memory, define 
  * X_HASHTABLE_ALLOC / X_HASHTABLE_REALLOC / X_HASHTABLE_FREE before including.
+ * To pick the allocator per table at runtime, create it with
+ * x_hashtable_create_with_allocator() and an XAllocator (see stdx_common.h).
  *
  * ## Typed usage (recommended)
  *
@@ -81,6 +83,43 @@
  * Internally these wrappers call the generic API, so there is no
  * additional runtime overhead.
  *
+ * ## Growth
+ *
+ * By default the table doubles inside the insert that crosses the load
+ * factor. For latency-sensitive callers, `x_hashtable_set_resize_mode(t,
+ * XHASHTABLE_RESIZE_INCREMENTAL)` keeps the old arrays alive after a
+ * growth and lets every set/get/has/remove migrate a few slots, so the
+ * cost of a rehash is spread over subsequent operations. When the final
+ * size is known, `x_hashtable_reserve()` sizes the table up front.
+ *
+ * ## Batch lookups
+ *
+ * `x_hashtable_get_many()` resolves an array of keys in one call. Keys are
+ * processed in blocks of `X_HASHTABLE_BATCH_SIZE`: all hashes of a block
+ * are computed and their home slots prefetched before any of them is
+ * probed, so the cache misses of independent lookups overlap instead of
+ * being paid one after the other.
+ *
+ * ## Flat hashtable
+ *
+ * `XFlatHashtable` is an alternative open-addressing table with a
+ * Swiss-table layout: keys and values are stored inline in one slot
+ * array, and a separate control byte per slot keeps 7 bits of the hash.
+ * Lookups scan 16 control bytes at once (SSE2/NEON when available) and
+ * compare keys only on fragment matches, which makes misses and long
+ * probe chains much cheaper than with `XHashtable`.
+ *
+ * It accepts the same key/value traits and callbacks, and has the same
+ * typed macros prefixed with `X_FLAT_`:
+ *
+ * ```
+ * X_FLAT_HASHTABLE_TYPE_CSTR_KEY_NAMED(int32_t, cstr_i32)
+ * XFlatHashtable_cstr_i32* ht = x_flat_hashtable_cstr_i32_create();
+ * x_flat_hashtable_cstr_i32_set(ht, "ONE", 1);
+ * ```
+ *
+ * Pointers returned by the flat iterator are invalidated by any insert.
+ *
  */
 
 #ifndef X_HASHTABLE_H
@@ -92,11 +131,16 @@
 #define X_HASHTABLE_VERSION_PATCH 0
 #define X_HASHTABLE_VERSION (X_HASHTABLE_VERSION_MAJOR * 10000 + X_HASHTABLE_VERSION_MINOR * 100 + X_HASHTABLE_VERSION_PATCH)
 
-#define X_HASHTABLE_INITIAL_CAPACITY 16
+#define X_HASHTABLE_INITIAL_CAPACITY 16 /* must be a power of two */
 #define X_HASHTABLE_LOAD_FACTOR 0.75
+#define X_HASHTABLE_MIGRATE_STEP 64    /* old slots migrated per operation during an incremental resize */
+#ifndef X_HASHTABLE_BATCH_SIZE
+#define X_HASHTABLE_BATCH_SIZE 16      /* keys hashed and prefetched together by x_hashtable_get_many() */
+#endif
 
 #include <stdx_common.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdbool.h>
 
 #ifndef X_HASHTABLE_API
@@ -112,6 +156,12 @@ extern "C" {
   typedef void    (*XHashFnClone)(void* dst, const void* src);
   typedef void    (*XHashFnDestroy)(void* ptr);
 
+  typedef enum
+  {
+    XHASHTABLE_RESIZE_BLOCKING    = 0,  /* rehash everything inside the insert that triggers growth */
+    XHASHTABLE_RESIZE_INCREMENTAL = 1,  /* spread the rehash over subsequent operations */
+  } XHashtableResizeMode;
+
   typedef struct
   {
     enum XEntryState
@@ -120,6 +170,7 @@ extern "C" {
       X_HASH_ENTRY_OCCUPIED,
       X_HASH_ENTRY_DELETED,
     } state;
+    size_t hash;        /* full key hash, valid while OCCUPIED */
   } XHashEntry;
 
   typedef struct
@@ -144,6 +195,16 @@ extern "C" {
     XHashFnDestroy    fn_key_free;
     XHashFnClone      fn_value_copy;
     XHashFnDestroy    fn_value_free;
+
+    /* incremental resize: previous arrays, drained by later operations */
+    XHashtableResizeMode resize_mode;
+    XHashEntry* old_entries;  /* NULL when no resize is in progress */
+    void* old_keys;
+    void* old_values;
+    size_t old_capacity;
+    size_t migrate_index;     /* next old slot to migrate */
+
+    XAllocator allocator;     /* alloc_fn == NULL means X_HASHTABLE_ALLOC/FREE */
   } XHashtable;
 
   typedef struct
@@ -192,6 +253,37 @@ extern "C" {
       XHashFnClone    fn_value_copy,
       XHashFnDestroy  fn_value_free);
 
+  /**
+   * @brief Same as x_hashtable_create_full(), with all memory taken from `allocator`.
+   * @param allocator Allocator for the table and its arrays, or NULL for X_HASHTABLE_ALLOC/FREE.
+   *        The struct is copied. Keys and values cloned by x_hashtable_clone_cstr() use it too.
+   * @return Pointer to a newly created hashtable, or NULL on failure.
+   */
+  X_HASHTABLE_API XHashtable* x_hashtable_create_full_with_allocator(
+      size_t          key_size,
+      size_t          value_size,
+      XHashFnHash     fn_key_hash,
+      XHashFnCompare  fn_key_compare,
+      XHashFnClone    fn_key_copy,
+      XHashFnDestroy  fn_key_free,
+      XHashFnClone    fn_value_copy,
+      XHashFnDestroy  fn_value_free,
+      const XAllocator* allocator);
+
+  /**
+   * @brief Same as x_hashtable_create_ex(), with all memory taken from `allocator`.
+   * @param allocator Allocator to use, or NULL for X_HASHTABLE_ALLOC/FREE. The struct is copied.
+   * @return Pointer to a newly created hashtable, or NULL on failure.
+   */
+  X_HASHTABLE_API XHashtable* x_hashtable_create_with_allocator(
+      size_t key_size,
+      bool key_null_terminated,
+      bool key_is_pointer,
+      size_t value_size,
+      bool value_null_terminated,
+      bool value_is_pointer,
+      const XAllocator* allocator);
+
   /**
    * @brief Insert or update a key/value pair in the hashtable.
    * @param table Hashtable instance.
@@ -224,6 +316,28 @@ extern "C" {
    */
   X_HASHTABLE_API size_t x_hashtable_count(const XHashtable* table);
 
+  /**
+   * @brief Grow the hashtable so it can hold a number of entries without resizing.
+   * The resize happens immediately, even in incremental mode.
+   * @param table Hashtable instance.
+   * @param count Number of entries the table should hold.
+   * @return True on success (or if already large enough), false on allocation failure.
+   */
+  X_HASHTABLE_API bool x_hashtable_reserve(XHashtable* table, size_t count);
+
+  /**
+   * @brief Select how the hashtable grows.
+   * In XHASHTABLE_RESIZE_INCREMENTAL mode the old and new arrays coexist
+   * after a growth, and every set/get/has/remove migrates up to
+   * X_HASHTABLE_MIGRATE_STEP old slots, so no single insert pays for the
+   * whole rehash. Switching back to blocking mode completes any pending
+   * migration.
+   * @param table Hashtable instance.
+   * @param mode Resize mode.
+   * @return Nothing.
+   */
+  X_HASHTABLE_API void x_hashtable_set_resize_mode(XHashtable* table, XHashtableResizeMode mode);
+
   /**
    * @brief Compare two NUL-terminated strings for equality.
    * @param a Pointer to the first string (const char*).
@@ -240,6 +354,19 @@ extern "C" {
    */
   X_HASHTABLE_API bool x_hashtable_has(XHashtable* table, const void* key);
 
+  /**
+   * @brief Look up many keys at once, overlapping the memory latency of the probes.
+   * Keys are read as a packed array of key_size elements; for pointer and C string
+   * keys every element is the pointer itself (e.g. a `const char*` array).
+   * @param table Hashtable instance.
+   * @param keys Packed array of n keys.
+   * @param n Number of keys.
+   * @param out_values Packed array of n value_size elements. Slots of missing keys are left untouched.
+   * @param out_found Optional array of n flags set to whether each key was found. May be NULL.
+   * @return Number of keys found.
+   */
+  X_HASHTABLE_API size_t x_hashtable_get_many(XHashtable* table, const void* keys, size_t n, void* out_values, bool* out_found);
+
   /**
    * @brief Remove an entry from the hashtable by key.
    * @param table Hashtable instance.
@@ -324,6 +451,10 @@ extern "C" {
   { \
     return (XHashtable_##suffix*)x_hashtable_create_ex(sizeof(tk), false, false, sizeof(tv), false, false); \
   } \
+  static inline XHashtable_##suffix* x_hashtable_##suffix##_create_with_allocator(const XAllocator* allocator) \
+  { \
+    return (XHashtable_##suffix*)x_hashtable_create_with_allocator(sizeof(tk), false, false, sizeof(tv), false, false, allocator); \
+  } \
   static inline bool x_hashtable_##suffix##_set(XHashtable_##suffix* table, tk key, tv value) \
   { \
     return x_hashtable_set((XHashtable*)table, &key, &value); \
@@ -332,6 +463,10 @@ extern "C" {
   { \
     return x_hashtable_get((XHashtable*)table, &key, out_value); \
   } \
+  static inline size_t x_hashtable_##suffix##_get_many(XHashtable_##suffix* table, tk const* keys, size_t n, tv* out_values, bool* out_found) \
+  { \
+    return x_hashtable_get_many((XHashtable*)table, keys, n, out_values, out_found); \
+  } \
   static inline bool x_hashtable_##suffix##_has(XHashtable_##suffix* table, tk key) \
   { \
     return x_hashtable_has((XHashtable*)table, &key); \
@@ -355,6 +490,10 @@ extern "C" {
   { \
     return (XHashtable_##suffix*)x_hashtable_create_ex(sizeof(tk), false, true, sizeof(tv), false, false); \
   } \
+  static inline XHashtable_##suffix* x_hashtable_##suffix##_create_with_allocator(const XAllocator* allocator) \
+  { \
+    return (XHashtable_##suffix*)x_hashtable_create_with_allocator(sizeof(tk), false, true, sizeof(tv), false, false, allocator); \
+  } \
   static inline bool x_hashtable_##suffix##_set(XHashtable_##suffix* table, tk key, tv value) \
   { \
     return x_hashtable_set((XHashtable*)table, key, &value); \
@@ -363,6 +502,10 @@ extern "C" {
   { \
     return x_hashtable_get((XHashtable*)table, key, out_value); \
   } \
+  static inline size_t x_hashtable_##suffix##_get_many(XHashtable_##suffix* table, tk const* keys, size_t n, tv* out_values, bool* out_found) \
+  { \
+    return x_hashtable_get_many((XHashtable*)table, keys, n, out_values, out_found); \
+  } \
   static inline bool x_hashtable_##suffix##_has(XHashtable_##suffix* table, tk key) \
   { \
     return x_hashtable_has((XHashtable*)table, key); \
@@ -386,6 +529,10 @@ extern "C" {
   { \
     return (XHashtable_##suffix*)x_hashtable_create_ex(sizeof(char*), true, true, sizeof(tv), false, false); \
   } \
+  static inline XHashtable_##suffix* x_hashtable_##suffix##_create_with_allocator(const XAllocator* allocator) \
+  { \
+    return (XHashtable_##suffix*)x_hashtable_create_with_allocator(sizeof(char*), true, true, sizeof(tv), false, false, allocator); \
+  } \
   static inline bool x_hashtable_##suffix##_set(XHashtable_##suffix* table, const char* key, tv value) \
   { \
     return x_hashtable_set((XHashtable*)table, key, &value); \
@@ -394,6 +541,10 @@ extern "C" {
   { \
     return x_hashtable_get((XHashtable*)table, key, out_value); \
   } \
+  static inline size_t x_hashtable_##suffix##_get_many(XHashtable_##suffix* table, const char* const* keys, size_t n, tv* out_values, bool* out_found) \
+  { \
+    return x_hashtable_get_many((XHashtable*)table, keys, n, out_values, out_found); \
+  } \
   static inline bool x_hashtable_##suffix##_has(XHashtable_##suffix* table, const char* key) \
   { \
     return x_hashtable_has((XHashtable*)table, key); \
@@ -417,6 +568,10 @@ extern "C" {
   { \
     return (XHashtable_##suffix*)x_hashtable_create_ex(sizeof(tk), false, false, sizeof(tv), false, true); \
   } \
+  static inline XHashtable_##suffix* x_hashtable_##suffix##_create_with_allocator(const XAllocator* allocator) \
+  { \
+    return (XHashtable_##suffix*)x_hashtable_create_with_allocator(sizeof(tk), false, false, sizeof(tv), false, true, allocator); \
+  } \
   static inline bool x_hashtable_##suffix##_set(XHashtable_##suffix* table, tk key, tv value) \
   { \
     return x_hashtable_set((XHashtable*)table, &key, value); \
@@ -425,6 +580,10 @@ extern "C" {
   { \
     return x_hashtable_get((XHashtable*)table, &key, out_value); \
   } \
+  static inline size_t x_hashtable_##suffix##_get_many(XHashtable_##suffix* table, tk const* keys, size_t n, tv* out_values, bool* out_found) \
+  { \
+    return x_hashtable_get_many((XHashtable*)table, keys, n, out_values, out_found); \
+  } \
   static inline bool x_hashtable_##suffix##_has(XHashtable_##suffix* table, tk key) \
   { \
     return x_hashtable_has((XHashtable*)table, &key); \
@@ -448,6 +607,10 @@ extern "C" {
   { \
     return (XHashtable_##suffix*)x_hashtable_create_ex(sizeof(tk), false, true, sizeof(tv), false, true); \
   } \
+  static inline XHashtable_##suffix* x_hashtable_##suffix##_create_with_allocator(const XAllocator* allocator) \
+  { \
+    return (XHashtable_##suffix*)x_hashtable_create_with_allocator(sizeof(tk), false, true, sizeof(tv), false, true, allocator); \
+  } \
   static inline bool x_hashtable_##suffix##_set(XHashtable_##suffix* table, tk key, tv value) \
   { \
     return x_hashtable_set((XHashtable*)table, key, value); \
@@ -456,6 +619,10 @@ extern "C" {
   { \
     return x_hashtable_get((XHashtable*)table, key, out_value); \
   } \
+  static inline size_t x_hashtable_##suffix##_get_many(XHashtable_##suffix* table, tk const* keys, size_t n, tv* out_values, bool* out_found) \
+  { \
+    return x_hashtable_get_many((XHashtable*)table, keys, n, out_values, out_found); \
+  } \
   static inline bool x_hashtable_##suffix##_has(XHashtable_##suffix* table, tk key) \
   { \
     return x_hashtable_has((XHashtable*)table, key); \
@@ -479,6 +646,10 @@ extern "C" {
   { \
     return (XHashtable_##suffix*)x_hashtable_create_ex(sizeof(char*), true, true, sizeof(tv), false, true); \
   } \
+  static inline XHashtable_##suffix* x_hashtable_##suffix##_create_with_allocator(const XAllocator* allocator) \
+  { \
+    return (XHashtable_##suffix*)x_hashtable_create_with_allocator(sizeof(char*), true, true, sizeof(tv), false, true, allocator); \
+  } \
   static inline bool x_hashtable_##suffix##_set(XHashtable_##suffix* table, const char* key, tv value) \
   { \
     return x_hashtable_set((XHashtable*)table, key, value); \
@@ -487,6 +658,10 @@ extern "C" {
   { \
     return x_hashtable_get((XHashtable*)table, key, out_value); \
   } \
+  static inline size_t x_hashtable_##suffix##_get_many(XHashtable_##suffix* table, const char* const* keys, size_t n, tv* out_values, bool* out_found) \
+  { \
+    return x_hashtable_get_many((XHashtable*)table, keys, n, out_values, out_found); \
+  } \
   static inline bool x_hashtable_##suffix##_has(XHashtable_##suffix* table, const char* key) \
   { \
     return x_hashtable_has((XHashtable*)table, key); \
@@ -504,6 +679,201 @@ extern "C" {
     return x_hashtable_count((const XHashtable*)table); \
   }
 
+
+  /*
+   * Flat hashtable (Swiss-table layout)
+   *
+   * Keys and values live inline in a single slot array. A parallel array
+   * of one control byte per slot holds either EMPTY, DELETED or the low 7
+   * bits of the key hash. Lookups compare X_FLAT_HASHTABLE_GROUP_WIDTH
+   * control bytes at once (SSE2 on x86, NEON on AArch64, portable loop
+   * elsewhere) and only touch slots whose hash fragment matches.
+   */
+
+#define X_FLAT_HASHTABLE_GROUP_WIDTH 16
+
+  typedef struct
+  {
+    size_t key_size;
+    size_t value_size;
+    size_t value_offset;    /* offset of the value inside a slot */
+    size_t slot_size;       /* key + value, padded for alignment */
+    size_t count;
+    size_t capacity;        /* power of two, multiple of X_FLAT_HASHTABLE_GROUP_WIDTH */
+    size_t growth_left;     /* inserts into EMPTY slots allowed before rehashing */
+    uint8_t* ctrl;          /* capacity control bytes */
+    void* slots;            /* capacity * slot_size bytes */
+
+    bool key_is_pointer;
+    bool value_is_pointer;
+    bool key_is_null_terminated;
+    bool value_is_null_terminated;
+
+    /* callbacks */
+    XHashFnHash       fn_key_hash;
+    XHashFnCompare    fn_key_compare;
+    XHashFnClone      fn_key_copy;
+    XHashFnDestroy    fn_key_free;
+    XHashFnClone      fn_value_copy;
+    XHashFnDestroy    fn_value_free;
+  } XFlatHashtable;
+
+  typedef struct
+  {
+    XFlatHashtable* table;
+    size_t index;      /* current occupied slot, or table->capacity when finished */
+  } XFlatHashtableIter;
+
+  /**
+   * @brief Create a flat hashtable using raw size and explicit string/pointer traits.
+   * Key and value traits have the same meaning as in x_hashtable_create_ex().
+   * @param key_size Size in bytes of the key type.
+   * @param key_null_terminated True if the key is a NUL-terminated string (C string).
+   * @param key_is_pointer True if the key is stored as a pointer value.
+   * @param value_size Size in bytes of the value type.
+   * @param value_null_terminated True if the value is a NUL-terminated string (C string).
+   * @param value_is_pointer True if the value is stored as a pointer value.
+   * @return Pointer to a newly created flat hashtable, or NULL on failure.
+   */
+  X_HASHTABLE_API XFlatHashtable* x_flat_hashtable_create_ex(
+      size_t key_size,
+      bool key_null_terminated,
+      bool key_is_pointer,
+      size_t value_size,
+      bool value_null_terminated,
+      bool value_is_pointer);
+
+  /**
+   * @brief Create a fully-configurable flat hashtable.
+   * Callbacks follow the same contract as x_hashtable_create_full().
+   * @return Pointer to a newly created flat hashtable, or NULL on failure.
+   */
+  X_HASHTABLE_API XFlatHashtable* x_flat_hashtable_create_full(
+      size_t          key_size,
+      size_t          value_size,
+      XHashFnHash     fn_key_hash,
+      XHashFnCompare  fn_key_compare,
+      XHashFnClone    fn_key_copy,
+      XHashFnDestroy  fn_key_free,
+      XHashFnClone    fn_value_copy,
+      XHashFnDestroy  fn_value_free);
+
+  /**
+   * @brief Insert or update a key/value pair in the flat hashtable.
+   * @param table Flat hashtable instance.
+   * @param key Pointer to the key data.
+   * @param value Pointer to the value data.
+   * @return True on success, false on failure (e.g., allocation failure).
+   */
+  X_HASHTABLE_API bool x_flat_hashtable_set(XFlatHashtable* table, const void* key, const void* value);
+
+  /**
+   * @brief Retrieve a value from the flat hashtable by key.
+   * @param table Flat hashtable instance.
+   * @param key Pointer to the key data.
+   * @param out_value Output buffer to receive the value.
+   * @return True if the key was found and out_value was written, false otherwise.
+   */
+  X_HASHTABLE_API bool x_flat_hashtable_get(XFlatHashtable* table, const void* key, void* out_value);
+
+  /**
+   * @brief Check whether the flat hashtable contains a key.
+   * @param table Flat hashtable instance.
+   * @param key Pointer to the key data.
+   * @return True if the key exists, false otherwise.
+   */
+  X_HASHTABLE_API bool x_flat_hashtable_has(XFlatHashtable* table, const void* key);
+
+  /**
+   * @brief Remove an entry from the flat hashtable by key.
+   * @param table Flat hashtable instance.
+   * @param key Pointer to the key data.
+   * @return True if an entry was removed, false if the key was not found.
+   */
+  X_HASHTABLE_API bool x_flat_hashtable_remove(XFlatHashtable* table, const void* key);
+
+  /**
+   * @brief Destroy a flat hashtable and free all associated resources.
+   * @param table Flat hashtable instance to destroy.
+   * @return Nothing.
+   */
+  X_HASHTABLE_API void x_flat_hashtable_destroy(XFlatHashtable* table);
+
+  /**
+   * @brief Get the number of stored entries in the flat hashtable.
+   * @param table Flat hashtable instance.
+   * @return Number of key/value pairs currently stored.
+   */
+  X_HASHTABLE_API size_t x_flat_hashtable_count(const XFlatHashtable* table);
+
+  /**
+   * @brief Initialize an iterator for a flat hashtable.
+   * @param table Flat hashtable instance.
+   * @param it Iterator to initialize.
+   * @return True if the iterator was initialized (even if empty table), false on invalid args.
+   */
+  X_HASHTABLE_API bool x_flat_hashtable_iter_begin(XFlatHashtable* table, XFlatHashtableIter* it);
+
+  /**
+   * @brief Advance iterator to the next occupied entry.
+   * @param it Iterator.
+   * @param out_key Receives pointer to key (user-facing: dereferenced if stored as pointer/string).
+   * @param out_value Receives pointer to value (user-facing: dereferenced if stored as pointer/string).
+   * @return True if an entry was produced, false if iteration finished or invalid args.
+   */
+  X_HASHTABLE_API bool x_flat_hashtable_iter_next(XFlatHashtableIter* it, void** out_key, void** out_value);
+
+#define X_FLAT_HASHTABLE__WRAPPERS(tk, tv, suffix, key_ptr, key_term, value_ptr, value_term, key_arg, value_arg) \
+  typedef XFlatHashtable XFlatHashtable_##suffix; \
+  static inline XFlatHashtable_##suffix* x_flat_hashtable_##suffix##_create(void) \
+  { \
+    return (XFlatHashtable_##suffix*)x_flat_hashtable_create_ex(sizeof(tk), key_term, key_ptr, sizeof(tv), value_term, value_ptr); \
+  } \
+  static inline bool x_flat_hashtable_##suffix##_set(XFlatHashtable_##suffix* table, tk key, tv value) \
+  { \
+    return x_flat_hashtable_set((XFlatHashtable*)table, key_arg, value_arg); \
+  } \
+  static inline bool x_flat_hashtable_##suffix##_get(XFlatHashtable_##suffix* table, tk key, tv* out_value) \
+  { \
+    return x_flat_hashtable_get((XFlatHashtable*)table, key_arg, out_value); \
+  } \
+  static inline bool x_flat_hashtable_##suffix##_has(XFlatHashtable_##suffix* table, tk key) \
+  { \
+    return x_flat_hashtable_has((XFlatHashtable*)table, key_arg); \
+  } \
+  static inline bool x_flat_hashtable_##suffix##_remove(XFlatHashtable_##suffix* table, tk key) \
+  { \
+    return x_flat_hashtable_remove((XFlatHashtable*)table, key_arg); \
+  } \
+  static inline void x_flat_hashtable_##suffix##_destroy(XFlatHashtable_##suffix* table) \
+  { \
+    x_flat_hashtable_destroy((XFlatHashtable*)table); \
+  } \
+  static inline size_t x_flat_hashtable_##suffix##_count(const XFlatHashtable_##suffix* table) \
+  { \
+    return x_flat_hashtable_count((const XFlatHashtable*)table); \
+  }
+
+#define X_FLAT_HASHTABLE_TYPE(tk, tv) X_FLAT_HASHTABLE_TYPE_NAMED(tk, tv, tk##_##tv)
+
+#define X_FLAT_HASHTABLE_TYPE_NAMED(tk, tv, suffix) \
+  X_FLAT_HASHTABLE__WRAPPERS(tk, tv, suffix, false, false, false, false, &key, &value)
+
+#define X_FLAT_HASHTABLE_TYPE_PTR_KEY_NAMED(tk, tv, suffix) \
+  X_FLAT_HASHTABLE__WRAPPERS(tk, tv, suffix, true, false, false, false, key, &value)
+
+#define X_FLAT_HASHTABLE_TYPE_CSTR_KEY_NAMED(tv, suffix) \
+  X_FLAT_HASHTABLE__WRAPPERS(const char*, tv, suffix, true, true, false, false, key, &value)
+
+#define X_FLAT_HASHTABLE_TYPE_PTR_VALUE_NAMED(tk, tv, suffix) \
+  X_FLAT_HASHTABLE__WRAPPERS(tk, tv, suffix, false, false, true, false, &key, value)
+
+#define X_FLAT_HASHTABLE_TYPE_PTR_KEY_PTR_VALUE_NAMED(tk, tv, suffix) \
+  X_FLAT_HASHTABLE__WRAPPERS(tk, tv, suffix, true, false, true, false, key, value)
+
+#define X_FLAT_HASHTABLE_TYPE_CSTR_KEY_PTR_VALUE_NAMED(tv, suffix) \
+  X_FLAT_HASHTABLE__WRAPPERS(const char*, tv, suffix, true, true, true, false, key, value)
+
 #ifdef __cplusplus
 }
 #endif
@@ -547,6 +917,15 @@ extern "C" {
 #define X_HASHTABLE_FREE(p)          free(p)
 #endif
 
+#if defined(__GNUC__) || defined(__clang__)
+#define X_HASHTABLE_PREFETCH(p)      __builtin_prefetch((p), 0, 3)
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define X_HASHTABLE_PREFETCH(p)      _mm_prefetch((const char*)(p), _MM_HINT_T0)
+#else
+#define X_HASHTABLE_PREFETCH(p)      ((void)(p))
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -561,82 +940,333 @@ extern "C" {
     return (char*)t->values + i * t->value_size;
   }
 
-  X_HASHTABLE_API size_t x_hashtable_hash_bytes(const void* key, size_t size)
-  {
-    const unsigned char* data = (const unsigned char*)key;
-    size_t hash = 5381;
-    size_t i;
-    for (i = 0; i < size; i++)
-    {
-      hash = ((hash << 5) + hash) + data[i];
-    }
-    return hash;
-  }
+  /*
+   * Byte hashing
+   *
+   * The default hash is a wyhash-style function: it consumes 16 bytes per
+   * round, folding each pair of 64-bit words with a 64x64->128 multiply.
+   * When the compiler targets SSE4.2 or ARMv8 CRC32, a CRC32-C based hash
+   * is used instead, with two independent lanes and a multiplicative
+   * finalizer. Define X_HASHTABLE_NO_CRC32 to always use the portable path.
+   */
 
-  X_HASHTABLE_API size_t x_hashtable_hash_cstr(const void* key, size_t _)
-  {
-    const char* str;
-    size_t len;
+#if !defined(X_HASHTABLE_NO_CRC32)
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#define X_HASHTABLE_CRC32 1
+#define s_hash_crc32_u64(crc, v) ((uint32_t)_mm_crc32_u64((crc), (v)))
+#define s_hash_crc32_u32(crc, v) _mm_crc32_u32((crc), (v))
+#define s_hash_crc32_u8(crc, v)  _mm_crc32_u8((crc), (v))
+#elif defined(__ARM_FEATURE_CRC32) && defined(__aarch64__)
+#include <arm_acle.h>
+#define X_HASHTABLE_CRC32 1
+#define s_hash_crc32_u64(crc, v) __crc32cd((crc), (v))
+#define s_hash_crc32_u32(crc, v) __crc32cw((crc), (v))
+#define s_hash_crc32_u8(crc, v)  __crc32cb((crc), (v))
+#endif
+#endif
 
-    X_UNUSED(_);
-    str = (const char*)key;
-    len = strlen(str);
-    return x_hashtable_hash_bytes(str, len);
-  }
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
 
-  X_HASHTABLE_API bool x_hashtable_compare_cstr(const void* a, const void* b)
+#define X_HASH_SECRET0 0xa0761d6478bd642full
+#define X_HASH_SECRET1 0xe7037ed1a0b428dbull
+#define X_HASH_SECRET2 0x8ebc6af09c88c6e3ull
+#define X_HASH_SECRET3 0x589965cc75374cc3ull
+
+  static inline uint64_t s_hash_read64(const uint8_t* p)
   {
-    const char* str_a = *(const char**)a;
-    const char* str_b = *(const char**)b;
-    return strcmp(str_a, str_b) == 0;
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
   }
 
-  X_HASHTABLE_API void x_hashtable_free_cstr(void* a)
+  static inline uint64_t s_hash_read32(const uint8_t* p)
   {
-    X_HASHTABLE_FREE(*(char**)a);
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
   }
 
-  X_HASHTABLE_API void x_hashtable_clone_cstr(void* dest, const void* src)
+  /* 64x64->128 multiply, returns both halves in *a (low) and *b (high) */
+  static inline void s_hash_mum(uint64_t* a, uint64_t* b)
   {
-    char* mem =  
-#if defined(_MSC_VER)
-      _strdup((const char*) src);
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 XHashU128;
+    XHashU128 r = (XHashU128)*a * *b;
+    *a = (uint64_t)r;
+    *b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
 #else
-    strdup((const char*) src);
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t)*a, lb = (uint32_t)*b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32);
+    uint64_t c = t < rl;
+    uint64_t lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
 #endif
-    *(char**)dest = mem;
   }
 
-  X_HASHTABLE_API static bool x_hashtable_resize(XHashtable* table, size_t new_capacity);
+  static inline uint64_t s_hash_mix(uint64_t a, uint64_t b)
+  {
+    s_hash_mum(&a, &b);
+    return a ^ b;
+  }
 
-  X_HASHTABLE_API XHashtable* x_hashtable_create_ex(size_t key_size, bool key_null_terminated, bool key_is_pointer,
-      size_t value_size, bool value_null_terminated, bool value_is_pointer)
+#if defined(X_HASHTABLE_CRC32)
+  static inline uint64_t s_hash_bytes_crc32(const uint8_t* p, size_t len)
   {
-    XHashtable* ht = x_hashtable_create_full(
-        key_size,
-        value_size,
-        key_null_terminated   ? x_hashtable_hash_cstr     : x_hashtable_hash_bytes,
-        key_null_terminated   ? x_hashtable_compare_cstr  : NULL,
-        key_null_terminated   ? x_hashtable_clone_cstr    : NULL,
-        key_null_terminated   ? x_hashtable_free_cstr     : NULL,
-        value_null_terminated ? x_hashtable_clone_cstr    : NULL,
-        value_null_terminated ? x_hashtable_free_cstr     : NULL);
+    uint32_t c0 = 0x243f6a88u;
+    uint32_t c1 = 0x85a308d3u;
+    size_t i = len;
 
-    if (!ht)
+    while (i >= 16)
     {
-      return NULL;
+      c0 = s_hash_crc32_u64(c0, s_hash_read64(p));
+      c1 = s_hash_crc32_u64(c1, s_hash_read64(p + 8));
+      p += 16;
+      i -= 16;
     }
 
-    ht->key_is_pointer = key_is_pointer;
-    ht->key_is_null_terminated = key_null_terminated;
-    ht->value_is_pointer = value_is_pointer;
-    ht->value_is_null_terminated = value_null_terminated;
-    return ht;
-  }
+    if (i >= 8)
+    {
+      c0 = s_hash_crc32_u64(c0, s_hash_read64(p));
+      p += 8;
+      i -= 8;
+    }
 
-  XHashtable* x_hashtable_create_full(
-      size_t          key_size,
-      size_t          value_size,
+    if (i >= 4)
+    {
+      /* 4..7 bytes left: two overlapping 32-bit reads cover them */
+      c1 = s_hash_crc32_u32(c1, (uint32_t)s_hash_read32(p));
+      c0 = s_hash_crc32_u32(c0, (uint32_t)s_hash_read32(p + i - 4));
+    }
+    else
+    {
+      while (i--)
+      {
+        c1 = s_hash_crc32_u8(c1, *p++);
+      }
+    }
+
+    return s_hash_mix(((uint64_t)c0 << 32 | c1) ^ X_HASH_SECRET1, (uint64_t)len ^ X_HASH_SECRET0);
+  }
+#endif
+
+  static inline uint64_t s_hash_bytes_wy(const uint8_t* p, size_t len)
+  {
+    uint64_t seed = s_hash_mix(X_HASH_SECRET0, X_HASH_SECRET1);
+    uint64_t a;
+    uint64_t b;
+
+    if (len <= 16)
+    {
+      if (len >= 4)
+      {
+        size_t off = (len >> 3) << 2;
+        a = (s_hash_read32(p) << 32) | s_hash_read32(p + off);
+        b = (s_hash_read32(p + len - 4) << 32) | s_hash_read32(p + len - 4 - off);
+      }
+      else if (len > 0)
+      {
+        a = ((uint64_t)p[0] << 16) | ((uint64_t)p[len >> 1] << 8) | p[len - 1];
+        b = 0;
+      }
+      else
+      {
+        a = b = 0;
+      }
+    }
+    else
+    {
+      size_t i = len;
+
+      if (i > 48)
+      {
+        uint64_t see1 = seed;
+        uint64_t see2 = seed;
+        do
+        {
+          seed = s_hash_mix(s_hash_read64(p) ^ X_HASH_SECRET1, s_hash_read64(p + 8) ^ seed);
+          see1 = s_hash_mix(s_hash_read64(p + 16) ^ X_HASH_SECRET2, s_hash_read64(p + 24) ^ see1);
+          see2 = s_hash_mix(s_hash_read64(p + 32) ^ X_HASH_SECRET3, s_hash_read64(p + 40) ^ see2);
+          p += 48;
+          i -= 48;
+        } while (i > 48);
+        seed ^= see1 ^ see2;
+      }
+
+      while (i > 16)
+      {
+        seed = s_hash_mix(s_hash_read64(p) ^ X_HASH_SECRET1, s_hash_read64(p + 8) ^ seed);
+        i -= 16;
+        p += 16;
+      }
+
+      /* The last 16 bytes may overlap with bytes already consumed */
+      a = s_hash_read64(p + i - 16);
+      b = s_hash_read64(p + i - 8);
+    }
+
+    a ^= X_HASH_SECRET1;
+    b ^= seed;
+    s_hash_mum(&a, &b);
+    return s_hash_mix(a ^ X_HASH_SECRET0 ^ (uint64_t)len, b ^ X_HASH_SECRET1);
+  }
+
+  X_HASHTABLE_API size_t x_hashtable_hash_bytes(const void* key, size_t size)
+  {
+#if defined(X_HASHTABLE_CRC32)
+    return (size_t)s_hash_bytes_crc32((const uint8_t*)key, size);
+#else
+    return (size_t)s_hash_bytes_wy((const uint8_t*)key, size);
+#endif
+  }
+
+  X_HASHTABLE_API size_t x_hashtable_hash_cstr(const void* key, size_t _)
+  {
+    const char* str;
+    size_t len;
+
+    X_UNUSED(_);
+    str = (const char*)key;
+    len = strlen(str);
+    return x_hashtable_hash_bytes(str, len);
+  }
+
+  X_HASHTABLE_API bool x_hashtable_compare_cstr(const void* a, const void* b)
+  {
+    const char* str_a = *(const char**)a;
+    const char* str_b = *(const char**)b;
+    return strcmp(str_a, str_b) == 0;
+  }
+
+  X_HASHTABLE_API void x_hashtable_free_cstr(void* a)
+  {
+    X_HASHTABLE_FREE(*(char**)a);
+  }
+
+  X_HASHTABLE_API void x_hashtable_clone_cstr(void* dest, const void* src)
+  {
+    char* mem =  
+#if defined(_MSC_VER)
+      _strdup((const char*) src);
+#else
+    strdup((const char*) src);
+#endif
+    *(char**)dest = mem;
+  }
+
+  X_HASHTABLE_API static bool x_hashtable_resize(XHashtable* table, size_t new_capacity);
+
+  X_HASHTABLE_API static void* s_hashtable_mem_alloc(const XAllocator* a, size_t size)
+  {
+    if (a && a->alloc_fn)
+      return a->alloc_fn(a->user, size);
+    return X_HASHTABLE_ALLOC(size);
+  }
+
+  X_HASHTABLE_API static void* s_hashtable_mem_calloc(const XAllocator* a, size_t n, size_t size)
+  {
+    void* p;
+    if (!a || !a->alloc_fn)
+      return X_HASHTABLE_CALLOC(n, size);
+    p = a->alloc_fn(a->user, n * size);
+    if (p)
+      memset(p, 0, n * size);
+    return p;
+  }
+
+  X_HASHTABLE_API static void s_hashtable_mem_free(const XAllocator* a, void* p, size_t size)
+  {
+    if (!p)
+      return;
+    if (a && a->alloc_fn)
+    {
+      if (a->free_fn)
+        a->free_fn(a->user, p, size);
+      return;
+    }
+    X_HASHTABLE_FREE(p);
+  }
+
+  X_HASHTABLE_API static void s_hashtable_free_arrays(XHashtable* table, XHashEntry* entries, void* keys, void* values, size_t capacity)
+  {
+    s_hashtable_mem_free(&table->allocator, entries, capacity * sizeof(XHashEntry));
+    s_hashtable_mem_free(&table->allocator, keys, capacity * table->key_size);
+    s_hashtable_mem_free(&table->allocator, values, capacity * table->value_size);
+  }
+
+  /*
+   * Runs a clone callback. The built-in C string clone goes through the
+   * table allocator so owned strings live in the same memory as the table.
+   */
+  X_HASHTABLE_API static void s_hashtable_copy(XHashtable* table, XHashFnClone fn, void* dst, const void* src)
+  {
+    if (fn == x_hashtable_clone_cstr && table->allocator.alloc_fn)
+    {
+      size_t len = strlen((const char*)src) + 1;
+      char* mem = (char*)s_hashtable_mem_alloc(&table->allocator, len);
+      if (mem)
+        memcpy(mem, src, len);
+      *(char**)dst = mem;
+      return;
+    }
+    fn(dst, src);
+  }
+
+  X_HASHTABLE_API static void s_hashtable_destroy_item(XHashtable* table, XHashFnDestroy fn, void* ptr)
+  {
+    if (fn == x_hashtable_free_cstr && table->allocator.alloc_fn)
+    {
+      char* str = *(char**)ptr;
+      if (str)
+        s_hashtable_mem_free(&table->allocator, str, strlen(str) + 1);
+      return;
+    }
+    fn(ptr);
+  }
+
+  X_HASHTABLE_API XHashtable* x_hashtable_create_ex(size_t key_size, bool key_null_terminated, bool key_is_pointer,
+      size_t value_size, bool value_null_terminated, bool value_is_pointer)
+  {
+    return x_hashtable_create_with_allocator(key_size, key_null_terminated, key_is_pointer,
+        value_size, value_null_terminated, value_is_pointer, NULL);
+  }
+
+  X_HASHTABLE_API XHashtable* x_hashtable_create_with_allocator(size_t key_size, bool key_null_terminated, bool key_is_pointer,
+      size_t value_size, bool value_null_terminated, bool value_is_pointer, const XAllocator* allocator)
+  {
+    XHashtable* ht = x_hashtable_create_full_with_allocator(
+        key_size,
+        value_size,
+        key_null_terminated   ? x_hashtable_hash_cstr     : x_hashtable_hash_bytes,
+        key_null_terminated   ? x_hashtable_compare_cstr  : NULL,
+        key_null_terminated   ? x_hashtable_clone_cstr    : NULL,
+        key_null_terminated   ? x_hashtable_free_cstr     : NULL,
+        value_null_terminated ? x_hashtable_clone_cstr    : NULL,
+        value_null_terminated ? x_hashtable_free_cstr     : NULL,
+        allocator);
+
+    if (!ht)
+    {
+      return NULL;
+    }
+
+    ht->key_is_pointer = key_is_pointer;
+    ht->key_is_null_terminated = key_null_terminated;
+    ht->value_is_pointer = value_is_pointer;
+    ht->value_is_null_terminated = value_null_terminated;
+    return ht;
+  }
+
+  XHashtable* x_hashtable_create_full(
+      size_t          key_size,
+      size_t          value_size,
       XHashFnHash     fn_key_hash,
       XHashFnCompare  fn_key_compare,
       XHashFnClone    fn_key_copy,
@@ -645,7 +1275,23 @@ extern "C" {
       XHashFnDestroy  fn_value_free
       )
   {
-    XHashtable* table = (XHashtable*)X_HASHTABLE_ALLOC(sizeof(XHashtable));
+    return x_hashtable_create_full_with_allocator(key_size, value_size, fn_key_hash, fn_key_compare,
+        fn_key_copy, fn_key_free, fn_value_copy, fn_value_free, NULL);
+  }
+
+  X_HASHTABLE_API XHashtable* x_hashtable_create_full_with_allocator(
+      size_t          key_size,
+      size_t          value_size,
+      XHashFnHash     fn_key_hash,
+      XHashFnCompare  fn_key_compare,
+      XHashFnClone    fn_key_copy,
+      XHashFnDestroy  fn_key_free,
+      XHashFnClone    fn_value_copy,
+      XHashFnDestroy  fn_value_free,
+      const XAllocator* allocator
+      )
+  {
+    XHashtable* table = (XHashtable*)s_hashtable_mem_alloc(allocator, sizeof(XHashtable));
     size_t capacity = X_HASHTABLE_INITIAL_CAPACITY;
 
     if (!table)
@@ -653,21 +1299,25 @@ extern "C" {
       return NULL;
     }
 
-    table->entries = (XHashEntry*)X_HASHTABLE_CALLOC(capacity, sizeof(XHashEntry));
-    table->keys = X_HASHTABLE_ALLOC(key_size * capacity);
-    table->values = X_HASHTABLE_ALLOC(value_size * capacity);
+    memset(&table->allocator, 0, sizeof(table->allocator));
+    if (allocator)
+    {
+      table->allocator = *allocator;
+    }
+    table->key_size = key_size;
+    table->value_size = value_size;
+
+    table->entries = (XHashEntry*)s_hashtable_mem_calloc(allocator, capacity, sizeof(XHashEntry));
+    table->keys = s_hashtable_mem_alloc(allocator, key_size * capacity);
+    table->values = s_hashtable_mem_alloc(allocator, value_size * capacity);
 
     if (!table->entries || !table->keys || !table->values)
     {
-      X_HASHTABLE_FREE(table->entries);
-      X_HASHTABLE_FREE(table->keys);
-      X_HASHTABLE_FREE(table->values);
-      X_HASHTABLE_FREE(table);
+      s_hashtable_free_arrays(table, table->entries, table->keys, table->values, capacity);
+      s_hashtable_mem_free(allocator, table, sizeof(XHashtable));
       return NULL;
     }
 
-    table->key_size = key_size;
-    table->value_size = value_size;
     table->count = 0;
     table->capacity = capacity;
     table->key_is_pointer = false;
@@ -682,20 +1332,30 @@ extern "C" {
     table->fn_value_copy = fn_value_copy;
     table->fn_value_free = fn_value_free;
 
+    table->resize_mode = XHASHTABLE_RESIZE_BLOCKING;
+    table->old_entries = NULL;
+    table->old_keys = NULL;
+    table->old_values = NULL;
+    table->old_capacity = 0;
+    table->migrate_index = 0;
+
     return table;
   }
 
-  X_HASHTABLE_API static size_t probe_index(XHashtable* table, const void* key, size_t *out_index_found, bool *found)
+  /*
+   * Linear probe for key. Stored hashes are compared first so the key
+   * compare callback only runs for real candidates.
+   */
+  X_HASHTABLE_API static size_t probe_index(XHashtable* table, const void* key, size_t hash, size_t *out_index_found, bool *found)
   {
-    size_t capacity = table->capacity;
-    size_t hash = table->fn_key_hash(key, table->key_size);
-    size_t index = hash % capacity;
+    size_t mask = table->capacity - 1;
+    size_t index = hash & mask;
     size_t first_deleted = (size_t)-1;
     size_t i;
 
-    for (i = 0; i < capacity; i++)
+    for (i = 0; i <= mask; i++)
     {
-      size_t idx = (index + i) % capacity;
+      size_t idx = (index + i) & mask;
       XHashEntry* entry = &table->entries[idx];
 
       if (entry->state == X_HASH_ENTRY_FREE)
@@ -719,7 +1379,7 @@ extern "C" {
           first_deleted = idx;
         }
       }
-      else if (entry->state == X_HASH_ENTRY_OCCUPIED)
+      else if (entry->hash == hash)
       {
         void* key_at_idx = key_at(table, idx);
         bool keys_match = table->fn_key_compare ?
@@ -735,14 +1395,107 @@ extern "C" {
       }
     }
 
-    *out_index_found = (size_t)-1;
+    /* No FREE slot left: reuse a tombstone if there is one */
+    *out_index_found = first_deleted;
     *found = false;
-    return (size_t)-1;
+    return first_deleted;
+  }
+
+  /* Hashes a user-facing key (raw pointer keys are hashed by address) and probes for it */
+  X_HASHTABLE_API static inline size_t probe_key(XHashtable* table, const void* key, size_t* out_hash, size_t* out_index_found, bool* found)
+  {
+    const void* k = (table->key_is_pointer && !table->key_is_null_terminated) ? (const void*)&key : key;
+    *out_hash = table->fn_key_hash(k, table->key_size);
+    return probe_index(table, k, *out_hash, out_index_found, found);
+  }
+
+  /* A copy of the table header that points at the arrays still being drained by an incremental resize */
+  X_HASHTABLE_API static inline void s_hashtable_old_view(const XHashtable* table, XHashtable* view)
+  {
+    *view = *table;
+    view->entries = table->old_entries;
+    view->keys = table->old_keys;
+    view->values = table->old_values;
+    view->capacity = table->old_capacity;
+    view->old_entries = NULL;
+  }
+
+  /* Probes the old arrays of an in-progress incremental resize */
+  X_HASHTABLE_API static inline bool s_hashtable_probe_old(XHashtable* table, const void* key, size_t hash, size_t* out_index)
+  {
+    XHashtable view;
+    bool found = false;
+    const void* k = (table->key_is_pointer && !table->key_is_null_terminated) ? (const void*)&key : key;
+
+    s_hashtable_old_view(table, &view);
+    probe_index(&view, k, hash, out_index, &found);
+    return found;
+  }
+
+  /*
+   * Places an entry taken from other storage into the current arrays,
+   * without rehashing or cloning. The key must not be present already.
+   */
+  X_HASHTABLE_API static void s_hashtable_place(XHashtable* table, const XHashEntry* entry, const void* key_src, const void* value_src)
+  {
+    size_t mask = table->capacity - 1;
+    size_t idx = entry->hash & mask;
+
+    while (table->entries[idx].state == X_HASH_ENTRY_OCCUPIED)
+    {
+      idx = (idx + 1) & mask;
+    }
+
+    table->entries[idx] = *entry;
+    memcpy(key_at(table, idx), key_src, table->key_size);
+    memcpy(value_at(table, idx), value_src, table->value_size);
+  }
+
+  /* Moves one old slot into the current arrays and leaves a tombstone behind */
+  X_HASHTABLE_API static void s_hashtable_migrate_slot(XHashtable* table, size_t i)
+  {
+    XHashEntry* old = &table->old_entries[i];
+
+    if (old->state == X_HASH_ENTRY_OCCUPIED)
+    {
+      s_hashtable_place(table, old,
+          (char*)table->old_keys + i * table->key_size,
+          (char*)table->old_values + i * table->value_size);
+      old->state = X_HASH_ENTRY_DELETED;
+    }
+  }
+
+  /* Advances an in-progress incremental resize by up to `steps` old slots */
+  X_HASHTABLE_API static void s_hashtable_migrate(XHashtable* table, size_t steps)
+  {
+    while (table->old_entries && steps--)
+    {
+      s_hashtable_migrate_slot(table, table->migrate_index++);
+
+      if (table->migrate_index >= table->old_capacity)
+      {
+        s_hashtable_free_arrays(table, table->old_entries, table->old_keys, table->old_values, table->old_capacity);
+        table->old_entries = NULL;
+        table->old_keys = NULL;
+        table->old_values = NULL;
+        table->old_capacity = 0;
+        table->migrate_index = 0;
+      }
+    }
+  }
+
+  X_HASHTABLE_API static inline void s_hashtable_finish_migration(XHashtable* table)
+  {
+    if (table->old_entries)
+    {
+      s_hashtable_migrate(table, table->old_capacity);
+    }
   }
 
   X_HASHTABLE_API bool x_hashtable_set(XHashtable* table, const void* key, const void* value)
   {
     size_t idx;
+    size_t hash;
     bool found;
     XHashEntry* entry;
 
@@ -751,22 +1504,35 @@ extern "C" {
       return false;
     }
 
+    s_hashtable_migrate(table, X_HASHTABLE_MIGRATE_STEP);
+
     if ((double)(table->count + 1) / table->capacity > X_HASHTABLE_LOAD_FACTOR)
     {
+      /* Growing again while draining would stack resizes; finish the current one first */
+      s_hashtable_finish_migration(table);
       if (!x_hashtable_resize(table, table->capacity * 2))
       {
         return false;
       }
     }
 
-    probe_index(table,
-        (table->key_is_pointer && !table->key_is_null_terminated) ? &key : key,
-        &idx, &found);
+    probe_key(table, key, &hash, &idx, &found);
     if (idx == (size_t)-1)
     {
       return false;
     }
 
+    if (!found && table->old_entries)
+    {
+      /* The key may not have been migrated yet: move it now and update it in place */
+      size_t old_idx;
+      if (s_hashtable_probe_old(table, key, hash, &old_idx))
+      {
+        s_hashtable_migrate_slot(table, old_idx);
+        probe_key(table, key, &hash, &idx, &found);
+      }
+    }
+
     entry = &table->entries[idx];
 
     if (found)
@@ -774,11 +1540,11 @@ extern "C" {
       void* value_ptr = value_at(table, idx);
       if (table->fn_value_free)
       {
-        table->fn_value_free(value_ptr);
+        s_hashtable_destroy_item(table, table->fn_value_free, value_ptr);
       }
       if (table->fn_value_copy)
       {
-        table->fn_value_copy(value_ptr, value);
+        s_hashtable_copy(table, table->fn_value_copy, value_ptr, value);
       }
       else
       {
@@ -791,7 +1557,7 @@ extern "C" {
     {
       if (table->fn_key_copy)
       {
-        table->fn_key_copy(key_at(table, idx), key);
+        s_hashtable_copy(table, table->fn_key_copy, key_at(table, idx), key);
       }
       else
       {
@@ -802,7 +1568,7 @@ extern "C" {
 
       if (table->fn_value_copy)
       {
-        table->fn_value_copy(value_at(table, idx), value);
+        s_hashtable_copy(table, table->fn_value_copy, value_at(table, idx), value);
       }
       else
       {
@@ -812,6 +1578,7 @@ extern "C" {
       }
 
       entry->state = X_HASH_ENTRY_OCCUPIED;
+      entry->hash = hash;
       table->count++;
     }
 
@@ -821,31 +1588,41 @@ extern "C" {
   X_HASHTABLE_API bool x_hashtable_get(XHashtable* table, const void* key, void* out_value)
   {
     size_t idx;
+    size_t hash;
     bool found;
+    void* value_ptr;
 
     if (!table || !key || !out_value)
     {
       return false;
     }
 
-    probe_index(table,
-        (table->key_is_pointer && !table->key_is_null_terminated) ? &key : key,
-        &idx, &found);
+    s_hashtable_migrate(table, X_HASHTABLE_MIGRATE_STEP);
+    probe_key(table, key, &hash, &idx, &found);
 
     if (found)
     {
-      void* value_ptr = value_at(table, idx);
-      memcpy(out_value,
-          (table->value_is_pointer && !table->value_is_null_terminated) ? &value_ptr : value_ptr,
-          table->value_size);
-      return true;
+      value_ptr = value_at(table, idx);
     }
-    return false;
+    else if (table->old_entries && s_hashtable_probe_old(table, key, hash, &idx))
+    {
+      value_ptr = (char*)table->old_values + idx * table->value_size;
+    }
+    else
+    {
+      return false;
+    }
+
+    memcpy(out_value,
+        (table->value_is_pointer && !table->value_is_null_terminated) ? &value_ptr : value_ptr,
+        table->value_size);
+    return true;
   }
 
   X_HASHTABLE_API bool x_hashtable_has(XHashtable* table, const void* key)
   {
     size_t idx;
+    size_t hash;
     bool found;
 
     if (!table || !key)
@@ -853,15 +1630,91 @@ extern "C" {
       return false;
     }
 
-    probe_index(table,
-        (table->key_is_pointer && !table->key_is_null_terminated) ? &key : key,
-        &idx, &found);
+    s_hashtable_migrate(table, X_HASHTABLE_MIGRATE_STEP);
+    probe_key(table, key, &hash, &idx, &found);
+    if (!found && table->old_entries)
+    {
+      found = s_hashtable_probe_old(table, key, hash, &idx);
+    }
     return found;
   }
 
+  X_HASHTABLE_API size_t x_hashtable_get_many(XHashtable* table, const void* keys, size_t n, void* out_values, bool* out_found)
+  {
+    const void* raw[X_HASHTABLE_BATCH_SIZE];
+    const void* k[X_HASHTABLE_BATCH_SIZE];
+    size_t hashes[X_HASHTABLE_BATCH_SIZE];
+    size_t found_count = 0;
+    size_t base;
+
+    if (!table || (n > 0 && (!keys || !out_values)))
+    {
+      return 0;
+    }
+
+    s_hashtable_migrate(table, X_HASHTABLE_MIGRATE_STEP);
+
+    for (base = 0; base < n; base += X_HASHTABLE_BATCH_SIZE)
+    {
+      size_t batch = (n - base) < X_HASHTABLE_BATCH_SIZE ? (n - base) : X_HASHTABLE_BATCH_SIZE;
+      size_t mask = table->capacity - 1;
+      size_t i;
+
+      /* Pass 1: hash every key and start loading its home slot */
+      for (i = 0; i < batch; i++)
+      {
+        const char* elem = (const char*)keys + (base + i) * table->key_size;
+        size_t home;
+
+        raw[i] = (table->key_is_pointer || table->key_is_null_terminated) ? *(const void* const*)elem : (const void*)elem;
+        k[i] = table->key_is_null_terminated ? raw[i] : (const void*)elem;
+        hashes[i] = table->fn_key_hash(k[i], table->key_size);
+
+        home = hashes[i] & mask;
+        X_HASHTABLE_PREFETCH(&table->entries[home]);
+        X_HASHTABLE_PREFETCH(key_at(table, home));
+      }
+
+      /* Pass 2: the slots are (mostly) in cache now, resolve the probes */
+      for (i = 0; i < batch; i++)
+      {
+        void* out = (char*)out_values + (base + i) * table->value_size;
+        void* value_ptr = NULL;
+        size_t idx;
+        bool found;
+
+        probe_index(table, k[i], hashes[i], &idx, &found);
+        if (found)
+        {
+          value_ptr = value_at(table, idx);
+        }
+        else if (table->old_entries && s_hashtable_probe_old(table, raw[i], hashes[i], &idx))
+        {
+          value_ptr = (char*)table->old_values + idx * table->value_size;
+        }
+
+        if (value_ptr)
+        {
+          memcpy(out,
+              (table->value_is_pointer && !table->value_is_null_terminated) ? (void*)&value_ptr : value_ptr,
+              table->value_size);
+          found_count++;
+        }
+
+        if (out_found)
+        {
+          out_found[base + i] = value_ptr != NULL;
+        }
+      }
+    }
+
+    return found_count;
+  }
+
   X_HASHTABLE_API bool x_hashtable_remove(XHashtable* table, const void* key)
   {
     size_t idx;
+    size_t hash;
     bool found;
     XHashEntry* entry;
     void* key_ptr;
@@ -872,25 +1725,33 @@ extern "C" {
       return false;
     }
 
-    probe_index(table,
-        (table->key_is_pointer && !table->key_is_null_terminated) ? &key : key,
-        &idx, &found);
-    if (!found)
+    s_hashtable_migrate(table, X_HASHTABLE_MIGRATE_STEP);
+    probe_key(table, key, &hash, &idx, &found);
+
+    if (found)
     {
-      return false;
+      entry = &table->entries[idx];
+      key_ptr = key_at(table, idx);
+      value_ptr = value_at(table, idx);
+    }
+    else if (table->old_entries && s_hashtable_probe_old(table, key, hash, &idx))
+    {
+      entry = &table->old_entries[idx];
+      key_ptr = (char*)table->old_keys + idx * table->key_size;
+      value_ptr = (char*)table->old_values + idx * table->value_size;
+    }
+    else
+    {
+      return false;
     }
-
-    entry = &table->entries[idx];
-    key_ptr = key_at(table, idx);
-    value_ptr = value_at(table, idx);
 
     if (table->fn_key_free)
     {
-      table->fn_key_free(key_ptr);
+      s_hashtable_destroy_item(table, table->fn_key_free, key_ptr);
     }
     if (table->fn_value_free)
     {
-      table->fn_value_free(value_ptr);
+      s_hashtable_destroy_item(table, table->fn_value_free, value_ptr);
     }
 
     entry->state = X_HASH_ENTRY_DELETED;
@@ -907,6 +1768,9 @@ extern "C" {
       return;
     }
 
+    /* Pull any unmigrated entries in so they are released below */
+    s_hashtable_finish_migration(table);
+
     for (i = 0; i < table->capacity; i++)
     {
       if (table->entries[i].state == X_HASH_ENTRY_OCCUPIED)
@@ -916,19 +1780,17 @@ extern "C" {
 
         if (table->fn_key_free)
         {
-          table->fn_key_free(key_ptr);
+          s_hashtable_destroy_item(table, table->fn_key_free, key_ptr);
         }
         if (table->fn_value_free)
         {
-          table->fn_value_free(value_ptr);
+          s_hashtable_destroy_item(table, table->fn_value_free, value_ptr);
         }
       }
     }
 
-    X_HASHTABLE_FREE(table->entries);
-    X_HASHTABLE_FREE(table->keys);
-    X_HASHTABLE_FREE(table->values);
-    X_HASHTABLE_FREE(table);
+    s_hashtable_free_arrays(table, table->entries, table->keys, table->values, table->capacity);
+    s_hashtable_mem_free(&table->allocator, table, sizeof(XHashtable));
   }
 
   X_HASHTABLE_API size_t x_hashtable_count(const XHashtable* table)
@@ -936,74 +1798,115 @@ extern "C" {
     return table ? table->count : 0;
   }
 
+  /*
+   * Switches to new arrays of new_capacity slots. In blocking mode all
+   * entries are moved before returning; in incremental mode the current
+   * arrays become the old arrays and are drained by later operations.
+   * Entries are moved with their stored hash: no key is rehashed, and
+   * owned keys/values keep their allocations.
+   */
   X_HASHTABLE_API static bool x_hashtable_resize(XHashtable* table, size_t new_capacity)
   {
     XHashEntry* new_entries;
     void* new_keys;
     void* new_values;
-    XHashEntry* old_entries;
-    void* old_keys;
-    void* old_values;
-    size_t old_capacity;
     size_t i;
 
-    if (!table || new_capacity <= table->capacity)
+    if (!table || new_capacity <= table->capacity || table->old_entries)
     {
       return false;
     }
 
-    new_entries = (XHashEntry*)X_HASHTABLE_CALLOC(new_capacity, sizeof(XHashEntry));
-    new_keys = X_HASHTABLE_ALLOC(table->key_size * new_capacity);
-    new_values = X_HASHTABLE_ALLOC(table->value_size * new_capacity);
+    new_entries = (XHashEntry*)s_hashtable_mem_calloc(&table->allocator, new_capacity, sizeof(XHashEntry));
+    new_keys = s_hashtable_mem_alloc(&table->allocator, table->key_size * new_capacity);
+    new_values = s_hashtable_mem_alloc(&table->allocator, table->value_size * new_capacity);
 
     if (!new_entries || !new_keys || !new_values)
     {
-      X_HASHTABLE_FREE(new_entries);
-      X_HASHTABLE_FREE(new_keys);
-      X_HASHTABLE_FREE(new_values);
+      s_hashtable_free_arrays(table, new_entries, new_keys, new_values, new_capacity);
       return false;
     }
 
-    old_entries = table->entries;
-    old_keys = table->keys;
-    old_values = table->values;
-    old_capacity = table->capacity;
+    table->old_entries = table->entries;
+    table->old_keys = table->keys;
+    table->old_values = table->values;
+    table->old_capacity = table->capacity;
+    table->migrate_index = 0;
 
     table->entries = new_entries;
     table->keys = new_keys;
     table->values = new_values;
     table->capacity = new_capacity;
-    table->count = 0;
 
-    for (i = 0; i < old_capacity; i++)
+    if (table->resize_mode == XHASHTABLE_RESIZE_BLOCKING || table->count == 0)
     {
-      if (old_entries[i].state == X_HASH_ENTRY_OCCUPIED)
+      for (i = 0; i < table->old_capacity; i++)
       {
-        void* key_ptr = (char*)old_keys + i * table->key_size;
-        void* value_ptr = (char*)old_values + i * table->value_size;
-
-        x_hashtable_set(table,
-            table->key_is_null_terminated ? *(void**)key_ptr : (table->key_is_pointer ? *(void**)key_ptr : key_ptr),
-            table->value_is_null_terminated ? *(void**)value_ptr : (table->value_is_pointer ? *(void**)value_ptr : value_ptr));
-
-        if (table->fn_key_free)
-        {
-          table->fn_key_free(key_ptr);
-        }
-        if (table->fn_value_free)
+        if (table->old_entries[i].state == X_HASH_ENTRY_OCCUPIED)
         {
-          table->fn_value_free(value_ptr);
+          s_hashtable_place(table, &table->old_entries[i],
+              (char*)table->old_keys + i * table->key_size,
+              (char*)table->old_values + i * table->value_size);
         }
       }
-    }
 
-    X_HASHTABLE_FREE(old_entries);
-    X_HASHTABLE_FREE(old_keys);
-    X_HASHTABLE_FREE(old_values);
+      s_hashtable_free_arrays(table, table->old_entries, table->old_keys, table->old_values, table->old_capacity);
+      table->old_entries = NULL;
+      table->old_keys = NULL;
+      table->old_values = NULL;
+      table->old_capacity = 0;
+    }
 
     return true;
   }
 
+  X_HASHTABLE_API bool x_hashtable_reserve(XHashtable* table, size_t count)
+  {
+    size_t capacity;
+
+    if (!table)
+    {
+      return false;
+    }
+
+    capacity = table->capacity;
+    while ((double)count / capacity > X_HASHTABLE_LOAD_FACTOR)
+    {
+      capacity *= 2;
+    }
+
+    if (capacity == table->capacity)
+    {
+      return true;
+    }
+
+    {
+      /* Reserving is an explicit request to pay the cost now, so never leave it incremental */
+      XHashtableResizeMode mode = table->resize_mode;
+      bool ok;
+
+      s_hashtable_finish_migration(table);
+      table->resize_mode = XHASHTABLE_RESIZE_BLOCKING;
+      ok = x_hashtable_resize(table, capacity);
+      table->resize_mode = mode;
+      return ok;
+    }
+  }
+
+  X_HASHTABLE_API void x_hashtable_set_resize_mode(XHashtable* table, XHashtableResizeMode mode)
+  {
+    if (!table)
+    {
+      return;
+    }
+
+    if (mode == XHASHTABLE_RESIZE_BLOCKING)
+    {
+      s_hashtable_finish_migration(table);
+    }
+    table->resize_mode = mode;
+  }
+
   X_HASHTABLE_API static inline const void* x_hashtable__user_key_ptr(XHashtable* t, size_t i)
   {
     void* slot = key_at(t, i);
@@ -1035,6 +1938,9 @@ extern "C" {
       return false;
     }
 
+    /* Iteration walks a single set of arrays */
+    s_hashtable_finish_migration(table);
+
     it->table = table;
     it->index = (size_t)-1;
     return true;
@@ -1108,6 +2014,583 @@ extern "C" {
     return it->index;
   }
 
+  /*
+   * Flat hashtable implementation
+   */
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define X_FLAT_HASHTABLE_SSE2 1
+#elif (defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define X_FLAT_HASHTABLE_NEON 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#define X_FLAT_CTRL_EMPTY   ((uint8_t)0x80)
+#define X_FLAT_CTRL_DELETED ((uint8_t)0xFE)
+
+  /* Bitmask with one bit per slot of a group; returns slots whose control byte equals c */
+  static inline uint32_t s_flat_group_match(const uint8_t* group, uint8_t c)
+  {
+#if defined(X_FLAT_HASHTABLE_SSE2)
+    __m128i g = _mm_loadu_si128((const __m128i*)group);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)c)));
+#elif defined(X_FLAT_HASHTABLE_NEON)
+    static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t eq = vandq_u8(vceqq_u8(vld1q_u8(group), vdupq_n_u8(c)), vld1q_u8(bits));
+    return (uint32_t)vaddv_u8(vget_low_u8(eq)) | ((uint32_t)vaddv_u8(vget_high_u8(eq)) << 8);
+#else
+    uint32_t mask = 0;
+    int i;
+    for (i = 0; i < X_FLAT_HASHTABLE_GROUP_WIDTH; i++)
+    {
+      if (group[i] == c)
+      {
+        mask |= 1u << i;
+      }
+    }
+    return mask;
+#endif
+  }
+
+  /* Slots that are EMPTY or DELETED (control byte has its high bit set) */
+  static inline uint32_t s_flat_group_match_free(const uint8_t* group)
+  {
+#if defined(X_FLAT_HASHTABLE_SSE2)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)group));
+#elif defined(X_FLAT_HASHTABLE_NEON)
+    static const uint8_t bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+    uint8x16_t hi = vandq_u8(vcltq_s8(vreinterpretq_s8_u8(vld1q_u8(group)), vdupq_n_s8(0)), vld1q_u8(bits));
+    return (uint32_t)vaddv_u8(vget_low_u8(hi)) | ((uint32_t)vaddv_u8(vget_high_u8(hi)) << 8);
+#else
+    uint32_t mask = 0;
+    int i;
+    for (i = 0; i < X_FLAT_HASHTABLE_GROUP_WIDTH; i++)
+    {
+      if (group[i] & 0x80)
+      {
+        mask |= 1u << i;
+      }
+    }
+    return mask;
+#endif
+  }
+
+  static inline uint32_t s_flat_ctz(uint32_t mask)
+  {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctz(mask);
+#endif
+  }
+
+  /* Stores the user hash after a multiplicative mix so weak hashes still spread over h1 and h2 */
+  static inline uint64_t s_flat_hash(const XFlatHashtable* t, const void* key)
+  {
+    uint64_t h = (uint64_t)t->fn_key_hash(key, t->key_size) * 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+  }
+
+  static inline size_t s_flat_max_load(size_t capacity)
+  {
+    return capacity - capacity / 8;
+  }
+
+  static inline void* s_flat_slot(const XFlatHashtable* t, size_t i)
+  {
+    return (char*)t->slots + i * t->slot_size;
+  }
+
+  static inline void* s_flat_slot_value(const XFlatHashtable* t, size_t i)
+  {
+    return (char*)t->slots + i * t->slot_size + t->value_offset;
+  }
+
+  /* Natural alignment guess for a field of the given size, capped at 8 */
+  static inline size_t s_flat_align_of(size_t size)
+  {
+    size_t a = 1;
+    while (a < 8 && (size % (a * 2)) == 0)
+    {
+      a *= 2;
+    }
+    return a;
+  }
+
+  static inline size_t s_flat_align_up(size_t n, size_t a)
+  {
+    return (n + a - 1) & ~(a - 1);
+  }
+
+  static inline bool s_flat_key_eq(const XFlatHashtable* t, const void* slot_key, const void* key)
+  {
+    if (t->fn_key_compare)
+    {
+      return t->fn_key_compare(slot_key, &key);
+    }
+
+    if (t->key_size == sizeof(uint32_t))
+    {
+      uint32_t a, b;
+      memcpy(&a, slot_key, sizeof(a));
+      memcpy(&b, key, sizeof(b));
+      return a == b;
+    }
+
+    if (t->key_size == sizeof(uint64_t))
+    {
+      uint64_t a, b;
+      memcpy(&a, slot_key, sizeof(a));
+      memcpy(&b, key, sizeof(b));
+      return a == b;
+    }
+
+    return memcmp(slot_key, key, t->key_size) == 0;
+  }
+
+  /* Key as it must be handed to fn_key_hash, given a stored slot */
+  static inline const void* s_flat_slot_hash_key(const XFlatHashtable* t, size_t i)
+  {
+    void* slot = s_flat_slot(t, i);
+    return t->key_is_null_terminated ? *(void**)slot : slot;
+  }
+
+  static bool s_flat_alloc_storage(XFlatHashtable* t, size_t capacity)
+  {
+    uint8_t* ctrl = (uint8_t*)X_HASHTABLE_ALLOC(capacity);
+    void* slots = X_HASHTABLE_ALLOC(t->slot_size * capacity);
+
+    if (!ctrl || !slots)
+    {
+      X_HASHTABLE_FREE(ctrl);
+      X_HASHTABLE_FREE(slots);
+      return false;
+    }
+
+    memset(ctrl, X_FLAT_CTRL_EMPTY, capacity);
+    t->ctrl = ctrl;
+    t->slots = slots;
+    t->capacity = capacity;
+    t->growth_left = s_flat_max_load(capacity) - t->count;
+    return true;
+  }
+
+  /*
+   * Looks for key. Probing walks whole groups in triangular order, which
+   * visits every group exactly once because the group count is a power of two.
+   * Returns the slot index or (size_t)-1 when absent.
+   */
+  static size_t s_flat_find(const XFlatHashtable* t, const void* key, uint64_t hash)
+  {
+    size_t group_mask = t->capacity / X_FLAT_HASHTABLE_GROUP_WIDTH - 1;
+    size_t g = (size_t)(hash >> 7) & group_mask;
+    uint8_t h2 = (uint8_t)(hash & 0x7F);
+    size_t step;
+
+    for (step = 0; step <= group_mask; step++)
+    {
+      const uint8_t* group = t->ctrl + g * X_FLAT_HASHTABLE_GROUP_WIDTH;
+      uint32_t match = s_flat_group_match(group, h2);
+
+      while (match)
+      {
+        size_t idx = g * X_FLAT_HASHTABLE_GROUP_WIDTH + s_flat_ctz(match);
+        if (s_flat_key_eq(t, s_flat_slot(t, idx), key))
+        {
+          return idx;
+        }
+        match &= match - 1;
+      }
+
+      if (s_flat_group_match(group, X_FLAT_CTRL_EMPTY))
+      {
+        return (size_t)-1;
+      }
+
+      g = (g + step + 1) & group_mask;
+    }
+
+    return (size_t)-1;
+  }
+
+  /* First EMPTY or DELETED slot on the probe sequence of hash. The table always has one. */
+  static size_t s_flat_find_insert_slot(const XFlatHashtable* t, uint64_t hash)
+  {
+    size_t group_mask = t->capacity / X_FLAT_HASHTABLE_GROUP_WIDTH - 1;
+    size_t g = (size_t)(hash >> 7) & group_mask;
+    size_t step;
+
+    for (step = 0; step <= group_mask; step++)
+    {
+      uint32_t free_mask = s_flat_group_match_free(t->ctrl + g * X_FLAT_HASHTABLE_GROUP_WIDTH);
+      if (free_mask)
+      {
+        return g * X_FLAT_HASHTABLE_GROUP_WIDTH + s_flat_ctz(free_mask);
+      }
+      g = (g + step + 1) & group_mask;
+    }
+
+    return (size_t)-1;
+  }
+
+  /*
+   * Rebuilds the table into new storage. Slots are moved bytewise, so owned
+   * keys and values change location without being cloned or freed. Rehashing
+   * at the same capacity purges tombstones.
+   */
+  static bool s_flat_rehash(XFlatHashtable* t, size_t new_capacity)
+  {
+    uint8_t* old_ctrl = t->ctrl;
+    void* old_slots = t->slots;
+    size_t old_capacity = t->capacity;
+    size_t i;
+    XFlatHashtable old = *t;
+
+    if (!s_flat_alloc_storage(t, new_capacity))
+    {
+      return false;
+    }
+
+    for (i = 0; i < old_capacity; i++)
+    {
+      if ((old_ctrl[i] & 0x80) == 0)
+      {
+        uint64_t hash = s_flat_hash(t, s_flat_slot_hash_key(&old, i));
+        size_t idx = s_flat_find_insert_slot(t, hash);
+        t->ctrl[idx] = (uint8_t)(hash & 0x7F);
+        memcpy(s_flat_slot(t, idx), s_flat_slot(&old, i), t->slot_size);
+      }
+    }
+
+    t->growth_left = s_flat_max_load(new_capacity) - t->count;
+    X_HASHTABLE_FREE(old_ctrl);
+    X_HASHTABLE_FREE(old_slots);
+    return true;
+  }
+
+  X_HASHTABLE_API XFlatHashtable* x_flat_hashtable_create_ex(size_t key_size, bool key_null_terminated, bool key_is_pointer,
+      size_t value_size, bool value_null_terminated, bool value_is_pointer)
+  {
+    XFlatHashtable* ht = x_flat_hashtable_create_full(
+        key_size,
+        value_size,
+        key_null_terminated   ? x_hashtable_hash_cstr     : x_hashtable_hash_bytes,
+        key_null_terminated   ? x_hashtable_compare_cstr  : NULL,
+        key_null_terminated   ? x_hashtable_clone_cstr    : NULL,
+        key_null_terminated   ? x_hashtable_free_cstr     : NULL,
+        value_null_terminated ? x_hashtable_clone_cstr    : NULL,
+        value_null_terminated ? x_hashtable_free_cstr     : NULL);
+
+    if (!ht)
+    {
+      return NULL;
+    }
+
+    ht->key_is_pointer = key_is_pointer;
+    ht->key_is_null_terminated = key_null_terminated;
+    ht->value_is_pointer = value_is_pointer;
+    ht->value_is_null_terminated = value_null_terminated;
+    return ht;
+  }
+
+  X_HASHTABLE_API XFlatHashtable* x_flat_hashtable_create_full(
+      size_t          key_size,
+      size_t          value_size,
+      XHashFnHash     fn_key_hash,
+      XHashFnCompare  fn_key_compare,
+      XHashFnClone    fn_key_copy,
+      XHashFnDestroy  fn_key_free,
+      XHashFnClone    fn_value_copy,
+      XHashFnDestroy  fn_value_free)
+  {
+    XFlatHashtable* table;
+    size_t key_align = s_flat_align_of(key_size);
+    size_t value_align = s_flat_align_of(value_size);
+
+    if (key_size == 0 || !fn_key_hash)
+    {
+      return NULL;
+    }
+
+    table = (XFlatHashtable*)X_HASHTABLE_ALLOC(sizeof(XFlatHashtable));
+    if (!table)
+    {
+      return NULL;
+    }
+
+    memset(table, 0, sizeof(*table));
+    table->key_size = key_size;
+    table->value_size = value_size;
+    table->value_offset = s_flat_align_up(key_size, value_align);
+    table->slot_size = s_flat_align_up(table->value_offset + value_size,
+        key_align > value_align ? key_align : value_align);
+
+    table->fn_key_hash = fn_key_hash;
+    table->fn_key_compare = fn_key_compare;
+    table->fn_key_copy = fn_key_copy;
+    table->fn_key_free = fn_key_free;
+    table->fn_value_copy = fn_value_copy;
+    table->fn_value_free = fn_value_free;
+
+    if (!s_flat_alloc_storage(table, X_HASHTABLE_INITIAL_CAPACITY < X_FLAT_HASHTABLE_GROUP_WIDTH ?
+          X_FLAT_HASHTABLE_GROUP_WIDTH : X_HASHTABLE_INITIAL_CAPACITY))
+    {
+      X_HASHTABLE_FREE(table);
+      return NULL;
+    }
+
+    return table;
+  }
+
+  X_HASHTABLE_API bool x_flat_hashtable_set(XFlatHashtable* table, const void* key, const void* value)
+  {
+    const void* k;
+    uint64_t hash;
+    size_t idx;
+
+    if (!table || !key)
+    {
+      return false;
+    }
+
+    k = (table->key_is_pointer && !table->key_is_null_terminated) ? (const void*)&key : key;
+    hash = s_flat_hash(table, k);
+    idx = s_flat_find(table, k, hash);
+
+    if (idx != (size_t)-1)
+    {
+      void* value_ptr = s_flat_slot_value(table, idx);
+      if (table->fn_value_free)
+      {
+        table->fn_value_free(value_ptr);
+      }
+      if (table->fn_value_copy)
+      {
+        table->fn_value_copy(value_ptr, value);
+      }
+      else
+      {
+        memcpy(value_ptr,
+            (table->value_is_pointer && !table->value_is_null_terminated) ? (const void*)&value : value,
+            table->value_size);
+      }
+      return true;
+    }
+
+    idx = s_flat_find_insert_slot(table, hash);
+    if (table->growth_left == 0 && table->ctrl[idx] == X_FLAT_CTRL_EMPTY)
+    {
+      /* Grow only when live entries need it; otherwise just drop tombstones */
+      size_t new_capacity = (table->count + 1) * 2 > s_flat_max_load(table->capacity) ?
+        table->capacity * 2 : table->capacity;
+
+      if (!s_flat_rehash(table, new_capacity))
+      {
+        return false;
+      }
+      idx = s_flat_find_insert_slot(table, hash);
+    }
+
+    if (table->ctrl[idx] == X_FLAT_CTRL_EMPTY)
+    {
+      table->growth_left--;
+    }
+    table->ctrl[idx] = (uint8_t)(hash & 0x7F);
+
+    if (table->fn_key_copy)
+    {
+      table->fn_key_copy(s_flat_slot(table, idx), key);
+    }
+    else
+    {
+      memcpy(s_flat_slot(table, idx), k, table->key_size);
+    }
+
+    if (table->fn_value_copy)
+    {
+      table->fn_value_copy(s_flat_slot_value(table, idx), value);
+    }
+    else
+    {
+      memcpy(s_flat_slot_value(table, idx),
+          (table->value_is_pointer && !table->value_is_null_terminated) ? (const void*)&value : value,
+          table->value_size);
+    }
+
+    table->count++;
+    return true;
+  }
+
+  X_HASHTABLE_API bool x_flat_hashtable_get(XFlatHashtable* table, const void* key, void* out_value)
+  {
+    const void* k;
+    size_t idx;
+
+    if (!table || !key || !out_value)
+    {
+      return false;
+    }
+
+    k = (table->key_is_pointer && !table->key_is_null_terminated) ? (const void*)&key : key;
+    idx = s_flat_find(table, k, s_flat_hash(table, k));
+    if (idx == (size_t)-1)
+    {
+      return false;
+    }
+
+    {
+      void* value_ptr = s_flat_slot_value(table, idx);
+      memcpy(out_value,
+          (table->value_is_pointer && !table->value_is_null_terminated) ? (void*)&value_ptr : value_ptr,
+          table->value_size);
+    }
+    return true;
+  }
+
+  X_HASHTABLE_API bool x_flat_hashtable_has(XFlatHashtable* table, const void* key)
+  {
+    const void* k;
+
+    if (!table || !key)
+    {
+      return false;
+    }
+
+    k = (table->key_is_pointer && !table->key_is_null_terminated) ? (const void*)&key : key;
+    return s_flat_find(table, k, s_flat_hash(table, k)) != (size_t)-1;
+  }
+
+  X_HASHTABLE_API bool x_flat_hashtable_remove(XFlatHashtable* table, const void* key)
+  {
+    const void* k;
+    size_t idx;
+    const uint8_t* group;
+
+    if (!table || !key)
+    {
+      return false;
+    }
+
+    k = (table->key_is_pointer && !table->key_is_null_terminated) ? (const void*)&key : key;
+    idx = s_flat_find(table, k, s_flat_hash(table, k));
+    if (idx == (size_t)-1)
+    {
+      return false;
+    }
+
+    if (table->fn_key_free)
+    {
+      table->fn_key_free(s_flat_slot(table, idx));
+    }
+    if (table->fn_value_free)
+    {
+      table->fn_value_free(s_flat_slot_value(table, idx));
+    }
+
+    /*
+     * A group that still has an EMPTY slot never made a probe continue past
+     * it, so the slot can become EMPTY again. Otherwise leave a tombstone.
+     */
+    group = table->ctrl + (idx & ~(size_t)(X_FLAT_HASHTABLE_GROUP_WIDTH - 1));
+    if (s_flat_group_match(group, X_FLAT_CTRL_EMPTY))
+    {
+      table->ctrl[idx] = X_FLAT_CTRL_EMPTY;
+      table->growth_left++;
+    }
+    else
+    {
+      table->ctrl[idx] = X_FLAT_CTRL_DELETED;
+    }
+
+    table->count--;
+    return true;
+  }
+
+  X_HASHTABLE_API void x_flat_hashtable_destroy(XFlatHashtable* table)
+  {
+    size_t i;
+
+    if (!table)
+    {
+      return;
+    }
+
+    if (table->fn_key_free || table->fn_value_free)
+    {
+      for (i = 0; i < table->capacity; i++)
+      {
+        if ((table->ctrl[i] & 0x80) == 0)
+        {
+          if (table->fn_key_free)
+          {
+            table->fn_key_free(s_flat_slot(table, i));
+          }
+          if (table->fn_value_free)
+          {
+            table->fn_value_free(s_flat_slot_value(table, i));
+          }
+        }
+      }
+    }
+
+    X_HASHTABLE_FREE(table->ctrl);
+    X_HASHTABLE_FREE(table->slots);
+    X_HASHTABLE_FREE(table);
+  }
+
+  X_HASHTABLE_API size_t x_flat_hashtable_count(const XFlatHashtable* table)
+  {
+    return table ? table->count : 0;
+  }
+
+  X_HASHTABLE_API bool x_flat_hashtable_iter_begin(XFlatHashtable* table, XFlatHashtableIter* it)
+  {
+    if (!table || !it)
+    {
+      return false;
+    }
+
+    it->table = table;
+    it->index = (size_t)-1;
+    return true;
+  }
+
+  X_HASHTABLE_API bool x_flat_hashtable_iter_next(XFlatHashtableIter* it, void** out_key, void** out_value)
+  {
+    XFlatHashtable* t;
+    size_t i;
+
+    if (!it || !it->table || !out_key || !out_value)
+    {
+      return false;
+    }
+
+    t = it->table;
+
+    for (i = it->index + 1; i < t->capacity; i++)
+    {
+      if ((t->ctrl[i] & 0x80) == 0)
+      {
+        void* key_slot = s_flat_slot(t, i);
+        void* value_slot = s_flat_slot_value(t, i);
+        it->index = i;
+        *out_key = (t->key_is_pointer || t->key_is_null_terminated) ? *(void**)key_slot : key_slot;
+        *out_value = (t->value_is_pointer || t->value_is_null_terminated) ? *(void**)value_slot : value_slot;
+        return true;
+      }
+    }
+
+    it->index = t->capacity;
+    return false;
+  }
+
 #ifdef __cplusplus
 }
 #endif
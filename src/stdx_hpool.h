@@ -94,6 +94,83 @@
  *      }
  *
  *
+ * ## Parallel iteration
+ *
+ *  Live objects occupy alive positions `[0, x_hpool_alive_count())`. The
+ *  range can be cut into contiguous chunks with `x_hpool_range_count()` /
+ *  `x_hpool_range()` and each chunk handed to a different thread, which
+ *  resolves positions with `x_hpool_item_at()`:
+ *
+ *      uint32_t n = x_hpool_range_count(&pool, 4096);
+ *      for (uint32_t c = 0; c < n; ++c)
+ *      {
+ *          XHPoolRange r = x_hpool_range(&pool, 4096, c);
+ *          for (uint32_t pos = r.begin; pos < r.end; ++pos)
+ *              update(x_hpool_item_at(&pool, pos, NULL));
+ *      }
+ *
+ *  `x_hpool_for_each_parallel()` does this on an `XThreadPool` and calls a
+ *  function for every live object.
+ *
+ *  Rules while a parallel pass is in flight:
+ *   - Workers may read and write the items of their own range.
+ *   - `x_hpool_get()`, `x_hpool_get_fast()`, `x_hpool_is_alive()`,
+ *     `x_hpool_item_at()` and `x_hpool_alive_count()` are safe from any thread.
+ *   - `x_hpool_alloc()`, `x_hpool_free()`, `x_hpool_clear()` and
+ *     `x_hpool_term()` are not: they reorder `alive[]` (and move items in
+ *     the dense layout). Collect handles during the pass and free them after.
+ *     Concurrent pools (below) allow alloc and free during a pass.
+ *
+ * ## Dense layout
+ *
+ *  By default each page interleaves a small slot header with every item,
+ *  so iterating drags headers through the cache along with the items.
+ *  Setting `cfg.layout = XHPOOL_LAYOUT_DENSE` stores the headers in their
+ *  own pages and keeps the items packed in one array in `alive[]` order.
+ *  Iteration then sweeps item memory linearly, and the whole live set is
+ *  available as a plain array:
+ *
+ *      MyType* items = (MyType*)x_hpool_dense_items(&pool);
+ *      for (uint32_t i = 0; i < x_hpool_alive_count(&pool); ++i)
+ *          update(&items[i]);
+ *
+ *  The price is that items move: freeing swaps the last item into the
+ *  hole, and allocating may reallocate the array. Pointers returned by
+ *  `x_hpool_get()` or the iterator are only valid until the next alloc or
+ *  free; keep handles, not pointers. Lookups by handle read the header
+ *  and then the item, so random access is slightly slower than with the
+ *  interleaved layout.
+ *
+ * ## Concurrent mode
+ *
+ *  Setting `cfg.concurrent = 1` lets any number of threads call
+ *  `x_hpool_alloc()`, `x_hpool_free()` and `x_hpool_get()` on the same pool
+ *  at once:
+ *
+ *      XHPoolConfig cfg = {0};
+ *      cfg.concurrent = 1;
+ *      cfg.max_pages = 256;        // pages[] is sized once and never moves
+ *
+ *   - `x_hpool_get()` is wait-free: a page pointer load and a version check.
+ *   - Free slots live on a lock-free stack whose head carries the version
+ *     of the top slot. Every free bumps the version before the slot goes
+ *     back on the stack, so a stale head never matches (no ABA).
+ *   - Each thread keeps a small cache of free slots per pool and grabs fresh
+ *     indices in batches, so most alloc/free pairs never touch shared state.
+ *   - Pages are installed into a fixed directory of `cfg.max_pages` entries,
+ *     so growing the pool never moves memory a reader might be looking at.
+ *
+ *  Limits of this mode:
+ *   - Only the interleaved layout is supported.
+ *   - `alive[]` is not maintained. Iteration, `x_hpool_item_at()` and the
+ *     range helpers walk slot indices instead of alive positions and skip
+ *     (or return NULL for) dead slots, so they see a weakly consistent view.
+ *   - Freeing an object while another thread still uses it is, as always,
+ *     the caller's problem; the version check only rejects stale handles.
+ *   - A thread that is done with pools may call `x_hpool_thread_detach()`;
+ *     its cache slot (and the free slots it holds) pass to the next thread.
+ *   - `x_hpool_clear()` and `x_hpool_term()` still need exclusive access.
+ *
  * ## Optional Constructors / Destructors
  *
  *  A constructor and destructor may be supplied when the pool is
@@ -115,6 +192,11 @@
  *      #include "stdx_hpool.h"
  *
  *
+ * ## Dependencies
+ *
+ *  stdx_common.h
+ *  stdx_thread.h (implementation required, for x_hpool_for_each_parallel)
+ *
  * ## Custom memory allocation
  *
  *  To override how this module allocates memory define the following
@@ -130,6 +212,8 @@
 #define STDX_HPOOL_H
 
 #include "stdx_common.h"
+#include "stdx_thread.h"
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -157,17 +241,48 @@ extern "C" {
 
   typedef void (*XHPoolDtorFn)(void* user, void* item);
 
+  typedef enum XHPoolLayout
+  {
+    XHPOOL_LAYOUT_INTERLEAVED = 0,  // Header and item share a slot; items never move.
+    XHPOOL_LAYOUT_DENSE       = 1   // Headers apart, items packed in alive[] order; items move on alloc/free.
+  } XHPoolLayout;
+
+#ifndef X_HPOOL_MAX_PAGES
+#define X_HPOOL_MAX_PAGES 1024u       // Default page directory size in concurrent mode
+#endif
+
+#ifndef X_HPOOL_THREAD_CACHES
+#define X_HPOOL_THREAD_CACHES 64      // Threads with a private free-slot cache; others use the shared stack
+#endif
+
+#ifndef X_HPOOL_THREAD_CACHE_SIZE
+#define X_HPOOL_THREAD_CACHE_SIZE 32  // Free slots a thread keeps per pool
+#endif
+
   typedef struct XHPoolConfig
   {
     uint32_t page_capacity;   // e.g. 1024
     uint32_t initial_pages;   // e.g. 1
+    XHPoolLayout layout;      // XHPOOL_LAYOUT_INTERLEAVED unless set
+    int concurrent;           // nonzero: alloc/free/get may be called from any thread
+    uint32_t max_pages;       // concurrent: page directory size, X_HPOOL_MAX_PAGES if 0
   } XHPoolConfig;
 
+  typedef struct XHPoolThreadCache XHPoolThreadCache;
+
   typedef struct XHPoolIter
   {
     uint32_t alive_pos;
   } XHPoolIter;
 
+  typedef struct XHPoolRange
+  {
+    uint32_t begin;           // first alive position
+    uint32_t end;             // one past the last alive position
+  } XHPoolRange;
+
+  typedef void (*XHPoolForEachFn)(void* ctx, void* item, XHandle h);
+
   typedef struct XHPool
   {
     size_t item_size;
@@ -186,6 +301,14 @@ extern "C" {
     uint32_t alive_count;
     uint32_t alive_cap;
 
+    XHPoolLayout layout;
+    uint8_t* dense;           // XHPOOL_LAYOUT_DENSE: items, alive_cap * item_size bytes
+    uint32_t* dense_version;  // XHPOOL_LAYOUT_DENSE: version of the item at each alive position
+
+    int concurrent;
+    volatile int64_t free_top;      // concurrent: free stack head, (version << 32) | index
+    XHPoolThreadCache* caches;      // concurrent: X_HPOOL_THREAD_CACHES entries
+
     XHPoolCtorFn ctor;
     XHPoolDtorFn dtor;
     void* user;
@@ -207,6 +330,12 @@ extern "C" {
   X_HPOOL_API void x_hpool_clear(XHPool* p);
   X_HPOOL_API void* x_hpool_iter_begin(XHPool* p, XHPoolIter* it, XHandle* out_h);
   X_HPOOL_API void* x_hpool_iter_next(XHPool* p, XHPoolIter* it, XHandle* out_h);
+  X_HPOOL_API void* x_hpool_dense_items(XHPool* p);
+  X_HPOOL_API void* x_hpool_item_at(XHPool* p, uint32_t alive_pos, XHandle* out_h);
+  X_HPOOL_API uint32_t x_hpool_range_count(XHPool* p, uint32_t chunk_size);
+  X_HPOOL_API XHPoolRange x_hpool_range(XHPool* p, uint32_t chunk_size, uint32_t chunk_index);
+  X_HPOOL_API int x_hpool_for_each_parallel(XHPool* p, XThreadPool* pool, XHPoolForEachFn fn, void* ctx);
+  X_HPOOL_API void x_hpool_thread_detach(void);
 
 #define X_HPOOL_FOREACH(pHPool, Type, itVar, hVar, ptrVar) \
   for (XHPoolIter itVar = {0}, *x__hpool_once_##itVar = &(itVar); x__hpool_once_##itVar != NULL; x__hpool_once_##itVar = NULL) \
@@ -299,30 +428,8 @@ extern "C" {
     return n;
   }
 
-  X_HPOOL_API static uint32_t s_hpool_page_index(const XHPool* p, uint32_t index);
-
-  X_HPOOL_API static uint32_t s_hpool_slot_index(const XHPool* p, uint32_t index);
-
   X_HPOOL_API static size_t x_hpool_slot_stride(const XHPool* p);
 
-  X_HPOOL_API static uint8_t* s_hpool_page_base(const XHPool* p, uint32_t page_index);
-
-  X_HPOOL_API static XHPoolSlotHeader* s_hpool_slot_hdr(const XHPool* p, uint32_t index);
-
-  X_HPOOL_API static void* s_hpool_slot_item(const XHPool* p, XHPoolSlotHeader* hdr);
-
-  X_HPOOL_API static void* s_hpool_item_by_index(const XHPool* p, uint32_t index);
-
-  X_HPOOL_API static int s_hpool_ensure_pages_array(XHPool* p, uint32_t want);
-
-  X_HPOOL_API static int s_hpool_add_page(XHPool* p);
-
-  X_HPOOL_API static int s_hpool_ensure_page_for_index(XHPool* p, uint32_t index);
-
-  X_HPOOL_API static int s_hpool_alive_reserve(XHPool* p, uint32_t want);
-
-  X_HPOOL_API static void s_hpool_alive_add(XHPool* p, uint32_t index);
-
   X_HPOOL_API int x_handle_is_null(XHandle h)
   {
     return h.index == X_HPOOL_NULL_INDEX;
@@ -341,7 +448,11 @@ extern "C" {
   X_HPOOL_API size_t x_hpool_slot_stride(const XHPool* p)
   {
     size_t s;
-    s = sizeof(XHPoolSlotHeader) + p->item_size;
+    s = sizeof(XHPoolSlotHeader);
+    if (p->layout != XHPOOL_LAYOUT_DENSE)
+    {
+      s = s + p->item_size;
+    }
     return s;
   }
 
@@ -367,9 +478,16 @@ extern "C" {
     return (XHPoolSlotHeader*)ptr;
   }
 
+  /* Dense layout: only valid while the slot is alive */
   X_HPOOL_API void* x_hpool_slot_item(const XHPool* p, XHPoolSlotHeader* hdr)
   {
     uint8_t* ptr;
+
+    if (p->layout == XHPOOL_LAYOUT_DENSE)
+    {
+      return (void*)(p->dense + (size_t)hdr->alive_pos * p->item_size);
+    }
+
     ptr = (uint8_t*)hdr;
     ptr = ptr + sizeof(XHPoolSlotHeader);
     return (void*)ptr;
@@ -503,8 +621,27 @@ extern "C" {
     {
       return 0;
     }
-
     p->alive = new_arr;
+
+    if (p->layout == XHPOOL_LAYOUT_DENSE)
+    {
+      uint8_t* new_dense;
+
+      new_arr = (uint32_t*)X_HPOOL_REALLOC(p->dense_version, (size_t)new_cap * sizeof(uint32_t));
+      if (new_arr == NULL)
+      {
+        return 0;
+      }
+      p->dense_version = new_arr;
+
+      new_dense = (uint8_t*)X_HPOOL_REALLOC(p->dense, (size_t)new_cap * p->item_size);
+      if (new_dense == NULL)
+      {
+        return 0;
+      }
+      p->dense = new_dense;
+    }
+
     p->alive_cap = new_cap;
 
     return 1;
@@ -520,6 +657,11 @@ extern "C" {
     hdr->alive_pos = p->alive_count;
     hdr->flags = hdr->flags | X_POOL_SLOT_ALIVE;
 
+    if (p->layout == XHPOOL_LAYOUT_DENSE)
+    {
+      p->dense_version[p->alive_count] = hdr->version;
+    }
+
     p->alive_count = p->alive_count + 1u;
   }
 
@@ -547,6 +689,15 @@ extern "C" {
 
       moved_hdr = x_hpool_slot_hdr(p, moved_index);
       moved_hdr->alive_pos = pos;
+
+      /* Dense layout: the last item fills the hole so items stay packed */
+      if (p->layout == XHPOOL_LAYOUT_DENSE)
+      {
+        memcpy(p->dense + (size_t)pos * p->item_size,
+            p->dense + (size_t)last_pos * p->item_size,
+            p->item_size);
+        p->dense_version[pos] = p->dense_version[last_pos];
+      }
     }
 
     p->alive_count = p->alive_count - 1u;
@@ -555,6 +706,419 @@ extern "C" {
     hdr->flags = hdr->flags & ~X_POOL_SLOT_ALIVE;
   }
 
+  /* ----------------------------- concurrent mode ----------------------------- */
+
+  struct XHPoolThreadCache
+  {
+    uint32_t count;
+    uint32_t slots[X_HPOOL_THREAD_CACHE_SIZE];
+    char pad[X_THREAD_CACHE_LINE_SIZE - (sizeof(uint32_t) * (X_HPOOL_THREAD_CACHE_SIZE + 1)) % X_THREAD_CACHE_LINE_SIZE];
+  };
+
+#define X_HPOOL_THREAD_NONE     -1
+#define X_HPOOL_THREAD_OVERFLOW -2
+
+  /* One cache index per thread, shared by every concurrent pool */
+  static volatile int32_t s_hpool_thread_slots[X_HPOOL_THREAD_CACHES];
+  static X_THREAD_LOCAL int32_t s_hpool_thread_slot = X_HPOOL_THREAD_NONE;
+
+  static XHPoolThreadCache* s_hpool_thread_cache(XHPool* p)
+  {
+    int32_t i;
+
+    if (s_hpool_thread_slot == X_HPOOL_THREAD_NONE)
+    {
+      s_hpool_thread_slot = X_HPOOL_THREAD_OVERFLOW;
+      for (i = 0; i < X_HPOOL_THREAD_CACHES; i++)
+      {
+        if (x_atomic_load_i32(&s_hpool_thread_slots[i]) == 0 &&
+            x_atomic_cas_i32(&s_hpool_thread_slots[i], 0, 1))
+        {
+          s_hpool_thread_slot = i;
+          break;
+        }
+      }
+    }
+
+    if (s_hpool_thread_slot < 0)
+    {
+      return NULL;
+    }
+
+    return &p->caches[s_hpool_thread_slot];
+  }
+
+  X_HPOOL_API void x_hpool_thread_detach(void)
+  {
+    if (s_hpool_thread_slot >= 0)
+    {
+      x_atomic_store_i32(&s_hpool_thread_slots[s_hpool_thread_slot], 0);
+    }
+    s_hpool_thread_slot = X_HPOOL_THREAD_NONE;
+  }
+
+  static int64_t s_hpool_pack_top(uint32_t version, uint32_t index)
+  {
+    return (int64_t)(((uint64_t)version << 32) | (uint64_t)index);
+  }
+
+  static uint32_t s_hpool_load_u32(uint32_t* v)
+  {
+    return (uint32_t)x_atomic_load_i32((volatile int32_t*)v);
+  }
+
+  static void s_hpool_store_u32(uint32_t* v, uint32_t value)
+  {
+    x_atomic_store_i32((volatile int32_t*)v, (int32_t)value);
+  }
+
+  /* Header of a slot whose page may still be missing; NULL if it is */
+  static XHPoolSlotHeader* s_hpool_c_slot_hdr(const XHPool* p, uint32_t index)
+  {
+    uint32_t page_index;
+    uint8_t* base;
+
+    page_index = x_hpool_page_index(p, index);
+    if (page_index >= p->page_cap)
+    {
+      return NULL;
+    }
+
+    base = (uint8_t*)x_atomic_load_ptr((void* volatile*)&p->pages[page_index]);
+    if (base == NULL)
+    {
+      return NULL;
+    }
+
+    return (XHPoolSlotHeader*)(base + (size_t)x_hpool_slot_index(p, index) * x_hpool_slot_stride(p));
+  }
+
+  /* Installs the page holding `index` unless another thread already did */
+  static int s_hpool_c_ensure_page(XHPool* p, uint32_t index)
+  {
+    uint32_t page_index;
+    size_t bytes;
+    uint32_t i;
+    uint8_t* mem;
+
+    page_index = x_hpool_page_index(p, index);
+    if (x_atomic_load_ptr((void* volatile*)&p->pages[page_index]) != NULL)
+    {
+      return 1;
+    }
+
+    bytes = (size_t)p->page_capacity * x_hpool_slot_stride(p);
+    mem = (uint8_t*)X_HPOOL_ALLOC(bytes);
+    if (mem == NULL)
+    {
+      return 0;
+    }
+
+    memset(mem, 0, bytes);
+    for (i = 0u; i < p->page_capacity; i += 1u)
+    {
+      ((XHPoolSlotHeader*)(mem + (size_t)i * x_hpool_slot_stride(p)))->next_free = X_HPOOL_NULL_INDEX;
+    }
+
+    if (!x_atomic_cas_ptr((void* volatile*)&p->pages[page_index], NULL, mem))
+    {
+      X_HPOOL_FREE(mem);
+      return 1;
+    }
+
+    x_atomic_fetch_add_i32((volatile int32_t*)&p->page_count, 1);
+    return 1;
+  }
+
+  /*
+   * Pops the free stack. The head is (version, index) of the top slot, and a
+   * slot only goes back on the stack after a free bumped its version, so a
+   * head that was popped and pushed again in between never compares equal.
+   */
+  static uint32_t s_hpool_c_pop(XHPool* p)
+  {
+    for (;;)
+    {
+      int64_t top;
+      int64_t new_top;
+      uint32_t index;
+      uint32_t next;
+
+      top = x_atomic_load_i64(&p->free_top);
+      index = (uint32_t)top;
+      if (index == X_HPOOL_NULL_INDEX)
+      {
+        return X_HPOOL_NULL_INDEX;
+      }
+
+      next = s_hpool_load_u32(&x_hpool_slot_hdr(p, index)->next_free);
+      if (next == X_HPOOL_NULL_INDEX)
+      {
+        new_top = s_hpool_pack_top(0u, X_HPOOL_NULL_INDEX);
+      }
+      else
+      {
+        new_top = s_hpool_pack_top(s_hpool_load_u32(&x_hpool_slot_hdr(p, next)->version), next);
+      }
+
+      if (x_atomic_cas_i64(&p->free_top, top, new_top))
+      {
+        return index;
+      }
+    }
+  }
+
+  /* Pushes slots[0..count) as one chain with slots[0] on top */
+  static void s_hpool_c_push(XHPool* p, const uint32_t* slots, uint32_t count)
+  {
+    XHPoolSlotHeader* last;
+    int64_t top;
+    int64_t new_top;
+    uint32_t i;
+
+    for (i = 0u; i + 1u < count; i += 1u)
+    {
+      s_hpool_store_u32(&x_hpool_slot_hdr(p, slots[i])->next_free, slots[i + 1u]);
+    }
+
+    last = x_hpool_slot_hdr(p, slots[count - 1u]);
+    new_top = s_hpool_pack_top(s_hpool_load_u32(&x_hpool_slot_hdr(p, slots[0])->version), slots[0]);
+
+    do
+    {
+      top = x_atomic_load_i64(&p->free_top);
+      s_hpool_store_u32(&last->next_free, (uint32_t)top);
+    } while (!x_atomic_cas_i64(&p->free_top, top, new_top));
+  }
+
+  /* Reserves up to `want` never-used indices, all within one page */
+  static uint32_t s_hpool_c_fresh(XHPool* p, uint32_t want, uint32_t* out_count)
+  {
+    uint32_t limit;
+    uint32_t first;
+    uint32_t take;
+
+    limit = p->page_cap * p->page_capacity;
+
+    do
+    {
+      first = s_hpool_load_u32(&p->next_index);
+      if (first >= limit)
+      {
+        return X_HPOOL_NULL_INDEX;
+      }
+
+      take = want;
+      if (take > limit - first)
+      {
+        take = limit - first;
+      }
+      if (take > p->page_capacity - x_hpool_slot_index(p, first))
+      {
+        take = p->page_capacity - x_hpool_slot_index(p, first);
+      }
+    } while (!x_atomic_cas_i32((volatile int32_t*)&p->next_index, (int32_t)first, (int32_t)(first + take)));
+
+    /* On failure the indices are simply never used */
+    if (s_hpool_c_ensure_page(p, first) == 0)
+    {
+      return X_HPOOL_NULL_INDEX;
+    }
+
+    *out_count = take;
+    return first;
+  }
+
+  static XHandle s_hpool_c_alloc(XHPool* p)
+  {
+    XHPoolThreadCache* cache;
+    XHPoolSlotHeader* hdr;
+    uint32_t index;
+    void* item;
+    XHandle h;
+
+    h = x_handle_null();
+    cache = s_hpool_thread_cache(p);
+
+    if (cache != NULL && cache->count > 0u)
+    {
+      cache->count = cache->count - 1u;
+      index = cache->slots[cache->count];
+    }
+    else
+    {
+      /* Slots popped here go straight to the caller, never into a cache: that keeps the stack ABA-free */
+      index = s_hpool_c_pop(p);
+      if (index == X_HPOOL_NULL_INDEX)
+      {
+        uint32_t count;
+        uint32_t i;
+
+        count = 0u;
+        index = s_hpool_c_fresh(p, cache != NULL ? X_HPOOL_THREAD_CACHE_SIZE / 2u : 1u, &count);
+        if (index == X_HPOOL_NULL_INDEX)
+        {
+          return h;
+        }
+
+        for (i = count - 1u; i > 0u; i -= 1u)
+        {
+          cache->slots[cache->count] = index + i;
+          cache->count = cache->count + 1u;
+        }
+      }
+    }
+
+    hdr = x_hpool_slot_hdr(p, index);
+    item = x_hpool_slot_item(p, hdr);
+    if (p->ctor != NULL)
+    {
+      p->ctor(p->user, item);
+    }
+    else
+    {
+      memset(item, 0, p->item_size);
+    }
+
+    /* Publishes the constructed item */
+    s_hpool_store_u32(&hdr->flags, X_POOL_SLOT_ALIVE);
+    x_atomic_fetch_add_i32((volatile int32_t*)&p->alive_count, 1);
+
+    h.index = index;
+    h.version = s_hpool_load_u32(&hdr->version);
+    return h;
+  }
+
+  static void s_hpool_c_free(XHPool* p, XHandle h)
+  {
+    XHPoolThreadCache* cache;
+    XHPoolSlotHeader* hdr;
+    uint32_t next_version;
+
+    hdr = s_hpool_c_slot_hdr(p, h.index);
+    if (hdr == NULL || (s_hpool_load_u32(&hdr->flags) & X_POOL_SLOT_ALIVE) == 0u)
+    {
+      return;
+    }
+
+    next_version = h.version + 1u;
+    if (next_version == 0u)
+    {
+      next_version = 1u;
+    }
+
+    /* Whoever bumps the version owns the free; lookups with the old handle fail from here on */
+    if (!x_atomic_cas_i32((volatile int32_t*)&hdr->version, (int32_t)h.version, (int32_t)next_version))
+    {
+      return;
+    }
+
+    if (p->dtor != NULL)
+    {
+      p->dtor(p->user, x_hpool_slot_item(p, hdr));
+    }
+
+    s_hpool_store_u32(&hdr->flags, 0u);
+    x_atomic_fetch_add_i32((volatile int32_t*)&p->alive_count, -1);
+
+    cache = s_hpool_thread_cache(p);
+    if (cache == NULL)
+    {
+      s_hpool_c_push(p, &h.index, 1u);
+      return;
+    }
+
+    if (cache->count == X_HPOOL_THREAD_CACHE_SIZE)
+    {
+      cache->count = X_HPOOL_THREAD_CACHE_SIZE / 2u;
+      s_hpool_c_push(p, &cache->slots[cache->count], X_HPOOL_THREAD_CACHE_SIZE - cache->count);
+    }
+
+    cache->slots[cache->count] = h.index;
+    cache->count = cache->count + 1u;
+  }
+
+  static void* s_hpool_c_get(XHPool* p, XHandle h)
+  {
+    XHPoolSlotHeader* hdr;
+
+    hdr = s_hpool_c_slot_hdr(p, h.index);
+    if (hdr == NULL)
+    {
+      return NULL;
+    }
+
+    if (s_hpool_load_u32(&hdr->version) != h.version)
+    {
+      return NULL;
+    }
+
+    if ((s_hpool_load_u32(&hdr->flags) & X_POOL_SLOT_ALIVE) == 0u)
+    {
+      return NULL;
+    }
+
+    return x_hpool_slot_item(p, hdr);
+  }
+
+  /* Concurrent mode: positions are slot indices; dead slots yield NULL */
+  static void* s_hpool_c_item_at(XHPool* p, uint32_t index, XHandle* out_h)
+  {
+    XHPoolSlotHeader* hdr;
+
+    hdr = s_hpool_c_slot_hdr(p, index);
+    if (hdr == NULL || (s_hpool_load_u32(&hdr->flags) & X_POOL_SLOT_ALIVE) == 0u)
+    {
+      return NULL;
+    }
+
+    if (out_h != NULL)
+    {
+      out_h->index = index;
+      out_h->version = s_hpool_load_u32(&hdr->version);
+    }
+
+    return x_hpool_slot_item(p, hdr);
+  }
+
+  /* Number of positions the iteration and range helpers walk */
+  static uint32_t s_hpool_position_count(XHPool* p)
+  {
+    uint32_t n;
+
+    if (p->concurrent == 0)
+    {
+      return p->alive_count;
+    }
+
+    n = s_hpool_load_u32(&p->next_index);
+    if (n > p->page_cap * p->page_capacity)
+    {
+      n = p->page_cap * p->page_capacity;
+    }
+    return n;
+  }
+
+  /* Concurrent iteration: next live slot at or after `it->alive_pos` */
+  static void* s_hpool_c_scan(XHPool* p, XHPoolIter* it, XHandle* out_h)
+  {
+    uint32_t end;
+    void* item;
+
+    end = s_hpool_position_count(p);
+    while (it->alive_pos < end)
+    {
+      item = s_hpool_c_item_at(p, it->alive_pos, out_h);
+      if (item != NULL)
+      {
+        return item;
+      }
+      it->alive_pos = it->alive_pos + 1u;
+    }
+
+    return NULL;
+  }
+
   X_HPOOL_API int x_hpool_init(XHPool* p,
       size_t item_size,
       XHPoolConfig cfg,
@@ -584,6 +1148,31 @@ extern "C" {
       return 0;
     }
 
+    if (cfg.layout != XHPOOL_LAYOUT_INTERLEAVED && cfg.layout != XHPOOL_LAYOUT_DENSE)
+    {
+      return 0;
+    }
+
+    if (cfg.concurrent != 0)
+    {
+      if (cfg.layout != XHPOOL_LAYOUT_INTERLEAVED)
+      {
+        return 0;
+      }
+
+      if (cfg.max_pages == 0u)
+      {
+        cfg.max_pages = X_HPOOL_MAX_PAGES;
+      }
+
+      /* Every slot index must fit below X_HPOOL_NULL_INDEX */
+      if ((uint64_t)cfg.max_pages * cfg.page_capacity >= (uint64_t)X_HPOOL_NULL_INDEX ||
+          cfg.initial_pages > cfg.max_pages)
+      {
+        return 0;
+      }
+    }
+
     memset(p, 0, sizeof(*p));
 
     p->item_size = item_size;
@@ -595,6 +1184,28 @@ extern "C" {
     p->ctor = ctor;
     p->dtor = dtor;
     p->user = user;
+    p->layout = cfg.layout;
+    p->concurrent = cfg.concurrent != 0;
+
+    if (p->concurrent != 0)
+    {
+      /* The directory is sized once so readers never see it move */
+      p->pages = (void**)X_HPOOL_ALLOC((size_t)cfg.max_pages * sizeof(void*));
+      p->caches = (XHPoolThreadCache*)X_HPOOL_ALLOC(sizeof(XHPoolThreadCache) * X_HPOOL_THREAD_CACHES);
+      if (p->pages == NULL || p->caches == NULL)
+      {
+        X_HPOOL_FREE(p->pages);
+        X_HPOOL_FREE(p->caches);
+        p->pages = NULL;
+        p->caches = NULL;
+        return 0;
+      }
+
+      memset(p->pages, 0, (size_t)cfg.max_pages * sizeof(void*));
+      memset(p->caches, 0, sizeof(XHPoolThreadCache) * X_HPOOL_THREAD_CACHES);
+      p->page_cap = cfg.max_pages;
+      p->free_top = s_hpool_pack_top(0u, X_HPOOL_NULL_INDEX);
+    }
 
     if (cfg.initial_pages == 0u)
     {
@@ -621,6 +1232,30 @@ extern "C" {
       return;
     }
 
+    if (p->concurrent != 0)
+    {
+      XHPoolIter it;
+      void* item;
+
+      it.alive_pos = 0u;
+      while (p->dtor != NULL && (item = s_hpool_c_scan(p, &it, NULL)) != NULL)
+      {
+        p->dtor(p->user, item);
+        it.alive_pos = it.alive_pos + 1u;
+      }
+
+      /* Pages may have been installed out of order */
+      for (i = 0u; i < p->page_cap; i += 1u)
+      {
+        X_HPOOL_FREE(p->pages[i]);
+      }
+
+      X_HPOOL_FREE(p->pages);
+      X_HPOOL_FREE(p->caches);
+      memset(p, 0, sizeof(*p));
+      return;
+    }
+
     /* call dtors for live items */
     if (p->dtor != NULL)
     {
@@ -642,6 +1277,8 @@ extern "C" {
 
     X_HPOOL_FREE(p->pages);
     X_HPOOL_FREE(p->alive);
+    X_HPOOL_FREE(p->dense);
+    X_HPOOL_FREE(p->dense_version);
 
     memset(p, 0, sizeof(*p));
   }
@@ -663,6 +1300,11 @@ extern "C" {
       return 0u;
     }
 
+    if (p->concurrent != 0)
+    {
+      return s_hpool_load_u32(&p->page_count) * p->page_capacity;
+    }
+
     return p->page_count * p->page_capacity;
   }
 
@@ -673,6 +1315,11 @@ extern "C" {
       return 0u;
     }
 
+    if (p->concurrent != 0)
+    {
+      return s_hpool_load_u32(&p->alive_count);
+    }
+
     return p->alive_count;
   }
 
@@ -690,6 +1337,11 @@ extern "C" {
       return 0;
     }
 
+    if (p->concurrent != 0)
+    {
+      return s_hpool_c_get(p, h) != NULL;
+    }
+
     if (h.index >= x_hpool_capacity(p))
     {
       return 0;
@@ -723,6 +1375,11 @@ extern "C" {
       return NULL;
     }
 
+    if (p->concurrent != 0)
+    {
+      return s_hpool_c_get(p, h);
+    }
+
     if (h.index >= x_hpool_capacity(p))
     {
       return NULL;
@@ -748,6 +1405,12 @@ extern "C" {
 
     X_ASSERT(p != NULL);
     X_ASSERT(x_handle_is_null(h) == 0);
+
+    if (p->concurrent != 0)
+    {
+      return s_hpool_c_get(p, h);
+    }
+
     X_ASSERT(h.index < x_hpool_capacity(p));
 
     hdr = x_hpool_slot_hdr(p, h.index);
@@ -773,6 +1436,11 @@ extern "C" {
       return NULL;
     }
 
+    if (p->concurrent != 0)
+    {
+      return s_hpool_c_item_at(p, index, NULL);
+    }
+
     if (index >= x_hpool_capacity(p))
     {
       return NULL;
@@ -801,6 +1469,11 @@ extern "C" {
       return h;
     }
 
+    if (p->concurrent != 0)
+    {
+      return s_hpool_c_alloc(p);
+    }
+
     if (p->free_head != X_HPOOL_NULL_INDEX)
     {
       index = p->free_head;
@@ -832,6 +1505,9 @@ extern "C" {
       return h;
     }
 
+    /* Join the alive list first: in the dense layout that is what places the item */
+    x_hpool_alive_add(p, index);
+
     item = x_hpool_slot_item(p, hdr);
     if (p->ctor != NULL)
     {
@@ -842,8 +1518,6 @@ extern "C" {
       memset(item, 0, p->item_size);
     }
 
-    x_hpool_alive_add(p, index);
-
     h.index = index;
     h.version = hdr->version;
 
@@ -865,6 +1539,12 @@ extern "C" {
       return;
     }
 
+    if (p->concurrent != 0)
+    {
+      s_hpool_c_free(p, h);
+      return;
+    }
+
     if (h.index >= x_hpool_capacity(p))
     {
       return;
@@ -909,6 +1589,20 @@ extern "C" {
       return;
     }
 
+    if (p->concurrent != 0)
+    {
+      XHPoolIter it;
+      XHandle h;
+
+      it.alive_pos = 0u;
+      while (s_hpool_c_scan(p, &it, &h) != NULL)
+      {
+        x_hpool_free(p, h);
+        it.alive_pos = it.alive_pos + 1u;
+      }
+      return;
+    }
+
     /* Copy count because we mutate alive_count during frees */
     count = p->alive_count;
 
@@ -946,12 +1640,29 @@ extern "C" {
       return NULL;
     }
 
+    if (p->concurrent != 0)
+    {
+      return it != NULL ? s_hpool_c_scan(p, it, out_h) : NULL;
+    }
+
     if (p->alive_count == 0u)
     {
       return NULL;
     }
 
     index = p->alive[0];
+
+    /* Dense layout: item, index and version are linear sweeps; headers stay out of the cache */
+    if (p->layout == XHPOOL_LAYOUT_DENSE)
+    {
+      if (out_h != NULL)
+      {
+        out_h->index = index;
+        out_h->version = p->dense_version[0];
+      }
+      return (void*)p->dense;
+    }
+
     hdr = x_hpool_slot_hdr(p, index);
     item = x_hpool_slot_item(p, hdr);
 
@@ -984,12 +1695,28 @@ extern "C" {
     pos = it->alive_pos + 1u;
     it->alive_pos = pos;
 
+    if (p->concurrent != 0)
+    {
+      return s_hpool_c_scan(p, it, out_h);
+    }
+
     if (pos >= p->alive_count)
     {
       return NULL;
     }
 
     index = p->alive[pos];
+
+    if (p->layout == XHPOOL_LAYOUT_DENSE)
+    {
+      if (out_h != NULL)
+      {
+        out_h->index = index;
+        out_h->version = p->dense_version[pos];
+      }
+      return (void*)(p->dense + (size_t)pos * p->item_size);
+    }
+
     hdr = x_hpool_slot_hdr(p, index);
     item = x_hpool_slot_item(p, hdr);
 
@@ -1002,6 +1729,151 @@ extern "C" {
     return item;
   }
 
+  X_HPOOL_API void* x_hpool_dense_items(XHPool* p)
+  {
+    if (p == NULL || p->layout != XHPOOL_LAYOUT_DENSE)
+    {
+      return NULL;
+    }
+
+    return (void*)p->dense;
+  }
+
+  X_HPOOL_API void* x_hpool_item_at(XHPool* p, uint32_t alive_pos, XHandle* out_h)
+  {
+    uint32_t index;
+    XHPoolSlotHeader* hdr;
+
+    if (p == NULL)
+    {
+      return NULL;
+    }
+
+    if (p->concurrent != 0)
+    {
+      return s_hpool_c_item_at(p, alive_pos, out_h);
+    }
+
+    if (alive_pos >= p->alive_count)
+    {
+      return NULL;
+    }
+
+    index = p->alive[alive_pos];
+
+    if (p->layout == XHPOOL_LAYOUT_DENSE)
+    {
+      if (out_h != NULL)
+      {
+        out_h->index = index;
+        out_h->version = p->dense_version[alive_pos];
+      }
+      return (void*)(p->dense + (size_t)alive_pos * p->item_size);
+    }
+
+    hdr = x_hpool_slot_hdr(p, index);
+    if (out_h != NULL)
+    {
+      out_h->index = index;
+      out_h->version = hdr->version;
+    }
+
+    return x_hpool_slot_item(p, hdr);
+  }
+
+  X_HPOOL_API uint32_t x_hpool_range_count(XHPool* p, uint32_t chunk_size)
+  {
+    if (p == NULL || chunk_size == 0u)
+    {
+      return 0u;
+    }
+
+    return (uint32_t)(((uint64_t)s_hpool_position_count(p) + chunk_size - 1u) / chunk_size);
+  }
+
+  X_HPOOL_API XHPoolRange x_hpool_range(XHPool* p, uint32_t chunk_size, uint32_t chunk_index)
+  {
+    XHPoolRange r;
+    uint32_t count;
+    uint64_t begin;
+    uint64_t end;
+
+    r.begin = 0u;
+    r.end = 0u;
+
+    if (p == NULL || chunk_size == 0u)
+    {
+      return r;
+    }
+
+    count = s_hpool_position_count(p);
+    begin = (uint64_t)chunk_index * chunk_size;
+    if (begin >= count)
+    {
+      return r;
+    }
+
+    end = begin + chunk_size;
+    if (end > count)
+    {
+      end = count;
+    }
+
+    r.begin = (uint32_t)begin;
+    r.end = (uint32_t)end;
+    return r;
+  }
+
+  typedef struct XHPoolParallelJob
+  {
+    XHPool* pool;
+    XHPoolForEachFn fn;
+    void* ctx;
+  } XHPoolParallelJob;
+
+  static void s_hpool_parallel_chunk(int64_t begin, int64_t end, void* arg)
+  {
+    XHPoolParallelJob* job;
+    int64_t pos;
+
+    job = (XHPoolParallelJob*)arg;
+    for (pos = begin; pos < end; pos += 1)
+    {
+      XHandle h;
+      void* item;
+
+      /* Only concurrent pools have dead positions */
+      item = x_hpool_item_at(job->pool, (uint32_t)pos, &h);
+      if (item != NULL)
+      {
+        job->fn(job->ctx, item, h);
+      }
+    }
+  }
+
+  X_HPOOL_API int x_hpool_for_each_parallel(XHPool* p, XThreadPool* pool, XHPoolForEachFn fn, void* ctx)
+  {
+    XHPoolParallelJob job;
+
+    if (p == NULL || fn == NULL)
+    {
+      return 0;
+    }
+
+    job.pool = p;
+    job.fn = fn;
+    job.ctx = ctx;
+
+    /* No pool: same contract, on the calling thread */
+    if (pool == NULL)
+    {
+      s_hpool_parallel_chunk(0, (int64_t)s_hpool_position_count(p), &job);
+      return 1;
+    }
+
+    return x_threadpool_parallel_for(pool, 0, (int64_t)s_hpool_position_count(p), 0, s_hpool_parallel_chunk, &job) == 0 ? 1 : 0;
+  }
+
 
 #ifdef __cplusplus
 }
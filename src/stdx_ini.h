@@ -9,6 +9,16 @@
  * One flat string pool owns all normalized C strings (section names, keys, values).
  * Sections and entries are indexed by arrays for direct and iterative access.
  *
+ * Loading also builds a hash index over section names and (section, key)
+ * pairs, stored at the end of the same pool, so x_ini_get and the typed
+ * getters cost one probe instead of a scan over all entries. The index
+ * keeps the existing lookup rules: the first section with a given name is
+ * the one searched, and within it the last definition of a key wins.
+ *
+ * x_ini_bind fills a struct from a table of XIniField descriptors in one
+ * pass; fields that are missing or do not parse keep their current value,
+ * so the struct can be pre-filled with defaults.
+ *
  * ## How to compile
  *
  * To compile the implementation, define `X_IMPL_INI`
@@ -108,8 +118,41 @@ typedef struct XIni
   int          entries_cap;
   /* bookkeeping */
   int          global_section; // index of the synthetic global section ("")
+  /* hash index, stored in the pool: (hash << 32) | (index + 1), 0 is empty */
+  uint64_t    *section_slots;
+  uint32_t     section_mask;
+  uint64_t    *entry_slots;
+  uint32_t     entry_mask;
 } XIni;
 
+/**
+ * @brief Destination type of a bound field.
+ */
+typedef enum XIniFieldType
+{
+  XINI_FIELD_STR = 0,  /* const char*, points into the ini pool */
+  XINI_FIELD_I32,      /* int32_t */
+  XINI_FIELD_F32,      /* float */
+  XINI_FIELD_BOOL      /* bool */
+} XIniFieldType;
+
+/**
+ * @brief Describes one struct member filled by x_ini_bind.
+ */
+typedef struct XIniField
+{
+  const char   *section;  /* section name, NULL or "" for the global section */
+  const char   *key;
+  XIniFieldType type;
+  size_t        offset;   /* offsetof the member inside the bound struct */
+} XIniField;
+
+/**
+ * @brief Builds an XIniField for member `member` of struct type `type`.
+ */
+#define X_INI_FIELD(section, key, field_type, type, member) \
+  { (section), (key), (field_type), offsetof(type, member) }
+
 /**
 * @brief Load and parse an INI file from disk.
 * @param path Path to the INI file.
@@ -183,6 +226,18 @@ X_INI_API float x_ini_get_f32(const XIni *ini, const char *section, const char *
 */
 X_INI_API bool x_ini_get_bool(const XIni *ini, const char *section, const char *key, bool def_value);
 
+/**
+* @brief Fill struct members from the INI data in a single pass.
+* Fields that are missing or cannot be parsed keep their current value.
+* Consecutive fields of the same section share one section lookup.
+* @param ini Parsed INI data.
+* @param fields Field descriptors, see X_INI_FIELD.
+* @param field_count Number of descriptors.
+* @param out_struct Struct the descriptor offsets refer to.
+* @return Number of fields that were found and assigned.
+*/
+X_INI_API int x_ini_bind(const XIni *ini, const XIniField *fields, int field_count, void *out_struct);
+
 /**
 * @brief Get the number of sections in the INI data.
 * @param ini Parsed INI data.
@@ -236,6 +291,15 @@ X_INI_API const char* x_ini_value_at(const XIni *ini, int section_index, int key
 #include <stdio.h>
 #include <ctype.h>
 
+#ifdef X_PROFILE_LIBRARY
+#include "stdx_profile.h"
+#define X_INI_PROFILE_BEGIN(name) X_PROFILE_BEGIN(name)
+#define X_INI_PROFILE_END() X_PROFILE_END()
+#else
+#define X_INI_PROFILE_BEGIN(name) ((void)0)
+#define X_INI_PROFILE_END() ((void)0)
+#endif
+
 /* Allocator override */
 
 #ifndef X_INI_ALLOC
@@ -376,7 +440,32 @@ static void s_x_chomp_inline_comment_unquoted(char *s)
   }
 }
 
-static int s_x_find_section(const XIni *ini, const char *section)
+/* FNV-1a */
+static uint32_t s_x_hash_str(const char *s, uint32_t seed)
+{
+  uint32_t h = 2166136261u ^ seed;
+  while (*s)
+  {
+    h ^= (uint8_t)*s++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/* the entry hash mixes in the section index so equal keys in different sections spread */
+static uint32_t s_x_entry_hash(int section, const char *key)
+{
+  return s_x_hash_str(key, (uint32_t)section * 0x9E3779B1u);
+}
+
+static uint32_t s_x_index_cap(int count)
+{
+  uint32_t cap = 16;
+  while (cap < (uint32_t)count * 2u) cap <<= 1;
+  return cap;
+}
+
+static int s_x_find_section_linear(const XIni *ini, const char *section)
 {
   for (int i = 0; i < ini->sections_count; ++i)
   {
@@ -385,6 +474,110 @@ static int s_x_find_section(const XIni *ini, const char *section)
   return -1;
 }
 
+static int s_x_find_section(const XIni *ini, const char *section)
+{
+  if (!ini->section_slots) return s_x_find_section_linear(ini, section);
+
+  uint32_t h = s_x_hash_str(section, 0);
+  for (uint32_t i = h & ini->section_mask;; i = (i + 1) & ini->section_mask)
+  {
+    uint64_t slot = ini->section_slots[i];
+    if (!slot) return -1;
+    int idx = (int)(uint32_t)slot - 1;
+    if ((uint32_t)(slot >> 32) == h && strcmp(ini->sections[idx].name, section) == 0) return idx;
+  }
+}
+
+static const XIniEntry *s_x_find_entry(const XIni *ini, int section, const char *key)
+{
+  if (!ini->entry_slots)
+  {
+    /* last definition wins -> iterate from the end */
+    for (int i = ini->entries_count - 1; i >= 0; --i)
+    {
+      const XIniEntry *e = &ini->entries[i];
+      if (e->section == section && strcmp(e->key, key) == 0) return e;
+    }
+    return NULL;
+  }
+
+  uint32_t h = s_x_entry_hash(section, key);
+  for (uint32_t i = h & ini->entry_mask;; i = (i + 1) & ini->entry_mask)
+  {
+    uint64_t slot = ini->entry_slots[i];
+    if (!slot) return NULL;
+    const XIniEntry *e = &ini->entries[(uint32_t)slot - 1];
+    if ((uint32_t)(slot >> 32) == h && e->section == section && strcmp(e->key, key) == 0) return e;
+  }
+}
+
+/* Appends the index to the pool. If the pool has to move, every string
+   pointer handed out so far is rebased onto the new block. */
+static bool s_x_build_index(XIni *ini)
+{
+  uint32_t scap = s_x_index_cap(ini->sections_count);
+  uint32_t ecap = s_x_index_cap(ini->entries_count);
+  size_t at = (ini->pool_size + 7u) & ~(size_t)7u;
+  size_t need = at + ((size_t)scap + ecap) * sizeof(uint64_t);
+
+  if (need > ini->pool_cap)
+  {
+    uintptr_t old_base = (uintptr_t)ini->pool;
+    char *np = (char *)X_INI_REALLOC(ini->pool, need);
+    if (!np) return false;
+    ini->pool = np;
+    ini->pool_cap = need;
+
+    if ((uintptr_t)np != old_base)
+    {
+      for (int i = 0; i < ini->sections_count; ++i)
+        ini->sections[i].name = np + ((uintptr_t)ini->sections[i].name - old_base);
+      for (int i = 0; i < ini->entries_count; ++i)
+      {
+        ini->entries[i].key = np + ((uintptr_t)ini->entries[i].key - old_base);
+        ini->entries[i].value = np + ((uintptr_t)ini->entries[i].value - old_base);
+      }
+    }
+  }
+
+  ini->section_slots = (uint64_t *)(void *)(ini->pool + at);
+  ini->section_mask = scap - 1u;
+  ini->entry_slots = ini->section_slots + scap;
+  ini->entry_mask = ecap - 1u;
+  memset(ini->section_slots, 0, ((size_t)scap + ecap) * sizeof(uint64_t));
+
+  /* the first section with a name is the one lookups see */
+  for (int s = 0; s < ini->sections_count; ++s)
+  {
+    uint32_t h = s_x_hash_str(ini->sections[s].name, 0);
+    for (uint32_t i = h & ini->section_mask;; i = (i + 1) & ini->section_mask)
+    {
+      uint64_t slot = ini->section_slots[i];
+      if (!slot) { ini->section_slots[i] = ((uint64_t)h << 32) | (uint32_t)(s + 1); break; }
+      if ((uint32_t)(slot >> 32) == h && strcmp(ini->sections[(uint32_t)slot - 1].name, ini->sections[s].name) == 0) break;
+    }
+  }
+
+  /* a later definition of the same (section, key) replaces the earlier one */
+  for (int e = 0; e < ini->entries_count; ++e)
+  {
+    const XIniEntry *cur = &ini->entries[e];
+    uint32_t h = s_x_entry_hash(cur->section, cur->key);
+    for (uint32_t i = h & ini->entry_mask;; i = (i + 1) & ini->entry_mask)
+    {
+      uint64_t slot = ini->entry_slots[i];
+      const XIniEntry *old = slot ? &ini->entries[(uint32_t)slot - 1] : NULL;
+      if (!slot || ((uint32_t)(slot >> 32) == h && old->section == cur->section && strcmp(old->key, cur->key) == 0))
+      {
+        ini->entry_slots[i] = ((uint64_t)h << 32) | (uint32_t)(e + 1);
+        break;
+      }
+    }
+  }
+
+  return true;
+}
+
 static int s_x_count_keys_in_section(const XIni *ini, int section_index)
 {
   int c = 0;
@@ -475,7 +668,7 @@ X_INI_API const char* x_ini_err_str(XIniErrorCode code)
   return s_x_err_msg(code);
 }
 
-X_INI_API bool x_ini_load_mem(const void *data, size_t size, XIni *out_ini, XIniError *err)
+static bool s_x_ini_load_mem(const void *data, size_t size, XIni *out_ini, XIniError *err)
 {
   if (err) { err->code = XINI_OK; err->line = 0; err->column = 0; err->message = s_x_err_msg(XINI_OK); }
   if (!out_ini) { s_x_set_err(err, XINI_ERR_SYNTAX, 0, 0, "null output ini"); return false; }
@@ -658,9 +851,24 @@ X_INI_API bool x_ini_load_mem(const void *data, size_t size, XIni *out_ini, XIni
   }
 
   X_INI_FREE(buf);
+
+  if (!s_x_build_index(out_ini))
+  {
+    s_x_set_err(err, XINI_ERR_MEMORY, 0, 0, s_x_err_msg(XINI_ERR_MEMORY));
+    x_ini_free(out_ini);
+    return false;
+  }
   return true;
 }
 
+X_INI_API bool x_ini_load_mem(const void *data, size_t size, XIni *out_ini, XIniError *err)
+{
+  X_INI_PROFILE_BEGIN("x_ini_load_mem");
+  bool ok = s_x_ini_load_mem(data, size, out_ini, err);
+  X_INI_PROFILE_END();
+  return ok;
+}
+
 X_INI_API bool x_ini_load_file(const char *path, XIni *out_ini, XIniError *err)
 {
   if (err) { err->code = XINI_OK; err->line = 0; err->column = 0; err->message = s_x_err_msg(XINI_OK); }
@@ -712,40 +920,30 @@ X_INI_API const char *x_ini_get(const XIni *ini, const char *section, const char
   int sidx = s_x_find_section(ini, secname);
   if (sidx < 0) return def_value;
 
-  /* last definition wins -> iterate from the end */
-  for (int i = ini->entries_count - 1; i >= 0; --i)
-  {
-    const XIniEntry *e = &ini->entries[i];
-    if (e->section == sidx && strcmp(e->key, key) == 0) return e->value;
-  }
-  return def_value;
+  const XIniEntry *e = s_x_find_entry(ini, sidx, key);
+  return e ? e->value : def_value;
 }
 
-X_INI_API int32_t x_ini_get_i32(const XIni *ini, const char *section, const char *key, int32_t def_value)
+static bool s_x_parse_i32(const char *s, int32_t *out)
 {
-  const char *s = x_ini_get(ini, section, key, NULL);
-  if (!s) return def_value;
   char *end = NULL;
   long v = strtol(s, &end, 0);
-  if (end == s) return def_value;
-  return (int32_t)v;
+  if (end == s) return false;
+  *out = (int32_t)v;
+  return true;
 }
 
-X_INI_API float x_ini_get_f32(const XIni *ini, const char *section, const char *key, float def_value)
+static bool s_x_parse_f32(const char *s, float *out)
 {
-  const char *s = x_ini_get(ini, section, key, NULL);
-  if (!s) return def_value;
   char *end = NULL;
   float v = (float)strtod(s, &end);
-  if (end == s) return def_value;
-  return v;
+  if (end == s) return false;
+  *out = v;
+  return true;
 }
 
-X_INI_API bool x_ini_get_bool(const XIni *ini, const char *section, const char *key, bool def_value)
+static bool s_x_parse_bool(const char *s, bool *out)
 {
-  const char *s = x_ini_get(ini, section, key, NULL);
-  if (!s) return def_value;
-
   /* case-insensitive checks for common forms */
   char c0 = (char)tolower((unsigned char)s[0]);
   if ((c0 == 't' && s_x_stricmp(s, "true")  == 0) ||
@@ -753,6 +951,7 @@ X_INI_API bool x_ini_get_bool(const XIni *ini, const char *section, const char *
       (c0 == 'o' && s_x_stricmp(s, "on")    == 0) ||
       (c0 == '1' && s[1] == '\0'))
   {
+    *out = true;
     return true;
   }
   if ((c0 == 'f' && s_x_stricmp(s, "false") == 0) ||
@@ -760,9 +959,77 @@ X_INI_API bool x_ini_get_bool(const XIni *ini, const char *section, const char *
       (c0 == 'o' && s_x_stricmp(s, "off")   == 0) ||
       (c0 == '0' && s[1] == '\0'))
   {
-    return false;
+    *out = false;
+    return true;
+  }
+  return false;
+}
+
+X_INI_API int32_t x_ini_get_i32(const XIni *ini, const char *section, const char *key, int32_t def_value)
+{
+  const char *s = x_ini_get(ini, section, key, NULL);
+  int32_t v = def_value;
+  if (s) s_x_parse_i32(s, &v);
+  return v;
+}
+
+X_INI_API float x_ini_get_f32(const XIni *ini, const char *section, const char *key, float def_value)
+{
+  const char *s = x_ini_get(ini, section, key, NULL);
+  float v = def_value;
+  if (s) s_x_parse_f32(s, &v);
+  return v;
+}
+
+X_INI_API bool x_ini_get_bool(const XIni *ini, const char *section, const char *key, bool def_value)
+{
+  const char *s = x_ini_get(ini, section, key, NULL);
+  bool v = def_value;
+  if (s) s_x_parse_bool(s, &v);
+  return v;
+}
+
+X_INI_API int x_ini_bind(const XIni *ini, const XIniField *fields, int field_count, void *out_struct)
+{
+  if (!ini || !fields || !out_struct) return 0;
+
+  char *base = (char *)out_struct;
+  const char *last_name = NULL;
+  int sidx = -1;
+  int found = 0;
+
+  for (int i = 0; i < field_count; ++i)
+  {
+    const XIniField *f = &fields[i];
+    if (!f->key) continue;
+
+    const char *secname = f->section ? f->section : "";
+    if (!last_name || (secname != last_name && strcmp(secname, last_name) != 0))
+    {
+      sidx = s_x_find_section(ini, secname);
+      last_name = secname;
+    }
+    if (sidx < 0) continue;
+
+    const XIniEntry *e = s_x_find_entry(ini, sidx, f->key);
+    if (!e) continue;
+
+    void *dst = base + f->offset;
+    bool ok = false;
+    switch (f->type)
+    {
+      case XINI_FIELD_STR:
+        *(const char **)dst = e->value;
+        ok = true;
+        break;
+      case XINI_FIELD_I32:  ok = s_x_parse_i32(e->value, (int32_t *)dst); break;
+      case XINI_FIELD_F32:  ok = s_x_parse_f32(e->value, (float *)dst);   break;
+      case XINI_FIELD_BOOL: ok = s_x_parse_bool(e->value, (bool *)dst);   break;
+      default: break;
+    }
+    if (ok) ++found;
   }
-  return def_value;
+  return found;
 }
 
 X_INI_API int x_ini_section_count(const XIni *ini)
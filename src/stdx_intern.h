@@ -0,0 +1,540 @@
+/**
+ * STDX - String Interning
+ * Part of the STDX General Purpose C Library by marciovmf
+ * License: MIT
+ * <https://github.com/marciovmf/stdx>
+ *
+ * ## Overview
+ *
+ * An intern pool maps strings to small integer ids (`XAtom`). Interning the
+ * same bytes twice returns the same atom, so identifiers can be compared
+ * with `==`, stored in 4 bytes and used as hashtable keys without hashing
+ * or comparing the string again.
+ *
+ * - Each distinct string is copied once into an arena owned by the pool
+ *   and stays valid, null-terminated, until the pool is destroyed.
+ * - Atoms are dense: the first string interned is atom 1, the next 2, and
+ *   so on. `X_ATOM_NONE` (0) is never a valid atom.
+ * - Hash and length are computed once and kept next to the string, so
+ *   `x_atom_hash()` and `x_atom_length()` are array reads.
+ * - `x_intern()` is lookup-or-insert in one probe sequence: the probe that
+ *   misses stops at the empty slot the new atom goes into.
+ * - The table grows by rehashing the stored hashes; strings are never
+ *   hashed twice.
+ *
+ * ## Concurrent mode
+ *
+ * Pass `X_INTERN_CONCURRENT` to `x_intern_create_ex()` to share one pool
+ * between threads (parallel parsers). Lookups of strings already in the
+ * pool never lock. Inserts take one mutex and re-check before adding.
+ * Slot arrays replaced by growth are kept until the pool is destroyed,
+ * since a reader may still be probing one; that costs at most as much
+ * memory again as the final table. Atoms and the strings behind them can
+ * be passed freely between threads.
+ *
+ * ## Atom-keyed hashtables
+ *
+ * Atoms are plain `uint32_t`, so `X_HASHTABLE_TYPE(XAtom, V)` (or any of
+ * the hashtable typed macros) gives a table that hashes and compares 4
+ * bytes instead of a string.
+ *
+ * ## How to compile
+ *
+ * To compile the implementation define `X_IMPL_INTERN`
+ * in **one** source file before including this header.
+ *
+ * To customize how this module allocates memory, define
+ * `X_INTERN_ALLOC` / `X_INTERN_FREE` before including.
+ *
+ * ## Dependencies
+ *
+ *  stdx_arena.h (string storage, implementation required)
+ *  stdx_hashtable.h (x_hashtable_hash_bytes, implementation required)
+ *  stdx_string.h (XSlice)
+ *  stdx_thread.h (mutex and atomics for concurrent mode, implementation required)
+ *
+ */
+
+#ifndef X_INTERN_H
+#define X_INTERN_H
+
+#include "stdx_arena.h"
+#include "stdx_hashtable.h"
+#include "stdx_string.h"
+#include "stdx_thread.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef X_INTERN_API
+#define X_INTERN_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define X_INTERN_VERSION_MAJOR 1
+#define X_INTERN_VERSION_MINOR 0
+#define X_INTERN_VERSION_PATCH 0
+
+#define X_INTERN_VERSION (X_INTERN_VERSION_MAJOR * 10000 + X_INTERN_VERSION_MINOR * 100 + X_INTERN_VERSION_PATCH)
+
+#ifndef X_INTERN_PAGE_SIZE
+/**
+ * @brief Atoms per page of the atom directory. Must be a power of two.
+ * Can be overriden before including this header.
+ */
+#define X_INTERN_PAGE_SIZE 1024
+#endif
+
+#ifndef X_INTERN_MAX_PAGES
+/**
+ * @brief Pages in the atom directory; a pool holds at most
+ * X_INTERN_PAGE_SIZE * X_INTERN_MAX_PAGES - 1 atoms.
+ * Can be overriden before including this header.
+ */
+#define X_INTERN_MAX_PAGES 4096
+#endif
+
+#ifndef X_INTERN_ARENA_CHUNK_SIZE
+/**
+ * @brief Chunk size of the arena that stores the interned bytes.
+ * Can be overriden before including this header.
+ */
+#define X_INTERN_ARENA_CHUNK_SIZE (16 * 1024)
+#endif
+
+  typedef uint32_t XAtom;
+
+  /** @brief The atom that no string maps to. */
+#define X_ATOM_NONE ((XAtom)0)
+
+  typedef enum
+  {
+    X_INTERN_DEFAULT    = 0,
+    X_INTERN_CONCURRENT = 1 << 0,  /* lock-free lookups, locked inserts, usable from any thread */
+  } XInternFlags;
+
+  typedef struct XIntern XIntern;
+
+  /**
+   * @brief Create a single-threaded intern pool.
+   * @return Pointer to the new pool, or NULL on failure.
+   */
+  X_INTERN_API XIntern* x_intern_create(void);
+
+  /**
+   * @brief Create an intern pool.
+   * @param flags Combination of XInternFlags.
+   * @param initial_capacity Strings the pool can hold before its table first grows (0 for a default).
+   * @return Pointer to the new pool, or NULL on failure.
+   */
+  X_INTERN_API XIntern* x_intern_create_ex(uint32_t flags, size_t initial_capacity);
+
+  /**
+   * @brief Destroy a pool, its table and every interned string.
+   * @param pool Pool to destroy (may be NULL).
+   */
+  X_INTERN_API void x_intern_destroy(XIntern* pool);
+
+  /**
+   * @brief Return the atom for a string, adding the string if it is new.
+   * @param pool Intern pool.
+   * @param str Bytes to intern; need not be null-terminated and may be empty.
+   * @return The atom, or X_ATOM_NONE if the pool is full or out of memory.
+   */
+  X_INTERN_API XAtom x_intern(XIntern* pool, XSlice str);
+
+  /**
+   * @brief Intern a null-terminated string (see x_intern()).
+   * @param pool Intern pool.
+   * @param cstr String to intern.
+   * @return The atom, or X_ATOM_NONE on failure.
+   */
+  X_INTERN_API XAtom x_intern_cstr(XIntern* pool, const char* cstr);
+
+  /**
+   * @brief Return the atom for a string without adding it.
+   * @param pool Intern pool.
+   * @param str Bytes to look up.
+   * @return The atom, or X_ATOM_NONE if the string was never interned.
+   */
+  X_INTERN_API XAtom x_intern_find(XIntern* pool, XSlice str);
+
+  /**
+   * @brief Number of distinct strings in the pool.
+   * @param pool Intern pool.
+   * @return Number of atoms issued.
+   */
+  X_INTERN_API uint32_t x_intern_count(const XIntern* pool);
+
+  /**
+   * @brief The null-terminated string behind an atom.
+   * @param pool Pool that issued the atom.
+   * @param atom Atom to resolve.
+   * @return The string, valid until the pool is destroyed, or NULL for an invalid atom.
+   */
+  X_INTERN_API const char* x_atom_cstr(const XIntern* pool, XAtom atom);
+
+  /**
+   * @brief The string behind an atom as a slice.
+   * @param pool Pool that issued the atom.
+   * @param atom Atom to resolve.
+   * @return The string, or an empty slice for an invalid atom.
+   */
+  X_INTERN_API XSlice x_atom_slice(const XIntern* pool, XAtom atom);
+
+  /**
+   * @brief Length in bytes of the string behind an atom.
+   * @param pool Pool that issued the atom.
+   * @param atom Atom to resolve.
+   * @return Length, or 0 for an invalid atom.
+   */
+  X_INTERN_API uint32_t x_atom_length(const XIntern* pool, XAtom atom);
+
+  /**
+   * @brief Hash of the string behind an atom, computed when it was interned.
+   * @param pool Pool that issued the atom.
+   * @param atom Atom to resolve.
+   * @return 32-bit hash, or 0 for an invalid atom.
+   */
+  X_INTERN_API uint32_t x_atom_hash(const XIntern* pool, XAtom atom);
+
+  /**
+   * @brief Compare two atoms of the same pool: equal atoms mean equal strings.
+   */
+  static inline bool x_atom_eq(XAtom a, XAtom b) { return a == b; }
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef X_IMPL_INTERN
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef X_INTERN_ALLOC
+/**
+ * @brief Internal macro for allocating memory.
+ * To override how this header allocates memory, define this macro with a
+ * different implementation before including this header.
+ * @param sz  The size of memory to alloc.
+ */
+#define X_INTERN_ALLOC(sz) malloc(sz)
+#endif
+
+#ifndef X_INTERN_FREE
+/**
+ * @brief Internal macro for freeing memory.
+ * To override how this header frees memory, define this macro with a
+ * different implementation before including this header.
+ * @param p  The address of memory region to free.
+ */
+#define X_INTERN_FREE(p) free(p)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  typedef struct
+  {
+    const char* ptr;
+    uint32_t    length;
+    uint32_t    hash;
+  } XInternEntry;
+
+  /*
+   * Open addressing with linear probing. A slot holds (hash << 32) | atom,
+   * 0 when empty, so most misses are rejected without touching the entry.
+   */
+  typedef struct XInternTable
+  {
+    volatile int64_t*    slots;
+    size_t               mask;      /* capacity - 1 */
+    struct XInternTable* retired;   /* older tables kept alive in concurrent mode */
+  } XInternTable;
+
+  struct XIntern
+  {
+    XArena*                 arena;    /* string bytes */
+    XInternEntry**          pages;    /* X_INTERN_MAX_PAGES pages of X_INTERN_PAGE_SIZE entries */
+    XInternTable* volatile  table;
+    volatile int32_t        count;    /* atoms issued; atom n lives at entry n */
+    XMutex*                 lock;     /* NULL unless X_INTERN_CONCURRENT */
+  };
+
+  static XInternTable* s_intern_table_create(size_t capacity)
+  {
+    XInternTable* t = (XInternTable*)X_INTERN_ALLOC(sizeof(XInternTable));
+    if (!t)
+      return NULL;
+    t->slots = (volatile int64_t*)X_INTERN_ALLOC(capacity * sizeof(int64_t));
+    if (!t->slots)
+    {
+      X_INTERN_FREE(t);
+      return NULL;
+    }
+    memset((void*)t->slots, 0, capacity * sizeof(int64_t));
+    t->mask = capacity - 1;
+    t->retired = NULL;
+    return t;
+  }
+
+  static void s_intern_table_free(XInternTable* t)
+  {
+    while (t)
+    {
+      XInternTable* next = t->retired;
+      X_INTERN_FREE((void*)t->slots);
+      X_INTERN_FREE(t);
+      t = next;
+    }
+  }
+
+  static inline const XInternEntry* s_intern_entry(const XIntern* pool, XAtom atom)
+  {
+    return &pool->pages[atom / X_INTERN_PAGE_SIZE][atom % X_INTERN_PAGE_SIZE];
+  }
+
+  static inline uint32_t s_intern_hash(const char* ptr, size_t length)
+  {
+    uint64_t h = (uint64_t)x_hashtable_hash_bytes(ptr, length);
+    return (uint32_t)(h ^ (h >> 32));
+  }
+
+  /*
+   * Probe for a string. Returns its atom, or X_ATOM_NONE with *out_slot set
+   * to the empty slot that ended the probe.
+   */
+  static XAtom s_intern_probe(const XIntern* pool, const XInternTable* t, const char* ptr, uint32_t length, uint32_t hash, size_t* out_slot)
+  {
+    size_t i = hash & t->mask;
+    for (;;)
+    {
+      int64_t slot = x_atomic_load_acquire_i64(&t->slots[i]);
+      if (slot == 0)
+      {
+        if (out_slot) *out_slot = i;
+        return X_ATOM_NONE;
+      }
+      if ((uint32_t)((uint64_t)slot >> 32) == hash)
+      {
+        XAtom atom = (XAtom)slot;
+        const XInternEntry* e = s_intern_entry(pool, atom);
+        if (e->length == length && memcmp(e->ptr, ptr, length) == 0)
+          return atom;
+      }
+      i = (i + 1) & t->mask;
+    }
+  }
+
+  /* Doubles the table. Only stored hashes are read; no string is rehashed. */
+  static bool s_intern_grow(XIntern* pool)
+  {
+    XInternTable* old = pool->table;
+    size_t capacity = (old->mask + 1) * 2;
+    XInternTable* t = s_intern_table_create(capacity);
+    if (!t)
+      return false;
+    for (size_t i = 0; i <= old->mask; i++)
+    {
+      int64_t slot = old->slots[i];
+      if (slot == 0)
+        continue;
+      size_t j = (size_t)((uint64_t)slot >> 32) & t->mask;
+      while (t->slots[j] != 0)
+        j = (j + 1) & t->mask;
+      t->slots[j] = slot;
+    }
+
+    if (pool->lock)
+    {
+      // Readers may still be probing the old table
+      t->retired = old;
+      x_atomic_store_ptr((void* volatile*)&pool->table, t);
+    }
+    else
+    {
+      pool->table = t;
+      s_intern_table_free(old);
+    }
+    return true;
+  }
+
+  static XAtom s_intern_insert(XIntern* pool, const char* ptr, uint32_t length, uint32_t hash)
+  {
+    XInternTable* t = pool->table;
+    size_t slot_index = 0;
+    XAtom atom = s_intern_probe(pool, t, ptr, length, hash, &slot_index);
+    if (atom != X_ATOM_NONE)
+      return atom;
+
+    uint32_t next = (uint32_t)pool->count + 1;
+    if (next >= (uint32_t)X_INTERN_PAGE_SIZE * X_INTERN_MAX_PAGES)
+      return X_ATOM_NONE;
+
+    // Keep the load factor under 3/4
+    if ((size_t)next * 4 > (t->mask + 1) * 3)
+    {
+      if (!s_intern_grow(pool))
+        return X_ATOM_NONE;
+      t = pool->table;
+      s_intern_probe(pool, t, ptr, length, hash, &slot_index);
+    }
+
+    XInternEntry* page = pool->pages[next / X_INTERN_PAGE_SIZE];
+    if (!page)
+    {
+      page = (XInternEntry*)X_INTERN_ALLOC(X_INTERN_PAGE_SIZE * sizeof(XInternEntry));
+      if (!page)
+        return X_ATOM_NONE;
+      pool->pages[next / X_INTERN_PAGE_SIZE] = page;
+    }
+
+    char* copy = x_arena_slicedup(pool->arena, ptr, length, true);
+    if (!copy)
+      return X_ATOM_NONE;
+
+    XInternEntry* e = &page[next % X_INTERN_PAGE_SIZE];
+    e->ptr = copy;
+    e->length = length;
+    e->hash = hash;
+
+    // The entry is complete before the slot that leads to it is visible
+    x_atomic_store_i32(&pool->count, (int32_t)next);
+    x_atomic_store_release_i64(&t->slots[slot_index], (int64_t)(((uint64_t)hash << 32) | next));
+    return (XAtom)next;
+  }
+
+  X_INTERN_API XIntern* x_intern_create(void)
+  {
+    return x_intern_create_ex(X_INTERN_DEFAULT, 0);
+  }
+
+  X_INTERN_API XIntern* x_intern_create_ex(uint32_t flags, size_t initial_capacity)
+  {
+    size_t capacity = 64;
+    while (capacity * 3 < initial_capacity * 4)
+      capacity *= 2;
+
+    XIntern* pool = (XIntern*)X_INTERN_ALLOC(sizeof(XIntern));
+    if (!pool)
+      return NULL;
+    memset(pool, 0, sizeof(*pool));
+
+    pool->pages = (XInternEntry**)X_INTERN_ALLOC(X_INTERN_MAX_PAGES * sizeof(XInternEntry*));
+    pool->arena = x_arena_create(X_INTERN_ARENA_CHUNK_SIZE);
+    pool->table = s_intern_table_create(capacity);
+    if (!pool->pages || !pool->arena || !pool->table
+        || ((flags & X_INTERN_CONCURRENT) && x_thread_mutex_init(&pool->lock) != 0))
+    {
+      x_intern_destroy(pool);
+      return NULL;
+    }
+    memset(pool->pages, 0, X_INTERN_MAX_PAGES * sizeof(XInternEntry*));
+    return pool;
+  }
+
+  X_INTERN_API void x_intern_destroy(XIntern* pool)
+  {
+    if (!pool)
+      return;
+    if (pool->pages)
+    {
+      for (size_t i = 0; i < X_INTERN_MAX_PAGES; i++)
+      {
+        if (pool->pages[i])
+          X_INTERN_FREE(pool->pages[i]);
+      }
+      X_INTERN_FREE(pool->pages);
+    }
+    if (pool->arena)
+      x_arena_destroy(pool->arena);
+    if (pool->table)
+      s_intern_table_free(pool->table);
+    if (pool->lock)
+      x_thread_mutex_destroy(pool->lock);
+    X_INTERN_FREE(pool);
+  }
+
+  X_INTERN_API XAtom x_intern(XIntern* pool, XSlice str)
+  {
+    if (!pool || (!str.ptr && str.length) || str.length > UINT32_MAX)
+      return X_ATOM_NONE;
+    const char* ptr = str.ptr ? str.ptr : "";
+    uint32_t length = (uint32_t)str.length;
+    uint32_t hash = s_intern_hash(ptr, length);
+
+    if (!pool->lock)
+      return s_intern_insert(pool, ptr, length, hash);
+
+    // Strings already in the pool are found without the lock
+    XInternTable* t = (XInternTable*)x_atomic_load_ptr((void* volatile*)&pool->table);
+    XAtom atom = s_intern_probe(pool, t, ptr, length, hash, NULL);
+    if (atom != X_ATOM_NONE)
+      return atom;
+
+    x_thread_mutex_lock(pool->lock);
+    atom = s_intern_insert(pool, ptr, length, hash);
+    x_thread_mutex_unlock(pool->lock);
+    return atom;
+  }
+
+  X_INTERN_API XAtom x_intern_cstr(XIntern* pool, const char* cstr)
+  {
+    if (!cstr)
+      return X_ATOM_NONE;
+    return x_intern(pool, x_slice_init(cstr, strlen(cstr)));
+  }
+
+  X_INTERN_API XAtom x_intern_find(XIntern* pool, XSlice str)
+  {
+    if (!pool || (!str.ptr && str.length) || str.length > UINT32_MAX)
+      return X_ATOM_NONE;
+    const char* ptr = str.ptr ? str.ptr : "";
+    XInternTable* t = pool->lock ? (XInternTable*)x_atomic_load_ptr((void* volatile*)&pool->table) : pool->table;
+    return s_intern_probe(pool, t, ptr, (uint32_t)str.length, s_intern_hash(ptr, str.length), NULL);
+  }
+
+  X_INTERN_API uint32_t x_intern_count(const XIntern* pool)
+  {
+    return pool ? (uint32_t)x_atomic_load_i32((volatile int32_t*)&pool->count) : 0;
+  }
+
+  static inline bool s_intern_valid(const XIntern* pool, XAtom atom)
+  {
+    return pool && atom != X_ATOM_NONE && atom <= x_intern_count(pool);
+  }
+
+  X_INTERN_API const char* x_atom_cstr(const XIntern* pool, XAtom atom)
+  {
+    return s_intern_valid(pool, atom) ? s_intern_entry(pool, atom)->ptr : NULL;
+  }
+
+  X_INTERN_API XSlice x_atom_slice(const XIntern* pool, XAtom atom)
+  {
+    if (!s_intern_valid(pool, atom))
+      return x_slice_init(NULL, 0);
+    const XInternEntry* e = s_intern_entry(pool, atom);
+    return x_slice_init(e->ptr, e->length);
+  }
+
+  X_INTERN_API uint32_t x_atom_length(const XIntern* pool, XAtom atom)
+  {
+    return s_intern_valid(pool, atom) ? s_intern_entry(pool, atom)->length : 0;
+  }
+
+  X_INTERN_API uint32_t x_atom_hash(const XIntern* pool, XAtom atom)
+  {
+    return s_intern_valid(pool, atom) ? s_intern_entry(pool, atom)->hash : 0;
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* X_IMPL_INTERN */
+#endif /* X_INTERN_H */
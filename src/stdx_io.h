@@ -15,7 +15,36 @@
  *
  * To customize how this module allocates memory, define
  * `X_IO_ALLOC` / `X_IO_FREE` before including.
- * 
+ *
+ * ## Gather writes
+ *
+ * `x_io_writev()` writes a list of `XSlice`s in order with as few system
+ * calls as possible (writev on POSIX), so output assembled from several
+ * buffers, such as XStrBuilder segments, never gets concatenated first.
+ *
+ * ## Memory-mapped files
+ *
+ * `x_io_map()` maps a whole file read-only (mmap, or CreateFileMapping on
+ * Windows) so parsers that take `(buf, size)` read straight from the page
+ * cache instead of a malloc'd copy. The flags are access hints:
+ * `X_IO_MAP_SEQUENTIAL` / `X_IO_MAP_RANDOM` (madvise, or the matching
+ * CreateFile flags) and `X_IO_MAP_WILLNEED` (madvise, or
+ * PrefetchVirtualMemory) to start reading ahead right away. The mapped
+ * bytes are **not** NUL-terminated. An empty file maps to `data == NULL`
+ * and `size == 0`.
+ *
+ * ## Streaming
+ *
+ * `XReader` and `XWriter` put one large, caller-sized buffer in front of
+ * an `XFile` so huge files are processed in constant memory with one read
+ * or write per buffer. `x_reader_next_line()` / `x_reader_next_record()`
+ * return slices that point into the reader buffer, valid until the next
+ * call on the reader. A line longer than the buffer grows it.
+ * `x_reader_peek()` / `x_reader_consume()` let parsers look ahead before
+ * committing to what they read.
+ *
+ * ## Dependencies
+ *  stdx_string.h (for XSlice only; the implementation is not required).
  */
 #ifndef X_IO_H
 #define X_IO_H
@@ -23,6 +52,7 @@
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include "stdx_string.h"
 
 
 #define X_IO_VERSION_MAJOR 1
@@ -34,11 +64,39 @@
 #define X_IO_API
 #endif
 
+#ifndef X_IO_STREAM_BUFFER_SIZE
+#define X_IO_STREAM_BUFFER_SIZE (64 * 1024)   /* XReader/XWriter buffer when 0 is passed */
+#endif
+
+#ifndef X_IO_WRITEV_BATCH
+#define X_IO_WRITEV_BATCH 64   /* slices handed to one writev() call */
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
   typedef struct XFile_t XFile;
+  typedef struct XReader_t XReader;
+  typedef struct XWriter_t XWriter;
+
+  typedef enum
+  {
+    X_IO_MAP_DEFAULT    = 0,
+    X_IO_MAP_SEQUENTIAL = 1 << 0,   // Expect a front-to-back scan
+    X_IO_MAP_RANDOM     = 1 << 1,   // Expect scattered access; disables read-ahead
+    X_IO_MAP_WILLNEED   = 1 << 2,   // Start paging the file in immediately
+  } XFileMapFlags;
+
+  typedef struct XFileMapping
+  {
+    const void *data;   // First mapped byte, NULL for an empty file
+    size_t size;        // File size in bytes
+#if defined(_WIN32)
+    void *file_handle;
+    void *map_handle;
+#endif
+  } XFileMapping;
 
   X_IO_API XFile *x_io_open(const char *filename, const char *mode);           // Open a file with mode ("r", "rb", "w", etc.)
   X_IO_API void x_io_close(XFile *file);                                       // Close a file and free internal memory
@@ -46,6 +104,7 @@ extern "C" {
   X_IO_API char *x_io_read_all(XFile *file, size_t *out_size);                 // Read the entire file into a buffer. Returns buffer (null-terminated, but not for text safety). Caller must free.
   X_IO_API char *x_io_read_text(const char *filename, size_t* out_size);       // Convenience: open, read, close. Returns null-terminated text.
   X_IO_API size_t x_io_write(XFile *file, const void *data, size_t size);      // Write `size` bytes to file. Returns number of bytes written.
+  X_IO_API size_t x_io_writev(XFile *file, const XSlice *parts, size_t count); // Write `count` slices in order. Returns number of bytes written.
   X_IO_API bool x_io_write_text(const char *filename, const char *text);       // Write null-terminated text to a file (overwrite).
   X_IO_API bool x_io_append_text(const char *filename, const char *text);      // Append null-terminated text to file.
   X_IO_API bool x_io_seek(XFile *file, long offset, int32_t origin);           // Seek within file.
@@ -56,6 +115,24 @@ extern "C" {
   X_IO_API bool x_io_error(XFile *file);                                       // Check for file error.
   X_IO_API void x_io_clearerr(XFile *file);                                    // Clear file error and EOF flags.
   X_IO_API int32_t x_io_fileno(XFile *file);                                   // Return underlying file descriptor.
+  X_IO_API bool x_io_map(const char *filename, uint32_t flags, XFileMapping *out); // Map a whole file read-only. `flags` are XFileMapFlags hints.
+  X_IO_API void x_io_unmap(XFileMapping *mapping);                             // Release a mapping made by x_io_map().
+
+  X_IO_API XReader *x_reader_create(XFile *file, size_t buffer_size);          // Buffered reader over `file` (not owned). 0 picks X_IO_STREAM_BUFFER_SIZE.
+  X_IO_API void x_reader_destroy(XReader *reader);                             // Free the reader. The file stays open.
+  X_IO_API bool x_reader_next_line(XReader *reader, XSlice *out_line);         // Next line without "\n" or "\r\n". False at end of input.
+  X_IO_API bool x_reader_next_record(XReader *reader, char delim, XSlice *out);// Next record up to (not including) `delim`. False at end of input.
+  X_IO_API size_t x_reader_peek(XReader *reader, size_t size, XSlice *out);    // Buffer up to `size` bytes without consuming them. Returns bytes available.
+  X_IO_API void x_reader_consume(XReader *reader, size_t size);                // Drop `size` peeked bytes.
+  X_IO_API size_t x_reader_read(XReader *reader, void *buffer, size_t size);   // Copy up to `size` bytes out. Returns bytes read.
+  X_IO_API bool x_reader_eof(const XReader *reader);                           // True once the file is exhausted and the buffer drained.
+  X_IO_API bool x_reader_error(const XReader *reader);                         // True if a read failed.
+
+  X_IO_API XWriter *x_writer_create(XFile *file, size_t buffer_size);          // Buffered writer over `file` (not owned). 0 picks X_IO_STREAM_BUFFER_SIZE.
+  X_IO_API bool x_writer_destroy(XWriter *writer);                             // Flush and free the writer. Returns false if the flush failed.
+  X_IO_API bool x_writer_write(XWriter *writer, const void *data, size_t size);// Append bytes. Writes larger than the buffer bypass it.
+  X_IO_API bool x_writer_write_slice(XWriter *writer, XSlice slice);           // Append a slice.
+  X_IO_API bool x_writer_flush(XWriter *writer);                               // Write out buffered bytes.
 
 #ifdef __cplusplus
 }
@@ -65,6 +142,18 @@ extern "C" {
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 #ifndef X_IO_ALLOC
 #define X_IO_ALLOC(sz)        malloc(sz)
@@ -80,6 +169,26 @@ extern "C" {
     FILE *fp;
   };
 
+  struct XReader_t
+  {
+    XFile *file;
+    char *buf;
+    size_t capacity;
+    size_t start;       // first unconsumed byte
+    size_t end;         // one past the last buffered byte
+    bool eof;
+    bool error;
+  };
+
+  struct XWriter_t
+  {
+    XFile *file;
+    char *buf;
+    size_t capacity;
+    size_t used;
+    bool error;
+  };
+
   X_IO_API XFile *x_io_open(const char *filename, const char *mode) 
   {
     FILE *fp = fopen(filename, mode);
@@ -115,6 +224,58 @@ extern "C" {
     return fwrite(data, 1, size, file->fp);
   }
 
+  X_IO_API size_t x_io_writev(XFile *file, const XSlice *parts, size_t count)
+  {
+    size_t total = 0;
+    if (!file || !parts) return 0;
+
+#if defined(_WIN32)
+    // The CRT buffers fwrite, which already coalesces small parts
+    for (size_t i = 0; i < count; i++)
+    {
+      if (parts[i].length == 0) continue;
+      size_t n = fwrite(parts[i].ptr, 1, parts[i].length, file->fp);
+      total += n;
+      if (n < parts[i].length) break;
+    }
+#else
+    // Drain the stdio buffer so bytes land in order, then write to the descriptor
+    if (fflush(file->fp) != 0) return 0;
+    int fd = fileno(file->fp);
+    struct iovec iov[X_IO_WRITEV_BATCH];
+    size_t i = 0;
+    size_t skip = 0;    // bytes of parts[i] already written
+
+    while (i < count)
+    {
+      int n = 0;
+      for (size_t j = i; j < count && n < X_IO_WRITEV_BATCH; j++)
+      {
+        size_t off = (j == i) ? skip : 0;
+        if (parts[j].length == off) continue;
+        iov[n].iov_base = (void*)(parts[j].ptr + off);
+        iov[n].iov_len = parts[j].length - off;
+        n++;
+      }
+      if (n == 0) break;
+
+      ssize_t written = writev(fd, iov, n);
+      if (written <= 0) break;
+      total += (size_t)written;
+
+      size_t adv = (size_t)written;
+      while (i < count && adv >= parts[i].length - skip)
+      {
+        adv -= parts[i].length - skip;
+        skip = 0;
+        i++;
+      }
+      skip += adv;
+    }
+#endif
+    return total;
+  }
+
   X_IO_API char *x_io_read_all(XFile *file, size_t *out_size) 
   {
     if (!file) return NULL;
@@ -211,6 +372,326 @@ extern "C" {
 #endif
   }
 
+  X_IO_API XReader *x_reader_create(XFile *file, size_t buffer_size)
+  {
+    if (!file) return NULL;
+    if (buffer_size == 0) buffer_size = X_IO_STREAM_BUFFER_SIZE;
+
+    XReader *r = (XReader *)X_IO_ALLOC(sizeof(XReader));
+    if (!r) return NULL;
+    r->buf = (char *)X_IO_ALLOC(buffer_size);
+    if (!r->buf) { X_IO_FREE(r); return NULL; }
+    r->file = file;
+    r->capacity = buffer_size;
+    r->start = 0;
+    r->end = 0;
+    r->eof = false;
+    r->error = false;
+    return r;
+  }
+
+  X_IO_API void x_reader_destroy(XReader *reader)
+  {
+    if (!reader) return;
+    X_IO_FREE(reader->buf);
+    X_IO_FREE(reader);
+  }
+
+  /* Makes room for `want` buffered bytes: compacts, then grows if still short */
+  static bool s_reader_make_room(XReader *r, size_t want)
+  {
+    size_t avail = r->end - r->start;
+    if (r->start > 0 && r->capacity - r->start < want)
+    {
+      memmove(r->buf, r->buf + r->start, avail);
+      r->start = 0;
+      r->end = avail;
+    }
+    if (r->capacity < want)
+    {
+      size_t cap = r->capacity * 2;
+      if (cap < want) cap = want;
+      char *p = (char *)X_IO_ALLOC(cap);
+      if (!p) { r->error = true; return false; }
+      memcpy(p, r->buf + r->start, avail);
+      X_IO_FREE(r->buf);
+      r->buf = p;
+      r->capacity = cap;
+      r->start = 0;
+      r->end = avail;
+    }
+    return true;
+  }
+
+  /* Reads until `want` bytes are buffered or the file ends, one full-buffer read at a time */
+  static void s_reader_fill(XReader *r, size_t want)
+  {
+    while (r->end - r->start < want && !r->eof)
+    {
+      if (r->end == r->capacity || r->capacity - r->start < want)
+      {
+        if (!s_reader_make_room(r, want)) return;
+      }
+      size_t n = fread(r->buf + r->end, 1, r->capacity - r->end, r->file->fp);
+      if (n == 0)
+      {
+        r->eof = true;
+        r->error = ferror(r->file->fp) != 0;
+      }
+      r->end += n;
+    }
+  }
+
+  X_IO_API bool x_reader_next_record(XReader *reader, char delim, XSlice *out)
+  {
+    if (!reader || !out) return false;
+    size_t scanned = 0;
+
+    for (;;)
+    {
+      char *base = reader->buf + reader->start;
+      size_t avail = reader->end - reader->start;
+      char *hit = (char *)memchr(base + scanned, delim, avail - scanned);
+      if (hit)
+      {
+        out->ptr = base;
+        out->length = (size_t)(hit - base);
+        reader->start += out->length + 1;
+        return true;
+      }
+
+      scanned = avail;
+      if (reader->eof)
+      {
+        // The last record may have no trailing delimiter
+        if (avail == 0) return false;
+        out->ptr = base;
+        out->length = avail;
+        reader->start = reader->end;
+        return true;
+      }
+      s_reader_fill(reader, scanned + 1);
+      if (reader->error) return false;
+    }
+  }
+
+  X_IO_API bool x_reader_next_line(XReader *reader, XSlice *out_line)
+  {
+    if (!x_reader_next_record(reader, '\n', out_line)) return false;
+    if (out_line->length > 0 && out_line->ptr[out_line->length - 1] == '\r')
+      out_line->length--;
+    return true;
+  }
+
+  X_IO_API size_t x_reader_peek(XReader *reader, size_t size, XSlice *out)
+  {
+    if (!reader) return 0;
+    s_reader_fill(reader, size);
+    size_t avail = reader->end - reader->start;
+    if (avail > size) avail = size;
+    if (out)
+    {
+      out->ptr = reader->buf + reader->start;
+      out->length = avail;
+    }
+    return avail;
+  }
+
+  X_IO_API void x_reader_consume(XReader *reader, size_t size)
+  {
+    if (!reader) return;
+    size_t avail = reader->end - reader->start;
+    reader->start += (size < avail) ? size : avail;
+  }
+
+  X_IO_API size_t x_reader_read(XReader *reader, void *buffer, size_t size)
+  {
+    if (!reader || !buffer) return 0;
+    size_t done = 0;
+
+    // Serve what is buffered, then read large requests straight into the caller's memory
+    size_t avail = reader->end - reader->start;
+    size_t n = (size < avail) ? size : avail;
+    memcpy(buffer, reader->buf + reader->start, n);
+    reader->start += n;
+    done += n;
+
+    if (done < size && size - done >= reader->capacity && !reader->eof)
+    {
+      size_t rd = fread((char *)buffer + done, 1, size - done, reader->file->fp);
+      if (rd < size - done)
+      {
+        reader->eof = true;
+        reader->error = ferror(reader->file->fp) != 0;
+      }
+      return done + rd;
+    }
+
+    while (done < size)
+    {
+      s_reader_fill(reader, 1);
+      avail = reader->end - reader->start;
+      if (avail == 0) break;
+      n = (size - done < avail) ? size - done : avail;
+      memcpy((char *)buffer + done, reader->buf + reader->start, n);
+      reader->start += n;
+      done += n;
+    }
+    return done;
+  }
+
+  X_IO_API bool x_reader_eof(const XReader *reader)
+  {
+    return !reader || (reader->eof && reader->start == reader->end);
+  }
+
+  X_IO_API bool x_reader_error(const XReader *reader)
+  {
+    return !reader || reader->error;
+  }
+
+  X_IO_API XWriter *x_writer_create(XFile *file, size_t buffer_size)
+  {
+    if (!file) return NULL;
+    if (buffer_size == 0) buffer_size = X_IO_STREAM_BUFFER_SIZE;
+
+    XWriter *w = (XWriter *)X_IO_ALLOC(sizeof(XWriter));
+    if (!w) return NULL;
+    w->buf = (char *)X_IO_ALLOC(buffer_size);
+    if (!w->buf) { X_IO_FREE(w); return NULL; }
+    w->file = file;
+    w->capacity = buffer_size;
+    w->used = 0;
+    w->error = false;
+    return w;
+  }
+
+  X_IO_API bool x_writer_flush(XWriter *writer)
+  {
+    if (!writer) return false;
+    if (writer->used > 0)
+    {
+      if (fwrite(writer->buf, 1, writer->used, writer->file->fp) != writer->used)
+        writer->error = true;
+      writer->used = 0;
+    }
+    return !writer->error;
+  }
+
+  X_IO_API bool x_writer_write(XWriter *writer, const void *data, size_t size)
+  {
+    if (!writer || (!data && size > 0)) return false;
+
+    if (writer->used + size > writer->capacity)
+    {
+      if (!x_writer_flush(writer)) return false;
+      if (size >= writer->capacity)
+      {
+        if (fwrite(data, 1, size, writer->file->fp) != size)
+          writer->error = true;
+        return !writer->error;
+      }
+    }
+    memcpy(writer->buf + writer->used, data, size);
+    writer->used += size;
+    return true;
+  }
+
+  X_IO_API bool x_writer_write_slice(XWriter *writer, XSlice slice)
+  {
+    return x_writer_write(writer, slice.ptr, slice.length);
+  }
+
+  X_IO_API bool x_writer_destroy(XWriter *writer)
+  {
+    if (!writer) return false;
+    bool ok = x_writer_flush(writer);
+    X_IO_FREE(writer->buf);
+    X_IO_FREE(writer);
+    return ok;
+  }
+
+  X_IO_API bool x_io_map(const char *filename, uint32_t flags, XFileMapping *out)
+  {
+    if (!filename || !out) return false;
+    memset(out, 0, sizeof(*out));
+
+#if defined(_WIN32)
+    DWORD access_hint = FILE_ATTRIBUTE_NORMAL;
+    if (flags & X_IO_MAP_SEQUENTIAL) access_hint = FILE_FLAG_SEQUENTIAL_SCAN;
+    else if (flags & X_IO_MAP_RANDOM) access_hint = FILE_FLAG_RANDOM_ACCESS;
+
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, access_hint, NULL);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) { CloseHandle(file); return false; }
+    if (size.QuadPart == 0)
+    {
+      CloseHandle(file);
+      return true;
+    }
+
+    HANDLE map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!map) { CloseHandle(file); return false; }
+
+    void *view = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    if (!view) { CloseHandle(map); CloseHandle(file); return false; }
+
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0602
+    if (flags & X_IO_MAP_WILLNEED)
+    {
+      WIN32_MEMORY_RANGE_ENTRY range;
+      range.VirtualAddress = view;
+      range.NumberOfBytes = (SIZE_T)size.QuadPart;
+      PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+#endif
+
+    out->data = view;
+    out->size = (size_t)size.QuadPart;
+    out->file_handle = file;
+    out->map_handle = map;
+    return true;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) { close(fd); return false; }
+    if (st.st_size == 0)
+    {
+      close(fd);
+      return true;
+    }
+
+    void *view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);    // the mapping keeps the file referenced
+    if (view == MAP_FAILED) return false;
+
+    if (flags & X_IO_MAP_SEQUENTIAL) madvise(view, (size_t)st.st_size, MADV_SEQUENTIAL);
+    else if (flags & X_IO_MAP_RANDOM) madvise(view, (size_t)st.st_size, MADV_RANDOM);
+    if (flags & X_IO_MAP_WILLNEED) madvise(view, (size_t)st.st_size, MADV_WILLNEED);
+
+    out->data = view;
+    out->size = (size_t)st.st_size;
+    return true;
+#endif
+  }
+
+  X_IO_API void x_io_unmap(XFileMapping *mapping)
+  {
+    if (!mapping) return;
+#if defined(_WIN32)
+    if (mapping->data) UnmapViewOfFile(mapping->data);
+    if (mapping->map_handle) CloseHandle((HANDLE)mapping->map_handle);
+    if (mapping->file_handle) CloseHandle((HANDLE)mapping->file_handle);
+#else
+    if (mapping->data) munmap((void*)mapping->data, mapping->size);
+#endif
+    memset(mapping, 0, sizeof(*mapping));
+  }
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,878 @@
+/**
+ * STDX - Asynchronous file reads
+ * Part of the STDX General Purpose C Library by marciovmf
+ * License: MIT
+ * <https://github.com/marciovmf/stdx>
+ *
+ * ## Overview
+ *
+ * Overlaps many positional file reads instead of blocking on each one, so
+ * tools that load thousands of small files keep the disk queue full on
+ * cold caches.
+ *
+ *     XIOAsync* io = x_io_async_create(0);
+ *     for (int i = 0; i < count; ++i)
+ *       x_io_async_read(io, files[i], 0, bufs[i], sizes[i], on_read, &jobs[i]);
+ *     x_io_async_submit(io);
+ *     while (x_io_async_pending(io) > 0)
+ *       x_io_async_poll(io, 1);
+ *     x_io_async_destroy(io);
+ *
+ * Requests are queued by `x_io_async_read()` and handed to the backend in
+ * one batch by `x_io_async_submit()`. `x_io_async_poll()` reaps finished
+ * reads and runs their callbacks **on the calling thread**, optionally
+ * waiting for a minimum number of completions. A context is not thread
+ * safe: queue, submit and poll from one thread.
+ *
+ * A context holds at most `depth` requests between `x_io_async_read()` and
+ * the end of their callback. When it is full, `x_io_async_read()` returns
+ * false; poll and try again. A request's slot is released before its
+ * callback runs, so callbacks may queue follow-up reads.
+ *
+ * ## Backends
+ *
+ * - `X_IO_ASYNC_URING`: io_uring on Linux, through the raw syscalls (no
+ *   liburing). A whole batch is submitted with one `io_uring_enter()`.
+ * - `X_IO_ASYNC_IOCP`: overlapped `ReadFile` completed on an I/O
+ *   completion port on Windows. The file is reopened for overlapped
+ *   access with `ReOpenFile()` for each request.
+ * - `X_IO_ASYNC_THREADPOOL`: blocking `pread` (or positional `ReadFile`)
+ *   on `XThreadPool` workers. Works everywhere.
+ *
+ * `x_io_async_create()` picks the native backend and falls back to the
+ * thread pool when it is unavailable (old kernel, seccomp filter).
+ *
+ * The callback's `result` is the number of bytes read (0 at end of file,
+ * less than asked for on a short read) or a negative error code
+ * (`-errno` on POSIX, `-GetLastError()` on Windows).
+ *
+ * ## How to compile
+ *
+ * To compile the implementation define `X_IMPL_IO_ASYNC`
+ * in **one** source file before including this header.
+ *
+ * To customize how this module allocates memory, define
+ * `X_IO_ASYNC_ALLOC` / `X_IO_ASYNC_FREE` before including.
+ *
+ * ## Dependencies
+ *
+ *  stdx_io.h (XFile, implementation required)
+ *  stdx_thread.h (thread pool backend, implementation required)
+ *
+ */
+
+#ifndef X_IO_ASYNC_H
+#define X_IO_ASYNC_H
+
+#include "stdx_io.h"
+#include "stdx_thread.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef X_IO_ASYNC_API
+#define X_IO_ASYNC_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define X_IO_ASYNC_VERSION_MAJOR 1
+#define X_IO_ASYNC_VERSION_MINOR 0
+#define X_IO_ASYNC_VERSION_PATCH 0
+
+#define X_IO_ASYNC_VERSION (X_IO_ASYNC_VERSION_MAJOR * 10000 + X_IO_ASYNC_VERSION_MINOR * 100 + X_IO_ASYNC_VERSION_PATCH)
+
+#ifndef X_IO_ASYNC_DEFAULT_DEPTH
+/**
+ * @brief Number of requests a context holds when 0 is passed as depth.
+ */
+#define X_IO_ASYNC_DEFAULT_DEPTH 256
+#endif
+
+#ifndef X_IO_ASYNC_THREADS
+/**
+ * @brief Worker count of the pool created by the thread-pool backend when none is given.
+ */
+#define X_IO_ASYNC_THREADS 4
+#endif
+
+  typedef struct XIOAsync XIOAsync;
+
+  /**
+   * @brief Completion callback.
+   * @param user User pointer passed to x_io_async_read().
+   * @param buffer Destination buffer passed to x_io_async_read().
+   * @param result Bytes read, or a negative error code.
+   */
+  typedef void (*XIOAsyncCallback)(void* user, void* buffer, int64_t result);
+
+  typedef enum
+  {
+    X_IO_ASYNC_AUTO       = 0,  /* Native backend, thread pool if unavailable */
+    X_IO_ASYNC_URING      = 1,  /* io_uring (Linux) */
+    X_IO_ASYNC_IOCP       = 2,  /* I/O completion port (Windows) */
+    X_IO_ASYNC_THREADPOOL = 3   /* Blocking reads on XThreadPool workers */
+  } XIOAsyncBackend;
+
+  /**
+   * @brief Create a context with the best backend for this platform.
+   * @param depth Maximum number of outstanding requests. 0 picks X_IO_ASYNC_DEFAULT_DEPTH.
+   * @return Context, or NULL on failure.
+   */
+  X_IO_ASYNC_API XIOAsync* x_io_async_create(uint32_t depth);
+
+  /**
+   * @brief Create a context with an explicit backend.
+   * @param depth Maximum number of outstanding requests. 0 picks X_IO_ASYNC_DEFAULT_DEPTH.
+   * @param backend Backend to use. A native backend that is unavailable fails instead of falling back.
+   * @param pool Pool for the thread-pool backend. NULL creates a private pool of X_IO_ASYNC_THREADS workers. Not owned.
+   * @return Context, or NULL on failure.
+   */
+  X_IO_ASYNC_API XIOAsync* x_io_async_create_ex(uint32_t depth, XIOAsyncBackend backend, XThreadPool* pool);
+
+  /**
+   * @brief Submit queued requests, wait for every outstanding read, run its callback and free the context.
+   * Reads the backend refuses to take finish with -ECANCELED
+   * (-ERROR_OPERATION_ABORTED on Windows). If the backend stops reporting
+   * completions, the wait ends instead of hanging.
+   * @param ctx Context to destroy.
+   */
+  X_IO_ASYNC_API void x_io_async_destroy(XIOAsync* ctx);
+
+  /**
+   * @brief Backend chosen for a context.
+   * @param ctx Context.
+   * @return X_IO_ASYNC_URING, X_IO_ASYNC_IOCP or X_IO_ASYNC_THREADPOOL.
+   */
+  X_IO_ASYNC_API XIOAsyncBackend x_io_async_backend(const XIOAsync* ctx);
+
+  /**
+   * @brief Queue a read of `length` bytes at `offset`. It starts on the next x_io_async_submit().
+   * The file position is not used or changed. `file` and `buffer` must stay valid until the callback runs.
+   * @param ctx Context.
+   * @param file Open file to read from.
+   * @param offset Byte offset in the file.
+   * @param buffer Destination buffer of at least `length` bytes.
+   * @param length Bytes to read. Reads above 2 GB are shortened.
+   * @param callback Function run by x_io_async_poll() when the read finishes.
+   * @param user User pointer passed to the callback.
+   * @return True if queued, false on invalid arguments or when `depth` requests are outstanding.
+   */
+  X_IO_ASYNC_API bool x_io_async_read(XIOAsync* ctx, XFile* file, uint64_t offset, void* buffer, size_t length, XIOAsyncCallback callback, void* user);
+
+  /**
+   * @brief Hand every queued request to the backend in one batch.
+   * Requests the backend does not take (io_uring_enter failed or submitted
+   * fewer) stay queued for the next call.
+   * @param ctx Context.
+   * @return Number of requests submitted; less than the number queued on failure.
+   */
+  X_IO_ASYNC_API uint32_t x_io_async_submit(XIOAsync* ctx);
+
+  /**
+   * @brief Run callbacks of finished reads.
+   * Submitted reads are waited for until at least `min_complete` have finished
+   * (capped at the number in flight). 0 never blocks.
+   * @param ctx Context.
+   * @param min_complete Completions to wait for.
+   * @return Number of callbacks run.
+   */
+  X_IO_ASYNC_API uint32_t x_io_async_poll(XIOAsync* ctx, uint32_t min_complete);
+
+  /**
+   * @brief Number of requests queued or in flight whose callback has not run yet.
+   * @param ctx Context.
+   * @return Outstanding request count.
+   */
+  X_IO_ASYNC_API uint32_t x_io_async_pending(const XIOAsync* ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // X_IO_ASYNC_H
+
+#ifdef X_IMPL_IO_ASYNC
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <io.h>
+#if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x0600
+#define X_IO_ASYNC_HAS_IOCP 1
+#endif
+#else
+#include <errno.h>
+#include <unistd.h>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#define X_IO_ASYNC_HAS_URING 1
+#endif
+#endif
+#endif
+
+#ifndef X_IO_ASYNC_ALLOC
+/**
+ * @brief Internal macro for allocating memory.
+ * To override how this header allocates memory, define this macro with a
+ * different implementation before including this header.
+ * @param sz  The size of memory to alloc.
+ */
+#define X_IO_ASYNC_ALLOC(sz) malloc(sz)
+#endif
+
+#ifndef X_IO_ASYNC_FREE
+/**
+ * @brief Internal macro for freeing memory.
+ * To override how this header frees memory, define this macro with a
+ * different implementation before including this header.
+ * @param p  The address of memory region to free.
+ */
+#define X_IO_ASYNC_FREE(p) free(p)
+#endif
+
+#define X_IO_ASYNC_MAX_READ 0x7ffff000u
+
+/* Result of reads still queued when the context is destroyed */
+#if defined(_WIN32)
+#define X_IO_ASYNC_CANCELED (-(int64_t)ERROR_OPERATION_ABORTED)
+#else
+#define X_IO_ASYNC_CANCELED (-(int64_t)ECANCELED)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  typedef struct XIOAsyncRequest XIOAsyncRequest;
+
+  struct XIOAsyncRequest
+  {
+#if defined(X_IO_ASYNC_HAS_IOCP)
+    OVERLAPPED overlapped;  /* must stay first: completions hand back this address */
+    HANDLE handle;          /* overlapped reopen of the file */
+#endif
+#if defined(X_IO_ASYNC_HAS_URING)
+    struct iovec iov;
+#endif
+    XTask task;
+    XIOAsync* ctx;
+    XIOAsyncRequest* next;
+    int32_t fd;
+    uint32_t length;
+    uint64_t offset;
+    void* buffer;
+    XIOAsyncCallback callback;
+    void* user;
+    int64_t result;
+  };
+
+  struct XIOAsync
+  {
+    XIOAsyncBackend backend;
+    uint32_t depth;
+    uint32_t queued;          /* read but not submitted */
+    uint32_t in_flight;       /* submitted, callback not run */
+    XIOAsyncRequest* slots;
+    XIOAsyncRequest* free_list;
+    XIOAsyncRequest* queue_head;
+    XIOAsyncRequest* queue_tail;
+    XIOAsyncRequest* ready;   /* finished synchronously on the calling thread */
+
+    /* Thread-pool backend */
+    XThreadPool* pool;
+    bool owns_pool;
+    XMutex* lock;
+    XCondVar* cond;
+    XIOAsyncRequest* done;    /* finished by workers, guarded by lock */
+    uint32_t done_count;
+
+#if defined(X_IO_ASYNC_HAS_URING)
+    int ring_fd;
+    void* sq_ring;
+    void* cq_ring;
+    size_t sq_ring_size;
+    size_t cq_ring_size;
+    struct io_uring_sqe* sqes;
+    size_t sqes_size;
+    uint32_t* sq_tail;
+    uint32_t* sq_mask;
+    uint32_t* sq_array;
+    uint32_t* cq_head;
+    uint32_t* cq_tail;
+    uint32_t* cq_mask;
+    struct io_uring_cqe* cqes;
+#endif
+#if defined(X_IO_ASYNC_HAS_IOCP)
+    HANDLE port;
+#endif
+  };
+
+  static void s_io_async_push(XIOAsyncRequest** list, XIOAsyncRequest* req)
+  {
+    req->next = *list;
+    *list = req;
+  }
+
+  /* Releases the slot, then runs the callback so it can queue a follow-up read */
+  static void s_io_async_finish(XIOAsync* ctx, XIOAsyncRequest* req)
+  {
+    XIOAsyncCallback callback = req->callback;
+    void* user = req->user;
+    void* buffer = req->buffer;
+    int64_t result = req->result;
+
+    ctx->in_flight--;
+    s_io_async_push(&ctx->free_list, req);
+    if (callback)
+      callback(user, buffer, result);
+  }
+
+  static uint32_t s_io_async_finish_list(XIOAsync* ctx, XIOAsyncRequest* list)
+  {
+    uint32_t count = 0;
+    while (list)
+    {
+      XIOAsyncRequest* next = list->next;
+      s_io_async_finish(ctx, list);
+      list = next;
+      count++;
+    }
+    return count;
+  }
+
+  /* ---------------------------------------------------------------------- */
+  /* Thread-pool backend                                                    */
+  /* ---------------------------------------------------------------------- */
+
+  static void s_io_async_pool_task(void* arg)
+  {
+    XIOAsyncRequest* req = (XIOAsyncRequest*)arg;
+    XIOAsync* ctx = req->ctx;
+
+#if defined(_WIN32)
+    HANDLE h = (HANDLE)_get_osfhandle(req->fd);
+    OVERLAPPED ov;
+    DWORD got = 0;
+    memset(&ov, 0, sizeof(ov));
+    ov.Offset = (DWORD)(req->offset & 0xffffffffu);
+    ov.OffsetHigh = (DWORD)(req->offset >> 32);
+    if (ReadFile(h, req->buffer, req->length, &got, &ov))
+    {
+      req->result = (int64_t)got;
+    }
+    else
+    {
+      DWORD err = GetLastError();
+      req->result = (err == ERROR_HANDLE_EOF) ? 0 : -(int64_t)err;
+    }
+#else
+    ssize_t n;
+    do
+    {
+      n = pread(req->fd, req->buffer, req->length, (off_t)req->offset);
+    } while (n < 0 && errno == EINTR);
+    req->result = (n < 0) ? -(int64_t)errno : (int64_t)n;
+#endif
+
+    x_thread_mutex_lock(ctx->lock);
+    s_io_async_push(&ctx->done, req);
+    ctx->done_count++;
+    x_thread_condvar_signal(ctx->cond);
+    x_thread_mutex_unlock(ctx->lock);
+  }
+
+  static bool s_io_async_pool_init(XIOAsync* ctx, XThreadPool* pool)
+  {
+    if (x_thread_mutex_init(&ctx->lock) != 0) return false;
+    if (x_thread_condvar_init(&ctx->cond) != 0) return false;
+    ctx->pool = pool;
+    if (!ctx->pool)
+    {
+      ctx->pool = x_threadpool_create(X_IO_ASYNC_THREADS);
+      if (!ctx->pool) return false;
+      ctx->owns_pool = true;
+    }
+    ctx->backend = X_IO_ASYNC_THREADPOOL;
+    return true;
+  }
+
+  static void s_io_async_pool_submit(XIOAsync* ctx, XIOAsyncRequest* req)
+  {
+    x_task_init(&req->task, s_io_async_pool_task, req);
+    if (x_threadpool_submit(ctx->pool, &req->task) != 0)
+      s_io_async_pool_task(req);
+  }
+
+  static uint32_t s_io_async_pool_poll(XIOAsync* ctx, uint32_t min_complete)
+  {
+    x_thread_mutex_lock(ctx->lock);
+    while (ctx->done_count < min_complete)
+      x_thread_condvar_wait(ctx->cond, ctx->lock);
+    XIOAsyncRequest* list = ctx->done;
+    ctx->done = NULL;
+    ctx->done_count = 0;
+    x_thread_mutex_unlock(ctx->lock);
+    return s_io_async_finish_list(ctx, list);
+  }
+
+  /* ---------------------------------------------------------------------- */
+  /* io_uring backend                                                       */
+  /* ---------------------------------------------------------------------- */
+
+#if defined(X_IO_ASYNC_HAS_URING)
+
+  static int s_io_uring_enter(int fd, uint32_t to_submit, uint32_t min_complete, uint32_t flags)
+  {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+  }
+
+  static bool s_io_async_uring_init(XIOAsync* ctx)
+  {
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+
+    int fd = (int)syscall(__NR_io_uring_setup, ctx->depth, &p);
+    if (fd < 0) return false;
+    ctx->ring_fd = fd;
+
+    ctx->sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+    ctx->cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single)
+    {
+      if (ctx->cq_ring_size > ctx->sq_ring_size) ctx->sq_ring_size = ctx->cq_ring_size;
+      ctx->cq_ring_size = ctx->sq_ring_size;
+    }
+
+    ctx->sq_ring = mmap(NULL, ctx->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (ctx->sq_ring == MAP_FAILED) { ctx->sq_ring = NULL; return false; }
+
+    if (single)
+    {
+      ctx->cq_ring = ctx->sq_ring;
+    }
+    else
+    {
+      ctx->cq_ring = mmap(NULL, ctx->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+      if (ctx->cq_ring == MAP_FAILED) { ctx->cq_ring = NULL; return false; }
+    }
+
+    ctx->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+    ctx->sqes = (struct io_uring_sqe*)mmap(NULL, ctx->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (ctx->sqes == MAP_FAILED) { ctx->sqes = NULL; return false; }
+
+    char* sq = (char*)ctx->sq_ring;
+    char* cq = (char*)ctx->cq_ring;
+    ctx->sq_tail  = (uint32_t*)(sq + p.sq_off.tail);
+    ctx->sq_mask  = (uint32_t*)(sq + p.sq_off.ring_mask);
+    ctx->sq_array = (uint32_t*)(sq + p.sq_off.array);
+    ctx->cq_head  = (uint32_t*)(cq + p.cq_off.head);
+    ctx->cq_tail  = (uint32_t*)(cq + p.cq_off.tail);
+    ctx->cq_mask  = (uint32_t*)(cq + p.cq_off.ring_mask);
+    ctx->cqes     = (struct io_uring_cqe*)(cq + p.cq_off.cqes);
+
+    ctx->backend = X_IO_ASYNC_URING;
+    return true;
+  }
+
+  static void s_io_async_uring_close(XIOAsync* ctx)
+  {
+    if (ctx->sqes) munmap(ctx->sqes, ctx->sqes_size);
+    if (ctx->cq_ring && ctx->cq_ring != ctx->sq_ring) munmap(ctx->cq_ring, ctx->cq_ring_size);
+    if (ctx->sq_ring) munmap(ctx->sq_ring, ctx->sq_ring_size);
+    if (ctx->ring_fd >= 0) close(ctx->ring_fd);
+    ctx->sqes = NULL;
+    ctx->sq_ring = ctx->cq_ring = NULL;
+    ctx->ring_fd = -1;
+  }
+
+  /*
+   * Requests never outnumber the ring, so the SQ always has room for a batch.
+   * Returns how many the kernel took; the rest go back to the front of the queue.
+   */
+  static uint32_t s_io_async_uring_submit(XIOAsync* ctx, XIOAsyncRequest* list)
+  {
+    uint32_t tail = *ctx->sq_tail;
+    uint32_t mask = *ctx->sq_mask;
+    uint32_t count = 0;
+
+    for (XIOAsyncRequest* req = list; req; req = req->next)
+    {
+      uint32_t index = tail & mask;
+      struct io_uring_sqe* sqe = &ctx->sqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+      req->iov.iov_base = req->buffer;
+      req->iov.iov_len = req->length;
+      sqe->opcode = IORING_OP_READV;
+      sqe->fd = req->fd;
+      sqe->off = req->offset;
+      sqe->addr = (uint64_t)(uintptr_t)&req->iov;
+      sqe->len = 1;
+      sqe->user_data = (uint64_t)(uintptr_t)req;
+      ctx->sq_array[index] = index;
+      tail++;
+      count++;
+    }
+
+    __atomic_store_n(ctx->sq_tail, tail, __ATOMIC_RELEASE);
+    uint32_t submitted = 0;
+    while (submitted < count)
+    {
+      int n = s_io_uring_enter(ctx->ring_fd, count - submitted, 0, 0);
+      if (n < 0 && errno == EINTR) continue;
+      if (n <= 0) break;
+      submitted += (uint32_t)n;
+    }
+    if (submitted == count)
+      return count;
+
+    // The kernel consumes SQEs in order and never read the last ones: take them back
+    __atomic_store_n(ctx->sq_tail, tail - (count - submitted), __ATOMIC_RELEASE);
+    XIOAsyncRequest* rest = list;
+    for (uint32_t i = 0; i < submitted; i++)
+      rest = rest->next;
+    XIOAsyncRequest* last = rest;
+    while (last->next)
+      last = last->next;
+    last->next = ctx->queue_head;
+    if (!ctx->queue_head) ctx->queue_tail = last;
+    ctx->queue_head = rest;
+    ctx->queued += count - submitted;
+    return submitted;
+  }
+
+  static uint32_t s_io_async_uring_poll(XIOAsync* ctx, uint32_t min_complete)
+  {
+    uint32_t count = 0;
+    for (;;)
+    {
+      uint32_t head = *ctx->cq_head;
+      while (head != __atomic_load_n(ctx->cq_tail, __ATOMIC_ACQUIRE))
+      {
+        struct io_uring_cqe* cqe = &ctx->cqes[head & *ctx->cq_mask];
+        XIOAsyncRequest* req = (XIOAsyncRequest*)(uintptr_t)cqe->user_data;
+        req->result = cqe->res;
+        head++;
+        __atomic_store_n(ctx->cq_head, head, __ATOMIC_RELEASE);
+        s_io_async_finish(ctx, req);
+        count++;
+      }
+
+      if (count >= min_complete || ctx->in_flight == 0)
+        break;
+
+      uint32_t want = min_complete - count;
+      if (want > ctx->in_flight) want = ctx->in_flight;
+      if (s_io_uring_enter(ctx->ring_fd, 0, want, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR)
+        break;
+    }
+    return count;
+  }
+
+#endif // X_IO_ASYNC_HAS_URING
+
+  /* ---------------------------------------------------------------------- */
+  /* IOCP backend                                                           */
+  /* ---------------------------------------------------------------------- */
+
+#if defined(X_IO_ASYNC_HAS_IOCP)
+
+  static bool s_io_async_iocp_init(XIOAsync* ctx)
+  {
+    ctx->port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (!ctx->port) return false;
+    ctx->backend = X_IO_ASYNC_IOCP;
+    return true;
+  }
+
+  static int64_t s_io_async_iocp_error(DWORD err)
+  {
+    return (err == ERROR_HANDLE_EOF) ? 0 : -(int64_t)err;
+  }
+
+  static void s_io_async_iocp_submit(XIOAsync* ctx, XIOAsyncRequest* req)
+  {
+    HANDLE src = (HANDLE)_get_osfhandle(req->fd);
+    req->handle = ReOpenFile(src, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, FILE_FLAG_OVERLAPPED);
+    if (req->handle == INVALID_HANDLE_VALUE || !CreateIoCompletionPort(req->handle, ctx->port, 0, 0))
+    {
+      req->result = -(int64_t)GetLastError();
+      if (req->handle != INVALID_HANDLE_VALUE) CloseHandle(req->handle);
+      s_io_async_push(&ctx->ready, req);
+      return;
+    }
+
+    memset(&req->overlapped, 0, sizeof(req->overlapped));
+    req->overlapped.Offset = (DWORD)(req->offset & 0xffffffffu);
+    req->overlapped.OffsetHigh = (DWORD)(req->offset >> 32);
+    if (!ReadFile(req->handle, req->buffer, req->length, NULL, &req->overlapped))
+    {
+      DWORD err = GetLastError();
+      if (err != ERROR_IO_PENDING)
+      {
+        // Failed synchronously: no completion packet will be queued
+        req->result = s_io_async_iocp_error(err);
+        CloseHandle(req->handle);
+        s_io_async_push(&ctx->ready, req);
+      }
+    }
+  }
+
+  static uint32_t s_io_async_iocp_poll(XIOAsync* ctx, uint32_t min_complete)
+  {
+    OVERLAPPED_ENTRY entries[64];
+    uint32_t count = 0;
+
+    for (;;)
+    {
+      ULONG removed = 0;
+      bool wait = count < min_complete && ctx->in_flight > 0;
+      if (!GetQueuedCompletionStatusEx(ctx->port, entries, 64, &removed, wait ? INFINITE : 0, FALSE))
+        break;
+
+      for (ULONG i = 0; i < removed; i++)
+      {
+        XIOAsyncRequest* req = (XIOAsyncRequest*)entries[i].lpOverlapped;
+        DWORD got = 0;
+        if (GetOverlappedResult(req->handle, &req->overlapped, &got, FALSE))
+          req->result = (int64_t)got;
+        else
+          req->result = s_io_async_iocp_error(GetLastError());
+        CloseHandle(req->handle);
+        s_io_async_finish(ctx, req);
+        count++;
+      }
+
+      if (count >= min_complete || ctx->in_flight == 0)
+        break;
+    }
+    return count;
+  }
+
+#endif // X_IO_ASYNC_HAS_IOCP
+
+  /* ---------------------------------------------------------------------- */
+  /* Public API                                                             */
+  /* ---------------------------------------------------------------------- */
+
+  static bool s_io_async_init_backend(XIOAsync* ctx, XIOAsyncBackend backend, XThreadPool* pool)
+  {
+    switch (backend)
+    {
+      case X_IO_ASYNC_URING:
+#if defined(X_IO_ASYNC_HAS_URING)
+        return s_io_async_uring_init(ctx);
+#else
+        return false;
+#endif
+      case X_IO_ASYNC_IOCP:
+#if defined(X_IO_ASYNC_HAS_IOCP)
+        return s_io_async_iocp_init(ctx);
+#else
+        return false;
+#endif
+      case X_IO_ASYNC_THREADPOOL:
+        return s_io_async_pool_init(ctx, pool);
+      case X_IO_ASYNC_AUTO:
+      default:
+#if defined(X_IO_ASYNC_HAS_URING)
+        if (s_io_async_uring_init(ctx)) return true;
+        s_io_async_uring_close(ctx);
+#elif defined(X_IO_ASYNC_HAS_IOCP)
+        if (s_io_async_iocp_init(ctx)) return true;
+#endif
+        return s_io_async_pool_init(ctx, pool);
+    }
+  }
+
+  X_IO_ASYNC_API XIOAsync* x_io_async_create(uint32_t depth)
+  {
+    return x_io_async_create_ex(depth, X_IO_ASYNC_AUTO, NULL);
+  }
+
+  X_IO_ASYNC_API XIOAsync* x_io_async_create_ex(uint32_t depth, XIOAsyncBackend backend, XThreadPool* pool)
+  {
+    if (depth == 0) depth = X_IO_ASYNC_DEFAULT_DEPTH;
+
+    XIOAsync* ctx = (XIOAsync*)X_IO_ASYNC_ALLOC(sizeof(XIOAsync));
+    if (!ctx) return NULL;
+    memset(ctx, 0, sizeof(*ctx));
+    ctx->depth = depth;
+#if defined(X_IO_ASYNC_HAS_URING)
+    ctx->ring_fd = -1;
+#endif
+
+    ctx->slots = (XIOAsyncRequest*)X_IO_ASYNC_ALLOC(sizeof(XIOAsyncRequest) * depth);
+    if (!ctx->slots)
+    {
+      X_IO_ASYNC_FREE(ctx);
+      return NULL;
+    }
+    for (uint32_t i = depth; i > 0; i--)
+      s_io_async_push(&ctx->free_list, &ctx->slots[i - 1]);
+
+    if (!s_io_async_init_backend(ctx, backend, pool))
+    {
+      x_io_async_destroy(ctx);
+      return NULL;
+    }
+    return ctx;
+  }
+
+  X_IO_ASYNC_API void x_io_async_destroy(XIOAsync* ctx)
+  {
+    if (!ctx) return;
+
+    if (ctx->backend != X_IO_ASYNC_AUTO)
+    {
+      // Stop once the backend makes no progress rather than wait for completions that never come
+      for (;;)
+      {
+        x_io_async_submit(ctx);
+        uint32_t submitted = ctx->in_flight - ctx->queued;
+        if (submitted == 0 || x_io_async_poll(ctx, submitted) == 0)
+          break;
+      }
+
+      // Reads the backend never took still get their callback
+      XIOAsyncRequest* list = ctx->queue_head;
+      ctx->queue_head = ctx->queue_tail = NULL;
+      ctx->queued = 0;
+      for (XIOAsyncRequest* req = list; req; req = req->next)
+        req->result = X_IO_ASYNC_CANCELED;
+      s_io_async_finish_list(ctx, list);
+    }
+
+#if defined(X_IO_ASYNC_HAS_URING)
+    s_io_async_uring_close(ctx);
+#endif
+#if defined(X_IO_ASYNC_HAS_IOCP)
+    if (ctx->port) CloseHandle(ctx->port);
+#endif
+    if (ctx->owns_pool) x_threadpool_destroy(ctx->pool);
+    if (ctx->cond) x_thread_condvar_destroy(ctx->cond);
+    if (ctx->lock) x_thread_mutex_destroy(ctx->lock);
+    X_IO_ASYNC_FREE(ctx->slots);
+    X_IO_ASYNC_FREE(ctx);
+  }
+
+  X_IO_ASYNC_API XIOAsyncBackend x_io_async_backend(const XIOAsync* ctx)
+  {
+    return ctx ? ctx->backend : X_IO_ASYNC_AUTO;
+  }
+
+  X_IO_ASYNC_API bool x_io_async_read(XIOAsync* ctx, XFile* file, uint64_t offset, void* buffer, size_t length, XIOAsyncCallback callback, void* user)
+  {
+    if (!ctx || !file || (!buffer && length > 0)) return false;
+    int32_t fd = x_io_fileno(file);
+    if (fd < 0 || !ctx->free_list) return false;
+
+    XIOAsyncRequest* req = ctx->free_list;
+    ctx->free_list = req->next;
+
+    req->ctx = ctx;
+    req->next = NULL;
+    req->fd = fd;
+    req->offset = offset;
+    req->buffer = buffer;
+    req->length = (length > X_IO_ASYNC_MAX_READ) ? X_IO_ASYNC_MAX_READ : (uint32_t)length;
+    req->callback = callback;
+    req->user = user;
+    req->result = 0;
+
+    // Keep submission order so batches reach the device in the order they were queued
+    if (ctx->queue_tail) ctx->queue_tail->next = req;
+    else ctx->queue_head = req;
+    ctx->queue_tail = req;
+    ctx->queued++;
+    ctx->in_flight++;
+    return true;
+  }
+
+  X_IO_ASYNC_API uint32_t x_io_async_submit(XIOAsync* ctx)
+  {
+    if (!ctx || !ctx->queue_head) return 0;
+
+    XIOAsyncRequest* list = ctx->queue_head;
+    uint32_t count = ctx->queued;
+    ctx->queue_head = ctx->queue_tail = NULL;
+    ctx->queued = 0;
+
+    switch (ctx->backend)
+    {
+#if defined(X_IO_ASYNC_HAS_URING)
+      case X_IO_ASYNC_URING:
+        return s_io_async_uring_submit(ctx, list);
+#endif
+#if defined(X_IO_ASYNC_HAS_IOCP)
+      case X_IO_ASYNC_IOCP:
+        while (list)
+        {
+          XIOAsyncRequest* next = list->next;
+          s_io_async_iocp_submit(ctx, list);
+          list = next;
+        }
+        return count;
+#endif
+      default:
+        while (list)
+        {
+          // The worker may finish and relink the node before submit returns
+          XIOAsyncRequest* next = list->next;
+          s_io_async_pool_submit(ctx, list);
+          list = next;
+        }
+        return count;
+    }
+  }
+
+  X_IO_ASYNC_API uint32_t x_io_async_poll(XIOAsync* ctx, uint32_t min_complete)
+  {
+    if (!ctx) return 0;
+
+    // Queued requests cannot complete, so never wait on them
+    uint32_t submitted = ctx->in_flight - ctx->queued;
+    if (min_complete > submitted) min_complete = submitted;
+
+    XIOAsyncRequest* ready = ctx->ready;
+    ctx->ready = NULL;
+    uint32_t count = s_io_async_finish_list(ctx, ready);
+    min_complete = (count >= min_complete) ? 0 : min_complete - count;
+
+    switch (ctx->backend)
+    {
+#if defined(X_IO_ASYNC_HAS_URING)
+      case X_IO_ASYNC_URING:
+        return count + s_io_async_uring_poll(ctx, min_complete);
+#endif
+#if defined(X_IO_ASYNC_HAS_IOCP)
+      case X_IO_ASYNC_IOCP:
+        return count + s_io_async_iocp_poll(ctx, min_complete);
+#endif
+      default:
+        return count + s_io_async_pool_poll(ctx, min_complete);
+    }
+  }
+
+  X_IO_ASYNC_API uint32_t x_io_async_pending(const XIOAsync* ctx)
+  {
+    return ctx ? ctx->in_flight : 0;
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // X_IMPL_IO_ASYNC
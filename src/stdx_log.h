@@ -16,10 +16,61 @@
  * If a NULL XLogger instance is passed to logger functions it will use a default
  * logger that outputs to the console only with XLOG_LEVEL_DEBUG log level.
  *
+ * ## Asynchronous output
+ *
+ * By default every message is written to its outputs on the calling thread.
+ * x_log_start_async() switches a logger to a background writer: each
+ * producing thread formats into its own lock-free ring and the writer thread
+ * drains all rings into large, batched writes. When a ring is full the
+ * message is either dropped (counted by x_log_dropped()) or the producer
+ * waits for room, as chosen by the XLogOverflowPolicy. Fatal messages are
+ * never dropped and are flushed before x_log_fatal() returns; x_log_flush()
+ * waits for everything logged so far, and x_log_close() drains and stops the
+ * writer.
+ *
+ * The asynchronous backend runs on stdx_thread, so it is only compiled when
+ * `X_LOG_ASYNC` is defined where the implementation is, and the program must
+ * also compile the threading implementation (`X_IMPL_THREAD`; in the same
+ * file, include stdx_thread.h with it first). Without `X_LOG_ASYNC`
+ * x_log_start_async() returns false and the logger stays synchronous.
+ *
+ * ## Deferred formatting
+ *
+ * x_log_binary() is for high-frequency trace points. On an asynchronous
+ * logger the call site records only its static site descriptor, a
+ * timestamp and the raw argument values; the printf-style formatting is
+ * done by the writer thread. If x_log_open_binary() gave the logger a binary
+ * log, the records are written there unformatted instead, and
+ * x_log_decode() (or the `logdecode` demo tool) turns that file back into
+ * text later. On a synchronous logger x_log_binary() formats like any other
+ * message.
+ *
+ * Deferred messages take the conversions `d i u o x X c e E f F g G a A s p`
+ * with the usual flags, widths and length modifiers; a `%s` argument keeps
+ * at most X_LOG_BINARY_MAX_STRING bytes. A site whose format uses anything
+ * else (such as `%n`) is formatted on the calling thread.
+ *
+ * ## Filtering and timestamps
+ *
+ * The level macros test the logger's level before their arguments are
+ * evaluated, so a filtered x_log_debug() costs a compare. Defining
+ * `X_LOG_MIN_LEVEL` (0 debug, 1 info, 2 warning, 3 error) removes the
+ * x_log_debug(), x_log_info(), x_log_warning(), x_log_error() and
+ * x_log_binary() calls below that level at compile time; fatal messages
+ * are always kept.
+ *
+ * `XLOG_TIMESTAMP` prints the local wall-clock time. The date part is
+ * formatted once per second per thread and reused. `XLOG_MONOTONIC` prints
+ * seconds on the monotonic clock instead (or as well), which never jumps
+ * and resolves microseconds.
+ *
  * ## How to compile
  *
  * To compile the implementation define `X_IMPL_LOG`
  * in **one** source file before including this header.
+ *
+ * To customize how this module allocates memory, define
+ * `X_LOG_ALLOC` / `X_LOG_FREE` before including.
  */
 
 #ifndef X_LOG_H
@@ -38,6 +89,55 @@
 #define X_LOG_BUFFER_SIZE (1024 * 4)
 #endif  // X_LOG_BUFFER_SIZE
 
+#ifndef X_LOG_MIN_LEVEL
+/**
+ * Lowest level the level macros compile in, as an XLogLevel value.
+ * Can be overriden before including this header
+ */
+#define X_LOG_MIN_LEVEL 0
+#endif  // X_LOG_MIN_LEVEL
+
+#ifndef X_LOG_ASYNC_RING_SIZE
+/**
+ * Default size in bytes of each producer thread's ring in asynchronous mode.
+ * Can be overriden before including this header
+ */
+#define X_LOG_ASYNC_RING_SIZE (64 * 1024)
+#endif  // X_LOG_ASYNC_RING_SIZE
+
+#ifndef X_LOG_ASYNC_BATCH_SIZE
+/**
+ * Size of the writer thread's output batches in asynchronous mode.
+ * Can be overriden before including this header
+ */
+#define X_LOG_ASYNC_BATCH_SIZE (64 * 1024)
+#endif  // X_LOG_ASYNC_BATCH_SIZE
+
+#ifndef X_LOG_ASYNC_IDLE_POLLS
+/**
+ * Milliseconds the writer thread keeps polling an idle logger before it
+ * sleeps until a producer wakes it.
+ * Can be overriden before including this header
+ */
+#define X_LOG_ASYNC_IDLE_POLLS 10
+#endif  // X_LOG_ASYNC_IDLE_POLLS
+
+#ifndef X_LOG_BINARY_MAX_ARGS
+/**
+ * Most arguments (including `*` widths and precisions) a deferred message can take.
+ * Can be overriden before including this header
+ */
+#define X_LOG_BINARY_MAX_ARGS 16
+#endif  // X_LOG_BINARY_MAX_ARGS
+
+#ifndef X_LOG_BINARY_MAX_STRING
+/**
+ * Longest `%s` argument a deferred message records; longer strings are cut.
+ * Can be overriden before including this header
+ */
+#define X_LOG_BINARY_MAX_STRING 256
+#endif  // X_LOG_BINARY_MAX_STRING
+
 #ifdef _WIN32
 #ifndef _CRT_SECURE_NO_WARNINGS
 #define _CRT_SECURE_NO_WARNINGS
@@ -76,16 +176,45 @@ extern "C" {
     XLOG_TIMESTAMP  = 1 << 0,
     XLOG_TAG        = 1 << 1,
     XLOG_SOURCEINFO = 1 << 2,
+    XLOG_MONOTONIC  = 1 << 3,   /* Seconds on the monotonic clock, to the microsecond */
     XLOG_DEFAULT    = XLOG_TAG | XLOG_TIMESTAMP | XLOG_SOURCEINFO
   } XLogComponent;
 
+  typedef enum
+  {
+    XLOG_ASYNC_DROP  = 0,    /* Discard the message when the thread's ring is full */
+    XLOG_ASYNC_BLOCK = 1,    /* Wait for the writer to make room */
+  } XLogOverflowPolicy;
+
+  typedef struct XLogAsync XLogAsync;
+
+  /**
+   * Call site of a deferred-format message. x_log_binary() declares one
+   * static descriptor per call site; the remaining fields are filled in the
+   * first time the site logs.
+   */
+  typedef struct
+  {
+    const char* fmt;
+    const char* file;
+    int line;
+    XLogLevel level;
+    const char* func;
+    volatile int32_t state;  /* 0 new, 1 ready, 2 being registered, -1 formatted on the caller */
+    uint32_t id;             /* Process-wide site number, used by binary logs */
+    int32_t arg_count;
+    uint8_t arg_types[X_LOG_BINARY_MAX_ARGS];
+  } XLogSite;
+
   typedef struct
   {
     FILE* console;           /* Console output stream (stdout/stderr). Defaults to stdout. */
     FILE* file;              /* Log file pointer (optional) */
     bool file_owned;         /* True if logger opened the file and should close it */
+    FILE* binary;            /* Binary log for deferred messages (optional, owned) */
     int outputs;             /* Which outputs enabled (console/file/both) */
     XLogLevel level;         /* Minimum level to log */
+    XLogAsync* async;        /* Background writer, NULL when logging synchronously */
 #ifdef _WIN32
     bool vt_enabled;         /* Windows VT ANSI mode enabled? */
 #endif
@@ -123,9 +252,63 @@ extern "C" {
 
   /**
    * @brief Shutdown the logging system and release resources.
+   *
+   * An asynchronous logger first writes everything still queued and stops its writer thread.
    */
   void x_log_close(XLogger* logger);
 
+  /**
+   * @brief Move a logger's output to a background writer thread.
+   *
+   * Messages are still filtered and formatted on the calling thread, then
+   * queued in a per-thread ring of `ring_size` bytes (0 for
+   * X_LOG_ASYNC_RING_SIZE). Call once, from a single thread, before the
+   * logger is shared.
+   * @param logger Logger to switch, or NULL for the default logger.
+   * @param ring_size Bytes per producer thread ring, rounded up to a power of two.
+   * @param policy What logging does when the calling thread's ring is full.
+   * @return true if the writer is running; false if it could not be started
+   * or the backend is not compiled in (see `X_LOG_ASYNC`).
+   */
+  bool x_log_start_async(XLogger* logger, size_t ring_size, XLogOverflowPolicy policy);
+
+  /**
+   * @brief Wait until every message logged so far has been written and flushed.
+   *
+   * For a synchronous logger this just flushes the output streams.
+   */
+  void x_log_flush(XLogger* logger);
+
+  /**
+   * @brief Number of messages an asynchronous logger discarded because a ring was full.
+   */
+  uint64_t x_log_dropped(const XLogger* logger);
+
+  /**
+   * @brief Send the logger's deferred messages to a binary log instead of formatting them.
+   *
+   * Only affects asynchronous loggers; call it before x_log_start_async().
+   * The file is truncated and closed by x_log_close().
+   * @return true if the file was opened.
+   */
+  bool x_log_open_binary(XLogger* logger, const char* filename);
+
+  /**
+   * @brief Emit a deferred-format message. Use the x_log_binary() macro instead.
+   * @param logger Logger context.
+   * @param site Static descriptor of the call site, holding format and level.
+   * @param func Source function name.
+   */
+  void x_log_binary_message(XLogger* logger, XLogSite* site, const char* func, ...);
+
+  /**
+   * @brief Convert a binary log written through x_log_open_binary() to text.
+   * @param in Binary log, opened for reading in binary mode.
+   * @param out Destination of the text lines.
+   * @return true if the whole log was decoded, false if it is not a binary log or is damaged.
+   */
+  bool x_log_decode(FILE* in, FILE* out);
+
   /**
    * @brief Set the output stream used for console logging.
    *
@@ -193,6 +376,16 @@ extern "C" {
    */
   void x_log_print(XLogger* logger, XLogLevel level, const char* fmt, ...);
 
+  /**
+   * @brief Whether a message of `level` would pass the logger's level filter.
+   *
+   * The level macros check this before evaluating their arguments.
+   */
+  static inline bool x_log_enabled(const XLogger* logger, XLogLevel level)
+  {
+    return logger == NULL || level >= logger->level;
+  }
+
   /**
    * @brief Platform- or user-defined break action for fatal logs.
    *
@@ -211,29 +404,62 @@ extern "C" {
 #define x_log_raw(logger, out, level, fg, bg, components, fmt, ...) \
   x_log_message_to((logger), (out), (level), (fg), (bg), (components), __FILE__, __LINE__, __func__, (fmt), ##__VA_ARGS__)
 
+/**
+ * @brief Emit a deferred-format log message.
+ *
+ * `fmt` must be a string literal. See "Deferred formatting" above.
+ */
+#define x_log_binary(logger, level, fmt, ...) \
+  do \
+  { \
+    static XLogSite x_log_site_ = { (fmt), __FILE__, __LINE__, (level), NULL, 0, 0, 0, {0} }; \
+    if ((level) >= X_LOG_MIN_LEVEL && x_log_enabled((logger), (level))) \
+      x_log_binary_message((logger), &x_log_site_, __func__, ##__VA_ARGS__); \
+  } while (0)
+
 /**
  * @brief Emit a debug-level log message.
  */
+#if X_LOG_MIN_LEVEL <= 0
 #define x_log_debug(logger, fmt, ...) \
-  x_log_message((logger), XLOG_LEVEL_DEBUG, XLOG_COLOR_BLUE, XLOG_COLOR_BLACK, XLOG_DEFAULT, __FILE__, __LINE__, __func__, (fmt), ##__VA_ARGS__)
+  (x_log_enabled((logger), XLOG_LEVEL_DEBUG) ? \
+   x_log_message((logger), XLOG_LEVEL_DEBUG, XLOG_COLOR_BLUE, XLOG_COLOR_BLACK, XLOG_DEFAULT, __FILE__, __LINE__, __func__, (fmt), ##__VA_ARGS__) : (void)0)
+#else
+#define x_log_debug(logger, fmt, ...) ((void)0)
+#endif
 
 /**
  * @brief Emit an informational log message with timestamp.
  */
+#if X_LOG_MIN_LEVEL <= 1
 #define x_log_info(logger, fmt, ...) \
-  x_log_message((logger), XLOG_LEVEL_INFO, XLOG_COLOR_WHITE, XLOG_COLOR_BLACK, XLOG_TIMESTAMP, __FILE__, __LINE__, __func__, (fmt), ##__VA_ARGS__)
+  (x_log_enabled((logger), XLOG_LEVEL_INFO) ? \
+   x_log_message((logger), XLOG_LEVEL_INFO, XLOG_COLOR_WHITE, XLOG_COLOR_BLACK, XLOG_TIMESTAMP, __FILE__, __LINE__, __func__, (fmt), ##__VA_ARGS__) : (void)0)
+#else
+#define x_log_info(logger, fmt, ...) ((void)0)
+#endif
 
 /**
  * @brief Emit a warning-level log message.
  */
+#if X_LOG_MIN_LEVEL <= 2
 #define x_log_warning(logger, fmt, ...) \
-  x_log_message((logger), XLOG_LEVEL_WARNING, XLOG_COLOR_YELLOW, XLOG_COLOR_BLACK, XLOG_DEFAULT, __FILE__, __LINE__, __func__, (fmt), ##__VA_ARGS__)
+  (x_log_enabled((logger), XLOG_LEVEL_WARNING) ? \
+   x_log_message((logger), XLOG_LEVEL_WARNING, XLOG_COLOR_YELLOW, XLOG_COLOR_BLACK, XLOG_DEFAULT, __FILE__, __LINE__, __func__, (fmt), ##__VA_ARGS__) : (void)0)
+#else
+#define x_log_warning(logger, fmt, ...) ((void)0)
+#endif
 
 /**
  * @brief Emit an error-level log message.
  */
+#if X_LOG_MIN_LEVEL <= 3
 #define x_log_error(logger, fmt, ...) \
-  x_log_message((logger), XLOG_LEVEL_ERROR, XLOG_COLOR_RED, XLOG_COLOR_BLACK, XLOG_DEFAULT, __FILE__, __LINE__, __func__, (fmt), ##__VA_ARGS__)
+  (x_log_enabled((logger), XLOG_LEVEL_ERROR) ? \
+   x_log_message((logger), XLOG_LEVEL_ERROR, XLOG_COLOR_RED, XLOG_COLOR_BLACK, XLOG_DEFAULT, __FILE__, __LINE__, __func__, (fmt), ##__VA_ARGS__) : (void)0)
+#else
+#define x_log_error(logger, fmt, ...) ((void)0)
+#endif
 
 /**
  * @brief Emit a fatal log message and trigger a break action.
@@ -257,10 +483,35 @@ extern "C" {
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
+#include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 
+#ifdef X_LOG_ASYNC
+#include "stdx_thread.h"
+#endif
+
+#ifndef X_LOG_ALLOC
+/**
+ * @brief Internal macro for allocating memory.
+ * To override how this header allocates memory, define this macro with a
+ * different implementation before including this header.
+ * @param sz  The size of memory to alloc.
+ */
+#define X_LOG_ALLOC(sz)        malloc(sz)
+#endif
+
+#ifndef X_LOG_FREE
+/**
+ * @brief Internal macro for freeing memory.
+ * To override how this header frees memory, define this macro with a
+ * different implementation before including this header.
+ * @param p  The address of memory region to free.
+ */
+#define X_LOG_FREE(p)          free(p)
+#endif
+
 #ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
@@ -277,8 +528,10 @@ extern "C" {
     .console = NULL,
     .file = NULL,
     .file_owned = false,
+    .binary = NULL,
     .outputs = XLOG_OUTPUT_CONSOLE,
     .level = XLOG_LEVEL_DEBUG,
+    .async = NULL,
 #ifdef _WIN32
     .vt_enabled = false,
 #endif
@@ -459,163 +712,1570 @@ extern "C" {
     }
   }
 
-  void x_log_set_console(XLogger* logger, FILE* out)
+  /* Deferred formatting */
+
+  /* How an argument is read from the va_list; every one is recorded as 8 bytes except strings */
+  enum
   {
-    logger = s_x_log_resolve(logger);
-    logger->console = (out != NULL) ? out : stdout;
-  }
+    X_LOG_ARG_INT = 1,
+    X_LOG_ARG_UINT,
+    X_LOG_ARG_LONG,
+    X_LOG_ARG_ULONG,
+    X_LOG_ARG_LLONG,
+    X_LOG_ARG_ULLONG,
+    X_LOG_ARG_SIZE,
+    X_LOG_ARG_PTRDIFF,
+    X_LOG_ARG_INTMAX,
+    X_LOG_ARG_UINTMAX,
+    X_LOG_ARG_DOUBLE,
+    X_LOG_ARG_LDOUBLE,
+    X_LOG_ARG_PTR,
+    X_LOG_ARG_STR,
+  };
 
-  FILE* x_log_get_console(const XLogger* logger)
+  static const char* s_x_log_level_strings[] =
   {
-    if (logger == NULL || logger->console == NULL)
+    "DEBUG",
+    "INFO",
+    "WARNING",
+    "ERROR",
+    "FATAL"
+  };
+
+  /* One printf conversion: `begin` points at the '%', `end` one past the conversion character */
+  typedef struct
+  {
+    const char* begin;
+    const char* end;
+    const char* length;      /* First length modifier character, or `end - 1` if none */
+    char conversion;
+    bool star_width;
+    bool star_precision;
+  } XLogSpec;
+
+  /* Parses the conversion at `p` (just past the '%'). Returns false on anything unsupported. */
+  static bool s_x_log_parse_spec(const char* p, XLogSpec* spec)
+  {
+    spec->begin = p - 1;
+    spec->star_width = false;
+    spec->star_precision = false;
+
+    while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
     {
-      return stdout;
+      p++;
+    }
+    if (*p == '*')
+    {
+      spec->star_width = true;
+      p++;
+    }
+    while (*p >= '0' && *p <= '9')
+    {
+      p++;
+    }
+    if (*p == '.')
+    {
+      p++;
+      if (*p == '*')
+      {
+        spec->star_precision = true;
+        p++;
+      }
+      while (*p >= '0' && *p <= '9')
+      {
+        p++;
+      }
     }
 
-    return logger->console;
+    spec->length = p;
+    while (*p == 'h' || *p == 'l' || *p == 'z' || *p == 'j' || *p == 't' || *p == 'L')
+    {
+      p++;
+    }
+    if (p - spec->length > 2 || *p == 0 || strchr("diouxXceEfFgGaAsp", *p) == NULL)
+    {
+      return false;
+    }
+    spec->conversion = *p;
+    spec->end = p + 1;
+    return true;
   }
 
-  static void s_x_log_vmessage_to(
-      XLogger* logger,
-      FILE* out,
-      XLogLevel level,
-      XLogColor fg,
-      XLogColor bg,
-      XLogComponent components,
-      const char* file,
-      int line,
-      const char* func,
-      const char* fmt,
-      va_list args
-      )
+  /* Argument class of a parsed conversion */
+  static uint8_t s_x_log_spec_arg(const XLogSpec* spec)
   {
-    static const char* x_log_level_strings[] =
+    const char* m = spec->length;
+    bool is_signed = (spec->conversion == 'd' || spec->conversion == 'i');
+
+    switch (spec->conversion)
     {
-      "DEBUG",
-      "INFO",
-      "WARNING",
-      "ERROR",
-      "FATAL"
-    };
+      case 's': return (*m == 'l') ? 0 : X_LOG_ARG_STR;   /* wide strings are not recorded */
+      case 'p': return X_LOG_ARG_PTR;
+      case 'c': return X_LOG_ARG_INT;
+      case 'e': case 'E': case 'f': case 'F':
+      case 'g': case 'G': case 'a': case 'A':
+        return (*m == 'L') ? X_LOG_ARG_LDOUBLE : X_LOG_ARG_DOUBLE;
+      default: break;
+    }
 
-    char timebuf[30] = {0};
-    char tag[32] = {0};
-    char source_info[1024] = {0};
-    char msgbuf[X_LOG_BUFFER_SIZE];
-    char finalbuf[X_LOG_BUFFER_SIZE + 1186];
-    FILE* console_out;
+    if (m[0] == 'l' && m[1] == 'l') return is_signed ? X_LOG_ARG_LLONG : X_LOG_ARG_ULLONG;
+    if (m[0] == 'l') return is_signed ? X_LOG_ARG_LONG : X_LOG_ARG_ULONG;
+    if (m[0] == 'z') return X_LOG_ARG_SIZE;
+    if (m[0] == 't') return X_LOG_ARG_PTRDIFF;
+    if (m[0] == 'j') return is_signed ? X_LOG_ARG_INTMAX : X_LOG_ARG_UINTMAX;
+    if (m[0] == 'L') return 0;
+    return is_signed ? X_LOG_ARG_INT : X_LOG_ARG_UINT;   /* h and hh arguments arrive promoted */
+  }
 
-    logger = s_x_log_resolve(logger);
+  /* Reads a recorded 8-byte value; returns false past the end of the payload */
+  static bool s_x_log_payload_u64(const uint8_t** p, const uint8_t* end, uint64_t* v)
+  {
+    if (end - *p < 8)
+    {
+      return false;
+    }
+    memcpy(v, *p, 8);
+    *p += 8;
+    return true;
+  }
 
-    if (level < logger->level)
+  static size_t s_x_log_advance(size_t cap, size_t len, int written)
+  {
+    if (written < 0)
     {
-      return;
+      return len;
     }
+    return (len + (size_t)written < cap) ? len + (size_t)written : cap - 1;
+  }
 
-    if (components & XLOG_TIMESTAMP)
+  /*
+   * Formats a recorded message. Each conversion is printed on its own, with
+   * `*` widths and precisions resolved into the spec and integer length
+   * modifiers replaced by `ll`, so every value goes through snprintf as the
+   * type it was recorded as. Returns the text length; `out` is terminated.
+   */
+  static size_t s_x_log_format_deferred(const char* fmt, const uint8_t* payload, size_t payload_len, char* out, size_t cap)
+  {
+    const uint8_t* p = payload;
+    const uint8_t* end = payload + payload_len;
+    const char* f = fmt;
+    const char* next;
+    size_t len = 0;
+    XLogSpec spec;
+    char conv[64];
+    char str[X_LOG_BINARY_MAX_STRING + 1];
+    uint64_t v;
+    double d;
+    int64_t star;
+    int n;
+    uint16_t slen;
+
+    out[0] = 0;
+    while (*f && len + 1 < cap)
     {
-      time_t t;
-      struct tm tm_info;
+      next = strchr(f, '%');
+      if (next == NULL)
+      {
+        next = f + strlen(f);
+      }
+      if (next > f)
+      {
+        n = (int)(next - f);
+        len = s_x_log_advance(cap, len, snprintf(out + len, cap - len, "%.*s", n, f));
+        f = next;
+        continue;
+      }
+      if (f[1] == '%')
+      {
+        len = s_x_log_advance(cap, len, snprintf(out + len, cap - len, "%%"));
+        f += 2;
+        continue;
+      }
+      if (!s_x_log_parse_spec(f + 1, &spec))
+      {
+        break;
+      }
 
-      t = time(NULL);
+      /* Rebuild the spec: flags and digits, resolved stars, our length modifier */
+      n = 0;
+      next = spec.begin;
+      while (next < spec.length && n < (int)sizeof(conv) - 24)
+      {
+        if (*next != '*')
+        {
+          conv[n++] = *next;
+        }
+        else
+        {
+          if (!s_x_log_payload_u64(&p, end, &v)) return len;
+          star = (int64_t)v;
+          if (next > spec.begin && next[-1] == '.')
+          {
+            if (star < 0) n--;   /* a negative precision means none */
+            else n += snprintf(conv + n, sizeof(conv) - n, "%d", (int)star);
+          }
+          else
+          {
+            n += snprintf(conv + n, sizeof(conv) - n, "%d", (int)star);
+          }
+        }
+        next++;
+      }
 
-#ifdef _WIN32
-      localtime_s(&tm_info, &t);
+      switch (s_x_log_spec_arg(&spec))
+      {
+        case X_LOG_ARG_STR:
+          if (end - p < 2) return len;
+          memcpy(&slen, p, 2);
+          p += 2;
+          if ((size_t)(end - p) < slen || slen > X_LOG_BINARY_MAX_STRING) return len;
+          memcpy(str, p, slen);
+          str[slen] = 0;
+          p += slen;
+          conv[n++] = 's';
+          conv[n] = 0;
+          len = s_x_log_advance(cap, len, snprintf(out + len, cap - len, conv, str));
+          break;
+
+        case X_LOG_ARG_DOUBLE:
+        case X_LOG_ARG_LDOUBLE:
+          if (!s_x_log_payload_u64(&p, end, &v)) return len;
+          memcpy(&d, &v, sizeof(d));
+          conv[n++] = spec.conversion;
+          conv[n] = 0;
+          len = s_x_log_advance(cap, len, snprintf(out + len, cap - len, conv, d));
+          break;
+
+        case X_LOG_ARG_PTR:
+          if (!s_x_log_payload_u64(&p, end, &v)) return len;
+          conv[n++] = 'p';
+          conv[n] = 0;
+          len = s_x_log_advance(cap, len, snprintf(out + len, cap - len, conv, (void*)(uintptr_t)v));
+          break;
+
+        default:
+          if (!s_x_log_payload_u64(&p, end, &v)) return len;
+          if (spec.conversion == 'c')
+          {
+            conv[n++] = 'c';
+            conv[n] = 0;
+            len = s_x_log_advance(cap, len, snprintf(out + len, cap - len, conv, (int)v));
+            break;
+          }
+          /* Narrow the value again for h and hh conversions */
+          if (spec.length[0] == 'h' && spec.length[1] == 'h') v = (spec.conversion == 'd' || spec.conversion == 'i') ? (uint64_t)(int64_t)(signed char)v : (uint64_t)(unsigned char)v;
+          else if (spec.length[0] == 'h') v = (spec.conversion == 'd' || spec.conversion == 'i') ? (uint64_t)(int64_t)(short)v : (uint64_t)(unsigned short)v;
+          conv[n++] = 'l';
+          conv[n++] = 'l';
+          conv[n++] = spec.conversion;
+          conv[n] = 0;
+          if (spec.conversion == 'd' || spec.conversion == 'i')
+          {
+            len = s_x_log_advance(cap, len, snprintf(out + len, cap - len, conv, (long long)(int64_t)v));
+          }
+          else
+          {
+            len = s_x_log_advance(cap, len, snprintf(out + len, cap - len, conv, (unsigned long long)v));
+          }
+          break;
+      }
+      f = spec.end;
+    }
+    return len;
+  }
+
+#if defined(_MSC_VER)
+#define X_LOG_THREAD_LOCAL __declspec(thread)
 #else
-      localtime_r(&t, &tm_info);
+#define X_LOG_THREAD_LOCAL __thread
 #endif
-      strftime(timebuf, sizeof(timebuf), "[%Y-%m-%d %H:%M:%S] ", &tm_info);
-    }
 
-    if (components & XLOG_TAG)
-    {
-      snprintf(tag, sizeof(tag), "%s ", x_log_level_strings[level]);
-    }
+  /* The last "[date time" prefix this thread formatted, reused within the same second */
+  typedef struct
+  {
+    time_t second;
+    size_t length;
+    char text[32];
+  } XLogTimeCache;
 
-    if (components & XLOG_SOURCEINFO)
-    {
-      snprintf(source_info, sizeof(source_info), "%s:%d %s() : ", file, line, func);
-    }
+  static X_LOG_THREAD_LOCAL XLogTimeCache s_x_log_time_cache = { (time_t)-1, 0, {0} };
 
-    /* Format the message body */
+  /* Writes "[YYYY-mm-dd HH:MM:SS" for `t` in local time. Returns its length. */
+  static size_t s_x_log_format_second(time_t t, char* out, size_t cap)
+  {
+    XLogTimeCache* cache = &s_x_log_time_cache;
+    struct tm tm_info;
+    size_t n;
+
+    if (cache->second != t)
+    {
 #ifdef _WIN32
-    vsnprintf_s(msgbuf, sizeof(msgbuf), _TRUNCATE, fmt, args);
+      localtime_s(&tm_info, &t);
 #else
-    vsnprintf(msgbuf, sizeof(msgbuf), fmt, args);
+      localtime_r(&t, &tm_info);
 #endif
+      cache->length = strftime(cache->text, sizeof(cache->text), "[%Y-%m-%d %H:%M:%S", &tm_info);
+      cache->second = t;
+    }
 
-    snprintf(
-        finalbuf,
-        sizeof(finalbuf),
-        "%s%s%s%s",
-        tag,
-        timebuf,
-        source_info,
-        msgbuf
-        );
+    n = cache->length < cap ? cache->length : cap - 1;
+    memcpy(out, cache->text, n);
+    out[n] = 0;
+    return n;
+  }
 
-    if (logger->outputs & XLOG_OUTPUT_CONSOLE)
-    {
-      console_out = (out != NULL) ? out : x_log_get_console(logger);
-      s_x_log_output_console(logger, console_out, fg, bg, finalbuf);
-    }
+  /* Monotonic clock in nanoseconds; the same clock stdx_time's XTimer reads */
+  static uint64_t s_x_log_monotonic_ns(void)
+  {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
 
-    if (logger->outputs & XLOG_OUTPUT_FILE)
+    if (freq.QuadPart == 0)
     {
-      s_x_log_output_file(logger, finalbuf);
+      QueryPerformanceFrequency(&freq);
     }
+    QueryPerformanceCounter(&now);
+    return (uint64_t)(now.QuadPart / freq.QuadPart) * 1000000000u
+      + (uint64_t)(now.QuadPart % freq.QuadPart) * 1000000000u / (uint64_t)freq.QuadPart;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
   }
 
-  void x_log_message_to(
-      XLogger* logger,
-      FILE* out,
+  /* Formats the text line of a deferred message: tag, timestamp, source and message */
+  static size_t s_x_log_format_binary_line(
       XLogLevel level,
-      XLogColor fg,
-      XLogColor bg,
-      XLogComponent components,
       const char* file,
       int line,
       const char* func,
       const char* fmt,
-      ...
+      uint64_t timestamp,
+      const uint8_t* payload,
+      size_t payload_len,
+      char* out,
+      size_t cap
       )
   {
-    va_list args;
+    size_t len;
 
-    va_start(args, fmt);
-    s_x_log_vmessage_to(logger, out, level, fg, bg, components, file, line, func, fmt, args);
-    va_end(args);
+    len = s_x_log_advance(cap, 0, snprintf(out, cap, "%s ", s_x_log_level_strings[level]));
+    len += s_x_log_format_second((time_t)(timestamp / 1000000000u), out + len, cap - len);
+    len = s_x_log_advance(cap, len, snprintf(out + len, cap - len, ".%06u] %s:%d %s() : ",
+          (unsigned)(timestamp % 1000000000u / 1000u), file, line, func));
+    return len + s_x_log_format_deferred(fmt, payload, payload_len, out + len, cap - len);
   }
 
-  void x_log_message(
-      XLogger* logger,
-      XLogLevel level,
-      XLogColor fg,
-      XLogColor bg,
-      XLogComponent components,
-      const char* file,
-      int line,
-      const char* func,
-      const char* fmt,
-      ...
-      )
+  static void s_x_log_level_colors(XLogLevel level, XLogColor* fg, XLogColor* bg)
   {
-    va_list args;
+    static const XLogColor colors[][2] =
+    {
+      { XLOG_COLOR_BLUE,   XLOG_COLOR_BLACK },
+      { XLOG_COLOR_WHITE,  XLOG_COLOR_BLACK },
+      { XLOG_COLOR_YELLOW, XLOG_COLOR_BLACK },
+      { XLOG_COLOR_RED,    XLOG_COLOR_BLACK },
+      { XLOG_COLOR_WHITE,  XLOG_COLOR_RED   },
+    };
 
-    va_start(args, fmt);
-    s_x_log_vmessage_to(logger, NULL, level, fg, bg, components, file, line, func, fmt, args);
-    va_end(args);
+    *fg = colors[level][0];
+    *bg = colors[level][1];
   }
 
-  void x_log_print(XLogger* logger, XLogLevel level, const char* fmt, ...)
+  /*
+   * Binary log layout, in the byte order of the machine that wrote it: the
+   * 8-byte magic, a uint32 byte-order mark, then entries that start with a
+   * type byte. A site entry (uint32 id, uint8 level, uint32 line, then
+   * uint16-length fmt, file and func strings) comes before the first event
+   * of its site; an event entry is a uint32 site id, a uint64 timestamp in
+   * nanoseconds and a uint32-length argument payload.
+   */
+#define X_LOG_BINARY_MAGIC "XLOGBIN1"
+#define X_LOG_BINARY_BOM   0x01020304u
+#define X_LOG_BINARY_SITE  1
+#define X_LOG_BINARY_EVENT 2
+
+  typedef struct
   {
-    va_list args;
+    char* fmt;
+    char* file;
+    char* func;
+    int line;
+    XLogLevel level;
+  } XLogDecodedSite;
+
+  static char* s_x_log_read_string(FILE* in)
+  {
+    uint16_t n;
+    char* s;
 
-    va_start(args, fmt);
+    if (fread(&n, sizeof(n), 1, in) != 1)
+    {
+      return NULL;
+    }
+    s = (char*)X_LOG_ALLOC((size_t)n + 1);
+    if (s != NULL && fread(s, 1, n, in) != n)
+    {
+      X_LOG_FREE(s);
+      return NULL;
+    }
+    if (s != NULL)
+    {
+      s[n] = 0;
+    }
+    return s;
+  }
+
+  bool x_log_decode(FILE* in, FILE* out)
+  {
+    char magic[8];
+    uint32_t bom;
+    uint8_t type;
+    uint32_t id;
+    uint8_t level;
+    uint32_t line;
+    uint64_t timestamp;
+    uint32_t payload_len;
+    uint8_t* payload = NULL;
+    uint32_t payload_cap = 0;
+    XLogDecodedSite* sites = NULL;
+    uint32_t site_count = 0;
+    uint32_t i;
+    char text[X_LOG_BUFFER_SIZE + 1186];
+    bool ok = false;
+
+    if (in == NULL || out == NULL
+        || fread(magic, 1, 8, in) != 8 || memcmp(magic, X_LOG_BINARY_MAGIC, 8) != 0
+        || fread(&bom, sizeof(bom), 1, in) != 1 || bom != X_LOG_BINARY_BOM)
+    {
+      return false;
+    }
+
+    while (fread(&type, 1, 1, in) == 1)
+    {
+      if (fread(&id, sizeof(id), 1, in) != 1)
+      {
+        goto done;
+      }
+
+      if (type == X_LOG_BINARY_SITE)
+      {
+        XLogDecodedSite* grown;
+        if (fread(&level, 1, 1, in) != 1 || level > XLOG_LEVEL_FATAL || fread(&line, sizeof(line), 1, in) != 1)
+        {
+          goto done;
+        }
+        if (id >= (1u << 20))
+        {
+          goto done;
+        }
+        if (id >= site_count)
+        {
+          grown = (XLogDecodedSite*)X_LOG_ALLOC(sizeof(XLogDecodedSite) * (id + 16));
+          if (grown == NULL)
+          {
+            goto done;
+          }
+          memset(grown, 0, sizeof(XLogDecodedSite) * (id + 16));
+          if (sites != NULL)
+          {
+            memcpy(grown, sites, sizeof(XLogDecodedSite) * site_count);
+            X_LOG_FREE(sites);
+          }
+          sites = grown;
+          site_count = id + 16;
+        }
+        if (sites[id].fmt != NULL)
+        {
+          goto done;
+        }
+        sites[id].level = (XLogLevel)level;
+        sites[id].line = (int)line;
+        sites[id].fmt = s_x_log_read_string(in);
+        sites[id].file = s_x_log_read_string(in);
+        sites[id].func = s_x_log_read_string(in);
+        if (sites[id].fmt == NULL || sites[id].file == NULL || sites[id].func == NULL)
+        {
+          goto done;
+        }
+      }
+      else if (type == X_LOG_BINARY_EVENT)
+      {
+        if (id >= site_count || sites[id].fmt == NULL
+            || fread(&timestamp, sizeof(timestamp), 1, in) != 1
+            || fread(&payload_len, sizeof(payload_len), 1, in) != 1
+            || payload_len > X_LOG_BINARY_MAX_ARGS * (X_LOG_BINARY_MAX_STRING + 2))
+        {
+          goto done;
+        }
+        if (payload_len > payload_cap)
+        {
+          X_LOG_FREE(payload);
+          payload_cap = payload_len;
+          payload = (uint8_t*)X_LOG_ALLOC(payload_cap);
+          if (payload == NULL)
+          {
+            goto done;
+          }
+        }
+        if (payload_len > 0 && fread(payload, 1, payload_len, in) != payload_len)
+        {
+          goto done;
+        }
+        s_x_log_format_binary_line(sites[id].level, sites[id].file, sites[id].line, sites[id].func,
+            sites[id].fmt, timestamp, payload, payload_len, text, sizeof(text));
+        fputs(text, out);
+      }
+      else
+      {
+        goto done;
+      }
+    }
+    ok = feof(in) != 0;
+
+done:
+    for (i = 0; i < site_count; i++)
+    {
+      X_LOG_FREE(sites[i].fmt);
+      X_LOG_FREE(sites[i].file);
+      X_LOG_FREE(sites[i].func);
+    }
+    X_LOG_FREE(sites);
+    X_LOG_FREE(payload);
+    return ok;
+  }
+
+  bool x_log_open_binary(XLogger* logger, const char* filename)
+  {
+    uint32_t bom = X_LOG_BINARY_BOM;
+    FILE* f;
+
+    logger = s_x_log_resolve(logger);
+    if (filename == NULL || logger->async != NULL)
+    {
+      return false;
+    }
+
+    f = fopen(filename, "wb");
+    if (f == NULL)
+    {
+      return false;
+    }
+    if (fwrite(X_LOG_BINARY_MAGIC, 1, 8, f) != 8 || fwrite(&bom, sizeof(bom), 1, f) != 1)
+    {
+      fclose(f);
+      return false;
+    }
+
+    if (logger->binary != NULL)
+    {
+      fclose(logger->binary);
+    }
+    logger->binary = f;
+    return true;
+  }
+
+  /* Asynchronous backend */
+
+#ifdef X_LOG_ASYNC
+
+#define X_LOG_RECORD_TEXT   1
+#define X_LOG_RECORD_PAD    2
+#define X_LOG_RECORD_BINARY 3
+
+  /*
+   * Ring records are 8-byte aligned. `size` covers the header, the body and
+   * the alignment padding, so the writer can step over a record without
+   * looking inside; a PAD record fills the tail of the ring when the next
+   * record does not fit before the wrap. A TEXT body is the formatted
+   * message; a BINARY body is an XLogBinaryHead and the recorded arguments.
+   */
+  typedef struct
+  {
+    uint32_t size;
+    uint8_t kind;
+    uint8_t level;
+    uint8_t fg;
+    uint8_t bg;
+    FILE* console;           /* Resolved console stream; the logger's outputs decide whether it is used */
+    uint32_t length;         /* Body bytes; text is followed by a terminator not counted here */
+  } XLogRecord;
+
+  typedef struct
+  {
+    XLogSite* site;
+    const char* func;
+    uint64_t timestamp;
+  } XLogBinaryHead;
+
+  /* Single-producer, single-consumer byte ring owned by one logging thread */
+  typedef struct XLogRing
+  {
+    volatile int64_t head;   /* Written by the producer */
+    int64_t reserved;        /* Producer only: head once the reserved record is committed */
+    int64_t tail_seen;       /* Producer only: last tail read, refreshed when the ring looks full */
+    char pad0[X_THREAD_CACHE_LINE_SIZE - 3 * sizeof(int64_t)];
+    volatile int64_t tail;   /* Written by the writer thread */
+    char pad1[X_THREAD_CACHE_LINE_SIZE - sizeof(int64_t)];
+    const void* thread;      /* Identity of the producing thread */
+    struct XLogRing* next;
+    char* data;
+    uint64_t mask;
+  } XLogRing;
+
+  struct XLogAsync
+  {
+    XLogger* logger;
+    int64_t id;
+    XLogRing* volatile rings;
+    size_t ring_size;
+    XLogOverflowPolicy policy;
+    XThread* thread;
+    XMutex* lock;
+    XCondVar* wake;          /* Signals the writer: new records, flush request or stop */
+    XCondVar* done;          /* Signals flushers that their request was written */
+    volatile int32_t sleeping;
+    volatile int32_t stop;
+    volatile int64_t flush_requested;
+    volatile int64_t flush_done;
+    volatile int64_t dropped;
+    char* console_batch;     /* Writer-side batches, one per destination */
+    size_t console_len;
+    FILE* console_out;
+    char* file_batch;
+    size_t file_len;
+    uint8_t* sites_written;  /* Per site id: already described in the binary log */
+    uint32_t sites_capacity;
+  };
+
+  static volatile int64_t s_x_log_async_ids;
+  static volatile int32_t s_x_log_site_ids;
+
+  /* Fills `types` with the va_list reads `fmt` needs. Returns their count, or -1 if it can't be deferred. */
+  static int32_t s_x_log_parse_format(const char* fmt, uint8_t* types, int32_t max)
+  {
+    XLogSpec spec;
+    int32_t count = 0;
+    uint8_t type;
+    const char* p = fmt;
+
+    while ((p = strchr(p, '%')) != NULL)
+    {
+      if (p[1] == '%')
+      {
+        p += 2;
+        continue;
+      }
+      if (!s_x_log_parse_spec(p + 1, &spec))
+      {
+        return -1;
+      }
+      type = s_x_log_spec_arg(&spec);
+      if (type == 0 || count + spec.star_width + spec.star_precision + 1 > max)
+      {
+        return -1;
+      }
+      if (spec.star_width) types[count++] = X_LOG_ARG_INT;
+      if (spec.star_precision) types[count++] = X_LOG_ARG_INT;
+      types[count++] = type;
+      p = spec.end;
+    }
+    return count;
+  }
+
+  /* Wall clock in nanoseconds since the Unix epoch */
+  static uint64_t s_x_log_now_ns(void)
+  {
+#ifdef _WIN32
+    FILETIME ft;
+    ULARGE_INTEGER t;
+
+    GetSystemTimeAsFileTime(&ft);
+    t.LowPart = ft.dwLowDateTime;
+    t.HighPart = ft.dwHighDateTime;
+    return (t.QuadPart - 116444736000000000ULL) * 100u;
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+  }
+  static X_THREAD_LOCAL char s_x_log_thread_token;
+  static X_THREAD_LOCAL XLogRing* s_x_log_thread_ring;
+  static X_THREAD_LOCAL int64_t s_x_log_thread_ring_owner;
+
+  static inline uint32_t s_x_log_align8(size_t n)
+  {
+    return (uint32_t)((n + 7u) & ~(size_t)7u);
+  }
+
+  /* Finds or registers the calling thread's ring. Registration is a lock-free push. */
+  static XLogRing* s_x_log_thread_ring_get(XLogAsync* a)
+  {
+    XLogRing* ring;
+
+    if (s_x_log_thread_ring != NULL && s_x_log_thread_ring_owner == a->id)
+    {
+      return s_x_log_thread_ring;
+    }
+
+    for (ring = (XLogRing*)x_atomic_load_ptr((void* volatile*)&a->rings); ring != NULL; ring = ring->next)
+    {
+      if (ring->thread == &s_x_log_thread_token)
+      {
+        break;
+      }
+    }
+
+    if (ring == NULL)
+    {
+      ring = (XLogRing*)X_LOG_ALLOC(sizeof(XLogRing));
+      if (ring == NULL)
+      {
+        return NULL;
+      }
+      memset(ring, 0, sizeof(*ring));
+      ring->data = (char*)X_LOG_ALLOC(a->ring_size);
+      if (ring->data == NULL)
+      {
+        X_LOG_FREE(ring);
+        return NULL;
+      }
+      ring->mask = a->ring_size - 1;
+      ring->thread = &s_x_log_thread_token;
+      do
+      {
+        ring->next = (XLogRing*)x_atomic_load_ptr((void* volatile*)&a->rings);
+      } while (!x_atomic_cas_ptr((void* volatile*)&a->rings, ring->next, ring));
+    }
+
+    s_x_log_thread_ring = ring;
+    s_x_log_thread_ring_owner = a->id;
+    return ring;
+  }
+
+  static void s_x_log_async_wake(XLogAsync* a)
+  {
+    if (x_atomic_load_i32(&a->sleeping))
+    {
+      x_thread_mutex_lock(a->lock);
+      x_thread_condvar_signal(a->wake);
+      x_thread_mutex_unlock(a->lock);
+    }
+  }
+
+  /*
+   * Reserves room for a record with a `length`-byte body in the calling
+   * thread's ring and fills in its header. Returns NULL if the message was
+   * dropped; otherwise publish it with s_x_log_async_commit().
+   */
+  static XLogRecord* s_x_log_async_reserve(XLogAsync* a, XLogRing* ring, uint8_t kind, XLogLevel level, size_t length)
+  {
+    XLogRecord* rec;
+    uint32_t need;
+    uint64_t capacity = ring->mask + 1;
+    int64_t head;
+    int64_t tail;
+    uint64_t offset;
+    uint64_t pad;
+    bool block;
+
+    need = s_x_log_align8(sizeof(XLogRecord) + length + 1);
+    block = (a->policy == XLOG_ASYNC_BLOCK) || level == XLOG_LEVEL_FATAL;
+    head = ring->head;
+    tail = ring->tail_seen;
+    offset = (uint64_t)head & ring->mask;
+    pad = (offset + need > capacity) ? capacity - offset : 0;
+    for (;;)
+    {
+      if ((uint64_t)(head - tail) + pad + need <= capacity)
+      {
+        break;
+      }
+      /* Only touch the writer's cache line when the stale tail says there is no room */
+      tail = x_atomic_load_acquire_i64(&ring->tail);
+      if ((uint64_t)(head - tail) + pad + need <= capacity)
+      {
+        break;
+      }
+      if (!block)
+      {
+        x_atomic_fetch_add_i64(&a->dropped, 1);
+        return NULL;
+      }
+      s_x_log_async_wake(a);
+      x_thread_yield();
+    }
+
+    if (pad > 0)
+    {
+      rec = (XLogRecord*)(ring->data + offset);
+      rec->size = (uint32_t)pad;
+      rec->kind = X_LOG_RECORD_PAD;
+      offset = 0;
+    }
+    ring->reserved = head + (int64_t)pad + need;
+    ring->tail_seen = tail;
+
+    rec = (XLogRecord*)(ring->data + offset);
+    rec->size = need;
+    rec->kind = kind;
+    rec->level = (uint8_t)level;
+    rec->length = (uint32_t)length;
+    return rec;
+  }
+
+  static void s_x_log_async_commit(XLogAsync* a, XLogRing* ring)
+  {
+    x_atomic_store_release_i64(&ring->head, ring->reserved);
+    s_x_log_async_wake(a);
+  }
+
+  /* Queues one formatted message. Returns false if it was dropped. */
+  static bool s_x_log_async_push(XLogAsync* a, XLogLevel level, XLogColor fg, XLogColor bg, FILE* console, const char* msg)
+  {
+    XLogRing* ring;
+    XLogRecord* rec;
+    size_t length;
+    size_t limit;
+
+    ring = s_x_log_thread_ring_get(a);
+    if (ring == NULL)
+    {
+      x_atomic_fetch_add_i64(&a->dropped, 1);
+      return false;
+    }
+
+    /* A record never takes more than half the ring, so it always fits once the ring drains */
+    limit = (size_t)((ring->mask + 1) / 2 - sizeof(XLogRecord) - 8);
+    length = strlen(msg);
+    if (length > limit)
+    {
+      length = limit;
+    }
+
+    rec = s_x_log_async_reserve(a, ring, X_LOG_RECORD_TEXT, level, length);
+    if (rec == NULL)
+    {
+      return false;
+    }
+    rec->fg = (uint8_t)fg;
+    rec->bg = (uint8_t)bg;
+    rec->console = console;
+    memcpy((char*)(rec + 1), msg, length);
+    ((char*)(rec + 1))[length] = 0;
+    s_x_log_async_commit(a, ring);
+    return true;
+  }
+
+  /* Parses a site's format the first time it logs. Returns false if it must be formatted on the caller. */
+  static bool s_x_log_site_ready(XLogSite* site)
+  {
+    int32_t state = x_atomic_load_i32(&site->state);
+
+    if (state == 1)
+    {
+      return true;
+    }
+    if (state != 0 || !x_atomic_cas_i32(&site->state, 0, 2))
+    {
+      return false;   /* unsupported, or another thread is registering it right now */
+    }
+
+    site->arg_count = s_x_log_parse_format(site->fmt, site->arg_types, X_LOG_BINARY_MAX_ARGS);
+    site->id = (uint32_t)x_atomic_fetch_add_i32(&s_x_log_site_ids, 1);
+    x_atomic_store_i32(&site->state, site->arg_count >= 0 ? 1 : -1);
+    return site->arg_count >= 0;
+  }
+
+  /* Records the raw arguments of a deferred message. Returns false if it was dropped. */
+  static bool s_x_log_async_push_binary(XLogAsync* a, XLogSite* site, const char* func, FILE* console, va_list args)
+  {
+    uint8_t payload[X_LOG_BINARY_MAX_ARGS * (X_LOG_BINARY_MAX_STRING + 2)];
+    size_t len = 0;
+    int32_t i;
+    uint64_t v;
+    double d;
+    const char* str;
+    size_t n;
+    uint16_t n16;
+    XLogRing* ring;
+    XLogRecord* rec;
+    XLogBinaryHead head;
+    XLogColor fg;
+    XLogColor bg;
+
+    head.timestamp = s_x_log_now_ns();
+    for (i = 0; i < site->arg_count; i++)
+    {
+      switch (site->arg_types[i])
+      {
+        case X_LOG_ARG_INT:     v = (uint64_t)(int64_t)va_arg(args, int); break;
+        case X_LOG_ARG_UINT:    v = (uint64_t)va_arg(args, unsigned int); break;
+        case X_LOG_ARG_LONG:    v = (uint64_t)(int64_t)va_arg(args, long); break;
+        case X_LOG_ARG_ULONG:   v = (uint64_t)va_arg(args, unsigned long); break;
+        case X_LOG_ARG_LLONG:   v = (uint64_t)va_arg(args, long long); break;
+        case X_LOG_ARG_ULLONG:  v = (uint64_t)va_arg(args, unsigned long long); break;
+        case X_LOG_ARG_SIZE:    v = (uint64_t)va_arg(args, size_t); break;
+        case X_LOG_ARG_PTRDIFF: v = (uint64_t)(int64_t)va_arg(args, ptrdiff_t); break;
+        case X_LOG_ARG_INTMAX:  v = (uint64_t)(int64_t)va_arg(args, intmax_t); break;
+        case X_LOG_ARG_UINTMAX: v = (uint64_t)va_arg(args, uintmax_t); break;
+        case X_LOG_ARG_PTR:     v = (uint64_t)(uintptr_t)va_arg(args, void*); break;
+        case X_LOG_ARG_DOUBLE:
+        case X_LOG_ARG_LDOUBLE:
+          d = (site->arg_types[i] == X_LOG_ARG_DOUBLE) ? va_arg(args, double) : (double)va_arg(args, long double);
+          memcpy(&v, &d, sizeof(v));
+          break;
+        default:
+          str = va_arg(args, const char*);
+          if (str == NULL) str = "(null)";
+          n = strlen(str);
+          n16 = (uint16_t)(n < X_LOG_BINARY_MAX_STRING ? n : X_LOG_BINARY_MAX_STRING);
+          memcpy(payload + len, &n16, 2);
+          memcpy(payload + len + 2, str, n16);
+          len += 2 + (size_t)n16;
+          continue;
+      }
+      memcpy(payload + len, &v, 8);
+      len += 8;
+    }
+
+    ring = s_x_log_thread_ring_get(a);
+    if (ring == NULL)
+    {
+      x_atomic_fetch_add_i64(&a->dropped, 1);
+      return false;
+    }
+    rec = s_x_log_async_reserve(a, ring, X_LOG_RECORD_BINARY, site->level, sizeof(head) + len);
+    if (rec == NULL)
+    {
+      return false;
+    }
+    s_x_log_level_colors(site->level, &fg, &bg);
+    rec->fg = (uint8_t)fg;
+    rec->bg = (uint8_t)bg;
+    rec->console = console;
+    head.site = site;
+    head.func = func;
+    memcpy((char*)(rec + 1), &head, sizeof(head));
+    memcpy((char*)(rec + 1) + sizeof(head), payload, len);
+    s_x_log_async_commit(a, ring);
+    return true;
+  }
+
+  static void s_x_log_batch_flush_console(XLogAsync* a)
+  {
+    if (a->console_len > 0 && a->console_out != NULL)
+    {
+      fwrite(a->console_batch, 1, a->console_len, a->console_out);
+    }
+    a->console_len = 0;
+  }
+
+  static void s_x_log_batch_flush_file(XLogAsync* a)
+  {
+    if (a->file_len > 0 && a->logger->file != NULL)
+    {
+      fwrite(a->file_batch, 1, a->file_len, a->logger->file);
+    }
+    a->file_len = 0;
+  }
+
+  static void s_x_log_batch_append(char* batch, size_t* len, const char* text, size_t n)
+  {
+    memcpy(batch + *len, text, n);
+    *len += n;
+  }
+
+  /* Adds one message to the batches of the outputs it goes to. `text` is terminated. */
+  static void s_x_log_async_write(XLogAsync* a, FILE* console, XLogColor fg, XLogColor bg, const char* text, size_t n)
+  {
+    XLogger* logger = a->logger;
+    char color[32];
+    int color_len;
+
+    if ((logger->outputs & XLOG_OUTPUT_CONSOLE) && console != NULL)
+    {
+      if (console != a->console_out)
+      {
+        s_x_log_batch_flush_console(a);
+        a->console_out = console;
+      }
+
+#ifdef _WIN32
+      if (!logger->vt_enabled)
+      {
+        /* The console API colors whole writes, so these go out one by one */
+        s_x_log_batch_flush_console(a);
+        s_x_log_output_console_winapi(console, fg, bg, text);
+      }
+      else
+#endif
+      {
+        color_len = snprintf(
+            color,
+            sizeof(color),
+            "\x1b[%d;%dm",
+            s_x_log_map_color_to_ansi(fg, true),
+            s_x_log_map_color_to_ansi(bg, false)
+            );
+        if (a->console_len + (size_t)color_len + n + 4 > X_LOG_ASYNC_BATCH_SIZE)
+        {
+          s_x_log_batch_flush_console(a);
+        }
+        s_x_log_batch_append(a->console_batch, &a->console_len, color, (size_t)color_len);
+        s_x_log_batch_append(a->console_batch, &a->console_len, text, n);
+        s_x_log_batch_append(a->console_batch, &a->console_len, "\x1b[0m", 4);
+      }
+    }
+
+    if ((logger->outputs & XLOG_OUTPUT_FILE) && logger->file != NULL)
+    {
+      if (a->file_len + n > X_LOG_ASYNC_BATCH_SIZE)
+      {
+        s_x_log_batch_flush_file(a);
+      }
+      s_x_log_batch_append(a->file_batch, &a->file_len, text, n);
+    }
+  }
+
+  static void s_x_log_binary_write_string(FILE* f, const char* s)
+  {
+    size_t n = strlen(s);
+    uint16_t n16 = (uint16_t)(n < 0xFFFFu ? n : 0xFFFFu);
+
+    fwrite(&n16, sizeof(n16), 1, f);
+    fwrite(s, 1, n16, f);
+  }
+
+  /* Appends a deferred message to the binary log, describing its site first if this log hasn't seen it */
+  static void s_x_log_binary_write(XLogAsync* a, const XLogBinaryHead* head, const uint8_t* payload, uint32_t payload_len)
+  {
+    FILE* f = a->logger->binary;
+    const XLogSite* site = head->site;
+    uint32_t line = (uint32_t)site->line;
+    uint8_t type;
+    uint8_t level;
+    uint8_t* grown;
+    uint32_t capacity;
+
+    if (site->id >= a->sites_capacity)
+    {
+      capacity = a->sites_capacity ? a->sites_capacity : 64;
+      while (capacity <= site->id)
+      {
+        capacity *= 2;
+      }
+      grown = (uint8_t*)X_LOG_ALLOC(capacity);
+      if (grown == NULL)
+      {
+        return;
+      }
+      memset(grown, 0, capacity);
+      if (a->sites_written != NULL)
+      {
+        memcpy(grown, a->sites_written, a->sites_capacity);
+        X_LOG_FREE(a->sites_written);
+      }
+      a->sites_written = grown;
+      a->sites_capacity = capacity;
+    }
+
+    if (!a->sites_written[site->id])
+    {
+      type = X_LOG_BINARY_SITE;
+      level = (uint8_t)site->level;
+      fwrite(&type, 1, 1, f);
+      fwrite(&site->id, sizeof(site->id), 1, f);
+      fwrite(&level, 1, 1, f);
+      fwrite(&line, sizeof(line), 1, f);
+      s_x_log_binary_write_string(f, site->fmt);
+      s_x_log_binary_write_string(f, site->file);
+      s_x_log_binary_write_string(f, head->func);
+      a->sites_written[site->id] = 1;
+    }
+
+    type = X_LOG_BINARY_EVENT;
+    fwrite(&type, 1, 1, f);
+    fwrite(&site->id, sizeof(site->id), 1, f);
+    fwrite(&head->timestamp, sizeof(head->timestamp), 1, f);
+    fwrite(&payload_len, sizeof(payload_len), 1, f);
+    fwrite(payload, 1, payload_len, f);
+  }
+
+  /* Writes a deferred message: raw to the binary log if there is one, formatted otherwise */
+  static void s_x_log_async_write_binary(XLogAsync* a, const XLogRecord* rec)
+  {
+    XLogBinaryHead head;
+    const uint8_t* payload = (const uint8_t*)(rec + 1) + sizeof(head);
+    uint32_t payload_len = rec->length - (uint32_t)sizeof(head);
+    const XLogSite* site;
+    char text[X_LOG_BUFFER_SIZE + 1186];
+    size_t n;
+
+    memcpy(&head, rec + 1, sizeof(head));
+    site = head.site;
+    if (a->logger->binary != NULL)
+    {
+      s_x_log_binary_write(a, &head, payload, payload_len);
+      return;
+    }
+
+    n = s_x_log_format_binary_line(site->level, site->file, site->line, head.func, site->fmt,
+        head.timestamp, payload, payload_len, text, sizeof(text));
+    s_x_log_async_write(a, rec->console, (XLogColor)rec->fg, (XLogColor)rec->bg, text, n);
+  }
+
+  /* Writes out every record queued so far. Returns the number of records written. */
+  static size_t s_x_log_async_drain(XLogAsync* a)
+  {
+    XLogRing* ring;
+    const XLogRecord* rec;
+    int64_t head;
+    int64_t tail;
+    size_t count = 0;
+
+    for (ring = (XLogRing*)x_atomic_load_ptr((void* volatile*)&a->rings); ring != NULL; ring = ring->next)
+    {
+      tail = ring->tail;
+      head = x_atomic_load_acquire_i64(&ring->head);
+      while (tail < head)
+      {
+        rec = (const XLogRecord*)(ring->data + ((uint64_t)tail & ring->mask));
+        if (rec->kind == X_LOG_RECORD_TEXT)
+        {
+          s_x_log_async_write(a, rec->console, (XLogColor)rec->fg, (XLogColor)rec->bg, (const char*)(rec + 1), rec->length);
+          count++;
+        }
+        else if (rec->kind == X_LOG_RECORD_BINARY)
+        {
+          s_x_log_async_write_binary(a, rec);
+          count++;
+        }
+        tail += rec->size;
+        x_atomic_store_release_i64(&ring->tail, tail);
+      }
+    }
+
+    if (count > 0)
+    {
+      s_x_log_batch_flush_console(a);
+      s_x_log_batch_flush_file(a);
+    }
+    return count;
+  }
+
+  static bool s_x_log_async_pending(XLogAsync* a)
+  {
+    XLogRing* ring;
+
+    for (ring = (XLogRing*)x_atomic_load_ptr((void* volatile*)&a->rings); ring != NULL; ring = ring->next)
+    {
+      if (x_atomic_load_acquire_i64(&ring->head) != ring->tail)
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static void* s_x_log_async_writer(void* arg)
+  {
+    XLogAsync* a = (XLogAsync*)arg;
+    int64_t flush_request;
+    int32_t stop;
+    size_t written;
+    int32_t idle = 0;
+
+    for (;;)
+    {
+      flush_request = x_atomic_load_i64(&a->flush_requested);
+      stop = x_atomic_load_i32(&a->stop);
+      written = s_x_log_async_drain(a);
+
+      if (x_atomic_load_i64(&a->flush_done) < flush_request)
+      {
+        if (a->console_out != NULL) fflush(a->console_out);
+        if (a->logger->file != NULL) fflush(a->logger->file);
+        if (a->logger->binary != NULL) fflush(a->logger->binary);
+        x_thread_mutex_lock(a->lock);
+        x_atomic_store_i64(&a->flush_done, flush_request);
+        x_thread_condvar_broadcast(a->done);
+        x_thread_mutex_unlock(a->lock);
+      }
+
+      if (written > 0)
+      {
+        idle = 0;
+        continue;
+      }
+      if (stop)
+      {
+        break;
+      }
+
+      /* Poll for a while before sleeping, so a busy logger's producers rarely need to signal */
+      if (idle < X_LOG_ASYNC_IDLE_POLLS && flush_request == x_atomic_load_i64(&a->flush_requested))
+      {
+        idle++;
+        x_thread_sleep_ms(1);
+        continue;
+      }
+
+      /* Producers signal only while `sleeping` is set, so check for work after setting it */
+      x_thread_mutex_lock(a->lock);
+      x_atomic_store_i32(&a->sleeping, 1);
+      if (!s_x_log_async_pending(a)
+          && !x_atomic_load_i32(&a->stop)
+          && x_atomic_load_i64(&a->flush_requested) == flush_request)
+      {
+        x_thread_condvar_wait(a->wake, a->lock);
+      }
+      x_atomic_store_i32(&a->sleeping, 0);
+      x_thread_mutex_unlock(a->lock);
+    }
+
+    if (a->console_out != NULL) fflush(a->console_out);
+    if (a->logger->file != NULL) fflush(a->logger->file);
+    if (a->logger->binary != NULL) fflush(a->logger->binary);
+    return NULL;
+  }
+
+  static void s_x_log_async_destroy(XLogAsync* a)
+  {
+    XLogRing* ring = a->rings;
+    XLogRing* next;
+
+    while (ring != NULL)
+    {
+      next = ring->next;
+      X_LOG_FREE(ring->data);
+      X_LOG_FREE(ring);
+      ring = next;
+    }
+    if (a->done) x_thread_condvar_destroy(a->done);
+    if (a->wake) x_thread_condvar_destroy(a->wake);
+    if (a->lock) x_thread_mutex_destroy(a->lock);
+    X_LOG_FREE(a->console_batch);
+    X_LOG_FREE(a->file_batch);
+    X_LOG_FREE(a->sites_written);
+    X_LOG_FREE(a);
+  }
+
+  static void s_x_log_async_flush(XLogAsync* a)
+  {
+    int64_t request;
+
+    x_thread_mutex_lock(a->lock);
+    request = x_atomic_fetch_add_i64(&a->flush_requested, 1) + 1;
+    x_thread_condvar_signal(a->wake);
+    while (x_atomic_load_i64(&a->flush_done) < request)
+    {
+      x_thread_condvar_wait(a->done, a->lock);
+    }
+    x_thread_mutex_unlock(a->lock);
+  }
+
+  static void s_x_log_async_stop(XLogAsync* a)
+  {
+    x_thread_mutex_lock(a->lock);
+    x_atomic_store_i32(&a->stop, 1);
+    x_thread_condvar_signal(a->wake);
+    x_thread_mutex_unlock(a->lock);
+
+    x_thread_join(a->thread);
+    x_thread_destroy(a->thread);
+    s_x_log_async_destroy(a);
+  }
+
+  bool x_log_start_async(XLogger* logger, size_t ring_size, XLogOverflowPolicy policy)
+  {
+    XLogAsync* a;
+    size_t size = 1024;
+
+    logger = s_x_log_resolve(logger);
+    if (logger->async != NULL)
+    {
+      return true;
+    }
+
+    if (ring_size == 0)
+    {
+      ring_size = X_LOG_ASYNC_RING_SIZE;
+    }
+    while (size < ring_size)
+    {
+      size <<= 1;
+    }
+
+    a = (XLogAsync*)X_LOG_ALLOC(sizeof(XLogAsync));
+    if (a == NULL)
+    {
+      return false;
+    }
+    memset(a, 0, sizeof(*a));
+    a->logger = logger;
+    a->id = x_atomic_fetch_add_i64(&s_x_log_async_ids, 1) + 1;
+    a->ring_size = size;
+    a->policy = policy;
+    a->console_batch = (char*)X_LOG_ALLOC(X_LOG_ASYNC_BATCH_SIZE);
+    a->file_batch = (char*)X_LOG_ALLOC(X_LOG_ASYNC_BATCH_SIZE);
+
+    if (a->console_batch == NULL || a->file_batch == NULL
+        || x_thread_mutex_init(&a->lock) != 0
+        || x_thread_condvar_init(&a->wake) != 0
+        || x_thread_condvar_init(&a->done) != 0
+        || x_thread_create(&a->thread, s_x_log_async_writer, a) != 0)
+    {
+      s_x_log_async_destroy(a);
+      return false;
+    }
+
+    logger->async = a;
+    return true;
+  }
+
+  uint64_t x_log_dropped(const XLogger* logger)
+  {
+    if (logger == NULL)
+    {
+      logger = &s_x_log_default_logger;
+    }
+    return logger->async ? (uint64_t)x_atomic_load_i64(&logger->async->dropped) : 0;
+  }
+
+#else
+
+  bool x_log_start_async(XLogger* logger, size_t ring_size, XLogOverflowPolicy policy)
+  {
+    (void)logger;
+    (void)ring_size;
+    (void)policy;
+    return false;
+  }
+
+  uint64_t x_log_dropped(const XLogger* logger)
+  {
+    (void)logger;
+    return 0;
+  }
+
+#endif /* X_LOG_ASYNC */
+
+  void x_log_flush(XLogger* logger)
+  {
+    logger = s_x_log_resolve(logger);
+
+#ifdef X_LOG_ASYNC
+    if (logger->async != NULL)
+    {
+      s_x_log_async_flush(logger->async);
+      return;
+    }
+#endif
+
+    fflush(x_log_get_console(logger));
+    if (logger->file != NULL)
+    {
+      fflush(logger->file);
+    }
+  }
+
+  void x_log_set_console(XLogger* logger, FILE* out)
+  {
+    logger = s_x_log_resolve(logger);
+    logger->console = (out != NULL) ? out : stdout;
+  }
+
+  FILE* x_log_get_console(const XLogger* logger)
+  {
+    if (logger == NULL || logger->console == NULL)
+    {
+      return stdout;
+    }
+
+    return logger->console;
+  }
+
+  static void s_x_log_vmessage_to(
+      XLogger* logger,
+      FILE* out,
+      XLogLevel level,
+      XLogColor fg,
+      XLogColor bg,
+      XLogComponent components,
+      const char* file,
+      int line,
+      const char* func,
+      const char* fmt,
+      va_list args
+      )
+  {
+    char timebuf[64] = {0};
+    size_t timelen = 0;
+    char tag[32] = {0};
+    char source_info[1024] = {0};
+    char msgbuf[X_LOG_BUFFER_SIZE];
+    char finalbuf[X_LOG_BUFFER_SIZE + 1186];
+    FILE* console_out;
+
+    logger = s_x_log_resolve(logger);
+
+    if (level < logger->level)
+    {
+      return;
+    }
+
+    if (components & XLOG_TIMESTAMP)
+    {
+      timelen = s_x_log_format_second(time(NULL), timebuf, sizeof(timebuf) - 2);
+      timebuf[timelen++] = ']';
+      timebuf[timelen++] = ' ';
+      timebuf[timelen] = 0;
+    }
+
+    if (components & XLOG_MONOTONIC)
+    {
+      uint64_t ns = s_x_log_monotonic_ns();
+      snprintf(timebuf + timelen, sizeof(timebuf) - timelen, "[%llu.%06u] ",
+          (unsigned long long)(ns / 1000000000u), (unsigned)(ns % 1000000000u / 1000u));
+    }
+
+    if (components & XLOG_TAG)
+    {
+      snprintf(tag, sizeof(tag), "%s ", s_x_log_level_strings[level]);
+    }
+
+    if (components & XLOG_SOURCEINFO)
+    {
+      snprintf(source_info, sizeof(source_info), "%s:%d %s() : ", file, line, func);
+    }
+
+    /* Format the message body */
+#ifdef _WIN32
+    vsnprintf_s(msgbuf, sizeof(msgbuf), _TRUNCATE, fmt, args);
+#else
+    vsnprintf(msgbuf, sizeof(msgbuf), fmt, args);
+#endif
+
+    snprintf(
+        finalbuf,
+        sizeof(finalbuf),
+        "%s%s%s%s",
+        tag,
+        timebuf,
+        source_info,
+        msgbuf
+        );
+
+    console_out = (out != NULL) ? out : x_log_get_console(logger);
+
+#ifdef X_LOG_ASYNC
+    if (logger->async != NULL)
+    {
+      s_x_log_async_push(logger->async, level, fg, bg, console_out, finalbuf);
+      if (level == XLOG_LEVEL_FATAL)
+      {
+        s_x_log_async_flush(logger->async);
+      }
+      return;
+    }
+#endif
+
+    if (logger->outputs & XLOG_OUTPUT_CONSOLE)
+    {
+      s_x_log_output_console(logger, console_out, fg, bg, finalbuf);
+    }
+
+    if (logger->outputs & XLOG_OUTPUT_FILE)
+    {
+      s_x_log_output_file(logger, finalbuf);
+    }
+  }
+
+  void x_log_message_to(
+      XLogger* logger,
+      FILE* out,
+      XLogLevel level,
+      XLogColor fg,
+      XLogColor bg,
+      XLogComponent components,
+      const char* file,
+      int line,
+      const char* func,
+      const char* fmt,
+      ...
+      )
+  {
+    va_list args;
+
+    va_start(args, fmt);
+    s_x_log_vmessage_to(logger, out, level, fg, bg, components, file, line, func, fmt, args);
+    va_end(args);
+  }
+
+  void x_log_message(
+      XLogger* logger,
+      XLogLevel level,
+      XLogColor fg,
+      XLogColor bg,
+      XLogComponent components,
+      const char* file,
+      int line,
+      const char* func,
+      const char* fmt,
+      ...
+      )
+  {
+    va_list args;
+
+    va_start(args, fmt);
+    s_x_log_vmessage_to(logger, NULL, level, fg, bg, components, file, line, func, fmt, args);
+    va_end(args);
+  }
+
+  void x_log_print(XLogger* logger, XLogLevel level, const char* fmt, ...)
+  {
+    va_list args;
+
+    va_start(args, fmt);
     s_x_log_vmessage_to(logger, NULL, level, XLOG_COLOR_DEFAULT, XLOG_COLOR_DEFAULT, XLOG_PLAIN, NULL, 0, NULL, fmt, args);
     va_end(args);
   }
 
+  void x_log_binary_message(XLogger* logger, XLogSite* site, const char* func, ...)
+  {
+    va_list args;
+    XLogColor fg;
+    XLogColor bg;
+
+    logger = s_x_log_resolve(logger);
+    if (site->level < logger->level)
+    {
+      return;
+    }
+
+    va_start(args, func);
+#ifdef X_LOG_ASYNC
+    if (logger->async != NULL && s_x_log_site_ready(site))
+    {
+      s_x_log_async_push_binary(logger->async, site, func, x_log_get_console(logger), args);
+      va_end(args);
+      if (site->level == XLOG_LEVEL_FATAL)
+      {
+        s_x_log_async_flush(logger->async);
+      }
+      return;
+    }
+#endif
+    s_x_log_level_colors(site->level, &fg, &bg);
+    s_x_log_vmessage_to(logger, NULL, site->level, fg, bg, XLOG_DEFAULT, site->file, site->line, func, site->fmt, args);
+    va_end(args);
+  }
+
   /* Initialize logger */
   void x_log_init(XLogger* logger, XLogOutputFlags outputs, XLogLevel level, const char* filename)
   {
@@ -627,8 +2287,10 @@ extern "C" {
     logger->console = stdout;
     logger->file = NULL;
     logger->file_owned = false;
+    logger->binary = NULL;
     logger->outputs = outputs;
     logger->level = level;
+    logger->async = NULL;
 #ifdef _WIN32
     logger->vt_enabled = false;
     s_x_log_enable_windows_vt(logger);
@@ -652,6 +2314,14 @@ extern "C" {
   {
     logger = s_x_log_resolve(logger);
 
+#ifdef X_LOG_ASYNC
+    if (logger->async != NULL)
+    {
+      s_x_log_async_stop(logger->async);
+      logger->async = NULL;
+    }
+#endif
+
     if (logger->file && logger->file_owned)
     {
       fclose(logger->file);
@@ -659,6 +2329,12 @@ extern "C" {
 
     logger->file = NULL;
     logger->file_owned = false;
+
+    if (logger->binary)
+    {
+      fclose(logger->binary);
+    }
+    logger->binary = NULL;
   }
 
 #ifdef __cplusplus
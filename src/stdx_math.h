@@ -9,6 +9,20 @@
  * Usage:
  * #define X_IMPL_MATH
  * #include "stdx_math.h"
+ *
+ * SIMD:
+ *  Vec4, Quat and Mat4 operations use SSE2 on x86 and NEON on aarch64.
+ *  On x86 the batch kernels also have AVX2 and AVX-512F versions picked at
+ *  runtime, so the implementation brings in the stdx_cpuid implementation
+ *  unless X_IMPL_CPUID is already defined.
+ *  Every lane keeps the scalar evaluation order, so results match the
+ *  scalar build bit for bit (unless the compiler contracts the scalar code
+ *  into FMAs), except mat4_inverse, whose SSE path works on 2x2 blocks and
+ *  rounds differently.
+ *  Define X_MATH_NO_SIMD to build only the scalar versions, e.g. when
+ *  results must match across architectures and compilers.
+ *  Define X_MATH_ALIGN16 (in every translation unit) to give Vec4, Quat and
+ *  Mat4 16-byte alignment so they are loaded with aligned moves.
  */
 
 #ifndef X_MATH_H
@@ -27,6 +41,7 @@
 
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifndef STDXM_EPS
@@ -36,6 +51,14 @@
 #define STDXM_PI 3.14159265358979323846f
 #endif
 
+#if defined(X_MATH_ALIGN16) && defined(_MSC_VER)
+#define X_MATH_ALIGNAS __declspec(align(16))
+#elif defined(X_MATH_ALIGN16)
+#define X_MATH_ALIGNAS __attribute__((aligned(16)))
+#else
+#define X_MATH_ALIGNAS
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -48,7 +71,7 @@ typedef struct {
   float x, y, z;
 } Vec3;
 
-typedef struct {
+typedef struct X_MATH_ALIGNAS {
   float x, y, z, w;
 } Vec4;
 
@@ -60,11 +83,11 @@ typedef struct {
   float m[9];
 } Mat3;
 
-typedef struct {
+typedef struct X_MATH_ALIGNAS {
   float m[16];
 } Mat4;
 
-typedef struct {
+typedef struct X_MATH_ALIGNAS {
   float x, y, z, w;
 } Quat;
 
@@ -208,6 +231,8 @@ X_MATH_API Mat4 mat4_inverse_affine(
     Mat4 m); /* Fast inverse for affine TRS without shear */
 X_MATH_API Mat4 mat4_inverse_affine_uniform_scale(Mat4 m);
 X_MATH_API Mat4 mat4_inverse_full(Mat4 m, bool* ok);
+X_MATH_API Mat4 mat4_inverse(
+    Mat4 m, bool* ok); /* Fast general inverse; identity and *ok = false if singular */
 X_MATH_API Mat4 mat4_look_at_rh(Vec3 eye, Vec3 target, Vec3 up); /**< Right-handed view */
 X_MATH_API Mat4 mat4_look_at_lh(Vec3 eye, Vec3 target, Vec3 up); /**< Left-handed view */
 X_MATH_API Mat4 mat4_perspective_rh_no(
@@ -270,12 +295,110 @@ X_MATH_API Vec3 quatdual_mul_vec3_rot(QuatDual qd, Vec3 v); /* Rotate vector onl
 X_MATH_API Vec3 quatdual_mul_vec3(
     QuatDual qd, Vec3 v); /* Full transform (rotate + translate) */
 
+/**
+ * Batch kernels over structure-of-arrays streams.
+ * Each call processes `n` elements and runs four lanes at a time on
+ * SSE2/NEON, or eight and sixteen on CPUs with AVX2/AVX-512F, with results
+ * equal to the per-element functions for finite input. Elements are independent, so a large batch can be split across
+ * threads (e.g. with x_threadpool_parallel_for) by offsetting every array
+ * pointer by the chunk start; for the cull functions chunks must start on a
+ * multiple of 32 and the mask pointer is offset by start / 32.
+ */
+
+/** Frustum planes (x, y, z, w) with normals pointing inside: left, right,
+ * bottom, top, near, far. A point p is inside when dot(n, p) + w >= 0. */
+typedef struct {
+  Vec4 planes[6];
+} Frustum;
+
+X_MATH_API Frustum frustum_from_mat4(
+    Mat4 view_proj, bool zero_to_one); /* Extract normalized planes; zero_to_one for ZO depth */
+X_MATH_API void mat4_transform_points(Mat4 m, const float* xs, const float* ys,
+    const float* zs, float* out_x, float* out_y, float* out_z,
+    size_t n); /* mat4_mul_point over arrays; outputs may alias inputs */
+X_MATH_API void mat4_transform_dirs(Mat4 m, const float* xs, const float* ys,
+    const float* zs, float* out_x, float* out_y, float* out_z,
+    size_t n); /* mat4_mul_dir over arrays; outputs may alias inputs */
+X_MATH_API void frustum_cull_spheres(const Frustum* f, const float* xs, const float* ys,
+    const float* zs, const float* radii, size_t n,
+    uint32_t* out_mask); /* Bit i of the mask set when sphere i is (partly) inside; (n + 31) / 32 words */
+X_MATH_API void frustum_cull_aabbs(const Frustum* f, const float* cx, const float* cy,
+    const float* cz, const float* ex, const float* ey, const float* ez, size_t n,
+    uint32_t* out_mask); /* Same for boxes given by center and half extents */
+X_MATH_API void quat_slerp_array(const Quat* a, const Quat* b, float t, size_t n,
+    Quat* out); /* quat_slerp(a[i], b[i], t) */
+X_MATH_API void mat4_compose_array(const Vec3* t, const Quat* r, const Vec3* s, size_t n,
+    Mat4* out); /* T * R * S per element, without the two full matrix products */
+
 #ifdef __cplusplus
 }
 #endif
 
 #ifdef X_IMPL_MATH
 
+#if !defined(X_MATH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define X_MATH_SIMD_SSE 1
+#include <emmintrin.h>
+#include <immintrin.h>
+#ifndef X_IMPL_CPUID
+#define X_INTERNAL_CPUID_IMPL
+#define X_IMPL_CPUID
+#endif
+#include "stdx_cpuid.h"
+#elif !defined(X_MATH_NO_SIMD) && ((defined(__aarch64__) && defined(__ARM_NEON)) || defined(_M_ARM64))
+#define X_MATH_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if X_MATH_SIMD_SSE
+typedef __m128 XMathV4;
+#if defined(X_MATH_ALIGN16)
+#define s_xm_load(p) _mm_load_ps(p)
+#define s_xm_store(p, v) _mm_store_ps((p), (v))
+#else
+#define s_xm_load(p) _mm_loadu_ps(p)
+#define s_xm_store(p, v) _mm_storeu_ps((p), (v))
+#endif
+#define s_xm_add(a, b) _mm_add_ps((a), (b))
+#define s_xm_sub(a, b) _mm_sub_ps((a), (b))
+#define s_xm_mul(a, b) _mm_mul_ps((a), (b))
+#define s_xm_div(a, b) _mm_div_ps((a), (b))
+#define s_xm_set1(s) _mm_set1_ps(s)
+#define s_xm_abs(a) _mm_andnot_ps(_mm_set1_ps(-0.0f), (a))
+#define s_xm_lane(v, i) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(i, i, i, i))
+/* result lanes are v[a], v[b], v[c], v[d] */
+#define s_xm_swizzle(v, a, b, c, d) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(d, c, b, a))
+#define s_xm_shuffle(v, w, a, b, c, d) _mm_shuffle_ps((v), (w), _MM_SHUFFLE(d, c, b, a))
+#define s_xm_negate(v, sx, sy, sz, sw) _mm_xor_ps((v), _mm_setr_ps(sx, sy, sz, sw))
+#elif X_MATH_SIMD_NEON
+typedef float32x4_t XMathV4;
+#define s_xm_load(p) vld1q_f32(p)
+#define s_xm_store(p, v) vst1q_f32((p), (v))
+#define s_xm_add(a, b) vaddq_f32((a), (b))
+#define s_xm_sub(a, b) vsubq_f32((a), (b))
+#define s_xm_mul(a, b) vmulq_f32((a), (b))
+#define s_xm_div(a, b) vdivq_f32((a), (b))
+#define s_xm_set1(s) vdupq_n_f32(s)
+#define s_xm_abs(a) vabsq_f32(a)
+#define s_xm_lane(v, i) vdupq_laneq_f32((v), i)
+#endif
+
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+/* a[0] + a[1] + a[2] + a[3], added left to right like the scalar code */
+static inline float s_xm_sum_ordered(XMathV4 a)
+{
+#if X_MATH_SIMD_SSE
+  __m128 r = _mm_add_ss(a, s_xm_lane(a, 1));
+  r = _mm_add_ss(r, s_xm_lane(a, 2));
+  r = _mm_add_ss(r, s_xm_lane(a, 3));
+  return _mm_cvtss_f32(r);
+#else
+  return ((vgetq_lane_f32(a, 0) + vgetq_lane_f32(a, 1)) + vgetq_lane_f32(a, 2))
+      + vgetq_lane_f32(a, 3);
+#endif
+}
+#endif
+
 float float_clamp(float x, float a, float b) { return x < a ? a : (x > b ? b : x); }
 
 float float_lerp(float a, float b, float t) { return a + (b - a) * t; }
@@ -498,6 +621,58 @@ X_MATH_API Vec4 vec4_make(float x, float y, float z, float w)
   return (Vec4) { x, y, z, w };
 }
 
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+
+X_MATH_API Vec4 vec4_add(Vec4 a, Vec4 b)
+{
+  Vec4 r;
+  s_xm_store(&r.x, s_xm_add(s_xm_load(&a.x), s_xm_load(&b.x)));
+  return r;
+}
+
+X_MATH_API Vec4 vec4_sub(Vec4 a, Vec4 b)
+{
+  Vec4 r;
+  s_xm_store(&r.x, s_xm_sub(s_xm_load(&a.x), s_xm_load(&b.x)));
+  return r;
+}
+
+X_MATH_API Vec4 vec4_mul(Vec4 a, float s)
+{
+  Vec4 r;
+  s_xm_store(&r.x, s_xm_mul(s_xm_load(&a.x), s_xm_set1(s)));
+  return r;
+}
+
+X_MATH_API Vec4 vec4_mul_vec4(Vec4 a, Vec4 b)
+{
+  Vec4 r;
+  s_xm_store(&r.x, s_xm_mul(s_xm_load(&a.x), s_xm_load(&b.x)));
+  return r;
+}
+
+X_MATH_API Vec4 vec4_div(Vec4 a, float s)
+{
+  Vec4 r;
+  s_xm_store(&r.x, s_xm_div(s_xm_load(&a.x), s_xm_set1(s)));
+  return r;
+}
+
+X_MATH_API float vec4_dot(Vec4 a, Vec4 b)
+{
+  return s_xm_sum_ordered(s_xm_mul(s_xm_load(&a.x), s_xm_load(&b.x)));
+}
+
+X_MATH_API Vec4 vec4_lerp(Vec4 a, Vec4 b, float t)
+{
+  XMathV4 va = s_xm_load(&a.x);
+  Vec4 r;
+  s_xm_store(&r.x, s_xm_add(va, s_xm_mul(s_xm_sub(s_xm_load(&b.x), va), s_xm_set1(t))));
+  return r;
+}
+
+#else
+
 X_MATH_API Vec4 vec4_add(Vec4 a, Vec4 b)
 {
   return vec4_make(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
@@ -534,17 +709,32 @@ X_MATH_API Vec4 vec4_lerp(Vec4 a, Vec4 b, float t)
       float_lerp(a.z, b.z, t), float_lerp(a.w, b.w, t));
 }
 
+#endif
+
 X_MATH_API Vec4 vec4_smoothstep(Vec4 a, Vec4 b, float t)
 {
   return vec4_make(float_smoothstep(a.x, b.x, t), float_smoothstep(a.y, b.y, t),
       float_smoothstep(a.z, b.z, t), float_smoothstep(a.w, b.w, t));
 }
 
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+
+X_MATH_API Vec4 vec4_abs(Vec4 v)
+{
+  Vec4 r;
+  s_xm_store(&r.x, s_xm_abs(s_xm_load(&v.x)));
+  return r;
+}
+
+#else
+
 X_MATH_API Vec4 vec4_abs(Vec4 v)
 {
   return vec4_make(fabsf(v.x), fabsf(v.y), fabsf(v.z), fabsf(v.w));
 }
 
+#endif
+
 X_MATH_API Mat2 mat2_identity(void)
 {
   Mat2 M = { { 1, 0, 0, 1 } };
@@ -665,6 +855,33 @@ X_MATH_API Mat4 mat4_make(float xx, float xy, float xz, float xw, float yx, floa
   return M;
 }
 
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+
+X_MATH_API Mat4 mat4_transpose(Mat4 a)
+{
+  Mat4 r;
+#if X_MATH_SIMD_SSE
+  __m128 c0 = s_xm_load(a.m + 0);
+  __m128 c1 = s_xm_load(a.m + 4);
+  __m128 c2 = s_xm_load(a.m + 8);
+  __m128 c3 = s_xm_load(a.m + 12);
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+  s_xm_store(r.m + 0, c0);
+  s_xm_store(r.m + 4, c1);
+  s_xm_store(r.m + 8, c2);
+  s_xm_store(r.m + 12, c3);
+#else
+  float32x4x4_t t = vld4q_f32(a.m);
+  s_xm_store(r.m + 0, t.val[0]);
+  s_xm_store(r.m + 4, t.val[1]);
+  s_xm_store(r.m + 8, t.val[2]);
+  s_xm_store(r.m + 12, t.val[3]);
+#endif
+  return r;
+}
+
+#else
+
 X_MATH_API Mat4 mat4_transpose(Mat4 a)
 {
   Mat4 r = a;
@@ -683,6 +900,57 @@ X_MATH_API Mat4 mat4_transpose(Mat4 a)
   return r;
 }
 
+#endif
+
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+
+/* c = a·b (apply b then a); each column of c is a's columns weighted by b's */
+X_MATH_API Mat4 mat4_mul(Mat4 a, Mat4 b)
+{
+  XMathV4 a0 = s_xm_load(a.m + 0);
+  XMathV4 a1 = s_xm_load(a.m + 4);
+  XMathV4 a2 = s_xm_load(a.m + 8);
+  XMathV4 a3 = s_xm_load(a.m + 12);
+  Mat4 r;
+  for (int c = 0; c < 4; c++) {
+    XMathV4 bc = s_xm_load(b.m + c * 4);
+    XMathV4 v = s_xm_mul(a0, s_xm_lane(bc, 0));
+    v = s_xm_add(v, s_xm_mul(a1, s_xm_lane(bc, 1)));
+    v = s_xm_add(v, s_xm_mul(a2, s_xm_lane(bc, 2)));
+    v = s_xm_add(v, s_xm_mul(a3, s_xm_lane(bc, 3)));
+    s_xm_store(r.m + c * 4, v);
+  }
+  return r;
+}
+
+X_MATH_API Vec3 mat4_mul_point(Mat4 m, Vec3 p)
+{
+  XMathV4 v = s_xm_mul(s_xm_load(m.m + 0), s_xm_set1(p.x));
+  v = s_xm_add(v, s_xm_mul(s_xm_load(m.m + 4), s_xm_set1(p.y)));
+  v = s_xm_add(v, s_xm_mul(s_xm_load(m.m + 8), s_xm_set1(p.z)));
+  v = s_xm_add(v, s_xm_load(m.m + 12));
+  Vec4 r;
+  s_xm_store(&r.x, v);
+  if (!float_is_zero(r.w)) {
+    r.x /= r.w;
+    r.y /= r.w;
+    r.z /= r.w;
+  }
+  return vec3_make(r.x, r.y, r.z);
+}
+
+X_MATH_API Vec3 mat4_mul_dir(Mat4 m, Vec3 v)
+{
+  XMathV4 t = s_xm_mul(s_xm_load(m.m + 0), s_xm_set1(v.x));
+  t = s_xm_add(t, s_xm_mul(s_xm_load(m.m + 4), s_xm_set1(v.y)));
+  t = s_xm_add(t, s_xm_mul(s_xm_load(m.m + 8), s_xm_set1(v.z)));
+  Vec4 r;
+  s_xm_store(&r.x, t);
+  return vec3_make(r.x, r.y, r.z);
+}
+
+#else
+
 /* c = a·b (apply b then a) */
 X_MATH_API Mat4 mat4_mul(Mat4 a, Mat4 b)
 {
@@ -718,6 +986,8 @@ X_MATH_API Vec3 mat4_mul_dir(Mat4 m, Vec3 v)
       m.m[2] * v.x + m.m[6] * v.y + m.m[10] * v.z);
 }
 
+#endif
+
 X_MATH_API Mat4 mat4_from_quat(Quat q)
 {
   q = quat_norm(q);
@@ -982,6 +1252,66 @@ X_MATH_API Mat4 mat4_inverse_affine_uniform_scale(Mat4 m)
   }
 }
 
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+
+/* The scalar version flips the sign of one axis when the basis is
+   mirrored; that cancels out in x / sx / sx, so the vector path skips it. */
+X_MATH_API Mat4 mat4_inverse_affine(Mat4 m)
+{
+  XMathV4 t = s_xm_load(m.m + 12);
+  Mat4 inv;
+#if X_MATH_SIMD_SSE
+  __m128 r0 = s_xm_load(m.m + 0);
+  __m128 r1 = s_xm_load(m.m + 4);
+  __m128 r2 = s_xm_load(m.m + 8);
+  __m128 r3 = t;
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3); /* r0 = X.x Y.x Z.x t.x */
+  __m128 xyz = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+  __m128 w1 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+  r0 = _mm_and_ps(r0, xyz);
+  r1 = _mm_and_ps(r1, xyz);
+  r2 = _mm_and_ps(r2, xyz);
+  /* w lane of 1 keeps the divisions below finite and the w lanes 0 */
+  __m128 len = _mm_sqrt_ps(_mm_or_ps(
+      _mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, r0), _mm_mul_ps(r1, r1)), _mm_mul_ps(r2, r2)), w1));
+  if (_mm_movemask_ps(_mm_cmple_ps(len, _mm_set1_ps(STDXM_EPS))) & 7) {
+    return mat4_identity();
+  }
+#else
+  float32x4x4_t rows = vld4q_f32(m.m); /* rows.val[0] = X.x Y.x Z.x t.x */
+  float32x4_t r0 = vsetq_lane_f32(0.0f, rows.val[0], 3);
+  float32x4_t r1 = vsetq_lane_f32(0.0f, rows.val[1], 3);
+  float32x4_t r2 = vsetq_lane_f32(0.0f, rows.val[2], 3);
+  float32x4_t len = vsqrtq_f32(vsetq_lane_f32(1.0f,
+      vaddq_f32(vaddq_f32(vmulq_f32(r0, r0), vmulq_f32(r1, r1)), vmulq_f32(r2, r2)), 3));
+  uint32x4_t small = vcleq_f32(len, vdupq_n_f32(STDXM_EPS));
+  if (vgetq_lane_u32(small, 0) | vgetq_lane_u32(small, 1) | vgetq_lane_u32(small, 2)) {
+    return mat4_identity();
+  }
+#endif
+
+  XMathV4 i0 = s_xm_div(s_xm_div(r0, len), len);
+  XMathV4 i1 = s_xm_div(s_xm_div(r1, len), len);
+  XMathV4 i2 = s_xm_div(s_xm_div(r2, len), len);
+  XMathV4 tt = s_xm_mul(i0, s_xm_lane(t, 0));
+  tt = s_xm_add(tt, s_xm_mul(i1, s_xm_lane(t, 1)));
+  tt = s_xm_add(tt, s_xm_mul(i2, s_xm_lane(t, 2)));
+#if X_MATH_SIMD_SSE
+  /* The w lane is 0 * t, which is -0 when t is negative: mask it before OR'ing in 1 */
+  tt = _mm_or_ps(_mm_and_ps(_mm_xor_ps(tt, _mm_set1_ps(-0.0f)), xyz), w1);
+#else
+  tt = vsetq_lane_f32(1.0f, vnegq_f32(tt), 3);
+#endif
+
+  s_xm_store(inv.m + 0, i0);
+  s_xm_store(inv.m + 4, i1);
+  s_xm_store(inv.m + 8, i2);
+  s_xm_store(inv.m + 12, tt);
+  return inv;
+}
+
+#else
+
 X_MATH_API Mat4 mat4_inverse_affine(Mat4 m)
 {
   Vec3 X = (Vec3) { m.m[0], m.m[1], m.m[2] };
@@ -1042,6 +1372,8 @@ X_MATH_API Mat4 mat4_inverse_affine(Mat4 m)
   return inv;
 }
 
+#endif
+
 X_MATH_API Quat quat_id(void) { return (Quat) { 0, 0, 0, 1 }; }
 
 X_MATH_API Quat quat_make(float x, float y, float z, float w)
@@ -1051,8 +1383,18 @@ X_MATH_API Quat quat_make(float x, float y, float z, float w)
 
 X_MATH_API Quat quat_norm(Quat a)
 {
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+  XMathV4 v = s_xm_load(&a.x);
+  float L = sqrtf(s_xm_sum_ordered(s_xm_mul(v, v)));
+  if (L <= STDXM_EPS)
+    return quat_id();
+  Quat r;
+  s_xm_store(&r.x, s_xm_div(v, s_xm_set1(L)));
+  return r;
+#else
   float L = sqrtf(a.x * a.x + a.y * a.y + a.z * a.z + a.w * a.w);
   return (L > STDXM_EPS) ? quat_make(a.x / L, a.y / L, a.z / L, a.w / L) : quat_id();
+#endif
 }
 
 X_MATH_API Quat quat_conjugate(Quat q) { return quat_make(-q.x, -q.y, -q.z, q.w); }
@@ -1068,6 +1410,34 @@ X_MATH_API Quat quat_inverse(Quat q)
 
 X_MATH_API Quat quat_unit_inverse(Quat q) { return quat_conjugate(quat_norm(q)); }
 
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+
+/* Lane by lane this is the scalar sum below, term for term and in order */
+X_MATH_API Quat quat_mul(Quat a, Quat b)
+{
+  XMathV4 qa = s_xm_load(&a.x);
+  Quat r;
+#if X_MATH_SIMD_SSE
+  __m128 qb = s_xm_load(&b.x);
+  __m128 v = _mm_mul_ps(s_xm_lane(qa, 3), qb);
+  v = _mm_add_ps(v, _mm_mul_ps(s_xm_lane(qa, 0), s_xm_negate(s_xm_swizzle(qb, 3, 2, 1, 0), 0.0f, -0.0f, 0.0f, -0.0f)));
+  v = _mm_add_ps(v, _mm_mul_ps(s_xm_lane(qa, 1), s_xm_negate(s_xm_swizzle(qb, 2, 3, 0, 1), 0.0f, 0.0f, -0.0f, -0.0f)));
+  v = _mm_add_ps(v, _mm_mul_ps(s_xm_lane(qa, 2), s_xm_negate(s_xm_swizzle(qb, 1, 0, 3, 2), -0.0f, 0.0f, 0.0f, -0.0f)));
+#else
+  Quat b1 = quat_make(b.w, -b.z, b.y, -b.x);
+  Quat b2 = quat_make(b.z, b.w, -b.x, -b.y);
+  Quat b3 = quat_make(-b.y, b.x, b.w, -b.z);
+  float32x4_t v = vmulq_f32(s_xm_lane(qa, 3), s_xm_load(&b.x));
+  v = vaddq_f32(v, vmulq_f32(s_xm_lane(qa, 0), s_xm_load(&b1.x)));
+  v = vaddq_f32(v, vmulq_f32(s_xm_lane(qa, 1), s_xm_load(&b2.x)));
+  v = vaddq_f32(v, vmulq_f32(s_xm_lane(qa, 2), s_xm_load(&b3.x)));
+#endif
+  s_xm_store(&r.x, v);
+  return r;
+}
+
+#else
+
 X_MATH_API Quat quat_mul(Quat a, Quat b)
 {
   return quat_make(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
@@ -1076,6 +1446,8 @@ X_MATH_API Quat quat_mul(Quat a, Quat b)
       a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
 }
 
+#endif
+
 X_MATH_API Vec3 quat_mul_vec3(Quat q, Vec3 v)
 { /* rotate v by q */
   Vec3 u = vec3_make(q.x, q.y, q.z);
@@ -1124,7 +1496,7 @@ X_MATH_API Quat quat_slerp(Quat a, Quat b, float t)
 }
 
 /* column-major Mat3 -> scalar entries (m[col*3 + row]) */
-X_MATH_API static inline Quat quat_from_mat3(Mat3 R)
+X_MATH_API Quat quat_from_mat3(Mat3 R)
 {
   /* correct loads for column-major: */
   float m00 = R.m[0], m01 = R.m[3], m02 = R.m[6];
@@ -1220,7 +1592,13 @@ X_MATH_API Quat quat_neg(Quat q) { return quat_make(-q.x, -q.y, -q.z, -q.w); }
 
 X_MATH_API Quat quat_scale(Quat q, float s)
 {
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+  Quat r;
+  s_xm_store(&r.x, s_xm_mul(s_xm_load(&q.x), s_xm_set1(s)));
+  return r;
+#else
   return quat_make(q.x * s, q.y * s, q.z * s, q.w * s);
+#endif
 }
 
 X_MATH_API Vec3 quat_get_right(Quat q) { return quat_mul_vec3(q, vec3_make(1, 0, 0)); }
@@ -1294,7 +1672,13 @@ X_MATH_API QuatDual quatdual_mul(QuatDual a, QuatDual b)
 
 X_MATH_API Quat quat_add(Quat a, Quat b)
 {
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+  Quat r;
+  s_xm_store(&r.x, s_xm_add(s_xm_load(&a.x), s_xm_load(&b.x)));
+  return r;
+#else
   return quat_make(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w);
+#endif
 }
 
 X_MATH_API QuatDual quatdual_norm(QuatDual qd)
@@ -1373,5 +1757,616 @@ X_MATH_API Mat4 mat4_inverse_full(Mat4 m, bool* ok)
   return r;
 }
 
+#if !X_MATH_SIMD_SSE
+/* Inverse through the 2x2 sub-determinants of the first and last two
+   columns. Reading m as rows instead gives the same result, since
+   inverse(transpose(m)) == transpose(inverse(m)). */
+static Mat4 s_mat4_inverse_scalar(const float* a, bool* ok)
+{
+  float s0 = a[0] * a[5] - a[4] * a[1];
+  float s1 = a[0] * a[6] - a[4] * a[2];
+  float s2 = a[0] * a[7] - a[4] * a[3];
+  float s3 = a[1] * a[6] - a[5] * a[2];
+  float s4 = a[1] * a[7] - a[5] * a[3];
+  float s5 = a[2] * a[7] - a[6] * a[3];
+
+  float c5 = a[10] * a[15] - a[14] * a[11];
+  float c4 = a[9] * a[15] - a[13] * a[11];
+  float c3 = a[9] * a[14] - a[13] * a[10];
+  float c2 = a[8] * a[15] - a[12] * a[11];
+  float c1 = a[8] * a[14] - a[12] * a[10];
+  float c0 = a[8] * a[13] - a[12] * a[9];
+
+  float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+
+  if (ok) {
+    *ok = fabsf(det) > STDXM_EPS;
+  }
+
+  if (fabsf(det) <= STDXM_EPS) {
+    return mat4_identity();
+  }
+
+  float d = 1.0f / det;
+  Mat4 r;
+  r.m[0] = (a[5] * c5 - a[6] * c4 + a[7] * c3) * d;
+  r.m[1] = (-a[1] * c5 + a[2] * c4 - a[3] * c3) * d;
+  r.m[2] = (a[13] * s5 - a[14] * s4 + a[15] * s3) * d;
+  r.m[3] = (-a[9] * s5 + a[10] * s4 - a[11] * s3) * d;
+
+  r.m[4] = (-a[4] * c5 + a[6] * c2 - a[7] * c1) * d;
+  r.m[5] = (a[0] * c5 - a[2] * c2 + a[3] * c1) * d;
+  r.m[6] = (-a[12] * s5 + a[14] * s2 - a[15] * s1) * d;
+  r.m[7] = (a[8] * s5 - a[10] * s2 + a[11] * s1) * d;
+
+  r.m[8] = (a[4] * c4 - a[5] * c2 + a[7] * c0) * d;
+  r.m[9] = (-a[0] * c4 + a[1] * c2 - a[3] * c0) * d;
+  r.m[10] = (a[12] * s4 - a[13] * s2 + a[15] * s0) * d;
+  r.m[11] = (-a[8] * s4 + a[9] * s2 - a[11] * s0) * d;
+
+  r.m[12] = (-a[4] * c3 + a[5] * c1 - a[6] * c0) * d;
+  r.m[13] = (a[0] * c3 - a[1] * c1 + a[2] * c0) * d;
+  r.m[14] = (-a[12] * s3 + a[13] * s1 - a[14] * s0) * d;
+  r.m[15] = (a[8] * s3 - a[9] * s1 + a[10] * s0) * d;
+  return r;
+}
+#endif
+
+#if X_MATH_SIMD_SSE
+/* 2x2 matrices packed as (m00, m01, m10, m11): a * b, adj(a) * b, a * adj(b) */
+static inline __m128 s_xm_mat2_mul(__m128 a, __m128 b)
+{
+  return _mm_add_ps(_mm_mul_ps(a, s_xm_swizzle(b, 0, 3, 0, 3)),
+      _mm_mul_ps(s_xm_swizzle(a, 1, 0, 3, 2), s_xm_swizzle(b, 2, 1, 2, 1)));
+}
+
+static inline __m128 s_xm_mat2_adj_mul(__m128 a, __m128 b)
+{
+  return _mm_sub_ps(_mm_mul_ps(s_xm_swizzle(a, 3, 3, 0, 0), b),
+      _mm_mul_ps(s_xm_swizzle(a, 1, 1, 2, 2), s_xm_swizzle(b, 2, 3, 0, 1)));
+}
+
+static inline __m128 s_xm_mat2_mul_adj(__m128 a, __m128 b)
+{
+  return _mm_sub_ps(_mm_mul_ps(a, s_xm_swizzle(b, 3, 0, 3, 0)),
+      _mm_mul_ps(s_xm_swizzle(a, 1, 0, 3, 2), s_xm_swizzle(b, 2, 1, 2, 1)));
+}
+#endif
+
+X_MATH_API Mat4 mat4_inverse(Mat4 m, bool* ok)
+{
+#if X_MATH_SIMD_SSE
+  /* Blockwise inverse of [A B; C D] with 2x2 blocks. Columns are read as
+     rows, which inverts the transpose, and stored back the same way. */
+  __m128 r0 = s_xm_load(m.m + 0);
+  __m128 r1 = s_xm_load(m.m + 4);
+  __m128 r2 = s_xm_load(m.m + 8);
+  __m128 r3 = s_xm_load(m.m + 12);
+
+  __m128 A = _mm_movelh_ps(r0, r1);
+  __m128 B = _mm_movehl_ps(r1, r0);
+  __m128 C = _mm_movelh_ps(r2, r3);
+  __m128 D = _mm_movehl_ps(r3, r2);
+
+  /* |A| |B| |C| |D| */
+  __m128 det_sub = _mm_sub_ps(
+      _mm_mul_ps(s_xm_shuffle(r0, r2, 0, 2, 0, 2), s_xm_shuffle(r1, r3, 1, 3, 1, 3)),
+      _mm_mul_ps(s_xm_shuffle(r0, r2, 1, 3, 1, 3), s_xm_shuffle(r1, r3, 0, 2, 0, 2)));
+  __m128 det_a = s_xm_lane(det_sub, 0);
+  __m128 det_b = s_xm_lane(det_sub, 1);
+  __m128 det_c = s_xm_lane(det_sub, 2);
+  __m128 det_d = s_xm_lane(det_sub, 3);
+
+  __m128 d_c = s_xm_mat2_adj_mul(D, C);
+  __m128 a_b = s_xm_mat2_adj_mul(A, B);
+  __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, A), s_xm_mat2_mul(B, d_c));
+  __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, D), s_xm_mat2_mul(C, a_b));
+  __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, C), s_xm_mat2_mul_adj(D, a_b));
+  __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, B), s_xm_mat2_mul_adj(A, d_c));
+
+  /* |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C) */
+  __m128 det_m = _mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c));
+  __m128 tr = _mm_mul_ps(a_b, s_xm_swizzle(d_c, 0, 2, 1, 3));
+  tr = _mm_add_ps(tr, s_xm_swizzle(tr, 2, 3, 0, 1));
+  tr = _mm_add_ps(tr, s_xm_swizzle(tr, 1, 0, 3, 2));
+  det_m = _mm_sub_ps(det_m, tr);
+
+  float det = _mm_cvtss_f32(det_m);
+  if (ok) {
+    *ok = fabsf(det) > STDXM_EPS;
+  }
+
+  if (fabsf(det) <= STDXM_EPS) {
+    return mat4_identity();
+  }
+
+  __m128 rdet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det_m);
+  x = _mm_mul_ps(x, rdet);
+  y = _mm_mul_ps(y, rdet);
+  z = _mm_mul_ps(z, rdet);
+  w = _mm_mul_ps(w, rdet);
+
+  Mat4 r;
+  s_xm_store(r.m + 0, s_xm_shuffle(x, y, 3, 1, 3, 1));
+  s_xm_store(r.m + 4, s_xm_shuffle(x, y, 2, 0, 2, 0));
+  s_xm_store(r.m + 8, s_xm_shuffle(z, w, 3, 1, 3, 1));
+  s_xm_store(r.m + 12, s_xm_shuffle(z, w, 2, 0, 2, 0));
+  return r;
+#else
+  return s_mat4_inverse_scalar(m.m, ok);
+#endif
+}
+
+/* Batch kernels */
+
+#if X_MATH_SIMD_SSE
+#define s_xm_loadu(p) _mm_loadu_ps(p)
+#define s_xm_storeu(p, v) _mm_storeu_ps((p), (v))
+#elif X_MATH_SIMD_NEON
+#define s_xm_loadu(p) vld1q_f32(p)
+#define s_xm_storeu(p, v) vst1q_f32((p), (v))
+#endif
+
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+/* Divisor for the perspective divide: w, or 1 where float_is_zero(w) */
+static inline XMathV4 s_xm_safe_w(XMathV4 w)
+{
+#if X_MATH_SIMD_SSE
+  __m128 small = _mm_cmple_ps(s_xm_abs(w), _mm_set1_ps(STDXM_EPS));
+  return _mm_or_ps(_mm_and_ps(small, _mm_set1_ps(1.0f)), _mm_andnot_ps(small, w));
+#else
+  return vbslq_f32(vcleq_f32(vabsq_f32(w), vdupq_n_f32(STDXM_EPS)), vdupq_n_f32(1.0f), w);
+#endif
+}
+
+/* One bit per lane where a >= b */
+static inline uint32_t s_xm_ge_mask(XMathV4 a, XMathV4 b)
+{
+#if X_MATH_SIMD_SSE
+  return (uint32_t)_mm_movemask_ps(_mm_cmpge_ps(a, b));
+#else
+  static const uint32_t bits[4] = { 1, 2, 4, 8 };
+  return vaddvq_u32(vandq_u32(vcgeq_f32(a, b), vld1q_u32(bits)));
+#endif
+}
+#endif
+
+X_MATH_API Frustum frustum_from_mat4(Mat4 m, bool zero_to_one)
+{
+  /* Gribb/Hartmann: planes are sums and differences of the matrix rows */
+  Vec4 r0 = vec4_make(m.m[0], m.m[4], m.m[8], m.m[12]);
+  Vec4 r1 = vec4_make(m.m[1], m.m[5], m.m[9], m.m[13]);
+  Vec4 r2 = vec4_make(m.m[2], m.m[6], m.m[10], m.m[14]);
+  Vec4 r3 = vec4_make(m.m[3], m.m[7], m.m[11], m.m[15]);
+  Frustum f;
+  f.planes[0] = vec4_add(r3, r0);
+  f.planes[1] = vec4_sub(r3, r0);
+  f.planes[2] = vec4_add(r3, r1);
+  f.planes[3] = vec4_sub(r3, r1);
+  f.planes[4] = zero_to_one ? r2 : vec4_add(r3, r2);
+  f.planes[5] = vec4_sub(r3, r2);
+  for (int i = 0; i < 6; i++) {
+    Vec4 p = f.planes[i];
+    float len = sqrtf(p.x * p.x + p.y * p.y + p.z * p.z);
+    if (len > STDXM_EPS) {
+      f.planes[i] = vec4_div(p, len);
+    }
+  }
+  return f;
+}
+
+#if X_MATH_SIMD_SSE
+/* AVX2 and AVX-512F versions of the batch loops, picked at runtime through
+   stdx_cpuid. They run whole 8 or 16 lane blocks with the same operations
+   as the 4 lane loop and return how many elements they did; the 4 lane and
+   scalar loops finish the rest. None of them is compiled with FMA, so the
+   results stay equal to the per-element functions. */
+
+/* GCC enables FMA with avx512f and fuses intrinsic mul/add pairs into it */
+#if defined(__GNUC__) && !defined(__clang__)
+#define X_MATH_NO_CONTRACT __attribute__((optimize("fp-contract=off")))
+#else
+#define X_MATH_NO_CONTRACT
+#endif
+
+typedef size_t (*XMathTransformFn)(const Mat4* m, bool affine, const float* xs, const float* ys,
+    const float* zs, float* out_x, float* out_y, float* out_z, size_t n);
+typedef size_t (*XMathCullFn)(const Frustum* f, const float* xs, const float* ys, const float* zs,
+    const float* radii, const float* ex, const float* ey, const float* ez, size_t n, uint32_t* out_mask);
+
+static size_t s_xm_transform_none(const Mat4* m, bool affine, const float* xs, const float* ys,
+    const float* zs, float* out_x, float* out_y, float* out_z, size_t n)
+{
+  (void)m; (void)affine; (void)xs; (void)ys; (void)zs; (void)out_x; (void)out_y; (void)out_z; (void)n;
+  return 0;
+}
+
+static size_t s_xm_cull_none(const Frustum* f, const float* xs, const float* ys, const float* zs,
+    const float* radii, const float* ex, const float* ey, const float* ez, size_t n, uint32_t* out_mask)
+{
+  (void)f; (void)xs; (void)ys; (void)zs; (void)radii; (void)ex; (void)ey; (void)ez; (void)n; (void)out_mask;
+  return 0;
+}
+
+X_CPU_TARGET("avx2") X_MATH_NO_CONTRACT static size_t s_xm_transform_points_avx2(const Mat4* m, bool affine,
+    const float* xs, const float* ys, const float* zs, float* out_x, float* out_y, float* out_z, size_t n)
+{
+  __m256 c[16];
+  for (int k = 0; k < 16; k++) {
+    c[k] = _mm256_set1_ps(m->m[k]);
+  }
+  __m256 eps = _mm256_set1_ps(STDXM_EPS), one = _mm256_set1_ps(1.0f), sign = _mm256_set1_ps(-0.0f);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 x = _mm256_loadu_ps(xs + i), y = _mm256_loadu_ps(ys + i), z = _mm256_loadu_ps(zs + i);
+    __m256 rx = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[0], x), _mm256_mul_ps(c[4], y)), _mm256_mul_ps(c[8], z)), c[12]);
+    __m256 ry = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[1], x), _mm256_mul_ps(c[5], y)), _mm256_mul_ps(c[9], z)), c[13]);
+    __m256 rz = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[2], x), _mm256_mul_ps(c[6], y)), _mm256_mul_ps(c[10], z)), c[14]);
+    if (!affine) {
+      __m256 w = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c[3], x), _mm256_mul_ps(c[7], y)), _mm256_mul_ps(c[11], z)), c[15]);
+      w = _mm256_blendv_ps(w, one, _mm256_cmp_ps(_mm256_andnot_ps(sign, w), eps, _CMP_LE_OQ));
+      rx = _mm256_div_ps(rx, w);
+      ry = _mm256_div_ps(ry, w);
+      rz = _mm256_div_ps(rz, w);
+    }
+    _mm256_storeu_ps(out_x + i, rx);
+    _mm256_storeu_ps(out_y + i, ry);
+    _mm256_storeu_ps(out_z + i, rz);
+  }
+  return i;
+}
+
+X_CPU_TARGET("avx512f") X_MATH_NO_CONTRACT static size_t s_xm_transform_points_avx512(const Mat4* m, bool affine,
+    const float* xs, const float* ys, const float* zs, float* out_x, float* out_y, float* out_z, size_t n)
+{
+  __m512 c[16];
+  for (int k = 0; k < 16; k++) {
+    c[k] = _mm512_set1_ps(m->m[k]);
+  }
+  __m512 eps = _mm512_set1_ps(STDXM_EPS), one = _mm512_set1_ps(1.0f);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 x = _mm512_loadu_ps(xs + i), y = _mm512_loadu_ps(ys + i), z = _mm512_loadu_ps(zs + i);
+    __m512 rx = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(c[0], x), _mm512_mul_ps(c[4], y)), _mm512_mul_ps(c[8], z)), c[12]);
+    __m512 ry = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(c[1], x), _mm512_mul_ps(c[5], y)), _mm512_mul_ps(c[9], z)), c[13]);
+    __m512 rz = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(c[2], x), _mm512_mul_ps(c[6], y)), _mm512_mul_ps(c[10], z)), c[14]);
+    if (!affine) {
+      __m512 w = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(c[3], x), _mm512_mul_ps(c[7], y)), _mm512_mul_ps(c[11], z)), c[15]);
+      w = _mm512_mask_blend_ps(_mm512_cmp_ps_mask(_mm512_abs_ps(w), eps, _CMP_LE_OQ), w, one);
+      rx = _mm512_div_ps(rx, w);
+      ry = _mm512_div_ps(ry, w);
+      rz = _mm512_div_ps(rz, w);
+    }
+    _mm512_storeu_ps(out_x + i, rx);
+    _mm512_storeu_ps(out_y + i, ry);
+    _mm512_storeu_ps(out_z + i, rz);
+  }
+  return i;
+}
+
+X_CPU_TARGET("avx2") X_MATH_NO_CONTRACT static size_t s_xm_transform_dirs_avx2(const Mat4* m, bool affine,
+    const float* xs, const float* ys, const float* zs, float* out_x, float* out_y, float* out_z, size_t n)
+{
+  (void)affine;
+  __m256 c0 = _mm256_set1_ps(m->m[0]), c1 = _mm256_set1_ps(m->m[1]), c2 = _mm256_set1_ps(m->m[2]);
+  __m256 c4 = _mm256_set1_ps(m->m[4]), c5 = _mm256_set1_ps(m->m[5]), c6 = _mm256_set1_ps(m->m[6]);
+  __m256 c8 = _mm256_set1_ps(m->m[8]), c9 = _mm256_set1_ps(m->m[9]), c10 = _mm256_set1_ps(m->m[10]);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 x = _mm256_loadu_ps(xs + i), y = _mm256_loadu_ps(ys + i), z = _mm256_loadu_ps(zs + i);
+    _mm256_storeu_ps(out_x + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c0, x), _mm256_mul_ps(c4, y)), _mm256_mul_ps(c8, z)));
+    _mm256_storeu_ps(out_y + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c1, x), _mm256_mul_ps(c5, y)), _mm256_mul_ps(c9, z)));
+    _mm256_storeu_ps(out_z + i, _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(c2, x), _mm256_mul_ps(c6, y)), _mm256_mul_ps(c10, z)));
+  }
+  return i;
+}
+
+X_CPU_TARGET("avx512f") X_MATH_NO_CONTRACT static size_t s_xm_transform_dirs_avx512(const Mat4* m, bool affine,
+    const float* xs, const float* ys, const float* zs, float* out_x, float* out_y, float* out_z, size_t n)
+{
+  (void)affine;
+  __m512 c0 = _mm512_set1_ps(m->m[0]), c1 = _mm512_set1_ps(m->m[1]), c2 = _mm512_set1_ps(m->m[2]);
+  __m512 c4 = _mm512_set1_ps(m->m[4]), c5 = _mm512_set1_ps(m->m[5]), c6 = _mm512_set1_ps(m->m[6]);
+  __m512 c8 = _mm512_set1_ps(m->m[8]), c9 = _mm512_set1_ps(m->m[9]), c10 = _mm512_set1_ps(m->m[10]);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 x = _mm512_loadu_ps(xs + i), y = _mm512_loadu_ps(ys + i), z = _mm512_loadu_ps(zs + i);
+    _mm512_storeu_ps(out_x + i, _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(c0, x), _mm512_mul_ps(c4, y)), _mm512_mul_ps(c8, z)));
+    _mm512_storeu_ps(out_y + i, _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(c1, x), _mm512_mul_ps(c5, y)), _mm512_mul_ps(c9, z)));
+    _mm512_storeu_ps(out_z + i, _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(c2, x), _mm512_mul_ps(c6, y)), _mm512_mul_ps(c10, z)));
+  }
+  return i;
+}
+
+/* out_mask is already cleared; blocks start on multiples of 8 or 16, so a
+   block never straddles two mask words */
+X_CPU_TARGET("avx2") X_MATH_NO_CONTRACT static size_t s_xm_cull_avx2(const Frustum* f, const float* xs, const float* ys,
+    const float* zs, const float* radii, const float* ex, const float* ey, const float* ez, size_t n,
+    uint32_t* out_mask)
+{
+  __m256 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+  for (int p = 0; p < 6; p++) {
+    px[p] = _mm256_set1_ps(f->planes[p].x);
+    py[p] = _mm256_set1_ps(f->planes[p].y);
+    pz[p] = _mm256_set1_ps(f->planes[p].z);
+    pw[p] = _mm256_set1_ps(f->planes[p].w);
+    ax[p] = _mm256_set1_ps(fabsf(f->planes[p].x));
+    ay[p] = _mm256_set1_ps(fabsf(f->planes[p].y));
+    az[p] = _mm256_set1_ps(fabsf(f->planes[p].z));
+  }
+  __m256 zero = _mm256_setzero_ps();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 x = _mm256_loadu_ps(xs + i), y = _mm256_loadu_ps(ys + i), z = _mm256_loadu_ps(zs + i);
+    __m256 ex8 = zero, ey8 = zero, ez8 = zero, r8 = zero;
+    if (radii) {
+      r8 = _mm256_loadu_ps(radii + i);
+    } else {
+      ex8 = _mm256_loadu_ps(ex + i);
+      ey8 = _mm256_loadu_ps(ey + i);
+      ez8 = _mm256_loadu_ps(ez + i);
+    }
+    uint32_t visible = 0xFF;
+    for (int p = 0; p < 6 && visible; p++) {
+      __m256 d = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], x), _mm256_mul_ps(py[p], y)), _mm256_mul_ps(pz[p], z)), pw[p]);
+      __m256 r = radii ? r8
+                       : _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ax[p], ex8), _mm256_mul_ps(ay[p], ey8)), _mm256_mul_ps(az[p], ez8));
+      visible &= (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(d, r), zero, _CMP_GE_OQ));
+    }
+    out_mask[i / 32] |= visible << (i % 32);
+  }
+  return i;
+}
+
+X_CPU_TARGET("avx512f") X_MATH_NO_CONTRACT static size_t s_xm_cull_avx512(const Frustum* f, const float* xs, const float* ys,
+    const float* zs, const float* radii, const float* ex, const float* ey, const float* ez, size_t n,
+    uint32_t* out_mask)
+{
+  __m512 px[6], py[6], pz[6], pw[6], ax[6], ay[6], az[6];
+  for (int p = 0; p < 6; p++) {
+    px[p] = _mm512_set1_ps(f->planes[p].x);
+    py[p] = _mm512_set1_ps(f->planes[p].y);
+    pz[p] = _mm512_set1_ps(f->planes[p].z);
+    pw[p] = _mm512_set1_ps(f->planes[p].w);
+    ax[p] = _mm512_set1_ps(fabsf(f->planes[p].x));
+    ay[p] = _mm512_set1_ps(fabsf(f->planes[p].y));
+    az[p] = _mm512_set1_ps(fabsf(f->planes[p].z));
+  }
+  __m512 zero = _mm512_setzero_ps();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m512 x = _mm512_loadu_ps(xs + i), y = _mm512_loadu_ps(ys + i), z = _mm512_loadu_ps(zs + i);
+    __m512 ex16 = zero, ey16 = zero, ez16 = zero, r16 = zero;
+    if (radii) {
+      r16 = _mm512_loadu_ps(radii + i);
+    } else {
+      ex16 = _mm512_loadu_ps(ex + i);
+      ey16 = _mm512_loadu_ps(ey + i);
+      ez16 = _mm512_loadu_ps(ez + i);
+    }
+    uint32_t visible = 0xFFFF;
+    for (int p = 0; p < 6 && visible; p++) {
+      __m512 d = _mm512_add_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(px[p], x), _mm512_mul_ps(py[p], y)), _mm512_mul_ps(pz[p], z)), pw[p]);
+      __m512 r = radii ? r16
+                       : _mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(ax[p], ex16), _mm512_mul_ps(ay[p], ey16)), _mm512_mul_ps(az[p], ez16));
+      visible &= (uint32_t)_mm512_cmp_ps_mask(_mm512_add_ps(d, r), zero, _CMP_GE_OQ);
+    }
+    out_mask[i / 32] |= visible << (i % 32);
+  }
+  return i;
+}
+
+X_CPU_DISPATCH(s_xm_transform_points_wide, XMathTransformFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX512F, s_xm_transform_points_avx512),
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_xm_transform_points_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_xm_transform_none))
+X_CPU_DISPATCH(s_xm_transform_dirs_wide, XMathTransformFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX512F, s_xm_transform_dirs_avx512),
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_xm_transform_dirs_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_xm_transform_none))
+X_CPU_DISPATCH(s_xm_cull_wide, XMathCullFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX512F, s_xm_cull_avx512),
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_xm_cull_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_xm_cull_none))
+
+/* Below this the 4 lane loop is as fast as a dispatched call */
+#define X_MATH_WIDE_MIN 8
+#endif
+
+X_MATH_API void mat4_transform_points(Mat4 m, const float* xs, const float* ys,
+    const float* zs, float* out_x, float* out_y, float* out_z, size_t n)
+{
+  /* w stays exactly 1 for affine matrices, so the divide can be skipped */
+  bool affine = m.m[3] == 0.0f && m.m[7] == 0.0f && m.m[11] == 0.0f && m.m[15] == 1.0f;
+  size_t i = 0;
+#if X_MATH_SIMD_SSE
+  if (n >= X_MATH_WIDE_MIN) {
+    i = X_CPU_CALL(s_xm_transform_points_wide)(&m, affine, xs, ys, zs, out_x, out_y, out_z, n);
+  }
+#endif
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+  XMathV4 m0 = s_xm_set1(m.m[0]), m1 = s_xm_set1(m.m[1]), m2 = s_xm_set1(m.m[2]);
+  XMathV4 m4 = s_xm_set1(m.m[4]), m5 = s_xm_set1(m.m[5]), m6 = s_xm_set1(m.m[6]);
+  XMathV4 m8 = s_xm_set1(m.m[8]), m9 = s_xm_set1(m.m[9]), m10 = s_xm_set1(m.m[10]);
+  XMathV4 m12 = s_xm_set1(m.m[12]), m13 = s_xm_set1(m.m[13]), m14 = s_xm_set1(m.m[14]);
+  XMathV4 m3 = s_xm_set1(m.m[3]), m7 = s_xm_set1(m.m[7]), m11 = s_xm_set1(m.m[11]);
+  XMathV4 m15 = s_xm_set1(m.m[15]);
+  for (; i + 4 <= n; i += 4) {
+    XMathV4 x = s_xm_loadu(xs + i), y = s_xm_loadu(ys + i), z = s_xm_loadu(zs + i);
+    XMathV4 rx = s_xm_add(s_xm_add(s_xm_add(s_xm_mul(m0, x), s_xm_mul(m4, y)), s_xm_mul(m8, z)), m12);
+    XMathV4 ry = s_xm_add(s_xm_add(s_xm_add(s_xm_mul(m1, x), s_xm_mul(m5, y)), s_xm_mul(m9, z)), m13);
+    XMathV4 rz = s_xm_add(s_xm_add(s_xm_add(s_xm_mul(m2, x), s_xm_mul(m6, y)), s_xm_mul(m10, z)), m14);
+    if (!affine) {
+      XMathV4 w = s_xm_safe_w(s_xm_add(
+          s_xm_add(s_xm_add(s_xm_mul(m3, x), s_xm_mul(m7, y)), s_xm_mul(m11, z)), m15));
+      rx = s_xm_div(rx, w);
+      ry = s_xm_div(ry, w);
+      rz = s_xm_div(rz, w);
+    }
+    s_xm_storeu(out_x + i, rx);
+    s_xm_storeu(out_y + i, ry);
+    s_xm_storeu(out_z + i, rz);
+  }
+#endif
+  for (; i < n; i++) {
+    float x = xs[i], y = ys[i], z = zs[i];
+    float rx = m.m[0] * x + m.m[4] * y + m.m[8] * z + m.m[12];
+    float ry = m.m[1] * x + m.m[5] * y + m.m[9] * z + m.m[13];
+    float rz = m.m[2] * x + m.m[6] * y + m.m[10] * z + m.m[14];
+    if (!affine) {
+      float w = m.m[3] * x + m.m[7] * y + m.m[11] * z + m.m[15];
+      if (!float_is_zero(w)) {
+        rx /= w;
+        ry /= w;
+        rz /= w;
+      }
+    }
+    out_x[i] = rx;
+    out_y[i] = ry;
+    out_z[i] = rz;
+  }
+}
+
+X_MATH_API void mat4_transform_dirs(Mat4 m, const float* xs, const float* ys,
+    const float* zs, float* out_x, float* out_y, float* out_z, size_t n)
+{
+  size_t i = 0;
+#if X_MATH_SIMD_SSE
+  if (n >= X_MATH_WIDE_MIN) {
+    i = X_CPU_CALL(s_xm_transform_dirs_wide)(&m, false, xs, ys, zs, out_x, out_y, out_z, n);
+  }
+#endif
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+  XMathV4 m0 = s_xm_set1(m.m[0]), m1 = s_xm_set1(m.m[1]), m2 = s_xm_set1(m.m[2]);
+  XMathV4 m4 = s_xm_set1(m.m[4]), m5 = s_xm_set1(m.m[5]), m6 = s_xm_set1(m.m[6]);
+  XMathV4 m8 = s_xm_set1(m.m[8]), m9 = s_xm_set1(m.m[9]), m10 = s_xm_set1(m.m[10]);
+  for (; i + 4 <= n; i += 4) {
+    XMathV4 x = s_xm_loadu(xs + i), y = s_xm_loadu(ys + i), z = s_xm_loadu(zs + i);
+    s_xm_storeu(out_x + i, s_xm_add(s_xm_add(s_xm_mul(m0, x), s_xm_mul(m4, y)), s_xm_mul(m8, z)));
+    s_xm_storeu(out_y + i, s_xm_add(s_xm_add(s_xm_mul(m1, x), s_xm_mul(m5, y)), s_xm_mul(m9, z)));
+    s_xm_storeu(out_z + i, s_xm_add(s_xm_add(s_xm_mul(m2, x), s_xm_mul(m6, y)), s_xm_mul(m10, z)));
+  }
+#endif
+  for (; i < n; i++) {
+    float x = xs[i], y = ys[i], z = zs[i];
+    out_x[i] = m.m[0] * x + m.m[4] * y + m.m[8] * z;
+    out_y[i] = m.m[1] * x + m.m[5] * y + m.m[9] * z;
+    out_z[i] = m.m[2] * x + m.m[6] * y + m.m[10] * z;
+  }
+}
+
+/* Shared by the sphere and box tests: an element is visible when, for every
+   plane, dot(n, c) + w >= -r. For spheres r is the radius, for boxes the
+   extents projected on the normal. */
+static void s_frustum_cull(const Frustum* f, const float* xs, const float* ys,
+    const float* zs, const float* radii, const float* ex, const float* ey,
+    const float* ez, size_t n, uint32_t* out_mask)
+{
+  size_t words = (n + 31) / 32;
+  for (size_t w = 0; w < words; w++) {
+    out_mask[w] = 0;
+  }
+
+  size_t i = 0;
+#if X_MATH_SIMD_SSE
+  if (n >= X_MATH_WIDE_MIN) {
+    i = X_CPU_CALL(s_xm_cull_wide)(f, xs, ys, zs, radii, ex, ey, ez, n, out_mask);
+  }
+#endif
+#if X_MATH_SIMD_SSE || X_MATH_SIMD_NEON
+  XMathV4 px[6], py[6], pz[6], pw[6];
+  XMathV4 ax[6], ay[6], az[6];
+  for (int p = 0; p < 6; p++) {
+    px[p] = s_xm_set1(f->planes[p].x);
+    py[p] = s_xm_set1(f->planes[p].y);
+    pz[p] = s_xm_set1(f->planes[p].z);
+    pw[p] = s_xm_set1(f->planes[p].w);
+    ax[p] = s_xm_set1(fabsf(f->planes[p].x));
+    ay[p] = s_xm_set1(fabsf(f->planes[p].y));
+    az[p] = s_xm_set1(fabsf(f->planes[p].z));
+  }
+  XMathV4 zero = s_xm_set1(0.0f);
+  for (; i + 4 <= n; i += 4) {
+    XMathV4 x = s_xm_loadu(xs + i), y = s_xm_loadu(ys + i), z = s_xm_loadu(zs + i);
+    XMathV4 ex4 = zero, ey4 = zero, ez4 = zero, r4 = zero;
+    if (radii) {
+      r4 = s_xm_loadu(radii + i);
+    } else {
+      ex4 = s_xm_loadu(ex + i);
+      ey4 = s_xm_loadu(ey + i);
+      ez4 = s_xm_loadu(ez + i);
+    }
+    uint32_t visible = 0xF;
+    for (int p = 0; p < 6 && visible; p++) {
+      XMathV4 d = s_xm_add(s_xm_add(s_xm_add(s_xm_mul(px[p], x), s_xm_mul(py[p], y)), s_xm_mul(pz[p], z)), pw[p]);
+      XMathV4 r = radii ? r4
+                        : s_xm_add(s_xm_add(s_xm_mul(ax[p], ex4), s_xm_mul(ay[p], ey4)), s_xm_mul(az[p], ez4));
+      visible &= s_xm_ge_mask(s_xm_add(d, r), zero);
+    }
+    out_mask[i / 32] |= visible << (i % 32);
+  }
+#endif
+  for (; i < n; i++) {
+    bool visible = true;
+    for (int p = 0; p < 6 && visible; p++) {
+      Vec4 pl = f->planes[p];
+      float d = pl.x * xs[i] + pl.y * ys[i] + pl.z * zs[i] + pl.w;
+      float r = radii ? radii[i]
+                      : fabsf(pl.x) * ex[i] + fabsf(pl.y) * ey[i] + fabsf(pl.z) * ez[i];
+      visible = d + r >= 0.0f;
+    }
+    if (visible) {
+      out_mask[i / 32] |= 1u << (i % 32);
+    }
+  }
+}
+
+X_MATH_API void frustum_cull_spheres(const Frustum* f, const float* xs, const float* ys,
+    const float* zs, const float* radii, size_t n, uint32_t* out_mask)
+{
+  s_frustum_cull(f, xs, ys, zs, radii, NULL, NULL, NULL, n, out_mask);
+}
+
+X_MATH_API void frustum_cull_aabbs(const Frustum* f, const float* cx, const float* cy,
+    const float* cz, const float* ex, const float* ey, const float* ez, size_t n,
+    uint32_t* out_mask)
+{
+  s_frustum_cull(f, cx, cy, cz, NULL, ex, ey, ez, n, out_mask);
+}
+
+X_MATH_API void quat_slerp_array(const Quat* a, const Quat* b, float t, size_t n, Quat* out)
+{
+  for (size_t i = 0; i < n; i++) {
+    out[i] = quat_slerp(a[i], b[i], t);
+  }
+}
+
+X_MATH_API void mat4_compose_array(const Vec3* t, const Quat* r, const Vec3* s, size_t n,
+    Mat4* out)
+{
+  /* T * R * S only scales the rotation columns and sets the translation;
+     the products with 0 and 1 that mat4_compose performs are exact. */
+  for (size_t i = 0; i < n; i++) {
+    Mat4 rot = mat4_from_quat(r[i]);
+    Mat4* m = &out[i];
+    for (int c = 0; c < 3; c++) {
+      float sc = c == 0 ? s[i].x : c == 1 ? s[i].y : s[i].z;
+      m->m[c * 4 + 0] = rot.m[c * 4 + 0] * sc;
+      m->m[c * 4 + 1] = rot.m[c * 4 + 1] * sc;
+      m->m[c * 4 + 2] = rot.m[c * 4 + 2] * sc;
+      m->m[c * 4 + 3] = 0.0f;
+    }
+    m->m[12] = t[i].x;
+    m->m[13] = t[i].y;
+    m->m[14] = t[i].z;
+    m->m[15] = 1.0f;
+  }
+}
+
+#ifdef X_INTERNAL_CPUID_IMPL
+#undef X_IMPL_CPUID
+#undef X_INTERNAL_CPUID_IMPL
+#endif
+
 #endif // X_IMPL_MATH
 #endif // X_MATH_H
@@ -15,6 +15,78 @@
  *
  * To customize how this module allocates memory, define
  * `X_NET_ALLOC` / `X_NET_FREE` before including.
+ *
+ * ## Gather sends
+ *
+ * `x_net_sendv()` sends a list of `XSlice`s in order through sendmsg
+ * (WSASend on Windows), so a response header and body, or the segments of
+ * an XStrBuilder, go out without being concatenated first.
+ * `x_net_recvv()` is its counterpart and scatters one receive across
+ * several buffers.
+ *
+ * ## Datagram batches
+ *
+ * `x_net_sendmmsg()` and `x_net_recvmmsg()` move an array of `XNetDatagram`s
+ * per call: sendmmsg/recvmmsg on Linux, one sendmsg/recvmsg per datagram
+ * elsewhere. Receiving waits for the first datagram only and then takes
+ * whatever else is already queued.
+ *
+ * Segmentation offload goes further where the kernel has it.
+ * - After `x_net_set_udp_segment()`, one large send leaves as many
+ *   datagrams of the given size. This is UDP_SEGMENT on Linux and
+ *   UDP_SEND_MSG_SIZE on Windows.
+ * - After `x_net_set_udp_gro()` (Linux), the kernel may deliver several
+ *   datagrams from the same sender back to back in one receive buffer.
+ *   The datagram then reports their size in `segment_size`.
+ *
+ * ## File sends
+ *
+ * `x_net_send_file()` sends a byte range of an open `XFile` straight from
+ * the page cache: sendfile on Linux, macOS and FreeBSD, TransmitFile on
+ * Windows (which also links *mswsock.lib*), and a mapped view plus send
+ * elsewhere. File data never passes through a user buffer. On non-blocking
+ * sockets it returns early when the socket would block, so callers advance
+ * their offset by the returned count and try again on the next write event.
+ * sendfile can raise SIGPIPE on a closed peer; servers should ignore it.
+ *
+ * ## Event loops
+ *
+ * An `XNetLoop` waits on any number of sockets at once: epoll on Linux,
+ * kqueue on macOS/BSD and an I/O completion port on Windows. Sockets are
+ * registered once with their read/write interest and a user pointer, and
+ * `x_net_loop_wait()` returns a batch of ready events, so the cost of a wait
+ * depends on how many sockets are ready rather than how many are watched.
+ *
+ * Notifications are edge-triggered: a socket is reported when it becomes
+ * readable or writable, and not again until new data or buffer space
+ * arrives. Put registered sockets in non-blocking mode and read or write
+ * until `x_net_would_block()` before waiting again. On Windows write
+ * readiness is reported once per arm, so portable code calls
+ * `x_net_loop_modify()` again after a send would block.
+ *
+ * A loop belongs to the thread that waits on it; `x_net_loop_wake()` is the
+ * only call that may come from other threads. Remove a socket from its loop
+ * before closing it.
+ *
+ * ## Buffer pools
+ *
+ * An `XNetBufferPool` hands out fixed-size, reference-counted `XNetBuffer`s
+ * carved from cache-aligned slabs, and takes them back for reuse. An
+ * `XNetChain` strings buffers together so a message of any size can arrive
+ * in pieces: `x_net_recv_chain()` fills the chain's last buffer and appends
+ * fresh ones only as data arrives, `x_net_chain_consume()` returns buffers
+ * to the pool as soon as they have been read, and `x_net_send_chain()` sends
+ * a chain with one gather write. A connection with nothing in flight holds
+ * no buffers at all.
+ *
+ * A buffer sits in at most one chain at a time (`x_net_chain_move()` hands
+ * a whole chain over without copying). Additional references only keep its
+ * memory alive, e.g. while slices point into it. Pools and their buffers
+ * belong to one thread, like event loops.
+ *
+ * ## Dependencies
+ *  stdx_string.h (for XSlice only; the implementation is not required).
+ *  stdx_io.h (for XFile; `x_net_send_file()` needs its implementation).
  */
 
 #ifndef X_NETWORK_H
@@ -28,6 +100,28 @@
 #include <stdint.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include "stdx_string.h"
+#include "stdx_io.h"
+
+#ifndef X_NET_SENDV_BATCH
+#define X_NET_SENDV_BATCH 64   /* slices handed to one sendmsg()/WSASend() call */
+#endif
+
+#ifndef X_NET_MMSG_BATCH
+#define X_NET_MMSG_BATCH 64    /* datagrams handed to one sendmmsg()/recvmmsg() call */
+#endif
+
+#ifndef X_NET_BUFFER_ALIGN
+#define X_NET_BUFFER_ALIGN 64  /* payload alignment of pooled buffers, one cache line */
+#endif
+
+#ifndef X_NET_BUFFER_SLAB
+#define X_NET_BUFFER_SLAB 32   /* buffers allocated at once when a pool grows */
+#endif
+
+#ifndef X_NET_SEND_FILE_CHUNK
+#define X_NET_SEND_FILE_CHUNK (1024 * 1024)   /* bytes handed to one sendfile()/TransmitFile() call */
+#endif
 
 #if defined(_WIN32)
 #include <winsock2.h>
@@ -43,6 +137,27 @@ extern "C" {
 #endif
 
   typedef struct XAddress XAddress;
+  typedef struct XNetLoop_t XNetLoop;
+  typedef struct XNetBufferPool_t XNetBufferPool;
+  typedef struct XNetBuffer XNetBuffer;
+
+  struct XNetBuffer
+  {
+    XNetBuffer* next;             // next buffer of the chain holding it
+    char* data;                   // payload, X_NET_BUFFER_ALIGN aligned
+    uint32_t start;               // first byte not yet consumed
+    uint32_t end;                 // one past the last byte written
+    uint32_t capacity;
+    int32_t refs;
+    XNetBufferPool* pool;         // where the buffer returns once released
+  };
+
+  typedef struct
+  {
+    XNetBuffer* head;
+    XNetBuffer* tail;
+    size_t length;                // bytes between head's start and tail's end
+  } XNetChain;
 
   typedef enum
   {
@@ -56,6 +171,29 @@ extern "C" {
     X_NET_SOCK_DGRAM = 2,
   } XSocketType;
 
+  typedef enum
+  {
+    X_NET_LOOP_READ   = 1 << 0,   // readable, or a connection is waiting on a listening socket
+    X_NET_LOOP_WRITE  = 1 << 1,   // writable
+    X_NET_LOOP_ERROR  = 1 << 2,   // socket error, reported even when not requested
+    X_NET_LOOP_HANGUP = 1 << 3,   // peer closed the connection, reported even when not requested
+  } XNetLoopEvents;
+
+  typedef struct
+  {
+    XSocket sock;
+    uint32_t events;              // XNetLoopEvents that fired
+    void* user;                   // pointer given to x_net_loop_add()
+  } XNetEvent;
+
+  typedef struct
+  {
+    void* data;                   // payload to send, or buffer to receive into
+    size_t length;                // payload size; on receive, buffer size in and bytes received out
+    XAddress* addr;               // destination, or filled with the sender; NULL on connected sockets
+    uint32_t segment_size;        // on receive with GRO: size of each coalesced datagram, 0 if just one
+  } XNetDatagram;
+
   typedef struct
   {
     int8_t name[128];
@@ -108,6 +246,38 @@ void    x_net_close(XSocket sock);
 */
 int32_t x_net_set_nonblocking(XSocket sock, int32_t nonblocking);
 
+/**
+* @brief Allow binding to a local address that still has connections in TIME_WAIT.
+* @param sock Socket handle, before bind.
+* @param enable True to enable, false to disable.
+* @return True on success, false on failure.
+*/
+bool    x_net_set_reuse_addr(XSocket sock, bool enable);
+
+/**
+* @brief Let several sockets bind the same address and port, with the kernel spreading incoming connections between them.
+* @param sock Socket handle, before bind.
+* @param enable True to enable, false to disable.
+* @return True on success, false on failure or where SO_REUSEPORT is not supported (Windows).
+*/
+bool    x_net_set_reuse_port(XSocket sock, bool enable);
+
+/**
+* @brief Let the kernel split large sends on a UDP socket into datagrams of a fixed size (UDP GSO).
+* @param sock UDP socket handle.
+* @param segment_size Datagram payload size, or 0 to turn segmentation off.
+* @return True on success, false on failure or where the kernel has no UDP segmentation offload.
+*/
+bool    x_net_set_udp_segment(XSocket sock, uint16_t segment_size);
+
+/**
+* @brief Let the kernel coalesce datagrams from one sender into a single receive (UDP GRO).
+* @param sock UDP socket handle.
+* @param enable True to enable, false to disable.
+* @return True on success, false on failure or where UDP GRO is not supported (everywhere but Linux).
+*/
+bool    x_net_set_udp_gro(XSocket sock, bool enable);
+
 /**
 * @brief Create a socket with the specified address family and socket type.
 * @param family Address family (e.g., IPv4/IPv6).
@@ -204,6 +374,28 @@ int32_t x_net_connect(XSocket sock, const XAddress* addr);
 */
 size_t  x_net_send(XSocket sock, const void* buf, size_t len);
 
+/**
+* @brief Send several buffers on a connected socket, in order, without concatenating them.
+* Keeps sending until every byte went out or the socket reports an error.
+* @param sock Connected socket handle.
+* @param parts Buffers to send.
+* @param count Number of buffers.
+* @return Number of bytes sent (less than the total on error).
+*/
+size_t  x_net_sendv(XSocket sock, const XSlice* parts, size_t count);
+
+/**
+* @brief Send a byte range of an open file on a connected socket without copying it through user memory.
+* Uses sendfile (TransmitFile on Windows) and falls back to a mapped view plus send.
+* On Windows the file position is moved to the end of the sent range.
+* @param sock Connected socket handle.
+* @param file File opened for reading.
+* @param offset Offset of the first byte to send.
+* @param len Number of bytes to send.
+* @return Number of bytes sent (less than len when the socket would block, on error, or at end of file).
+*/
+size_t  x_net_send_file(XSocket sock, XFile* file, uint64_t offset, size_t len);
+
 /**
 * @brief Receive data from a connected socket.
 * @param sock Connected socket handle.
@@ -213,6 +405,15 @@ size_t  x_net_send(XSocket sock, const void* buf, size_t len);
 */
 size_t  x_net_recv(XSocket sock, void* buf, size_t len);
 
+/**
+* @brief Receive data from a connected socket into several buffers, filled in order.
+* @param sock Connected socket handle.
+* @param parts Buffers to fill. The slices must point at writable memory.
+* @param count Number of buffers (at most X_NET_SENDV_BATCH are used).
+* @return Number of bytes received, 0 on connection closed, or (size_t)-1 on error.
+*/
+size_t  x_net_recvv(XSocket sock, const XSlice* parts, size_t count);
+
 /**
 * @brief Send data to a specific address (datagram sockets).
 * @param sock Socket handle.
@@ -233,6 +434,26 @@ size_t  x_net_sendto(XSocket sock, const void* buf, size_t len, const XAddress*
 */
 size_t  x_net_recvfrom(XSocket sock, void* buf, size_t len, XAddress* out_addr);
 
+/**
+* @brief Send several datagrams with as few system calls as the platform allows.
+* Stops at the first datagram the socket does not take.
+* @param sock Datagram socket handle.
+* @param msgs Datagrams to send; `addr` may be NULL on connected sockets.
+* @param count Number of datagrams.
+* @return Number of datagrams sent, or -1 if the first one failed.
+*/
+int32_t x_net_sendmmsg(XSocket sock, const XNetDatagram* msgs, int32_t count);
+
+/**
+* @brief Receive up to `count` datagrams: waits for the first (unless non-blocking), then takes what is already queued.
+* Each `length` is the buffer size on input and the bytes received on output.
+* @param sock Datagram socket handle.
+* @param msgs Receive buffers; senders are stored where `addr` is not NULL.
+* @param count Number of buffers.
+* @return Number of datagrams received, or -1 if none could be (check x_net_would_block()).
+*/
+int32_t x_net_recvmmsg(XSocket sock, XNetDatagram* msgs, int32_t count);
+
 /**
 * @brief Wait for readability on multiple sockets.
 * @param read_sockets Array of sockets to wait on for readability.
@@ -251,6 +472,180 @@ int32_t x_net_select(XSocket* read_sockets, int32_t read_count, int32_t timeout_
 */
 int32_t x_net_poll(XSocket sock, int32_t events, int32_t timeout_ms);
 
+/**
+* @brief Check whether the last socket call failed only because it would have blocked.
+* @return True if the last error is EAGAIN/EWOULDBLOCK (WSAEWOULDBLOCK on Windows).
+*/
+bool    x_net_would_block(void);
+
+/**
+* @brief Create an event loop.
+* @param max_events Number of events fetched from the kernel per wait (0 for a default).
+* @return New loop, or NULL on failure.
+*/
+XNetLoop* x_net_loop_create(int32_t max_events);
+
+/**
+* @brief Destroy an event loop. Registered sockets are not closed.
+* @param loop Loop to destroy.
+* @return Nothing.
+*/
+void    x_net_loop_destroy(XNetLoop* loop);
+
+/**
+* @brief Register a socket with a loop.
+* @param loop Event loop.
+* @param sock Non-blocking socket to watch.
+* @param events XNetLoopEvents mask of X_NET_LOOP_READ and/or X_NET_LOOP_WRITE.
+* @param user Pointer handed back with every event of this socket.
+* @return True on success, false on failure or if the socket is already registered.
+*/
+bool    x_net_loop_add(XNetLoop* loop, XSocket sock, uint32_t events, void* user);
+
+/**
+* @brief Change the interest and user pointer of a registered socket. Also re-arms write readiness.
+* @param loop Event loop.
+* @param sock Registered socket.
+* @param events New XNetLoopEvents mask.
+* @param user New user pointer.
+* @return True on success, false on failure.
+*/
+bool    x_net_loop_modify(XNetLoop* loop, XSocket sock, uint32_t events, void* user);
+
+/**
+* @brief Unregister a socket. Events already fetched for it are not reported.
+* @param loop Event loop.
+* @param sock Registered socket.
+* @return True on success, false if the socket was not registered.
+*/
+bool    x_net_loop_remove(XNetLoop* loop, XSocket sock);
+
+/**
+* @brief Wait for ready sockets.
+* @param loop Event loop.
+* @param out_events Output array receiving ready events.
+* @param max_events Capacity of out_events.
+* @param timeout_ms Timeout in milliseconds (-1 for infinite, 0 for non-blocking poll).
+* @return Number of events written, 0 on timeout or wake-up, or -1 on error.
+*/
+int32_t x_net_loop_wait(XNetLoop* loop, XNetEvent* out_events, int32_t max_events, int32_t timeout_ms);
+
+/**
+* @brief Make a blocked x_net_loop_wait() return early. Safe to call from any thread.
+* @param loop Event loop.
+* @return True on success, false on failure.
+*/
+bool    x_net_loop_wake(XNetLoop* loop);
+
+/**
+* @brief Create a pool of fixed-size buffers.
+* @param buffer_size Payload bytes per buffer, rounded up to X_NET_BUFFER_ALIGN.
+* @param max_buffers Most buffers handed out at once, 0 for no limit.
+* @return New pool, or NULL on failure.
+*/
+XNetBufferPool* x_net_buffer_pool_create(size_t buffer_size, size_t max_buffers);
+
+/**
+* @brief Destroy a pool and every slab it allocated, including buffers still in use.
+* @param pool Pool to destroy.
+* @return Nothing.
+*/
+void    x_net_buffer_pool_destroy(XNetBufferPool* pool);
+
+/**
+* @brief Number of buffers currently handed out by a pool.
+* @param pool Buffer pool.
+* @return Buffers in use.
+*/
+size_t  x_net_buffer_pool_in_use(const XNetBufferPool* pool);
+
+/**
+* @brief Take an empty buffer from the pool, with one reference.
+* @param pool Buffer pool.
+* @return Buffer, or NULL when the pool is at its limit or out of memory.
+*/
+XNetBuffer* x_net_buffer_acquire(XNetBufferPool* pool);
+
+/**
+* @brief Add a reference to a buffer.
+* @param buf Buffer.
+* @return Nothing.
+*/
+void    x_net_buffer_retain(XNetBuffer* buf);
+
+/**
+* @brief Drop a reference; the last one returns the buffer to its pool.
+* @param buf Buffer, or NULL.
+* @return Nothing.
+*/
+void    x_net_buffer_release(XNetBuffer* buf);
+
+/**
+* @brief Append a buffer to a chain, which takes over the caller's reference.
+* @param chain Chain.
+* @param buf Buffer not held by any other chain.
+* @return Nothing.
+*/
+void    x_net_chain_append(XNetChain* chain, XNetBuffer* buf);
+
+/**
+* @brief Move every buffer of `src` to the end of `dst` without copying. `src` is left empty.
+* @param dst Destination chain.
+* @param src Source chain.
+* @return Nothing.
+*/
+void    x_net_chain_move(XNetChain* dst, XNetChain* src);
+
+/**
+* @brief Drop bytes from the front of a chain, releasing buffers that become empty.
+* @param chain Chain.
+* @param len Number of bytes to drop (clamped to the chain length).
+* @return Nothing.
+*/
+void    x_net_chain_consume(XNetChain* chain, size_t len);
+
+/**
+* @brief Release every buffer of a chain and leave it empty.
+* @param chain Chain.
+* @return Nothing.
+*/
+void    x_net_chain_release(XNetChain* chain);
+
+/**
+* @brief Describe the bytes of a chain as slices, without copying.
+* @param chain Chain.
+* @param out Output slices, one per non-empty buffer.
+* @param max Capacity of out.
+* @return Number of slices written.
+*/
+size_t  x_net_chain_gather(const XNetChain* chain, XSlice* out, size_t max);
+
+/**
+* @brief Copy bytes from the front of a chain into contiguous memory. The chain is not changed.
+* @param chain Chain.
+* @param dst Destination buffer.
+* @param len Most bytes to copy.
+* @return Number of bytes copied.
+*/
+size_t  x_net_chain_copy(const XNetChain* chain, void* dst, size_t len);
+
+/**
+* @brief Receive into a chain: fills its last buffer, then fresh buffers from `pool`, until a read comes up short.
+* @param sock Connected socket handle.
+* @param pool Pool providing new buffers.
+* @param chain Chain receiving the data.
+* @return Bytes received, 0 on connection closed, or (size_t)-1 on error, would-block or exhausted pool (ENOBUFS).
+*/
+size_t  x_net_recv_chain(XSocket sock, XNetBufferPool* pool, XNetChain* chain);
+
+/**
+* @brief Send the bytes of a chain with gather writes, consuming what was sent.
+* @param sock Connected socket handle.
+* @param chain Chain to send from.
+* @return Number of bytes sent (less than the chain length when the socket would block or failed).
+*/
+size_t  x_net_send_chain(XSocket sock, XNetChain* chain);
+
 /**
 * @brief Resolve a host and service/port into a network address.
 * @param host Hostname or address string.
@@ -439,8 +834,11 @@ int32_t x_net_get_last_error_message(char* buf, int32_t buf_len);
 #include <ws2tcpip.h>
 #include <iphlpapi.h>
 #include <windows.h>
+#include <mswsock.h>
+#include <io.h>
 #pragma comment(lib, "iphlpapi.lib")
 #pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "mswsock.lib")
 #else
 #include <ifaddrs.h>
 #include <sys/types.h>
@@ -448,11 +846,39 @@ int32_t x_net_get_last_error_message(char* buf, int32_t buf_len);
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <sys/uio.h>
 #include <net/if.h>
 #include <sys/ioctl.h>
 #include <netpacket/packet.h>
 #include <netinet/ip.h>
+#include <netinet/udp.h>
 #include <netdb.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#else
+#include <sys/event.h>
+#endif
+#if defined(__APPLE__) || defined(__FreeBSD__)
+#include <sys/uio.h>
+#endif
+#endif
+
+#ifdef MSG_NOSIGNAL
+#define X_NET_SEND_FLAGS MSG_NOSIGNAL   /* a closed peer reports EPIPE instead of raising SIGPIPE */
+#else
+#define X_NET_SEND_FLAGS 0
+#endif
+
+#ifndef X_NET_LOOP_DEFAULT_EVENTS
+#define X_NET_LOOP_DEFAULT_EVENTS 256   /* kernel events fetched per x_net_loop_wait() call */
 #endif
 
 #ifndef X_NET_ALLOC
@@ -501,7 +927,8 @@ extern "C" {
     if (r == 0) x_net_initialized = true;
     return true;
 #else
-    return false;
+    x_net_initialized = true;
+    return true;
 #endif
   }
 
@@ -551,6 +978,51 @@ extern "C" {
 #endif
   }
 
+  bool x_net_set_reuse_addr(XSocket sock, bool enable)
+  {
+    int32_t val = enable ? 1 : 0;
+    return setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&val, sizeof(val)) == 0;
+  }
+
+  bool x_net_set_reuse_port(XSocket sock, bool enable)
+  {
+#if defined(SO_REUSEPORT)
+    int32_t val = enable ? 1 : 0;
+    return setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, (const char*)&val, sizeof(val)) == 0;
+#else
+    (void)sock;
+    (void)enable;
+    return false;
+#endif
+  }
+
+  bool x_net_set_udp_segment(XSocket sock, uint16_t segment_size)
+  {
+#if defined(_WIN32) && defined(UDP_SEND_MSG_SIZE)
+    DWORD val = segment_size;
+    return setsockopt(sock, IPPROTO_UDP, UDP_SEND_MSG_SIZE, (const char*)&val, sizeof(val)) == 0;
+#elif defined(UDP_SEGMENT)
+    int32_t val = segment_size;
+    return setsockopt(sock, IPPROTO_UDP, UDP_SEGMENT, (const char*)&val, sizeof(val)) == 0;
+#else
+    (void)sock;
+    (void)segment_size;
+    return false;
+#endif
+  }
+
+  bool x_net_set_udp_gro(XSocket sock, bool enable)
+  {
+#if defined(UDP_GRO) && !defined(_WIN32)
+    int32_t val = enable ? 1 : 0;
+    return setsockopt(sock, IPPROTO_UDP, UDP_GRO, (const char*)&val, sizeof(val)) == 0;
+#else
+    (void)sock;
+    (void)enable;
+    return false;
+#endif
+  }
+
   // Socket Creation
   static int32_t x_net_family_to_af(XAddressFamily family)
   {
@@ -648,16 +1120,188 @@ extern "C" {
   {
     size_t sent = 
       send(sock, (const int8_t*)buf,
-          (int) len, 0);
+          (int) len, X_NET_SEND_FLAGS);
     return sent;
   }
 
+  size_t x_net_sendv(XSocket sock, const XSlice* parts, size_t count)
+  {
+    size_t total = 0;
+    size_t i = 0;
+    size_t skip = 0;    // bytes of parts[i] already sent
+#if defined(_WIN32)
+    WSABUF bufs[X_NET_SENDV_BATCH];
+#else
+    struct iovec bufs[X_NET_SENDV_BATCH];
+#endif
+
+    if (!parts) return 0;
+
+    while (i < count)
+    {
+      int32_t n = 0;
+      for (size_t j = i; j < count && n < X_NET_SENDV_BATCH; j++)
+      {
+        size_t off = (j == i) ? skip : 0;
+        if (parts[j].length == off) continue;
+#if defined(_WIN32)
+        bufs[n].buf = (CHAR*)(parts[j].ptr + off);
+        bufs[n].len = (ULONG)(parts[j].length - off);
+#else
+        bufs[n].iov_base = (void*)(parts[j].ptr + off);
+        bufs[n].iov_len = parts[j].length - off;
+#endif
+        n++;
+      }
+      if (n == 0) break;
+
+      size_t sent;
+#if defined(_WIN32)
+      DWORD wsent = 0;
+      if (WSASend(sock, bufs, (DWORD)n, &wsent, 0, NULL, NULL) != 0 || wsent == 0) break;
+      sent = (size_t)wsent;
+#else
+      struct msghdr msg;
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = bufs;
+      msg.msg_iovlen = (size_t)n;
+      ssize_t r = sendmsg(sock, &msg, X_NET_SEND_FLAGS);
+      if (r <= 0) break;
+      sent = (size_t)r;
+#endif
+      total += sent;
+
+      while (i < count && sent >= parts[i].length - skip)
+      {
+        sent -= parts[i].length - skip;
+        skip = 0;
+        i++;
+      }
+      skip += sent;
+    }
+    return total;
+  }
+
+#if !defined(_WIN32)
+  /* Portable fallback: map the range and send from the mapping. */
+  static size_t s_net_send_file_mapped(XSocket sock, int32_t fd, uint64_t offset, size_t len)
+  {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || offset >= (uint64_t)st.st_size) return 0;
+    if (len > (uint64_t)st.st_size - offset) len = (size_t)((uint64_t)st.st_size - offset);
+
+    uint64_t page = (uint64_t)sysconf(_SC_PAGESIZE);
+    uint64_t base = offset - offset % page;
+    size_t lead = (size_t)(offset - base);
+    void* view = mmap(NULL, len + lead, PROT_READ, MAP_SHARED, fd, (off_t)base);
+    if (view == MAP_FAILED) return 0;
+
+    size_t total = 0;
+    while (total < len)
+    {
+      ssize_t r = send(sock, (const char*)view + lead + total, len - total, X_NET_SEND_FLAGS);
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) break;
+      total += (size_t)r;
+    }
+    munmap(view, len + lead);
+    return total;
+  }
+#endif
+
+  size_t x_net_send_file(XSocket sock, XFile* file, uint64_t offset, size_t len)
+  {
+    int32_t fd = x_io_fileno(file);
+    size_t total = 0;
+    if (fd < 0) return 0;
+
+#if defined(_WIN32)
+    HANDLE h = (HANDLE)_get_osfhandle(fd);
+    LARGE_INTEGER pos;
+    if (h == INVALID_HANDLE_VALUE) return 0;
+    while (total < len)
+    {
+      DWORD chunk = (DWORD)((len - total) < X_NET_SEND_FILE_CHUNK ? (len - total) : X_NET_SEND_FILE_CHUNK);
+      pos.QuadPart = (LONGLONG)(offset + total);
+      if (!SetFilePointerEx(h, pos, NULL, FILE_BEGIN)) break;
+      // Without an OVERLAPPED the call completes synchronously and posts
+      // nothing to a completion port the socket may be bound to.
+      if (!TransmitFile(sock, h, chunk, 0, NULL, NULL, 0)) break;
+      total += chunk;
+    }
+    return total;
+#elif defined(__linux__)
+    off_t off = (off_t)offset;
+    while (total < len)
+    {
+      size_t chunk = (len - total) < X_NET_SEND_FILE_CHUNK ? (len - total) : X_NET_SEND_FILE_CHUNK;
+      ssize_t r = sendfile(sock, fd, &off, chunk);
+      if (r < 0 && errno == EINTR) continue;
+      if (r < 0 && total == 0 && (errno == EINVAL || errno == ENOSYS))
+        return s_net_send_file_mapped(sock, fd, offset, len);
+      if (r <= 0) break;   // would block, error or end of file
+      total += (size_t)r;
+    }
+    return total;
+#elif defined(__APPLE__) || defined(__FreeBSD__)
+    while (total < len)
+    {
+      size_t chunk = (len - total) < X_NET_SEND_FILE_CHUNK ? (len - total) : X_NET_SEND_FILE_CHUNK;
+#if defined(__APPLE__)
+      off_t n = (off_t)chunk;
+      int32_t r = sendfile(fd, sock, (off_t)(offset + total), &n, NULL, 0);
+#else
+      off_t n = 0;
+      int32_t r = sendfile(fd, sock, (off_t)(offset + total), chunk, NULL, &n, 0);
+#endif
+      // A partial send reports its count together with EAGAIN
+      total += (size_t)n;
+      if (r < 0 && errno == EINTR) continue;
+      if (r < 0 && total == 0 && (errno == ENOTSOCK || errno == EOPNOTSUPP))
+        return s_net_send_file_mapped(sock, fd, offset, len);
+      if (r < 0 || n == 0) break;
+    }
+    return total;
+#else
+    (void)total;
+    return s_net_send_file_mapped(sock, fd, offset, len);
+#endif
+  }
+
   size_t x_net_recv(XSocket sock, void* buf, size_t len)
   {
     size_t recvd = recv(sock, (char*)buf, (int) len, 0);
     return recvd;
   }
 
+  size_t x_net_recvv(XSocket sock, const XSlice* parts, size_t count)
+  {
+    if (!parts) return (size_t)-1;
+    if (count > X_NET_SENDV_BATCH) count = X_NET_SENDV_BATCH;
+#if defined(_WIN32)
+    WSABUF bufs[X_NET_SENDV_BATCH];
+    for (size_t i = 0; i < count; i++)
+    {
+      bufs[i].buf = (CHAR*)parts[i].ptr;
+      bufs[i].len = (ULONG)parts[i].length;
+    }
+    DWORD received = 0;
+    DWORD flags = 0;
+    if (WSARecv(sock, bufs, (DWORD)count, &received, &flags, NULL, NULL) != 0) return (size_t)-1;
+    return (size_t)received;
+#else
+    struct iovec bufs[X_NET_SENDV_BATCH];
+    for (size_t i = 0; i < count; i++)
+    {
+      bufs[i].iov_base = (void*)parts[i].ptr;
+      bufs[i].iov_len = parts[i].length;
+    }
+    ssize_t r;
+    do r = readv(sock, bufs, (int)count); while (r < 0 && errno == EINTR);
+    return r < 0 ? (size_t)-1 : (size_t)r;
+#endif
+  }
+
   size_t x_net_sendto(XSocket sock, const void* buf, size_t len, const XAddress* addr)
   {
     size_t sent = sendto(sock, (const int8_t*)buf, (int) len, 0, (const struct sockaddr*)&addr->addr, addr->addrlen);
@@ -668,7 +1312,7 @@ extern "C" {
   {
     socklen_t addrlen = sizeof(out_addr->addr);
     size_t recvd = recvfrom(sock, (char*)buf, (int) len, 0, (struct sockaddr*)&out_addr->addr, &addrlen);
-    if (recvd >= 0)
+    if (recvd != (size_t)-1)
     {
       out_addr->family = out_addr->addr.ss_family;
       out_addr->addrlen = addrlen;
@@ -676,25 +1320,189 @@ extern "C" {
     return recvd;
   }
 
-  int32_t x_net_select(XSocket* read_sockets, int32_t read_count, int32_t timeout_ms)
+#if defined(__linux__)
+  /* struct mmsghdr, without depending on _GNU_SOURCE being defined before the first system header */
+  typedef struct
   {
-    if (read_count <= 0 || read_sockets == NULL) return -1;
+    struct msghdr msg_hdr;
+    unsigned int msg_len;
+  } XNetMmsgHdr;
 
-    fd_set readfds;
-    FD_ZERO(&readfds);
+#ifndef MSG_WAITFORONE
+#define MSG_WAITFORONE 0x10000
+#endif
+#endif
 
-    XSocket maxfd = 0;
-    for (int i = 0; i < read_count; i++)
+#if !defined(_WIN32)
+  static void s_net_datagram_header(struct msghdr* hdr, struct iovec* iov, const XNetDatagram* msg)
+  {
+    memset(hdr, 0, sizeof(*hdr));
+    iov->iov_base = msg->data;
+    iov->iov_len = msg->length;
+    hdr->msg_iov = iov;
+    hdr->msg_iovlen = 1;
+    if (msg->addr)
     {
-      FD_SET(read_sockets[i], &readfds);
-      if (read_sockets[i] > maxfd) maxfd = read_sockets[i];
+      hdr->msg_name = &msg->addr->addr;
+      hdr->msg_namelen = msg->addr->addrlen ? msg->addr->addrlen : sizeof(msg->addr->addr);
     }
+  }
 
-    struct timeval tv;
-    if (timeout_ms >= 0)
+  /* Stores what recvmsg() reported for one datagram, including a GRO segment size in the control data. */
+  static void s_net_datagram_received(XNetDatagram* msg, const struct msghdr* hdr, size_t received)
+  {
+    msg->length = received;
+    msg->segment_size = 0;
+    if (msg->addr)
     {
-      tv.tv_sec = timeout_ms / 1000;
-      tv.tv_usec = (timeout_ms % 1000) * 1000;
+      msg->addr->family = msg->addr->addr.ss_family;
+      msg->addr->addrlen = hdr->msg_namelen;
+    }
+#if defined(UDP_GRO)
+    for (struct cmsghdr* c = CMSG_FIRSTHDR((struct msghdr*)hdr); c; c = CMSG_NXTHDR((struct msghdr*)hdr, c))
+    {
+      if (c->cmsg_level == IPPROTO_UDP && c->cmsg_type == UDP_GRO)
+      {
+        int32_t segment;
+        memcpy(&segment, CMSG_DATA(c), sizeof(segment));
+        if ((size_t)segment < received) msg->segment_size = (uint32_t)segment;
+      }
+    }
+#endif
+  }
+#endif
+
+  int32_t x_net_sendmmsg(XSocket sock, const XNetDatagram* msgs, int32_t count)
+  {
+    if (!msgs || count <= 0) return 0;
+    int32_t done = 0;
+#if defined(__linux__)
+    XNetMmsgHdr hdrs[X_NET_MMSG_BATCH];
+    struct iovec iovs[X_NET_MMSG_BATCH];
+    while (done < count)
+    {
+      int32_t n = (count - done) < X_NET_MMSG_BATCH ? (count - done) : X_NET_MMSG_BATCH;
+      for (int32_t i = 0; i < n; i++)
+      {
+        s_net_datagram_header(&hdrs[i].msg_hdr, &iovs[i], &msgs[done + i]);
+        hdrs[i].msg_len = 0;
+      }
+      int32_t r = (int32_t)syscall(SYS_sendmmsg, sock, hdrs, (unsigned int)n, X_NET_SEND_FLAGS);
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) break;
+      done += r;
+      if (r < n) break;
+    }
+#else
+    for (; done < count; done++)
+    {
+      const XNetDatagram* msg = &msgs[done];
+#if defined(_WIN32)
+      WSABUF buf;
+      DWORD sent = 0;
+      buf.buf = (CHAR*)msg->data;
+      buf.len = (ULONG)msg->length;
+      const struct sockaddr* to = msg->addr ? (const struct sockaddr*)&msg->addr->addr : NULL;
+      int32_t to_len = msg->addr ? (int32_t)msg->addr->addrlen : 0;
+      if (WSASendTo(sock, &buf, 1, &sent, 0, to, to_len, NULL, NULL) != 0) break;
+#else
+      struct msghdr hdr;
+      struct iovec iov;
+      s_net_datagram_header(&hdr, &iov, msg);
+      ssize_t r;
+      do r = sendmsg(sock, &hdr, X_NET_SEND_FLAGS); while (r < 0 && errno == EINTR);
+      if (r < 0) break;
+#endif
+    }
+#endif
+    return done > 0 ? done : -1;
+  }
+
+  int32_t x_net_recvmmsg(XSocket sock, XNetDatagram* msgs, int32_t count)
+  {
+    if (!msgs || count <= 0) return 0;
+    int32_t done = 0;
+#if defined(__linux__)
+    XNetMmsgHdr hdrs[X_NET_MMSG_BATCH];
+    struct iovec iovs[X_NET_MMSG_BATCH];
+    union { char buf[CMSG_SPACE(sizeof(int32_t))]; size_t align; } control[X_NET_MMSG_BATCH];
+    while (done < count)
+    {
+      int32_t n = (count - done) < X_NET_MMSG_BATCH ? (count - done) : X_NET_MMSG_BATCH;
+      for (int32_t i = 0; i < n; i++)
+      {
+        s_net_datagram_header(&hdrs[i].msg_hdr, &iovs[i], &msgs[done + i]);
+        if (msgs[done + i].addr) hdrs[i].msg_hdr.msg_namelen = sizeof(msgs[done + i].addr->addr);
+        hdrs[i].msg_hdr.msg_control = control[i].buf;
+        hdrs[i].msg_hdr.msg_controllen = sizeof(control[i].buf);
+        hdrs[i].msg_len = 0;
+      }
+      // Only the very first datagram is waited for
+      int32_t flags = done == 0 ? MSG_WAITFORONE : MSG_DONTWAIT;
+      int32_t r = (int32_t)syscall(SYS_recvmmsg, sock, hdrs, (unsigned int)n, flags, NULL);
+      if (r < 0 && errno == EINTR) continue;
+      if (r <= 0) break;
+      for (int32_t i = 0; i < r; i++)
+        s_net_datagram_received(&msgs[done + i], &hdrs[i].msg_hdr, hdrs[i].msg_len);
+      done += r;
+      if (r < n) break;
+    }
+#else
+    for (; done < count; done++)
+    {
+      XNetDatagram* msg = &msgs[done];
+#if defined(_WIN32)
+      u_long queued = 0;
+      if (done > 0 && (ioctlsocket(sock, FIONREAD, &queued) != 0 || queued == 0)) break;
+      WSABUF buf;
+      DWORD received = 0;
+      DWORD flags = 0;
+      buf.buf = (CHAR*)msg->data;
+      buf.len = (ULONG)msg->length;
+      struct sockaddr* from = msg->addr ? (struct sockaddr*)&msg->addr->addr : NULL;
+      int32_t from_len = sizeof(struct sockaddr_storage);
+      if (WSARecvFrom(sock, &buf, 1, &received, &flags, from, msg->addr ? &from_len : NULL, NULL, NULL) != 0) break;
+      msg->length = received;
+      msg->segment_size = 0;
+      if (msg->addr)
+      {
+        msg->addr->family = msg->addr->addr.ss_family;
+        msg->addr->addrlen = from_len;
+      }
+#else
+      struct msghdr hdr;
+      struct iovec iov;
+      s_net_datagram_header(&hdr, &iov, msg);
+      if (msg->addr) hdr.msg_namelen = sizeof(msg->addr->addr);
+      ssize_t r;
+      do r = recvmsg(sock, &hdr, done == 0 ? 0 : MSG_DONTWAIT); while (r < 0 && errno == EINTR);
+      if (r < 0) break;
+      s_net_datagram_received(msg, &hdr, (size_t)r);
+#endif
+    }
+#endif
+    return done > 0 ? done : -1;
+  }
+
+  int32_t x_net_select(XSocket* read_sockets, int32_t read_count, int32_t timeout_ms)
+  {
+    if (read_count <= 0 || read_sockets == NULL) return -1;
+
+    fd_set readfds;
+    FD_ZERO(&readfds);
+
+    XSocket maxfd = 0;
+    for (int i = 0; i < read_count; i++)
+    {
+      FD_SET(read_sockets[i], &readfds);
+      if (read_sockets[i] > maxfd) maxfd = read_sockets[i];
+    }
+
+    struct timeval tv;
+    if (timeout_ms >= 0)
+    {
+      tv.tv_sec = timeout_ms / 1000;
+      tv.tv_usec = (timeout_ms % 1000) * 1000;
     }
 
 #if defined(_WIN32)
@@ -743,6 +1551,918 @@ extern "C" {
 #endif
   }
 
+  bool x_net_would_block(void)
+  {
+#if defined(_WIN32)
+    int32_t err = WSAGetLastError();
+    return err == WSAEWOULDBLOCK || err == WSA_IO_PENDING;
+#else
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+  }
+
+#if defined(_WIN32)
+
+  /*
+   * Readiness on top of a completion port: a zero-byte WSARecv completes
+   * when data (or a close) arrives and a zero-byte WSASend when the socket
+   * can take more data, without moving any bytes. Listening sockets cannot
+   * take overlapped reads, so FD_ACCEPT is signalled through WSAEventSelect
+   * and a thread-pool wait that posts a packet to the port.
+   */
+  typedef struct XNetLoopEntry XNetLoopEntry;
+
+  typedef struct
+  {
+    OVERLAPPED overlapped;      // first: completions hand back this address
+    XNetLoopEntry* entry;
+    uint32_t event;             // X_NET_LOOP_READ or X_NET_LOOP_WRITE
+    bool busy;                  // an overlapped operation is in flight
+  } XNetLoopOp;
+
+  struct XNetLoopEntry
+  {
+    XSocket sock;
+    void* user;
+    uint32_t events;
+    XNetLoopOp read_op;
+    XNetLoopOp write_op;
+    volatile LONG pending;      // packets that still reference this entry
+    bool removed;
+    bool listener;
+    WSAEVENT accept_event;
+    HANDLE accept_wait;
+    XNetLoop* loop;
+  };
+
+  struct XNetLoop_t
+  {
+    HANDLE port;
+    XNetLoopEntry** table;      // open addressing by socket, linear probing
+    uint32_t capacity;          // power of two
+    uint32_t count;
+    int32_t zombies;            // removed entries waiting for their last packet
+    int32_t max_events;
+    OVERLAPPED_ENTRY* entries;
+  };
+
+  static uint32_t s_net_loop_slot(const XNetLoop* loop, XSocket sock)
+  {
+    uint64_t h = (uint64_t)sock * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(h >> 32) & (loop->capacity - 1);
+  }
+
+  static XNetLoopEntry* s_net_loop_find(const XNetLoop* loop, XSocket sock)
+  {
+    for (uint32_t i = s_net_loop_slot(loop, sock); loop->table[i]; i = (i + 1) & (loop->capacity - 1))
+    {
+      if (loop->table[i]->sock == sock) return loop->table[i];
+    }
+    return NULL;
+  }
+
+  static bool s_net_loop_insert(XNetLoop* loop, XNetLoopEntry* entry)
+  {
+    if ((loop->count + 1) * 2 > loop->capacity)
+    {
+      uint32_t capacity = loop->capacity * 2;
+      XNetLoopEntry** table = (XNetLoopEntry**)X_NET_ALLOC(sizeof(XNetLoopEntry*) * capacity);
+      if (!table) return false;
+      memset(table, 0, sizeof(XNetLoopEntry*) * capacity);
+      XNetLoopEntry** old = loop->table;
+      uint32_t old_capacity = loop->capacity;
+      loop->table = table;
+      loop->capacity = capacity;
+      for (uint32_t i = 0; i < old_capacity; i++)
+      {
+        if (!old[i]) continue;
+        uint32_t j = s_net_loop_slot(loop, old[i]->sock);
+        while (table[j]) j = (j + 1) & (capacity - 1);
+        table[j] = old[i];
+      }
+      X_NET_FREE(old);
+    }
+
+    uint32_t i = s_net_loop_slot(loop, entry->sock);
+    while (loop->table[i]) i = (i + 1) & (loop->capacity - 1);
+    loop->table[i] = entry;
+    loop->count++;
+    return true;
+  }
+
+  static void s_net_loop_erase(XNetLoop* loop, XNetLoopEntry* entry)
+  {
+    uint32_t mask = loop->capacity - 1;
+    uint32_t i = s_net_loop_slot(loop, entry->sock);
+    while (loop->table[i] != entry) i = (i + 1) & mask;
+    loop->table[i] = NULL;
+    loop->count--;
+
+    // Backward-shift deletion keeps probe chains intact without tombstones
+    for (uint32_t j = (i + 1) & mask; loop->table[j]; j = (j + 1) & mask)
+    {
+      uint32_t home = s_net_loop_slot(loop, loop->table[j]->sock);
+      if (((j - home) & mask) >= ((j - i) & mask))
+      {
+        loop->table[i] = loop->table[j];
+        loop->table[j] = NULL;
+        i = j;
+      }
+    }
+  }
+
+  static void s_net_loop_post(XNetLoopEntry* entry, XNetLoopOp* op)
+  {
+    InterlockedIncrement(&entry->pending);
+    if (!PostQueuedCompletionStatus(entry->loop->port, 0, 0, &op->overlapped))
+      InterlockedDecrement(&entry->pending);
+  }
+
+  static void s_net_loop_arm(XNetLoopEntry* entry, XNetLoopOp* op)
+  {
+    if (op->busy) return;
+
+    WSABUF buf;
+    buf.len = 0;
+    buf.buf = NULL;
+    DWORD flags = 0;
+    memset(&op->overlapped, 0, sizeof(op->overlapped));
+    op->busy = true;
+    InterlockedIncrement(&entry->pending);
+
+    int32_t r = (op->event == X_NET_LOOP_READ)
+      ? WSARecv(entry->sock, &buf, 1, NULL, &flags, &op->overlapped, NULL)
+      : WSASend(entry->sock, &buf, 1, NULL, 0, &op->overlapped, NULL);
+    if (r == 0 || WSAGetLastError() == WSA_IO_PENDING) return;
+
+    // Failed to start; report it through the port like any other completion
+    op->busy = false;
+    op->overlapped.Internal = (ULONG_PTR)0xC0000001L;   // STATUS_UNSUCCESSFUL
+    InterlockedDecrement(&entry->pending);
+    s_net_loop_post(entry, op);
+  }
+
+  static VOID CALLBACK s_net_loop_accept_ready(PVOID context, BOOLEAN timed_out)
+  {
+    (void)timed_out;
+    XNetLoopEntry* entry = (XNetLoopEntry*)context;
+    WSANETWORKEVENTS ne;
+    if (WSAEnumNetworkEvents(entry->sock, entry->accept_event, &ne) == 0 && (ne.lNetworkEvents & FD_ACCEPT))
+      s_net_loop_post(entry, &entry->read_op);
+  }
+
+  static void s_net_loop_cancel(XNetLoopEntry* entry, XNetLoopOp* op)
+  {
+    if (op->busy)
+      CancelIoEx((HANDLE)entry->sock, &op->overlapped);
+  }
+
+  XNetLoop* x_net_loop_create(int32_t max_events)
+  {
+    XNetLoop* loop = (XNetLoop*)X_NET_ALLOC(sizeof(XNetLoop));
+    if (!loop) return NULL;
+    memset(loop, 0, sizeof(*loop));
+    loop->max_events = max_events > 0 ? max_events : X_NET_LOOP_DEFAULT_EVENTS;
+    loop->capacity = 64;
+    loop->table = (XNetLoopEntry**)X_NET_ALLOC(sizeof(XNetLoopEntry*) * loop->capacity);
+    loop->entries = (OVERLAPPED_ENTRY*)X_NET_ALLOC(sizeof(OVERLAPPED_ENTRY) * (size_t)loop->max_events);
+    loop->port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (!loop->table || !loop->entries || !loop->port)
+    {
+      if (loop->port) CloseHandle(loop->port);
+      X_NET_FREE(loop->table);
+      X_NET_FREE(loop->entries);
+      X_NET_FREE(loop);
+      return NULL;
+    }
+    memset(loop->table, 0, sizeof(XNetLoopEntry*) * loop->capacity);
+    return loop;
+  }
+
+  bool x_net_loop_add(XNetLoop* loop, XSocket sock, uint32_t events, void* user)
+  {
+    if (!loop || sock == INVALID_SOCKET || s_net_loop_find(loop, sock)) return false;
+
+    XNetLoopEntry* entry = (XNetLoopEntry*)X_NET_ALLOC(sizeof(XNetLoopEntry));
+    if (!entry) return false;
+    memset(entry, 0, sizeof(*entry));
+    entry->sock = sock;
+    entry->user = user;
+    entry->events = events;
+    entry->loop = loop;
+    entry->read_op.entry = entry;
+    entry->read_op.event = X_NET_LOOP_READ;
+    entry->write_op.entry = entry;
+    entry->write_op.event = X_NET_LOOP_WRITE;
+
+    BOOL listening = FALSE;
+    int32_t len = sizeof(listening);
+    entry->listener = getsockopt(sock, SOL_SOCKET, SO_ACCEPTCONN, (char*)&listening, &len) == 0 && listening;
+
+    if (entry->listener)
+    {
+      entry->accept_event = WSACreateEvent();
+      if (entry->accept_event == WSA_INVALID_EVENT
+          || WSAEventSelect(sock, entry->accept_event, FD_ACCEPT) != 0
+          || !RegisterWaitForSingleObject(&entry->accept_wait, entry->accept_event, s_net_loop_accept_ready, entry, INFINITE, WT_EXECUTEINWAITTHREAD))
+      {
+        if (entry->accept_event != WSA_INVALID_EVENT) WSACloseEvent(entry->accept_event);
+        X_NET_FREE(entry);
+        return false;
+      }
+    }
+    else
+    {
+      // Accepted sockets inherit the listener's WSAEventSelect association
+      WSAEventSelect(sock, NULL, 0);
+      if (!CreateIoCompletionPort((HANDLE)sock, loop->port, 0, 0))
+      {
+        X_NET_FREE(entry);
+        return false;
+      }
+    }
+
+    if (!s_net_loop_insert(loop, entry))
+    {
+      if (entry->listener)
+      {
+        UnregisterWaitEx(entry->accept_wait, INVALID_HANDLE_VALUE);
+        WSAEventSelect(sock, NULL, 0);
+        WSACloseEvent(entry->accept_event);
+      }
+      X_NET_FREE(entry);
+      return false;
+    }
+
+    if (!entry->listener)
+    {
+      if (events & X_NET_LOOP_READ) s_net_loop_arm(entry, &entry->read_op);
+      if (events & X_NET_LOOP_WRITE) s_net_loop_arm(entry, &entry->write_op);
+    }
+    return true;
+  }
+
+  bool x_net_loop_modify(XNetLoop* loop, XSocket sock, uint32_t events, void* user)
+  {
+    if (!loop) return false;
+    XNetLoopEntry* entry = s_net_loop_find(loop, sock);
+    if (!entry) return false;
+
+    entry->events = events;
+    entry->user = user;
+    if (entry->listener) return true;
+
+    if (events & X_NET_LOOP_READ) s_net_loop_arm(entry, &entry->read_op);
+    else s_net_loop_cancel(entry, &entry->read_op);
+    if (events & X_NET_LOOP_WRITE) s_net_loop_arm(entry, &entry->write_op);
+    else s_net_loop_cancel(entry, &entry->write_op);
+    return true;
+  }
+
+  bool x_net_loop_remove(XNetLoop* loop, XSocket sock)
+  {
+    if (!loop) return false;
+    XNetLoopEntry* entry = s_net_loop_find(loop, sock);
+    if (!entry) return false;
+
+    s_net_loop_erase(loop, entry);
+    entry->removed = true;
+    if (entry->listener)
+    {
+      // Waits for a running callback, so nothing posts after this
+      UnregisterWaitEx(entry->accept_wait, INVALID_HANDLE_VALUE);
+      WSAEventSelect(sock, NULL, 0);
+      WSACloseEvent(entry->accept_event);
+    }
+    s_net_loop_cancel(entry, &entry->read_op);
+    s_net_loop_cancel(entry, &entry->write_op);
+
+    if (InterlockedCompareExchange(&entry->pending, 0, 0) == 0)
+      X_NET_FREE(entry);
+    else
+      loop->zombies++;
+    return true;
+  }
+
+  int32_t x_net_loop_wait(XNetLoop* loop, XNetEvent* out_events, int32_t max_events, int32_t timeout_ms)
+  {
+    if (!loop || !out_events || max_events <= 0) return -1;
+
+    ULONG fetched = 0;
+    ULONG limit = (ULONG)(max_events < loop->max_events ? max_events : loop->max_events);
+    if (!GetQueuedCompletionStatusEx(loop->port, loop->entries, limit, &fetched,
+          timeout_ms < 0 ? INFINITE : (DWORD)timeout_ms, FALSE))
+    {
+      return GetLastError() == WAIT_TIMEOUT ? 0 : -1;
+    }
+
+    int32_t count = 0;
+    for (ULONG i = 0; i < fetched; i++)
+    {
+      OVERLAPPED* ov = loop->entries[i].lpOverlapped;
+      if (!ov) continue;    // x_net_loop_wake()
+
+      XNetLoopOp* op = (XNetLoopOp*)ov;
+      XNetLoopEntry* entry = op->entry;
+      // Posted packets never touch the OVERLAPPED; only real operations complete with status
+      bool posted = entry->listener || !op->busy;
+      if (!posted) op->busy = false;
+      LONG left = InterlockedDecrement(&entry->pending);
+
+      if (entry->removed)
+      {
+        if (left == 0)
+        {
+          X_NET_FREE(entry);
+          loop->zombies--;
+        }
+        continue;
+      }
+
+      LONG status = (LONG)ov->Internal;
+      if (!posted && status == (LONG)0xC0000120L) continue;   // STATUS_CANCELLED by modify
+      if (!(entry->events & op->event) && status == 0) continue;
+
+      uint32_t fired = op->event;
+      if (status != 0) fired = X_NET_LOOP_ERROR | X_NET_LOOP_HANGUP;
+
+      XNetEvent* ev = (count > 0 && out_events[count - 1].sock == entry->sock) ? &out_events[count - 1] : NULL;
+      if (!ev)
+      {
+        if (count == max_events) continue;
+        ev = &out_events[count++];
+        ev->sock = entry->sock;
+        ev->events = 0;
+        ev->user = entry->user;
+      }
+      ev->events |= fired;
+
+      // Reads stay armed; a still-readable socket completes again right away
+      if (op->event == X_NET_LOOP_READ && !entry->listener && status == 0 && (entry->events & X_NET_LOOP_READ))
+        s_net_loop_arm(entry, op);
+    }
+    return count;
+  }
+
+  bool x_net_loop_wake(XNetLoop* loop)
+  {
+    return loop && PostQueuedCompletionStatus(loop->port, 0, 0, NULL);
+  }
+
+  void x_net_loop_destroy(XNetLoop* loop)
+  {
+    if (!loop) return;
+
+    for (uint32_t i = 0; i < loop->capacity; )
+    {
+      if (loop->table[i]) x_net_loop_remove(loop, loop->table[i]->sock);   // erase may shift another entry into slot i
+      else i++;
+    }
+
+    // Cancelled operations still complete through the port
+    while (loop->zombies > 0)
+    {
+      ULONG fetched = 0;
+      if (!GetQueuedCompletionStatusEx(loop->port, loop->entries, (ULONG)loop->max_events, &fetched, 1000, FALSE))
+        break;
+      for (ULONG i = 0; i < fetched; i++)
+      {
+        OVERLAPPED* ov = loop->entries[i].lpOverlapped;
+        if (!ov) continue;
+        XNetLoopEntry* entry = ((XNetLoopOp*)ov)->entry;
+        if (InterlockedDecrement(&entry->pending) == 0)
+        {
+          X_NET_FREE(entry);
+          loop->zombies--;
+        }
+      }
+    }
+
+    CloseHandle(loop->port);
+    X_NET_FREE(loop->table);
+    X_NET_FREE(loop->entries);
+    X_NET_FREE(loop);
+  }
+
+#else
+
+  typedef struct
+  {
+    void* user;
+    uint32_t events;
+    bool used;
+  } XNetLoopEntry;
+
+  struct XNetLoop_t
+  {
+    int32_t fd;                 // epoll or kqueue descriptor
+#if defined(__linux__)
+    int32_t wake_fd;            // eventfd
+    struct epoll_event* events;
+#else
+    struct kevent* events;
+#endif
+    int32_t max_events;
+    XNetLoopEntry* entries;     // indexed by socket descriptor
+    int32_t capacity;
+  };
+
+  static XNetLoopEntry* s_net_loop_entry(XNetLoop* loop, XSocket sock, bool grow)
+  {
+    if (sock < 0) return NULL;
+    if (sock >= loop->capacity)
+    {
+      if (!grow) return NULL;
+      int32_t capacity = loop->capacity ? loop->capacity : 256;
+      while (capacity <= sock) capacity *= 2;
+      XNetLoopEntry* entries = (XNetLoopEntry*)X_NET_ALLOC(sizeof(XNetLoopEntry) * (size_t)capacity);
+      if (!entries) return NULL;
+      if (loop->capacity > 0)
+        memcpy(entries, loop->entries, sizeof(XNetLoopEntry) * (size_t)loop->capacity);
+      memset(entries + loop->capacity, 0, sizeof(XNetLoopEntry) * (size_t)(capacity - loop->capacity));
+      X_NET_FREE(loop->entries);
+      loop->entries = entries;
+      loop->capacity = capacity;
+    }
+    return &loop->entries[sock];
+  }
+
+#if defined(__linux__)
+  static uint32_t s_net_loop_epoll_mask(uint32_t events)
+  {
+    uint32_t mask = EPOLLET | EPOLLRDHUP;
+    if (events & X_NET_LOOP_READ) mask |= EPOLLIN;
+    if (events & X_NET_LOOP_WRITE) mask |= EPOLLOUT;
+    return mask;
+  }
+#else
+  static bool s_net_loop_kevent(XNetLoop* loop, XSocket sock, uint32_t old_events, uint32_t events)
+  {
+    struct kevent changes[2];
+    int32_t n = 0;
+    if ((events ^ old_events) & X_NET_LOOP_READ)
+    {
+      EV_SET(&changes[n], sock, EVFILT_READ, (events & X_NET_LOOP_READ) ? EV_ADD | EV_CLEAR : EV_DELETE, 0, 0, NULL);
+      n++;
+    }
+    if ((events ^ old_events) & X_NET_LOOP_WRITE || (events & X_NET_LOOP_WRITE))
+    {
+      // Re-adding the write filter re-arms it, matching the Windows contract
+      EV_SET(&changes[n], sock, EVFILT_WRITE, (events & X_NET_LOOP_WRITE) ? EV_ADD | EV_CLEAR : EV_DELETE, 0, 0, NULL);
+      n++;
+    }
+    return n == 0 || kevent(loop->fd, changes, n, NULL, 0, NULL) == 0;
+  }
+#endif
+
+  XNetLoop* x_net_loop_create(int32_t max_events)
+  {
+    XNetLoop* loop = (XNetLoop*)X_NET_ALLOC(sizeof(XNetLoop));
+    if (!loop) return NULL;
+    memset(loop, 0, sizeof(*loop));
+    loop->max_events = max_events > 0 ? max_events : X_NET_LOOP_DEFAULT_EVENTS;
+    loop->events = X_NET_ALLOC(sizeof(*loop->events) * (size_t)loop->max_events);
+
+#if defined(__linux__)
+    loop->fd = epoll_create1(EPOLL_CLOEXEC);
+    loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (loop->events && loop->fd >= 0 && loop->wake_fd >= 0)
+    {
+      struct epoll_event ev;
+      ev.events = EPOLLIN | EPOLLET;
+      ev.data.fd = loop->wake_fd;
+      if (epoll_ctl(loop->fd, EPOLL_CTL_ADD, loop->wake_fd, &ev) == 0)
+        return loop;
+    }
+    if (loop->wake_fd >= 0) close(loop->wake_fd);
+#else
+    loop->fd = kqueue();
+    if (loop->events && loop->fd >= 0)
+    {
+      struct kevent ev;
+      EV_SET(&ev, 0, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, NULL);
+      if (kevent(loop->fd, &ev, 1, NULL, 0, NULL) == 0)
+        return loop;
+    }
+#endif
+
+    if (loop->fd >= 0) close(loop->fd);
+    X_NET_FREE(loop->events);
+    X_NET_FREE(loop);
+    return NULL;
+  }
+
+  void x_net_loop_destroy(XNetLoop* loop)
+  {
+    if (!loop) return;
+#if defined(__linux__)
+    close(loop->wake_fd);
+#endif
+    close(loop->fd);
+    X_NET_FREE(loop->events);
+    X_NET_FREE(loop->entries);
+    X_NET_FREE(loop);
+  }
+
+  bool x_net_loop_add(XNetLoop* loop, XSocket sock, uint32_t events, void* user)
+  {
+    if (!loop) return false;
+    XNetLoopEntry* entry = s_net_loop_entry(loop, sock, true);
+    if (!entry || entry->used) return false;
+
+#if defined(__linux__)
+    struct epoll_event ev;
+    ev.events = s_net_loop_epoll_mask(events);
+    ev.data.fd = sock;
+    if (epoll_ctl(loop->fd, EPOLL_CTL_ADD, sock, &ev) != 0) return false;
+#else
+    if (!s_net_loop_kevent(loop, sock, 0, events)) return false;
+#endif
+
+    entry->used = true;
+    entry->events = events;
+    entry->user = user;
+    return true;
+  }
+
+  bool x_net_loop_modify(XNetLoop* loop, XSocket sock, uint32_t events, void* user)
+  {
+    if (!loop) return false;
+    XNetLoopEntry* entry = s_net_loop_entry(loop, sock, false);
+    if (!entry || !entry->used) return false;
+
+#if defined(__linux__)
+    // EPOLL_CTL_MOD re-evaluates readiness, which re-arms the edge
+    struct epoll_event ev;
+    ev.events = s_net_loop_epoll_mask(events);
+    ev.data.fd = sock;
+    if (epoll_ctl(loop->fd, EPOLL_CTL_MOD, sock, &ev) != 0) return false;
+#else
+    if (!s_net_loop_kevent(loop, sock, entry->events, events)) return false;
+#endif
+
+    entry->events = events;
+    entry->user = user;
+    return true;
+  }
+
+  bool x_net_loop_remove(XNetLoop* loop, XSocket sock)
+  {
+    if (!loop) return false;
+    XNetLoopEntry* entry = s_net_loop_entry(loop, sock, false);
+    if (!entry || !entry->used) return false;
+
+#if defined(__linux__)
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    epoll_ctl(loop->fd, EPOLL_CTL_DEL, sock, &ev);
+#else
+    s_net_loop_kevent(loop, sock, entry->events, 0);
+#endif
+
+    memset(entry, 0, sizeof(*entry));
+    return true;
+  }
+
+  int32_t x_net_loop_wait(XNetLoop* loop, XNetEvent* out_events, int32_t max_events, int32_t timeout_ms)
+  {
+    if (!loop || !out_events || max_events <= 0) return -1;
+
+    int32_t limit = max_events < loop->max_events ? max_events : loop->max_events;
+    int32_t count = 0;
+
+#if defined(__linux__)
+    int32_t n = epoll_wait(loop->fd, loop->events, limit, timeout_ms);
+    if (n < 0) return errno == EINTR ? 0 : -1;
+
+    for (int32_t i = 0; i < n; i++)
+    {
+      struct epoll_event* e = &loop->events[i];
+      if (e->data.fd == loop->wake_fd)
+      {
+        uint64_t value;
+        while (read(loop->wake_fd, &value, sizeof(value)) > 0) { }
+        continue;
+      }
+
+      // Entries removed earlier in this batch are skipped
+      XNetLoopEntry* entry = s_net_loop_entry(loop, e->data.fd, false);
+      if (!entry || !entry->used) continue;
+
+      uint32_t fired = 0;
+      if (e->events & EPOLLIN) fired |= X_NET_LOOP_READ;
+      if (e->events & EPOLLOUT) fired |= X_NET_LOOP_WRITE;
+      if (e->events & EPOLLERR) fired |= X_NET_LOOP_ERROR;
+      if (e->events & (EPOLLHUP | EPOLLRDHUP)) fired |= X_NET_LOOP_HANGUP;
+
+      XNetEvent* ev = &out_events[count++];
+      ev->sock = e->data.fd;
+      ev->events = fired;
+      ev->user = entry->user;
+    }
+#else
+    struct timespec ts;
+    if (timeout_ms >= 0)
+    {
+      ts.tv_sec = timeout_ms / 1000;
+      ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    }
+    int32_t n = kevent(loop->fd, NULL, 0, loop->events, limit, timeout_ms >= 0 ? &ts : NULL);
+    if (n < 0) return errno == EINTR ? 0 : -1;
+
+    for (int32_t i = 0; i < n; i++)
+    {
+      struct kevent* e = &loop->events[i];
+      if (e->filter == EVFILT_USER) continue;
+
+      XSocket sock = (XSocket)e->ident;
+      XNetLoopEntry* entry = s_net_loop_entry(loop, sock, false);
+      if (!entry || !entry->used) continue;
+
+      uint32_t fired = (e->filter == EVFILT_READ) ? X_NET_LOOP_READ : X_NET_LOOP_WRITE;
+      if (e->flags & EV_ERROR) fired = X_NET_LOOP_ERROR;
+      if (e->flags & EV_EOF) fired |= X_NET_LOOP_HANGUP;
+
+      // Read and write filters of one socket come back as separate kevents
+      XNetEvent* ev = (count > 0 && out_events[count - 1].sock == sock) ? &out_events[count - 1] : NULL;
+      if (!ev)
+      {
+        ev = &out_events[count++];
+        ev->sock = sock;
+        ev->events = 0;
+        ev->user = entry->user;
+      }
+      ev->events |= fired;
+    }
+#endif
+    return count;
+  }
+
+  bool x_net_loop_wake(XNetLoop* loop)
+  {
+    if (!loop) return false;
+#if defined(__linux__)
+    uint64_t one = 1;
+    return write(loop->wake_fd, &one, sizeof(one)) == sizeof(one) || errno == EAGAIN;
+#else
+    struct kevent ev;
+    EV_SET(&ev, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, NULL);
+    return kevent(loop->fd, &ev, 1, NULL, 0, NULL) == 0;
+#endif
+  }
+
+#endif
+
+  // Buffer pools
+
+  typedef struct XNetBufferSlab
+  {
+    struct XNetBufferSlab* next;
+  } XNetBufferSlab;
+
+  struct XNetBufferPool_t
+  {
+    uint32_t buffer_size;
+    size_t max_buffers;
+    size_t total;                 // buffers carved so far
+    size_t in_use;
+    XNetBuffer* free_list;
+    XNetBufferSlab* slabs;
+  };
+
+  XNetBufferPool* x_net_buffer_pool_create(size_t buffer_size, size_t max_buffers)
+  {
+    if (buffer_size == 0 || buffer_size > UINT32_MAX - X_NET_BUFFER_ALIGN) return NULL;
+    XNetBufferPool* pool = (XNetBufferPool*)X_NET_ALLOC(sizeof(XNetBufferPool));
+    if (!pool) return NULL;
+    memset(pool, 0, sizeof(*pool));
+    pool->buffer_size = (uint32_t)((buffer_size + X_NET_BUFFER_ALIGN - 1) & ~(size_t)(X_NET_BUFFER_ALIGN - 1));
+    pool->max_buffers = max_buffers;
+    return pool;
+  }
+
+  void x_net_buffer_pool_destroy(XNetBufferPool* pool)
+  {
+    if (!pool) return;
+    XNetBufferSlab* slab = pool->slabs;
+    while (slab)
+    {
+      XNetBufferSlab* next = slab->next;
+      X_NET_FREE(slab);
+      slab = next;
+    }
+    X_NET_FREE(pool);
+  }
+
+  size_t x_net_buffer_pool_in_use(const XNetBufferPool* pool)
+  {
+    return pool ? pool->in_use : 0;
+  }
+
+  /* One allocation per slab: the link, the buffer headers, then the aligned payloads. */
+  static bool s_net_buffer_pool_grow(XNetBufferPool* pool)
+  {
+    size_t count = X_NET_BUFFER_SLAB;
+    if (pool->max_buffers && pool->max_buffers - pool->total < count)
+      count = pool->max_buffers - pool->total;
+    if (count == 0) return false;
+
+    size_t headers = sizeof(XNetBufferSlab) + sizeof(XNetBuffer) * count;
+    size_t size = headers + X_NET_BUFFER_ALIGN + (size_t)pool->buffer_size * count;
+    XNetBufferSlab* slab = (XNetBufferSlab*)X_NET_ALLOC(size);
+    if (!slab) return false;
+    slab->next = pool->slabs;
+    pool->slabs = slab;
+
+    XNetBuffer* bufs = (XNetBuffer*)(slab + 1);
+    uintptr_t payload = (uintptr_t)slab + headers;
+    payload = (payload + X_NET_BUFFER_ALIGN - 1) & ~(uintptr_t)(X_NET_BUFFER_ALIGN - 1);
+    for (size_t i = 0; i < count; i++)
+    {
+      bufs[i].data = (char*)(payload + i * pool->buffer_size);
+      bufs[i].capacity = pool->buffer_size;
+      bufs[i].pool = pool;
+      bufs[i].next = pool->free_list;
+      pool->free_list = &bufs[i];
+    }
+    pool->total += count;
+    return true;
+  }
+
+  XNetBuffer* x_net_buffer_acquire(XNetBufferPool* pool)
+  {
+    if (!pool) return NULL;
+    if (!pool->free_list && !s_net_buffer_pool_grow(pool)) return NULL;
+    XNetBuffer* buf = pool->free_list;
+    pool->free_list = buf->next;
+    buf->next = NULL;
+    buf->start = 0;
+    buf->end = 0;
+    buf->refs = 1;
+    pool->in_use++;
+    return buf;
+  }
+
+  void x_net_buffer_retain(XNetBuffer* buf)
+  {
+    if (buf) buf->refs++;
+  }
+
+  void x_net_buffer_release(XNetBuffer* buf)
+  {
+    if (!buf || --buf->refs > 0) return;
+    XNetBufferPool* pool = buf->pool;
+    buf->next = pool->free_list;
+    pool->free_list = buf;
+    pool->in_use--;
+  }
+
+  void x_net_chain_append(XNetChain* chain, XNetBuffer* buf)
+  {
+    if (!chain || !buf) return;
+    buf->next = NULL;
+    if (chain->tail) chain->tail->next = buf;
+    else chain->head = buf;
+    chain->tail = buf;
+    chain->length += buf->end - buf->start;
+  }
+
+  void x_net_chain_move(XNetChain* dst, XNetChain* src)
+  {
+    if (!dst || !src || !src->head) return;
+    if (dst->tail) dst->tail->next = src->head;
+    else dst->head = src->head;
+    dst->tail = src->tail;
+    dst->length += src->length;
+    memset(src, 0, sizeof(*src));
+  }
+
+  void x_net_chain_consume(XNetChain* chain, size_t len)
+  {
+    if (!chain) return;
+    while (chain->head && len > 0)
+    {
+      XNetBuffer* buf = chain->head;
+      size_t avail = buf->end - buf->start;
+      size_t n = len < avail ? len : avail;
+      buf->start += (uint32_t)n;
+      chain->length -= n;
+      len -= n;
+      // A buffer with room left keeps receiving; only drained full ones go back
+      if (buf->start < buf->end || (buf == chain->tail && buf->end < buf->capacity)) break;
+      chain->head = buf->next;
+      if (!chain->head) chain->tail = NULL;
+      x_net_buffer_release(buf);
+    }
+    if (chain->head == chain->tail && chain->head && chain->length == 0)
+    {
+      // Nothing left in flight: hand the last buffer back too
+      x_net_buffer_release(chain->head);
+      chain->head = NULL;
+      chain->tail = NULL;
+    }
+  }
+
+  void x_net_chain_release(XNetChain* chain)
+  {
+    if (!chain) return;
+    XNetBuffer* buf = chain->head;
+    while (buf)
+    {
+      XNetBuffer* next = buf->next;
+      x_net_buffer_release(buf);
+      buf = next;
+    }
+    memset(chain, 0, sizeof(*chain));
+  }
+
+  size_t x_net_chain_gather(const XNetChain* chain, XSlice* out, size_t max)
+  {
+    size_t n = 0;
+    if (!chain || !out) return 0;
+    for (const XNetBuffer* buf = chain->head; buf && n < max; buf = buf->next)
+    {
+      if (buf->end > buf->start)
+        out[n++] = x_slice_init(buf->data + buf->start, buf->end - buf->start);
+    }
+    return n;
+  }
+
+  size_t x_net_chain_copy(const XNetChain* chain, void* dst, size_t len)
+  {
+    size_t copied = 0;
+    if (!chain || !dst) return 0;
+    for (const XNetBuffer* buf = chain->head; buf && copied < len; buf = buf->next)
+    {
+      size_t n = buf->end - buf->start;
+      if (n > len - copied) n = len - copied;
+      memcpy((char*)dst + copied, buf->data + buf->start, n);
+      copied += n;
+    }
+    return copied;
+  }
+
+  size_t x_net_recv_chain(XSocket sock, XNetBufferPool* pool, XNetChain* chain)
+  {
+    size_t total = 0;
+    if (!pool || !chain) return (size_t)-1;
+
+    for (;;)
+    {
+      XNetBuffer* buf = chain->tail;
+      bool fresh = !buf || buf->end == buf->capacity;
+      if (fresh)
+      {
+        buf = x_net_buffer_acquire(pool);
+        if (!buf)
+        {
+          if (total > 0) return total;
+#if defined(_WIN32)
+          WSASetLastError(WSAENOBUFS);
+#else
+          errno = ENOBUFS;
+#endif
+          return (size_t)-1;
+        }
+      }
+
+      size_t room = buf->capacity - buf->end;
+      size_t r = x_net_recv(sock, buf->data + buf->end, room);
+      if (r == 0 || r == (size_t)-1)
+      {
+        if (fresh) x_net_buffer_release(buf);   // idle connections hold no buffers
+        return total > 0 ? total : r;
+      }
+
+      buf->end += (uint32_t)r;
+      if (fresh) x_net_chain_append(chain, buf);
+      else chain->length += r;
+      total += r;
+      if (r < room) return total;
+    }
+  }
+
+  size_t x_net_send_chain(XSocket sock, XNetChain* chain)
+  {
+    size_t total = 0;
+    XSlice parts[X_NET_SENDV_BATCH];
+    if (!chain) return 0;
+
+    while (chain->length > 0)
+    {
+      size_t count = x_net_chain_gather(chain, parts, X_NET_SENDV_BATCH);
+      size_t want = 0;
+      for (size_t i = 0; i < count; i++) want += parts[i].length;
+
+      size_t sent = x_net_sendv(sock, parts, count);
+      if (sent == (size_t)-1) break;
+      x_net_chain_consume(chain, sent);
+      total += sent;
+      if (sent < want) break;
+    }
+    return total;
+  }
+
   void x_net_address_clear(XAddress* addr)
   {
     if (!addr) return;
@@ -784,10 +2504,10 @@ extern "C" {
     hints.ai_family = AF_UNSPEC; // IPv4 or IPv6
     hints.ai_socktype = SOCK_STREAM;
 
-    int8_t port_str[16];
+    char port_str[16];
     snprintf(port_str, sizeof(port_str), "%u", port);
 
-    int32_t err = getaddrinfo(ip, port_str, &hints, &res);
+    int32_t err = getaddrinfo((const char*)ip, port_str, &hints, &res);
     if (err != 0 || !res)
     {
       return -1;
@@ -825,7 +2545,7 @@ extern "C" {
   int32_t x_net_address_to_string(const XAddress* addr, char* buf, int32_t buf_len)
   {
     if (!addr || !buf || buf_len <= 0) return -1;
-    int8_t ipstr[INET6_ADDRSTRLEN];
+    char ipstr[INET6_ADDRSTRLEN];
     uint16_t port = 0;
 
     if (addr->family == AF_INET)
@@ -854,7 +2574,7 @@ extern "C" {
       (family == X_NET_AF_IPV6) ? AF_INET6 : AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
 
-    int32_t err = getaddrinfo(host, port, &hints, &res);
+    int32_t err = getaddrinfo((const char*)host, (const char*)port, &hints, &res);
     if (err != 0 || !res) return false;
 
     memcpy(&out_addr->addr, res->ai_addr, res->ai_addrlen);
@@ -869,7 +2589,7 @@ extern "C" {
   {
     if (!ip || !out_addr) return -1;
     int32_t af = (family == X_NET_AF_IPV4) ? AF_INET : AF_INET6;
-    return inet_pton(af, ip, out_addr) == 1 ? 0 : -1;
+    return inet_pton(af, (const char*)ip, out_addr) == 1 ? 0 : -1;
   }
 
   int32_t x_net_format_address(const XAddress* addr, char* out_str, int32_t maxlen)
@@ -879,13 +2599,13 @@ extern "C" {
 
   int32_t x_net_dns_resolve(const int8_t* hostname, XAddressFamily family, XAddress* out_addr)
   {
-    return x_net_resolve(hostname, "0", family, out_addr);
+    return x_net_resolve(hostname, (const int8_t*)"0", family, out_addr);
   }
 
   bool x_net_join_multicast_ipv4(XSocket sock, const int8_t* group)
   {
     struct ip_mreq mreq;
-    if (inet_pton(AF_INET, group, &mreq.imr_multiaddr) != 1) return -1;
+    if (inet_pton(AF_INET, (const char*)group, &mreq.imr_multiaddr) != 1) return -1;
     mreq.imr_interface.s_addr = INADDR_ANY;
     return setsockopt(sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, (const int8_t*)&mreq, sizeof(mreq)) == 0;
   }
@@ -893,7 +2613,7 @@ extern "C" {
   bool x_net_leave_multicast_ipv4(XSocket sock, const int8_t* group)
   {
     struct ip_mreq mreq;
-    if (inet_pton(AF_INET, group, &mreq.imr_multiaddr) != 1) return -1;
+    if (inet_pton(AF_INET, (const char*)group, &mreq.imr_multiaddr) != 1) return -1;
     mreq.imr_interface.s_addr = INADDR_ANY;
     return setsockopt(sock, IPPROTO_IP, IP_DROP_MEMBERSHIP, (const int8_t*)&mreq, sizeof(mreq)) == 0;
   }
@@ -901,7 +2621,7 @@ extern "C" {
   bool x_net_join_multicast_ipv6(XSocket sock, const int8_t* multicast_ip, uint32_t ifindex)
   {
     struct ipv6_mreq mreq;
-    if (inet_pton(AF_INET6, multicast_ip, &mreq.ipv6mr_multiaddr) != 1) return -1;
+    if (inet_pton(AF_INET6, (const char*)multicast_ip, &mreq.ipv6mr_multiaddr) != 1) return -1;
     mreq.ipv6mr_interface = ifindex;
     return setsockopt(sock, IPPROTO_IPV6, IPV6_JOIN_GROUP, (const int8_t*)&mreq, sizeof(mreq)) == 0;
   }
@@ -909,7 +2629,7 @@ extern "C" {
   bool x_net_leave_multicast_ipv6(XSocket sock, const int8_t* multicast_ip, uint32_t ifindex)
   {
     struct ipv6_mreq mreq;
-    if (inet_pton(AF_INET6, multicast_ip, &mreq.ipv6mr_multiaddr) != 1) return -1;
+    if (inet_pton(AF_INET6, (const char*)multicast_ip, &mreq.ipv6mr_multiaddr) != 1) return -1;
     mreq.ipv6mr_interface = ifindex;
     return setsockopt(sock, IPPROTO_IPV6, IPV6_LEAVE_GROUP, (const int8_t*)&mreq, sizeof(mreq)) == 0;
   }
@@ -1088,7 +2808,7 @@ extern "C" {
 
     int32_t count = 0;
     struct ifaddrs* ifa = ifaddr;
-    int8_t last_name[IFNAMSIZ] =
+    char last_name[IFNAMSIZ] =
     {0};
     while (ifa)
     {
@@ -1100,7 +2820,7 @@ extern "C" {
       ifa = ifa->ifa_next;
     }
 
-    X_NET_FREEifaddrs(ifaddr);
+    freeifaddrs(ifaddr);
     return count;
   }
 
@@ -1110,7 +2830,7 @@ extern "C" {
     if (getifaddrs(&ifaddr) == -1) return -1;
 
     int32_t count = 0;
-    int8_t last_name[IFNAMSIZ] =
+    char last_name[IFNAMSIZ] =
     {0};
 
     struct ifaddrs* ifa = ifaddr;
@@ -1119,14 +2839,14 @@ extern "C" {
       if (ifa->ifa_name && strcmp(last_name, ifa->ifa_name) != 0)
       {
         strncpy(last_name, ifa->ifa_name, IFNAMSIZ - 1);
-        strncpy(out_adapters[count].name, ifa->ifa_name, sizeof(out_adapters[count].name) - 1);
+        strncpy((char*)out_adapters[count].name, ifa->ifa_name, sizeof(out_adapters[count].name) - 1);
         out_adapters[count].name[sizeof(out_adapters[count].name) - 1] = '\0';
         count++;
       }
       ifa = ifa->ifa_next;
     }
 
-    X_NET_FREEifaddrs(ifaddr);
+    freeifaddrs(ifaddr);
     return count;
   }
 
@@ -1138,55 +2858,54 @@ extern "C" {
     if (getifaddrs(&ifaddr) == -1) return -1;
 
     memset(out_info, 0, sizeof(*out_info));
-    strncpy(out_info->name, name, sizeof(out_info->name) - 1);
+    strncpy((char*)out_info->name, (const char*)name, sizeof(out_info->name) - 1);
 
     // MAC address retrieval via SIOCGIFHWADDR (socket ioctl)
     int32_t sock = socket(AF_INET, SOCK_DGRAM, 0);
     if (sock < 0)
     {
-      X_NET_FREEifaddrs(ifaddr);
+      freeifaddrs(ifaddr);
       return -1;
     }
 
     struct ifreq ifr;
     memset(&ifr, 0, sizeof(ifr));
-    strncpy(ifr.ifr_name, name, IFNAMSIZ - 1);
+    strncpy(ifr.ifr_name, (const char*)name, IFNAMSIZ - 1);
     if (ioctl(sock, SIOCGIFHWADDR, &ifr) == 0)
     {
       uint8_t* mac = (uint8_t*)ifr.ifr_hwaddr.sa_data;
-      snprintf(out_info->mac, sizeof(out_info->mac), "%02X:%02X:%02X:%02X:%02X:%02X",
+      snprintf((char*)out_info->mac, sizeof(out_info->mac), "%02X:%02X:%02X:%02X:%02X:%02X",
           mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
     } else
     {
       out_info->mac[0] = '\0';
     }
+    if (ioctl(sock, SIOCGIFMTU, &ifr) == 0)
+      out_info->mtu = ifr.ifr_mtu;
     close(sock);
 
     // IP addresses
     struct ifaddrs* ifa = ifaddr;
     while (ifa)
     {
-      if (ifa->ifa_name && strcmp(ifa->ifa_name, name) == 0 && ifa->ifa_addr)
+      if (ifa->ifa_name && strcmp(ifa->ifa_name, (const char*)name) == 0 && ifa->ifa_addr)
       {
         int32_t family = ifa->ifa_addr->sa_family;
-        int8_t buf[INET6_ADDRSTRLEN] =
+        char buf[INET6_ADDRSTRLEN] =
         {0};
-        out_info->ifindex = ifa->IfIndex;
-        out_info->is_wireless = (ifa->IfType == IF_TYPE_IEEE80211) ? 1 : 0;
-        out_info->mtu = (int) ifa->Mtu;
-        out_info->speed_bps = ifa->TransmitLinkSpeed;
+        out_info->ifindex = if_nametoindex((const char*)name);
 
         if (family == AF_INET)
         {
           struct sockaddr_in* sa = (struct sockaddr_in*)ifa->ifa_addr;
           inet_ntop(AF_INET, &(sa->sin_addr), buf, sizeof(buf));
-          strncpy(out_info->ipv4, buf, sizeof(out_info->ipv4) - 1);
+          strncpy((char*)out_info->ipv4, buf, sizeof(out_info->ipv4) - 1);
           out_info->ipv4[sizeof(out_info->ipv4) - 1] = '\0';
         } else if (family == AF_INET6)
         {
           struct sockaddr_in6* sa6 = (struct sockaddr_in6*)ifa->ifa_addr;
           inet_ntop(AF_INET6, &(sa6->sin6_addr), buf, sizeof(buf));
-          strncpy(out_info->ipv6, buf, sizeof(out_info->ipv6) - 1);
+          strncpy((char*)out_info->ipv6, buf, sizeof(out_info->ipv6) - 1);
           out_info->ipv6[sizeof(out_info->ipv6) - 1] = '\0';
         }
       }
@@ -1261,7 +2980,7 @@ extern "C" {
 
 #else
     int32_t err = errno;
-    const int8_t* msg = strerror(err);
+    const char* msg = strerror(err);
     if (!msg)
     {
       snprintf(buf, buf_len, "Unknown error %d", err);
@@ -0,0 +1,778 @@
+/**
+ * STDX - Profiling zones
+ * Part of the STDX General Purpose C Library by marciovmf
+ * License: MIT
+ * <https://github.com/marciovmf/stdx>
+ *
+ * ## Overview
+ *
+ * Lightweight instrumentation for finding hot spots in real builds. A zone
+ * is a named, nestable region of code; entering and leaving it reads a raw
+ * tick counter and touches only the calling thread's buffers.
+ *
+ *     x_profile_init(X_PROFILE_DEFAULT_EVENTS);
+ *
+ *     void update(void)
+ *     {
+ *       X_PROFILE_BEGIN("update");
+ *       ...
+ *       X_PROFILE_END();
+ *     }
+ *
+ *     x_profile_report(stdout);
+ *     x_profile_write_chrome_trace("trace.json");
+ *     x_profile_shutdown();
+ *
+ * On GCC and Clang `X_PROFILE_ZONE("name")` declares a zone that ends with
+ * the enclosing block, however the block is left. Every zone must be
+ * closed on the thread that opened it, innermost first.
+ *
+ * Zones record nothing until x_profile_init() and after
+ * x_profile_shutdown(), and compile to nothing when `X_PROFILE_DISABLE` is
+ * defined.
+ *
+ * ## Statistics and traces
+ *
+ * Each thread aggregates, per zone, the call count, total and self time
+ * (total minus the time spent in nested zones), minimum, maximum and a
+ * logarithmic histogram (eight buckets per power of two) from which the
+ * 99th percentile is estimated to within 12.5%. x_profile_stats() merges
+ * the threads; x_profile_report() prints the merged table sorted by total
+ * time.
+ *
+ * Each thread also keeps its last `events_per_thread` zone instances in a
+ * ring. x_profile_write_chrome_trace() writes them as Chrome trace JSON,
+ * which chrome://tracing, Perfetto (ui.perfetto.dev) and Tracy's
+ * `import-chrome` tool open. Pass 0 to keep statistics only.
+ *
+ * Statistics and traces read other threads' buffers without stopping
+ * them; numbers taken while zones are running may be off by the zones in
+ * flight. x_profile_reset() and x_profile_shutdown() must only be called
+ * while no other thread is inside a zone.
+ *
+ * ## Clock
+ *
+ * Zones are timed with stdx_time's x_ticks_now(): the invariant time stamp
+ * counter on x86, the virtual counter on ARM64 and the monotonic OS clock
+ * elsewhere.
+ *
+ * ## Instrumenting the library
+ *
+ * Defining `X_PROFILE_LIBRARY` where the implementations of stdx_thread,
+ * stdx_ini and stdx_tml are compiled adds zones around thread pool tasks
+ * and parallel_for ranges (`x_threadpool task`, `x_parallel_for range`),
+ * `x_ini_load_mem` and `x_tml_load`. The profiler implementation must then
+ * be requested before those headers are included.
+ *
+ * ## How to compile
+ *
+ * To compile the implementation define `X_IMPL_PROFILE`
+ * in **one** source file before including this header.
+ *
+ * To customize how this module allocates memory, define
+ * `X_PROFILE_ALLOC` / `X_PROFILE_FREE` before including.
+ *
+ * ## Dependencies
+ *
+ *  stdx_thread.h (atomics, mutex, thread-local storage, implementation required)
+ *  stdx_time.h (tick counter, implementation required)
+ *
+ */
+
+#ifndef X_PROFILE_H
+#define X_PROFILE_H
+
+#define X_PROFILE_VERSION_MAJOR 1
+#define X_PROFILE_VERSION_MINOR 0
+#define X_PROFILE_VERSION_PATCH 0
+#define X_PROFILE_VERSION (X_PROFILE_VERSION_MAJOR * 10000 + X_PROFILE_VERSION_MINOR * 100 + X_PROFILE_VERSION_PATCH)
+
+#include "stdx_thread.h"
+#include "stdx_time.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#ifndef X_PROFILE_API
+#define X_PROFILE_API
+#endif
+
+#ifndef X_PROFILE_MAX_ZONES
+/**
+ * Most distinct zones a program can register. Zones past it are ignored.
+ * Can be overriden before including this header
+ */
+#define X_PROFILE_MAX_ZONES 512
+#endif  // X_PROFILE_MAX_ZONES
+
+#ifndef X_PROFILE_MAX_DEPTH
+/**
+ * Deepest zone nesting recorded per thread. Deeper zones are ignored.
+ * Can be overriden before including this header
+ */
+#define X_PROFILE_MAX_DEPTH 64
+#endif  // X_PROFILE_MAX_DEPTH
+
+#ifndef X_PROFILE_DEFAULT_EVENTS
+/**
+ * Suggested per-thread trace ring size for x_profile_init().
+ * Can be overriden before including this header
+ */
+#define X_PROFILE_DEFAULT_EVENTS (64 * 1024)
+#endif  // X_PROFILE_DEFAULT_EVENTS
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  /**
+   * @brief Static descriptor of one zone call site.
+   *
+   * The zone macros declare one per site; `id` is assigned the first time
+   * the zone is entered.
+   */
+  typedef struct XProfileZone
+  {
+    const char* name;
+    const char* file;
+    int32_t line;
+    volatile int32_t id;
+  } XProfileZone;
+
+  /**
+   * @brief Merged statistics of one zone, in nanoseconds.
+   */
+  typedef struct XProfileStats
+  {
+    const char* name;
+    const char* file;
+    int32_t line;
+    uint64_t count;
+    uint64_t total_ns;
+    uint64_t self_ns;
+    uint64_t min_ns;
+    uint64_t max_ns;
+    uint64_t mean_ns;
+    uint64_t p99_ns;
+  } XProfileStats;
+
+  /**
+   * @brief Start recording zones.
+   *
+   * Calibrates the tick counter (up to 10 ms, once per process) and
+   * enables the zones of every thread. Calling it again while running only resets the data.
+   * @param events_per_thread Size of each thread's trace ring, rounded up to
+   * a power of two, or 0 to keep statistics only.
+   * @return true on success, false if out of memory.
+   */
+  X_PROFILE_API bool x_profile_init(size_t events_per_thread);
+
+  /**
+   * @brief Stop recording and free every thread's buffers.
+   */
+  X_PROFILE_API void x_profile_shutdown(void);
+
+  /**
+   * @brief Discard the statistics and trace events recorded so far.
+   */
+  X_PROFILE_API void x_profile_reset(void);
+
+  /**
+   * @brief Name the calling thread in traces and reports.
+   * @param name Thread name; copied, truncated to 31 bytes.
+   */
+  X_PROFILE_API void x_profile_set_thread_name(const char* name);
+
+  /**
+   * @brief Enter a zone. Use the X_PROFILE_BEGIN() macro instead.
+   * @param zone Static descriptor of the call site.
+   */
+  X_PROFILE_API void x_profile_begin(XProfileZone* zone);
+
+  /**
+   * @brief Leave the innermost zone of the calling thread.
+   */
+  X_PROFILE_API void x_profile_end(void);
+
+  /**
+   * @brief Merge the statistics of all threads.
+   * @param out Destination array, in zone registration order.
+   * @param max Capacity of out.
+   * @return Number of entered zones written to out.
+   */
+  X_PROFILE_API size_t x_profile_stats(XProfileStats* out, size_t max);
+
+  /**
+   * @brief Print the merged statistics as a table sorted by total time.
+   * @param out Destination stream.
+   */
+  X_PROFILE_API void x_profile_report(FILE* out);
+
+  /**
+   * @brief Write the recorded zone instances as Chrome trace JSON.
+   * @param path Output file path.
+   * @return true on success, false if the file can't be written.
+   */
+  X_PROFILE_API bool x_profile_write_chrome_trace(const char* path);
+
+  /**
+   * @brief Get the rate of the ticks zones are timed with.
+   * @return Ticks per second, or 0 before x_profile_init().
+   */
+  X_PROFILE_API double x_profile_ticks_per_second(void);
+
+  /* Dummy type for the cleanup attribute of X_PROFILE_ZONE() */
+  typedef int32_t XProfileScope;
+
+  static inline XProfileScope x_profile_scope_begin(XProfileZone* zone)
+  {
+    x_profile_begin(zone);
+    return 0;
+  }
+
+  static inline void x_profile_scope_end(XProfileScope* scope)
+  {
+    (void)scope;
+    x_profile_end();
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define X_PROFILE_CONCAT_(a, b) a##b
+#define X_PROFILE_CONCAT(a, b) X_PROFILE_CONCAT_(a, b)
+
+#ifdef X_PROFILE_DISABLE
+#define X_PROFILE_BEGIN(name) ((void)0)
+#define X_PROFILE_END() ((void)0)
+#define X_PROFILE_ZONE(name) ((void)0)
+#else
+/**
+ * Enter the zone `name` (a string literal). Must be matched by X_PROFILE_END().
+ */
+#define X_PROFILE_BEGIN(name) \
+  do { \
+    static XProfileZone x_profile_zone_ = { (name), __FILE__, __LINE__, 0 }; \
+    x_profile_begin(&x_profile_zone_); \
+  } while (0)
+
+/**
+ * Leave the zone entered by the innermost X_PROFILE_BEGIN().
+ */
+#define X_PROFILE_END() x_profile_end()
+
+#if defined(__GNUC__) || defined(__clang__)
+/**
+ * Declare a zone that lasts until the end of the enclosing block.
+ */
+#define X_PROFILE_ZONE(name) \
+  static XProfileZone X_PROFILE_CONCAT(x_profile_zone_, __LINE__) = { (name), __FILE__, __LINE__, 0 }; \
+  XProfileScope X_PROFILE_CONCAT(x_profile_scope_, __LINE__) __attribute__((cleanup(x_profile_scope_end), unused)) = \
+    x_profile_scope_begin(&X_PROFILE_CONCAT(x_profile_zone_, __LINE__))
+#endif
+#endif  // X_PROFILE_DISABLE
+
+#ifdef X_IMPL_PROFILE
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef X_PROFILE_ALLOC
+/**
+ * @brief Internal macro for allocating memory.
+ * To override how this header allocates memory, define this macro with a
+ * different implementation before including this header.
+ * @param sz  The size of memory to alloc.
+ */
+#define X_PROFILE_ALLOC(sz)        malloc(sz)
+#endif
+
+#ifndef X_PROFILE_FREE
+/**
+ * @brief Internal macro for freeing memory.
+ * To override how this header frees memory, define this macro with a
+ * different implementation before including this header.
+ * @param p  The address of memory region to free.
+ */
+#define X_PROFILE_FREE(p)          free(p)
+#endif
+
+/* Eight histogram buckets per power of two: exact below 8 ticks, then
+   (exponent, top three mantissa bits). 62 octaves cover 64-bit durations. */
+#define X_PROFILE_HIST_SUB 8
+#define X_PROFILE_HIST_BUCKETS (62 * X_PROFILE_HIST_SUB)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  typedef struct XProfileZoneData
+  {
+    uint64_t count;
+    uint64_t total;
+    uint64_t self;
+    uint64_t min;
+    uint64_t max;
+    uint32_t hist[X_PROFILE_HIST_BUCKETS];
+  } XProfileZoneData;
+
+  typedef struct XProfileFrame
+  {
+    uint64_t start;
+    uint64_t child;
+    int32_t zone;
+  } XProfileFrame;
+
+  typedef struct XProfileEvent
+  {
+    uint64_t start;
+    uint64_t end;
+    int32_t zone;
+    int32_t depth;
+  } XProfileEvent;
+
+  typedef struct XProfileThread
+  {
+    struct XProfileThread* next;
+    int32_t index;
+    int32_t depth;
+    char name[32];
+    XProfileEvent* events;
+    uint64_t event_mask;
+    volatile int64_t event_count;
+    XProfileFrame stack[X_PROFILE_MAX_DEPTH];
+    XProfileZoneData* volatile zones[X_PROFILE_MAX_ZONES];
+  } XProfileThread;
+
+  typedef struct XProfileState
+  {
+    volatile int32_t generation;      // 0 while stopped
+    int32_t generations;
+    XMutex* lock;
+    XProfileThread* volatile threads;
+    int32_t thread_count;
+    size_t events_per_thread;
+    uint64_t base_ticks;              // trace time zero
+    XProfileZone* zones[X_PROFILE_MAX_ZONES];
+    volatile int32_t zone_count;      // ids start at 1
+  } XProfileState;
+
+  static XProfileState s_x_profile;
+  static X_THREAD_LOCAL XProfileThread* s_x_profile_thread = NULL;
+  static X_THREAD_LOCAL int32_t s_x_profile_thread_generation = 0;
+
+  static uint32_t s_x_profile_bucket(uint64_t ticks)
+  {
+    if (ticks < X_PROFILE_HIST_SUB)
+      return (uint32_t)ticks;
+    uint32_t e = 63;
+    while (!(ticks >> e)) e--;
+    return (e - 2) * X_PROFILE_HIST_SUB + (uint32_t)((ticks >> (e - 3)) & (X_PROFILE_HIST_SUB - 1));
+  }
+
+  /* Largest duration that falls in `bucket` */
+  static uint64_t s_x_profile_bucket_upper(uint32_t bucket)
+  {
+    if (bucket < X_PROFILE_HIST_SUB)
+      return bucket;
+    uint32_t e = bucket / X_PROFILE_HIST_SUB + 2;
+    uint64_t sub = bucket % X_PROFILE_HIST_SUB;
+    return ((X_PROFILE_HIST_SUB + sub + 1) << (e - 3)) - 1;
+  }
+
+  static void s_x_profile_free_threads(void)
+  {
+    XProfileThread* t = s_x_profile.threads;
+    while (t)
+    {
+      XProfileThread* next = t->next;
+      for (int32_t i = 0; i < X_PROFILE_MAX_ZONES; i++)
+        X_PROFILE_FREE(t->zones[i]);
+      X_PROFILE_FREE(t->events);
+      X_PROFILE_FREE(t);
+      t = next;
+    }
+    s_x_profile.threads = NULL;
+    s_x_profile.thread_count = 0;
+  }
+
+  static XProfileThread* s_x_profile_thread_register(int32_t generation)
+  {
+    XProfileThread* t = (XProfileThread*)X_PROFILE_ALLOC(sizeof(XProfileThread));
+    if (!t) return NULL;
+    memset(t, 0, sizeof(*t));
+
+    size_t events = s_x_profile.events_per_thread;
+    if (events)
+    {
+      t->events = (XProfileEvent*)X_PROFILE_ALLOC(events * sizeof(XProfileEvent));
+      if (!t->events)
+      {
+        X_PROFILE_FREE(t);
+        return NULL;
+      }
+      t->event_mask = (uint64_t)events - 1;
+    }
+
+    x_thread_mutex_lock(s_x_profile.lock);
+    if (x_atomic_load_i32(&s_x_profile.generation) != generation)
+    {
+      // Stopped while this thread was registering
+      x_thread_mutex_unlock(s_x_profile.lock);
+      X_PROFILE_FREE(t->events);
+      X_PROFILE_FREE(t);
+      return NULL;
+    }
+    t->index = ++s_x_profile.thread_count;
+    snprintf(t->name, sizeof(t->name), "thread %d", t->index);
+    t->next = s_x_profile.threads;
+    x_atomic_store_ptr((void* volatile*)&s_x_profile.threads, t);
+    x_thread_mutex_unlock(s_x_profile.lock);
+
+    s_x_profile_thread = t;
+    s_x_profile_thread_generation = generation;
+    return t;
+  }
+
+  static inline XProfileThread* s_x_profile_thread_get(void)
+  {
+    int32_t generation = x_atomic_load_i32(&s_x_profile.generation);
+    if (generation == 0)
+      return NULL;
+    if (s_x_profile_thread && s_x_profile_thread_generation == generation)
+      return s_x_profile_thread;
+    return s_x_profile_thread_register(generation);
+  }
+
+  static int32_t s_x_profile_zone_register(XProfileZone* zone)
+  {
+    x_thread_mutex_lock(s_x_profile.lock);
+    int32_t id = x_atomic_load_i32(&zone->id);
+    if (id == 0)
+    {
+      int32_t count = x_atomic_load_i32(&s_x_profile.zone_count);
+      if (count + 1 < X_PROFILE_MAX_ZONES)
+      {
+        id = count + 1;
+        s_x_profile.zones[id] = zone;
+        x_atomic_store_i32(&s_x_profile.zone_count, id);
+      }
+      else
+      {
+        id = -1;
+      }
+      x_atomic_store_i32(&zone->id, id);
+    }
+    x_thread_mutex_unlock(s_x_profile.lock);
+    return id;
+  }
+
+  static XProfileZoneData* s_x_profile_zone_data(XProfileThread* t, int32_t id)
+  {
+    XProfileZoneData* z = t->zones[id];
+    if (z) return z;
+    z = (XProfileZoneData*)X_PROFILE_ALLOC(sizeof(XProfileZoneData));
+    if (!z) return NULL;
+    memset(z, 0, sizeof(*z));
+    z->min = UINT64_MAX;
+    x_atomic_store_ptr((void* volatile*)&t->zones[id], z);
+    return z;
+  }
+
+  X_PROFILE_API void x_profile_begin(XProfileZone* zone)
+  {
+    XProfileThread* t = s_x_profile_thread_get();
+    if (!t) return;
+
+    int32_t depth = t->depth++;
+    if (depth >= X_PROFILE_MAX_DEPTH) return;
+
+    int32_t id = x_atomic_load_i32(&zone->id);
+    if (id == 0)
+      id = s_x_profile_zone_register(zone);
+
+    XProfileFrame* frame = &t->stack[depth];
+    frame->zone = id;
+    frame->child = 0;
+    frame->start = x_ticks_now();
+  }
+
+  X_PROFILE_API void x_profile_end(void)
+  {
+    uint64_t end = x_ticks_now();
+    XProfileThread* t = s_x_profile_thread;
+    if (!t || s_x_profile_thread_generation != x_atomic_load_i32(&s_x_profile.generation) || t->depth == 0)
+      return;
+
+    int32_t depth = --t->depth;
+    if (depth >= X_PROFILE_MAX_DEPTH) return;
+
+    XProfileFrame* frame = &t->stack[depth];
+    uint64_t duration = end - frame->start;
+    if (depth > 0)
+      t->stack[depth - 1].child += duration;
+    if (frame->zone < 0) return;
+
+    XProfileZoneData* z = s_x_profile_zone_data(t, frame->zone);
+    if (z)
+    {
+      z->count++;
+      z->total += duration;
+      z->self += duration - frame->child;
+      if (duration < z->min) z->min = duration;
+      if (duration > z->max) z->max = duration;
+      z->hist[s_x_profile_bucket(duration)]++;
+    }
+
+    if (t->events)
+    {
+      int64_t n = t->event_count;
+      XProfileEvent* e = &t->events[(uint64_t)n & t->event_mask];
+      e->start = frame->start;
+      e->end = end;
+      e->zone = frame->zone;
+      e->depth = depth;
+      x_atomic_store_release_i64(&t->event_count, n + 1);
+    }
+  }
+
+  X_PROFILE_API bool x_profile_init(size_t events_per_thread)
+  {
+    if (x_atomic_load_i32(&s_x_profile.generation) != 0)
+    {
+      x_profile_reset();
+      return true;
+    }
+
+    if (!s_x_profile.lock && x_thread_mutex_init(&s_x_profile.lock) != 0)
+      return false;
+
+    size_t events = 0;
+    if (events_per_thread)
+    {
+      events = 1;
+      while (events < events_per_thread) events <<= 1;
+    }
+    s_x_profile.events_per_thread = events;
+
+    x_ticks_frequency();
+    s_x_profile.base_ticks = x_ticks_now();
+
+    s_x_profile.generations++;
+    x_atomic_store_i32(&s_x_profile.generation, s_x_profile.generations);
+    return true;
+  }
+
+  X_PROFILE_API void x_profile_shutdown(void)
+  {
+    if (x_atomic_load_i32(&s_x_profile.generation) == 0)
+      return;
+    x_thread_mutex_lock(s_x_profile.lock);
+    x_atomic_store_i32(&s_x_profile.generation, 0);
+    s_x_profile_free_threads();
+    x_thread_mutex_unlock(s_x_profile.lock);
+  }
+
+  X_PROFILE_API void x_profile_reset(void)
+  {
+    if (!s_x_profile.lock) return;
+    x_thread_mutex_lock(s_x_profile.lock);
+    for (XProfileThread* t = s_x_profile.threads; t; t = t->next)
+    {
+      for (int32_t i = 0; i < X_PROFILE_MAX_ZONES; i++)
+      {
+        XProfileZoneData* z = t->zones[i];
+        if (!z) continue;
+        memset(z, 0, sizeof(*z));
+        z->min = UINT64_MAX;
+      }
+      x_atomic_store_release_i64(&t->event_count, 0);
+    }
+    x_thread_mutex_unlock(s_x_profile.lock);
+  }
+
+  X_PROFILE_API void x_profile_set_thread_name(const char* name)
+  {
+    XProfileThread* t = s_x_profile_thread_get();
+    if (!t || !name) return;
+    x_thread_mutex_lock(s_x_profile.lock);
+    snprintf(t->name, sizeof(t->name), "%s", name);
+    x_thread_mutex_unlock(s_x_profile.lock);
+  }
+
+  X_PROFILE_API double x_profile_ticks_per_second(void)
+  {
+    if (x_atomic_load_i32(&s_x_profile.generation) == 0)
+      return 0.0;
+    return (double)x_ticks_frequency();
+  }
+
+  /* Merges zone `id` over all threads. Called with the lock held. */
+  static bool s_x_profile_merge(int32_t id, XProfileStats* out)
+  {
+    static uint64_t hist[X_PROFILE_HIST_BUCKETS];
+    uint64_t count = 0, total = 0, self = 0, min = UINT64_MAX, max = 0;
+    memset(hist, 0, sizeof(hist));
+
+    for (XProfileThread* t = s_x_profile.threads; t; t = t->next)
+    {
+      XProfileZoneData* z = (XProfileZoneData*)x_atomic_load_ptr((void* volatile*)&t->zones[id]);
+      if (!z || z->count == 0) continue;
+      count += z->count;
+      total += z->total;
+      self += z->self;
+      if (z->min < min) min = z->min;
+      if (z->max > max) max = z->max;
+      for (uint32_t b = 0; b < X_PROFILE_HIST_BUCKETS; b++)
+        hist[b] += z->hist[b];
+    }
+    if (count == 0) return false;
+
+    uint64_t rank = count - count / 100;  // the 99th percentile sample, 1-based
+    uint64_t seen = 0;
+    uint64_t p99 = max;
+    for (uint32_t b = 0; b < X_PROFILE_HIST_BUCKETS; b++)
+    {
+      seen += hist[b];
+      if (seen >= rank)
+      {
+        p99 = s_x_profile_bucket_upper(b);
+        if (p99 > max) p99 = max;
+        if (p99 < min) p99 = min;
+        break;
+      }
+    }
+
+    XProfileZone* zone = s_x_profile.zones[id];
+    out->name = zone->name;
+    out->file = zone->file;
+    out->line = zone->line;
+    out->count = count;
+    out->total_ns = x_ticks_to_ns(total);
+    out->self_ns = x_ticks_to_ns(self);
+    out->min_ns = x_ticks_to_ns(min);
+    out->max_ns = x_ticks_to_ns(max);
+    out->mean_ns = x_ticks_to_ns(total / count);
+    out->p99_ns = x_ticks_to_ns(p99);
+    return true;
+  }
+
+  X_PROFILE_API size_t x_profile_stats(XProfileStats* out, size_t max)
+  {
+    if (!out || x_atomic_load_i32(&s_x_profile.generation) == 0)
+      return 0;
+
+    size_t n = 0;
+    x_thread_mutex_lock(s_x_profile.lock);
+    int32_t zones = x_atomic_load_i32(&s_x_profile.zone_count);
+    for (int32_t id = 1; id <= zones && n < max; id++)
+    {
+      if (s_x_profile_merge(id, &out[n]))
+        n++;
+    }
+    x_thread_mutex_unlock(s_x_profile.lock);
+    return n;
+  }
+
+  static int s_x_profile_cmp_total(const void* a, const void* b)
+  {
+    const XProfileStats* x = (const XProfileStats*)a;
+    const XProfileStats* y = (const XProfileStats*)b;
+    return (x->total_ns < y->total_ns) - (x->total_ns > y->total_ns);
+  }
+
+  X_PROFILE_API void x_profile_report(FILE* out)
+  {
+    XProfileStats* stats = (XProfileStats*)X_PROFILE_ALLOC(sizeof(XProfileStats) * X_PROFILE_MAX_ZONES);
+    if (!stats || !out)
+    {
+      X_PROFILE_FREE(stats);
+      return;
+    }
+
+    size_t n = x_profile_stats(stats, X_PROFILE_MAX_ZONES);
+    qsort(stats, n, sizeof(XProfileStats), s_x_profile_cmp_total);
+
+    fprintf(out, "%-32s %10s %12s %12s %10s %10s %10s\n",
+        "zone", "count", "total ms", "self ms", "mean us", "p99 us", "max us");
+    for (size_t i = 0; i < n; i++)
+    {
+      const XProfileStats* s = &stats[i];
+      fprintf(out, "%-32.32s %10llu %12.3f %12.3f %10.3f %10.3f %10.3f\n",
+          s->name,
+          (unsigned long long)s->count,
+          s->total_ns / 1e6,
+          s->self_ns / 1e6,
+          s->mean_ns / 1e3,
+          s->p99_ns / 1e3,
+          s->max_ns / 1e3);
+    }
+    X_PROFILE_FREE(stats);
+  }
+
+  static void s_x_profile_write_json_string(FILE* f, const char* s)
+  {
+    fputc('"', f);
+    for (; *s; s++)
+    {
+      unsigned char c = (unsigned char)*s;
+      if (c == '"' || c == '\\')
+        fprintf(f, "\\%c", c);
+      else if (c < 0x20)
+        fprintf(f, "\\u%04x", c);
+      else
+        fputc(c, f);
+    }
+    fputc('"', f);
+  }
+
+  X_PROFILE_API bool x_profile_write_chrome_trace(const char* path)
+  {
+    if (!path || x_atomic_load_i32(&s_x_profile.generation) == 0)
+      return false;
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+
+    x_thread_mutex_lock(s_x_profile.lock);
+    double us_per_tick = 1e6 / (double)x_ticks_frequency();
+    bool first = true;
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f);
+    for (XProfileThread* t = s_x_profile.threads; t; t = t->next)
+    {
+      fprintf(f, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":", first ? "" : ",", t->index);
+      s_x_profile_write_json_string(f, t->name);
+      fputs("}}", f);
+      first = false;
+
+      if (!t->events) continue;
+      int64_t count = x_atomic_load_acquire_i64(&t->event_count);
+      int64_t capacity = (int64_t)t->event_mask + 1;
+      for (int64_t i = count > capacity ? count - capacity : 0; i < count; i++)
+      {
+        const XProfileEvent* e = &t->events[(uint64_t)i & t->event_mask];
+        if (e->zone <= 0) continue;
+        // Events are stored as they end; the viewers sort them
+        double ts = (double)(int64_t)(e->start - s_x_profile.base_ticks) * us_per_tick;
+        double dur = (double)(e->end - e->start) * us_per_tick;
+        fputs(",\n{\"name\":", f);
+        s_x_profile_write_json_string(f, s_x_profile.zones[e->zone]->name);
+        fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}", ts, dur, t->index);
+      }
+    }
+    fputs("\n]}\n", f);
+    x_thread_mutex_unlock(s_x_profile.lock);
+
+    bool ok = !ferror(f);
+    return fclose(f) == 0 && ok;
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // X_IMPL_PROFILE
+#endif  // X_PROFILE_H
@@ -0,0 +1,484 @@
+/**
+ * STDX - Lock-free Queues
+ * Part of the STDX General Purpose C Library by marciovmf
+ * License: MIT
+ * <https://github.com/marciovmf/stdx>
+ *
+ * ## Overview
+ *
+ * Bounded, lock-free ring buffer queues for handing fixed-size items
+ * between threads without taking locks.
+ *
+ * - `XSpscQueue`: single producer / single consumer. One thread pushes, one
+ *   thread pops. Producer and consumer indices live on separate cache lines
+ *   and each side caches the other's index, so the common case touches no
+ *   shared cache line.
+ * - `XMpmcQueue`: multiple producers / multiple consumers (Dmitry Vyukov's
+ *   bounded queue). Every cell carries a sequence number; producers and
+ *   consumers claim cells with a single CAS on their own index.
+ *
+ * Both queues copy items in and out by value (`element_size` bytes) and
+ * round the requested capacity up to a power of two. Push fails when the
+ * queue is full and pop fails when it is empty; neither ever blocks.
+ *
+ * ## How to compile
+ *
+ * To compile the implementation define `X_IMPL_QUEUE`
+ * in **one** source file before including this header.
+ *
+ * To customize how this module allocates memory, define
+ * `X_QUEUE_ALLOC` / `X_QUEUE_FREE` before including.
+ *
+ * ## Typed usage
+ *
+ * ```
+ * X_QUEUE_TYPE(int)
+ * XMpmcQueue_int* q = x_mpmc_queue_int_create(1024);
+ * x_mpmc_queue_int_push(q, 42);
+ * int value;
+ * if (x_mpmc_queue_int_pop(q, &value)) { ... }
+ * ```
+ *
+ * `X_QUEUE_TYPE_NAMED(T, suffix)` works like `X_ARRAY_TYPE_NAMED` for
+ * element types that are not valid identifiers.
+ *
+ * ## Dependencies
+ *
+ *  stdx_thread.h (atomic operations only, no implementation required)
+ *
+ */
+
+#ifndef X_QUEUE_H
+#define X_QUEUE_H
+
+#include "stdx_thread.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef X_QUEUE_API
+#define X_QUEUE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define X_QUEUE_VERSION_MAJOR 1
+#define X_QUEUE_VERSION_MINOR 0
+#define X_QUEUE_VERSION_PATCH 0
+
+#define X_QUEUE_VERSION (X_QUEUE_VERSION_MAJOR * 10000 + X_QUEUE_VERSION_MINOR * 100 + X_QUEUE_VERSION_PATCH)
+
+  typedef struct XSpscQueue XSpscQueue;
+  typedef struct XMpmcQueue XMpmcQueue;
+
+  /**
+   * @brief Create a single-producer/single-consumer queue.
+   * @param element_size Size in bytes of one item.
+   * @param capacity Minimum number of items the queue holds. Rounded up to a power of two.
+   * @return Pointer to the new queue, or NULL on failure.
+   */
+  X_QUEUE_API XSpscQueue* x_spsc_queue_create(size_t element_size, uint32_t capacity);
+
+  /**
+   * @brief Destroy a queue created with `x_spsc_queue_create()`.
+   * @param q Queue to destroy.
+   */
+  X_QUEUE_API void x_spsc_queue_destroy(XSpscQueue* q);
+
+  /**
+   * @brief Copy an item into the queue. Must only be called by the producer thread.
+   * @param q Queue.
+   * @param item Pointer to `element_size` bytes to copy.
+   * @return true on success, false if the queue is full.
+   */
+  X_QUEUE_API bool x_spsc_queue_push(XSpscQueue* q, const void* item);
+
+  /**
+   * @brief Copy the oldest item out of the queue. Must only be called by the consumer thread.
+   * @param q Queue.
+   * @param out Destination for `element_size` bytes.
+   * @return true on success, false if the queue is empty.
+   */
+  X_QUEUE_API bool x_spsc_queue_pop(XSpscQueue* q, void* out);
+
+  /**
+   * @brief Number of queued items. Only a snapshot when other threads are active.
+   * @param q Queue.
+   * @return Item count.
+   */
+  X_QUEUE_API uint32_t x_spsc_queue_count(XSpscQueue* q);
+
+  /**
+   * @brief Queue capacity after rounding.
+   * @param q Queue.
+   * @return Maximum number of items.
+   */
+  X_QUEUE_API uint32_t x_spsc_queue_capacity(XSpscQueue* q);
+
+  /**
+   * @brief Create a multi-producer/multi-consumer queue.
+   * @param element_size Size in bytes of one item.
+   * @param capacity Minimum number of items the queue holds. Rounded up to a power of two (at least 2).
+   * @return Pointer to the new queue, or NULL on failure.
+   */
+  X_QUEUE_API XMpmcQueue* x_mpmc_queue_create(size_t element_size, uint32_t capacity);
+
+  /**
+   * @brief Destroy a queue created with `x_mpmc_queue_create()`.
+   * @param q Queue to destroy.
+   */
+  X_QUEUE_API void x_mpmc_queue_destroy(XMpmcQueue* q);
+
+  /**
+   * @brief Copy an item into the queue. Safe to call from any thread.
+   * @param q Queue.
+   * @param item Pointer to `element_size` bytes to copy.
+   * @return true on success, false if the queue is full.
+   */
+  X_QUEUE_API bool x_mpmc_queue_push(XMpmcQueue* q, const void* item);
+
+  /**
+   * @brief Copy the oldest item out of the queue. Safe to call from any thread.
+   * @param q Queue.
+   * @param out Destination for `element_size` bytes.
+   * @return true on success, false if the queue is empty.
+   */
+  X_QUEUE_API bool x_mpmc_queue_pop(XMpmcQueue* q, void* out);
+
+  /**
+   * @brief Number of queued items. Only a snapshot when other threads are active.
+   * @param q Queue.
+   * @return Item count.
+   */
+  X_QUEUE_API uint32_t x_mpmc_queue_count(XMpmcQueue* q);
+
+  /**
+   * @brief Queue capacity after rounding.
+   * @param q Queue.
+   * @return Maximum number of items.
+   */
+  X_QUEUE_API uint32_t x_mpmc_queue_capacity(XMpmcQueue* q);
+
+  /* Declare typed queue aliases and typed inline wrappers. */
+#define X_QUEUE_TYPE(T) \
+  X_QUEUE_TYPE_NAMED(T, T)
+
+  /* Use this form for multi-token types such as unsigned int or struct Foo. */
+#define X_QUEUE_TYPE_NAMED(T, suffix) \
+  typedef XSpscQueue XSpscQueue_##suffix; \
+  typedef XMpmcQueue XMpmcQueue_##suffix; \
+  static inline XSpscQueue_##suffix* x_spsc_queue_##suffix##_create(uint32_t capacity) \
+  { \
+    return (XSpscQueue_##suffix*)x_spsc_queue_create(sizeof(T), capacity); \
+  } \
+  static inline void x_spsc_queue_##suffix##_destroy(XSpscQueue_##suffix* q) \
+  { \
+    x_spsc_queue_destroy((XSpscQueue*)q); \
+  } \
+  static inline bool x_spsc_queue_##suffix##_push(XSpscQueue_##suffix* q, T value) \
+  { \
+    T value_copy = value; \
+    return x_spsc_queue_push((XSpscQueue*)q, &value_copy); \
+  } \
+  static inline bool x_spsc_queue_##suffix##_pop(XSpscQueue_##suffix* q, T* out) \
+  { \
+    return x_spsc_queue_pop((XSpscQueue*)q, out); \
+  } \
+  static inline uint32_t x_spsc_queue_##suffix##_count(XSpscQueue_##suffix* q) \
+  { \
+    return x_spsc_queue_count((XSpscQueue*)q); \
+  } \
+  static inline XMpmcQueue_##suffix* x_mpmc_queue_##suffix##_create(uint32_t capacity) \
+  { \
+    return (XMpmcQueue_##suffix*)x_mpmc_queue_create(sizeof(T), capacity); \
+  } \
+  static inline void x_mpmc_queue_##suffix##_destroy(XMpmcQueue_##suffix* q) \
+  { \
+    x_mpmc_queue_destroy((XMpmcQueue*)q); \
+  } \
+  static inline bool x_mpmc_queue_##suffix##_push(XMpmcQueue_##suffix* q, T value) \
+  { \
+    T value_copy = value; \
+    return x_mpmc_queue_push((XMpmcQueue*)q, &value_copy); \
+  } \
+  static inline bool x_mpmc_queue_##suffix##_pop(XMpmcQueue_##suffix* q, T* out) \
+  { \
+    return x_mpmc_queue_pop((XMpmcQueue*)q, out); \
+  } \
+  static inline uint32_t x_mpmc_queue_##suffix##_count(XMpmcQueue_##suffix* q) \
+  { \
+    return x_mpmc_queue_count((XMpmcQueue*)q); \
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef X_IMPL_QUEUE
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef X_QUEUE_ALLOC
+/**
+ * @brief Internal macro for allocating memory.
+ * To override how this header allocates memory, define this macro with a
+ * different implementation before including this header.
+ * @param sz  The size of memory to alloc.
+ */
+#define X_QUEUE_ALLOC(sz) malloc(sz)
+#endif
+
+#ifndef X_QUEUE_FREE
+/**
+ * @brief Internal macro for freeing memory.
+ * To override how this header frees memory, define this macro with a
+ * different implementation before including this header.
+ * @param p  The address of memory region to free.
+ */
+#define X_QUEUE_FREE(p) free(p)
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  struct XSpscQueue
+  {
+    uint8_t* buffer;
+    size_t element_size;
+    int64_t mask;
+    char pad0[X_THREAD_CACHE_LINE_SIZE];
+
+    // Consumer side
+    volatile int64_t head;
+    int64_t cached_tail;
+    char pad1[X_THREAD_CACHE_LINE_SIZE];
+
+    // Producer side
+    volatile int64_t tail;
+    int64_t cached_head;
+    char pad2[X_THREAD_CACHE_LINE_SIZE];
+  };
+
+  struct XMpmcQueue
+  {
+    uint8_t* cells;
+    size_t element_size;
+    size_t cell_stride;
+    int64_t mask;
+    char pad0[X_THREAD_CACHE_LINE_SIZE];
+
+    volatile int64_t enqueue_pos;
+    char pad1[X_THREAD_CACHE_LINE_SIZE];
+
+    volatile int64_t dequeue_pos;
+    char pad2[X_THREAD_CACHE_LINE_SIZE];
+  };
+
+  static uint32_t s_queue_round_pow2(uint32_t v)
+  {
+    uint32_t n = 1;
+    while (n < v && n < 0x80000000u)
+      n <<= 1;
+    return n;
+  }
+
+  XSpscQueue* x_spsc_queue_create(size_t element_size, uint32_t capacity)
+  {
+    if (element_size == 0 || capacity == 0)
+      return NULL;
+
+    XSpscQueue* q = (XSpscQueue*)X_QUEUE_ALLOC(sizeof(XSpscQueue));
+    if (!q)
+      return NULL;
+
+    memset(q, 0, sizeof(*q));
+    capacity = s_queue_round_pow2(capacity);
+    q->element_size = element_size;
+    q->mask = (int64_t)capacity - 1;
+    q->buffer = (uint8_t*)X_QUEUE_ALLOC(element_size * capacity);
+    if (!q->buffer)
+    {
+      X_QUEUE_FREE(q);
+      return NULL;
+    }
+    return q;
+  }
+
+  void x_spsc_queue_destroy(XSpscQueue* q)
+  {
+    if (!q)
+      return;
+    X_QUEUE_FREE(q->buffer);
+    X_QUEUE_FREE(q);
+  }
+
+  bool x_spsc_queue_push(XSpscQueue* q, const void* item)
+  {
+    int64_t tail = q->tail;   // Only the producer writes tail
+    if (tail - q->cached_head > q->mask)
+    {
+      q->cached_head = x_atomic_load_acquire_i64(&q->head);
+      if (tail - q->cached_head > q->mask)
+        return false;
+    }
+
+    memcpy(q->buffer + (size_t)(tail & q->mask) * q->element_size, item, q->element_size);
+    x_atomic_store_release_i64(&q->tail, tail + 1);
+    return true;
+  }
+
+  bool x_spsc_queue_pop(XSpscQueue* q, void* out)
+  {
+    int64_t head = q->head;   // Only the consumer writes head
+    if (head >= q->cached_tail)
+    {
+      q->cached_tail = x_atomic_load_acquire_i64(&q->tail);
+      if (head >= q->cached_tail)
+        return false;
+    }
+
+    memcpy(out, q->buffer + (size_t)(head & q->mask) * q->element_size, q->element_size);
+    x_atomic_store_release_i64(&q->head, head + 1);
+    return true;
+  }
+
+  uint32_t x_spsc_queue_count(XSpscQueue* q)
+  {
+    int64_t head = x_atomic_load_acquire_i64(&q->head);
+    int64_t tail = x_atomic_load_acquire_i64(&q->tail);
+    return tail > head ? (uint32_t)(tail - head) : 0;
+  }
+
+  uint32_t x_spsc_queue_capacity(XSpscQueue* q)
+  {
+    return (uint32_t)(q->mask + 1);
+  }
+
+  // MPMC cell layout: [int64_t sequence][item bytes], padded to 8 bytes
+  static volatile int64_t* s_mpmc_cell_seq(XMpmcQueue* q, int64_t pos)
+  {
+    return (volatile int64_t*)(q->cells + (size_t)(pos & q->mask) * q->cell_stride);
+  }
+
+  static void* s_mpmc_cell_data(XMpmcQueue* q, int64_t pos)
+  {
+    return q->cells + (size_t)(pos & q->mask) * q->cell_stride + sizeof(int64_t);
+  }
+
+  XMpmcQueue* x_mpmc_queue_create(size_t element_size, uint32_t capacity)
+  {
+    if (element_size == 0 || capacity == 0)
+      return NULL;
+
+    XMpmcQueue* q = (XMpmcQueue*)X_QUEUE_ALLOC(sizeof(XMpmcQueue));
+    if (!q)
+      return NULL;
+
+    memset(q, 0, sizeof(*q));
+    capacity = s_queue_round_pow2(capacity < 2 ? 2 : capacity);
+    q->element_size = element_size;
+    q->cell_stride = (sizeof(int64_t) + element_size + 7) & ~(size_t)7;
+    q->mask = (int64_t)capacity - 1;
+    q->cells = (uint8_t*)X_QUEUE_ALLOC(q->cell_stride * capacity);
+    if (!q->cells)
+    {
+      X_QUEUE_FREE(q);
+      return NULL;
+    }
+
+    for (int64_t i = 0; i < (int64_t)capacity; ++i)
+      x_atomic_store_release_i64(s_mpmc_cell_seq(q, i), i);
+
+    return q;
+  }
+
+  void x_mpmc_queue_destroy(XMpmcQueue* q)
+  {
+    if (!q)
+      return;
+    X_QUEUE_FREE(q->cells);
+    X_QUEUE_FREE(q);
+  }
+
+  bool x_mpmc_queue_push(XMpmcQueue* q, const void* item)
+  {
+    int64_t pos = x_atomic_load_acquire_i64(&q->enqueue_pos);
+    volatile int64_t* seq;
+
+    while (1)
+    {
+      seq = s_mpmc_cell_seq(q, pos);
+      int64_t diff = x_atomic_load_acquire_i64(seq) - pos;
+      if (diff == 0)
+      {
+        if (x_atomic_cas_i64(&q->enqueue_pos, pos, pos + 1))
+          break;
+        pos = x_atomic_load_acquire_i64(&q->enqueue_pos);
+      }
+      else if (diff < 0)
+      {
+        return false;   // Cell still holds an item from the previous lap
+      }
+      else
+      {
+        pos = x_atomic_load_acquire_i64(&q->enqueue_pos);
+      }
+    }
+
+    memcpy(s_mpmc_cell_data(q, pos), item, q->element_size);
+    x_atomic_store_release_i64(seq, pos + 1);
+    return true;
+  }
+
+  bool x_mpmc_queue_pop(XMpmcQueue* q, void* out)
+  {
+    int64_t pos = x_atomic_load_acquire_i64(&q->dequeue_pos);
+    volatile int64_t* seq;
+
+    while (1)
+    {
+      seq = s_mpmc_cell_seq(q, pos);
+      int64_t diff = x_atomic_load_acquire_i64(seq) - (pos + 1);
+      if (diff == 0)
+      {
+        if (x_atomic_cas_i64(&q->dequeue_pos, pos, pos + 1))
+          break;
+        pos = x_atomic_load_acquire_i64(&q->dequeue_pos);
+      }
+      else if (diff < 0)
+      {
+        return false;   // Cell not written yet
+      }
+      else
+      {
+        pos = x_atomic_load_acquire_i64(&q->dequeue_pos);
+      }
+    }
+
+    memcpy(out, s_mpmc_cell_data(q, pos), q->element_size);
+    x_atomic_store_release_i64(seq, pos + q->mask + 1);
+    return true;
+  }
+
+  uint32_t x_mpmc_queue_count(XMpmcQueue* q)
+  {
+    int64_t head = x_atomic_load_acquire_i64(&q->dequeue_pos);
+    int64_t tail = x_atomic_load_acquire_i64(&q->enqueue_pos);
+    return tail > head ? (uint32_t)(tail - head) : 0;
+  }
+
+  uint32_t x_mpmc_queue_capacity(XMpmcQueue* q)
+  {
+    return (uint32_t)(q->mask + 1);
+  }
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // X_IMPL_QUEUE
+#endif // X_QUEUE_H
@@ -9,17 +9,48 @@
  * This header provides a simple interface for constructing strings efficiently:
  *   - Dynamic growth as data is appended
  *   - Append strings, characters, substrings, and formatted text
+ *   - Append integers and doubles without going through printf
+ *   - Append many slices with a single capacity check
+ *   - Write in place through x_strbuilder_begin_write() / x_strbuilder_commit()
+ *   - Reference large external chunks instead of copying them (segments)
  *   - Convert to null-terminated C string
  *   - Clear or destroy the builder when done
  *
  * To customize how this module allocates memory, define
  * `X_STRBUILDER_ALLOC` / `X_STRBUILDER_REALLOC` / `X_STRBUILDER_FREE` before including.
+ * To pick the allocator per builder at runtime, create it with
+ * `x_strbuilder_create_with_allocator()` and an `XAllocator` (see stdx_common.h).
+ *
+ * ## Segments
+ *
+ * `x_strbuilder_append_ref()` records a borrowed chunk (for example a
+ * static template literal) instead of copying it. The builder then holds
+ * an ordered list of owned and borrowed segments that
+ * `x_strbuilder_gather()` exposes as `XSlice`s, ready for `x_io_writev()`
+ * or `x_net_sendv()`. Borrowed memory must stay valid until the builder is
+ * cleared, destroyed or flattened. `x_strbuilder_to_string()` flattens
+ * everything into one owned buffer, so only call it when a contiguous
+ * string is really needed.
+ *
+ * ```c
+ * XSlice parts[32];
+ * size_t first = 0, n;
+ * while ((n = x_strbuilder_gather(sb, first, parts, 32)) > 0)
+ * {
+ *   x_io_writev(file, parts, n);
+ *   first += n;
+ * }
+ * ```
  *
  * ## How to compile
  *
  * To compile the implementation define `X_IMPL_STRBUILDER`
  * in **one** source file before including this header.
  *
+ * ## Dependencies
+ *  stdx_string.h (for XSlice only; the implementation is not required).
+ *  When a file implements stdx_string.h too, define X_IMPL_STRING and
+ *  include it before this header.
  */
 
 #ifndef X_STRBUILDER_H
@@ -38,17 +69,39 @@
 #define STRBUILDER_STACK_BUFFER_SIZE 255
 #endif
 
+#ifndef X_STRBUILDER_REF_MIN
+#define X_STRBUILDER_REF_MIN 64   /* shorter chunks passed to x_strbuilder_append_ref() are copied */
+#endif
+
+#include <stdx_common.h>
+#include <stdx_string.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <wchar.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+  typedef struct XStrSegment
+  {
+    const char *ref;        /* borrowed bytes, or NULL for data + offset */
+    size_t offset;
+    size_t length;
+  } XStrSegment;
+
   typedef struct XStrBuilder
   {
     char *data;
     size_t capacity;
-    size_t length;
+    size_t length;          /* owned bytes in data */
+    XAllocator allocator;   /* alloc_fn NULL means X_STRBUILDER_ALLOC */
+
+    XStrSegment *segments;  /* empty until the first x_strbuilder_append_ref() */
+    size_t segment_count;
+    size_t segment_capacity;
+    size_t owned_mark;      /* start of the owned run not yet in segments */
+    size_t ref_length;      /* total borrowed bytes */
   } XStrBuilder;
 
   typedef struct XWStrBuilder
@@ -67,6 +120,13 @@ extern "C" {
    */
   XStrBuilder*  x_strbuilder_create();
 
+  /**
+   * @brief Creates a XStrBuilder that allocates through `allocator`
+   * @param allocator Allocator to copy into the builder, or NULL for X_STRBUILDER_ALLOC
+   * @return pointer to the XStrBuilder or NULL if creation fails
+   */
+  XStrBuilder*  x_strbuilder_create_with_allocator(const XAllocator* allocator);
+
   /**
    * @brief Appends a C-string to the builder
    * @param sb Destination builder
@@ -96,12 +156,96 @@ extern "C" {
    */
   void   x_strbuilder_append_substring(XStrBuilder *sb, const char *start, size_t length);
 
+  /**
+   * @brief Appends many slices, growing the buffer at most once
+   * @param sb Destination builder
+   * @param slices Slices to append, in order
+   * @param count Number of slices
+   */
+  void   x_strbuilder_append_slices(XStrBuilder *sb, const XSlice *slices, size_t count);
+
+  /**
+   * @brief Appends a signed integer in decimal
+   * @param sb Destination builder
+   * @param value Value to append
+   */
+  void   x_strbuilder_append_i64(XStrBuilder *sb, int64_t value);
+
+  /**
+   * @brief Appends an unsigned integer in decimal
+   * @param sb Destination builder
+   * @param value Value to append
+   */
+  void   x_strbuilder_append_u64(XStrBuilder *sb, uint64_t value);
+
+  /**
+   * @brief Appends a double using the shortest text that parses back to the same value
+   * Integral values below 1e15 are written as plain integers; others use
+   * `%g` notation with 15, 16 or 17 significant digits.
+   * @param sb Destination builder
+   * @param value Value to append
+   */
+  void   x_strbuilder_append_f64(XStrBuilder *sb, double value);
+
+  /**
+   * @brief Ensures room for `capacity` bytes plus the NUL without further growth
+   * @param sb Builder to grow
+   * @param capacity Total length in bytes the builder must be able to hold
+   * @return true on success, false if the allocation failed
+   */
+  bool   x_strbuilder_reserve(XStrBuilder *sb, size_t capacity);
+
+  /**
+   * @brief Returns a pointer where up to `max` bytes can be written in place
+   * The bytes become part of the content once x_strbuilder_commit() is called.
+   * The pointer is invalidated by any other call on the builder.
+   * @param sb Destination builder
+   * @param max Maximum number of bytes the caller will write
+   * @return Pointer to the end of the content, or NULL if the allocation failed
+   */
+  char*  x_strbuilder_begin_write(XStrBuilder *sb, size_t max);
+
+  /**
+   * @brief Commits `n` bytes written after x_strbuilder_begin_write()
+   * @param sb Destination builder
+   * @param n Number of bytes written (no more than the `max` passed to begin_write)
+   */
+  void   x_strbuilder_commit(XStrBuilder *sb, size_t n);
+
+  /**
+   * @brief Appends a borrowed chunk without copying it
+   * Chunks shorter than X_STRBUILDER_REF_MIN are copied instead.
+   * @param sb Destination builder
+   * @param ptr First byte; must stay valid until the builder is cleared, destroyed or flattened
+   * @param length Number of bytes
+   */
+  void   x_strbuilder_append_ref(XStrBuilder *sb, const char *ptr, size_t length);
+
+  /**
+   * @brief Returns the number of segments x_strbuilder_gather() produces
+   * @param sb Builder to query
+   * @return Segment count (0 for an empty builder, 1 without borrowed chunks)
+   */
+  size_t x_strbuilder_segment_count(const XStrBuilder *sb);
+
+  /**
+   * @brief Describes the content as ordered slices, without copying
+   * The slices are invalidated by any later append on the builder.
+   * @param sb Builder to query
+   * @param first Index of the first segment to return
+   * @param out Destination slices
+   * @param max Capacity of out
+   * @return Number of slices written
+   */
+  size_t x_strbuilder_gather(const XStrBuilder *sb, size_t first, XSlice *out, size_t max);
+
   /**
    * @brief Returns internal buffer pointer
+   * Borrowed segments are copied into the buffer first.
    * @param sb Builder to query
-   * @return Pointer to internal NUL-terminated buffer (invalidated by later appends)
+   * @return Pointer to internal NUL-terminated buffer (invalidated by later appends), NULL if flattening failed
    */
-  char*  x_strbuilder_to_string(const XStrBuilder *sb);
+  char*  x_strbuilder_to_string(XStrBuilder *sb);
 
   /**
    * @brief Destroys the builder and frees memory
@@ -118,7 +262,7 @@ extern "C" {
   /**
    * @brief Returns current length in bytes
    * @param sb Builder to query
-   * @return Length in bytes (excluding the NUL)
+   * @return Length in bytes, borrowed segments included (excluding the NUL)
    */
   size_t x_strbuilder_length(XStrBuilder *sb);
 
@@ -133,6 +277,7 @@ extern "C" {
   
   /**
    * @brief Counts UTF-8 code points contained in the builder
+   * Borrowed segments are not counted until x_strbuilder_to_string() flattens them.
    * @param sb Builder to query
    * @return Number of Unicode code points
    */
@@ -214,6 +359,25 @@ extern "C" {
 extern "C" {
 #endif
 
+  static void* s_strbuilder_alloc(const XAllocator* a, size_t size)
+  {
+    return a->alloc_fn ? a->alloc_fn(a->user, size) : X_STRBUILDER_ALLOC(size);
+  }
+
+  static void s_strbuilder_free(const XAllocator* a, void* ptr, size_t size)
+  {
+    if (a->alloc_fn)
+    {
+      if (ptr) a->free_fn(a->user, ptr, size);
+      return;
+    }
+    X_STRBUILDER_FREE(ptr);
+  }
+
+  static void* s_strbuilder_realloc(const XAllocator* a, void* ptr, size_t old_size, size_t new_size)
+  {
+    return a->alloc_fn ? a->realloc_fn(a->user, ptr, old_size, new_size) : X_STRBUILDER_REALLOC(ptr, new_size);
+  }
 
   static int s_strbuilder_reserve(XStrBuilder* sb, size_t min_cap)
   {
@@ -224,7 +388,7 @@ extern "C" {
       if (cap > (SIZE_MAX/2u)) { cap = min_cap; break; }
       cap *= 2u;
     }
-    char* p = (char*)X_STRBUILDER_REALLOC(sb->data, cap * sizeof(char));
+    char* p = (char*)s_strbuilder_realloc(&sb->allocator, sb->data, sb->capacity * sizeof(char), cap * sizeof(char));
     if (!p) return 0;
     sb->data = p;
     sb->capacity = cap;
@@ -265,11 +429,26 @@ extern "C" {
 
   X_STRBUILDER_API XStrBuilder* x_strbuilder_create()
   {
-    XStrBuilder* sb = (XStrBuilder*)  X_STRBUILDER_ALLOC(sizeof(XStrBuilder));
+    return x_strbuilder_create_with_allocator(NULL);
+  }
+
+  X_STRBUILDER_API XStrBuilder* x_strbuilder_create_with_allocator(const XAllocator* allocator)
+  {
+    XAllocator a;
+    memset(&a, 0, sizeof(a));
+    if (allocator) a = *allocator;
+
+    XStrBuilder* sb = (XStrBuilder*) s_strbuilder_alloc(&a, sizeof(XStrBuilder));
     if (!sb) return NULL;
+    sb->allocator = a;
+    sb->segments = NULL;
+    sb->segment_count = 0;
+    sb->segment_capacity = 0;
+    sb->owned_mark = 0;
+    sb->ref_length = 0;
     sb->capacity = 16; // Initial capacity
-    sb->data = (char *) X_STRBUILDER_ALLOC(sb->capacity * sizeof(char));
-    if (!sb->data) { X_STRBUILDER_FREE(sb); return NULL; }
+    sb->data = (char *) s_strbuilder_alloc(&a, sb->capacity * sizeof(char));
+    if (!sb->data) { s_strbuilder_free(&a, sb, sizeof(XStrBuilder)); return NULL; }
     sb->length = 0;
     sb->data[0] = '\0'; // Null-terminate the string
     return sb;
@@ -291,24 +470,156 @@ extern "C" {
     va_start(args, fmt);
     va_copy(args2, args);
 
-    int need = vsnprintf(NULL, 0, fmt, args);   // measure
+    // Format straight into the spare capacity; only measure and retry if it did not fit
+    size_t avail = sb->capacity - sb->length;
+    int need = vsnprintf(sb->data + sb->length, avail, fmt, args);
     va_end(args);
-    if (need < 0) { va_end(args2); return; }
+    if (need < 0) { sb->data[sb->length] = '\0'; va_end(args2); return; }
 
     size_t uneed = (size_t)need;
-    if (!s_strbuilder_reserve(sb, sb->length + uneed + 1)) { va_end(args2); return; }
-
-    // write at the end
-    vsnprintf(sb->data + sb->length, uneed + 1, fmt, args2);
+    if (uneed >= avail)
+    {
+      if (!s_strbuilder_reserve(sb, sb->length + uneed + 1)) { sb->data[sb->length] = '\0'; va_end(args2); return; }
+      vsnprintf(sb->data + sb->length, uneed + 1, fmt, args2);
+    }
     va_end(args2);
     sb->length += uneed;
   }
 
   X_STRBUILDER_API void x_strbuilder_append_char(XStrBuilder* sb, char c)
   {
-    char s[2] =
-    {c, 0};
-    x_strbuilder_append(sb, s);
+    if (!s_strbuilder_reserve(sb, sb->length + 2)) return;
+    sb->data[sb->length++] = c;
+    sb->data[sb->length] = '\0';
+  }
+
+  X_STRBUILDER_API void x_strbuilder_append_slices(XStrBuilder* sb, const XSlice* slices, size_t count)
+  {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++)
+      total += slices[i].length;
+
+    if (!s_strbuilder_reserve(sb, sb->length + total + 1)) return;
+
+    char* dst = sb->data + sb->length;
+    for (size_t i = 0; i < count; i++)
+    {
+      memcpy(dst, slices[i].ptr, slices[i].length);
+      dst += slices[i].length;
+    }
+    sb->length += total;
+    sb->data[sb->length] = '\0';
+  }
+
+  static const char s_strbuilder_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+  /* Writes value in decimal ending at `end`, two digits at a time. Returns the first char. */
+  static char* s_strbuilder_format_u64(char* end, uint64_t value)
+  {
+    char* p = end;
+    while (value >= 100)
+    {
+      unsigned d = (unsigned)(value % 100) * 2;
+      value /= 100;
+      *--p = s_strbuilder_digit_pairs[d + 1];
+      *--p = s_strbuilder_digit_pairs[d];
+    }
+    if (value >= 10)
+    {
+      unsigned d = (unsigned)value * 2;
+      *--p = s_strbuilder_digit_pairs[d + 1];
+      *--p = s_strbuilder_digit_pairs[d];
+    }
+    else
+    {
+      *--p = (char)('0' + value);
+    }
+    return p;
+  }
+
+  X_STRBUILDER_API void x_strbuilder_append_u64(XStrBuilder* sb, uint64_t value)
+  {
+    char buf[20];
+    char* p = s_strbuilder_format_u64(buf + sizeof(buf), value);
+    x_strbuilder_append_substring(sb, p, (size_t)(buf + sizeof(buf) - p));
+  }
+
+  X_STRBUILDER_API void x_strbuilder_append_i64(XStrBuilder* sb, int64_t value)
+  {
+    char buf[21];
+    // Negate in unsigned space so INT64_MIN does not overflow
+    uint64_t mag = value < 0 ? (uint64_t)0 - (uint64_t)value : (uint64_t)value;
+    char* p = s_strbuilder_format_u64(buf + sizeof(buf), mag);
+    if (value < 0) *--p = '-';
+    x_strbuilder_append_substring(sb, p, (size_t)(buf + sizeof(buf) - p));
+  }
+
+  X_STRBUILDER_API void x_strbuilder_append_f64(XStrBuilder* sb, double value)
+  {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool negative = (bits >> 63) != 0;
+
+    if (value != value) { x_strbuilder_append_substring(sb, "nan", 3); return; }
+    if (value - value != 0.0)
+    {
+      if (negative) x_strbuilder_append_substring(sb, "-inf", 4);
+      else x_strbuilder_append_substring(sb, "inf", 3);
+      return;
+    }
+
+    // Integral values take the integer path, keeping the sign of -0.0
+    if (value > -1e15 && value < 1e15 && value == (double)(int64_t)value)
+    {
+      if (value == 0.0)
+      {
+        if (negative) x_strbuilder_append_substring(sb, "-0", 2);
+        else x_strbuilder_append_substring(sb, "0", 1);
+        return;
+      }
+      x_strbuilder_append_i64(sb, (int64_t)value);
+      return;
+    }
+
+    // 17 significant digits always round-trip; take the shortest that does
+    char* dst = x_strbuilder_begin_write(sb, 32);
+    if (!dst) return;
+    int n = 0;
+    for (int precision = 15; precision <= 17; precision++)
+    {
+      n = snprintf(dst, 33, "%.*g", precision, value);
+      if (precision == 17 || strtod(dst, NULL) == value)
+        break;
+    }
+    x_strbuilder_commit(sb, n > 0 ? (size_t)n : 0);
+  }
+
+  X_STRBUILDER_API bool x_strbuilder_reserve(XStrBuilder* sb, size_t capacity)
+  {
+    return s_strbuilder_reserve(sb, capacity + 1) != 0;
+  }
+
+  X_STRBUILDER_API char* x_strbuilder_begin_write(XStrBuilder* sb, size_t max)
+  {
+    if (!s_strbuilder_reserve(sb, sb->length + max + 1)) return NULL;
+    return sb->data + sb->length;
+  }
+
+  X_STRBUILDER_API void x_strbuilder_commit(XStrBuilder* sb, size_t n)
+  {
+    if (sb->length + n >= sb->capacity) n = sb->capacity - sb->length - 1;
+    sb->length += n;
+    sb->data[sb->length] = '\0';
   }
 
   X_STRBUILDER_API void x_strbuilder_append_substring(XStrBuilder *sb, const char *start, size_t length)
@@ -320,18 +631,111 @@ extern "C" {
     sb->data[sb->length] = '\0';
   }
 
-  X_STRBUILDER_API char* x_strbuilder_to_string(const XStrBuilder *sb)
+  static int s_strbuilder_push_segment(XStrBuilder* sb, const char* ref, size_t offset, size_t length)
   {
+    if (sb->segment_count == sb->segment_capacity)
+    {
+      size_t cap = sb->segment_capacity ? sb->segment_capacity * 2u : 8u;
+      XStrSegment* p = (XStrSegment*)s_strbuilder_realloc(&sb->allocator, sb->segments,
+          sb->segment_capacity * sizeof(XStrSegment), cap * sizeof(XStrSegment));
+      if (!p) return 0;
+      sb->segments = p;
+      sb->segment_capacity = cap;
+    }
+    sb->segments[sb->segment_count].ref = ref;
+    sb->segments[sb->segment_count].offset = offset;
+    sb->segments[sb->segment_count].length = length;
+    sb->segment_count++;
+    return 1;
+  }
+
+  X_STRBUILDER_API void x_strbuilder_append_ref(XStrBuilder* sb, const char* ptr, size_t length)
+  {
+    if (length < X_STRBUILDER_REF_MIN)
+    {
+      x_strbuilder_append_substring(sb, ptr, length);
+      return;
+    }
+
+    // Close the owned run written since the last borrowed chunk
+    if (sb->length > sb->owned_mark)
+    {
+      if (!s_strbuilder_push_segment(sb, NULL, sb->owned_mark, sb->length - sb->owned_mark)) return;
+      sb->owned_mark = sb->length;
+    }
+    if (!s_strbuilder_push_segment(sb, ptr, 0, length)) return;
+    sb->ref_length += length;
+  }
+
+  X_STRBUILDER_API size_t x_strbuilder_segment_count(const XStrBuilder* sb)
+  {
+    return sb->segment_count + (sb->length > sb->owned_mark ? 1u : 0u);
+  }
+
+  X_STRBUILDER_API size_t x_strbuilder_gather(const XStrBuilder* sb, size_t first, XSlice* out, size_t max)
+  {
+    size_t n = 0;
+    size_t i = first;
+
+    for (; i < sb->segment_count && n < max; i++, n++)
+    {
+      const XStrSegment* seg = &sb->segments[i];
+      out[n].ptr = seg->ref ? seg->ref : sb->data + seg->offset;
+      out[n].length = seg->length;
+    }
+
+    // The trailing owned run is implied rather than stored
+    if (i == sb->segment_count && n < max && sb->length > sb->owned_mark)
+    {
+      out[n].ptr = sb->data + sb->owned_mark;
+      out[n].length = sb->length - sb->owned_mark;
+      n++;
+    }
+    return n;
+  }
+
+  X_STRBUILDER_API char* x_strbuilder_to_string(XStrBuilder *sb)
+  {
+    if (sb->segment_count == 0)
+      return sb->data;
+
+    // Flatten into a fresh buffer: owned runs and borrowed chunks in order
+    size_t total = sb->length + sb->ref_length;
+    char* flat = (char*)s_strbuilder_alloc(&sb->allocator, total + 1);
+    if (!flat) return NULL;
+
+    XSlice parts[16];
+    size_t first = 0, n, pos = 0;
+    while ((n = x_strbuilder_gather(sb, first, parts, 16)) > 0)
+    {
+      for (size_t i = 0; i < n; i++)
+      {
+        memcpy(flat + pos, parts[i].ptr, parts[i].length);
+        pos += parts[i].length;
+      }
+      first += n;
+    }
+    flat[total] = '\0';
+
+    s_strbuilder_free(&sb->allocator, sb->data, sb->capacity * sizeof(char));
+    sb->data = flat;
+    sb->capacity = total + 1;
+    sb->length = total;
+    sb->segment_count = 0;
+    sb->owned_mark = 0;
+    sb->ref_length = 0;
     return sb->data;
   }
 
   X_STRBUILDER_API void x_strbuilder_destroy(XStrBuilder *sb)
   {
-    X_STRBUILDER_FREE(sb->data);
+    XAllocator a = sb->allocator;
+    s_strbuilder_free(&a, sb->segments, sb->segment_capacity * sizeof(XStrSegment));
+    s_strbuilder_free(&a, sb->data, sb->capacity * sizeof(char));
     sb->data = NULL;
     sb->capacity = 0;
     sb->length = 0;
-    X_STRBUILDER_FREE(sb);
+    s_strbuilder_free(&a, sb, sizeof(XStrBuilder));
   }
 
   X_STRBUILDER_API void x_strbuilder_clear(XStrBuilder *sb)
@@ -341,11 +745,14 @@ extern "C" {
       sb->data[0] = 0;
       sb->length = 0;
     }
+    sb->segment_count = 0;
+    sb->owned_mark = 0;
+    sb->ref_length = 0;
   }
 
   X_STRBUILDER_API size_t x_strbuilder_length(XStrBuilder *sb)
   {
-    return sb->length;
+    return sb->length + sb->ref_length;
   }
 
   X_STRBUILDER_API void x_strbuilder_append_utf8_substring(XStrBuilder* sb, const char* utf8, size_t start_cp, size_t len_cp)
@@ -386,19 +793,7 @@ extern "C" {
 
   X_STRBUILDER_API void x_wstrbuilder_grow(XWStrBuilder* sb, size_t needed_len)
   {
-    if (sb->length + needed_len + 1 > sb->capacity)
-    {
-      size_t want = sb->capacity;
-      while (sb->length + needed_len + 1 > want)
-      {
-        if (want > (SIZE_MAX/2)) { want = sb->length + needed_len + 1; break; }
-        want *= 2;
-      }
-      wchar_t* p = (wchar_t*)X_STRBUILDER_REALLOC(sb->data, want * sizeof(wchar_t));
-      if (!p) return;
-      sb->data = p;
-      sb->capacity = want;
-    }
+    s_wstrbuilder_reserve(sb, sb->length + needed_len + 1);
   }
 
   X_STRBUILDER_API void x_wstrbuilder_append(XWStrBuilder* sb, const wchar_t* str)
@@ -9,6 +9,12 @@
  * To compile the implementation define `X_IMPL_STRING`
  * in **one** source file before including this header.
  *
+ * The implementation brings in the stdx_cpuid implementation too, unless
+ * X_IMPL_CPUID is already defined: byte and substring searches use SSE2/AVX2
+ * or NEON kernels picked at runtime, as do UTF-8 validation, counting and
+ * the UTF-8/UTF-16 conversions. Define `X_STRING_NO_SIMD` to build only
+ * the portable ones.
+ *
  * ## Overview
  *  This header provides:
  *   - C string helpers: case-insensitive prefix/suffix matching
@@ -219,6 +225,30 @@ extern "C" {
    */
   X_STRING_API size_t    x_utf8_to_wcstr(const char* utf8, wchar_t* wide, size_t max);
 
+  /**
+   * @brief Converts UTF-8 to UTF-16, independent of the current locale.
+   * ASCII runs are widened with SIMD. Output stops at the last codepoint
+   * that fits and is always null-terminated.
+   * @param utf8 Source UTF-8 bytes.
+   * @param length Number of source bytes.
+   * @param utf16 Destination buffer, or NULL to measure the UTF-16 length.
+   * @param max Capacity of the destination buffer (in elements, including the terminator).
+   * @return Number of UTF-16 units written or measured (excluding the terminator), or (size_t)-1 on invalid UTF-8.
+   */
+  X_STRING_API size_t    x_utf8_to_utf16(const char* utf8, size_t length, uint16_t* utf16, size_t max);
+
+  /**
+   * @brief Converts UTF-16 to UTF-8, independent of the current locale.
+   * ASCII runs are narrowed with SIMD. Output stops at the last codepoint
+   * that fits and is always null-terminated.
+   * @param utf16 Source UTF-16 units.
+   * @param length Number of source units.
+   * @param utf8 Destination buffer, or NULL to measure the UTF-8 length.
+   * @param max Capacity of the destination buffer (in bytes, including the terminator).
+   * @return Number of bytes written or measured (excluding the terminator), or (size_t)-1 on an unpaired surrogate.
+   */
+  X_STRING_API size_t    x_utf16_to_utf8(const uint16_t* utf16, size_t length, char* utf8, size_t max);
+
   // -------------------------------------------------------------------------------------
   // UTF8 functions
   // -------------------------------------------------------------------------------------
@@ -277,6 +307,33 @@ extern "C" {
    */
   X_STRING_API int32_t x_utf8_codepoint_length(unsigned char first_byte);
 
+  /**
+   * @brief Checks that a byte span is well-formed UTF-8.
+   * Rejects overlong forms, surrogates, values above U+10FFFF and truncated
+   * sequences. Runs SIMD kernels (SSSE3/AVX2/NEON) chosen at runtime.
+   * @param utf8 Bytes to check.
+   * @param length Number of bytes.
+   * @param out_valid_length Optional output: length of the longest valid prefix.
+   * @return true if the whole span is valid UTF-8.
+   */
+  X_STRING_API bool      x_utf8_validate(const char* utf8, size_t length, size_t* out_valid_length);
+
+  /**
+   * @brief Counts the codepoints of valid UTF-8 (the bytes that are not continuations).
+   * @param utf8 UTF-8 bytes, validated by the caller.
+   * @param length Number of bytes.
+   * @return Number of codepoints.
+   */
+  X_STRING_API size_t    x_utf8_count(const char* utf8, size_t length);
+
+  /**
+   * @brief Checks whether a byte span is plain 7-bit ASCII.
+   * @param utf8 Bytes to check.
+   * @param length Number of bytes.
+   * @return true if no byte has the high bit set.
+   */
+  X_STRING_API bool      x_utf8_is_ascii(const char* utf8, size_t length);
+
   // -------------------------------------------------------------------------------------
   // Fixed size small string functions
   // -------------------------------------------------------------------------------------
@@ -645,6 +702,22 @@ extern "C" {
    */
   X_STRING_API int32_t   x_slice_rfind(XSlice sv, char c);
 
+  /**
+   * @brief Finds the first byte of a string view that belongs to a set.
+   * @param sv String view input.
+   * @param set Null-terminated list of the bytes to look for, e.g. " \t=;".
+   * @return Index on success, or -1 if not found.
+   */
+  X_STRING_API int32_t   x_slice_find_any(XSlice sv, const char* set);
+
+  /**
+   * @brief Finds the first occurrence of a substring in a string view.
+   * @param sv String view input.
+   * @param needle Substring to look for. An empty needle matches at 0.
+   * @return Index on success, or -1 if not found.
+   */
+  X_STRING_API int32_t   x_slice_find_slice(XSlice sv, XSlice needle);
+
   /**
    * @brief Splits a string view at the first occurrence of a delimiter.
    * @param sv String view input.
@@ -706,6 +779,13 @@ extern "C" {
    */
   X_STRING_API XSlice  x_slice_utf8_substr(XSlice sv, size_t char_start, size_t char_len);
 
+  /**
+   * @brief Checks that a string view is well-formed UTF-8 (see x_utf8_validate()).
+   * @param sv String view input.
+   * @return true if the view is valid UTF-8.
+   */
+  X_STRING_API bool    x_slice_utf8_is_valid(XSlice sv);
+
   /**
    * @brief Removes leading Unicode whitespace (by UTF-8 codepoints).
    * @param sv String view input.
@@ -976,6 +1056,12 @@ extern "C" {
 
 #ifdef X_IMPL_STRING
 
+#ifndef X_IMPL_CPUID
+#define X_INTERNAL_CPUID_IMPL
+#define X_IMPL_CPUID
+#endif
+#include "stdx_cpuid.h"
+
 #include <string.h>  /* strlen, memcpy, memmove (used by helpers/impl) */
 #include <wchar.h>   /* wchar_t APIs (XW* types) */
 #include <ctype.h>   /* tolower */
@@ -986,6 +1072,8 @@ extern "C" {
 #ifdef _WIN32
 #define strncasecmp _strnicmp
 #define strnicmp _strnicmp
+#else
+#include <strings.h> /* strncasecmp */
 #endif
 
 static bool s_is_unicode_whitespace(uint32_t cp)
@@ -1088,11 +1176,25 @@ static int32_t utf8_decode(const char** ptr, const char* end)
   return (int32_t)cp;
 }
 
+static inline bool s_x_utf8_is_ascii_word(const char* p)
+{
+  uint64_t w;
+  memcpy(&w, p, sizeof(w));
+  return (w & 0x8080808080808080ull) == 0;
+}
+
 static size_t utf8_advance(const char* s, size_t len, size_t chars)
 {
   size_t i = 0, count = 0;
   while (i < len && count < chars)
   {
+    // ASCII runs move 8 bytes (8 code points) at a time
+    if (i + 8 <= len && chars - count >= 8 && s_x_utf8_is_ascii_word(s + i))
+    {
+      i += 8;
+      count += 8;
+      continue;
+    }
     char c = (char)s[i];
     if ((c & 0x80) == 0x00) i += 1;
     else if ((c & 0xE0) == 0xC0) i += 2;
@@ -1243,22 +1345,6 @@ X_STRING_API void x_set_locale(const char* locale)
   setlocale(LC_ALL, locale ? locale : "");
 }
 
-X_STRING_API size_t x_utf8_strlen(const char* utf8)
-{
-  size_t count = 0;
-  while (*utf8)
-  {
-    char c = (char)*utf8;
-    if ((c & 0x80) == 0x00) utf8 += 1;
-    else if ((c & 0xE0) == 0xC0) utf8 += 2;
-    else if ((c & 0xF0) == 0xE0) utf8 += 3;
-    else if ((c & 0xF8) == 0xF0) utf8 += 4;
-    else break;
-    count++;
-  }
-  return count;
-}
-
 X_STRING_API int32_t  x_utf8_strcmp(const char* a, const char* b)
 {
   if (setlocale(LC_ALL, NULL) != NULL) return strcoll(a, b);
@@ -1452,7 +1538,7 @@ X_STRING_API void x_smallstr_trim(XSmallstr* s)
 X_STRING_API int32_t x_smallstr_cmp_ci(const XSmallstr* a, const XSmallstr* b)
 {
   size_t len = (a->length > b->length) ? a->length : b->length;
-  return strnicmp(a->buf, b->buf, len);
+  return strncasecmp(a->buf, b->buf, len);
 }
 
 X_STRING_API int32_t x_smallstr_replace_all(XSmallstr* s, const char* find, const char* replace)
@@ -1489,6 +1575,9 @@ X_STRING_API int32_t x_smallstr_replace_all(XSmallstr* s, const char* find, cons
 
 X_STRING_API size_t x_smallstr_utf8_len(const XSmallstr* s)
 {
+  if (x_utf8_validate(s->buf, s->length, NULL))
+    return x_utf8_count(s->buf, s->length);
+
   size_t count = 0;
   for (size_t i = 0; i < s->length;)
   {
@@ -1800,34 +1889,1228 @@ X_STRING_API XSlice x_slice_trim(XSlice sv)
   return x_slice_trim_right(x_slice_trim_left(sv));
 }
 
+//---------------------------------------------------------------------------
+// Byte search kernels
+//
+// x_slice_find() and friends scan with SSE2/AVX2 on x86 and NEON on
+// aarch64, picked at runtime through stdx_cpuid dispatch. Kernels return
+// the index of the match or X_STRING_NPOS. Slices shorter than one vector
+// never reach them.
+//---------------------------------------------------------------------------
+
+#define X_STRING_NPOS ((size_t)-1)
+#define X_STRING_SIMD_MIN 16
+
+#if !defined(X_STRING_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+#define X_STRING_SIMD_X86 1
+#include <immintrin.h>
+#elif !defined(X_STRING_NO_SIMD) && defined(__aarch64__)
+#define X_STRING_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+static inline uint32_t s_x_string_ctz32(uint32_t v) { unsigned long i; _BitScanForward(&i, v); return (uint32_t)i; }
+static inline uint32_t s_x_string_msb32(uint32_t v) { unsigned long i; _BitScanReverse(&i, v); return (uint32_t)i; }
+#else
+static inline uint32_t s_x_string_ctz32(uint32_t v) { return (uint32_t)__builtin_ctz(v); }
+static inline uint32_t s_x_string_msb32(uint32_t v) { return 31u - (uint32_t)__builtin_clz(v); }
+#endif
+
+// A set of bytes in the three shapes the kernels use
+typedef struct
+{
+  uint8_t small[4];       // the set when count <= 4, padded with its first byte
+  int32_t count;          // distinct bytes in the set
+  bool nibble;            // lo/hi identify the set exactly (at most 8 distinct high nibbles)
+  uint8_t lo[16];         // bit k set for low nibbles that pair with high nibble class k
+  uint8_t hi[16];         // bit k for the k-th distinct high nibble
+  bool table[256];
+} XStringByteSet;
+
+static void s_x_string_byteset_init(XStringByteSet* set, const uint8_t* bytes, size_t len)
+{
+  int32_t hi_class[16];
+  int32_t classes = 0;
+  memset(set, 0, sizeof(*set));
+  for (int32_t i = 0; i < 16; i++)
+    hi_class[i] = -1;
+  set->nibble = true;
+
+  for (size_t i = 0; i < len; i++)
+  {
+    uint8_t b = bytes[i];
+    if (set->table[b])
+      continue;
+    set->table[b] = true;
+    if (set->count < 4)
+      set->small[set->count] = b;
+    set->count++;
+
+    int32_t h = b >> 4;
+    if (hi_class[h] < 0)
+    {
+      if (classes == 8)
+        set->nibble = false;
+      else
+      {
+        hi_class[h] = classes++;
+        set->hi[h] = (uint8_t)(1u << hi_class[h]);
+      }
+    }
+    if (hi_class[h] >= 0)
+      set->lo[b & 15] |= (uint8_t)(1u << hi_class[h]);
+  }
+
+  for (int32_t i = set->count; i < 4; i++)
+    set->small[i] = set->small[0];
+}
+
+static size_t s_x_find_byte_scalar(const char* p, size_t n, char c)
+{
+  const char* at = (const char*)memchr(p, c, n);
+  return at ? (size_t)(at - p) : X_STRING_NPOS;
+}
+
+static size_t s_x_rfind_byte_scalar(const char* p, size_t n, char c)
+{
+  for (size_t i = n; i > 0; i--)
+  {
+    if (p[i - 1] == c) return i - 1;
+  }
+  return X_STRING_NPOS;
+}
+
+static size_t s_x_find_set_scalar(const char* p, size_t n, const XStringByteSet* set)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    if (set->table[(uint8_t)p[i]]) return i;
+  }
+  return X_STRING_NPOS;
+}
+
+static size_t s_x_find_small_scalar(const char* p, size_t n, const uint8_t* small)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    uint8_t b = (uint8_t)p[i];
+    if (b == small[0] || b == small[1] || b == small[2] || b == small[3]) return i;
+  }
+  return X_STRING_NPOS;
+}
+
+static size_t s_x_find_sub_scalar(const char* p, size_t n, const char* s, size_t m)
+{
+  size_t i = 0;
+  while (i + m <= n)
+  {
+    const char* at = (const char*)memchr(p + i, s[0], n - m + 1 - i);
+    if (!at)
+      break;
+    i = (size_t)(at - p);
+    if (p[i + m - 1] == s[m - 1] && memcmp(p + i + 1, s + 1, m - 2) == 0)
+      return i;
+    i++;
+  }
+  return X_STRING_NPOS;
+}
+
+#if X_STRING_SIMD_X86
+
+// Each kernel checks whole vectors, then one last vector overlapping the
+// previous one so every byte is seen without reading out of bounds.
+
+X_CPU_TARGET("sse2") static size_t s_x_find_byte_sse2(const char* p, size_t n, char c)
+{
+  const __m128i needle = _mm_set1_epi8(c);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), needle));
+    if (m) return i + s_x_string_ctz32(m);
+  }
+  if (i < n)
+  {
+    size_t base = n - 16;
+    uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + base)), needle));
+    m &= 0xFFFFu << (i - base);
+    if (m) return base + s_x_string_ctz32(m);
+  }
+  return X_STRING_NPOS;
+}
+
+X_CPU_TARGET("avx2") static size_t s_x_find_byte_avx2(const char* p, size_t n, char c)
+{
+  const __m256i needle = _mm256_set1_epi8(c);
+  size_t i = 0;
+  if (n < 32)
+  {
+    // Two overlapping 16-byte halves, kept in VEX encoding: calling the SSE2
+    // kernel from here would pay for the AVX to SSE transition
+    const __m128i needle16 = _mm256_castsi256_si128(needle);
+    uint32_t lo = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), needle16));
+    uint32_t hi = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + n - 16)), needle16));
+    uint32_t m = lo | (hi << (n - 16));
+    return m ? s_x_string_ctz32(m) : X_STRING_NPOS;
+  }
+  for (; i + 32 <= n; i += 32)
+  {
+    uint32_t m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), needle));
+    if (m) return i + s_x_string_ctz32(m);
+  }
+  if (i < n)
+  {
+    size_t base = n - 32;
+    uint32_t m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + base)), needle));
+    m &= 0xFFFFFFFFu << (i - base);
+    if (m) return base + s_x_string_ctz32(m);
+  }
+  return X_STRING_NPOS;
+}
+
+X_CPU_TARGET("sse2") static size_t s_x_rfind_byte_sse2(const char* p, size_t n, char c)
+{
+  const __m128i needle = _mm_set1_epi8(c);
+  size_t end = n;
+  for (; end >= 16; end -= 16)
+  {
+    uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + end - 16)), needle));
+    if (m) return end - 16 + s_x_string_msb32(m);
+  }
+  if (end > 0)
+  {
+    uint32_t m = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), needle));
+    m &= (1u << end) - 1u;
+    if (m) return s_x_string_msb32(m);
+  }
+  return X_STRING_NPOS;
+}
+
+X_CPU_TARGET("avx2") static size_t s_x_rfind_byte_avx2(const char* p, size_t n, char c)
+{
+  const __m256i needle = _mm256_set1_epi8(c);
+  size_t end = n;
+  if (n < 32)
+  {
+    const __m128i needle16 = _mm256_castsi256_si128(needle);
+    uint32_t lo = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)p), needle16));
+    uint32_t hi = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + n - 16)), needle16));
+    uint32_t m = lo | (hi << (n - 16));
+    return m ? s_x_string_msb32(m) : X_STRING_NPOS;
+  }
+  for (; end >= 32; end -= 32)
+  {
+    uint32_t m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + end - 32)), needle));
+    if (m) return end - 32 + s_x_string_msb32(m);
+  }
+  if (end > 0)
+  {
+    uint32_t m = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)p), needle));
+    m &= (1u << end) - 1u;
+    if (m) return s_x_string_msb32(m);
+  }
+  return X_STRING_NPOS;
+}
+
+// Up to four bytes: one compare per byte, OR-ed
+X_CPU_TARGET("sse2") static size_t s_x_find_small_sse2(const char* p, size_t n, const uint8_t* small)
+{
+  const __m128i b0 = _mm_set1_epi8((char)small[0]);
+  const __m128i b1 = _mm_set1_epi8((char)small[1]);
+  const __m128i b2 = _mm_set1_epi8((char)small[2]);
+  const __m128i b3 = _mm_set1_epi8((char)small[3]);
+  size_t i = 0;
+  for (;;)
+  {
+    size_t base = i + 16 <= n ? i : n - 16;
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + base));
+    __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, b0), _mm_cmpeq_epi8(v, b1)),
+        _mm_or_si128(_mm_cmpeq_epi8(v, b2), _mm_cmpeq_epi8(v, b3)));
+    uint32_t m = (uint32_t)_mm_movemask_epi8(eq) & (0xFFFFu << (i - base));
+    if (m) return base + s_x_string_ctz32(m);
+    i += 16;
+    if (i >= n) return X_STRING_NPOS;
+  }
+}
+
+X_CPU_TARGET("avx2") static size_t s_x_find_small_avx2(const char* p, size_t n, const uint8_t* small)
+{
+  const __m256i b0 = _mm256_set1_epi8((char)small[0]);
+  const __m256i b1 = _mm256_set1_epi8((char)small[1]);
+  const __m256i b2 = _mm256_set1_epi8((char)small[2]);
+  const __m256i b3 = _mm256_set1_epi8((char)small[3]);
+  size_t i = 0;
+  if (n < 32)
+  {
+    const __m128i c0 = _mm256_castsi256_si128(b0), c1 = _mm256_castsi256_si128(b1);
+    const __m128i c2 = _mm256_castsi256_si128(b2), c3 = _mm256_castsi256_si128(b3);
+    __m128i a = _mm_loadu_si128((const __m128i*)p);
+    __m128i z = _mm_loadu_si128((const __m128i*)(p + n - 16));
+    uint32_t lo = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(a, c0), _mm_cmpeq_epi8(a, c1)),
+          _mm_or_si128(_mm_cmpeq_epi8(a, c2), _mm_cmpeq_epi8(a, c3))));
+    uint32_t hi = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(z, c0), _mm_cmpeq_epi8(z, c1)),
+          _mm_or_si128(_mm_cmpeq_epi8(z, c2), _mm_cmpeq_epi8(z, c3))));
+    uint32_t m = lo | (hi << (n - 16));
+    return m ? s_x_string_ctz32(m) : X_STRING_NPOS;
+  }
+  for (;;)
+  {
+    size_t base = i + 32 <= n ? i : n - 32;
+    __m256i v = _mm256_loadu_si256((const __m256i*)(p + base));
+    __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, b0), _mm256_cmpeq_epi8(v, b1)),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, b2), _mm256_cmpeq_epi8(v, b3)));
+    uint32_t m = (uint32_t)_mm256_movemask_epi8(eq) & (0xFFFFFFFFu << (i - base));
+    if (m) return base + s_x_string_ctz32(m);
+    i += 32;
+    if (i >= n) return X_STRING_NPOS;
+  }
+}
+
+// Any set with at most 8 distinct high nibbles: a byte matches when the
+// classes of its low and high nibble intersect (two table lookups)
+X_CPU_TARGET("ssse3") static size_t s_x_find_nibble_ssse3(const char* p, size_t n, const XStringByteSet* set)
+{
+  const __m128i lo_table = _mm_loadu_si128((const __m128i*)set->lo);
+  const __m128i hi_table = _mm_loadu_si128((const __m128i*)set->hi);
+  const __m128i low4 = _mm_set1_epi8(0x0F);
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (;;)
+  {
+    size_t base = i + 16 <= n ? i : n - 16;
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + base));
+    __m128i lo = _mm_shuffle_epi8(lo_table, _mm_and_si128(v, low4));
+    __m128i hi = _mm_shuffle_epi8(hi_table, _mm_and_si128(_mm_srli_epi16(v, 4), low4));
+    uint32_t miss = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), zero));
+    uint32_t m = (~miss & 0xFFFFu) & (0xFFFFu << (i - base));
+    if (m) return base + s_x_string_ctz32(m);
+    i += 16;
+    if (i >= n) return X_STRING_NPOS;
+  }
+}
+
+X_CPU_TARGET("avx2") static size_t s_x_find_nibble_avx2(const char* p, size_t n, const XStringByteSet* set)
+{
+  const __m128i lo128 = _mm_loadu_si128((const __m128i*)set->lo);
+  const __m128i hi128 = _mm_loadu_si128((const __m128i*)set->hi);
+  const __m256i lo_table = _mm256_inserti128_si256(_mm256_castsi128_si256(lo128), lo128, 1);
+  const __m256i hi_table = _mm256_inserti128_si256(_mm256_castsi128_si256(hi128), hi128, 1);
+  const __m256i low4 = _mm256_set1_epi8(0x0F);
+  const __m256i zero = _mm256_setzero_si256();
+  size_t i = 0;
+  if (n < 32)
+  {
+    const __m128i low16 = _mm256_castsi256_si128(low4);
+    const __m128i zero16 = _mm_setzero_si128();
+    __m128i a = _mm_loadu_si128((const __m128i*)p);
+    __m128i z = _mm_loadu_si128((const __m128i*)(p + n - 16));
+    __m128i ma = _mm_and_si128(_mm_shuffle_epi8(lo128, _mm_and_si128(a, low16)),
+        _mm_shuffle_epi8(hi128, _mm_and_si128(_mm_srli_epi16(a, 4), low16)));
+    __m128i mz = _mm_and_si128(_mm_shuffle_epi8(lo128, _mm_and_si128(z, low16)),
+        _mm_shuffle_epi8(hi128, _mm_and_si128(_mm_srli_epi16(z, 4), low16)));
+    uint32_t lo = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(ma, zero16)) & 0xFFFFu;
+    uint32_t hi = ~(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(mz, zero16)) & 0xFFFFu;
+    uint32_t m = lo | (hi << (n - 16));
+    return m ? s_x_string_ctz32(m) : X_STRING_NPOS;
+  }
+  for (;;)
+  {
+    size_t base = i + 32 <= n ? i : n - 32;
+    __m256i v = _mm256_loadu_si256((const __m256i*)(p + base));
+    __m256i lo = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(v, low4));
+    __m256i hi = _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), low4));
+    uint32_t miss = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(lo, hi), zero));
+    uint32_t m = ~miss & (0xFFFFFFFFu << (i - base));
+    if (m) return base + s_x_string_ctz32(m);
+    i += 32;
+    if (i >= n) return X_STRING_NPOS;
+  }
+}
+
+// Substring: candidates are positions where both the first and the last
+// byte of the needle match; only those are compared in full
+X_CPU_TARGET("sse2") static size_t s_x_find_sub_sse2(const char* p, size_t n, const char* s, size_t m)
+{
+  const __m128i first = _mm_set1_epi8(s[0]);
+  const __m128i last = _mm_set1_epi8(s[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 16 <= n; i += 16)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(p + i + m - 1));
+    uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+    while (mask)
+    {
+      size_t at = i + s_x_string_ctz32(mask);
+      if (memcmp(p + at + 1, s + 1, m - 2) == 0) return at;
+      mask &= mask - 1;
+    }
+  }
+  size_t tail = s_x_find_sub_scalar(p + i, n - i, s, m);
+  return tail == X_STRING_NPOS ? X_STRING_NPOS : i + tail;
+}
+
+X_CPU_TARGET("avx2") static size_t s_x_find_sub_avx2(const char* p, size_t n, const char* s, size_t m)
+{
+  const __m256i first = _mm256_set1_epi8(s[0]);
+  const __m256i last = _mm256_set1_epi8(s[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 32 <= n; i += 32)
+  {
+    __m256i a = _mm256_loadu_si256((const __m256i*)(p + i));
+    __m256i b = _mm256_loadu_si256((const __m256i*)(p + i + m - 1));
+    uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+    while (mask)
+    {
+      size_t at = i + s_x_string_ctz32(mask);
+      if (memcmp(p + at + 1, s + 1, m - 2) == 0) return at;
+      mask &= mask - 1;
+    }
+  }
+  size_t tail = s_x_find_sub_sse2(p + i, n - i, s, m);
+  return tail == X_STRING_NPOS ? X_STRING_NPOS : i + tail;
+}
+
+#elif X_STRING_SIMD_NEON
+
+// 4 bits per byte of a compare result, so a 64-bit scan finds the lane
+static inline uint64_t s_x_neon_mask(uint8x16_t eq)
+{
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(eq), 4)), 0);
+}
+
+static inline uint64_t s_x_neon_mask_from(uint64_t m, size_t skip)
+{
+  return skip ? m & (~0ull << (skip * 4)) : m;
+}
+
+static size_t s_x_find_byte_neon(const char* p, size_t n, char c)
+{
+  const uint8x16_t needle = vdupq_n_u8((uint8_t)c);
+  size_t i = 0;
+  for (;;)
+  {
+    size_t base = i + 16 <= n ? i : n - 16;
+    uint64_t m = s_x_neon_mask_from(s_x_neon_mask(vceqq_u8(vld1q_u8((const uint8_t*)p + base), needle)), i - base);
+    if (m) return base + ((size_t)__builtin_ctzll(m) >> 2);
+    i += 16;
+    if (i >= n) return X_STRING_NPOS;
+  }
+}
+
+static size_t s_x_rfind_byte_neon(const char* p, size_t n, char c)
+{
+  const uint8x16_t needle = vdupq_n_u8((uint8_t)c);
+  size_t end = n;
+  for (; end >= 16; end -= 16)
+  {
+    uint64_t m = s_x_neon_mask(vceqq_u8(vld1q_u8((const uint8_t*)p + end - 16), needle));
+    if (m) return end - 16 + ((size_t)(63 - __builtin_clzll(m)) >> 2);
+  }
+  if (end > 0)
+  {
+    uint64_t m = s_x_neon_mask(vceqq_u8(vld1q_u8((const uint8_t*)p), needle));
+    m &= (end * 4 >= 64) ? ~0ull : ((1ull << (end * 4)) - 1);
+    if (m) return (size_t)(63 - __builtin_clzll(m)) >> 2;
+  }
+  return X_STRING_NPOS;
+}
+
+static size_t s_x_find_small_neon(const char* p, size_t n, const uint8_t* small)
+{
+  const uint8x16_t b0 = vdupq_n_u8(small[0]);
+  const uint8x16_t b1 = vdupq_n_u8(small[1]);
+  const uint8x16_t b2 = vdupq_n_u8(small[2]);
+  const uint8x16_t b3 = vdupq_n_u8(small[3]);
+  size_t i = 0;
+  for (;;)
+  {
+    size_t base = i + 16 <= n ? i : n - 16;
+    uint8x16_t v = vld1q_u8((const uint8_t*)p + base);
+    uint8x16_t eq = vorrq_u8(vorrq_u8(vceqq_u8(v, b0), vceqq_u8(v, b1)), vorrq_u8(vceqq_u8(v, b2), vceqq_u8(v, b3)));
+    uint64_t m = s_x_neon_mask_from(s_x_neon_mask(eq), i - base);
+    if (m) return base + ((size_t)__builtin_ctzll(m) >> 2);
+    i += 16;
+    if (i >= n) return X_STRING_NPOS;
+  }
+}
+
+static size_t s_x_find_nibble_neon(const char* p, size_t n, const XStringByteSet* set)
+{
+  const uint8x16_t lo_table = vld1q_u8(set->lo);
+  const uint8x16_t hi_table = vld1q_u8(set->hi);
+  const uint8x16_t low4 = vdupq_n_u8(0x0F);
+  size_t i = 0;
+  for (;;)
+  {
+    size_t base = i + 16 <= n ? i : n - 16;
+    uint8x16_t v = vld1q_u8((const uint8_t*)p + base);
+    uint8x16_t lo = vqtbl1q_u8(lo_table, vandq_u8(v, low4));
+    uint8x16_t hi = vqtbl1q_u8(hi_table, vshrq_n_u8(v, 4));
+    uint64_t m = s_x_neon_mask_from(s_x_neon_mask(vtstq_u8(lo, hi)), i - base);
+    if (m) return base + ((size_t)__builtin_ctzll(m) >> 2);
+    i += 16;
+    if (i >= n) return X_STRING_NPOS;
+  }
+}
+
+static size_t s_x_find_sub_neon(const char* p, size_t n, const char* s, size_t m)
+{
+  const uint8x16_t first = vdupq_n_u8((uint8_t)s[0]);
+  const uint8x16_t last = vdupq_n_u8((uint8_t)s[m - 1]);
+  size_t i = 0;
+  for (; i + m - 1 + 16 <= n; i += 16)
+  {
+    uint8x16_t a = vld1q_u8((const uint8_t*)p + i);
+    uint8x16_t b = vld1q_u8((const uint8_t*)p + i + m - 1);
+    uint64_t mask = s_x_neon_mask(vandq_u8(vceqq_u8(a, first), vceqq_u8(b, last))) & 0x8888888888888888ull;
+    while (mask)
+    {
+      size_t at = i + ((size_t)__builtin_ctzll(mask) >> 2);
+      if (memcmp(p + at + 1, s + 1, m - 2) == 0) return at;
+      mask &= mask - 1;
+    }
+  }
+  size_t tail = s_x_find_sub_scalar(p + i, n - i, s, m);
+  return tail == X_STRING_NPOS ? X_STRING_NPOS : i + tail;
+}
+
+#endif
+
+typedef size_t (*XStringFindByteFn)(const char* p, size_t n, char c);
+typedef size_t (*XStringFindSmallFn)(const char* p, size_t n, const uint8_t* small);
+typedef size_t (*XStringFindSetFn)(const char* p, size_t n, const XStringByteSet* set);
+typedef size_t (*XStringFindSubFn)(const char* p, size_t n, const char* s, size_t m);
+
+#if X_STRING_SIMD_X86
+X_CPU_DISPATCH(s_x_find_byte, XStringFindByteFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_x_find_byte_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_SSE2, s_x_find_byte_sse2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_byte_scalar))
+X_CPU_DISPATCH(s_x_rfind_byte, XStringFindByteFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_x_rfind_byte_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_SSE2, s_x_rfind_byte_sse2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_rfind_byte_scalar))
+X_CPU_DISPATCH(s_x_find_small, XStringFindSmallFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_x_find_small_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_SSE2, s_x_find_small_sse2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_small_scalar))
+X_CPU_DISPATCH(s_x_find_nibble, XStringFindSetFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_x_find_nibble_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_SSSE3, s_x_find_nibble_ssse3),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_set_scalar))
+X_CPU_DISPATCH(s_x_find_sub, XStringFindSubFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_x_find_sub_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_SSE2, s_x_find_sub_sse2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_sub_scalar))
+#elif X_STRING_SIMD_NEON
+X_CPU_DISPATCH(s_x_find_byte, XStringFindByteFn,
+    X_CPU_KERNEL(CPU_FEATURE_NEON, s_x_find_byte_neon),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_byte_scalar))
+X_CPU_DISPATCH(s_x_rfind_byte, XStringFindByteFn,
+    X_CPU_KERNEL(CPU_FEATURE_NEON, s_x_rfind_byte_neon),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_rfind_byte_scalar))
+X_CPU_DISPATCH(s_x_find_small, XStringFindSmallFn,
+    X_CPU_KERNEL(CPU_FEATURE_NEON, s_x_find_small_neon),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_small_scalar))
+X_CPU_DISPATCH(s_x_find_nibble, XStringFindSetFn,
+    X_CPU_KERNEL(CPU_FEATURE_NEON, s_x_find_nibble_neon),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_set_scalar))
+X_CPU_DISPATCH(s_x_find_sub, XStringFindSubFn,
+    X_CPU_KERNEL(CPU_FEATURE_NEON, s_x_find_sub_neon),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_sub_scalar))
+#else
+X_CPU_DISPATCH(s_x_find_byte, XStringFindByteFn, X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_byte_scalar))
+X_CPU_DISPATCH(s_x_rfind_byte, XStringFindByteFn, X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_rfind_byte_scalar))
+X_CPU_DISPATCH(s_x_find_small, XStringFindSmallFn, X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_small_scalar))
+X_CPU_DISPATCH(s_x_find_nibble, XStringFindSetFn, X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_set_scalar))
+X_CPU_DISPATCH(s_x_find_sub, XStringFindSubFn, X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_find_sub_scalar))
+#endif
+
+static size_t s_x_find_set(const char* p, size_t n, const XStringByteSet* set)
+{
+  if (n < X_STRING_SIMD_MIN || set->count == 0)
+    return set->count ? s_x_find_set_scalar(p, n, set) : X_STRING_NPOS;
+  if (set->count <= 4)
+    return X_CPU_CALL(s_x_find_small)(p, n, set->small);
+  if (set->nibble)
+    return X_CPU_CALL(s_x_find_nibble)(p, n, set);
+  return s_x_find_set_scalar(p, n, set);
+}
+
+// ' ', '\t', '\r' padded to four, as s_char_is_white_space() sees it
+static const uint8_t s_x_white_space_set[4] = { ' ', '\t', '\r', ' ' };
+
+// The first X_STRING_SIMD_MIN bytes are checked one at a time before the
+// kernels run: tokenizers mostly stop within a short field of a long input,
+// where setting up the vectors costs more than the scan it saves.
+
 X_STRING_API int32_t x_slice_find(XSlice sv, char c)
 {
-  for (size_t i = 0; i < sv.length; i++)
+  size_t head = sv.length < X_STRING_SIMD_MIN ? sv.length : X_STRING_SIMD_MIN;
+  for (size_t i = 0; i < head; i++)
   {
     if (sv.ptr[i] == c) return (int)i;
   }
-  return -1;
+  if (head == sv.length)
+    return -1;
+  size_t at = X_CPU_CALL(s_x_find_byte)(sv.ptr, sv.length, c);
+  return at == X_STRING_NPOS ? -1 : (int32_t)at;
 }
 
 X_STRING_API int32_t x_slice_find_white_space(XSlice sv)
 {
-  for (size_t i = 0; i < sv.length; i++)
+  size_t head = sv.length < X_STRING_SIMD_MIN ? sv.length : X_STRING_SIMD_MIN;
+  for (size_t i = 0; i < head; i++)
   {
     if ( sv.ptr[i] == ' ' ||
         sv.ptr[i] == '\t' ||
         sv.ptr[i] == '\r'
        ) return (int)i;
   }
-  return -1;
+  if (head == sv.length)
+    return -1;
+  size_t at = X_CPU_CALL(s_x_find_small)(sv.ptr, sv.length, s_x_white_space_set);
+  return at == X_STRING_NPOS ? -1 : (int32_t)at;
+}
+
+X_STRING_API int32_t x_slice_find_any(XSlice sv, const char* set)
+{
+  XStringByteSet bytes;
+  if (!set || !sv.ptr)
+    return -1;
+  s_x_string_byteset_init(&bytes, (const uint8_t*)set, strlen(set));
+  size_t at = s_x_find_set(sv.ptr, sv.length, &bytes);
+  return at == X_STRING_NPOS ? -1 : (int32_t)at;
+}
+
+X_STRING_API int32_t x_slice_find_slice(XSlice sv, XSlice needle)
+{
+  if (needle.length == 0)
+    return 0;
+  if (needle.length > sv.length)
+    return -1;
+  if (needle.length == 1)
+    return x_slice_find(sv, needle.ptr[0]);
+  size_t at = sv.length < X_STRING_SIMD_MIN
+    ? s_x_find_sub_scalar(sv.ptr, sv.length, needle.ptr, needle.length)
+    : X_CPU_CALL(s_x_find_sub)(sv.ptr, sv.length, needle.ptr, needle.length);
+  return at == X_STRING_NPOS ? -1 : (int32_t)at;
 }
 
 X_STRING_API int32_t x_slice_rfind(XSlice sv, char c)
 {
-  for (size_t i = sv.length; i > 0; i--)
+  size_t tail = sv.length < X_STRING_SIMD_MIN ? 0 : sv.length - X_STRING_SIMD_MIN;
+  for (size_t i = sv.length; i > tail; i--)
   {
     if (sv.ptr[i - 1] == c) return (int)(i - 1);
   }
-  return -1;
+  if (tail == 0)
+    return -1;
+  size_t at = X_CPU_CALL(s_x_rfind_byte)(sv.ptr, sv.length, c);
+  return at == X_STRING_NPOS ? -1 : (int32_t)at;
+}
+
+//---------------------------------------------------------------------------
+// UTF-8 kernels
+//
+// Validation follows the lookup algorithm of Keiser and Lemire ("Validating
+// UTF-8 In Less Than One Instruction Per Byte"): three 16-entry tables
+// indexed by the nibbles of each byte and the byte before it flag every
+// error that a two-byte window can see; a saturating compare catches the
+// missing continuations of 3 and 4 byte sequences.
+//---------------------------------------------------------------------------
+
+#define X_UTF8_TOO_SHORT      0x01
+#define X_UTF8_TOO_LONG       0x02
+#define X_UTF8_OVERLONG_3     0x04
+#define X_UTF8_TOO_LARGE      0x08
+#define X_UTF8_SURROGATE      0x10
+#define X_UTF8_OVERLONG_2     0x20
+#define X_UTF8_TOO_LARGE_1000 0x40
+#define X_UTF8_OVERLONG_4     0x40
+#define X_UTF8_TWO_CONTS      0x80
+#define X_UTF8_CARRY          (X_UTF8_TOO_SHORT | X_UTF8_TOO_LONG | X_UTF8_TWO_CONTS)
+
+// High nibble of the previous byte
+static const uint8_t s_x_utf8_byte1_high[16] =
+{
+  X_UTF8_TOO_LONG, X_UTF8_TOO_LONG, X_UTF8_TOO_LONG, X_UTF8_TOO_LONG,
+  X_UTF8_TOO_LONG, X_UTF8_TOO_LONG, X_UTF8_TOO_LONG, X_UTF8_TOO_LONG,
+  X_UTF8_TWO_CONTS, X_UTF8_TWO_CONTS, X_UTF8_TWO_CONTS, X_UTF8_TWO_CONTS,
+  X_UTF8_TOO_SHORT | X_UTF8_OVERLONG_2,
+  X_UTF8_TOO_SHORT,
+  X_UTF8_TOO_SHORT | X_UTF8_OVERLONG_3 | X_UTF8_SURROGATE,
+  X_UTF8_TOO_SHORT | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000 | X_UTF8_OVERLONG_4
+};
+
+// Low nibble of the previous byte
+static const uint8_t s_x_utf8_byte1_low[16] =
+{
+  X_UTF8_CARRY | X_UTF8_OVERLONG_3 | X_UTF8_OVERLONG_2 | X_UTF8_OVERLONG_4,
+  X_UTF8_CARRY | X_UTF8_OVERLONG_2,
+  X_UTF8_CARRY,
+  X_UTF8_CARRY,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000 | X_UTF8_SURROGATE,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000,
+  X_UTF8_CARRY | X_UTF8_TOO_LARGE | X_UTF8_TOO_LARGE_1000
+};
+
+// High nibble of the current byte
+static const uint8_t s_x_utf8_byte2_high[16] =
+{
+  X_UTF8_TOO_SHORT, X_UTF8_TOO_SHORT, X_UTF8_TOO_SHORT, X_UTF8_TOO_SHORT,
+  X_UTF8_TOO_SHORT, X_UTF8_TOO_SHORT, X_UTF8_TOO_SHORT, X_UTF8_TOO_SHORT,
+  X_UTF8_TOO_LONG | X_UTF8_OVERLONG_2 | X_UTF8_TWO_CONTS | X_UTF8_OVERLONG_3 | X_UTF8_TOO_LARGE_1000 | X_UTF8_OVERLONG_4,
+  X_UTF8_TOO_LONG | X_UTF8_OVERLONG_2 | X_UTF8_TWO_CONTS | X_UTF8_OVERLONG_3 | X_UTF8_TOO_LARGE,
+  X_UTF8_TOO_LONG | X_UTF8_OVERLONG_2 | X_UTF8_TWO_CONTS | X_UTF8_SURROGATE | X_UTF8_TOO_LARGE,
+  X_UTF8_TOO_LONG | X_UTF8_OVERLONG_2 | X_UTF8_TWO_CONTS | X_UTF8_SURROGATE | X_UTF8_TOO_LARGE,
+  X_UTF8_TOO_SHORT, X_UTF8_TOO_SHORT, X_UTF8_TOO_SHORT, X_UTF8_TOO_SHORT
+};
+
+// Lead bytes that need more bytes than are left in a 16-byte block,
+// as thresholds for a saturating subtract
+static const uint8_t s_x_utf8_incomplete[16] =
+{
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+};
+
+static size_t s_x_utf8_ascii_prefix_scalar(const char* p, size_t n)
+{
+  size_t i = 0;
+  while (i + 8 <= n && s_x_utf8_is_ascii_word(p + i))
+    i += 8;
+  while (i < n && (uint8_t)p[i] < 0x80)
+    i++;
+  return i;
+}
+
+// Length of the valid prefix: utf8_decode() over the non-ASCII parts
+static size_t s_x_utf8_valid_prefix_scalar(const char* p, size_t n)
+{
+  const char* end = p + n;
+  const char* s = p;
+  while (s < end)
+  {
+    s += s_x_utf8_ascii_prefix_scalar(s, (size_t)(end - s));
+    if (s == end)
+      break;
+    const char* at = s;
+    if (utf8_decode(&s, end) < 0)
+      return (size_t)(at - p);
+  }
+  return n;
+}
+
+static bool s_x_utf8_validate_scalar(const char* p, size_t n)
+{
+  return s_x_utf8_valid_prefix_scalar(p, n) == n;
+}
+
+static size_t s_x_utf8_count_scalar(const char* p, size_t n)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++)
+    count += ((uint8_t)p[i] & 0xC0) != 0x80;
+  return count;
+}
+
+static size_t s_x_ascii_widen_scalar(const char* p, size_t n, uint16_t* out)
+{
+  size_t i = 0;
+  for (; i < n && (uint8_t)p[i] < 0x80; i++)
+    out[i] = (uint16_t)p[i];
+  return i;
+}
+
+static size_t s_x_ascii_narrow_scalar(const uint16_t* p, size_t n, char* out)
+{
+  size_t i = 0;
+  for (; i < n && p[i] < 0x80; i++)
+    out[i] = (char)p[i];
+  return i;
+}
+
+#if X_STRING_SIMD_X86
+
+X_CPU_TARGET("ssse3") static inline __m128i s_x_utf8_block_ssse3(__m128i v, __m128i prev, __m128i* incomplete)
+{
+  const __m128i low4 = _mm_set1_epi8(0x0F);
+  if (_mm_movemask_epi8(v) == 0)
+  {
+    // An ASCII block is only wrong when the last one left a sequence open
+    __m128i err = *incomplete;
+    *incomplete = _mm_setzero_si128();
+    return err;
+  }
+  __m128i prev1 = _mm_alignr_epi8(v, prev, 15);
+  __m128i b1h = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)s_x_utf8_byte1_high), _mm_and_si128(_mm_srli_epi16(prev1, 4), low4));
+  __m128i b1l = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)s_x_utf8_byte1_low), _mm_and_si128(prev1, low4));
+  __m128i b2h = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)s_x_utf8_byte2_high), _mm_and_si128(_mm_srli_epi16(v, 4), low4));
+  __m128i special = _mm_and_si128(_mm_and_si128(b1h, b1l), b2h);
+  __m128i third = _mm_subs_epu8(_mm_alignr_epi8(v, prev, 14), _mm_set1_epi8((char)(0xE0 - 0x80)));
+  __m128i fourth = _mm_subs_epu8(_mm_alignr_epi8(v, prev, 13), _mm_set1_epi8((char)(0xF0 - 0x80)));
+  __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8((char)0x80));
+  *incomplete = _mm_subs_epu8(v, _mm_loadu_si128((const __m128i*)s_x_utf8_incomplete));
+  return _mm_xor_si128(must23, special);
+}
+
+X_CPU_TARGET("ssse3") static bool s_x_utf8_validate_ssse3(const char* p, size_t n)
+{
+  __m128i error = _mm_setzero_si128();
+  __m128i prev = _mm_setzero_si128();
+  __m128i incomplete = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+    error = _mm_or_si128(error, s_x_utf8_block_ssse3(v, prev, &incomplete));
+    prev = v;
+  }
+  if (i < n)
+  {
+    // Zero padding reads as ASCII, so a truncated sequence fails as too short
+    uint8_t tail[16] = { 0 };
+    memcpy(tail, p + i, n - i);
+    error = _mm_or_si128(error, s_x_utf8_block_ssse3(_mm_loadu_si128((const __m128i*)tail), prev, &incomplete));
+  }
+  error = _mm_or_si128(error, incomplete);
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+X_CPU_TARGET("avx2") static inline __m256i s_x_utf8_block_avx2(__m256i v, __m256i prev, __m256i* incomplete)
+{
+  const __m256i low4 = _mm256_set1_epi8(0x0F);
+  if (_mm256_movemask_epi8(v) == 0)
+  {
+    __m256i err = *incomplete;
+    *incomplete = _mm256_setzero_si256();
+    return err;
+  }
+  const __m128i t1 = _mm_loadu_si128((const __m128i*)s_x_utf8_byte1_high);
+  const __m128i t2 = _mm_loadu_si128((const __m128i*)s_x_utf8_byte1_low);
+  const __m128i t3 = _mm_loadu_si128((const __m128i*)s_x_utf8_byte2_high);
+  const __m128i t4 = _mm_loadu_si128((const __m128i*)s_x_utf8_incomplete);
+  // Halves are shifted independently by alignr, so stitch the previous
+  // block's upper half in front of this block's lower half first
+  __m256i shifted = _mm256_permute2x128_si256(prev, v, 0x21);
+  __m256i prev1 = _mm256_alignr_epi8(v, shifted, 15);
+  __m256i b1h = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(t1), _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low4));
+  __m256i b1l = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(t2), _mm256_and_si256(prev1, low4));
+  __m256i b2h = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(t3), _mm256_and_si256(_mm256_srli_epi16(v, 4), low4));
+  __m256i special = _mm256_and_si256(_mm256_and_si256(b1h, b1l), b2h);
+  __m256i third = _mm256_subs_epu8(_mm256_alignr_epi8(v, shifted, 14), _mm256_set1_epi8((char)(0xE0 - 0x80)));
+  __m256i fourth = _mm256_subs_epu8(_mm256_alignr_epi8(v, shifted, 13), _mm256_set1_epi8((char)(0xF0 - 0x80)));
+  __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+  // The incomplete thresholds only apply to the last three bytes of the upper half
+  __m256i max = _mm256_inserti128_si256(_mm256_set1_epi8((char)0xFF), t4, 1);
+  *incomplete = _mm256_subs_epu8(v, max);
+  return _mm256_xor_si256(must23, special);
+}
+
+X_CPU_TARGET("avx2") static bool s_x_utf8_validate_avx2(const char* p, size_t n)
+{
+  __m256i error = _mm256_setzero_si256();
+  __m256i prev = _mm256_setzero_si256();
+  __m256i incomplete = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+    error = _mm256_or_si256(error, s_x_utf8_block_avx2(v, prev, &incomplete));
+    prev = v;
+  }
+  if (i < n)
+  {
+    uint8_t tail[32] = { 0 };
+    memcpy(tail, p + i, n - i);
+    error = _mm256_or_si256(error, s_x_utf8_block_avx2(_mm256_loadu_si256((const __m256i*)tail), prev, &incomplete));
+  }
+  error = _mm256_or_si256(error, incomplete);
+  return _mm256_testz_si256(error, error) != 0;
+}
+
+// Counts bytes that are not continuations (signed > -65): one per code point.
+// Byte lanes count up to 255 blocks before they are summed with psadbw.
+X_CPU_TARGET("sse2") static size_t s_x_utf8_count_sse2(const char* p, size_t n)
+{
+  const __m128i cont = _mm_set1_epi8(-65);
+  size_t count = 0;
+  size_t i = 0;
+  while (i + 16 <= n)
+  {
+    __m128i acc = _mm_setzero_si128();
+    size_t blocks = (n - i) / 16;
+    if (blocks > 255) blocks = 255;
+    for (size_t b = 0; b < blocks; b++, i += 16)
+      acc = _mm_sub_epi8(acc, _mm_cmpgt_epi8(_mm_loadu_si128((const __m128i*)(p + i)), cont));
+    __m128i sum = _mm_sad_epu8(acc, _mm_setzero_si128());
+    count += (size_t)_mm_cvtsi128_si32(sum) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+  }
+  return count + s_x_utf8_count_scalar(p + i, n - i);
+}
+
+X_CPU_TARGET("avx2") static size_t s_x_utf8_count_avx2(const char* p, size_t n)
+{
+  const __m256i cont = _mm256_set1_epi8(-65);
+  size_t count = 0;
+  size_t i = 0;
+  while (i + 32 <= n)
+  {
+    __m256i acc = _mm256_setzero_si256();
+    size_t blocks = (n - i) / 32;
+    if (blocks > 255) blocks = 255;
+    for (size_t b = 0; b < blocks; b++, i += 32)
+      acc = _mm256_sub_epi8(acc, _mm256_cmpgt_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), cont));
+    __m256i sum256 = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+    __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(sum256), _mm256_extracti128_si256(sum256, 1));
+    count += (size_t)_mm_cvtsi128_si32(sum) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+  }
+  return count + s_x_utf8_count_scalar(p + i, n - i);
+}
+
+X_CPU_TARGET("sse2") static size_t s_x_ascii_widen_sse2(const char* p, size_t n, uint16_t* out)
+{
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+    if (_mm_movemask_epi8(v))
+      break;
+    _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(v, zero));
+    _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(v, zero));
+  }
+  return i + s_x_ascii_widen_scalar(p + i, n - i, out + i);
+}
+
+X_CPU_TARGET("sse2") static size_t s_x_ascii_narrow_sse2(const uint16_t* p, size_t n, char* out)
+{
+  const __m128i high = _mm_set1_epi16((short)0xFF80);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i*)(p + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(p + i + 8));
+    if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(a, b), high), _mm_setzero_si128())) != 0xFFFF)
+      break;
+    _mm_storeu_si128((__m128i*)(out + i), _mm_packus_epi16(a, b));
+  }
+  return i + s_x_ascii_narrow_scalar(p + i, n - i, out + i);
+}
+
+#elif X_STRING_SIMD_NEON
+
+static inline uint8x16_t s_x_utf8_block_neon(uint8x16_t v, uint8x16_t prev, uint8x16_t* incomplete)
+{
+  const uint8x16_t low4 = vdupq_n_u8(0x0F);
+  if (vmaxvq_u8(v) < 0x80)
+  {
+    uint8x16_t err = *incomplete;
+    *incomplete = vdupq_n_u8(0);
+    return err;
+  }
+  uint8x16_t prev1 = vextq_u8(prev, v, 15);
+  uint8x16_t b1h = vqtbl1q_u8(vld1q_u8(s_x_utf8_byte1_high), vshrq_n_u8(prev1, 4));
+  uint8x16_t b1l = vqtbl1q_u8(vld1q_u8(s_x_utf8_byte1_low), vandq_u8(prev1, low4));
+  uint8x16_t b2h = vqtbl1q_u8(vld1q_u8(s_x_utf8_byte2_high), vshrq_n_u8(v, 4));
+  uint8x16_t special = vandq_u8(vandq_u8(b1h, b1l), b2h);
+  uint8x16_t third = vqsubq_u8(vextq_u8(prev, v, 14), vdupq_n_u8(0xE0 - 0x80));
+  uint8x16_t fourth = vqsubq_u8(vextq_u8(prev, v, 13), vdupq_n_u8(0xF0 - 0x80));
+  uint8x16_t must23 = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+  *incomplete = vqsubq_u8(v, vld1q_u8(s_x_utf8_incomplete));
+  return veorq_u8(must23, special);
+}
+
+static bool s_x_utf8_validate_neon(const char* p, size_t n)
+{
+  uint8x16_t error = vdupq_n_u8(0);
+  uint8x16_t prev = vdupq_n_u8(0);
+  uint8x16_t incomplete = vdupq_n_u8(0);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    uint8x16_t v = vld1q_u8((const uint8_t*)p + i);
+    error = vorrq_u8(error, s_x_utf8_block_neon(v, prev, &incomplete));
+    prev = v;
+  }
+  if (i < n)
+  {
+    uint8_t tail[16] = { 0 };
+    memcpy(tail, p + i, n - i);
+    error = vorrq_u8(error, s_x_utf8_block_neon(vld1q_u8(tail), prev, &incomplete));
+  }
+  error = vorrq_u8(error, incomplete);
+  return vmaxvq_u8(error) == 0;
+}
+
+static size_t s_x_utf8_count_neon(const char* p, size_t n)
+{
+  const int8x16_t cont = vdupq_n_s8(-65);
+  size_t count = 0;
+  size_t i = 0;
+  while (i + 16 <= n)
+  {
+    uint8x16_t acc = vdupq_n_u8(0);
+    size_t blocks = (n - i) / 16;
+    if (blocks > 255) blocks = 255;
+    for (size_t b = 0; b < blocks; b++, i += 16)
+      acc = vsubq_u8(acc, vcgtq_s8(vld1q_s8((const int8_t*)p + i), cont));
+    count += vaddlvq_u8(acc);
+  }
+  return count + s_x_utf8_count_scalar(p + i, n - i);
+}
+
+static size_t s_x_ascii_widen_neon(const char* p, size_t n, uint16_t* out)
+{
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    uint8x16_t v = vld1q_u8((const uint8_t*)p + i);
+    if (vmaxvq_u8(v) >= 0x80)
+      break;
+    vst1q_u16(out + i, vmovl_u8(vget_low_u8(v)));
+    vst1q_u16(out + i + 8, vmovl_u8(vget_high_u8(v)));
+  }
+  return i + s_x_ascii_widen_scalar(p + i, n - i, out + i);
+}
+
+static size_t s_x_ascii_narrow_neon(const uint16_t* p, size_t n, char* out)
+{
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    uint16x8_t a = vld1q_u16(p + i);
+    uint16x8_t b = vld1q_u16(p + i + 8);
+    if (vmaxvq_u16(vorrq_u16(a, b)) >= 0x80)
+      break;
+    vst1q_u8((uint8_t*)out + i, vcombine_u8(vmovn_u16(a), vmovn_u16(b)));
+  }
+  return i + s_x_ascii_narrow_scalar(p + i, n - i, out + i);
+}
+
+#endif
+
+typedef bool (*XStringUtf8ValidateFn)(const char* p, size_t n);
+typedef size_t (*XStringUtf8CountFn)(const char* p, size_t n);
+typedef size_t (*XStringAsciiWidenFn)(const char* p, size_t n, uint16_t* out);
+typedef size_t (*XStringAsciiNarrowFn)(const uint16_t* p, size_t n, char* out);
+
+#if X_STRING_SIMD_X86
+X_CPU_DISPATCH(s_x_utf8_validate, XStringUtf8ValidateFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_x_utf8_validate_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_SSSE3, s_x_utf8_validate_ssse3),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_utf8_validate_scalar))
+X_CPU_DISPATCH(s_x_utf8_count, XStringUtf8CountFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX2, s_x_utf8_count_avx2),
+    X_CPU_KERNEL(CPU_FEATURE_SSE2, s_x_utf8_count_sse2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_utf8_count_scalar))
+X_CPU_DISPATCH(s_x_ascii_widen, XStringAsciiWidenFn,
+    X_CPU_KERNEL(CPU_FEATURE_SSE2, s_x_ascii_widen_sse2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_ascii_widen_scalar))
+X_CPU_DISPATCH(s_x_ascii_narrow, XStringAsciiNarrowFn,
+    X_CPU_KERNEL(CPU_FEATURE_SSE2, s_x_ascii_narrow_sse2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_ascii_narrow_scalar))
+#elif X_STRING_SIMD_NEON
+X_CPU_DISPATCH(s_x_utf8_validate, XStringUtf8ValidateFn,
+    X_CPU_KERNEL(CPU_FEATURE_NEON, s_x_utf8_validate_neon),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_utf8_validate_scalar))
+X_CPU_DISPATCH(s_x_utf8_count, XStringUtf8CountFn,
+    X_CPU_KERNEL(CPU_FEATURE_NEON, s_x_utf8_count_neon),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_utf8_count_scalar))
+X_CPU_DISPATCH(s_x_ascii_widen, XStringAsciiWidenFn,
+    X_CPU_KERNEL(CPU_FEATURE_NEON, s_x_ascii_widen_neon),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_ascii_widen_scalar))
+X_CPU_DISPATCH(s_x_ascii_narrow, XStringAsciiNarrowFn,
+    X_CPU_KERNEL(CPU_FEATURE_NEON, s_x_ascii_narrow_neon),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_ascii_narrow_scalar))
+#else
+X_CPU_DISPATCH(s_x_utf8_validate, XStringUtf8ValidateFn, X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_utf8_validate_scalar))
+X_CPU_DISPATCH(s_x_utf8_count, XStringUtf8CountFn, X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_utf8_count_scalar))
+X_CPU_DISPATCH(s_x_ascii_widen, XStringAsciiWidenFn, X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_ascii_widen_scalar))
+X_CPU_DISPATCH(s_x_ascii_narrow, XStringAsciiNarrowFn, X_CPU_KERNEL(CPU_FEATURE_NONE, s_x_ascii_narrow_scalar))
+#endif
+
+X_STRING_API bool x_utf8_validate(const char* utf8, size_t length, size_t* out_valid_length)
+{
+  if (!utf8)
+  {
+    if (out_valid_length) *out_valid_length = 0;
+    return length == 0;
+  }
+  bool valid = length < X_STRING_SIMD_MIN
+    ? s_x_utf8_validate_scalar(utf8, length)
+    : X_CPU_CALL(s_x_utf8_validate)(utf8, length);
+  if (out_valid_length)
+  {
+    // Only failures pay for locating the error
+    *out_valid_length = valid ? length : s_x_utf8_valid_prefix_scalar(utf8, length);
+  }
+  return valid;
+}
+
+X_STRING_API size_t x_utf8_count(const char* utf8, size_t length)
+{
+  if (!utf8)
+    return 0;
+  return length < X_STRING_SIMD_MIN
+    ? s_x_utf8_count_scalar(utf8, length)
+    : X_CPU_CALL(s_x_utf8_count)(utf8, length);
+}
+
+X_STRING_API bool x_utf8_is_ascii(const char* utf8, size_t length)
+{
+  return utf8 ? s_x_utf8_ascii_prefix_scalar(utf8, length) == length : length == 0;
+}
+
+X_STRING_API size_t x_utf8_strlen(const char* utf8)
+{
+  size_t length = strlen(utf8);
+  if (length >= X_STRING_SIMD_MIN && X_CPU_CALL(s_x_utf8_validate)(utf8, length))
+    return X_CPU_CALL(s_x_utf8_count)(utf8, length);
+
+  // Short or invalid: step by lead bytes, stopping at the first invalid one
+  const char* end = utf8 + length;
+  size_t count = 0;
+  while (utf8 < end)
+  {
+    char c = (char)*utf8;
+    if ((c & 0x80) == 0x00) utf8 += 1;
+    else if ((c & 0xE0) == 0xC0) utf8 += 2;
+    else if ((c & 0xF0) == 0xE0) utf8 += 3;
+    else if ((c & 0xF8) == 0xF0) utf8 += 4;
+    else break;
+    count++;
+  }
+  return count;
+}
+
+X_STRING_API size_t x_utf8_to_utf16(const char* utf8, size_t length, uint16_t* utf16, size_t max)
+{
+  if (!utf8 || (utf16 && max == 0))
+    return utf8 ? 0 : (size_t)-1;
+
+  const char* p = utf8;
+  const char* end = utf8 + length;
+  size_t cap = utf16 ? max - 1 : (size_t)-1;
+  size_t out = 0;
+  while (p < end)
+  {
+    if ((uint8_t)*p < 0x80)
+    {
+      size_t run = (size_t)(end - p);
+      if (run > cap - out) run = cap - out;
+      size_t done = utf16
+        ? X_CPU_CALL(s_x_ascii_widen)(p, run, utf16 + out)
+        : s_x_utf8_ascii_prefix_scalar(p, run);
+      p += done;
+      out += done;
+      if (p == end || out == cap)
+        break;
+    }
+
+    const char* at = p;
+    int32_t cp = utf8_decode(&p, end);
+    if (cp < 0)
+    {
+      if (utf16) utf16[0] = 0;
+      return (size_t)-1;
+    }
+    size_t units = cp >= 0x10000 ? 2 : 1;
+    if (out + units > cap)
+    {
+      p = at;
+      break;
+    }
+    if (utf16)
+    {
+      if (units == 1)
+        utf16[out] = (uint16_t)cp;
+      else
+      {
+        cp -= 0x10000;
+        utf16[out] = (uint16_t)(0xD800 + (cp >> 10));
+        utf16[out + 1] = (uint16_t)(0xDC00 + (cp & 0x3FF));
+      }
+    }
+    out += units;
+  }
+  if (utf16)
+    utf16[out] = 0;
+  return out;
+}
+
+X_STRING_API size_t x_utf16_to_utf8(const uint16_t* utf16, size_t length, char* utf8, size_t max)
+{
+  if (!utf16 || (utf8 && max == 0))
+    return utf16 ? 0 : (size_t)-1;
+
+  size_t cap = utf8 ? max - 1 : (size_t)-1;
+  size_t out = 0;
+  size_t i = 0;
+  while (i < length)
+  {
+    if (utf8 && utf16[i] < 0x80)
+    {
+      size_t run = length - i;
+      if (run > cap - out) run = cap - out;
+      size_t done = X_CPU_CALL(s_x_ascii_narrow)(utf16 + i, run, utf8 + out);
+      i += done;
+      out += done;
+      if (i == length || out == cap)
+        break;
+    }
+
+    uint32_t cp = utf16[i];
+    size_t used = 1;
+    if (cp >= 0xD800 && cp <= 0xDFFF)
+    {
+      if (cp > 0xDBFF || i + 1 >= length || utf16[i + 1] < 0xDC00 || utf16[i + 1] > 0xDFFF)
+      {
+        if (utf8) utf8[0] = 0;
+        return (size_t)-1;
+      }
+      cp = 0x10000 + ((cp - 0xD800) << 10) + (uint32_t)(utf16[i + 1] - 0xDC00);
+      used = 2;
+    }
+    size_t bytes = cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+    if (out + bytes > cap)
+      break;
+    if (utf8)
+    {
+      char* d = utf8 + out;
+      switch (bytes)
+      {
+        case 1: d[0] = (char)cp; break;
+        case 2: d[0] = (char)(0xC0 | (cp >> 6)); d[1] = (char)(0x80 | (cp & 0x3F)); break;
+        case 3: d[0] = (char)(0xE0 | (cp >> 12)); d[1] = (char)(0x80 | ((cp >> 6) & 0x3F)); d[2] = (char)(0x80 | (cp & 0x3F)); break;
+        default: d[0] = (char)(0xF0 | (cp >> 18)); d[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                 d[2] = (char)(0x80 | ((cp >> 6) & 0x3F)); d[3] = (char)(0x80 | (cp & 0x3F)); break;
+      }
+    }
+    out += bytes;
+    i += used;
+  }
+  if (utf8)
+    utf8[out] = 0;
+  return out;
+}
+
+X_STRING_API bool x_slice_utf8_is_valid(XSlice sv)
+{
+  return x_utf8_validate(sv.ptr, sv.length, NULL);
 }
 
 X_STRING_API bool x_slice_split_at(XSlice sv, char delim, XSlice* left, XSlice* right)
@@ -1839,7 +3122,7 @@ X_STRING_API bool x_slice_split_at(XSlice sv, char delim, XSlice* left, XSlice*
   return true;
 }
 
-static bool inline s_char_is_white_space(char c)
+static inline bool s_char_is_white_space(char c)
 {
   return ( c == ' ' || c == '\t' || c == '\r');
 }
@@ -2290,6 +3573,11 @@ X_STRING_API bool x_smallstr_try_append_cstr(XSmallstr* s, const char* cstr, siz
   return to_copy > 0u;
 }
 
+#ifdef X_INTERNAL_CPUID_IMPL
+#undef X_IMPL_CPUID
+#undef X_INTERNAL_CPUID_IMPL
+#endif
+
 #endif // X_IMPL_STRING
 #endif // X_STRING_H
 
@@ -9,6 +9,7 @@
  * - Lightweight, self-contained C test runner
  * - Colored PASS/FAIL output using x_log
  * - Assertion macros for booleans, equality, floats
+ * - Counting XAllocator for checking that containers return their memory
  * - Signal handling for crash diagnostics (SIGSEGV, SIGABRT, etc.)
  *
  * ## How to compile
@@ -41,6 +42,7 @@
  *
  * ## Dependencies
  *
+ * stdx_common.h
  * x_log.h
  */
 #ifndef X_TEST_H
@@ -71,7 +73,9 @@ extern "C" {
 #endif
 #endif
 #include "stdx_time.h"
+#include "stdx_common.h"
 
+#include <stddef.h>
 #include <stdint.h>
 #include <math.h>
 
@@ -170,6 +174,23 @@ typedef struct
   XLogger* x_test_logger(void);
   int x_tests_run(STDXTestCase* tests, int32_t num_tests, XLogger* logger);
 
+  /**
+   * Traffic seen by an allocator from x_test_allocator(), so tests can check
+   * that every allocation is returned.
+   */
+  typedef struct XTestAllocStats
+  {
+    size_t live;    // bytes currently allocated
+    size_t allocs;  // alloc and realloc calls
+  } XTestAllocStats;
+
+  /**
+   * @brief Allocator backed by malloc that records its traffic.
+   * @param stats Counters to update. Must outlive the allocator.
+   * @return Allocator for the *_with_allocator constructors.
+   */
+  XAllocator x_test_allocator(XTestAllocStats* stats);
+
 #ifdef __cplusplus
 }
 #endif
@@ -177,6 +198,7 @@ typedef struct
 #ifdef X_IMPL_TEST
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <signal.h>
 
 #ifdef _WIN32
@@ -280,6 +302,40 @@ extern "C" {
     return passed != num_tests;
   }
 
+  static void* s_test_alloc(void* user, size_t size)
+  {
+    XTestAllocStats* stats = (XTestAllocStats*)user;
+    stats->live += size;
+    stats->allocs++;
+    return malloc(size);
+  }
+
+  static void* s_test_realloc(void* user, void* ptr, size_t old_size, size_t new_size)
+  {
+    XTestAllocStats* stats = (XTestAllocStats*)user;
+    stats->live += new_size;
+    stats->live -= (ptr ? old_size : 0);
+    stats->allocs++;
+    return realloc(ptr, new_size);
+  }
+
+  static void s_test_free(void* user, void* ptr, size_t size)
+  {
+    XTestAllocStats* stats = (XTestAllocStats*)user;
+    stats->live -= size;
+    free(ptr);
+  }
+
+  XAllocator x_test_allocator(XTestAllocStats* stats)
+  {
+    XAllocator a;
+    a.alloc_fn = s_test_alloc;
+    a.realloc_fn = s_test_realloc;
+    a.free_fn = s_test_free;
+    a.user = stats;
+    return a;
+  }
+
 #ifdef __cplusplus
 }
 #endif
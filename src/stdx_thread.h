@@ -12,8 +12,53 @@
  * - Thread creation and joining
  * - Mutexes and condition variables
  * - Sleep/yield utilities
+ * - CPU affinity (see stdx_cpuid.h for XCPUSet and the CPU topology)
+ * - Atomic operations and thread-local storage
  * - A thread pool for concurrent task execution
  *
+ * ## Thread pool modes
+ *
+ * `x_threadpool_create()` starts a pool where every worker pulls tasks from
+ * a single shared queue protected by one mutex.
+ *
+ * `x_threadpool_create_ex()` can instead create a work-stealing pool
+ * (`XTHREADPOOL_MODE_WORK_STEALING`). Each worker owns a lock-free deque:
+ * tasks enqueued from inside a worker go to that worker's deque, idle
+ * workers steal from the other deques, and tasks enqueued from outside the
+ * pool go through a shared injection queue. This removes the global lock
+ * from the hot path when tasks are short and spawn more tasks.
+ *
+ * ## Task allocation
+ *
+ * `x_threadpool_enqueue()` takes task nodes from a free list owned by the
+ * pool. Nodes are carved from blocks of `X_THREADPOOL_TASK_BLOCK` tasks and
+ * recycled when the task completes, so steady-state submission does not
+ * call the allocator. Work-stealing workers keep a small private cache of
+ * nodes and only touch the shared free list in batches.
+ *
+ * `x_threadpool_submit()` skips allocation entirely: the caller embeds an
+ * `XTask` in its own struct, initializes it with `x_task_init()` and keeps
+ * it alive until the task function runs. The pool never touches an
+ * intrusive task after calling its function, so the function may free or
+ * resubmit the node.
+ *
+ * ## Task groups and parallel_for
+ *
+ * An `XTaskGroup` counts the tasks submitted through it. `x_taskgroup_wait()`
+ * runs queued pool tasks on the calling thread until the count reaches zero
+ * and only blocks when there is nothing left to help with, so it is safe to
+ * wait on a group from inside a pool task.
+ *
+ *     XTaskGroup group;
+ *     x_taskgroup_init(&group, pool);
+ *     for (int i = 0; i < count; ++i)
+ *       x_taskgroup_run(&group, process_file, &files[i]);
+ *     x_taskgroup_wait(&group);
+ *
+ * `x_threadpool_parallel_for()` is built on top of a task group: it splits a
+ * range into chunks that pool workers and the calling thread pick up until
+ * the range is exhausted, then joins.
+ *
  * ## How to compile
  *
  * To compile the implementation define `X_IMPL_THREAD`
@@ -22,12 +67,21 @@
  * To customize how this module allocates memory, define
  * `X_THREAD_ALLOC` / `X_THREAD_FREE` before including.
  *
+ * Define `X_PROFILE_LIBRARY` as well to time every pool task and
+ * parallel_for range with stdx_profile.
+ *
  */
 
 #ifndef X_THREAD_H
 #define X_THREAD_H
 
 #include <stdint.h>
+#include <stdbool.h>
+#include "stdx_cpuid.h"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 #define X_THREADING_VERSION_MAJOR 1
 #define X_THREADING_VERSION_MINOR 0
@@ -46,6 +100,48 @@ extern "C" {
   typedef struct XCondVar XCondVar;
   typedef struct XThreadPool XThreadPool;
   typedef struct XTask XTask;
+  typedef struct XTaskGroup XTaskGroup;
+  typedef void (*XParallelForFunc)(int64_t begin, int64_t end, void* ctx);
+
+  /**
+   * Task node. Embed it in your own struct to submit work with
+   * `x_threadpool_submit()` without allocating. All fields are managed by
+   * the pool once the task is submitted.
+   */
+  struct XTask
+  {
+    XThreadTask fn;
+    void* arg;
+    XTask* next;
+    XTaskGroup* group;
+    uint32_t flags;
+  };
+
+  /**
+   * Completion counter for a batch of tasks. Initialize with
+   * `x_taskgroup_init()`; it needs no cleanup.
+   */
+  struct XTaskGroup
+  {
+    XThreadPool* pool;
+    volatile int32_t pending;
+  };
+
+  typedef enum
+  {
+    XTHREADPOOL_MODE_SHARED_QUEUE   = 0,  /* All workers pull from one locked queue */
+    XTHREADPOOL_MODE_WORK_STEALING  = 1   /* Per-worker deques with stealing */
+  } XThreadPoolMode;
+
+#ifndef X_THREAD_CACHE_LINE_SIZE
+#define X_THREAD_CACHE_LINE_SIZE 64
+#endif
+
+#if defined(_MSC_VER)
+#define X_THREAD_LOCAL __declspec(thread)
+#else
+#define X_THREAD_LOCAL __thread
+#endif
 
 /**
  * @brief Create and start a new thread.
@@ -136,6 +232,31 @@ void x_thread_sleep_ms(int ms);
  */
 void x_thread_yield(void);
 
+/**
+ * @brief Restrict the calling thread to a set of logical CPUs.
+ * Threads pin themselves, usually first thing in their entry function.
+ * On Windows only the lowest processor group present in the set is used.
+ * @param cpus CPUs the thread may run on.
+ * @return true on success; false on error, for an empty set, or where
+ * affinity is not supported (macOS).
+ */
+bool x_thread_set_affinity(const XCPUSet* cpus);
+
+/**
+ * @brief Get the logical CPUs the calling thread may run on.
+ * @param out Set to fill. Cleared on failure.
+ * @return true on success, false where affinity is not supported.
+ */
+bool x_thread_get_affinity(XCPUSet* out);
+
+/**
+ * @brief Get the logical CPU the calling thread is running on right now.
+ * The answer may be stale as soon as it is returned unless the thread is
+ * pinned to a single CPU.
+ * @return OS CPU number, or -1 if unknown.
+ */
+int32_t x_thread_current_cpu(void);
+
 /**
  * @brief Create a thread pool with a fixed number of worker threads.
  * @param num_threads Number of worker threads to start.
@@ -143,8 +264,20 @@ void x_thread_yield(void);
  */
 XThreadPool* x_threadpool_create(int num_threads);
 
+/**
+ * @brief Create a thread pool with a fixed number of worker threads and
+ * an explicit scheduling mode.
+ * @param num_threads Number of worker threads to start.
+ * @param mode Scheduling mode. `XTHREADPOOL_MODE_SHARED_QUEUE` behaves
+ * exactly like `x_threadpool_create()`.
+ * @return Thread pool handle, or NULL on failure.
+ */
+XThreadPool* x_threadpool_create_ex(int num_threads, XThreadPoolMode mode);
+
 /**
  * @brief Enqueue a task for execution by the thread pool.
+ * In work-stealing mode, tasks enqueued from a worker of the same pool are
+ * pushed to that worker's local deque.
  * @param pool Thread pool handle.
  * @param fn Task function to execute.
  * @param arg User argument passed to fn.
@@ -152,12 +285,169 @@ XThreadPool* x_threadpool_create(int num_threads);
  */
 int32_t x_threadpool_enqueue(XThreadPool* pool, XThreadTask fn, void* arg);
 
+/**
+ * @brief Initialize a caller-owned task node for `x_threadpool_submit()`.
+ * @param task Task node to initialize.
+ * @param fn Task function to execute.
+ * @param arg User argument passed to fn.
+ */
+void x_task_init(XTask* task, XThreadTask fn, void* arg);
+
+/**
+ * @brief Submit a caller-owned task node without allocating.
+ * The node must stay valid until its function starts running. It must not
+ * be submitted again before that.
+ * @param pool Thread pool handle.
+ * @param task Task node initialized with `x_task_init()`.
+ * @return 0 on success, non-zero on failure.
+ */
+int32_t x_threadpool_submit(XThreadPool* pool, XTask* task);
+
+/**
+ * @brief Initialize a task group bound to a thread pool.
+ * @param group Task group to initialize.
+ * @param pool Thread pool that will run the group's tasks.
+ */
+void x_taskgroup_init(XTaskGroup* group, XThreadPool* pool);
+
+/**
+ * @brief Enqueue a task as part of a group.
+ * @param group Task group.
+ * @param fn Task function to execute.
+ * @param arg User argument passed to fn.
+ * @return 0 on success, non-zero on failure.
+ */
+int32_t x_taskgroup_run(XTaskGroup* group, XThreadTask fn, void* arg);
+
+/**
+ * @brief Submit a caller-owned task node as part of a group.
+ * Same ownership rules as `x_threadpool_submit()`.
+ * @param group Task group.
+ * @param task Task node initialized with `x_task_init()`.
+ * @return 0 on success, non-zero on failure.
+ */
+int32_t x_taskgroup_submit(XTaskGroup* group, XTask* task);
+
+/**
+ * @brief Wait until every task of the group has finished.
+ * While waiting, the calling thread runs queued tasks from the group's pool.
+ * @param group Task group.
+ */
+void x_taskgroup_wait(XTaskGroup* group);
+
+/**
+ * @brief Run fn over [begin, end) in parallel and wait for it to finish.
+ * The range is split in chunks of `grain` elements and fn is called once
+ * per chunk with its sub-range. The calling thread processes chunks too.
+ * @param pool Thread pool handle.
+ * @param begin First index of the range.
+ * @param end One past the last index of the range.
+ * @param grain Chunk size. Pass 0 to derive it from the pool size, aiming
+ * for `X_THREADPOOL_CHUNKS_PER_THREAD` chunks per thread.
+ * @param fn Function called for each chunk.
+ * @param ctx User argument passed to fn.
+ * @return 0 on success, non-zero on failure.
+ */
+int32_t x_threadpool_parallel_for(XThreadPool* pool, int64_t begin, int64_t end, int64_t grain, XParallelForFunc fn, void* ctx);
+
 /**
  * @brief Destroy a thread pool and release its resources.
  * @param pool Thread pool handle.
  */
 void x_threadpool_destroy(XThreadPool* pool);
 
+  // -----------------------------------------------------------------------------
+  // Atomic operations
+  // Operations are sequentially consistent unless named acquire/release.
+  // They work on plain aligned integers and pointers so they can be embedded
+  // in any struct.
+  // -----------------------------------------------------------------------------
+
+#if defined(_MSC_VER)
+
+  static inline int32_t x_atomic_load_i32(volatile int32_t* p)                  { return (int32_t)_InterlockedCompareExchange((volatile long*)p, 0, 0); }
+  static inline void    x_atomic_store_i32(volatile int32_t* p, int32_t v)      { _InterlockedExchange((volatile long*)p, (long)v); }
+  static inline int32_t x_atomic_exchange_i32(volatile int32_t* p, int32_t v)   { return (int32_t)_InterlockedExchange((volatile long*)p, (long)v); }
+  static inline int32_t x_atomic_fetch_add_i32(volatile int32_t* p, int32_t v)  { return (int32_t)_InterlockedExchangeAdd((volatile long*)p, (long)v); }
+  static inline bool    x_atomic_cas_i32(volatile int32_t* p, int32_t expected, int32_t desired)
+  { return _InterlockedCompareExchange((volatile long*)p, (long)desired, (long)expected) == (long)expected; }
+
+  // 64-bit exchange/add are built on CAS so they also work on 32-bit x86
+  static inline int64_t x_atomic_load_i64(volatile int64_t* p)                  { return _InterlockedCompareExchange64((volatile __int64*)p, 0, 0); }
+  static inline int64_t x_atomic_exchange_i64(volatile int64_t* p, int64_t v)
+  {
+    int64_t old;
+    do { old = *p; } while (_InterlockedCompareExchange64((volatile __int64*)p, v, old) != old);
+    return old;
+  }
+  static inline void    x_atomic_store_i64(volatile int64_t* p, int64_t v)      { (void)x_atomic_exchange_i64(p, v); }
+  static inline int64_t x_atomic_fetch_add_i64(volatile int64_t* p, int64_t v)
+  {
+    int64_t old;
+    do { old = *p; } while (_InterlockedCompareExchange64((volatile __int64*)p, old + v, old) != old);
+    return old;
+  }
+  static inline bool    x_atomic_cas_i64(volatile int64_t* p, int64_t expected, int64_t desired)
+  { return _InterlockedCompareExchange64((volatile __int64*)p, desired, expected) == expected; }
+
+#if defined(_M_X64)
+  // Plain aligned accesses are already acquire/release on x64
+  static inline int64_t x_atomic_load_acquire_i64(volatile int64_t* p)          { int64_t v = *p; _ReadWriteBarrier(); return v; }
+  static inline void    x_atomic_store_release_i64(volatile int64_t* p, int64_t v){ _ReadWriteBarrier(); *p = v; }
+#else
+  static inline int64_t x_atomic_load_acquire_i64(volatile int64_t* p)          { return x_atomic_load_i64(p); }
+  static inline void    x_atomic_store_release_i64(volatile int64_t* p, int64_t v){ x_atomic_store_i64(p, v); }
+#endif
+
+  static inline void*   x_atomic_load_ptr(void* volatile* p)                    { return _InterlockedCompareExchangePointer(p, NULL, NULL); }
+  static inline void    x_atomic_store_ptr(void* volatile* p, void* v)          { _InterlockedExchangePointer(p, v); }
+  static inline void*   x_atomic_exchange_ptr(void* volatile* p, void* v)       { return _InterlockedExchangePointer(p, v); }
+  static inline bool    x_atomic_cas_ptr(void* volatile* p, void* expected, void* desired)
+  { return _InterlockedCompareExchangePointer(p, desired, expected) == expected; }
+
+  static inline void    x_atomic_fence(void)                                    { volatile long fence = 0; _InterlockedExchange(&fence, 1); }
+#if defined(_M_IX86) || defined(_M_X64)
+  static inline void    x_cpu_relax(void)                                       { _mm_pause(); }
+#else
+  static inline void    x_cpu_relax(void)                                       { __yield(); }
+#endif
+
+#else
+
+  static inline int32_t x_atomic_load_i32(volatile int32_t* p)                  { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+  static inline void    x_atomic_store_i32(volatile int32_t* p, int32_t v)      { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+  static inline int32_t x_atomic_exchange_i32(volatile int32_t* p, int32_t v)   { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+  static inline int32_t x_atomic_fetch_add_i32(volatile int32_t* p, int32_t v)  { return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST); }
+  static inline bool    x_atomic_cas_i32(volatile int32_t* p, int32_t expected, int32_t desired)
+  { return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+
+  static inline int64_t x_atomic_load_i64(volatile int64_t* p)                  { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+  static inline void    x_atomic_store_i64(volatile int64_t* p, int64_t v)      { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+  static inline int64_t x_atomic_exchange_i64(volatile int64_t* p, int64_t v)   { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+  static inline int64_t x_atomic_fetch_add_i64(volatile int64_t* p, int64_t v)  { return __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST); }
+  static inline bool    x_atomic_cas_i64(volatile int64_t* p, int64_t expected, int64_t desired)
+  { return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+
+  static inline int64_t x_atomic_load_acquire_i64(volatile int64_t* p)          { return __atomic_load_n(p, __ATOMIC_ACQUIRE); }
+  static inline void    x_atomic_store_release_i64(volatile int64_t* p, int64_t v){ __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+  static inline void*   x_atomic_load_ptr(void* volatile* p)                    { return __atomic_load_n(p, __ATOMIC_SEQ_CST); }
+  static inline void    x_atomic_store_ptr(void* volatile* p, void* v)          { __atomic_store_n(p, v, __ATOMIC_SEQ_CST); }
+  static inline void*   x_atomic_exchange_ptr(void* volatile* p, void* v)       { return __atomic_exchange_n(p, v, __ATOMIC_SEQ_CST); }
+  static inline bool    x_atomic_cas_ptr(void* volatile* p, void* expected, void* desired)
+  { return __atomic_compare_exchange_n(p, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST); }
+
+  static inline void    x_atomic_fence(void)                                    { __atomic_thread_fence(__ATOMIC_SEQ_CST); }
+#if defined(__i386__) || defined(__x86_64__)
+  static inline void    x_cpu_relax(void)                                       { __builtin_ia32_pause(); }
+#elif defined(__aarch64__) || defined(__arm__)
+  static inline void    x_cpu_relax(void)                                       { __asm__ __volatile__("yield"); }
+#else
+  static inline void    x_cpu_relax(void)                                       { }
+#endif
+
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -175,10 +465,24 @@ void x_threadpool_destroy(XThreadPool* pool);
 #include <unistd.h>
 #include <sched.h>
 #include <time.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
 #endif // _WIN32
 
+#include <string.h>
+
 #include <stdlib.h>
 
+#ifdef X_PROFILE_LIBRARY
+#include "stdx_profile.h"
+#define X_THREAD_PROFILE_BEGIN(name) X_PROFILE_BEGIN(name)
+#define X_THREAD_PROFILE_END() X_PROFILE_END()
+#else
+#define X_THREAD_PROFILE_BEGIN(name) ((void)0)
+#define X_THREAD_PROFILE_END() ((void)0)
+#endif
+
 #ifndef X_THREAD_ALLOC
 /**
  * @brief Internal macro for allocating memory.
@@ -307,23 +611,56 @@ extern "C" {
     Sleep(0);
   }
 
+  bool x_thread_set_affinity(const XCPUSet* cpus)
+  {
+    // CPU numbers are group * 64 + bit, as in x_cpu_topology()
+    for (size_t g = 0; g < sizeof(cpus->bits) / sizeof(cpus->bits[0]); g++)
+    {
+      if (cpus->bits[g] == 0)
+        continue;
+      GROUP_AFFINITY affinity;
+      memset(&affinity, 0, sizeof(affinity));
+      affinity.Group = (WORD)g;
+      affinity.Mask = (KAFFINITY)cpus->bits[g];
+      return SetThreadGroupAffinity(GetCurrentThread(), &affinity, NULL) != 0;
+    }
+    return false;
+  }
+
+  bool x_thread_get_affinity(XCPUSet* out)
+  {
+    GROUP_AFFINITY affinity;
+    x_cpuset_clear(out);
+    if (!GetThreadGroupAffinity(GetCurrentThread(), &affinity))
+      return false;
+    out->bits[affinity.Group] = (uint64_t)affinity.Mask;
+    return true;
+  }
+
+  int32_t x_thread_current_cpu(void)
+  {
+    PROCESSOR_NUMBER number;
+    GetCurrentProcessorNumberEx(&number);
+    return (int32_t)number.Group * 64 + number.Number;
+  }
+
 #else // POSIX
 
-  struct XThread { pXThread id; };
-  struct XMutex  { px_thread_XMutex m; };
-  struct XCondVar { px_thread_cond_t cv; };
+  struct XThread { pthread_t id; };
+  struct XMutex  { pthread_mutex_t m; };
+  struct XCondVar { pthread_cond_t cv; };
 
   int32_t x_thread_create(XThread** t, XThreadFunc func, void* arg)
   {
     if (!t || !func) return -1;
     *t = X_THREAD_ALLOC(sizeof(XThread));
-    return px_thread_create(&(*t)->id, NULL, func, arg);
+    return pthread_create(&(*t)->id, NULL, func, arg);
   }
 
   void x_thread_join(XThread* t)
   {
     if (t) {
-      px_thread_join(t->id, NULL);
+      pthread_join(t->id, NULL);
     }
   }
 
@@ -332,53 +669,54 @@ extern "C" {
     if (t) X_THREAD_FREE(t);
   }
 
-  int32_t x_thread_mutexinit(XMutex** m) {
+  int32_t x_thread_mutex_init(XMutex** m)
+  {
     *m = X_THREAD_ALLOC(sizeof(XMutex));
-    px_thread_x_thread_mutexinit(&(*m)->m, NULL);
+    pthread_mutex_init(&(*m)->m, NULL);
     return 0;
   }
 
   void x_thread_mutex_lock(XMutex* m)
   {
-    px_thread_x_thread_mutexlock(&m->m);
+    pthread_mutex_lock(&m->m);
   }
 
   void x_thread_mutex_unlock(XMutex* m)
   {
-    px_thread_x_thread_mutexunlock(&m->m);
+    pthread_mutex_unlock(&m->m);
   }
 
   void x_thread_mutex_destroy(XMutex* m)
   {
-    px_thread_x_thread_mutexdestroy(&m->m);
+    pthread_mutex_destroy(&m->m);
     X_THREAD_FREE(m);
   }
 
   int32_t x_thread_condvar_init(XCondVar** cv)
   {
     *cv = X_THREAD_ALLOC(sizeof(XCondVar));
-    px_thread_cond_init(&(*cv)->cv, NULL);
+    pthread_cond_init(&(*cv)->cv, NULL);
     return 0;
   }
 
   void x_thread_condvar_wait(XCondVar* cv, XMutex* m)
   {
-    px_thread_cond_wait(&cv->cv, &m->m);
+    pthread_cond_wait(&cv->cv, &m->m);
   }
 
   void x_thread_condvar_signal(XCondVar* cv)
   {
-    px_thread_cond_signal(&cv->cv);
+    pthread_cond_signal(&cv->cv);
   }
 
   void x_thread_condvar_broadcast(XCondVar* cv)
   {
-    px_thread_cond_broadcast(&cv->cv);
+    pthread_cond_broadcast(&cv->cv);
   }
 
   void x_thread_condvar_destroy(XCondVar* cv)
   {
-    px_thread_cond_destroy(&cv->cv);
+    pthread_cond_destroy(&cv->cv);
     X_THREAD_FREE(cv);
   }
 
@@ -393,39 +731,486 @@ extern "C" {
     sched_yield();
   }
 
+#if defined(__linux__)
+  // The kernel's mask is an array of longs; the glibc wrappers and
+  // cpu_set_t would need _GNU_SOURCE before the first system header
+  typedef struct
+  {
+    unsigned long words[(X_CPU_MAX_CPUS + 8 * sizeof(unsigned long) - 1) / (8 * sizeof(unsigned long))];
+  } XThreadKernelMask;
+
+#define X_THREAD_MASK_BITS (8 * sizeof(unsigned long))
+#endif
+
+  bool x_thread_set_affinity(const XCPUSet* cpus)
+  {
+#if defined(__linux__)
+    XThreadKernelMask mask;
+    memset(&mask, 0, sizeof(mask));
+    if (x_cpuset_count(cpus) == 0)
+      return false;
+    for (int32_t cpu = x_cpuset_next(cpus, -1); cpu >= 0; cpu = x_cpuset_next(cpus, cpu))
+      mask.words[cpu / X_THREAD_MASK_BITS] |= 1ul << (cpu % X_THREAD_MASK_BITS);
+    return syscall(SYS_sched_setaffinity, 0, sizeof(mask), &mask) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+  }
+
+  bool x_thread_get_affinity(XCPUSet* out)
+  {
+    x_cpuset_clear(out);
+#if defined(__linux__)
+    XThreadKernelMask mask;
+    memset(&mask, 0, sizeof(mask));
+    // Returns the number of bytes written on success
+    if (syscall(SYS_sched_getaffinity, 0, sizeof(mask), &mask) <= 0)
+      return false;
+    for (int32_t cpu = 0; cpu < X_CPU_MAX_CPUS; cpu++)
+    {
+      if (mask.words[cpu / X_THREAD_MASK_BITS] & (1ul << (cpu % X_THREAD_MASK_BITS)))
+        x_cpuset_add(out, cpu);
+    }
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  int32_t x_thread_current_cpu(void)
+  {
+#if defined(__linux__)
+    unsigned int cpu = 0;
+    if (syscall(SYS_getcpu, &cpu, NULL, NULL) != 0)
+      return -1;
+    return (int32_t)cpu;
+#else
+    return -1;
+#endif
+  }
+
 #endif // WIN_32
 
 #define THREADPOOL_MAGIC 0xDEADBEEF
 
-  struct XTask
+#ifndef X_THREADPOOL_DEQUE_CAPACITY
+/**
+ * @brief Capacity of each worker deque in work-stealing mode. Must be a power
+ * of two. When a worker deque is full, tasks go through the injection queue.
+ */
+#define X_THREADPOOL_DEQUE_CAPACITY 4096
+#endif
+
+#ifndef X_THREADPOOL_INJECT_BATCH
+/**
+ * @brief Maximum number of tasks a work-stealing worker moves from the
+ * injection queue to its own deque each time it takes the pool lock.
+ */
+#define X_THREADPOOL_INJECT_BATCH 16
+#endif
+
+#ifndef X_THREADPOOL_TASK_BLOCK
+/**
+ * @brief Number of task nodes allocated at once when the pool free list is
+ * empty.
+ */
+#define X_THREADPOOL_TASK_BLOCK 256
+#endif
+
+#ifndef X_THREADPOOL_TASK_CACHE
+/**
+ * @brief Maximum number of free task nodes a work-stealing worker keeps for
+ * itself. Half of them go back to the pool when this is exceeded.
+ */
+#define X_THREADPOOL_TASK_CACHE 256
+#endif
+
+#ifndef X_THREADPOOL_CHUNKS_PER_THREAD
+/**
+ * @brief Number of chunks per thread `x_threadpool_parallel_for()` aims for
+ * when no grain is given. More chunks balance uneven work better.
+ */
+#define X_THREADPOOL_CHUNKS_PER_THREAD 4
+#endif
+
+#ifndef X_THREADPOOL_SPIN_COUNT
+/**
+ * @brief Number of failed task searches an idle work-stealing worker spins
+ * through before going to sleep on the pool condition variable.
+ */
+#define X_THREADPOOL_SPIN_COUNT 64
+#endif
+
+#define XTASK_FLAG_POOLED 1u   // Node belongs to the pool free list
+
+  typedef struct XTaskBlock XTaskBlock;
+  struct XTaskBlock
   {
-    XThreadTask fn;
-    void* arg;
-    XTask* next;
+    XTaskBlock* next;
+    XTask tasks[X_THREADPOOL_TASK_BLOCK];
   };
 
+  /*
+   * Work-stealing worker. The deque is a fixed size Chase-Lev ring: the owner
+   * pushes and pops at `bottom`, thieves take from `top`. Both indices only
+   * grow, so `bottom - top` is the number of queued tasks.
+   */
+  typedef struct XThreadPoolWorker
+  {
+    XThreadPool* pool;
+    void* volatile* slots;
+    int32_t index;
+    uint32_t rng;
+    XTask* free_tasks;            // Private node cache, owner only
+    int32_t free_count;
+    char pad0[X_THREAD_CACHE_LINE_SIZE];
+    volatile int64_t top;
+    char pad1[X_THREAD_CACHE_LINE_SIZE];
+    volatile int64_t bottom;
+    char pad2[X_THREAD_CACHE_LINE_SIZE];
+  } XThreadPoolWorker;
+
   struct XThreadPool
   {
     uint32_t magic;
+    XThreadPoolMode mode;
     XThread** threads;
     int32_t num_threads;
+    XThreadPoolWorker* workers;   // Work-stealing mode only
 
+    // Shared queue. In work-stealing mode this is the injection queue used
+    // by threads that are not workers of this pool.
     XTask* head;
     XTask* tail;
 
     XMutex* lock;
     XCondVar* cv;
 
+    XTask* free_tasks;            // Pool owned free nodes, guarded by lock
+    XTaskBlock* task_blocks;      // Every block allocated by this pool
+
+    volatile int32_t pending;     // Work-stealing: tasks queued anywhere in the pool
+    volatile int32_t injected;    // Work-stealing: tasks in the injection queue
+    volatile int32_t sleeping;    // Work-stealing: workers blocked on cv
+    volatile int32_t waiters;     // Threads blocked in x_taskgroup_wait
+
     bool stop;
   };
 
+  static X_THREAD_LOCAL XThreadPoolWorker* s_threadpool_worker = NULL;
+
+  static void s_threadpool_queue_push(XThreadPool* pool, XTask* task)
+  {
+    task->next = NULL;
+    if (pool->tail)
+    {
+      pool->tail->next = task;
+      pool->tail = task;
+    } else
+    {
+      pool->head = pool->tail = task;
+    }
+  }
+
+  static XTask* s_threadpool_queue_pop(XThreadPool* pool)
+  {
+    XTask* task = pool->head;
+    if (task)
+    {
+      pool->head = task->next;
+      if (!pool->head) pool->tail = NULL;
+    }
+    return task;
+  }
+
+  // Caller holds pool->lock
+  static XTask* s_threadpool_task_alloc_locked(XThreadPool* pool)
+  {
+    if (!pool->free_tasks)
+    {
+      XTaskBlock* block = X_THREAD_ALLOC(sizeof(XTaskBlock));
+      if (!block)
+        return NULL;
+
+      block->next = pool->task_blocks;
+      pool->task_blocks = block;
+      for (int32_t i = X_THREADPOOL_TASK_BLOCK - 1; i >= 0; --i)
+      {
+        block->tasks[i].flags = XTASK_FLAG_POOLED;
+        block->tasks[i].next = pool->free_tasks;
+        pool->free_tasks = &block->tasks[i];
+      }
+    }
+
+    XTask* task = pool->free_tasks;
+    pool->free_tasks = task->next;
+    return task;
+  }
+
+  // Caller holds pool->lock
+  static void s_threadpool_task_free_locked(XThreadPool* pool, XTask* task)
+  {
+    task->next = pool->free_tasks;
+    pool->free_tasks = task;
+  }
+
+  static XTask* s_threadpool_worker_task_alloc(XThreadPoolWorker* w)
+  {
+    if (!w->free_tasks)
+    {
+      XThreadPool* pool = w->pool;
+      x_thread_mutex_lock(pool->lock);
+      for (int32_t i = 0; i < X_THREADPOOL_TASK_CACHE / 2; ++i)
+      {
+        XTask* task = s_threadpool_task_alloc_locked(pool);
+        if (!task)
+          break;
+        task->next = w->free_tasks;
+        w->free_tasks = task;
+        w->free_count++;
+      }
+      x_thread_mutex_unlock(pool->lock);
+
+      if (!w->free_tasks)
+        return NULL;
+    }
+
+    XTask* task = w->free_tasks;
+    w->free_tasks = task->next;
+    w->free_count--;
+    return task;
+  }
+
+  static void s_threadpool_worker_task_free(XThreadPoolWorker* w, XTask* task)
+  {
+    task->next = w->free_tasks;
+    w->free_tasks = task;
+    w->free_count++;
+
+    if (w->free_count > X_THREADPOOL_TASK_CACHE)
+    {
+      XThreadPool* pool = w->pool;
+      x_thread_mutex_lock(pool->lock);
+      while (w->free_count > X_THREADPOOL_TASK_CACHE / 2)
+      {
+        XTask* extra = w->free_tasks;
+        w->free_tasks = extra->next;
+        w->free_count--;
+        s_threadpool_task_free_locked(pool, extra);
+      }
+      x_thread_mutex_unlock(pool->lock);
+    }
+  }
+
+  static bool s_threadpool_deque_push(XThreadPoolWorker* w, XTask* task)
+  {
+    int64_t b = x_atomic_load_i64(&w->bottom);
+    int64_t t = x_atomic_load_i64(&w->top);
+    if (b - t >= X_THREADPOOL_DEQUE_CAPACITY)
+      return false;
+
+    x_atomic_store_ptr(&w->slots[b & (X_THREADPOOL_DEQUE_CAPACITY - 1)], task);
+    x_atomic_store_i64(&w->bottom, b + 1);
+    return true;
+  }
+
+  static XTask* s_threadpool_deque_pop(XThreadPoolWorker* w)
+  {
+    int64_t b = x_atomic_load_i64(&w->bottom) - 1;
+    x_atomic_store_i64(&w->bottom, b);
+    int64_t t = x_atomic_load_i64(&w->top);
+
+    if (t > b)
+    {
+      x_atomic_store_i64(&w->bottom, b + 1);
+      return NULL;
+    }
+
+    XTask* task = (XTask*)x_atomic_load_ptr(&w->slots[b & (X_THREADPOOL_DEQUE_CAPACITY - 1)]);
+    if (t == b)
+    {
+      // Last task in the deque: race thieves for it.
+      if (!x_atomic_cas_i64(&w->top, t, t + 1))
+        task = NULL;
+      x_atomic_store_i64(&w->bottom, b + 1);
+    }
+    return task;
+  }
+
+  static XTask* s_threadpool_deque_steal(XThreadPoolWorker* w)
+  {
+    int64_t t = x_atomic_load_i64(&w->top);
+    int64_t b = x_atomic_load_i64(&w->bottom);
+    if (t >= b)
+      return NULL;
+
+    XTask* task = (XTask*)x_atomic_load_ptr(&w->slots[t & (X_THREADPOOL_DEQUE_CAPACITY - 1)]);
+    if (!x_atomic_cas_i64(&w->top, t, t + 1))
+      return NULL;
+    return task;
+  }
+
+  static XTask* s_threadpool_find_task(XThreadPoolWorker* w)
+  {
+    XThreadPool* pool = w->pool;
+    XTask* task = s_threadpool_deque_pop(w);
+    if (task)
+      return task;
+
+    // Steal starting from a pseudo-random victim so thieves spread out
+    if (pool->num_threads > 1)
+    {
+      w->rng ^= w->rng << 13;
+      w->rng ^= w->rng >> 17;
+      w->rng ^= w->rng << 5;
+      int32_t start = (int32_t)(w->rng % (uint32_t)pool->num_threads);
+      for (int32_t i = 0; i < pool->num_threads; ++i)
+      {
+        XThreadPoolWorker* victim = &pool->workers[(start + i) % pool->num_threads];
+        if (victim == w)
+          continue;
+
+        task = s_threadpool_deque_steal(victim);
+        if (task)
+          return task;
+      }
+    }
+
+    // Take a batch from the injection queue. The local deque is empty at
+    // this point, so the extra tasks can be stolen by other workers.
+    if (x_atomic_load_i32(&pool->injected) > 0)
+    {
+      x_thread_mutex_lock(pool->lock);
+      task = s_threadpool_queue_pop(pool);
+      if (task)
+      {
+        x_atomic_fetch_add_i32(&pool->injected, -1);
+        for (int32_t i = 1; i < X_THREADPOOL_INJECT_BATCH; ++i)
+        {
+          // Unlink before publishing: once pushed, a thief may run it
+          XTask* extra = s_threadpool_queue_pop(pool);
+          if (!extra)
+            break;
+
+          if (!s_threadpool_deque_push(w, extra))
+          {
+            extra->next = pool->head;
+            pool->head = extra;
+            if (!pool->tail) pool->tail = extra;
+            break;
+          }
+          x_atomic_fetch_add_i32(&pool->injected, -1);
+        }
+      }
+      x_thread_mutex_unlock(pool->lock);
+    }
+    return task;
+  }
+
+  static void s_threadpool_group_done(XThreadPool* pool, XTaskGroup* group)
+  {
+    // Waiters bump `waiters` before checking `pending`, see x_taskgroup_wait
+    if (group && x_atomic_fetch_add_i32(&group->pending, -1) == 1 && x_atomic_load_i32(&pool->waiters) > 0)
+    {
+      x_thread_mutex_lock(pool->lock);
+      x_thread_condvar_broadcast(pool->cv);
+      x_thread_mutex_unlock(pool->lock);
+    }
+  }
+
+  // Run a task taken from the pool and recycle its node. `w` is the calling
+  // worker of this pool, or NULL for any other thread.
+  static void s_threadpool_run_task(XThreadPool* pool, XThreadPoolWorker* w, XTask* task)
+  {
+    // Read everything first: intrusive tasks may be gone once fn returns
+    bool pooled = (task->flags & XTASK_FLAG_POOLED) != 0;
+    XTaskGroup* group = task->group;
+
+    X_THREAD_PROFILE_BEGIN("x_threadpool task");
+    task->fn(task->arg);
+    X_THREAD_PROFILE_END();
+
+    if (pooled)
+    {
+      if (w)
+      {
+        s_threadpool_worker_task_free(w, task);
+      }
+      else
+      {
+        x_thread_mutex_lock(pool->lock);
+        s_threadpool_task_free_locked(pool, task);
+        x_thread_mutex_unlock(pool->lock);
+      }
+    }
+    s_threadpool_group_done(pool, group);
+  }
+
+  static void* s_threadpool_worker_main(void* arg)
+  {
+    XThreadPoolWorker* w = (XThreadPoolWorker*)arg;
+    XThreadPool* pool = w->pool;
+    int32_t spins = 0;
+
+    s_threadpool_worker = w;
+
+    while (1)
+    {
+      XTask* task = s_threadpool_find_task(w);
+      if (task)
+      {
+        x_atomic_fetch_add_i32(&pool->pending, -1);
+        s_threadpool_run_task(pool, w, task);
+        spins = 0;
+        continue;
+      }
+
+      // Tasks may be in flight on another deque; keep looking for a while
+      if (x_atomic_load_i32(&pool->pending) > 0 || spins < X_THREADPOOL_SPIN_COUNT)
+      {
+        spins++;
+        x_cpu_relax();
+        continue;
+      }
+
+      // Enqueue bumps `pending` before looking at `sleeping`, and we bump
+      // `sleeping` before looking at `pending`, so a wakeup is never lost.
+      x_thread_mutex_lock(pool->lock);
+      x_atomic_fetch_add_i32(&pool->sleeping, 1);
+      while (x_atomic_load_i32(&pool->pending) <= 0 && !pool->stop)
+      {
+        x_thread_condvar_wait(pool->cv, pool->lock);
+      }
+      x_atomic_fetch_add_i32(&pool->sleeping, -1);
+      bool done = pool->stop && x_atomic_load_i32(&pool->pending) <= 0;
+      x_thread_mutex_unlock(pool->lock);
+
+      if (done)
+        break;
+      spins = 0;
+    }
+
+    s_threadpool_worker = NULL;
+    return NULL;
+  }
+
   static void* thread_main(void* arg)
   {
     XThreadPool* pool = (XThreadPool*)arg;
+    XTask* done = NULL;
 
     while (1)
     {
       x_thread_mutex_lock(pool->lock);
+
+      // Recycle the previous task node while we hold the lock anyway
+      if (done)
+      {
+        s_threadpool_task_free_locked(pool, done);
+        done = NULL;
+      }
+
       while (!pool->head && !pool->stop)
       {
         x_thread_condvar_wait(pool->cv, pool->lock);
@@ -437,63 +1222,373 @@ extern "C" {
         break;
       }
 
-      XTask* task = pool->head;
-      if (task)
-      {
-        pool->head = task->next;
-        if (!pool->head) pool->tail = NULL;
-      }
+      XTask* task = s_threadpool_queue_pop(pool);
       x_thread_mutex_unlock(pool->lock);
 
       if (task)
       {
+        bool pooled = (task->flags & XTASK_FLAG_POOLED) != 0;
+        XTaskGroup* group = task->group;
+        X_THREAD_PROFILE_BEGIN("x_threadpool task");
         task->fn(task->arg);
-        X_THREAD_FREE(task);
+        X_THREAD_PROFILE_END();
+        if (pooled)
+          done = task;
+        s_threadpool_group_done(pool, group);
       }
     }
     return NULL;
   }
 
   XThreadPool* x_threadpool_create(int num_threads)
+  {
+    return x_threadpool_create_ex(num_threads, XTHREADPOOL_MODE_SHARED_QUEUE);
+  }
+
+  XThreadPool* x_threadpool_create_ex(int num_threads, XThreadPoolMode mode)
   {
     if (num_threads <= 0)
       return NULL;
 
     XThreadPool* pool = calloc(1, sizeof(XThreadPool));
+    pool->mode = mode;
     pool->num_threads = num_threads;
     pool->threads = calloc(num_threads, sizeof(XThread*));
     x_thread_mutex_init(&pool->lock);
     x_thread_condvar_init(&pool->cv);
 
-    for (int i = 0; i < num_threads; ++i)
+    if (mode == XTHREADPOOL_MODE_WORK_STEALING)
+    {
+      pool->workers = calloc(num_threads, sizeof(XThreadPoolWorker));
+      for (int i = 0; i < num_threads; ++i)
+      {
+        XThreadPoolWorker* w = &pool->workers[i];
+        w->pool = pool;
+        w->index = i;
+        w->rng = (uint32_t)(i + 1) * 2654435761u;
+        w->slots = calloc(X_THREADPOOL_DEQUE_CAPACITY, sizeof(void*));
+      }
+
+      for (int i = 0; i < num_threads; ++i)
+      {
+        x_thread_create(&pool->threads[i], s_threadpool_worker_main, &pool->workers[i]);
+      }
+    }
+    else
     {
-      x_thread_create(&pool->threads[i], thread_main, pool);
+      for (int i = 0; i < num_threads; ++i)
+      {
+        x_thread_create(&pool->threads[i], thread_main, pool);
+      }
     }
     pool->magic = THREADPOOL_MAGIC;
     return pool;
   }
 
-  int32_t x_threadpool_enqueue(XThreadPool* pool, XThreadTask fn, void* arg)
+  // Work-stealing: push to the calling worker's deque. Returns false when
+  // the caller is not a worker of this pool or its deque is full.
+  static bool s_threadpool_push_local(XThreadPool* pool, XTask* task)
+  {
+    XThreadPoolWorker* w = s_threadpool_worker;
+    if (!w || w->pool != pool || !s_threadpool_deque_push(w, task))
+      return false;
+
+    x_atomic_fetch_add_i32(&pool->pending, 1);
+    if (x_atomic_load_i32(&pool->sleeping) > 0)
+    {
+      x_thread_mutex_lock(pool->lock);
+      x_thread_condvar_signal(pool->cv);
+      x_thread_mutex_unlock(pool->lock);
+    }
+    return true;
+  }
+
+  // Caller holds pool->lock
+  static void s_threadpool_push_shared_locked(XThreadPool* pool, XTask* task)
+  {
+    s_threadpool_queue_push(pool, task);
+    if (pool->mode == XTHREADPOOL_MODE_WORK_STEALING)
+    {
+      x_atomic_fetch_add_i32(&pool->injected, 1);
+      x_atomic_fetch_add_i32(&pool->pending, 1);
+      if (x_atomic_load_i32(&pool->sleeping) > 0)
+        x_thread_condvar_signal(pool->cv);
+    }
+    else
+    {
+      x_thread_condvar_signal(pool->cv);
+    }
+  }
+
+  static int32_t s_threadpool_enqueue(XThreadPool* pool, XThreadTask fn, void* arg, XTaskGroup* group)
   {
     if (!fn || !pool || pool->magic != THREADPOOL_MAGIC) return -1;
 
-    XTask* task = X_THREAD_ALLOC(sizeof(XTask));
+    if (pool->mode == XTHREADPOOL_MODE_WORK_STEALING)
+    {
+      XThreadPoolWorker* w = s_threadpool_worker;
+      if (w && w->pool == pool)
+      {
+        XTask* task = s_threadpool_worker_task_alloc(w);
+        if (!task) return -1;
+        task->fn = fn;
+        task->arg = arg;
+        task->group = group;
+
+        if (s_threadpool_push_local(pool, task))
+          return 0;
+
+        x_thread_mutex_lock(pool->lock);
+        s_threadpool_push_shared_locked(pool, task);
+        x_thread_mutex_unlock(pool->lock);
+        return 0;
+      }
+    }
+
+    x_thread_mutex_lock(pool->lock);
+    XTask* task = s_threadpool_task_alloc_locked(pool);
+    if (!task)
+    {
+      x_thread_mutex_unlock(pool->lock);
+      return -1;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->group = group;
+    s_threadpool_push_shared_locked(pool, task);
+    x_thread_mutex_unlock(pool->lock);
+
+    return 0;
+  }
+
+  int32_t x_threadpool_enqueue(XThreadPool* pool, XThreadTask fn, void* arg)
+  {
+    return s_threadpool_enqueue(pool, fn, arg, NULL);
+  }
+
+  void x_task_init(XTask* task, XThreadTask fn, void* arg)
+  {
+    if (!task) return;
     task->fn = fn;
     task->arg = arg;
     task->next = NULL;
+    task->group = NULL;
+    task->flags = 0;
+  }
+
+  static int32_t s_threadpool_submit(XThreadPool* pool, XTask* task)
+  {
+    if (!task || !task->fn || !pool || pool->magic != THREADPOOL_MAGIC) return -1;
+
+    task->flags &= ~XTASK_FLAG_POOLED;
+    if (pool->mode == XTHREADPOOL_MODE_WORK_STEALING && s_threadpool_push_local(pool, task))
+      return 0;
 
     x_thread_mutex_lock(pool->lock);
-    if (pool->tail)
+    s_threadpool_push_shared_locked(pool, task);
+    x_thread_mutex_unlock(pool->lock);
+    return 0;
+  }
+
+  int32_t x_threadpool_submit(XThreadPool* pool, XTask* task)
+  {
+    if (task) task->group = NULL;
+    return s_threadpool_submit(pool, task);
+  }
+
+  // Take one queued task and run it on the calling thread.
+  // Returns false if no task was found.
+  static bool s_threadpool_help(XThreadPool* pool)
+  {
+    XThreadPoolWorker* w = s_threadpool_worker;
+    XTask* task = NULL;
+
+    if (w && w->pool != pool)
+      w = NULL;
+
+    if (pool->mode == XTHREADPOOL_MODE_WORK_STEALING)
     {
-      pool->tail->next = task;
-      pool->tail = task;
-    } else
+      if (w)
+      {
+        task = s_threadpool_find_task(w);
+      }
+      else
+      {
+        for (int32_t i = 0; i < pool->num_threads && !task; ++i)
+          task = s_threadpool_deque_steal(&pool->workers[i]);
+
+        if (!task && x_atomic_load_i32(&pool->injected) > 0)
+        {
+          x_thread_mutex_lock(pool->lock);
+          task = s_threadpool_queue_pop(pool);
+          if (task)
+            x_atomic_fetch_add_i32(&pool->injected, -1);
+          x_thread_mutex_unlock(pool->lock);
+        }
+      }
+
+      if (!task)
+        return false;
+      x_atomic_fetch_add_i32(&pool->pending, -1);
+    }
+    else
     {
-      pool->head = pool->tail = task;
+      x_thread_mutex_lock(pool->lock);
+      task = s_threadpool_queue_pop(pool);
+      x_thread_mutex_unlock(pool->lock);
+      if (!task)
+        return false;
     }
-    x_thread_condvar_signal(pool->cv);
-    x_thread_mutex_unlock(pool->lock);
 
+    s_threadpool_run_task(pool, w, task);
+    return true;
+  }
+
+  // Caller holds pool->lock
+  static bool s_threadpool_has_work_locked(XThreadPool* pool)
+  {
+    if (pool->mode == XTHREADPOOL_MODE_WORK_STEALING)
+      return x_atomic_load_i32(&pool->pending) > 0;
+    return pool->head != NULL;
+  }
+
+  void x_taskgroup_init(XTaskGroup* group, XThreadPool* pool)
+  {
+    if (!group) return;
+    group->pool = pool;
+    group->pending = 0;
+  }
+
+  int32_t x_taskgroup_run(XTaskGroup* group, XThreadTask fn, void* arg)
+  {
+    if (!group) return -1;
+
+    x_atomic_fetch_add_i32(&group->pending, 1);
+    if (s_threadpool_enqueue(group->pool, fn, arg, group) != 0)
+    {
+      x_atomic_fetch_add_i32(&group->pending, -1);
+      return -1;
+    }
+    return 0;
+  }
+
+  int32_t x_taskgroup_submit(XTaskGroup* group, XTask* task)
+  {
+    if (!group || !task) return -1;
+
+    task->group = group;
+    x_atomic_fetch_add_i32(&group->pending, 1);
+    if (s_threadpool_submit(group->pool, task) != 0)
+    {
+      x_atomic_fetch_add_i32(&group->pending, -1);
+      return -1;
+    }
+    return 0;
+  }
+
+  void x_taskgroup_wait(XTaskGroup* group)
+  {
+    if (!group || !group->pool) return;
+
+    XThreadPool* pool = group->pool;
+    int32_t spins = 0;
+
+    while (x_atomic_load_i32(&group->pending) > 0)
+    {
+      if (s_threadpool_help(pool))
+      {
+        spins = 0;
+        continue;
+      }
+
+      if (spins < X_THREADPOOL_SPIN_COUNT)
+      {
+        spins++;
+        x_cpu_relax();
+        continue;
+      }
+
+      // Nothing to help with: block until the group finishes or new work
+      // shows up. Counting ourselves as sleeping makes enqueue signal us.
+      x_thread_mutex_lock(pool->lock);
+      x_atomic_fetch_add_i32(&pool->waiters, 1);
+      x_atomic_fetch_add_i32(&pool->sleeping, 1);
+      while (x_atomic_load_i32(&group->pending) > 0 && !s_threadpool_has_work_locked(pool))
+      {
+        x_thread_condvar_wait(pool->cv, pool->lock);
+      }
+      x_atomic_fetch_add_i32(&pool->sleeping, -1);
+      x_atomic_fetch_add_i32(&pool->waiters, -1);
+
+      // We may have consumed a wakeup meant for a worker; pass it on
+      if (x_atomic_load_i32(&group->pending) <= 0 && s_threadpool_has_work_locked(pool))
+        x_thread_condvar_signal(pool->cv);
+      x_thread_mutex_unlock(pool->lock);
+      spins = 0;
+    }
+  }
+
+  typedef struct XParallelForRange
+  {
+    XParallelForFunc fn;
+    void* ctx;
+    int64_t end;
+    int64_t grain;
+    volatile int64_t next;
+  } XParallelForRange;
+
+  static void s_threadpool_parallel_for_task(void* arg)
+  {
+    XParallelForRange* range = (XParallelForRange*)arg;
+    while (1)
+    {
+      int64_t start = x_atomic_fetch_add_i64(&range->next, range->grain);
+      if (start >= range->end)
+        break;
+
+      int64_t stop = (range->end - start > range->grain) ? start + range->grain : range->end;
+      X_THREAD_PROFILE_BEGIN("x_parallel_for range");
+      range->fn(start, stop, range->ctx);
+      X_THREAD_PROFILE_END();
+    }
+  }
+
+  int32_t x_threadpool_parallel_for(XThreadPool* pool, int64_t begin, int64_t end, int64_t grain, XParallelForFunc fn, void* ctx)
+  {
+    if (!fn || !pool || pool->magic != THREADPOOL_MAGIC) return -1;
+    if (end <= begin) return 0;
+
+    int64_t count = end - begin;
+    if (grain <= 0)
+    {
+      int64_t chunks = (int64_t)(pool->num_threads + 1) * X_THREADPOOL_CHUNKS_PER_THREAD;
+      grain = (count + chunks - 1) / chunks;
+      if (grain < 1) grain = 1;
+    }
+
+    XParallelForRange range;
+    range.fn = fn;
+    range.ctx = ctx;
+    range.end = end;
+    range.grain = grain;
+    range.next = begin;
+
+    // Chunks are claimed dynamically, so one task per worker is enough
+    int64_t num_chunks = (count + grain - 1) / grain;
+    int64_t helpers = num_chunks - 1;
+    if (helpers > pool->num_threads)
+      helpers = pool->num_threads;
+
+    XTaskGroup group;
+    x_taskgroup_init(&group, pool);
+    for (int64_t i = 0; i < helpers; ++i)
+    {
+      if (x_taskgroup_run(&group, s_threadpool_parallel_for_task, &range) != 0)
+        break;
+    }
+
+    s_threadpool_parallel_for_task(&range);
+    x_taskgroup_wait(&group);
     return 0;
   }
 
@@ -517,12 +1612,20 @@ extern "C" {
     x_thread_mutex_destroy(pool->lock);
     x_thread_condvar_destroy(pool->cv);
 
-    // Clean up remaining tasks
-    while (pool->head)
+    // Workers drain the queues before exiting, and every pool owned node
+    // (queued, cached by a worker or free) lives in one of the task blocks.
+    while (pool->task_blocks)
+    {
+      XTaskBlock* block = pool->task_blocks;
+      pool->task_blocks = block->next;
+      X_THREAD_FREE(block);
+    }
+
+    if (pool->workers)
     {
-      XTask* tmp = pool->head;
-      pool->head = tmp->next;
-      X_THREAD_FREE(tmp);
+      for (int i = 0; i < pool->num_threads; ++i)
+        X_THREAD_FREE((void*)pool->workers[i].slots);
+      X_THREAD_FREE(pool->workers);
     }
 
     X_THREAD_FREE(pool);
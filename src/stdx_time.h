@@ -9,6 +9,23 @@
  * Provides a portable threading abstraction for C programs.
  * Includes Time based comparisson, measurement and arithmetic ooperations
  *
+ * ## Ticks
+ *
+ * For measuring short intervals, x_ticks_now() reads a raw integer counter:
+ * the time stamp counter on x86 when cpuid reports it invariant, the
+ * virtual counter on ARM64, and CLOCK_MONOTONIC or QueryPerformanceCounter
+ * otherwise. All three are synchronized across cores, so ticks taken on
+ * different threads compare. x_ticks_frequency() gives the rate (measured
+ * against the monotonic clock for the TSC, on first use, taking up to
+ * 10 ms) and x_ticks_to_ns() converts without floating point.
+ *
+ *     uint64_t t0 = x_ticks_now();
+ *     work();
+ *     uint64_t ns = x_ticks_to_ns(x_ticks_now() - t0);
+ *
+ * x_time_monotonic_ns() and x_time_now_ns() are the OS clocks as integer
+ * nanoseconds.
+ *
  * ## How to compile
  *
  * To compile the implementation define `X_IMPL_TIME`
@@ -24,9 +41,10 @@
 #define X_TIME_VERSION_PATCH 0
 #define X_TIME_VERSION (X_TIME_VERSION_MAJOR * 10000 + X_TIME_VERSION_MINOR * 100 + X_TIME_VERSION_PATCH)
 
+#include <stdint.h>
+#include <stdbool.h>
 #ifdef _WIN32
 #include <windows.h>
-#include <stdint.h>
 #else
 #include <time.h>
 #include <unistd.h>
@@ -41,6 +59,13 @@ extern "C" {
     double seconds;
   } XTime;
 
+  typedef enum XTickSource
+  {
+    X_TICKS_OS,       // CLOCK_MONOTONIC (nanoseconds) or QueryPerformanceCounter
+    X_TICKS_TSC,      // invariant x86 time stamp counter
+    X_TICKS_CNTVCT,   // ARM64 generic timer virtual count
+  } XTickSource;
+
   typedef struct XTimer_t
   {
 #ifdef _WIN32
@@ -139,16 +164,182 @@ extern "C" {
    */
   XTime x_time_now(void);
 
+  /**
+   * @brief Get the current wall-clock time in integer nanoseconds.
+   * @return Nanoseconds since the Unix epoch.
+   */
+  int64_t x_time_now_ns(void);
+
+  /**
+   * @brief Read the monotonic OS clock in integer nanoseconds.
+   * @return Nanoseconds since an arbitrary fixed point.
+   */
+  uint64_t x_time_monotonic_ns(void);
+
+  /**
+   * @brief Convert a time value to integer nanoseconds.
+   * @param t Time value to convert.
+   * @return Nanoseconds, rounded to nearest.
+   */
+  int64_t x_time_to_ns(XTime t);
+
+  /**
+   * @brief Build a time value from integer nanoseconds.
+   * @param ns Nanoseconds.
+   * @return Time value.
+   */
+  XTime x_time_from_ns(int64_t ns);
+
+  /**
+   * @brief Read the high-resolution tick counter.
+   * @return Current tick count. Only differences are meaningful.
+   */
+  uint64_t x_ticks_now(void);
+
+  /**
+   * @brief Get the rate of x_ticks_now().
+   * Calibrated on first use; the first call may sleep up to 10 ms.
+   * @return Ticks per second.
+   */
+  uint64_t x_ticks_frequency(void);
+
+  /**
+   * @brief Convert a tick count to nanoseconds.
+   * @param ticks Tick count, usually a difference of x_ticks_now() values.
+   * @return Nanoseconds.
+   */
+  uint64_t x_ticks_to_ns(uint64_t ticks);
+
+  /**
+   * @brief Convert nanoseconds to a tick count.
+   * @param ns Nanoseconds.
+   * @return Ticks.
+   */
+  uint64_t x_ticks_from_ns(uint64_t ns);
+
+  /**
+   * @brief Tell which counter x_ticks_now() reads.
+   * @return The tick source chosen for this machine.
+   */
+  XTickSource x_ticks_source(void);
+
 #ifdef __cplusplus
 }
 #endif
 
 #ifdef X_IMPL_TIME
 
+#include "stdx_cpuid.h"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define X_TIME_LOAD_I64(p)        InterlockedCompareExchange64((volatile LONG64*)(p), 0, 0)
+#define X_TIME_STORE_I64(p, v)    InterlockedExchange64((volatile LONG64*)(p), (v))
+#define X_TIME_CAS_I64(p, e, d)   (InterlockedCompareExchange64((volatile LONG64*)(p), (d), (e)) == (e))
+#define X_TIME_PAUSE()            YieldProcessor()
+#else
+#define X_TIME_LOAD_I64(p)        __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define X_TIME_STORE_I64(p, v)    __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define X_TIME_CAS_I64(p, e, d)   __extension__({ int64_t x_time_e_ = (e); \
+    __atomic_compare_exchange_n((p), &x_time_e_, (d), false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE); })
+#define X_TIME_PAUSE()            ((void)0)
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+  /* Tick source + 1 once detected, -1 while a thread detects it */
+  static volatile int64_t s_x_ticks_mode = 0;
+  static volatile int64_t s_x_ticks_freq = 0;
+  /* Counter and monotonic clock read together at detection, for calibration */
+  static uint64_t s_x_ticks_base;
+  static uint64_t s_x_ticks_base_ns;
+
+  static inline uint64_t s_x_ticks_read(XTickSource source)
+  {
+#if X_CPUID_SUPPORTED && defined(_MSC_VER)
+    if (source == X_TICKS_TSC) return __rdtsc();
+#elif X_CPUID_SUPPORTED
+    if (source == X_TICKS_TSC) return __builtin_ia32_rdtsc();
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+    if (source == X_TICKS_CNTVCT)
+    {
+      uint64_t v;
+      __asm__ __volatile__("mrs %0, cntvct_el0" : "=r"(v));
+      return v;
+    }
+#endif
+    (void)source;
+#ifdef _WIN32
+    LARGE_INTEGER c;
+    QueryPerformanceCounter(&c);
+    return (uint64_t)c.QuadPart;
+#else
+    return x_time_monotonic_ns();
+#endif
+  }
+
+  static XTickSource s_x_ticks_detect(void)
+  {
+    for (;;)
+    {
+      int64_t mode = X_TIME_LOAD_I64(&s_x_ticks_mode);
+      if (mode > 0)
+        return (XTickSource)(mode - 1);
+      if (mode == 0 && X_TIME_CAS_I64(&s_x_ticks_mode, 0, -1))
+        break;
+      X_TIME_PAUSE();
+    }
+
+    XTickSource source = X_TICKS_OS;
+#if X_CPUID_SUPPORTED
+    if (x_cpu_has_invariant_tsc()) source = X_TICKS_TSC;
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+    source = X_TICKS_CNTVCT;
+#endif
+    s_x_ticks_base_ns = x_time_monotonic_ns();
+    s_x_ticks_base = s_x_ticks_read(source);
+    X_TIME_STORE_I64(&s_x_ticks_mode, (int64_t)source + 1);
+    return source;
+  }
+
+  static uint64_t s_x_ticks_calibrate(XTickSource source)
+  {
+    if (source == X_TICKS_CNTVCT)
+    {
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__aarch64__)
+      uint64_t f;
+      __asm__ __volatile__("mrs %0, cntfrq_el0" : "=r"(f));
+      return f;
+#endif
+    }
+
+    if (source == X_TICKS_TSC)
+    {
+      uint64_t f = x_cpu_tsc_frequency();
+      if (f) return f;
+
+      // Not enumerated (common under hypervisors): measure against the OS clock
+      uint64_t ns = x_time_monotonic_ns() - s_x_ticks_base_ns;
+      if (ns < 10000000)
+      {
+        x_time_sleep((XTime){ .seconds = (10000000 - ns) / 1e9 });
+        ns = x_time_monotonic_ns() - s_x_ticks_base_ns;
+      }
+      uint64_t ticks = s_x_ticks_read(source) - s_x_ticks_base;
+      return (uint64_t)((double)ticks * 1e9 / (double)ns + 0.5);
+    }
+
+#ifdef _WIN32
+    LARGE_INTEGER f;
+    QueryPerformanceFrequency(&f);
+    return (uint64_t)f.QuadPart;
+#else
+    return 1000000000u;
+#endif
+  }
+
   // Start the timer
   void x_timer_start(XTimer* t)
   {
@@ -251,6 +442,93 @@ extern "C" {
 #endif
   }
 
+  int64_t x_time_now_ns(void)
+  {
+#ifdef _WIN32
+    FILETIME ft;
+    GetSystemTimeAsFileTime(&ft);
+    uint64_t ticks = ((uint64_t)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+    return ((int64_t)ticks - 116444736000000000ll) * 100;  // FILETIME counts 100 ns since 1601
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+#endif
+  }
+
+  uint64_t x_time_monotonic_ns(void)
+  {
+#ifdef _WIN32
+    static volatile int64_t freq = 0;
+    int64_t f = X_TIME_LOAD_I64(&freq);
+    if (f == 0)
+    {
+      LARGE_INTEGER qpf;
+      QueryPerformanceFrequency(&qpf);
+      f = qpf.QuadPart;
+      X_TIME_STORE_I64(&freq, f);
+    }
+    LARGE_INTEGER c;
+    QueryPerformanceCounter(&c);
+    uint64_t q = (uint64_t)c.QuadPart / (uint64_t)f;
+    uint64_t r = (uint64_t)c.QuadPart % (uint64_t)f;
+    return q * 1000000000u + r * 1000000000u / (uint64_t)f;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+#endif
+  }
+
+  int64_t x_time_to_ns(XTime t)
+  {
+    double ns = t.seconds * 1e9;
+    return (int64_t)(ns < 0.0 ? ns - 0.5 : ns + 0.5);
+  }
+
+  XTime x_time_from_ns(int64_t ns)
+  {
+    return (XTime){ .seconds = (double)ns / 1e9 };
+  }
+
+  uint64_t x_ticks_now(void)
+  {
+    int64_t mode = X_TIME_LOAD_I64(&s_x_ticks_mode);
+    XTickSource source = mode > 0 ? (XTickSource)(mode - 1) : s_x_ticks_detect();
+    return s_x_ticks_read(source);
+  }
+
+  uint64_t x_ticks_frequency(void)
+  {
+    int64_t f = X_TIME_LOAD_I64(&s_x_ticks_freq);
+    if (f > 0)
+      return (uint64_t)f;
+    f = (int64_t)s_x_ticks_calibrate(s_x_ticks_detect());
+    // Threads calibrating at once all use the first result
+    if (!X_TIME_CAS_I64(&s_x_ticks_freq, 0, f))
+      f = X_TIME_LOAD_I64(&s_x_ticks_freq);
+    return (uint64_t)f;
+  }
+
+  uint64_t x_ticks_to_ns(uint64_t ticks)
+  {
+    uint64_t f = x_ticks_frequency();
+    if (f == 1000000000u) return ticks;
+    return ticks / f * 1000000000u + ticks % f * 1000000000u / f;
+  }
+
+  uint64_t x_ticks_from_ns(uint64_t ns)
+  {
+    uint64_t f = x_ticks_frequency();
+    if (f == 1000000000u) return ns;
+    return ns / 1000000000u * f + ns % 1000000000u * f / 1000000000u;
+  }
+
+  XTickSource x_ticks_source(void)
+  {
+    return s_x_ticks_detect();
+  }
+
 #ifdef __cplusplus
 }
 #endif
@@ -4,9 +4,12 @@
  * License: MIT
  * https://github.com/marciovmf/stdx
  *
- * To compile the implementation define X_IMPL_IO
+ * To compile the implementation define X_IMPL_TML
  * in **one** source file before including this header.
  *
+ * Dependencies: stdx_io.h (x_tml_save_binary / x_tml_load_binary,
+ * implementation required).
+ *
  *  TML is a minimal, indentation-based hierarchical data format.
  *  It borrows the readability of YAML but is parsed in a single pass,
  *  with one arena allocation for all internal data.
@@ -26,7 +29,33 @@
  *  - Single memory allocation (arena-style).
  *  - Linear-time parsing with no dynamic allocations.
  *  - Typed key/value decoding (bool, int, float, string, array).
- * 
+ *
+ *  Lookups walk sibling lists and entry ranges. Loading with
+ *  XTML_OPEN_INDEX also builds hash indexes for children and keys, plus a
+ *  flat child table, in the same allocation: x_tml_find_child,
+ *  x_tml_child_at, x_tml_get_* and dot-path lookups become O(1) per step.
+ *  Paths queried repeatedly can be parsed once with x_tml_path_compile and
+ *  resolved with x_tml_path_resolve.
+ *
+ *  Binary form:
+ *  x_tml_save_binary writes the parsed tables (nodes, entries, typed
+ *  arrays, the index when present) and the source text to a versioned
+ *  blob that uses offsets instead of pointers. x_tml_load_binary maps the
+ *  file and uses the tables in place: nothing is parsed, and only the
+ *  string-array slices are rebuilt, in one small allocation. Blobs are
+ *  native-endian and tied to this header's struct layout; a blob from a
+ *  different version, byte order or layout is rejected. Only the header
+ *  and table bounds are checked, so load blobs you wrote yourself.
+ *
+ *  Streaming:
+ *  x_tml_stream_* parses a document pushed in chunks of any size (or read
+ *  from an XReader) and reports it through callbacks instead of building
+ *  a tree: section begin/end, key/value, array begin/element/end. Memory
+ *  is bounded by the longest line or triple-quoted string, capped at
+ *  max_record bytes. Values are decoded exactly as x_tml_load does,
+ *  except that each array element keeps its own type and duplicate
+ *  sections are not detected, since nothing is kept once reported.
+ *
  * Example:
  *
  * level:
@@ -47,6 +76,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "stdx_io.h"
+
 #ifndef X_TML_API
 #define X_TML_API
 #endif
@@ -80,9 +111,42 @@ extern "C" {
 
   enum
   {
-    XTML_OPEN_DEFAULT = 0u
+    XTML_OPEN_DEFAULT = 0u,
+    XTML_OPEN_INDEX   = 1u << 0  /* build child/key hash indexes at load */
   };
 
+#ifndef X_TML_PATH_MAX_SEGMENTS
+  /**
+   * @brief Maximum number of segments in a compiled path.
+   * Can be overriden before including this header.
+   */
+#define X_TML_PATH_MAX_SEGMENTS 16
+#endif
+
+#ifndef X_TML_PATH_MAX_LENGTH
+  /**
+   * @brief Maximum length of the text of a compiled path.
+   * Can be overriden before including this header.
+   */
+#define X_TML_PATH_MAX_LENGTH 256
+#endif
+
+  typedef struct XTmlPathSeg
+  {
+    uint32_t off;    /* name offset in XTmlPath.text */
+    uint32_t len;
+    uint32_t hash;
+    uint32_t index;  /* child index for numeric segments, UINT32_MAX for names */
+  } XTmlPathSeg;
+
+  /* A dot-path parsed once; holds a copy of its text */
+  typedef struct XTmlPath
+  {
+    uint32_t    seg_count;
+    XTmlPathSeg segs[X_TML_PATH_MAX_SEGMENTS];
+    char        text[X_TML_PATH_MAX_LENGTH];
+  } XTmlPath;
+
   X_TML_API int  x_tml_load(const char *buf, uint32_t size, uint32_t flags, XTml **out_tml);
   X_TML_API void x_tml_unload(XTml *tml);
   X_TML_API XTmlCursor x_tml_root(XTml *tml);
@@ -92,6 +156,10 @@ extern "C" {
   X_TML_API int x_tml_find_child(XTml *tml, XTmlCursor cur, const char *name, uint32_t name_len, XTmlCursor *out_child);
   X_TML_API int x_tml_section_name(XTml *tml, XTmlCursor cur, const char **out_name, uint32_t *out_len);
 
+  /* Same syntax as x_tml_get_section; fails if the path has too many segments or is too long */
+  X_TML_API int x_tml_path_compile(const char *dot_path, XTmlPath *out_path);
+  X_TML_API int x_tml_path_resolve(XTml *tml, XTmlCursor parent, const XTmlPath *path, XTmlCursor *out);
+
   X_TML_API int x_tml_entry_count (XTml *tml, XTmlCursor cur, uint32_t *out_count);
   X_TML_API int x_tml_entry_key_at(XTml *tml, XTmlCursor cur, uint32_t index, const char **out_key, uint32_t *out_key_len);
 
@@ -107,6 +175,57 @@ extern "C" {
   X_TML_API int x_tml_has_key(XTml *tml, XTmlCursor cur, const char *key);
   X_TML_API int x_tml_dump(XTml *tml, void *f /* FILE* ou stdout if NULL */);
 
+  /* A decoded value as reported by the stream parser */
+  typedef struct XTmlScalar
+  {
+    XTmlValKind kind;   /* XTML_V_STR, XTML_V_I64, XTML_V_F64 or XTML_V_BOOL */
+    const char *str;    /* XTML_V_STR; not null-terminated, valid during the callback only */
+    uint32_t    len;
+    int64_t     i64;
+    double      f64;
+    int         boolean;
+  } XTmlScalar;
+
+  /* Any callback may be NULL. Returning 0 stops the parse. Names and keys
+     are valid during the callback only. */
+  typedef struct XTmlStreamCallbacks
+  {
+    int (*section_begin)(void *user, const char *name, uint32_t name_len); /* name_len 0 for "-" items */
+    int (*section_end)(void *user);
+    int (*key_value)(void *user, const char *key, uint32_t key_len, const XTmlScalar *value);
+    int (*array_begin)(void *user, const char *key, uint32_t key_len);
+    int (*array_element)(void *user, const XTmlScalar *value);
+    int (*array_end)(void *user);
+  } XTmlStreamCallbacks;
+
+  typedef struct XTmlStream XTmlStream;
+
+#ifndef X_TML_STREAM_MAX_RECORD
+  /**
+   * @brief Default longest line or triple-quoted string a stream accepts.
+   * Can be overriden before including this header.
+   */
+#define X_TML_STREAM_MAX_RECORD (64u * 1024u)
+#endif
+
+  /* max_record 0 picks X_TML_STREAM_MAX_RECORD */
+  X_TML_API XTmlStream *x_tml_stream_create(const XTmlStreamCallbacks *callbacks, void *user, uint32_t max_record);
+  X_TML_API void x_tml_stream_destroy(XTmlStream *stream);
+  /* Returns 0 once the input is invalid, a record is too long or a callback stopped the parse */
+  X_TML_API int  x_tml_stream_feed(XTmlStream *stream, const char *data, size_t len);
+  /* Ends the input: reports the last line and closes every open section */
+  X_TML_API int  x_tml_stream_finish(XTmlStream *stream);
+  /* Feeds every line of reader, then finishes */
+  X_TML_API int  x_tml_stream_read(XTmlStream *stream, XReader *reader);
+  /* 1-based number of the line being parsed, or of the line that failed */
+  X_TML_API uint32_t x_tml_stream_line(const XTmlStream *stream);
+
+  /* Binary form; the loaded XTml is used exactly like one from x_tml_load */
+  X_TML_API int x_tml_save_binary(XTml *tml, const char *path);
+  X_TML_API int x_tml_load_binary(const char *path, XTml **out_tml);
+  /* Uses data in place: it must stay alive, unchanged and 8-byte aligned until x_tml_unload */
+  X_TML_API int x_tml_load_binary_mem(const void *data, size_t size, XTml **out_tml);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif
@@ -118,6 +237,15 @@ extern "C" {
 #include <ctype.h>
 #include <stdio.h>
 
+#ifdef X_PROFILE_LIBRARY
+#include "stdx_profile.h"
+#define X_TML_PROFILE_BEGIN(name) X_PROFILE_BEGIN(name)
+#define X_TML_PROFILE_END() X_PROFILE_END()
+#else
+#define X_TML_PROFILE_BEGIN(name) ((void)0)
+#define X_TML_PROFILE_END() ((void)0)
+#endif
+
 #ifndef X_TML_ALLOC
 #define X_TML_ALLOC(sz)        malloc(sz)
 #define X_TML_FREE(p)          free(p)
@@ -159,6 +287,8 @@ extern "C" {
     int32_t  next_sibling;
     uint32_t kv_start;
     uint32_t kv_count;
+    int32_t  last_child;
+    uint32_t child_count;
   } XTmlNode;
 
   struct XTml
@@ -168,6 +298,8 @@ extern "C" {
 
     void      *arena;
     uint32_t   arena_size;
+    uint32_t   flags;
+    uint32_t   root_child_count;
 
     XTmlNode  *nodes;
     uint32_t   node_count;
@@ -183,6 +315,20 @@ extern "C" {
 
     XTmlStrSlice *str_slices;
     uint32_t      str_slice_count;
+
+    /* XTML_OPEN_INDEX only. Slots hold (hash << 32) | (index + 1), 0 when empty */
+    uint64_t  *child_slots;
+    uint32_t   child_mask;
+    uint64_t  *kv_slots;
+    uint32_t   kv_mask;
+
+    /* Children grouped by parent; the group of node n starts at
+       child_first[n + 1], the root's at child_first[0] */
+    uint32_t  *child_order;
+    uint32_t  *child_first;
+
+    /* x_tml_load_binary only */
+    XFileMapping *mapping;
   };
 
   /* Arena */
@@ -294,18 +440,38 @@ extern "C" {
     return n;
   }
 
-  static int s_tml_find_child_linear(XTml *tml,
-      int parent_idx,
-      const char *name,
-      uint32_t len)
+  /* Mixes the parent into a name or key hash for the index tables */
+  static uint32_t s_tml_index_hash(int parent, uint32_t hash)
   {
-    if (len == 0)
+    uint32_t h = hash ^ ((uint32_t)(parent + 1) * 0x9E3779B1u);
+
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+
+    return h;
+  }
+
+  static void s_tml_index_insert(uint64_t *slots, uint32_t mask, uint32_t h, uint32_t idx)
+  {
+    uint32_t i = h & mask;
+
+    while (slots[i])
     {
-      return -1;
+      i = (i + 1) & mask;
     }
 
-    uint32_t h = s_tml_hash32(name, len);
+    slots[i] = ((uint64_t)h << 32) | (uint64_t)(idx + 1u);
+  }
 
+  static int s_tml_find_child_linear(const XTml *tml,
+      int parent_idx,
+      const char *name,
+      uint32_t len,
+      uint32_t h)
+  {
     if (parent_idx < 0)
     {
       for (uint32_t i = 0; i < tml->node_count; i++)
@@ -353,6 +519,103 @@ extern "C" {
     return -1;
   }
 
+  /* h is s_tml_hash32 of the name */
+  static int s_tml_find_child(const XTml *tml,
+      int parent_idx,
+      const char *name,
+      uint32_t len,
+      uint32_t h)
+  {
+    if (len == 0)
+    {
+      return -1;
+    }
+
+    if (!tml->child_slots)
+    {
+      return s_tml_find_child_linear(tml, parent_idx, name, len, h);
+    }
+
+    uint32_t ih = s_tml_index_hash(parent_idx, h);
+    uint32_t i = ih & tml->child_mask;
+
+    for (;;)
+    {
+      uint64_t slot = tml->child_slots[i];
+
+      if (!slot)
+      {
+        return -1;
+      }
+
+      if ((uint32_t)(slot >> 32) == ih)
+      {
+        int idx = (int)((uint32_t)slot - 1u);
+        const XTmlNode *nd = &tml->nodes[idx];
+
+        if (nd->parent == parent_idx && nd->name_len == len &&
+            memcmp(tml->text + nd->name_off, name, len) == 0)
+        {
+          return idx;
+        }
+      }
+
+      i = (i + 1) & tml->child_mask;
+    }
+  }
+
+  static int s_tml_child_at(const XTml *tml, int parent_idx, uint32_t index)
+  {
+    if (tml->child_order)
+    {
+      uint32_t group = (uint32_t)(parent_idx + 1);
+      uint32_t first = tml->child_first[group];
+
+      if (index >= tml->child_first[group + 1] - first)
+      {
+        return -1;
+      }
+
+      return (int)tml->child_order[first + index];
+    }
+
+    if (parent_idx < 0)
+    {
+      uint32_t count = 0;
+
+      for (uint32_t i = 0; i < tml->node_count; i++)
+      {
+        if (tml->nodes[i].parent == -1)
+        {
+          if (count == index)
+          {
+            return (int)i;
+          }
+
+          count++;
+        }
+      }
+
+      return -1;
+    }
+
+    int32_t it = tml->nodes[parent_idx].first_child;
+    uint32_t k = 0;
+
+    while (it >= 0)
+    {
+      if (k == index)
+      {
+        return it;
+      }
+
+      k++;
+      it = tml->nodes[it].next_sibling;
+    }
+
+    return -1;
+  }
+
   static int s_tml_add_child(XTml *tml,
       int parent_idx,
       uint32_t name_off,
@@ -372,29 +635,75 @@ extern "C" {
     n->next_sibling = -1;
     n->kv_start = 0;
     n->kv_count = 0;
+    n->last_child = -1;
+    n->child_count = 0;
 
     if (parent_idx >= 0)
     {
-      if (tml->nodes[parent_idx].first_child < 0)
+      XTmlNode *pn = &tml->nodes[parent_idx];
+
+      if (pn->first_child < 0)
       {
-        tml->nodes[parent_idx].first_child = idx;
+        pn->first_child = idx;
       }
       else
       {
-        int32_t it = tml->nodes[parent_idx].first_child;
+        tml->nodes[pn->last_child].next_sibling = idx;
+      }
 
-        while (tml->nodes[it].next_sibling >= 0)
-        {
-          it = tml->nodes[it].next_sibling;
-        }
+      pn->last_child = idx;
+      pn->child_count++;
+    }
+    else
+    {
+      tml->root_child_count++;
+    }
 
-        tml->nodes[it].next_sibling = idx;
-      }
+    if (tml->child_slots && name_len)
+    {
+      s_tml_index_insert(tml->child_slots, tml->child_mask,
+          s_tml_index_hash(parent_idx, n->name_hash), (uint32_t)idx);
     }
 
     return idx;
   }
 
+  /* Key index and flat child table, once all nodes and entries exist */
+  static void s_tml_build_index(XTml *tml)
+  {
+    for (uint32_t n = 0; n < tml->node_count; n++)
+    {
+      const XTmlNode *nd = &tml->nodes[n];
+
+      for (uint32_t i = nd->kv_start; i < nd->kv_start + nd->kv_count; i++)
+      {
+        const XTmlKV *kv = &tml->kvs[i];
+        uint32_t h = s_tml_hash32(tml->text + kv->key_off, kv->key_len);
+
+        s_tml_index_insert(tml->kv_slots, tml->kv_mask, s_tml_index_hash((int)n, h), i);
+      }
+    }
+
+    /* Counting sort by parent: child_first[g] ends as the start of group g */
+    uint32_t groups = tml->node_count + 1u;
+    uint32_t *first = tml->child_first;
+
+    first[0] = tml->root_child_count;
+
+    for (uint32_t n = 0; n < tml->node_count; n++)
+    {
+      first[n + 1] = first[n] + tml->nodes[n].child_count;
+    }
+
+    for (uint32_t n = tml->node_count; n-- > 0;)
+    {
+      uint32_t group = (uint32_t)(tml->nodes[n].parent + 1);
+      tml->child_order[--first[group]] = n;
+    }
+
+    first[groups] = tml->node_count;
+  }
+
   static void s_tml_dump_section(XTml *tml, int node, int depth, FILE *f)
   {
     const XTmlNode *nd = &tml->nodes[node];
@@ -686,8 +995,22 @@ extern "C" {
         if (p[0] == '-')
         {
           out->headers++;
-          i += l + ((i + l) < len ? 1u : 0u);
-          continue;
+
+          /* "- key: value" also holds an entry */
+          uint32_t sk = 1u;
+          while (sk < pl && (p[sk] == ' ' || p[sk] == '\t'))
+          {
+            sk++;
+          }
+
+          if (sk >= pl)
+          {
+            i += l + ((i + l) < len ? 1u : 0u);
+            continue;
+          }
+
+          p += sk;
+          pl -= sk;
         }
 
         uint32_t pos = UINT32_MAX;
@@ -783,6 +1106,142 @@ extern "C" {
     }
   }
 
+  /* Typed decoding, shared by x_tml_load and the stream parser */
+
+  static int s_tml_looks_int(const char *p, uint32_t len)
+  {
+    for (uint32_t q = 0; q < len; q++)
+    {
+      char c = p[q];
+      if (c == '.' || c == 'e' || c == 'E')
+      {
+        return 0;
+      }
+    }
+
+    return 1;
+  }
+
+  /* One trimmed array element: quoted string, i64, f64 or bare string */
+  static void s_tml_decode_element(const char *ep, uint32_t el, XTmlScalar *out)
+  {
+    memset(out, 0, sizeof(*out));
+    out->kind = XTML_V_STR;
+    out->str = ep;
+    out->len = el;
+
+    if (ep[0] == '"' && el >= 2 && ep[el - 1] == '"')
+    {
+      out->str = ep + 1;
+      out->len = el - 2;
+      return;
+    }
+
+    if (s_tml_looks_int(ep, el))
+    {
+      out->kind = XTML_V_I64;
+      out->i64 = (int64_t)strtoll(ep, NULL, 10);
+      return;
+    }
+
+    char *endp = NULL;
+    double dv = strtod(ep, &endp);
+
+    if (endp == ep + (ptrdiff_t)el)
+    {
+      out->kind = XTML_V_F64;
+      out->f64 = dv;
+    }
+  }
+
+  /* A trimmed scalar value: bool, i64, f64, quoted or bare string */
+  static void s_tml_decode_scalar(const char *vp, uint32_t vl, XTmlScalar *out)
+  {
+    memset(out, 0, sizeof(*out));
+
+    if ((vl == 4 && memcmp(vp, "true", 4) == 0) ||
+        (vl == 5 && memcmp(vp, "false", 5) == 0))
+    {
+      out->kind = XTML_V_BOOL;
+      out->boolean = (vl == 4) ? 1 : 0;
+      return;
+    }
+
+    if (s_tml_looks_int(vp, vl))
+    {
+      out->kind = XTML_V_I64;
+      out->i64 = (int64_t)strtoll(vp, NULL, 10);
+      return;
+    }
+
+    char *endp = NULL;
+    double dv = strtod(vp, &endp);
+
+    if (endp == vp + (ptrdiff_t)vl)
+    {
+      out->kind = XTML_V_F64;
+      out->f64 = dv;
+      return;
+    }
+
+    out->kind = XTML_V_STR;
+
+    if (vl >= 2 && vp[0] == '"' && vp[vl - 1] == '"')
+    {
+      out->str = vp + 1;
+      out->len = vl - 2;
+    }
+    else
+    {
+      out->str = vp;
+      out->len = vl;
+    }
+  }
+
+  /* Has a comma outside double quotes */
+  static int s_tml_has_comma(const char *vp, uint32_t vl)
+  {
+    int in_str_q = 0;
+
+    for (uint32_t t = 0; t < vl; t++)
+    {
+      char c = vp[t];
+      if (c == '"')
+      {
+        in_str_q = !in_str_q;
+      }
+      if (c == ',' && !in_str_q)
+      {
+        return 1;
+      }
+    }
+
+    return 0;
+  }
+
+  /* Length of the next element of vp starting at start, up to an unquoted comma */
+  static uint32_t s_tml_element_end(const char *vp, uint32_t vl, uint32_t start)
+  {
+    uint32_t end = start;
+    int inq = 0;
+
+    while (end < vl)
+    {
+      char c = vp[end];
+      if (c == '"')
+      {
+        inq = !inq;
+      }
+      if (c == ',' && !inq)
+      {
+        break;
+      }
+      end++;
+    }
+
+    return end;
+  }
+
   /* Parser (UNIT=2 or 4, tabs are invalid) */
   typedef struct s_stack_entry
   {
@@ -798,13 +1257,23 @@ extern "C" {
     return c;
   }
 
-  X_TML_API int x_tml_load(const char *buf,
+  static uint32_t s_tml_index_capacity(uint32_t count)
+  {
+    uint32_t cap = 16u;
+
+    while (cap < count * 2u)
+    {
+      cap *= 2u;
+    }
+
+    return cap;
+  }
+
+  static int s_tml_load(const char *buf,
       uint32_t size,
       uint32_t flags,
       XTml **out_tml)
   {
-    (void)flags;
-
     if (!buf || !out_tml || !size)
     {
       return 0;
@@ -826,6 +1295,16 @@ extern "C" {
     arena_bytes += max_nums * (uint32_t)sizeof(int64_t);
     arena_bytes += max_strs * (uint32_t)sizeof(XTmlStrSlice);
 
+    int indexed = (flags & XTML_OPEN_INDEX) != 0;
+    uint32_t child_cap = indexed ? s_tml_index_capacity(max_nodes) : 0u;
+    uint32_t kv_cap = indexed ? s_tml_index_capacity(max_kvs) : 0u;
+
+    if (indexed)
+    {
+      arena_bytes += (child_cap + kv_cap) * (uint32_t)sizeof(uint64_t);
+      arena_bytes += (max_nodes + max_nodes + 2u) * (uint32_t)sizeof(uint32_t);
+    }
+
     void *arena = X_TML_ALLOC(arena_bytes);
     if (!arena)
     {
@@ -839,6 +1318,8 @@ extern "C" {
     tml->arena_size = arena_bytes;
     tml->text = buf;
     tml->text_len = size;
+    tml->flags = flags;
+    tml->root_child_count = 0;
 
     tml->nodes = (XTmlNode *)s_tml_arena_alloc(arena, &off, max_nodes * (uint32_t)sizeof(XTmlNode), arena_bytes);
     tml->node_count = 0;
@@ -855,6 +1336,25 @@ extern "C" {
     tml->str_slices = (XTmlStrSlice *)s_tml_arena_alloc(arena, &off, max_strs * (uint32_t)sizeof(XTmlStrSlice), arena_bytes);
     tml->str_slice_count = 0;
 
+    tml->child_slots = NULL;
+    tml->child_mask = 0;
+    tml->kv_slots = NULL;
+    tml->kv_mask = 0;
+    tml->child_order = NULL;
+    tml->child_first = NULL;
+    tml->mapping = NULL;
+
+    if (indexed)
+    {
+      tml->child_slots = (uint64_t *)s_tml_arena_alloc(arena, &off, child_cap * (uint32_t)sizeof(uint64_t), arena_bytes);
+      tml->child_mask = child_cap - 1u;
+      memset(tml->child_slots, 0, child_cap * sizeof(uint64_t));
+
+      tml->kv_slots = (uint64_t *)s_tml_arena_alloc(arena, &off, kv_cap * (uint32_t)sizeof(uint64_t), arena_bytes);
+      tml->kv_mask = kv_cap - 1u;
+      memset(tml->kv_slots, 0, kv_cap * sizeof(uint64_t));
+    }
+
     s_stack_entry stack[128];
     uint32_t sp = 0;
 
@@ -1022,7 +1522,7 @@ extern "C" {
           return 0;
         }
 
-        int exists = s_tml_find_child_linear(tml, cur_node, p, pos);
+        int exists = s_tml_find_child(tml, cur_node, p, pos, s_tml_hash32(p, pos));
         if (exists >= 0)
         {
           x_tml_unload(tml);
@@ -1231,27 +1731,12 @@ extern "C" {
       const char *vp = tml->text + raw_off;
       uint32_t vl = raw_len;
 
-      int has_comma = 0;
-      int in_str_q = 0;
+      int has_comma = s_tml_has_comma(vp, vl);
+
+      uint32_t vl2 = vl;
+      const char *vp2 = vp;
 
-      for (uint32_t t = 0; t < vl; t++)
-      {
-        char c = vp[t];
-        if (c == '"')
-        {
-          in_str_q = !in_str_q;
-        }
-        if (c == ',' && !in_str_q)
-        {
-          has_comma = 1;
-          break;
-        }
-      }
-
-      uint32_t vl2 = vl;
-      const char *vp2 = vp;
-
-      while (vl2 > 0 && (*vp2 == ' ' || *vp2 == '\t'))
+      while (vl2 > 0 && (*vp2 == ' ' || *vp2 == '\t'))
       {
         vp2++;
         vl2--;
@@ -1265,7 +1750,6 @@ extern "C" {
       if (has_comma)
       {
         uint32_t start = 0u;
-        int mode_f64 = 1;
         int mode_i64 = 1;
         int mode_str = 0;
 
@@ -1275,22 +1759,7 @@ extern "C" {
 
         while (start <= vl2)
         {
-          uint32_t end = start;
-          int inq = 0;
-
-          while (end < vl2)
-          {
-            char c = vp2[end];
-            if (c == '"')
-            {
-              inq = !inq;
-            }
-            if (c == ',' && !inq)
-            {
-              break;
-            }
-            end++;
-          }
+          uint32_t end = s_tml_element_end(vp2, vl2, start);
 
           const char *ep = vp2 + start;
           uint32_t el = end - start;
@@ -1308,58 +1777,28 @@ extern "C" {
 
           if (el > 0)
           {
-            if (ep[0] == '"' && el >= 2 && ep[el - 1] == '"')
+            XTmlScalar ev;
+            s_tml_decode_element(ep, el, &ev);
+
+            if (ev.kind == XTML_V_I64)
+            {
+              tml->nums_i64[tml->nums_i64_count] = ev.i64;
+              tml->nums_i64_count++;
+            }
+            else if (ev.kind == XTML_V_F64)
             {
+              tml->nums_f64[tml->nums_f64_count] = ev.f64;
+              tml->nums_f64_count++;
               mode_i64 = 0;
-              mode_f64 = 0;
-              mode_str = 1;
-
-              tml->str_slices[tml->str_slice_count].ptr = ep + 1;
-              tml->str_slices[tml->str_slice_count].len = el - 2;
-              tml->str_slice_count++;
             }
             else
             {
-              int is_int = 1;
-
-              for (uint32_t q = 0; q < el; q++)
-              {
-                char c2 = ep[q];
-                if (c2 == '.' || c2 == 'e' || c2 == 'E')
-                {
-                  is_int = 0;
-                  break;
-                }
-              }
-
-              if (is_int)
-              {
-                long long iv = strtoll(ep, NULL, 10);
-                tml->nums_i64[tml->nums_i64_count] = (int64_t)iv;
-                tml->nums_i64_count++;
-                mode_f64 = 0;
-              }
-              else
-              {
-                char *endp = NULL;
-                double dv = strtod(ep, &endp);
-                if (endp == ep + (ptrdiff_t)el)
-                {
-                  tml->nums_f64[tml->nums_f64_count] = dv;
-                  tml->nums_f64_count++;
-                  mode_i64 = 0;
-                }
-                else
-                {
-                  mode_i64 = 0;
-                  mode_f64 = 0;
-                  mode_str = 1;
+              mode_i64 = 0;
+              mode_str = 1;
 
-                  tml->str_slices[tml->str_slice_count].ptr = ep;
-                  tml->str_slices[tml->str_slice_count].len = el;
-                  tml->str_slice_count++;
-                }
-              }
+              tml->str_slices[tml->str_slice_count].ptr = ev.str;
+              tml->str_slices[tml->str_slice_count].len = ev.len;
+              tml->str_slice_count++;
             }
           }
 
@@ -1396,71 +1835,18 @@ extern "C" {
       }
       else
       {
-        if ((vl2 == 4 && memcmp(vp2, "true", 4) == 0) ||
-            (vl2 == 5 && memcmp(vp2, "false", 5) == 0))
-        {
-          kv->val.kind = XTML_V_BOOL;
-          kv->val.boolean = (vl2 == 4) ? 1 : 0;
-
-          if (tml->nodes[cur_node].kv_count == 0)
-          {
-            tml->nodes[cur_node].kv_start = tml->kv_count;
-          }
-
-          tml->kv_count++;
-          tml->nodes[cur_node].kv_count++;
+        XTmlScalar sv;
+        s_tml_decode_scalar(vp2, vl2, &sv);
 
-          if (did_multiline_array)
-          {
-            i = carry_next_i;
-            continue;
-          }
-
-          i += l + ((i + l) < size ? 1u : 0u);
-          continue;
-        }
-
-        int is_int = 1;
-        for (uint32_t q = 0; q < vl2; q++)
-        {
-          char c = vp2[q];
-          if (c == '.' || c == 'e' || c == 'E')
-          {
-            is_int = 0;
-            break;
-          }
-        }
+        kv->val.kind = sv.kind;
+        kv->val.i64 = sv.i64;
+        kv->val.f64 = sv.f64;
+        kv->val.boolean = sv.boolean;
 
-        if (is_int)
-        {
-          long long iv = strtoll(vp2, NULL, 10);
-          kv->val.kind = XTML_V_I64;
-          kv->val.i64 = (int64_t)iv;
-        }
-        else
+        if (sv.kind == XTML_V_STR)
         {
-          char *endp = NULL;
-          double dv = strtod(vp2, &endp);
-          if (endp == vp2 + (ptrdiff_t)vl2)
-          {
-            kv->val.kind = XTML_V_F64;
-            kv->val.f64 = dv;
-          }
-          else
-          {
-            if (vl2 >= 2 && vp2[0] == '"' && vp2[vl2 - 1] == '"')
-            {
-              kv->val.kind = XTML_V_STR;
-              kv->val.off = (uint32_t)((vp2 + 1) - tml->text);
-              kv->val.len = vl2 - 2;
-            }
-            else
-            {
-              kv->val.kind = XTML_V_STR;
-              kv->val.off = (uint32_t)(vp2 - tml->text);
-              kv->val.len = vl2;
-            }
-          }
+          kv->val.off = (uint32_t)(sv.str - tml->text);
+          kv->val.len = sv.len;
         }
       }
 
@@ -1481,10 +1867,29 @@ extern "C" {
       i += l + ((i + l) < size ? 1u : 0u);
     }
 
+    if (indexed)
+    {
+      /* The child table is built last so it never holds a partial tree */
+      tml->child_order = (uint32_t *)s_tml_arena_alloc(arena, &off, max_nodes * (uint32_t)sizeof(uint32_t), arena_bytes);
+      tml->child_first = (uint32_t *)s_tml_arena_alloc(arena, &off, (max_nodes + 2u) * (uint32_t)sizeof(uint32_t), arena_bytes);
+      s_tml_build_index(tml);
+    }
+
     *out_tml = tml;
     return 1;
   }
 
+  X_TML_API int x_tml_load(const char *buf,
+      uint32_t size,
+      uint32_t flags,
+      XTml **out_tml)
+  {
+    X_TML_PROFILE_BEGIN("x_tml_load");
+    int ok = s_tml_load(buf, size, flags, out_tml);
+    X_TML_PROFILE_END();
+    return ok;
+  }
+
   X_TML_API void x_tml_unload(XTml *tml)
   {
     if (!tml)
@@ -1494,6 +1899,11 @@ extern "C" {
 
     void *arena = tml->arena;
 
+    if (tml->mapping)
+    {
+      x_io_unmap(tml->mapping);
+    }
+
     X_TML_FREE(arena);
   }
 
@@ -1525,31 +1935,7 @@ extern "C" {
       return 0;
     }
 
-    uint32_t count = 0;
-
-    if (cur.node < 0)
-    {
-      for (uint32_t i = 0; i < tml->node_count; i++)
-      {
-        if (tml->nodes[i].parent == -1)
-        {
-          count++;
-        }
-      }
-
-      *out_count = count;
-      return 1;
-    }
-
-    int32_t it = tml->nodes[cur.node].first_child;
-
-    while (it >= 0)
-    {
-      count++;
-      it = tml->nodes[it].next_sibling;
-    }
-
-    *out_count = count;
+    *out_count = (cur.node < 0) ? tml->root_child_count : tml->nodes[cur.node].child_count;
 
     return 1;
   }
@@ -1562,43 +1948,16 @@ extern "C" {
       return 0;
     }
 
-    if (cur.node < 0)
-    {
-      uint32_t count = 0;
-
-      for (uint32_t i = 0; i < tml->node_count; i++)
-      {
-        if (tml->nodes[i].parent == -1)
-        {
-          if (count == index)
-          {
-            out_child->node = (int)i;
-            return 1;
-          }
-
-          count++;
-        }
-      }
+    int idx = s_tml_child_at(tml, cur.node, index);
 
+    if (idx < 0)
+    {
       return 0;
     }
 
-    int32_t it = tml->nodes[cur.node].first_child;
-    uint32_t k = 0;
-
-    while (it >= 0)
-    {
-      if (k == index)
-      {
-        out_child->node = it;
-        return 1;
-      }
-
-      k++;
-      it = tml->nodes[it].next_sibling;
-    }
+    out_child->node = idx;
 
-    return 0;
+    return 1;
   }
 
   X_TML_API int x_tml_find_child(XTml *tml, XTmlCursor cur,
@@ -1611,7 +1970,7 @@ extern "C" {
       return 0;
     }
 
-    int idx = s_tml_find_child_linear(tml, cur.node, name, name_len);
+    int idx = s_tml_find_child(tml, cur.node, name, name_len, s_tml_hash32(name, name_len));
 
     if (idx < 0)
     {
@@ -1623,6 +1982,29 @@ extern "C" {
     return 1;
   }
 
+  static int s_tml_segment_index(const char *seg, uint32_t slen, uint32_t *out_idx)
+  {
+    if (slen == 0u)
+    {
+      return 0;
+    }
+
+    uint32_t idx = 0;
+
+    for (uint32_t k = 0; k < slen; k++)
+    {
+      if (seg[k] < '0' || seg[k] > '9')
+      {
+        return 0;
+      }
+
+      idx = idx * 10u + (uint32_t)(seg[k] - '0');
+    }
+
+    *out_idx = idx;
+    return 1;
+  }
+
   /* dot-path: number => index */
   X_TML_API int x_tml_get_section(XTml *tml,
       XTmlCursor parent,
@@ -1646,41 +2028,22 @@ extern "C" {
       const char *seg = dot_path + offv[i];
       uint32_t slen = lenv[i];
 
-      int all_digits = (slen > 0u);
-
-      for (uint32_t k = 0; k < slen && all_digits; k++)
-      {
-        if (seg[k] < '0' || seg[k] > '9')
-        {
-          all_digits = 0;
-          break;
-        }
-      }
+      uint32_t idx = 0;
 
-      if (all_digits)
+      if (s_tml_segment_index(seg, slen, &idx))
       {
-        uint32_t idx = 0;
-
-        for (uint32_t k = 0; k < slen; k++)
-        {
-          idx = idx * 10u + (uint32_t)(seg[k] - '0');
-        }
-
-        XTmlCursor pc;
-        pc.node = cur;
-
-        XTmlCursor ch;
+        int child = s_tml_child_at(tml, cur, idx);
 
-        if (!x_tml_child_at(tml, pc, idx, &ch))
+        if (child < 0)
         {
           return 0;
         }
 
-        cur = ch.node;
+        cur = child;
       }
       else
       {
-        int child = s_tml_find_child_linear(tml, cur, seg, slen);
+        int child = s_tml_find_child(tml, cur, seg, slen, s_tml_hash32(seg, slen));
 
         if (child < 0)
         {
@@ -1696,6 +2059,86 @@ extern "C" {
     return 1;
   }
 
+  X_TML_API int x_tml_path_compile(const char *dot_path, XTmlPath *out_path)
+  {
+    if (!dot_path || !out_path)
+    {
+      return 0;
+    }
+
+    size_t plen = strlen(dot_path);
+
+    if (plen >= X_TML_PATH_MAX_LENGTH)
+    {
+      return 0;
+    }
+
+    uint32_t offv[X_TML_PATH_MAX_SEGMENTS + 1];
+    uint32_t lenv[X_TML_PATH_MAX_SEGMENTS + 1];
+    uint32_t n = s_tml_split_dotpath(dot_path, (uint32_t)plen, offv, lenv, X_TML_PATH_MAX_SEGMENTS + 1u);
+
+    if (n > X_TML_PATH_MAX_SEGMENTS)
+    {
+      return 0;
+    }
+
+    memcpy(out_path->text, dot_path, plen + 1u);
+    out_path->seg_count = n;
+
+    for (uint32_t i = 0; i < n; i++)
+    {
+      XTmlPathSeg *seg = &out_path->segs[i];
+      const char *name = dot_path + offv[i];
+
+      seg->off = offv[i];
+      seg->len = lenv[i];
+      seg->hash = s_tml_hash32(name, lenv[i]);
+
+      if (!s_tml_segment_index(name, lenv[i], &seg->index))
+      {
+        seg->index = UINT32_MAX;
+      }
+    }
+
+    return 1;
+  }
+
+  X_TML_API int x_tml_path_resolve(XTml *tml,
+      XTmlCursor parent,
+      const XTmlPath *path,
+      XTmlCursor *out)
+  {
+    if (!tml || !path || !out)
+    {
+      return 0;
+    }
+
+    int cur = parent.node;
+
+    for (uint32_t i = 0; i < path->seg_count; i++)
+    {
+      const XTmlPathSeg *seg = &path->segs[i];
+
+      if (seg->index != UINT32_MAX)
+      {
+        cur = s_tml_child_at(tml, cur, seg->index);
+      }
+      else
+      {
+        cur = s_tml_find_child(tml, cur, path->text + seg->off, seg->len, seg->hash);
+      }
+
+      if (cur < 0)
+      {
+        return 0;
+      }
+    }
+
+    out->node = cur;
+
+    return 1;
+  }
+
   static int s_tml_find_kv(const XTml *tml,
       int node,
       const char *key,
@@ -1713,6 +2156,37 @@ extern "C" {
 
     uint32_t klen = (uint32_t)strlen(key);
 
+    if (tml->kv_slots)
+    {
+      uint32_t ih = s_tml_index_hash(node, s_tml_hash32(key, klen));
+      uint32_t i = ih & tml->kv_mask;
+
+      for (;;)
+      {
+        uint64_t slot = tml->kv_slots[i];
+
+        if (!slot)
+        {
+          return 0;
+        }
+
+        uint32_t idx = (uint32_t)slot - 1u;
+
+        if ((uint32_t)(slot >> 32) == ih && idx >= start && idx < end)
+        {
+          const XTmlKV *kv = &tml->kvs[idx];
+
+          if (s_tml_str_equal(tml->text + kv->key_off, kv->key_len, key, klen))
+          {
+            *out_idx = idx;
+            return 1;
+          }
+        }
+
+        i = (i + 1) & tml->kv_mask;
+      }
+    }
+
     for (uint32_t i = start; i < end; i++)
     {
       const XTmlKV *kv = &tml->kvs[i];
@@ -2021,25 +2495,7 @@ extern "C" {
 
     while (start <= vl)
     {
-      uint32_t end = start;
-      int inq = 0;
-
-      while (end < vl)
-      {
-        char c = vp[end];
-
-        if (c == '"')
-        {
-          inq = !inq;
-        }
-
-        if (c == ',' && !inq)
-        {
-          break;
-        }
-
-        end++;
-      }
+      uint32_t end = s_tml_element_end(vp, vl, start);
 
       const char *ep = vp + start;
       uint32_t el = end - start;
@@ -2057,50 +2513,24 @@ extern "C" {
 
       if (el > 0)
       {
-        if (ep[0] == '"' && el >= 2 && ep[el - 1] == '"')
+        XTmlScalar ev;
+        s_tml_decode_element(ep, el, &ev);
+
+        if (ev.kind == XTML_V_I64)
         {
-          tml->str_slices[tml->str_slice_count].ptr = ep + 1;
-          tml->str_slices[tml->str_slice_count].len = el - 2;
-          tml->str_slice_count++;
+          tml->nums_i64[tml->nums_i64_count] = ev.i64;
+          tml->nums_i64_count++;
+        }
+        else if (ev.kind == XTML_V_F64)
+        {
+          tml->nums_f64[tml->nums_f64_count] = ev.f64;
+          tml->nums_f64_count++;
         }
         else
         {
-          int is_int = 1;
-
-          for (uint32_t q = 0; q < el; q++)
-          {
-            char c2 = ep[q];
-
-            if (c2 == '.' || c2 == 'e' || c2 == 'E')
-            {
-              is_int = 0;
-              break;
-            }
-          }
-
-          if (is_int)
-          {
-            long long iv = strtoll(ep, NULL, 10);
-            tml->nums_i64[tml->nums_i64_count] = (int64_t)iv;
-            tml->nums_i64_count++;
-          }
-          else
-          {
-            char *endp = NULL;
-            double dv = strtod(ep, &endp);
-
-            if (endp == ep + (ptrdiff_t)el)
-            {
-              tml->nums_f64[tml->nums_f64_count] = dv;
-              tml->nums_f64_count++;
-            }
-            else
-            {
-              tml->str_slices[tml->str_slice_count].ptr = ep;
-              tml->str_slices[tml->str_slice_count].len = el;
-              tml->str_slice_count++;
-            }
-          }
+          tml->str_slices[tml->str_slice_count].ptr = ev.str;
+          tml->str_slices[tml->str_slice_count].len = ev.len;
+          tml->str_slice_count++;
         }
       }
 
@@ -2328,43 +2758,906 @@ extern "C" {
       XTmlCursor cur,
       const char *key)
   {
-    const char *s = NULL;
-    uint32_t sl = 0;
+    if (!tml || !key)
+    {
+      return 0;
+    }
+
+    uint32_t idx = 0;
+
+    if (!s_tml_find_kv(tml, cur.node, key, &idx))
+    {
+      return 0;
+    }
+
+    return tml->kvs[idx].val.kind != XTML_V_NONE;
+  }
+
+  /* Streaming */
+
+  enum
+  {
+    X_TML_STREAM_NORMAL = 0,
+    X_TML_STREAM_ARRAY  = 1,   /* inside an array continued over lines */
+    X_TML_STREAM_TRIPLE = 2    /* inside a triple-quoted string */
+  };
+
+  struct XTmlStream
+  {
+    XTmlStreamCallbacks cb;
+    void     *user;
+
+    char     *line;         /* partial line carried between feeds */
+    uint32_t  line_len;
+    char     *value;        /* triple-quoted content so far */
+    uint32_t  value_len;
+    char     *key;          /* key of the pending triple-quoted value */
+    uint32_t  key_len;
+    uint32_t  cap;
+
+    uint32_t  mode;
+    uint32_t  unit;
+    uint32_t  depths[128];  /* open sections */
+    uint32_t  sp;
+    uint32_t  line_no;
+    int       failed;
+  };
 
-    if (x_tml_get_str(tml, cur, key, &s, &sl))
+  X_TML_API XTmlStream *x_tml_stream_create(const XTmlStreamCallbacks *callbacks, void *user, uint32_t max_record)
+  {
+    if (!callbacks)
     {
-      return 1;
+      return NULL;
     }
 
-    double f = 0.0;
+    uint32_t cap = max_record ? max_record : X_TML_STREAM_MAX_RECORD;
 
-    if (x_tml_get_f64(tml, cur, key, &f))
+    /* One block: the stream, then the line, value and key buffers (each + 1 for a NUL) */
+    XTmlStream *st = (XTmlStream *)X_TML_ALLOC(sizeof(XTmlStream) + 3u * ((size_t)cap + 1u));
+    if (!st)
     {
-      return 1;
+      return NULL;
     }
 
-    int64_t i = 0;
+    memset(st, 0, sizeof(*st));
+    st->cb = *callbacks;
+    st->user = user;
+    st->cap = cap;
+    st->line = (char *)(st + 1);
+    st->value = st->line + cap + 1;
+    st->key = st->value + cap + 1;
 
-    if (x_tml_get_i64(tml, cur, key, &i))
+    return st;
+  }
+
+  X_TML_API void x_tml_stream_destroy(XTmlStream *stream)
+  {
+    if (stream)
     {
-      return 1;
+      X_TML_FREE(stream);
+    }
+  }
+
+  X_TML_API uint32_t x_tml_stream_line(const XTmlStream *stream)
+  {
+    return stream ? stream->line_no : 0u;
+  }
+
+  static int s_tml_stream_fail(XTmlStream *st)
+  {
+    st->failed = 1;
+    return 0;
+  }
+
+  static int s_tml_stream_pop(XTmlStream *st)
+  {
+    st->sp--;
+
+    if (st->cb.section_end && !st->cb.section_end(st->user))
+    {
+      return s_tml_stream_fail(st);
+    }
+
+    return 1;
+  }
+
+  static int s_tml_stream_push(XTmlStream *st, uint32_t depth, const char *name, uint32_t len)
+  {
+    if (st->sp >= sizeof(st->depths) / sizeof(st->depths[0]))
+    {
+      return s_tml_stream_fail(st);
+    }
+
+    st->depths[st->sp++] = depth;
+
+    if (st->cb.section_begin && !st->cb.section_begin(st->user, name, len))
+    {
+      return s_tml_stream_fail(st);
+    }
+
+    return 1;
+  }
+
+  /* Reports the elements of one line of an array; the line must be null-terminated past vl */
+  static int s_tml_stream_elements(XTmlStream *st, const char *vp, uint32_t vl)
+  {
+    uint32_t start = 0u;
+
+    while (start < vl)
+    {
+      uint32_t end = s_tml_element_end(vp, vl, start);
+      const char *ep = vp + start;
+      uint32_t el = end - start;
+
+      while (el > 0 && (*ep == ' ' || *ep == '\t'))
+      {
+        ep++;
+        el--;
+      }
+
+      while (el > 0 && (ep[el - 1] == ' ' || ep[el - 1] == '\t' || ep[el - 1] == '\r'))
+      {
+        el--;
+      }
+
+      if (el > 0 && st->cb.array_element)
+      {
+        XTmlScalar ev;
+        s_tml_decode_element(ep, el, &ev);
+
+        if (!st->cb.array_element(st->user, &ev))
+        {
+          return s_tml_stream_fail(st);
+        }
+      }
+
+      start = end + 1u;
+    }
+
+    return 1;
+  }
+
+  static int s_tml_stream_array_end(XTmlStream *st)
+  {
+    st->mode = X_TML_STREAM_NORMAL;
+
+    if (st->cb.array_end && !st->cb.array_end(st->user))
+    {
+      return s_tml_stream_fail(st);
+    }
+
+    return 1;
+  }
+
+  /* Drops the newline after the opening and before the closing quotes, as x_tml_load does */
+  static int s_tml_stream_triple_end(XTmlStream *st, int closed)
+  {
+    const char *lo = st->value;
+    const char *hi = st->value + st->value_len;
+
+    if (lo < hi && *lo == '\r')
+    {
+      lo += (lo + 1 < hi && lo[1] == '\n') ? 2 : 1;
+    }
+    else if (lo < hi && *lo == '\n')
+    {
+      lo++;
+    }
+
+    if (closed && lo < hi)
+    {
+      if (hi[-1] == '\n')
+      {
+        hi -= (hi - 1 > lo && hi[-2] == '\r') ? 2 : 1;
+      }
+      else if (hi[-1] == '\r')
+      {
+        hi--;
+      }
+    }
+
+    st->mode = X_TML_STREAM_NORMAL;
+
+    if (st->cb.key_value)
+    {
+      XTmlScalar sv;
+      memset(&sv, 0, sizeof(sv));
+      sv.kind = XTML_V_STR;
+      sv.str = lo;
+      sv.len = (uint32_t)(hi - lo);
+
+      if (!st->cb.key_value(st->user, st->key, st->key_len, &sv))
+      {
+        return s_tml_stream_fail(st);
+      }
+    }
+
+    return 1;
+  }
+
+  static int s_tml_stream_append_value(XTmlStream *st, const char *p, uint32_t len, int newline)
+  {
+    if ((uint64_t)st->value_len + len + (newline ? 1u : 0u) > st->cap)
+    {
+      return s_tml_stream_fail(st);
+    }
+
+    memcpy(st->value + st->value_len, p, len);
+    st->value_len += len;
+
+    if (newline)
+    {
+      st->value[st->value_len++] = '\n';
+    }
+
+    return 1;
+  }
+
+  static const char *s_tml_find_triple(const char *p, uint32_t len)
+  {
+    for (uint32_t k = 0; k + 2u < len; k++)
+    {
+      if (p[k] == '"' && p[k + 1] == '"' && p[k + 2] == '"')
+      {
+        return p + k;
+      }
+    }
+
+    return NULL;
+  }
+
+  /* One complete line without its '\n', null-terminated at line[len] */
+  static int s_tml_stream_line(XTmlStream *st, char *line, uint32_t l)
+  {
+    st->line_no++;
+
+    if (st->mode == X_TML_STREAM_TRIPLE)
+    {
+      const char *close = s_tml_find_triple(line, l);
+
+      if (close)
+      {
+        return s_tml_stream_append_value(st, line, (uint32_t)(close - line), 0) &&
+          s_tml_stream_triple_end(st, 1);
+      }
+
+      return s_tml_stream_append_value(st, line, l, 1);
     }
 
-    int b = 0;
+    uint32_t tl = s_tml_trim_right_len(line, l);
+
+    if (st->mode == X_TML_STREAM_ARRAY)
+    {
+      if (tl == 0)
+      {
+        return s_tml_stream_array_end(st);
+      }
+
+      line[tl] = 0;
 
-    if (x_tml_get_bool(tml, cur, key, &b))
+      if (!s_tml_stream_elements(st, line, tl))
+      {
+        return 0;
+      }
+
+      return (line[tl - 1] == ',') ? 1 : s_tml_stream_array_end(st);
+    }
+
+    if (tl == 0 || line[0] == '#')
     {
       return 1;
     }
 
-    uint32_t n = 0;
+    uint32_t ind = 0;
+    while (ind < tl && line[ind] == ' ')
+    {
+      ind++;
+    }
+
+    if (ind < tl && line[ind] == '\t')
+    {
+      return s_tml_stream_fail(st);
+    }
+
+    if (st->unit == 0 && ind > 0)
+    {
+      st->unit = ind;
+      if (!(st->unit == 2 || st->unit == 4))
+      {
+        return s_tml_stream_fail(st);
+      }
+    }
+
+    if (ind > 0 && (ind % st->unit) != 0)
+    {
+      return s_tml_stream_fail(st);
+    }
+
+    uint32_t depth = (st->unit > 0) ? (ind / st->unit) : 0;
 
-    if (x_tml_get_array_len(tml, cur, key, &n))
+    char *p = line + ind;
+    uint32_t pl = tl - ind;
+
+    while (st->sp > 0 && st->depths[st->sp - 1] >= depth)
+    {
+      if (!s_tml_stream_pop(st))
+      {
+        return 0;
+      }
+    }
+
+    int inline_after_dash = 0;
+
+    if (p[0] == '-' && (pl == 1u || p[1] == ' ' || p[1] == '\t'))
+    {
+      if (!s_tml_stream_push(st, depth, NULL, 0u))
+      {
+        return 0;
+      }
+
+      uint32_t sk = 1u;
+      while (sk < pl && (p[sk] == ' ' || p[sk] == '\t'))
+      {
+        sk++;
+      }
+
+      if (sk >= pl)
+      {
+        return 1;
+      }
+
+      inline_after_dash = 1;
+      p += sk;
+      pl -= sk;
+    }
+
+    uint32_t pos = UINT32_MAX;
+    for (uint32_t k = 0; k < pl; k++)
+    {
+      if (p[k] == ':' || p[k] == '=')
+      {
+        pos = k;
+        break;
+      }
+    }
+
+    if (pos == UINT32_MAX)
     {
       return 1;
     }
 
-    return 0;
+    int is_colon = (p[pos] == ':');
+    uint32_t after = pos + 1u;
+
+    while (after < pl && (p[after] == ' ' || p[after] == '\t'))
+    {
+      after++;
+    }
+
+    if (is_colon && after >= pl)
+    {
+      if (pos == 0u || isdigit((unsigned char)p[0]))
+      {
+        return s_tml_stream_fail(st);
+      }
+
+      return s_tml_stream_push(st, depth, p, pos);
+    }
+
+    if (st->sp > 0 && !inline_after_dash && depth <= st->depths[st->sp - 1])
+    {
+      return s_tml_stream_fail(st);
+    }
+
+    uint32_t k_off = 0u;
+    while (k_off < pos && (p[k_off] == ' ' || p[k_off] == '\t'))
+    {
+      k_off++;
+    }
+
+    const char *key = p + k_off;
+    uint32_t key_len = pos - k_off;
+
+    char *vp = p + after;
+    uint32_t vl = pl - after;
+
+    if (vl >= 3u && vp[0] == '"' && vp[1] == '"' && vp[2] == '"')
+    {
+      /* The opening line runs to its untrimmed end, like the text loader */
+      const char *rest = vp + 3;
+      uint32_t rest_len = (uint32_t)((line + l) - rest);
+      const char *close = s_tml_find_triple(rest, rest_len);
+
+      memcpy(st->key, key, key_len);
+      st->key_len = key_len;
+      st->value_len = 0;
+      st->mode = X_TML_STREAM_TRIPLE;
+
+      if (close)
+      {
+        return s_tml_stream_append_value(st, rest, (uint32_t)(close - rest), 0) &&
+          s_tml_stream_triple_end(st, 1);
+      }
+
+      return s_tml_stream_append_value(st, rest, rest_len, 1);
+    }
+
+    while (vl > 0 && (vp[vl - 1] == ' ' || vp[vl - 1] == '\t' || vp[vl - 1] == '\r'))
+    {
+      vl--;
+    }
+
+    vp[vl] = 0;
+
+    int multiline = (vl > 0u && vp[vl - 1] == ',');
+
+    if (multiline || s_tml_has_comma(vp, vl))
+    {
+      if (st->cb.array_begin && !st->cb.array_begin(st->user, key, key_len))
+      {
+        return s_tml_stream_fail(st);
+      }
+
+      if (!s_tml_stream_elements(st, vp, vl))
+      {
+        return 0;
+      }
+
+      if (multiline)
+      {
+        st->mode = X_TML_STREAM_ARRAY;
+        return 1;
+      }
+
+      return s_tml_stream_array_end(st);
+    }
+
+    if (st->cb.key_value)
+    {
+      XTmlScalar sv;
+      s_tml_decode_scalar(vp, vl, &sv);
+
+      if (!st->cb.key_value(st->user, key, key_len, &sv))
+      {
+        return s_tml_stream_fail(st);
+      }
+    }
+
+    return 1;
+  }
+
+  X_TML_API int x_tml_stream_feed(XTmlStream *stream, const char *data, size_t len)
+  {
+    if (!stream || (!data && len))
+    {
+      return 0;
+    }
+
+    XTmlStream *st = stream;
+
+    while (len > 0 && !st->failed)
+    {
+      const char *nl = (const char *)memchr(data, '\n', len);
+      size_t take = nl ? (size_t)(nl - data) : len;
+
+      if ((uint64_t)st->line_len + take > st->cap)
+      {
+        st->line_no++;
+        return s_tml_stream_fail(st);
+      }
+
+      memcpy(st->line + st->line_len, data, take);
+      st->line_len += (uint32_t)take;
+
+      if (!nl)
+      {
+        break;
+      }
+
+      st->line[st->line_len] = 0;
+      uint32_t l = st->line_len;
+      st->line_len = 0;
+      s_tml_stream_line(st, st->line, l);
+
+      data += take + 1u;
+      len -= take + 1u;
+    }
+
+    return !st->failed;
+  }
+
+  X_TML_API int x_tml_stream_finish(XTmlStream *stream)
+  {
+    if (!stream)
+    {
+      return 0;
+    }
+
+    XTmlStream *st = stream;
+
+    if (!st->failed && st->line_len > 0)
+    {
+      st->line[st->line_len] = 0;
+      uint32_t l = st->line_len;
+      st->line_len = 0;
+      s_tml_stream_line(st, st->line, l);
+    }
+
+    if (!st->failed && st->mode == X_TML_STREAM_TRIPLE)
+    {
+      s_tml_stream_triple_end(st, 0);
+    }
+
+    if (!st->failed && st->mode == X_TML_STREAM_ARRAY)
+    {
+      s_tml_stream_array_end(st);
+    }
+
+    while (!st->failed && st->sp > 0)
+    {
+      s_tml_stream_pop(st);
+    }
+
+    return !st->failed;
+  }
+
+  X_TML_API int x_tml_stream_read(XTmlStream *stream, XReader *reader)
+  {
+    if (!stream || !reader)
+    {
+      return 0;
+    }
+
+    XTmlStream *st = stream;
+    XSlice line;
+
+    while (!st->failed && x_reader_next_line(reader, &line))
+    {
+      if (line.length > st->cap)
+      {
+        st->line_no++;
+        s_tml_stream_fail(st);
+        break;
+      }
+
+      /* The reader's buffer is not ours to terminate */
+      memcpy(st->line, line.ptr, line.length);
+      st->line[line.length] = 0;
+      s_tml_stream_line(st, st->line, (uint32_t)line.length);
+    }
+
+    return x_tml_stream_finish(st);
+  }
+
+  /* Binary form */
+
+#define X_TML_BINARY_MAGIC   0x424C4D54u /* "TMLB" */
+#define X_TML_BINARY_VERSION 1u
+#define X_TML_BINARY_ENDIAN  0x01020304u
+
+  typedef struct XTmlBinStr
+  {
+    uint32_t off;   /* into the text */
+    uint32_t len;
+  } XTmlBinStr;
+
+  /* Every table starts on an 8-byte boundary; offsets are from the blob start */
+  typedef struct XTmlBinHeader
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t endian;
+    uint32_t flags;
+    uint32_t node_size;
+    uint32_t kv_size;
+
+    uint32_t text_len;
+    uint32_t node_count;
+    uint32_t kv_count;
+    uint32_t nums_f64_count;
+    uint32_t nums_i64_count;
+    uint32_t str_slice_count;
+    uint32_t root_child_count;
+    uint32_t child_mask;
+    uint32_t kv_mask;
+    uint32_t reserved;
+
+    uint64_t text_off;
+    uint64_t nodes_off;
+    uint64_t kvs_off;
+    uint64_t f64_off;
+    uint64_t i64_off;
+    uint64_t str_off;
+    uint64_t child_slots_off;
+    uint64_t kv_slots_off;
+    uint64_t child_order_off;
+    uint64_t child_first_off;
+    uint64_t total_size;
+  } XTmlBinHeader;
+
+  static uint64_t s_tml_bin_place(uint64_t *cursor, uint64_t bytes)
+  {
+    uint64_t off = *cursor;
+    *cursor = (off + bytes + 7u) & ~(uint64_t)7u;
+    return off;
+  }
+
+  static int s_tml_bin_write(XFile *f, uint64_t *written, uint64_t off, const void *data, uint64_t bytes)
+  {
+    static const char zeros[8] = { 0 };
+
+    while (*written < off)
+    {
+      uint64_t pad = off - *written;
+      size_t n = (size_t)(pad < sizeof(zeros) ? pad : sizeof(zeros));
+
+      if (x_io_write(f, zeros, n) != n)
+      {
+        return 0;
+      }
+
+      *written += n;
+    }
+
+    if (bytes && x_io_write(f, data, (size_t)bytes) != (size_t)bytes)
+    {
+      return 0;
+    }
+
+    *written += bytes;
+    return 1;
+  }
+
+  X_TML_API int x_tml_save_binary(XTml *tml, const char *path)
+  {
+    if (!tml || !path)
+    {
+      return 0;
+    }
+
+    int indexed = (tml->child_slots != NULL);
+
+    XTmlBinHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = X_TML_BINARY_MAGIC;
+    h.version = X_TML_BINARY_VERSION;
+    h.endian = X_TML_BINARY_ENDIAN;
+    h.flags = indexed ? XTML_OPEN_INDEX : 0u;
+    h.node_size = (uint32_t)sizeof(XTmlNode);
+    h.kv_size = (uint32_t)sizeof(XTmlKV);
+    h.text_len = tml->text_len;
+    h.node_count = tml->node_count;
+    h.kv_count = tml->kv_count;
+    h.nums_f64_count = tml->nums_f64_count;
+    h.nums_i64_count = tml->nums_i64_count;
+    h.str_slice_count = tml->str_slice_count;
+    h.root_child_count = tml->root_child_count;
+    h.child_mask = tml->child_mask;
+    h.kv_mask = tml->kv_mask;
+
+    uint64_t child_slot_count = indexed ? (uint64_t)tml->child_mask + 1u : 0u;
+    uint64_t kv_slot_count = indexed ? (uint64_t)tml->kv_mask + 1u : 0u;
+    uint64_t order_count = indexed ? tml->node_count : 0u;
+    uint64_t first_count = indexed ? (uint64_t)tml->node_count + 2u : 0u;
+
+    uint64_t cursor = 0;
+    s_tml_bin_place(&cursor, sizeof(XTmlBinHeader));
+    h.text_off = s_tml_bin_place(&cursor, (uint64_t)tml->text_len + 1u);
+    h.nodes_off = s_tml_bin_place(&cursor, (uint64_t)tml->node_count * sizeof(XTmlNode));
+    h.kvs_off = s_tml_bin_place(&cursor, (uint64_t)tml->kv_count * sizeof(XTmlKV));
+    h.f64_off = s_tml_bin_place(&cursor, (uint64_t)tml->nums_f64_count * sizeof(double));
+    h.i64_off = s_tml_bin_place(&cursor, (uint64_t)tml->nums_i64_count * sizeof(int64_t));
+    h.str_off = s_tml_bin_place(&cursor, (uint64_t)tml->str_slice_count * sizeof(XTmlBinStr));
+    h.child_slots_off = s_tml_bin_place(&cursor, child_slot_count * sizeof(uint64_t));
+    h.kv_slots_off = s_tml_bin_place(&cursor, kv_slot_count * sizeof(uint64_t));
+    h.child_order_off = s_tml_bin_place(&cursor, order_count * sizeof(uint32_t));
+    h.child_first_off = s_tml_bin_place(&cursor, first_count * sizeof(uint32_t));
+    h.total_size = cursor;
+
+    XTmlBinStr *strs = NULL;
+
+    if (tml->str_slice_count)
+    {
+      strs = (XTmlBinStr *)X_TML_ALLOC(tml->str_slice_count * sizeof(XTmlBinStr));
+      if (!strs)
+      {
+        return 0;
+      }
+
+      for (uint32_t i = 0; i < tml->str_slice_count; i++)
+      {
+        strs[i].off = (uint32_t)(tml->str_slices[i].ptr - tml->text);
+        strs[i].len = tml->str_slices[i].len;
+      }
+    }
+
+    XFile *f = x_io_open(path, "wb");
+    if (!f)
+    {
+      if (strs)
+      {
+        X_TML_FREE(strs);
+      }
+
+      return 0;
+    }
+
+    const char nul = 0;
+    uint64_t written = 0;
+    int ok =
+      s_tml_bin_write(f, &written, 0, &h, sizeof(h)) &&
+      s_tml_bin_write(f, &written, h.text_off, tml->text, tml->text_len) &&
+      s_tml_bin_write(f, &written, h.text_off + tml->text_len, &nul, 1) &&
+      s_tml_bin_write(f, &written, h.nodes_off, tml->nodes, (uint64_t)tml->node_count * sizeof(XTmlNode)) &&
+      s_tml_bin_write(f, &written, h.kvs_off, tml->kvs, (uint64_t)tml->kv_count * sizeof(XTmlKV)) &&
+      s_tml_bin_write(f, &written, h.f64_off, tml->nums_f64, (uint64_t)tml->nums_f64_count * sizeof(double)) &&
+      s_tml_bin_write(f, &written, h.i64_off, tml->nums_i64, (uint64_t)tml->nums_i64_count * sizeof(int64_t)) &&
+      s_tml_bin_write(f, &written, h.str_off, strs, (uint64_t)tml->str_slice_count * sizeof(XTmlBinStr)) &&
+      s_tml_bin_write(f, &written, h.child_slots_off, tml->child_slots, child_slot_count * sizeof(uint64_t)) &&
+      s_tml_bin_write(f, &written, h.kv_slots_off, tml->kv_slots, kv_slot_count * sizeof(uint64_t)) &&
+      s_tml_bin_write(f, &written, h.child_order_off, tml->child_order, order_count * sizeof(uint32_t)) &&
+      s_tml_bin_write(f, &written, h.child_first_off, tml->child_first, first_count * sizeof(uint32_t)) &&
+      s_tml_bin_write(f, &written, h.total_size, NULL, 0);
+
+    ok = x_io_flush(f) && ok;
+    x_io_close(f);
+    if (strs)
+    {
+      X_TML_FREE(strs);
+    }
+
+    return ok ? 1 : 0;
+  }
+
+  static int s_tml_bin_table_ok(const XTmlBinHeader *h, uint64_t off, uint64_t count, uint64_t elem_size)
+  {
+    return (off & 7u) == 0 && off >= sizeof(XTmlBinHeader) &&
+      off <= h->total_size && count * elem_size <= h->total_size - off;
+  }
+
+  /* Builds the XTml header over a validated blob; the mapping slot is appended when asked */
+  static int s_tml_load_binary(const void *data, size_t size, int with_mapping, XTml **out_tml)
+  {
+    if (!data || !out_tml || size < sizeof(XTmlBinHeader) || ((uintptr_t)data & 7u) != 0)
+    {
+      return 0;
+    }
+
+    const XTmlBinHeader *h = (const XTmlBinHeader *)data;
+
+    if (h->magic != X_TML_BINARY_MAGIC || h->version != X_TML_BINARY_VERSION ||
+        h->endian != X_TML_BINARY_ENDIAN || h->node_size != sizeof(XTmlNode) ||
+        h->kv_size != sizeof(XTmlKV) || h->total_size > size)
+    {
+      return 0;
+    }
+
+    int indexed = (h->flags & XTML_OPEN_INDEX) != 0;
+    uint64_t child_slot_count = indexed ? (uint64_t)h->child_mask + 1u : 0u;
+    uint64_t kv_slot_count = indexed ? (uint64_t)h->kv_mask + 1u : 0u;
+
+    if (!s_tml_bin_table_ok(h, h->text_off, (uint64_t)h->text_len + 1u, 1u) ||
+        !s_tml_bin_table_ok(h, h->nodes_off, h->node_count, sizeof(XTmlNode)) ||
+        !s_tml_bin_table_ok(h, h->kvs_off, h->kv_count, sizeof(XTmlKV)) ||
+        !s_tml_bin_table_ok(h, h->f64_off, h->nums_f64_count, sizeof(double)) ||
+        !s_tml_bin_table_ok(h, h->i64_off, h->nums_i64_count, sizeof(int64_t)) ||
+        !s_tml_bin_table_ok(h, h->str_off, h->str_slice_count, sizeof(XTmlBinStr)) ||
+        !s_tml_bin_table_ok(h, h->child_slots_off, child_slot_count, sizeof(uint64_t)) ||
+        !s_tml_bin_table_ok(h, h->kv_slots_off, kv_slot_count, sizeof(uint64_t)) ||
+        !s_tml_bin_table_ok(h, h->child_order_off, indexed ? h->node_count : 0u, sizeof(uint32_t)) ||
+        !s_tml_bin_table_ok(h, h->child_first_off, indexed ? (uint64_t)h->node_count + 2u : 0u, sizeof(uint32_t)))
+    {
+      return 0;
+    }
+
+    if (indexed && (((uint64_t)h->child_mask + 1u) & h->child_mask ||
+          ((uint64_t)h->kv_mask + 1u) & h->kv_mask))
+    {
+      return 0;
+    }
+
+    /* XTml, then the mapping, then the rebuilt string slices */
+    uint32_t bytes = (uint32_t)sizeof(XTml);
+    uint32_t mapping_off = bytes;
+    bytes += with_mapping ? (uint32_t)((sizeof(XFileMapping) + 7u) & ~(size_t)7u) : 0u;
+    uint32_t str_off = bytes;
+    bytes += h->str_slice_count * (uint32_t)sizeof(XTmlStrSlice);
+
+    void *arena = X_TML_ALLOC(bytes);
+    if (!arena)
+    {
+      return 0;
+    }
+
+    const char *base = (const char *)data;
+    XTml *tml = (XTml *)arena;
+    memset(tml, 0, sizeof(*tml));
+
+    tml->arena = arena;
+    tml->arena_size = bytes;
+    tml->flags = h->flags;
+    tml->root_child_count = h->root_child_count;
+    tml->text = base + h->text_off;
+    tml->text_len = h->text_len;
+
+    /* The tables are never written through, so dropping const is safe here */
+    tml->nodes = (XTmlNode *)(base + h->nodes_off);
+    tml->node_count = h->node_count;
+    tml->kvs = (XTmlKV *)(base + h->kvs_off);
+    tml->kv_count = h->kv_count;
+    tml->nums_f64 = (double *)(base + h->f64_off);
+    tml->nums_f64_count = h->nums_f64_count;
+    tml->nums_i64 = (int64_t *)(base + h->i64_off);
+    tml->nums_i64_count = h->nums_i64_count;
+
+    tml->str_slices = (XTmlStrSlice *)((char *)arena + str_off);
+    tml->str_slice_count = h->str_slice_count;
+
+    const XTmlBinStr *strs = (const XTmlBinStr *)(base + h->str_off);
+
+    for (uint32_t i = 0; i < h->str_slice_count; i++)
+    {
+      if ((uint64_t)strs[i].off + strs[i].len > h->text_len)
+      {
+        X_TML_FREE(arena);
+        return 0;
+      }
+
+      tml->str_slices[i].ptr = tml->text + strs[i].off;
+      tml->str_slices[i].len = strs[i].len;
+    }
+
+    if (indexed)
+    {
+      tml->child_slots = (uint64_t *)(base + h->child_slots_off);
+      tml->child_mask = h->child_mask;
+      tml->kv_slots = (uint64_t *)(base + h->kv_slots_off);
+      tml->kv_mask = h->kv_mask;
+      tml->child_order = (uint32_t *)(base + h->child_order_off);
+      tml->child_first = (uint32_t *)(base + h->child_first_off);
+    }
+
+    tml->mapping = with_mapping ? (XFileMapping *)((char *)arena + mapping_off) : NULL;
+
+    *out_tml = tml;
+    return 1;
+  }
+
+  X_TML_API int x_tml_load_binary_mem(const void *data, size_t size, XTml **out_tml)
+  {
+    return s_tml_load_binary(data, size, 0, out_tml);
+  }
+
+  X_TML_API int x_tml_load_binary(const char *path, XTml **out_tml)
+  {
+    if (!path || !out_tml)
+    {
+      return 0;
+    }
+
+    X_TML_PROFILE_BEGIN("x_tml_load_binary");
+
+    XFileMapping mapping;
+    XTml *tml = NULL;
+    int ok = 0;
+
+    if (x_io_map(path, X_IO_MAP_RANDOM, &mapping))
+    {
+      ok = s_tml_load_binary(mapping.data, mapping.size, 1, &tml);
+
+      if (ok)
+      {
+        *tml->mapping = mapping;
+        *out_tml = tml;
+      }
+      else
+      {
+        x_io_unmap(&mapping);
+      }
+    }
+
+    X_TML_PROFILE_END();
+    return ok;
   }
 
 #ifdef __cplusplus
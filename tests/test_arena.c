@@ -1,8 +1,27 @@
 #define X_IMPL_TEST
 #include <stdx_test.h>
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#include <stdlib.h>
+
+// Count chunk allocations so tests can check the steady state never mallocs
+static volatile int32_t s_arena_allocs = 0;
+static void* counting_alloc(size_t size)
+{
+  x_atomic_fetch_add_i32(&s_arena_allocs, 1);
+  return malloc(size);
+}
+
+#define X_ARENA_ALLOC(sz) counting_alloc((sz))
 #define X_IMPL_ARENA
 #define X_ARENA_TESTING
 #include <stdx_arena.h>
+#define X_IMPL_ARRAY
+#include <stdx_array.h>
+#define X_IMPL_HASHTABLE
+#include <stdx_hashtable.h>
+#define X_IMPL_STRBUILDER
+#include <stdx_strbuilder.h>
 
 #include <stdio.h>
 #include <string.h>
@@ -252,6 +271,290 @@ int test_x_arena_spike_then_trim_recovers_memory_pressure()
   return 0;
 }
 
+int test_x_arena_thread_local_reuses_cached_chunks()
+{
+  XArena* arena = x_arena_thread_local();
+  ASSERT_TRUE(arena != NULL);
+  ASSERT_TRUE(arena == x_arena_thread_local());
+  ASSERT_TRUE(arena->chunk_size == X_ARENA_THREAD_CHUNK_SIZE);
+
+  // Spill over several chunks, then give all but the head back to the cache
+  for (int i = 0; i < 8; ++i)
+    ASSERT_TRUE(x_arena_alloc(arena, X_ARENA_THREAD_CHUNK_SIZE / 2 + 1) != NULL);
+  ASSERT_TRUE(x_arena_chunk_count(arena) == 8);
+  x_arena_reset(arena);
+  ASSERT_TRUE(x_arena_chunk_count(arena) == 1);
+  ASSERT_TRUE(x_arena_head_used(arena) == 0);
+
+  int32_t before = x_atomic_load_i32(&s_arena_allocs);
+  for (int round = 0; round < 100; ++round)
+  {
+    for (int i = 0; i < 8; ++i)
+      ASSERT_TRUE(x_arena_alloc(arena, X_ARENA_THREAD_CHUNK_SIZE / 2 + 1) != NULL);
+    x_arena_reset(arena);
+  }
+  ASSERT_EQ(x_atomic_load_i32(&s_arena_allocs), before);
+
+  x_arena_thread_local_destroy();
+  x_arena_chunk_cache_purge();
+  return 0;
+}
+
+int test_x_arena_virtual_contiguous_growth()
+{
+  XArena* arena = x_arena_create_virtual(64u * 1024u * 1024u);
+  ASSERT_TRUE(arena != NULL);
+  ASSERT_TRUE(arena->vm_committed <= X_ARENA_VM_COMMIT_SIZE);
+
+  // Allocations are adjacent and memory is committed only as the cursor advances
+  uint8_t* a = (uint8_t*)x_arena_alloc(arena, 1000);
+  uint8_t* b = (uint8_t*)x_arena_alloc(arena, 1000);
+  ASSERT_TRUE(a && b);
+  ASSERT_TRUE(b == a + x_arena_align_up(1000, X_ARENA_ALIGN));
+
+  uint8_t* big = (uint8_t*)x_arena_alloc(arena, 8u * 1024u * 1024u);
+  ASSERT_TRUE(big != NULL);
+  memset(big, 0xAB, 8u * 1024u * 1024u);
+  ASSERT_TRUE(x_arena_chunk_count(arena) == 1);
+  ASSERT_TRUE(arena->vm_committed >= 8u * 1024u * 1024u);
+
+  // Rewinding decommits the tail
+  XArenaMark m = x_arena_mark(arena);
+  ASSERT_TRUE(x_arena_alloc(arena, 16u * 1024u * 1024u) != NULL);
+  size_t committed = arena->vm_committed;
+  x_arena_release(arena, m);
+  ASSERT_TRUE(arena->vm_committed < committed);
+  ASSERT_TRUE(x_arena_head_used(arena) == m.used);
+  ASSERT_TRUE(big[8u * 1024u * 1024u - 1] == 0xAB);
+
+  // Exhausting the reservation fails instead of spilling into a new chunk
+  ASSERT_TRUE(x_arena_alloc(arena, 128u * 1024u * 1024u) == NULL);
+
+  x_arena_reset_keep_head(arena);
+  ASSERT_TRUE(x_arena_head_used(arena) == 0);
+  ASSERT_TRUE(arena->vm_committed == X_ARENA_VM_COMMIT_SIZE);
+
+  x_arena_destroy(arena);
+  return 0;
+}
+
+int test_x_arena_realloc_last()
+{
+  XArena* vm = x_arena_create_virtual(16u * 1024u * 1024u);
+  XArena* heap = x_arena_create(256);
+  ASSERT_TRUE(vm && heap);
+
+  // Growing the last allocation of a virtual arena never moves it
+  char* p = (char*)x_arena_alloc(vm, 16);
+  memcpy(p, "stdx", 5);
+  for (size_t size = 32; size <= 4u * 1024u * 1024u; size *= 2)
+  {
+    char* q = (char*)x_arena_realloc_last(vm, p, size / 2, size);
+    ASSERT_TRUE(q == p);
+  }
+  ASSERT_TRUE(strcmp(p, "stdx") == 0);
+
+  // Heap arenas grow in place while the chunk has room, then copy
+  char* h = (char*)x_arena_alloc(heap, 16);
+  memcpy(h, "arena", 6);
+  ASSERT_TRUE(x_arena_realloc_last(heap, h, 16, 128) == h);
+  char* other = (char*)x_arena_alloc(heap, 8);
+  ASSERT_TRUE(other != NULL);
+  char* moved = (char*)x_arena_realloc_last(heap, h, 128, 200);
+  ASSERT_TRUE(moved != NULL && moved != h);
+  ASSERT_TRUE(strcmp(moved, "arena") == 0);
+
+  // Shrinking the last allocation gives the space back
+  size_t used = x_arena_head_used(heap);
+  ASSERT_TRUE(x_arena_realloc_last(heap, moved, 200, 100) == moved);
+  ASSERT_TRUE(x_arena_head_used(heap) == used - 100);
+
+  x_arena_destroy(vm);
+  x_arena_destroy(heap);
+  return 0;
+}
+
+int test_x_arena_chunk_cache_recycles_by_size()
+{
+  x_arena_chunk_cache_purge();
+  XArenaCacheStats before = x_arena_chunk_cache_stats();
+  ASSERT_TRUE(before.cached_chunks == 0);
+
+  // A per-request arena: after the first request, chunks come back from the cache
+  int32_t allocs = x_atomic_load_i32(&s_arena_allocs);
+  for (int request = 0; request < 10; ++request)
+  {
+    XArena* arena = x_arena_create(16u * 1024u);
+    ASSERT_TRUE(arena != NULL);
+    for (int i = 0; i < 4; ++i)
+      ASSERT_TRUE(x_arena_alloc(arena, 12u * 1024u) != NULL);
+    ASSERT_TRUE(x_arena_chunk_count(arena) == 4);
+    x_arena_destroy(arena);
+  }
+  // 10 arena headers, but only the first request's 4 chunks
+  ASSERT_EQ(x_atomic_load_i32(&s_arena_allocs) - allocs, 10 + 4);
+
+  XArenaCacheStats after = x_arena_chunk_cache_stats();
+  ASSERT_EQ(after.hits - before.hits, 36);
+  ASSERT_EQ(after.misses - before.misses, 4);
+  ASSERT_EQ(after.cached_chunks, 4);
+  ASSERT_EQ(after.cached_bytes, 4u * 16u * 1024u);
+
+  // Sizes that are not a power of two bypass the cache
+  XArena* odd = x_arena_create(10000);
+  x_arena_destroy(odd);
+  ASSERT_EQ(x_arena_chunk_cache_stats().cached_chunks, 4);
+
+  // The high-water mark bounds what the cache keeps
+  x_arena_chunk_cache_purge();
+  x_arena_chunk_cache_set_limit(2u * 16u * 1024u);
+  XArena* spike = x_arena_create(16u * 1024u);
+  for (int i = 0; i < 4; ++i)
+    ASSERT_TRUE(x_arena_alloc(spike, 12u * 1024u) != NULL);
+  x_arena_destroy(spike);
+  ASSERT_EQ(x_arena_chunk_cache_stats().cached_chunks, 2);
+
+  x_arena_chunk_cache_set_limit(X_ARENA_CHUNK_CACHE_LIMIT);
+  x_arena_chunk_cache_purge();
+  ASSERT_EQ(x_arena_chunk_cache_stats().cached_bytes, 0);
+  return 0;
+}
+
+int test_x_arena_stats()
+{
+  XArena* arena = x_arena_create(4096);
+  ASSERT_TRUE(arena != NULL);
+
+  XArenaStats st = x_arena_stats(arena);
+  ASSERT_EQ(st.bytes_used, 0);
+  ASSERT_EQ(st.bytes_reserved, 4096);
+
+  // 3 bytes + alignment padding + 8 bytes
+  ASSERT_TRUE(x_arena_alloc(arena, 3) != NULL);
+  ASSERT_TRUE(x_arena_alloc(arena, 8) != NULL);
+  st = x_arena_stats(arena);
+  ASSERT_EQ(st.alignment_waste, X_ARENA_ALIGN - 3);
+  ASSERT_EQ(st.bytes_used, X_ARENA_ALIGN + 8);
+
+  ASSERT_TRUE(x_arena_alloc(arena, 6000) != NULL);
+  st = x_arena_stats(arena);
+  ASSERT_EQ(st.bytes_used, X_ARENA_ALIGN + 8 + 6000);
+  ASSERT_EQ(st.bytes_reserved, 4096 + 6000);
+  ASSERT_EQ(st.chunks_created + st.chunks_reused, 2);
+
+  x_arena_reset(arena);
+  st = x_arena_stats(arena);
+  ASSERT_EQ(st.bytes_used, 0);
+  ASSERT_EQ(st.bytes_peak, X_ARENA_ALIGN + 8 + 6000);
+
+  ASSERT_TRUE(x_arena_alloc(arena, 100) != NULL);
+  x_arena_trim(arena, 1);
+  st = x_arena_stats(arena);
+  ASSERT_EQ(st.bytes_reserved, x_arena_head_capacity(arena));
+  ASSERT_EQ(st.bytes_used, x_arena_head_used(arena));
+
+  x_arena_destroy(arena);
+  x_arena_chunk_cache_purge();
+  return 0;
+}
+
+#define ARENA_WORKERS 4
+
+typedef struct
+{
+  XArena* arena;
+  bool ok;
+} ArenaWorker;
+
+static void* arena_worker(void* arg)
+{
+  ArenaWorker* w = (ArenaWorker*)arg;
+  w->arena = x_arena_thread_local();
+  w->ok = w->arena != NULL;
+
+  for (int round = 0; w->ok && round < 200; ++round)
+  {
+    int32_t* values[64];
+    for (int i = 0; i < 64; ++i)
+    {
+      values[i] = (int32_t*)x_arena_alloc(w->arena, 4096);
+      if (!values[i])
+      {
+        w->ok = false;
+        break;
+      }
+      values[i][0] = round * 64 + i;
+    }
+    for (int i = 0; w->ok && i < 64; ++i)
+      w->ok = values[i][0] == round * 64 + i;
+    x_arena_reset(w->arena);
+  }
+
+  x_arena_thread_local_destroy();
+  return NULL;
+}
+
+int test_x_arena_thread_local_per_thread()
+{
+  ArenaWorker workers[ARENA_WORKERS];
+  XThread* threads[ARENA_WORKERS];
+
+  for (int i = 0; i < ARENA_WORKERS; ++i)
+  {
+    workers[i].arena = NULL;
+    workers[i].ok = false;
+    ASSERT_TRUE(x_thread_create(&threads[i], arena_worker, &workers[i]) == 0);
+  }
+  for (int i = 0; i < ARENA_WORKERS; ++i)
+  {
+    x_thread_join(threads[i]);
+    x_thread_destroy(threads[i]);
+    ASSERT_TRUE(workers[i].ok);
+  }
+
+  // The calling thread has an arena of its own
+  ASSERT_TRUE(x_arena_thread_local() != NULL);
+  x_arena_thread_local_destroy();
+  x_arena_chunk_cache_purge();
+  return 0;
+}
+
+int test_x_arena_container_allocator()
+{
+  XArena* arena = x_arena_create(256);
+  ASSERT_TRUE(arena != NULL);
+  XAllocator a = x_arena_allocator(arena);
+
+  // Consecutive pushes grow the array in place at the arena cursor
+  XArray* arr = x_array_create_with_allocator(sizeof(int), 4, &a);
+  ASSERT_TRUE(arr != NULL);
+  ASSERT_TRUE(x_arena_has_pointer(arena, arr));
+  for (int i = 0; i < 1000; i++)
+  {
+    ASSERT_EQ(x_array_add(arr, &i), XARRAY_OK);
+  }
+  ASSERT_TRUE(x_arena_has_pointer(arena, x_array_data(arr)));
+  ASSERT_EQ(*(int*)x_array_get(arr, 999), 999);
+
+  XHashtable* ht = x_hashtable_create_with_allocator(sizeof(char*), true, true, sizeof(int), false, false, &a);
+  ASSERT_TRUE(ht != NULL);
+  int v = 7;
+  ASSERT_TRUE(x_hashtable_set(ht, "seven", &v));
+  ASSERT_TRUE(x_hashtable_get(ht, "seven", &v));
+  ASSERT_EQ(v, 7);
+
+  XStrBuilder* sb = x_strbuilder_create_with_allocator(&a);
+  ASSERT_TRUE(sb != NULL);
+  x_strbuilder_append(sb, "arena backed");
+  ASSERT_TRUE(x_arena_has_pointer(arena, x_strbuilder_to_string(sb)));
+
+  // One reset drops all three containers without destroying them
+  x_arena_reset(arena);
+  ASSERT_EQ(x_arena_stats(arena).bytes_used, 0);
+  x_arena_destroy(arena);
+  return 0;
+}
+
 int main()
 {
   STDXTestCase tests[] =
@@ -268,7 +571,14 @@ int main()
     X_TEST(test_x_arena_reset_keep_head_frees_extra_chunks),
     X_TEST(test_x_arena_trim_keeps_first_n_chunks),
     X_TEST(test_x_arena_mark_release_rewinds_and_frees_chunks),
-    X_TEST(test_x_arena_spike_then_trim_recovers_memory_pressure)
+    X_TEST(test_x_arena_spike_then_trim_recovers_memory_pressure),
+    X_TEST(test_x_arena_thread_local_reuses_cached_chunks),
+    X_TEST(test_x_arena_thread_local_per_thread),
+    X_TEST(test_x_arena_virtual_contiguous_growth),
+    X_TEST(test_x_arena_realloc_last),
+    X_TEST(test_x_arena_chunk_cache_recycles_by_size),
+    X_TEST(test_x_arena_stats),
+    X_TEST(test_x_arena_container_allocator)
   };
 
   return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
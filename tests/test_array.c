@@ -6,6 +6,7 @@
 
 X_ARRAY_TYPE(int)
 X_ARRAY_TYPE_NAMED(unsigned int, uint)
+X_ARRAY_TYPE_INLINE_NAMED(short, small_short, 4)
 
 typedef struct TestPoint
 {
@@ -371,6 +372,127 @@ int test_x_array_int_delete_range(void)
   return 0;
 }
 
+int test_x_array_reserve_and_shrink(void)
+{
+  XArray_int* arr = x_array_int_create(0);
+  int i;
+
+  ASSERT_TRUE(arr != NULL);
+  ASSERT_TRUE(x_array_int_capacity(arr) == 0);
+
+  // reserve never shrinks
+  ASSERT_TRUE(x_array_int_reserve(arr, 100) == XARRAY_OK);
+  ASSERT_TRUE(x_array_int_capacity(arr) == 100);
+  ASSERT_TRUE(x_array_int_reserve(arr, 10) == XARRAY_OK);
+  ASSERT_TRUE(x_array_int_capacity(arr) == 100);
+
+  for (i = 0; i < 100; i++)
+  {
+    ASSERT_TRUE(x_array_int_push(arr, i) == XARRAY_OK);
+  }
+  ASSERT_TRUE(x_array_int_capacity(arr) == 100);
+
+  ASSERT_TRUE(x_array_int_delete_range(arr, 10, 99) == XARRAY_OK);
+  ASSERT_TRUE(x_array_int_shrink_to_fit(arr) == XARRAY_OK);
+  ASSERT_TRUE(x_array_int_capacity(arr) == 10);
+  ASSERT_TRUE(*x_array_int_get(arr, 9) == 9);
+
+  x_array_int_clear(arr);
+  ASSERT_TRUE(x_array_int_shrink_to_fit(arr) == XARRAY_OK);
+  ASSERT_TRUE(x_array_int_capacity(arr) == 0);
+  ASSERT_TRUE(x_array_int_push(arr, 7) == XARRAY_OK);
+  ASSERT_TRUE(x_array_int_capacity(arr) == X_ARRAY_MIN_CAPACITY);
+
+  x_array_int_destroy(arr);
+  return 0;
+}
+
+int test_x_array_growth_factor(void)
+{
+  XArray_int* arr = x_array_int_create(8);
+  int i;
+
+  ASSERT_TRUE(arr != NULL);
+  x_array_int_set_growth(arr, 1.5f);
+
+  for (i = 0; i < 9; i++)
+  {
+    ASSERT_TRUE(x_array_int_push(arr, i) == XARRAY_OK);
+  }
+  ASSERT_TRUE(x_array_int_capacity(arr) == 12);
+
+  // A factor that would not grow falls back to the default
+  x_array_int_set_growth(arr, 1.0f);
+  for (i = 9; i < 13; i++)
+  {
+    ASSERT_TRUE(x_array_int_push(arr, i) == XARRAY_OK);
+  }
+  ASSERT_TRUE(x_array_int_capacity(arr) == 24);
+
+  x_array_int_destroy(arr);
+  return 0;
+}
+
+int test_x_array_inline_storage(void)
+{
+  XArrayInline_small_short storage;
+  XArray_small_short* arr = x_array_small_short_init_inline(&storage);
+  short i;
+
+  ASSERT_TRUE(x_array_is_inline(arr));
+  ASSERT_TRUE(x_array_small_short_capacity(arr) == 4);
+
+  for (i = 0; i < 4; i++)
+  {
+    ASSERT_TRUE(x_array_small_short_push(arr, i) == XARRAY_OK);
+  }
+  ASSERT_TRUE(x_array_is_inline(arr));
+  ASSERT_TRUE(x_array_small_short_data(arr) == storage.items);
+
+  // The fifth element spills to the heap and keeps the first four
+  ASSERT_TRUE(x_array_small_short_insert(arr, 42, 0) == XARRAY_OK);
+  ASSERT_FALSE(x_array_is_inline(arr));
+  ASSERT_TRUE(x_array_small_short_count(arr) == 5);
+  ASSERT_TRUE(*x_array_small_short_get(arr, 0) == 42);
+  ASSERT_TRUE(*x_array_small_short_get(arr, 4) == 3);
+
+  // Shrinking back under the inline capacity returns to the inline buffer
+  x_array_small_short_delete_at(arr, 0);
+  ASSERT_TRUE(x_array_small_short_shrink_to_fit(arr) == XARRAY_OK);
+  ASSERT_TRUE(x_array_is_inline(arr));
+  ASSERT_TRUE(x_array_small_short_capacity(arr) == 4);
+  ASSERT_TRUE(*x_array_small_short_get(arr, 3) == 3);
+
+  for (i = 0; i < 20; i++)
+  {
+    ASSERT_TRUE(x_array_small_short_push(arr, i) == XARRAY_OK);
+  }
+  x_array_small_short_term(arr);
+  ASSERT_TRUE(x_array_is_inline(arr));
+  ASSERT_TRUE(x_array_small_short_is_empty(arr));
+  return 0;
+}
+
+int test_x_array_custom_allocator()
+{
+  XTestAllocStats st = {0, 0};
+  XAllocator a = x_test_allocator(&st);
+
+  XArray_int* arr = x_array_int_create_with_allocator(2, &a);
+  ASSERT_TRUE(arr != NULL);
+  for (int i = 0; i < 100; i++)
+  {
+    ASSERT_EQ(x_array_int_push(arr, i), XARRAY_OK);
+  }
+  ASSERT_EQ(*x_array_int_get(arr, 99), 99);
+  ASSERT_TRUE(st.allocs > 2);
+
+  ASSERT_EQ(x_array_int_shrink_to_fit(arr), XARRAY_OK);
+  x_array_int_destroy(arr);
+  ASSERT_EQ(st.live, 0);
+  return 0;
+}
+
 int main()
 {
   STDXTestCase tests[] =
@@ -394,6 +516,10 @@ int main()
     X_TEST(test_x_array_uint_named_type),
     X_TEST(test_x_array_test_point_struct),
     X_TEST(test_x_array_int_delete_range),
+    X_TEST(test_x_array_reserve_and_shrink),
+    X_TEST(test_x_array_growth_factor),
+    X_TEST(test_x_array_inline_storage),
+    X_TEST(test_x_array_custom_allocator),
   };
 
   return x_tests_run(tests, sizeof(tests) / sizeof(tests[0]), NULL);
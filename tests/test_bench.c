@@ -0,0 +1,175 @@
+#define X_IMPL_TEST
+#include <stdx_test.h>
+#define X_IMPL_BENCH
+#include <stdx_bench.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEMP_JSON "test_tmp_bench.json"
+#define TEMP_BASELINE "test_tmp_bench_baseline.json"
+
+static uint64_t s_calls;
+static uint64_t s_max_iterations;
+
+static void bench_sum(XBench* b)
+{
+  static uint32_t data[256];
+  x_bench_set_bytes(b, sizeof(data));
+  s_calls++;
+  if (b->iterations > s_max_iterations) s_max_iterations = b->iterations;
+  for (uint64_t i = 0; i < b->iterations; i++)
+  {
+    uint64_t sum = 0;
+    x_bench_keep(data);
+    for (int32_t k = 0; k < 256; k++)
+      sum += data[k] + (uint32_t)k;
+    x_bench_keep_u64(sum);
+  }
+}
+
+static void bench_paused(XBench* b)
+{
+  // Setup and paused work don't count
+  volatile uint64_t spin = 0;
+  for (int32_t i = 0; i < 100000; i++) spin += (uint64_t)i;
+  x_bench_reset_timer(b);
+  for (uint64_t i = 0; i < b->iterations; i++)
+  {
+    x_bench_pause(b);
+    for (int32_t k = 0; k < 1000; k++) spin += (uint64_t)k;
+    x_bench_resume(b);
+    x_bench_keep_u64(spin);
+  }
+}
+
+static void s_options(XBenchOptions* options)
+{
+  x_bench_options_init(options);
+  options->min_time_ms = 2.0;
+  options->repetitions = 3;
+  options->quiet = true;
+}
+
+int test_bench_stats(void)
+{
+  XBenchCase benches[] = { X_BENCH(bench_sum) };
+  XBenchOptions options;
+  XBenchResult r;
+  s_options(&options);
+
+  s_calls = 0;
+  s_max_iterations = 0;
+  ASSERT_EQ(x_bench_run_ex(benches, 1, &options, &r), 0);
+
+  // Calibration grew the count, then the warmup and three measured runs used it
+  ASSERT_TRUE(r.iterations > 1);
+  ASSERT_EQ(r.iterations, s_max_iterations);
+  ASSERT_TRUE(s_calls >= 5);
+  ASSERT_TRUE(strcmp(r.name, "bench_sum") == 0);
+  ASSERT_EQ(r.repetitions, 3);
+  ASSERT_TRUE(r.min_ns > 0.0 && r.min_ns <= r.median_ns);
+  ASSERT_TRUE(r.stddev_ns >= 0.0);
+  ASSERT_TRUE(r.ops_per_sec > 0.0);
+  ASSERT_TRUE(r.bytes_per_sec > r.ops_per_sec);
+  ASSERT_TRUE(r.items_per_sec == 0.0);
+  // One repetition covers the minimum time
+  ASSERT_TRUE(r.median_ns * (double)r.iterations >= 1e6);
+  return 0;
+}
+
+int test_bench_pause(void)
+{
+  XBenchCase benches[] = { X_BENCH(bench_sum), X_BENCH(bench_paused) };
+  XBenchOptions options;
+  XBenchResult r;
+  s_options(&options);
+  options.min_time_ms = 0.5;
+  options.filter = "paused";
+
+  ASSERT_EQ(x_bench_run_ex(benches, 2, &options, &r), 0);
+  ASSERT_TRUE(strcmp(r.name, "bench_paused") == 0);
+  // 1000 paused additions would take far longer than the resume/pause pair alone
+  ASSERT_TRUE(r.median_ns < 5000.0);
+  return 0;
+}
+
+int test_bench_baseline(void)
+{
+  XBenchCase benches[] = { X_BENCH(bench_sum) };
+  XBenchOptions options;
+  XBenchResult r;
+  s_options(&options);
+  options.json_path = TEMP_JSON;
+  ASSERT_EQ(x_bench_run_ex(benches, 1, &options, &r), 0);
+
+  FILE* f = fopen(TEMP_JSON, "rb");
+  ASSERT_TRUE(f);
+  char text[2048];
+  size_t len = fread(text, 1, sizeof(text) - 1, f);
+  text[len] = 0;
+  fclose(f);
+  ASSERT_TRUE(strncmp(text, "{\"benchmarks\":[", 15) == 0);
+  ASSERT_TRUE(strstr(text, "\"name\":\"bench_sum\"") != NULL);
+  ASSERT_TRUE(strstr(text, "\"median_ns\":") != NULL);
+
+  // A baseline ten times faster flags a regression, a slower one doesn't
+  f = fopen(TEMP_BASELINE, "wb");
+  ASSERT_TRUE(f);
+  fprintf(f, "{\"benchmarks\":[\n{\"name\":\"bench_sum\",\"median_ns\":%.4f}\n]}\n", r.median_ns / 10.0);
+  fclose(f);
+  options.json_path = NULL;
+  options.baseline_path = TEMP_BASELINE;
+  ASSERT_EQ(x_bench_run_ex(benches, 1, &options, &r), 1);
+  ASSERT_TRUE(r.regressed);
+  ASSERT_TRUE(r.baseline_ns > 0.0);
+
+  f = fopen(TEMP_BASELINE, "wb");
+  ASSERT_TRUE(f);
+  fprintf(f, "{\"benchmarks\":[\n{\"name\":\"bench_sum\",\"median_ns\":%.4f}\n]}\n", r.median_ns * 10.0);
+  fclose(f);
+  ASSERT_EQ(x_bench_run_ex(benches, 1, &options, &r), 0);
+  ASSERT_FALSE(r.regressed);
+
+  // Missing baseline files are an error
+  options.baseline_path = "test_tmp_bench_missing.json";
+  ASSERT_EQ(x_bench_run_ex(benches, 1, &options, &r), -1);
+
+  remove(TEMP_JSON);
+  remove(TEMP_BASELINE);
+  return 0;
+}
+
+int test_bench_run_help(void)
+{
+  XBenchCase benches[] = { X_BENCH(bench_sum) };
+  char exe[] = "test_bench", help[] = "--help", h[] = "-h", reps[] = "--reps";
+
+  // --help and -h print usage and run nothing
+  uint64_t calls = s_calls;
+  char* help_argv[] = { exe, help };
+  ASSERT_EQ(x_bench_run(benches, 1, 2, help_argv), 0);
+  char* h_argv[] = { exe, h };
+  ASSERT_EQ(x_bench_run(benches, 1, 2, h_argv), 0);
+  ASSERT_EQ(s_calls, calls);
+
+  // Options that take a value still need one
+  char* reps_argv[] = { exe, reps };
+  ASSERT_EQ(x_bench_run(benches, 1, 2, reps_argv), 1);
+  ASSERT_EQ(s_calls, calls);
+  return 0;
+}
+
+int main()
+{
+  STDXTestCase tests[] =
+  {
+    X_TEST(test_bench_stats),
+    X_TEST(test_bench_pause),
+    X_TEST(test_bench_baseline),
+    X_TEST(test_bench_run_help),
+  };
+
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
+}
@@ -0,0 +1,219 @@
+#define X_IMPL_TEST
+#include <stdx_test.h>
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_IMPL_HASHTABLE
+#include <stdx_hashtable.h>
+#define X_IMPL_CONCURRENT_HASHTABLE
+#include <stdx_concurrent_hashtable.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+X_CONCURRENT_HASHTABLE_TYPE_NAMED(int32_t, int32_t, ii)
+X_CONCURRENT_HASHTABLE_TYPE_CSTR_KEY_NAMED(int32_t, si)
+
+int test_concurrent_hashtable_basic(void)
+{
+  XConcurrentHashtable_ii* ht = x_concurrent_hashtable_ii_create();
+  ASSERT_TRUE(ht != NULL);
+
+  for (int32_t i = 0; i < 5000; ++i)
+    ASSERT_TRUE(x_concurrent_hashtable_ii_set(ht, i, i * 3));
+  ASSERT_EQ(x_concurrent_hashtable_ii_count(ht), 5000);
+
+  int32_t v = 0;
+  for (int32_t i = 0; i < 5000; ++i)
+  {
+    ASSERT_TRUE(x_concurrent_hashtable_ii_get(ht, i, &v));
+    ASSERT_EQ(v, i * 3);
+  }
+  ASSERT_FALSE(x_concurrent_hashtable_ii_has(ht, 5000));
+
+  // Overwrite keeps the count, remove drops it
+  ASSERT_TRUE(x_concurrent_hashtable_ii_set(ht, 10, -1));
+  ASSERT_EQ(x_concurrent_hashtable_ii_count(ht), 5000);
+  ASSERT_TRUE(x_concurrent_hashtable_ii_get(ht, 10, &v));
+  ASSERT_EQ(v, -1);
+
+  for (int32_t i = 0; i < 5000; i += 2)
+    ASSERT_TRUE(x_concurrent_hashtable_ii_remove(ht, i));
+  ASSERT_FALSE(x_concurrent_hashtable_ii_remove(ht, 0));
+  ASSERT_EQ(x_concurrent_hashtable_ii_count(ht), 2500);
+
+  for (int32_t i = 0; i < 5000; ++i)
+    ASSERT_EQ(x_concurrent_hashtable_ii_has(ht, i), (i % 2) != 0);
+
+  x_concurrent_hashtable_ii_destroy(ht);
+  return 0;
+}
+
+int test_concurrent_hashtable_cstr_keys(void)
+{
+  XConcurrentHashtable_si* ht = x_concurrent_hashtable_si_create();
+  ASSERT_TRUE(ht != NULL);
+
+  char buf[32];
+  for (int32_t i = 0; i < 1000; ++i)
+  {
+    snprintf(buf, sizeof(buf), "key_%d", i);
+    ASSERT_TRUE(x_concurrent_hashtable_si_set(ht, buf, i));
+  }
+
+  // Keys are cloned, so the caller's buffer can be reused
+  int32_t v = 0;
+  ASSERT_TRUE(x_concurrent_hashtable_si_get(ht, "key_123", &v));
+  ASSERT_EQ(v, 123);
+  ASSERT_TRUE(x_concurrent_hashtable_si_set(ht, "key_123", 7));
+  ASSERT_TRUE(x_concurrent_hashtable_si_get(ht, "key_123", &v));
+  ASSERT_EQ(v, 7);
+  ASSERT_TRUE(x_concurrent_hashtable_si_remove(ht, "key_999"));
+  ASSERT_FALSE(x_concurrent_hashtable_si_has(ht, "key_999"));
+  ASSERT_EQ(x_concurrent_hashtable_si_count(ht), 999);
+
+  x_concurrent_hashtable_si_destroy(ht);
+  return 0;
+}
+
+int test_concurrent_hashtable_iter(void)
+{
+  XConcurrentHashtable* ht = x_concurrent_hashtable_create_ex(sizeof(char*), true, true, sizeof(int32_t), false, false);
+  ASSERT_TRUE(ht != NULL);
+
+  char buf[32];
+  for (int32_t i = 0; i < 300; ++i)
+  {
+    snprintf(buf, sizeof(buf), "k%d", i);
+    ASSERT_TRUE(x_concurrent_hashtable_set(ht, buf, &i));
+  }
+
+  XConcurrentHashtableIter it;
+  void* key;
+  void* value;
+  int32_t seen = 0;
+  int64_t sum = 0;
+
+  ASSERT_TRUE(x_concurrent_hashtable_iter_begin(ht, &it));
+  while (x_concurrent_hashtable_iter_next(&it, &key, &value))
+  {
+    int32_t n = *(int32_t*)value;
+    snprintf(buf, sizeof(buf), "k%d", n);
+    ASSERT_TRUE(strcmp((const char*)key, buf) == 0);
+    sum += n;
+    seen++;
+  }
+  x_concurrent_hashtable_iter_end(&it);
+
+  ASSERT_EQ(seen, 300);
+  ASSERT_EQ(sum, 299 * 300 / 2);
+
+  x_concurrent_hashtable_destroy(ht);
+  return 0;
+}
+
+#define CHT_READERS 4
+#define CHT_KEYS 1024
+#define CHT_WRITER_ROUNDS 20
+
+typedef struct
+{
+  XConcurrentHashtable* ht;
+  volatile int32_t* done;
+  bool ok;
+  int64_t lookups;
+} ChtWorker;
+
+// Stable keys [0, CHT_KEYS) always map to key * 2; churn keys are added and removed
+static void* cht_reader(void* arg)
+{
+  ChtWorker* w = (ChtWorker*)arg;
+  int32_t i = 0;
+
+  while (x_atomic_load_i32(w->done) == 0)
+  {
+    int32_t key = i % CHT_KEYS;
+    int32_t v = 0;
+    if (!x_concurrent_hashtable_get(w->ht, &key, &v) || v != key * 2)
+      w->ok = false;
+
+    key = CHT_KEYS + (i % CHT_KEYS);
+    if (x_concurrent_hashtable_get(w->ht, &key, &v) && v != key * 2)
+      w->ok = false;
+
+    w->lookups++;
+    i++;
+  }
+
+  x_concurrent_hashtable_thread_detach();
+  return NULL;
+}
+
+int test_concurrent_hashtable_threaded(void)
+{
+  XConcurrentHashtable* ht = x_concurrent_hashtable_create_ex(sizeof(int32_t), false, false, sizeof(int32_t), false, false);
+  ASSERT_TRUE(ht != NULL);
+
+  for (int32_t i = 0; i < CHT_KEYS; ++i)
+  {
+    int32_t v = i * 2;
+    ASSERT_TRUE(x_concurrent_hashtable_set(ht, &i, &v));
+  }
+
+  volatile int32_t done = 0;
+  ChtWorker workers[CHT_READERS];
+  XThread* threads[CHT_READERS];
+
+  for (int i = 0; i < CHT_READERS; ++i)
+  {
+    memset(&workers[i], 0, sizeof(workers[i]));
+    workers[i].ht = ht;
+    workers[i].done = &done;
+    workers[i].ok = true;
+    ASSERT_EQ(x_thread_create(&threads[i], cht_reader, &workers[i]), 0);
+  }
+
+  // Overwrites of stable keys and churn on the rest force node and array reclamation
+  for (int round = 0; round < CHT_WRITER_ROUNDS; ++round)
+  {
+    for (int32_t i = 0; i < CHT_KEYS; ++i)
+    {
+      int32_t key = CHT_KEYS + i;
+      int32_t v = key * 2;
+      ASSERT_TRUE(x_concurrent_hashtable_set(ht, &key, &v));
+      v = i * 2;
+      ASSERT_TRUE(x_concurrent_hashtable_set(ht, &i, &v));
+    }
+    for (int32_t i = 0; i < CHT_KEYS; ++i)
+    {
+      int32_t key = CHT_KEYS + i;
+      ASSERT_TRUE(x_concurrent_hashtable_remove(ht, &key));
+    }
+  }
+
+  x_atomic_store_i32(&done, 1);
+  for (int i = 0; i < CHT_READERS; ++i)
+  {
+    x_thread_join(threads[i]);
+    x_thread_destroy(threads[i]);
+    ASSERT_TRUE(workers[i].ok);
+    ASSERT_TRUE(workers[i].lookups > 0);
+  }
+
+  ASSERT_EQ(x_concurrent_hashtable_count(ht), CHT_KEYS);
+  x_concurrent_hashtable_destroy(ht);
+  return 0;
+}
+
+int main()
+{
+  STDXTestCase tests[] =
+  {
+    X_TEST(test_concurrent_hashtable_basic),
+    X_TEST(test_concurrent_hashtable_cstr_keys),
+    X_TEST(test_concurrent_hashtable_iter),
+    X_TEST(test_concurrent_hashtable_threaded),
+  };
+
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
+}
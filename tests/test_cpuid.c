@@ -4,6 +4,8 @@
 #define X_IMPL_CPUID
 #include <stdx_cpuid.h>
 
+#include <string.h>
+
 int test_cpuid(void)
 {
   XCPUInfo info = x_cpu_info();
@@ -14,7 +16,8 @@ int test_cpuid(void)
   printf("L1 Cache        : %6d KB\n", info.cache_size_l1_kb);
   printf("L2 Cache        : %6d KB\n", info.cache_size_l2_kb);
   printf("L3 Cache        : %6d KB\n", info.cache_size_l3_kb);
-  printf("Feature Flags   :%s%s%s%s%s%s%s%s%s%s%s%s\n",
+  printf("Cache line      : %6d B\n", info.cache_line_size);
+  printf("Feature Flags   :%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s%s\n",
       (info.feature_flags & CPU_FEATURE_SSE) ? " sse" : "",
       (info.feature_flags & CPU_FEATURE_SSE2) ? " sse2" : "",
       (info.feature_flags & CPU_FEATURE_SSE3) ? " sse3" : "",
@@ -24,6 +27,11 @@ int test_cpuid(void)
       (info.feature_flags & CPU_FEATURE_AVX) ? " avx" : "",
       (info.feature_flags & CPU_FEATURE_AVX2) ? " avx2" : "",
       (info.feature_flags & CPU_FEATURE_AVX512F) ? " avx512f" : "",
+      (info.feature_flags & CPU_FEATURE_AVX512BW) ? " avx512bw" : "",
+      (info.feature_flags & CPU_FEATURE_FMA) ? " fma" : "",
+      (info.feature_flags & CPU_FEATURE_POPCNT) ? " popcnt" : "",
+      (info.feature_flags & CPU_FEATURE_BMI2) ? " bmi2" : "",
+      (info.feature_flags & CPU_FEATURE_INVARIANT_TSC) ? " invtsc" : "",
       (info.feature_flags & CPU_FEATURE_NEON) ? " neon" : "",
       (info.feature_flags & CPU_FEATURE_AES) ? " aes" : "",
       (info.feature_flags & CPU_FEATURE_CRC32) ? " crc32" : "");
@@ -32,11 +40,167 @@ int test_cpuid(void)
   return 0;
 }
 
+int test_cpu_features_cached(void)
+{
+  CPUFeature first = x_cpu_features();
+  ASSERT_EQ(x_cpu_features(), first);
+  ASSERT_EQ(first, x_cpu_info().feature_flags);
+#if defined(__x86_64__) || defined(_M_X64)
+  // Part of the x86-64 baseline
+  ASSERT_TRUE(first & CPU_FEATURE_SSE2);
+#endif
+  // AVX2 is never reported without the AVX state saved by the OS
+  if (first & CPU_FEATURE_AVX2)
+    ASSERT_TRUE(first & CPU_FEATURE_AVX);
+  return 0;
+}
+
+int test_cpu_feature_mask(void)
+{
+  CPUFeature all = x_cpu_features();
+  x_cpu_set_feature_mask(CPU_FEATURE_SSE2);
+  ASSERT_EQ(x_cpu_features(), all & CPU_FEATURE_SSE2);
+  x_cpu_set_feature_mask(0);
+  ASSERT_EQ(x_cpu_features(), CPU_FEATURE_NONE);
+  x_cpu_set_feature_mask(~0u);
+  ASSERT_EQ(x_cpu_features(), all);
+  return 0;
+}
+
+static int s_kernel_scalar(int x) { return x + 1; }
+static int s_kernel_sse2(int x) { return x + 2; }
+static int s_kernel_avx512(int x) { return x + 3; }
+
+typedef int (*KernelFn)(int);
+
+X_CPU_DISPATCH(s_kernel, KernelFn,
+    X_CPU_KERNEL(CPU_FEATURE_AVX512F | CPU_FEATURE_AVX512BW, s_kernel_avx512),
+    X_CPU_KERNEL(CPU_FEATURE_SSE2, s_kernel_sse2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_kernel_scalar))
+
+int test_cpu_select(void)
+{
+  XCPUKernel kernels[] =
+  {
+    X_CPU_KERNEL(CPU_FEATURE_SSE2, s_kernel_sse2),
+    X_CPU_KERNEL(CPU_FEATURE_NONE, s_kernel_scalar),
+  };
+  x_cpu_set_feature_mask(0);
+  ASSERT_EQ(x_cpu_select(kernels, 2), &kernels[1]);
+  ASSERT_TRUE(strcmp(x_cpu_select(kernels, 2)->name, "s_kernel_scalar") == 0);
+  // Nothing runs when every candidate needs something missing
+  ASSERT_TRUE(x_cpu_select(kernels, 1) == NULL);
+  x_cpu_set_feature_mask(~0u);
+  if (x_cpu_features() & CPU_FEATURE_SSE2)
+    ASSERT_EQ(x_cpu_select(kernels, 2), &kernels[0]);
+  return 0;
+}
+
+int test_cpu_dispatch(void)
+{
+  CPUFeature all = x_cpu_features();
+  int expected = 1;
+  if ((all & CPU_FEATURE_AVX512F) && (all & CPU_FEATURE_AVX512BW))
+    expected = 3;
+  else if (all & CPU_FEATURE_SSE2)
+    expected = 2;
+
+  ASSERT_TRUE(s_kernel == NULL);
+  ASSERT_EQ(X_CPU_CALL(s_kernel)(10), 10 + expected);
+  ASSERT_TRUE(s_kernel != NULL);
+
+  // The choice sticks until reset
+  x_cpu_set_feature_mask(0);
+  ASSERT_EQ(X_CPU_CALL(s_kernel)(10), 10 + expected);
+  X_CPU_RESET(s_kernel);
+  ASSERT_EQ(X_CPU_CALL(s_kernel)(10), 11);
+
+  x_cpu_set_feature_mask(~0u);
+  X_CPU_RESET(s_kernel);
+  X_CPU_RESOLVE(s_kernel);
+  ASSERT_EQ(s_kernel(10), 10 + expected);
+  return 0;
+}
+
+int test_cpuset(void)
+{
+  XCPUSet set;
+  x_cpuset_clear(&set);
+  ASSERT_EQ(x_cpuset_count(&set), 0);
+  ASSERT_EQ(x_cpuset_next(&set, -1), -1);
+  x_cpuset_add(&set, 3);
+  x_cpuset_add(&set, 64);
+  x_cpuset_add(&set, X_CPU_MAX_CPUS - 1);
+  x_cpuset_add(&set, X_CPU_MAX_CPUS);   // ignored
+  x_cpuset_add(&set, -1);               // ignored
+  ASSERT_EQ(x_cpuset_count(&set), 3);
+  ASSERT_TRUE(x_cpuset_has(&set, 64));
+  ASSERT_FALSE(x_cpuset_has(&set, 63));
+  ASSERT_EQ(x_cpuset_next(&set, -1), 3);
+  ASSERT_EQ(x_cpuset_next(&set, 3), 64);
+  ASSERT_EQ(x_cpuset_next(&set, 64), X_CPU_MAX_CPUS - 1);
+  ASSERT_EQ(x_cpuset_next(&set, X_CPU_MAX_CPUS - 1), -1);
+  x_cpuset_remove(&set, 64);
+  ASSERT_FALSE(x_cpuset_has(&set, 64));
+  ASSERT_EQ(x_cpuset_count(&set), 2);
+  return 0;
+}
+
+int test_cpu_topology(void)
+{
+  XCPUTopology t;
+  ASSERT_TRUE(x_cpu_topology(&t));
+  ASSERT_TRUE(t.cpu_count > 0);
+  ASSERT_TRUE(t.core_count > 0 && t.core_count <= t.cpu_count);
+  ASSERT_TRUE(t.package_count > 0 && t.package_count <= t.core_count);
+  ASSERT_TRUE(t.numa_node_count > 0);
+  ASSERT_TRUE(t.cache_line_size >= 16);
+
+  for (int32_t i = 0; i < t.cpu_count; i++)
+  {
+    const XCPULogical* l = &t.cpus[i];
+    ASSERT_TRUE(i == 0 || l->cpu > t.cpus[i - 1].cpu);
+    ASSERT_TRUE(x_cpu_topology_find(&t, l->cpu) == l);
+    ASSERT_TRUE(l->core >= 0 && l->core < t.core_count);
+    ASSERT_TRUE(l->package >= 0 && l->package < t.package_count);
+    ASSERT_TRUE(l->numa_node >= 0 && l->numa_node < t.numa_node_count);
+    if (l->smt_sibling >= 0)
+      ASSERT_EQ(x_cpu_topology_find(&t, l->smt_sibling)->core, l->core);
+    for (int32_t level = 0; level < 3; level++)
+    {
+      if (l->cache[level] < 0)
+        continue;
+      ASSERT_TRUE(l->cache[level] < t.cache_count);
+      ASSERT_EQ(t.caches[l->cache[level]].level, level + 1);
+      ASSERT_TRUE(x_cpuset_has(&t.caches[l->cache[level]].cpus, l->cpu));
+    }
+  }
+
+  XCPUSet cores;
+  ASSERT_EQ(x_cpu_topology_cores(&t, -1, &cores), t.core_count);
+  XCPUSet node;
+  int32_t total = 0;
+  for (int32_t n = 0; n < t.numa_node_count; n++)
+    total += x_cpu_topology_node(&t, n, &node);
+  ASSERT_EQ(total, t.cpu_count);
+  ASSERT_TRUE(x_cpu_topology_find(&t, -1) == NULL);
+
+  x_cpu_topology_free(&t);
+  ASSERT_TRUE(t.cpus == NULL && t.caches == NULL);
+  return 0;
+}
+
 int main()
 {
   STDXTestCase tests[] =
   {
-    X_TEST(test_cpuid)
+    X_TEST(test_cpuid),
+    X_TEST(test_cpu_features_cached),
+    X_TEST(test_cpu_feature_mask),
+    X_TEST(test_cpu_select),
+    X_TEST(test_cpu_dispatch),
+    X_TEST(test_cpuset),
+    X_TEST(test_cpu_topology),
   };
 
   return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
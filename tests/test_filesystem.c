@@ -104,6 +104,11 @@ int test_x_fs_path_relative(void)
   XFSPath rel;
   ASSERT_TRUE(x_fs_path_common_prefix("/usr/local/", "/usr/local/bin/gcc", &rel));
   ASSERT_TRUE(x_fs_path_compare_cstr(&rel, "bin/gcc") == 0);
+
+  ASSERT_TRUE(x_fs_path_relative_to_cstr("site/content", "site/content/assets/bg.jpg", &rel) > 0);
+  ASSERT_TRUE(x_fs_path_compare_cstr(&rel, "assets/bg.jpg") == 0);
+  ASSERT_TRUE(x_fs_path_relative_to_cstr("site/content/posts", "site/content/assets/bg.jpg", &rel) > 0);
+  ASSERT_TRUE(x_fs_path_compare_cstr(&rel, "../assets/bg.jpg") == 0);
   return 0;
 }
 
@@ -164,6 +169,194 @@ int test_x_fs_file_operations(void)
   return 0;
 }
 
+static bool s_write_test_file(const char* path, size_t size, char fill)
+{
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  for (size_t i = 0; i < size; i++)
+    fputc(fill + (char)(i % 7), f);
+  fclose(f);
+  return true;
+}
+
+static bool s_files_equal(const char* a, const char* b)
+{
+  FILE* fa = fopen(a, "rb");
+  FILE* fb = fopen(b, "rb");
+  bool same = fa && fb;
+  while (same)
+  {
+    int ca = fgetc(fa);
+    int cb = fgetc(fb);
+    if (ca != cb) same = false;
+    if (ca == EOF) break;
+  }
+  if (fa) fclose(fa);
+  if (fb) fclose(fb);
+  return same;
+}
+
+int test_x_fs_file_copy_large(void)
+{
+  // Large enough to need several kernel copy calls or fallback iterations
+  ASSERT_TRUE(s_write_test_file("copy_big_src.bin", 3 * 1024 * 1024 + 17, 'a'));
+  ASSERT_TRUE(x_fs_file_copy("copy_big_src.bin", "copy_big_dst.bin"));
+  ASSERT_TRUE(s_files_equal("copy_big_src.bin", "copy_big_dst.bin"));
+
+  // Overwriting a longer file truncates it
+  ASSERT_TRUE(s_write_test_file("copy_big_src.bin", 10, 'x'));
+  ASSERT_TRUE(x_fs_file_copy("copy_big_src.bin", "copy_big_dst.bin"));
+  ASSERT_TRUE(s_files_equal("copy_big_src.bin", "copy_big_dst.bin"));
+
+  ASSERT_FALSE(x_fs_file_copy("copy_missing.bin", "copy_big_dst.bin"));
+  remove("copy_big_src.bin");
+  remove("copy_big_dst.bin");
+  return 0;
+}
+
+int test_x_fs_copy_tree(void)
+{
+  ASSERT_TRUE(x_fs_directory_create_recursive("copytree_src/sub/deeper"));
+  ASSERT_TRUE(s_write_test_file("copytree_src/a.txt", 100, 'a'));
+  ASSERT_TRUE(s_write_test_file("copytree_src/sub/b.bin", 300000, 'b'));
+  ASSERT_TRUE(s_write_test_file("copytree_src/sub/deeper/c.txt", 0, 'c'));
+
+  XThreadPool* pool = x_threadpool_create(4);
+  ASSERT_TRUE(pool != NULL);
+
+  XFSCopyStats stats;
+  ASSERT_TRUE(x_fs_copy_tree("copytree_src", "copytree_dst", X_FS_COPY_SKIP_UNCHANGED, pool, &stats));
+  ASSERT_EQ(stats.files_copied, 3);
+  ASSERT_EQ(stats.files_skipped, 0);
+  ASSERT_EQ(stats.bytes_copied, 300100);
+  ASSERT_TRUE(s_files_equal("copytree_src/a.txt", "copytree_dst/a.txt"));
+  ASSERT_TRUE(s_files_equal("copytree_src/sub/b.bin", "copytree_dst/sub/b.bin"));
+  ASSERT_TRUE(x_fs_path_is_file_cstr("copytree_dst/sub/deeper/c.txt"));
+
+  // Second run copies nothing; a resized file is copied again, serially this time
+  ASSERT_TRUE(x_fs_copy_tree("copytree_src", "copytree_dst", X_FS_COPY_SKIP_UNCHANGED, pool, &stats));
+  ASSERT_EQ(stats.files_copied, 0);
+  ASSERT_EQ(stats.files_skipped, 3);
+
+  ASSERT_TRUE(s_write_test_file("copytree_src/a.txt", 50, 'z'));
+  ASSERT_TRUE(x_fs_copy_tree("copytree_src", "copytree_dst", X_FS_COPY_SKIP_UNCHANGED, NULL, &stats));
+  ASSERT_EQ(stats.files_copied, 1);
+  ASSERT_EQ(stats.files_skipped, 2);
+  ASSERT_TRUE(s_files_equal("copytree_src/a.txt", "copytree_dst/a.txt"));
+
+  ASSERT_FALSE(x_fs_copy_tree("copytree_missing", "copytree_dst", X_FS_COPY_DEFAULT, NULL, NULL));
+  x_threadpool_destroy(pool);
+
+  const char* files[] = { "a.txt", "sub/b.bin", "sub/deeper/c.txt" };
+  const char* dirs[] = { "sub/deeper", "sub", "" };
+  char path[256];
+  for (int i = 0; i < 3; i++)
+  {
+    snprintf(path, sizeof(path), "copytree_src/%s", files[i]); remove(path);
+    snprintf(path, sizeof(path), "copytree_dst/%s", files[i]); remove(path);
+  }
+  for (int i = 0; i < 3; i++)
+  {
+    snprintf(path, sizeof(path), "copytree_src/%s", dirs[i]); x_fs_directory_delete(path);
+    snprintf(path, sizeof(path), "copytree_dst/%s", dirs[i]); x_fs_directory_delete(path);
+  }
+  ASSERT_FALSE(x_fs_path_exists_cstr("copytree_dst"));
+  return 0;
+}
+
+typedef struct
+{
+  volatile int32_t files;
+  volatile int32_t dirs;
+  volatile int64_t bytes;
+  volatile int32_t max_depth;
+  int32_t stop_after;
+} WalkCounts;
+
+static bool s_walk_filter(const XFSWalkEntry* entry, void* user)
+{
+  (void)user;
+  return strcmp(entry->name, "skipped") != 0;
+}
+
+static bool s_walk_count(const XFSWalkEntry* entry, void* user)
+{
+  WalkCounts* c = (WalkCounts*)user;
+  if (entry->type == X_FS_ENTRY_DIRECTORY)
+  {
+    x_atomic_fetch_add_i32(&c->dirs, 1);
+  }
+  else if (entry->type == X_FS_ENTRY_FILE)
+  {
+    x_atomic_fetch_add_i32(&c->files, 1);
+    x_atomic_fetch_add_i64(&c->bytes, (int64_t)entry->size);
+  }
+
+  int32_t depth = (int32_t)entry->depth;
+  int32_t seen = x_atomic_load_i32(&c->max_depth);
+  while (depth > seen && !x_atomic_cas_i32(&c->max_depth, seen, depth))
+    seen = x_atomic_load_i32(&c->max_depth);
+
+  // The path always ends with the name
+  if (strcmp(entry->path + entry->path_length - strlen(entry->name), entry->name) != 0)
+    return false;
+  return c->stop_after == 0 || x_atomic_load_i32(&c->files) < c->stop_after;
+}
+
+int test_x_fs_walk(void)
+{
+  ASSERT_TRUE(x_fs_directory_create_recursive("walk_root/a/b"));
+  ASSERT_TRUE(x_fs_directory_create_recursive("walk_root/skipped"));
+  ASSERT_TRUE(s_write_test_file("walk_root/one.txt", 10, 'a'));
+  ASSERT_TRUE(s_write_test_file("walk_root/a/two.txt", 20, 'a'));
+  ASSERT_TRUE(s_write_test_file("walk_root/a/b/three.txt", 30, 'a'));
+  ASSERT_TRUE(s_write_test_file("walk_root/skipped/hidden.txt", 40, 'a'));
+
+  // Immediate children only, no stat
+  WalkCounts c;
+  memset(&c, 0, sizeof(c));
+  ASSERT_TRUE(x_fs_walk("walk_root", X_FS_WALK_DEFAULT, NULL, s_walk_count, &c, NULL));
+  ASSERT_EQ(c.files, 1);
+  ASSERT_EQ(c.dirs, 2);
+  ASSERT_EQ(c.bytes, 0);
+
+  // Recursive with stat; the filter prunes a whole subtree
+  memset(&c, 0, sizeof(c));
+  ASSERT_TRUE(x_fs_walk("walk_root/", X_FS_WALK_RECURSIVE | X_FS_WALK_STAT, s_walk_filter, s_walk_count, &c, NULL));
+  ASSERT_EQ(c.files, 3);
+  ASSERT_EQ(c.dirs, 2);
+  ASSERT_EQ(c.bytes, 60);
+  ASSERT_EQ(c.max_depth, 2);
+
+  // Same result fanned out on a pool
+  XThreadPool* pool = x_threadpool_create(4);
+  ASSERT_TRUE(pool != NULL);
+  WalkCounts p;
+  memset(&p, 0, sizeof(p));
+  ASSERT_TRUE(x_fs_walk("walk_root", X_FS_WALK_RECURSIVE | X_FS_WALK_STAT, s_walk_filter, s_walk_count, &p, pool));
+  ASSERT_EQ(p.files, c.files);
+  ASSERT_EQ(p.dirs, c.dirs);
+  ASSERT_EQ(p.bytes, c.bytes);
+  x_threadpool_destroy(pool);
+
+  // Stopping early reports failure
+  memset(&c, 0, sizeof(c));
+  c.stop_after = 1;
+  ASSERT_FALSE(x_fs_walk("walk_root", X_FS_WALK_RECURSIVE, NULL, s_walk_count, &c, NULL));
+  ASSERT_EQ(c.files, 1);
+  ASSERT_FALSE(x_fs_walk("walk_missing", X_FS_WALK_RECURSIVE, NULL, s_walk_count, &c, NULL));
+
+  remove("walk_root/one.txt");
+  remove("walk_root/a/two.txt");
+  remove("walk_root/a/b/three.txt");
+  remove("walk_root/skipped/hidden.txt");
+  x_fs_directory_delete("walk_root/skipped");
+  x_fs_directory_delete("walk_root/a/b");
+  x_fs_directory_delete("walk_root/a");
+  x_fs_directory_delete("walk_root");
+  return 0;
+}
+
 int test_x_fs_path_functions(void)
 {
 #if defined(_WIN32)
@@ -296,6 +489,80 @@ int test_x_fs_watch_empty(void)
   return 0;
 }
 
+#ifdef _WIN32
+#define WATCH_SEP "\\"
+#else
+#define WATCH_SEP "/"
+#endif
+
+static int32_t s_watch_find(const XFSWatchEvent* events, int32_t count, const char* suffix)
+{
+  size_t n = strlen(suffix);
+  for (int32_t i = 0; i < count; i++)
+  {
+    size_t len = strlen(events[i].filename);
+    if (len >= n && strcmp(events[i].filename + len - n, suffix) == 0)
+      return i;
+  }
+  return -1;
+}
+
+int test_x_fs_watch_set(void)
+{
+  ASSERT_TRUE(x_fs_directory_create_recursive("watch_root/sub"));
+  XFSWatchSet* set = x_fs_watch_set_create(50);
+  ASSERT_TRUE(set != NULL);
+  ASSERT_TRUE(x_fs_watch_set_handle(set) != -1);
+  ASSERT_TRUE(x_fs_watch_set_add(set, "watch_root", true));
+  ASSERT_FALSE(x_fs_watch_set_add(set, "watch_missing", true));
+  ASSERT_EQ(x_fs_watch_set_timeout(set), -1);
+
+  // A burst of writes to one file, plus a file that comes and goes.
+  // Events are timed from the poll that reads them, as an event loop polls when the handle is ready
+  ASSERT_TRUE(s_write_test_file("watch_root/sub/a.txt", 100, 'a'));
+  ASSERT_TRUE(s_write_test_file("watch_root/sub/a.txt", 200, 'b'));
+  ASSERT_TRUE(s_write_test_file("watch_root/tmp.txt", 10, 'c'));
+  remove("watch_root/tmp.txt");
+
+  XFSWatchEvent events[16];
+  ASSERT_EQ(x_fs_watch_set_poll(set, events, 16), 0);
+  ASSERT_TRUE(x_fs_watch_set_timeout(set) >= 0);
+
+  x_thread_sleep_ms(120);
+  int32_t count = x_fs_watch_set_poll(set, events, 16);
+  ASSERT_EQ(count, 1);
+  ASSERT_TRUE(s_watch_find(events, count, "sub" WATCH_SEP "a.txt") == 0);
+  ASSERT_EQ(events[0].action, x_fs_watch_CREATED);
+  ASSERT_EQ(x_fs_watch_set_timeout(set), -1);
+
+  // Directories created after the watch was added are watched too
+  ASSERT_TRUE(x_fs_directory_create("watch_root/sub/new"));
+  ASSERT_EQ(x_fs_watch_set_poll(set, events, 16), 0);
+  ASSERT_TRUE(s_write_test_file("watch_root/sub/new/b.txt", 10, 'd'));
+  ASSERT_EQ(x_fs_watch_set_poll(set, events, 16), 0);
+  x_thread_sleep_ms(120);
+  count = x_fs_watch_set_poll(set, events, 16);
+  ASSERT_TRUE(s_watch_find(events, count, "new") >= 0);
+  ASSERT_TRUE(s_watch_find(events, count, "new" WATCH_SEP "b.txt") >= 0);
+
+  // Replacing a file inside one window reads as a modification
+  remove("watch_root/sub/a.txt");
+  ASSERT_TRUE(s_write_test_file("watch_root/sub/a.txt", 10, 'e'));
+  ASSERT_EQ(x_fs_watch_set_poll(set, events, 16), 0);
+  x_thread_sleep_ms(120);
+  count = x_fs_watch_set_poll(set, events, 16);
+  ASSERT_EQ(count, 1);
+  ASSERT_EQ(events[0].action, x_fs_watch_MODIFIED);
+
+  x_fs_watch_set_destroy(set);
+  remove("watch_root/sub/new/b.txt");
+  remove("watch_root/sub/a.txt");
+  x_fs_directory_delete("watch_root/sub/new");
+  x_fs_directory_delete("watch_root/sub");
+  x_fs_directory_delete("watch_root");
+  return 0;
+}
+
 int main()
 {
   STDXTestCase tests[] =
@@ -315,12 +582,16 @@ int main()
     X_TEST(test_x_fs_path_equality),
     X_TEST(test_x_fs_path_functions),
     X_TEST(test_x_fs_file_operations),
+    X_TEST(test_x_fs_file_copy_large),
+    X_TEST(test_x_fs_copy_tree),
+    X_TEST(test_x_fs_walk),
     X_TEST(test_x_fs_directory_operations),
     X_TEST(test_x_fs_cwd_functions),
     X_TEST(test_x_fs_directory_traversal),
     X_TEST(test_x_fs_temp_folder),
 
     X_TEST(test_x_fs_watch_empty),
+    X_TEST(test_x_fs_watch_set),
     X_TEST(test_x_fs_path_join_slice),
 
   };
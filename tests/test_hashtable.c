@@ -415,6 +415,427 @@ int test_typed_hashtable_i32_struct(void)
   return 0;
 }
 
+X_FLAT_HASHTABLE_TYPE(int32_t, int32_t)
+X_FLAT_HASHTABLE_TYPE_CSTR_KEY_NAMED(int32_t, flat_cstr_i32)
+
+int test_flat_hashtable_basic(void)
+{
+  XFlatHashtable_int32_t_int32_t* ht = x_flat_hashtable_int32_t_int32_t_create();
+  ASSERT_TRUE(ht != NULL);
+
+  ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_set(ht, 1, 10));
+  ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_set(ht, 2, 20));
+  ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_set(ht, 2, 30));
+  ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_count(ht) == 2);
+
+  {
+    int32_t out = 0;
+    ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_get(ht, 2, &out));
+    ASSERT_TRUE(out == 30);
+    ASSERT_FALSE(x_flat_hashtable_int32_t_int32_t_get(ht, 3, &out));
+  }
+
+  ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_remove(ht, 1));
+  ASSERT_FALSE(x_flat_hashtable_int32_t_int32_t_remove(ht, 1));
+  ASSERT_FALSE(x_flat_hashtable_int32_t_int32_t_has(ht, 1));
+  ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_count(ht) == 1);
+
+  x_flat_hashtable_int32_t_int32_t_destroy(ht);
+  return 0;
+}
+
+// Insert, remove and reinsert enough keys to go through growth and tombstone purges
+int test_flat_hashtable_churn(void)
+{
+  XFlatHashtable_int32_t_int32_t* ht = x_flat_hashtable_int32_t_int32_t_create();
+  int32_t i;
+  int32_t round;
+  ASSERT_TRUE(ht != NULL);
+
+  for (i = 0; i < 5000; i++)
+  {
+    ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_set(ht, i, i * 3));
+  }
+  ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_count(ht) == 5000);
+
+  for (round = 0; round < 4; round++)
+  {
+    for (i = round; i < 5000; i += 2)
+    {
+      ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_remove(ht, i));
+    }
+    for (i = round; i < 5000; i += 2)
+    {
+      ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_set(ht, i, i * 3 + round));
+    }
+  }
+
+  ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_count(ht) == 5000);
+  for (i = 0; i < 5000; i++)
+  {
+    int32_t out = -1;
+    int32_t last_round = (i % 2 == 0) ? 2 : 3;
+    if (i < last_round)
+      last_round -= 2;
+    ASSERT_TRUE(x_flat_hashtable_int32_t_int32_t_get(ht, i, &out));
+    ASSERT_TRUE(out == i * 3 + last_round);
+  }
+  ASSERT_FALSE(x_flat_hashtable_int32_t_int32_t_has(ht, 5000));
+
+  x_flat_hashtable_int32_t_int32_t_destroy(ht);
+  return 0;
+}
+
+int test_flat_hashtable_cstr_keys(void)
+{
+  XFlatHashtable_flat_cstr_i32* ht = x_flat_hashtable_flat_cstr_i32_create();
+  ASSERT_TRUE(ht != NULL);
+
+  {
+    char buf[32];
+    int32_t i;
+    for (i = 0; i < 200; i++)
+    {
+      sprintf(buf, "key_%d", i);
+      ASSERT_TRUE(x_flat_hashtable_flat_cstr_i32_set(ht, buf, i));
+    }
+  }
+
+  {
+    int32_t out = 0;
+    ASSERT_TRUE(x_flat_hashtable_flat_cstr_i32_get(ht, "key_123", &out));
+    ASSERT_TRUE(out == 123);
+    ASSERT_FALSE(x_flat_hashtable_flat_cstr_i32_has(ht, "key_200"));
+  }
+
+  ASSERT_TRUE(x_flat_hashtable_flat_cstr_i32_remove(ht, "key_7"));
+  ASSERT_FALSE(x_flat_hashtable_flat_cstr_i32_has(ht, "key_7"));
+  ASSERT_TRUE(x_flat_hashtable_flat_cstr_i32_count(ht) == 199);
+
+  x_flat_hashtable_flat_cstr_i32_destroy(ht);
+  return 0;
+}
+
+int test_flat_hashtable_iter(void)
+{
+  XFlatHashtable* ht = x_flat_hashtable_create_ex(sizeof(int32_t), false, false, sizeof(double), false, false);
+  XFlatHashtableIter it;
+  void* k;
+  void* v;
+  int32_t i;
+  int64_t key_sum = 0;
+  size_t seen = 0;
+  ASSERT_TRUE(ht != NULL);
+
+  for (i = 1; i <= 100; i++)
+  {
+    double d = i * 0.5;
+    ASSERT_TRUE(x_flat_hashtable_set(ht, &i, &d));
+  }
+
+  ASSERT_TRUE(x_flat_hashtable_iter_begin(ht, &it));
+  while (x_flat_hashtable_iter_next(&it, &k, &v))
+  {
+    ASSERT_TRUE(*(double*)v == *(int32_t*)k * 0.5);
+    key_sum += *(int32_t*)k;
+    seen++;
+  }
+
+  ASSERT_TRUE(seen == 100);
+  ASSERT_TRUE(key_sum == 5050);
+
+  x_flat_hashtable_destroy(ht);
+  return 0;
+}
+
+int test_hashtable_hash_bytes(void)
+{
+  const char* text = "The quick brown fox jumps over the lazy dog, repeatedly and at length.";
+  size_t len = strlen(text);
+  size_t i;
+  size_t j;
+  uint8_t buckets[256] = { 0 };
+  int max_bucket = 0;
+
+  // Deterministic, and every prefix length gives a distinct hash
+  for (i = 0; i <= len; i++)
+  {
+    ASSERT_TRUE(x_hashtable_hash_bytes(text, i) == x_hashtable_hash_bytes(text, i));
+    for (j = 0; j < i; j++)
+    {
+      ASSERT_TRUE(x_hashtable_hash_bytes(text, i) != x_hashtable_hash_bytes(text, j));
+    }
+  }
+
+  ASSERT_TRUE(x_hashtable_hash_cstr("hello", 0) == x_hashtable_hash_bytes("hello", 5));
+
+  // Sequential integers must spread over the low bits used for indexing
+  for (i = 0; i < 1024; i++)
+  {
+    int32_t v = (int32_t)i;
+    uint8_t* b = &buckets[x_hashtable_hash_bytes(&v, sizeof(v)) & 255];
+    (*b)++;
+    if (*b > max_bucket)
+      max_bucket = *b;
+  }
+  ASSERT_TRUE(max_bucket < 16);
+  return 0;
+}
+
+// Keys are inserted and removed one at a time, so the table never grows
+// and must keep reusing tombstones
+int test_hashtable_tombstone_reuse(void)
+{
+  XHashtable* ht = x_hashtable_create_ex(sizeof(int32_t), false, false, sizeof(int32_t), false, false);
+  int32_t i;
+  ASSERT_TRUE(ht != NULL);
+
+  for (i = 0; i < 10000; i++)
+  {
+    int32_t out = 0;
+    ASSERT_TRUE(x_hashtable_set(ht, &i, &i));
+    ASSERT_TRUE(x_hashtable_get(ht, &i, &out));
+    ASSERT_TRUE(out == i);
+    ASSERT_TRUE(x_hashtable_remove(ht, &i));
+  }
+
+  ASSERT_TRUE(x_hashtable_count(ht) == 0);
+  x_hashtable_destroy(ht);
+  return 0;
+}
+
+int test_hashtable_incremental_resize(void)
+{
+  XHashtable* ht = x_hashtable_create_ex(sizeof(int32_t), false, false, sizeof(int32_t), false, false);
+  int32_t i;
+  bool saw_migration = false;
+  ASSERT_TRUE(ht != NULL);
+
+  x_hashtable_set_resize_mode(ht, XHASHTABLE_RESIZE_INCREMENTAL);
+
+  for (i = 0; i < 20000; i++)
+  {
+    int32_t out = -1;
+    ASSERT_TRUE(x_hashtable_set(ht, &i, &i));
+    saw_migration |= ht->old_entries != NULL;
+
+    // Keys inserted before the last growth must stay visible while it drains
+    if (i % 97 == 0 && (i / 2) % 10 != 4)
+    {
+      int32_t probe = i / 2;
+      ASSERT_TRUE(x_hashtable_get(ht, &probe, &out));
+      ASSERT_TRUE(out == probe);
+    }
+
+    // Overwrite and remove keys that may still live in the old arrays
+    if (i % 10 == 9)
+    {
+      int32_t victim = i - 5;
+      int32_t updated = victim + 1000000;
+      ASSERT_TRUE(x_hashtable_set(ht, &victim, &updated));
+      ASSERT_TRUE(x_hashtable_remove(ht, &victim));
+      ASSERT_FALSE(x_hashtable_has(ht, &victim));
+    }
+  }
+
+  ASSERT_TRUE(saw_migration);
+  ASSERT_TRUE(x_hashtable_count(ht) == 18000);
+
+  for (i = 0; i < 20000; i++)
+  {
+    int32_t out = -1;
+    bool removed = (i % 10) == 4;
+    ASSERT_TRUE(x_hashtable_get(ht, &i, &out) == !removed);
+    if (!removed)
+      ASSERT_TRUE(out == i);
+  }
+
+  x_hashtable_destroy(ht);
+  return 0;
+}
+
+int test_hashtable_incremental_resize_owned_strings(void)
+{
+  XHashtable* ht = x_hashtable_create_ex(sizeof(char*), true, true, sizeof(char*), true, true);
+  XHashtableIter it;
+  void* k;
+  void* v;
+  size_t seen = 0;
+  char key[32];
+  char value[32];
+  int i;
+  ASSERT_TRUE(ht != NULL);
+
+  x_hashtable_set_resize_mode(ht, XHASHTABLE_RESIZE_INCREMENTAL);
+
+  for (i = 0; i < 3000; i++)
+  {
+    sprintf(key, "k%d", i);
+    sprintf(value, "v%d", i);
+    ASSERT_TRUE(x_hashtable_set(ht, key, value));
+  }
+
+  // Iteration completes any pending migration first
+  ASSERT_TRUE(x_hashtable_iter_begin(ht, &it));
+  ASSERT_TRUE(ht->old_entries == NULL);
+  while (x_hashtable_iter_next(&it, &k, &v))
+  {
+    ASSERT_TRUE(((char*)k)[0] == 'k' && ((char*)v)[0] == 'v');
+    ASSERT_TRUE(strcmp((char*)k + 1, (char*)v + 1) == 0);
+    seen++;
+  }
+  ASSERT_TRUE(seen == 3000);
+
+  x_hashtable_destroy(ht);
+  return 0;
+}
+
+int test_hashtable_reserve(void)
+{
+  XHashtable* ht = x_hashtable_create_ex(sizeof(int32_t), false, false, sizeof(int32_t), false, false);
+  size_t capacity;
+  int32_t i;
+  ASSERT_TRUE(ht != NULL);
+
+  ASSERT_TRUE(x_hashtable_reserve(ht, 10000));
+  capacity = ht->capacity;
+  ASSERT_TRUE(capacity >= 10000);
+  ASSERT_TRUE((capacity & (capacity - 1)) == 0);
+
+  for (i = 0; i < 10000; i++)
+  {
+    ASSERT_TRUE(x_hashtable_set(ht, &i, &i));
+  }
+  ASSERT_TRUE(ht->capacity == capacity);
+
+  // Reserving less than the current capacity is a no-op
+  ASSERT_TRUE(x_hashtable_reserve(ht, 10));
+  ASSERT_TRUE(ht->capacity == capacity);
+
+  for (i = 0; i < 10000; i++)
+  {
+    int32_t out = -1;
+    ASSERT_TRUE(x_hashtable_get(ht, &i, &out));
+    ASSERT_TRUE(out == i);
+  }
+
+  x_hashtable_destroy(ht);
+  return 0;
+}
+
+int test_hashtable_get_many(void)
+{
+  XHashtable_cstr_i32* names = x_hashtable_cstr_i32_create();
+  XHashtable* ht = x_hashtable_create_ex(sizeof(int32_t), false, false, sizeof(int32_t), false, false);
+  int32_t keys[100];
+  int32_t values[100];
+  bool found[100];
+  int32_t i;
+  ASSERT_TRUE(ht != NULL && names != NULL);
+
+  x_hashtable_set_resize_mode(ht, XHASHTABLE_RESIZE_INCREMENTAL);
+  for (i = 0; i < 3000; i++)
+  {
+    int32_t v = i * 7;
+    ASSERT_TRUE(x_hashtable_set(ht, &i, &v));
+  }
+
+  // Even keys exist, odd keys above 3000 do not; the table may still be migrating
+  for (i = 0; i < 100; i++)
+  {
+    keys[i] = (i % 2 == 0) ? i * 20 : 3000 + i;
+    values[i] = -1;
+  }
+  ASSERT_EQ(x_hashtable_get_many(ht, keys, 100, values, found), 50);
+  for (i = 0; i < 100; i++)
+  {
+    ASSERT_EQ(found[i], i % 2 == 0);
+    ASSERT_EQ(values[i], (i % 2 == 0) ? keys[i] * 7 : -1);
+  }
+  ASSERT_EQ(x_hashtable_get_many(ht, keys, 0, values, NULL), 0);
+
+  x_hashtable_cstr_i32_set(names, "one", 1);
+  x_hashtable_cstr_i32_set(names, "three", 3);
+  {
+    const char* lookup[3] = { "three", "two", "one" };
+    ASSERT_EQ(x_hashtable_cstr_i32_get_many(names, lookup, 3, values, found), 2);
+    ASSERT_TRUE(found[0] && !found[1] && found[2]);
+    ASSERT_EQ(values[0], 3);
+    ASSERT_EQ(values[2], 1);
+  }
+
+  x_hashtable_cstr_i32_destroy(names);
+  x_hashtable_destroy(ht);
+  return 0;
+}
+
+int test_hashtable_custom_allocator(void)
+{
+  XTestAllocStats st = {0, 0};
+  XAllocator a = x_test_allocator(&st);
+  char key[32];
+  int32_t v = 0;
+
+  // Owned C string keys must be cloned and released through the allocator too
+  XHashtable_cstr_i32* ht = x_hashtable_cstr_i32_create_with_allocator(&a);
+  ASSERT_TRUE(ht != NULL);
+  x_hashtable_set_resize_mode((XHashtable*)ht, XHASHTABLE_RESIZE_INCREMENTAL);
+
+  for (int32_t i = 0; i < 500; i++)
+  {
+    snprintf(key, sizeof(key), "key_%d", i);
+    ASSERT_TRUE(x_hashtable_cstr_i32_set(ht, key, i));
+  }
+  for (int32_t i = 0; i < 500; i += 3)
+  {
+    snprintf(key, sizeof(key), "key_%d", i);
+    ASSERT_TRUE(x_hashtable_cstr_i32_remove(ht, key));
+  }
+
+  ASSERT_TRUE(x_hashtable_cstr_i32_get(ht, "key_499", &v));
+  ASSERT_EQ(v, 499);
+  ASSERT_FALSE(x_hashtable_cstr_i32_has(ht, "key_3"));
+  ASSERT_TRUE(st.allocs > 500);
+
+  x_hashtable_cstr_i32_destroy(ht);
+  ASSERT_EQ(st.live, 0);
+  return 0;
+}
+
+int test_hashtable_create_full_with_allocator(void)
+{
+  XTestAllocStats st = {0, 0};
+  XAllocator a = x_test_allocator(&st);
+  float f = 0.0f;
+
+  XHashtable* ht = x_hashtable_create_full_with_allocator(
+      sizeof(double),
+      sizeof(float),
+      x_hashtable_hash_bytes,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      NULL,
+      &a);
+  ASSERT_TRUE(ht != NULL);
+  ASSERT_TRUE(st.allocs > 0);
+
+  for (int32_t i = 0; i < 200; i++)
+  {
+    double k = (double)i;
+    float v = (float)(i * 2);
+    ASSERT_TRUE(x_hashtable_set(ht, &k, &v));
+  }
+
+  ASSERT_TRUE(x_hashtable_get(ht, ref_d(150.0), &f));
+  ASSERT_TRUE(f == 300.0f);
+
+  x_hashtable_destroy(ht);
+  ASSERT_EQ(st.live, 0);
+  return 0;
+}
+
 int main()
 {
   STDXTestCase tests[] =
@@ -429,7 +850,19 @@ int main()
     X_TEST(test_x_hashtable_rehash_ints),
     X_TEST(test_typed_hashtable_int32_float),
     X_TEST(test_typed_hashtable_cstr_i32),
-    X_TEST(test_typed_hashtable_i32_struct)
+    X_TEST(test_typed_hashtable_i32_struct),
+    X_TEST(test_flat_hashtable_basic),
+    X_TEST(test_flat_hashtable_churn),
+    X_TEST(test_flat_hashtable_cstr_keys),
+    X_TEST(test_flat_hashtable_iter),
+    X_TEST(test_hashtable_hash_bytes),
+    X_TEST(test_hashtable_tombstone_reuse),
+    X_TEST(test_hashtable_incremental_resize),
+    X_TEST(test_hashtable_incremental_resize_owned_strings),
+    X_TEST(test_hashtable_reserve),
+    X_TEST(test_hashtable_get_many),
+    X_TEST(test_hashtable_custom_allocator),
+    X_TEST(test_hashtable_create_full_with_allocator)
   };
 
   return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
@@ -3,6 +3,8 @@
 #define X_IMPL_TEST
 #include <stdx_test.h>
 
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
 #define X_IMPL_HPOOL
 #include "stdx_hpool.h"
 
@@ -42,7 +44,7 @@ static void thp_dtor(void* user, void* item)
 static int test_x_hpool_init_and_term(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
 
   cfg.page_capacity = 8u;
   cfg.initial_pages = 1u;
@@ -59,7 +61,7 @@ static int test_x_hpool_init_and_term(void)
 static int test_x_hpool_alloc_get_free_basic(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
   XHandle h;
   THPItem* it;
 
@@ -92,7 +94,7 @@ static int test_x_hpool_alloc_get_free_basic(void)
 static int test_x_hpool_handle_stale_after_free(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
   XHandle h1;
   XHandle h2;
 
@@ -123,7 +125,7 @@ static int test_x_hpool_handle_stale_after_free(void)
 static int test_x_hpool_grows_by_pages(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
   XHandle h[10];
   uint32_t i;
 
@@ -154,7 +156,7 @@ static int test_x_hpool_grows_by_pages(void)
 static int test_x_hpool_iteration_foreach(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
   XHandle h;
   THPItem* it;
   uint32_t i;
@@ -200,7 +202,7 @@ static int test_x_hpool_iteration_foreach(void)
 static int test_x_hpool_free_compacts_alive_list(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
   XHandle h0;
   XHandle h1;
   XHandle h2;
@@ -250,7 +252,7 @@ static int test_x_hpool_free_compacts_alive_list(void)
 static int test_x_hpool_clear_empties_pool(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
   XHandle h[6];
   uint32_t i;
 
@@ -284,7 +286,7 @@ static int test_x_hpool_clear_empties_pool(void)
 static int test_x_hpool_get_unchecked_dead_returns_null(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
   XHandle h;
   uint32_t idx;
 
@@ -309,7 +311,7 @@ static int test_x_hpool_get_unchecked_dead_returns_null(void)
 static int test_x_hpool_get_fast_dead_returns_null(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
   XHandle h;
   void* ptr;
 
@@ -333,7 +335,7 @@ static int test_x_hpool_get_fast_dead_returns_null(void)
 static int test_x_hpool_is_alive_dead_is_false(void)
 {
   XHPool p;
-  XHPoolConfig cfg;
+  XHPoolConfig cfg = {0};
   XHandle h;
 
   cfg.page_capacity = 8u;
@@ -355,6 +357,392 @@ static int test_x_hpool_is_alive_dead_is_false(void)
 
 /* ------------------------------- test runner ------------------------------ */
 
+static int test_x_hpool_dense_layout_basic(void)
+{
+  XHPool p;
+  XHPoolConfig cfg = {0};
+  XHandle hs[20];
+  THPItem* it;
+  uint32_t i;
+
+  cfg.page_capacity = 8u;
+  cfg.initial_pages = 1u;
+  cfg.layout = XHPOOL_LAYOUT_DENSE;
+
+  ASSERT_TRUE(x_hpool_init(&p, sizeof(THPItem), cfg, thp_ctor, thp_dtor, NULL) != 0);
+  ASSERT_TRUE(x_hpool_dense_items(&p) == NULL);
+
+  for (i = 0u; i < 20u; i += 1u)
+  {
+    hs[i] = x_hpool_alloc(&p);
+    ASSERT_FALSE(x_handle_is_null(hs[i]) != 0);
+    it = (THPItem*)x_hpool_get(&p, hs[i]);
+    ASSERT_TRUE(it != NULL);
+    ASSERT_TRUE(it->magic == 0xC0FFEE01u);
+    it->value = i;
+  }
+  ASSERT_TRUE(x_hpool_capacity(&p) == 24u);
+
+  /* Items are packed in alive[] order */
+  THPItem* items = (THPItem*)x_hpool_dense_items(&p);
+  ASSERT_TRUE(items != NULL);
+  for (i = 0u; i < 20u; i += 1u)
+  {
+    ASSERT_TRUE(items[i].value == i);
+  }
+
+  /* Freeing swaps the last item into the hole; handles keep resolving to the right data */
+  x_hpool_free(&p, hs[3]);
+  x_hpool_free(&p, hs[0]);
+  ASSERT_TRUE(x_hpool_alive_count(&p) == 18u);
+  ASSERT_TRUE(x_hpool_get(&p, hs[3]) == NULL);
+  ASSERT_TRUE(x_hpool_is_alive(&p, hs[0]) == 0);
+
+  for (i = 0u; i < 20u; i += 1u)
+  {
+    if (i == 0u || i == 3u)
+    {
+      continue;
+    }
+    it = (THPItem*)x_hpool_get(&p, hs[i]);
+    ASSERT_TRUE(it != NULL);
+    ASSERT_TRUE(it->value == i);
+  }
+
+  /* A recycled slot gets a fresh version and a constructed item */
+  XHandle h = x_hpool_alloc(&p);
+  ASSERT_TRUE(h.index == hs[0].index);
+  ASSERT_TRUE(h.version != hs[0].version);
+  it = (THPItem*)x_hpool_get(&p, h);
+  ASSERT_TRUE(it->magic == 0xC0FFEE01u && it->value == 0u);
+
+  x_hpool_term(&p);
+  return 0;
+}
+
+static int test_x_hpool_dense_layout_iteration(void)
+{
+  XHPool p;
+  XHPoolConfig cfg = {0};
+  XHandle h;
+  uint32_t i;
+  uint32_t visited;
+  uint32_t sum;
+
+  cfg.page_capacity = 16u;
+  cfg.layout = XHPOOL_LAYOUT_DENSE;
+  ASSERT_TRUE(x_hpool_init(&p, sizeof(THPItem), cfg, NULL, NULL, NULL) != 0);
+
+  for (i = 0u; i < 100u; i += 1u)
+  {
+    h = x_hpool_alloc(&p);
+    ((THPItem*)x_hpool_get(&p, h))->value = i;
+    if (i % 3u == 0u)
+    {
+      x_hpool_free(&p, h);
+    }
+  }
+
+  /* Handles produced by the iterator are valid and point at the item they came with */
+  visited = 0u;
+  sum = 0u;
+  {
+    XHandle it_h;
+    THPItem* ptr = NULL;
+    X_HPOOL_FOREACH(&p, THPItem, it_it, it_h, ptr)
+    {
+      ASSERT_TRUE(x_hpool_get(&p, it_h) == (void*)ptr);
+      ASSERT_TRUE(ptr->value % 3u != 0u);
+      sum = sum + ptr->value;
+      visited = visited + 1u;
+    }
+  }
+  ASSERT_TRUE(visited == x_hpool_alive_count(&p));
+  ASSERT_TRUE(visited == 66u);
+  ASSERT_TRUE(sum == 4950u - 3u * (33u * 34u / 2u));
+
+  x_hpool_clear(&p);
+  ASSERT_TRUE(x_hpool_alive_count(&p) == 0u);
+  x_hpool_term(&p);
+  return 0;
+}
+
+static int test_x_hpool_range_chunks(void)
+{
+  XHPool p;
+  XHPoolConfig cfg = {0};
+  XHPoolRange r;
+  XHandle h;
+  uint32_t i;
+  uint32_t pos;
+  uint32_t covered;
+
+  cfg.page_capacity = 16u;
+  ASSERT_TRUE(x_hpool_init(&p, sizeof(THPItem), cfg, NULL, NULL, NULL) != 0);
+  ASSERT_TRUE(x_hpool_range_count(&p, 8u) == 0u);
+
+  for (i = 0u; i < 50u; i += 1u)
+  {
+    h = x_hpool_alloc(&p);
+    ((THPItem*)x_hpool_get(&p, h))->value = i;
+  }
+
+  /* 50 live objects in chunks of 8: six full ranges and a tail of 2 */
+  ASSERT_TRUE(x_hpool_range_count(&p, 8u) == 7u);
+  ASSERT_TRUE(x_hpool_range_count(&p, 0u) == 0u);
+
+  covered = 0u;
+  for (i = 0u; i < x_hpool_range_count(&p, 8u); i += 1u)
+  {
+    r = x_hpool_range(&p, 8u, i);
+    ASSERT_TRUE(r.begin == covered);
+    for (pos = r.begin; pos < r.end; pos += 1u)
+    {
+      THPItem* item = (THPItem*)x_hpool_item_at(&p, pos, &h);
+      ASSERT_TRUE(item != NULL);
+      ASSERT_TRUE(x_hpool_get(&p, h) == (void*)item);
+    }
+    covered = r.end;
+  }
+  ASSERT_TRUE(covered == 50u);
+
+  r = x_hpool_range(&p, 8u, 7u);
+  ASSERT_TRUE(r.begin == r.end);
+  ASSERT_TRUE(x_hpool_item_at(&p, 50u, NULL) == NULL);
+
+  x_hpool_term(&p);
+  return 0;
+}
+
+static void thp_parallel_visit(void* ctx, void* item, XHandle h)
+{
+  THPItem* it = (THPItem*)item;
+  (void)h;
+  it->value = it->value * 2u;
+  x_atomic_fetch_add_i32((volatile int32_t*)ctx, 1);
+}
+
+static int thp_check_parallel(XHPoolLayout layout, XThreadPool* pool)
+{
+  XHPool p;
+  XHPoolConfig cfg = {0};
+  XHandle h;
+  uint32_t i;
+  uint32_t sum;
+  volatile int32_t visited = 0;
+
+  cfg.page_capacity = 64u;
+  cfg.layout = layout;
+  ASSERT_TRUE(x_hpool_init(&p, sizeof(THPItem), cfg, NULL, NULL, NULL) != 0);
+
+  for (i = 0u; i < 5000u; i += 1u)
+  {
+    h = x_hpool_alloc(&p);
+    ((THPItem*)x_hpool_get(&p, h))->value = i;
+    if (i % 4u == 0u)
+    {
+      x_hpool_free(&p, h);
+    }
+  }
+
+  ASSERT_TRUE(x_hpool_for_each_parallel(&p, pool, thp_parallel_visit, (void*)&visited) != 0);
+  ASSERT_TRUE((uint32_t)visited == x_hpool_alive_count(&p));
+
+  /* Every live object was visited exactly once */
+  sum = 0u;
+  {
+    XHandle it_h;
+    THPItem* ptr = NULL;
+    X_HPOOL_FOREACH(&p, THPItem, it_it, it_h, ptr)
+    {
+      (void)it_h;
+      ASSERT_TRUE(ptr->value % 2u == 0u);
+      sum = sum + ptr->value / 2u;
+    }
+  }
+  ASSERT_TRUE(sum == 4999u * 5000u / 2u - 4u * (1249u * 1250u / 2u));
+
+  x_hpool_term(&p);
+  return 0;
+}
+
+static int test_x_hpool_for_each_parallel(void)
+{
+  XThreadPool* pool = x_threadpool_create(4);
+  ASSERT_TRUE(pool != NULL);
+
+  ASSERT_TRUE(thp_check_parallel(XHPOOL_LAYOUT_INTERLEAVED, pool) == 0);
+  ASSERT_TRUE(thp_check_parallel(XHPOOL_LAYOUT_DENSE, pool) == 0);
+  ASSERT_TRUE(thp_check_parallel(XHPOOL_LAYOUT_DENSE, NULL) == 0);
+
+  x_threadpool_destroy(pool);
+  return 0;
+}
+
+static int test_x_hpool_concurrent_basic(void)
+{
+  XHPool p;
+  XHPoolConfig cfg = {0};
+  XHandle hs[100];
+  uint32_t i;
+  uint32_t visited;
+
+  cfg.page_capacity = 16u;
+  cfg.concurrent = 1;
+  cfg.max_pages = 8u;
+
+  /* The dense layout moves items, which concurrent readers cannot tolerate */
+  cfg.layout = XHPOOL_LAYOUT_DENSE;
+  ASSERT_TRUE(x_hpool_init(&p, sizeof(THPItem), cfg, NULL, NULL, NULL) == 0);
+  cfg.layout = XHPOOL_LAYOUT_INTERLEAVED;
+  ASSERT_TRUE(x_hpool_init(&p, sizeof(THPItem), cfg, NULL, NULL, NULL) != 0);
+
+  for (i = 0u; i < 100u; i += 1u)
+  {
+    hs[i] = x_hpool_alloc(&p);
+    ASSERT_TRUE(x_handle_is_null(hs[i]) == 0);
+    ((THPItem*)x_hpool_get(&p, hs[i]))->value = i;
+  }
+  ASSERT_TRUE(x_hpool_alive_count(&p) == 100u);
+
+  for (i = 0u; i < 100u; i += 2u)
+  {
+    x_hpool_free(&p, hs[i]);
+  }
+  ASSERT_TRUE(x_hpool_alive_count(&p) == 50u);
+
+  /* Stale handles fail, and freeing one twice is a no-op */
+  ASSERT_TRUE(x_hpool_get(&p, hs[0]) == NULL);
+  ASSERT_TRUE(x_hpool_is_alive(&p, hs[0]) == 0);
+  x_hpool_free(&p, hs[0]);
+  ASSERT_TRUE(x_hpool_alive_count(&p) == 50u);
+
+  visited = 0u;
+  {
+    XHandle it_h;
+    THPItem* ptr = NULL;
+    X_HPOOL_FOREACH(&p, THPItem, it_it, it_h, ptr)
+    {
+      ASSERT_TRUE(x_hpool_get(&p, it_h) == (void*)ptr);
+      ASSERT_TRUE(ptr->value % 2u == 1u);
+      visited = visited + 1u;
+    }
+  }
+  ASSERT_TRUE(visited == 50u);
+
+  /* Freed slots come back with a new version */
+  {
+    XHandle h = x_hpool_alloc(&p);
+    ASSERT_TRUE(h.index < 100u);
+    ASSERT_TRUE(h.version != 0u);
+  }
+
+  /* The directory holds 8 pages of 16 slots */
+  for (i = 0u; i < 200u; i += 1u)
+  {
+    x_hpool_alloc(&p);
+  }
+  ASSERT_TRUE(x_hpool_alive_count(&p) == 128u);
+  ASSERT_TRUE(x_hpool_capacity(&p) == 128u);
+
+  x_hpool_clear(&p);
+  ASSERT_TRUE(x_hpool_alive_count(&p) == 0u);
+  x_hpool_term(&p);
+  return 0;
+}
+
+#define THP_THREADS 4
+#define THP_ROUNDS 2000
+#define THP_LIVE 64
+
+typedef struct THPWorker
+{
+  XHPool* pool;
+  uint32_t id;
+  int ok;
+} THPWorker;
+
+/* Each thread owns the objects it allocates; a slot handed to two threads at once would be overwritten */
+static void* thp_churn(void* arg)
+{
+  THPWorker* w = (THPWorker*)arg;
+  XHandle hs[THP_LIVE];
+  uint32_t round;
+  uint32_t i;
+
+  for (round = 0u; round < THP_ROUNDS; round += 1u)
+  {
+    uint32_t n = 1u + (round * 7u + w->id) % THP_LIVE;
+
+    for (i = 0u; i < n; i += 1u)
+    {
+      THPItem* item;
+      hs[i] = x_hpool_alloc(w->pool);
+      item = (THPItem*)x_hpool_get(w->pool, hs[i]);
+      if (item == NULL)
+      {
+        w->ok = 0;
+        return NULL;
+      }
+      item->magic = w->id;
+      item->value = round * THP_LIVE + i;
+    }
+
+    for (i = 0u; i < n; i += 1u)
+    {
+      THPItem* item = (THPItem*)x_hpool_get(w->pool, hs[i]);
+      if (item == NULL || item->magic != w->id || item->value != round * THP_LIVE + i)
+      {
+        w->ok = 0;
+      }
+      x_hpool_free(w->pool, hs[i]);
+      if (x_hpool_get(w->pool, hs[i]) != NULL)
+      {
+        w->ok = 0;
+      }
+    }
+  }
+
+  x_hpool_thread_detach();
+  return NULL;
+}
+
+static int test_x_hpool_concurrent_threads(void)
+{
+  XHPool p;
+  XHPoolConfig cfg = {0};
+  THPWorker workers[THP_THREADS];
+  XThread* threads[THP_THREADS];
+  uint32_t i;
+
+  cfg.page_capacity = 64u;
+  cfg.concurrent = 1;
+  ASSERT_TRUE(x_hpool_init(&p, sizeof(THPItem), cfg, NULL, NULL, NULL) != 0);
+
+  for (i = 0u; i < THP_THREADS; i += 1u)
+  {
+    workers[i].pool = &p;
+    workers[i].id = i + 1u;
+    workers[i].ok = 1;
+    ASSERT_TRUE(x_thread_create(&threads[i], thp_churn, &workers[i]) == 0);
+  }
+
+  for (i = 0u; i < THP_THREADS; i += 1u)
+  {
+    x_thread_join(threads[i]);
+    x_thread_destroy(threads[i]);
+    ASSERT_TRUE(workers[i].ok != 0);
+  }
+
+  ASSERT_TRUE(x_hpool_alive_count(&p) == 0u);
+
+  /* Slots are recycled: the pool never needs more than every thread's peak */
+  ASSERT_TRUE(x_hpool_capacity(&p) <= 64u * 16u);
+
+  x_hpool_term(&p);
+  return 0;
+}
+
 int main(void)
 {
   STDXTestCase cases[] =
@@ -368,7 +756,13 @@ int main(void)
     X_TEST(test_x_hpool_clear_empties_pool),
     X_TEST(test_x_hpool_get_unchecked_dead_returns_null),
     X_TEST(test_x_hpool_get_fast_dead_returns_null),
-    X_TEST(test_x_hpool_is_alive_dead_is_false)
+    X_TEST(test_x_hpool_is_alive_dead_is_false),
+    X_TEST(test_x_hpool_dense_layout_basic),
+    X_TEST(test_x_hpool_dense_layout_iteration),
+    X_TEST(test_x_hpool_range_chunks),
+    X_TEST(test_x_hpool_for_each_parallel),
+    X_TEST(test_x_hpool_concurrent_basic),
+    X_TEST(test_x_hpool_concurrent_threads)
   };
 
   return x_tests_run(cases, (uint32_t)(sizeof(cases) / sizeof(cases[0])), NULL);
@@ -242,6 +242,112 @@ int test_ini_numeric_parsing()
   return 0;
 }
 
+int test_ini_index_many_sections()
+{
+  /* Big enough that the pool grows to fit the index and strings are rebased */
+  size_t cap = 300 * 96;
+  char *txt = (char *)malloc(cap);
+  size_t len = 0;
+  for (int i = 0; i < 300; i++)
+  {
+    len += (size_t)snprintf(txt + len, cap - len, "[s%d]\nport = %d\nname = host%d\nport = %d\n", i, i, i, i + 1000);
+  }
+
+  XIni ini;
+  XIniError iniError;
+  ASSERT_TRUE(x_ini_load_mem(txt, len, &ini, &iniError));
+  free(txt);
+
+  for (int i = 0; i < 300; i++)
+  {
+    char section[16], name[16];
+    snprintf(section, sizeof(section), "s%d", i);
+    snprintf(name, sizeof(name), "host%d", i);
+    ASSERT_TRUE(x_ini_get_i32(&ini, section, "port", -1) == i + 1000);
+    ASSERT_TRUE(s_eq(x_ini_get(&ini, section, "name", NULL), name));
+    ASSERT_TRUE(x_ini_get(&ini, section, "missing", NULL) == NULL);
+  }
+  ASSERT_TRUE(x_ini_get(&ini, "s300", "port", NULL) == NULL);
+  ASSERT_TRUE(s_eq(x_ini_section_name(&ini, 300), "s299"));
+
+  x_ini_free(&ini);
+  return 0;
+}
+
+int test_ini_index_repeated_section()
+{
+  /* A repeated section name opens a new section; lookups search the first one */
+  const char *txt =
+    "[a]\n"
+    "x = 1\n"
+    "[b]\n"
+    "x = 2\n"
+    "[a]\n"
+    "x = 3\n"
+    "y = 4\n";
+
+  XIni ini;
+  XIniError iniError;
+  ASSERT_TRUE(x_ini_load_mem(txt, strlen(txt), &ini, &iniError));
+  ASSERT_TRUE(x_ini_section_count(&ini) == 4);
+  ASSERT_TRUE(x_ini_get_i32(&ini, "a", "x", 0) == 1);
+  ASSERT_TRUE(x_ini_get_i32(&ini, "b", "x", 0) == 2);
+  ASSERT_TRUE(x_ini_get(&ini, "a", "y", NULL) == NULL);
+  ASSERT_TRUE(s_eq(x_ini_value_at(&ini, 3, 1), "4"));
+
+  x_ini_free(&ini);
+  return 0;
+}
+
+typedef struct
+{
+  const char *name;
+  int32_t     port;
+  float       ratio;
+  bool        verbose;
+  int32_t     threads;
+  const char *motd;
+} IniBindTarget;
+
+int test_ini_bind()
+{
+  const char *txt =
+    "name = stdx\n"
+    "[server]\n"
+    "port = 8080\n"
+    "ratio = 0.25\n"
+    "verbose = yes\n"
+    "threads = many\n";
+
+  static const XIniField fields[] =
+  {
+    X_INI_FIELD(NULL,     "name",    XINI_FIELD_STR,  IniBindTarget, name),
+    X_INI_FIELD("server", "port",    XINI_FIELD_I32,  IniBindTarget, port),
+    X_INI_FIELD("server", "ratio",   XINI_FIELD_F32,  IniBindTarget, ratio),
+    X_INI_FIELD("server", "verbose", XINI_FIELD_BOOL, IniBindTarget, verbose),
+    X_INI_FIELD("server", "threads", XINI_FIELD_I32,  IniBindTarget, threads),
+    X_INI_FIELD("server", "motd",    XINI_FIELD_STR,  IniBindTarget, motd),
+    X_INI_FIELD("nope",   "port",    XINI_FIELD_I32,  IniBindTarget, port),
+  };
+
+  XIni ini;
+  XIniError iniError;
+  ASSERT_TRUE(x_ini_load_mem(txt, strlen(txt), &ini, &iniError));
+
+  /* Missing or unparsable fields keep their defaults */
+  IniBindTarget cfg = { "default", 80, 1.0f, false, 4, "hello" };
+  ASSERT_TRUE(x_ini_bind(&ini, fields, (int)(sizeof(fields) / sizeof(fields[0])), &cfg) == 4);
+  ASSERT_TRUE(s_eq(cfg.name, "stdx"));
+  ASSERT_TRUE(cfg.port == 8080);
+  ASSERT_TRUE(cfg.ratio == 0.25f);
+  ASSERT_TRUE(cfg.verbose == true);
+  ASSERT_TRUE(cfg.threads == 4);
+  ASSERT_TRUE(s_eq(cfg.motd, "hello"));
+
+  x_ini_free(&ini);
+  return 0;
+}
+
 int main(void)
 {
   STDXTestCase tests[] =
@@ -256,6 +362,9 @@ int main(void)
     X_TEST(test_ini_malformed_2),
     X_TEST(test_ini_malformed_3),
     X_TEST(test_ini_numeric_parsing),
+    X_TEST(test_ini_index_many_sections),
+    X_TEST(test_ini_index_repeated_section),
+    X_TEST(test_ini_bind),
   };
 
   return x_tests_run(tests, (int)(sizeof(tests) / sizeof(tests[0])), NULL);
@@ -0,0 +1,215 @@
+#define X_IMPL_TEST
+#include <stdx_test.h>
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_IMPL_STRING
+#include <stdx_string.h>
+#define X_IMPL_ARENA
+#include <stdx_arena.h>
+#define X_IMPL_HASHTABLE
+#include <stdx_hashtable.h>
+#define X_IMPL_INTERN
+#include <stdx_intern.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+int test_intern_basic(void)
+{
+  XIntern* pool = x_intern_create();
+  ASSERT_TRUE(pool != NULL);
+  ASSERT_EQ(x_intern_count(pool), 0);
+
+  XAtom foo = x_intern_cstr(pool, "foo");
+  XAtom bar = x_intern_cstr(pool, "bar");
+  ASSERT_EQ(foo, 1);
+  ASSERT_EQ(bar, 2);
+  ASSERT_TRUE(x_atom_eq(x_intern_cstr(pool, "foo"), foo));
+  ASSERT_FALSE(x_atom_eq(foo, bar));
+  ASSERT_EQ(x_intern_count(pool), 2);
+
+  // Slices need not be null-terminated
+  const char* text = "foobarbaz";
+  ASSERT_EQ(x_intern(pool, x_slice_init(text, 3)), foo);
+  ASSERT_EQ(x_intern(pool, x_slice_init(text + 3, 3)), bar);
+  XAtom baz = x_intern(pool, x_slice_init(text + 6, 3));
+  ASSERT_EQ(baz, 3);
+
+  ASSERT_TRUE(strcmp(x_atom_cstr(pool, foo), "foo") == 0);
+  ASSERT_EQ(x_atom_length(pool, bar), 3);
+  ASSERT_TRUE(x_slice_eq(x_atom_slice(pool, baz), x_slice("baz")));
+  ASSERT_TRUE(x_atom_cstr(pool, baz) != text + 6);
+  ASSERT_EQ(x_atom_hash(pool, foo), x_atom_hash(pool, x_intern_cstr(pool, "foo")));
+
+  // Lookup never adds
+  ASSERT_EQ(x_intern_find(pool, x_slice("bar")), bar);
+  ASSERT_EQ(x_intern_find(pool, x_slice("qux")), X_ATOM_NONE);
+  ASSERT_EQ(x_intern_count(pool), 3);
+
+  // Invalid atoms resolve to nothing
+  ASSERT_TRUE(x_atom_cstr(pool, X_ATOM_NONE) == NULL);
+  ASSERT_TRUE(x_atom_cstr(pool, 4) == NULL);
+  ASSERT_EQ(x_atom_length(pool, 99), 0);
+  ASSERT_EQ(x_atom_slice(pool, 99).length, 0);
+
+  x_intern_destroy(pool);
+  return 0;
+}
+
+int test_intern_edge_cases(void)
+{
+  XIntern* pool = x_intern_create();
+
+  // The empty string is a string like any other
+  XAtom empty = x_intern_cstr(pool, "");
+  ASSERT_TRUE(empty != X_ATOM_NONE);
+  ASSERT_EQ(x_intern(pool, x_slice_init(NULL, 0)), empty);
+  ASSERT_EQ(x_atom_length(pool, empty), 0);
+  ASSERT_TRUE(strcmp(x_atom_cstr(pool, empty), "") == 0);
+
+  // Embedded nul bytes and prefixes are distinct strings
+  XAtom with_nul = x_intern(pool, x_slice_init("a\0b", 3));
+  XAtom a = x_intern_cstr(pool, "a");
+  ASSERT_TRUE(with_nul != a);
+  ASSERT_EQ(x_atom_length(pool, with_nul), 3);
+  ASSERT_EQ(x_intern(pool, x_slice_init("a\0b", 3)), with_nul);
+  ASSERT_TRUE(x_intern_cstr(pool, "ab") != a);
+
+  ASSERT_EQ(x_intern_cstr(pool, NULL), X_ATOM_NONE);
+  ASSERT_EQ(x_intern(NULL, x_slice("a")), X_ATOM_NONE);
+  ASSERT_EQ(x_intern_count(NULL), 0);
+  x_intern_destroy(NULL);
+
+  x_intern_destroy(pool);
+  return 0;
+}
+
+int test_intern_growth(void)
+{
+  // Crosses several table resizes and atom pages
+  XIntern* pool = x_intern_create_ex(X_INTERN_DEFAULT, 8);
+  enum { N = 20000 };
+  char buf[32];
+  for (int32_t i = 0; i < N; ++i)
+  {
+    int len = snprintf(buf, sizeof(buf), "name_%d", i);
+    ASSERT_EQ(x_intern(pool, x_slice_init(buf, (size_t)len)), (XAtom)(i + 1));
+  }
+  ASSERT_EQ(x_intern_count(pool), N);
+
+  for (int32_t i = 0; i < N; ++i)
+  {
+    int len = snprintf(buf, sizeof(buf), "name_%d", i);
+    XAtom atom = x_intern_find(pool, x_slice_init(buf, (size_t)len));
+    ASSERT_EQ(atom, (XAtom)(i + 1));
+    ASSERT_TRUE(strcmp(x_atom_cstr(pool, atom), buf) == 0);
+  }
+  ASSERT_EQ(x_intern_count(pool), N);
+
+  x_intern_destroy(pool);
+  return 0;
+}
+
+X_HASHTABLE_TYPE_NAMED(XAtom, int32_t, atom_i32)
+
+int test_intern_atom_keys(void)
+{
+  XIntern* pool = x_intern_create();
+  XHashtable_atom_i32* ht = x_hashtable_atom_i32_create();
+
+  const char* words[] = { "alpha", "beta", "gamma", "beta", "alpha", "alpha" };
+  for (size_t i = 0; i < sizeof(words) / sizeof(words[0]); ++i)
+  {
+    XAtom key = x_intern_cstr(pool, words[i]);
+    int32_t v = 0;
+    x_hashtable_atom_i32_get(ht, key, &v);
+    x_hashtable_atom_i32_set(ht, key, v + 1);
+  }
+
+  int32_t v = 0;
+  ASSERT_TRUE(x_hashtable_atom_i32_get(ht, x_intern_cstr(pool, "alpha"), &v));
+  ASSERT_EQ(v, 3);
+  ASSERT_TRUE(x_hashtable_atom_i32_get(ht, x_intern_cstr(pool, "beta"), &v));
+  ASSERT_EQ(v, 2);
+  ASSERT_TRUE(x_hashtable_atom_i32_get(ht, x_intern_cstr(pool, "gamma"), &v));
+  ASSERT_EQ(v, 1);
+
+  x_hashtable_atom_i32_destroy(ht);
+  x_intern_destroy(pool);
+  return 0;
+}
+
+#define INTERN_THREADS 4
+#define INTERN_WORDS 5000
+
+typedef struct
+{
+  XIntern* pool;
+  int32_t offset;
+  XAtom atoms[INTERN_WORDS];
+} InternWorker;
+
+// Every worker interns the same words, starting at a different point
+static void* intern_worker(void* arg)
+{
+  InternWorker* w = (InternWorker*)arg;
+  char buf[32];
+  for (int32_t n = 0; n < INTERN_WORDS; ++n)
+  {
+    int32_t i = (n + w->offset) % INTERN_WORDS;
+    int len = snprintf(buf, sizeof(buf), "word_%d", i);
+    w->atoms[i] = x_intern(w->pool, x_slice_init(buf, (size_t)len));
+  }
+  return NULL;
+}
+
+int test_intern_concurrent(void)
+{
+  XIntern* pool = x_intern_create_ex(X_INTERN_CONCURRENT, 0);
+  ASSERT_TRUE(pool != NULL);
+
+  static InternWorker workers[INTERN_THREADS];
+  XThread* threads[INTERN_THREADS];
+  for (int32_t i = 0; i < INTERN_THREADS; ++i)
+  {
+    workers[i].pool = pool;
+    workers[i].offset = i * (INTERN_WORDS / INTERN_THREADS);
+    ASSERT_EQ(x_thread_create(&threads[i], intern_worker, &workers[i]), 0);
+  }
+  for (int32_t i = 0; i < INTERN_THREADS; ++i)
+  {
+    x_thread_join(threads[i]);
+    x_thread_destroy(threads[i]);
+  }
+
+  // All threads agree on every atom, and each word was added once
+  ASSERT_EQ(x_intern_count(pool), INTERN_WORDS);
+  char buf[32];
+  for (int32_t i = 0; i < INTERN_WORDS; ++i)
+  {
+    XAtom atom = workers[0].atoms[i];
+    ASSERT_TRUE(atom != X_ATOM_NONE);
+    for (int32_t t = 1; t < INTERN_THREADS; ++t)
+      ASSERT_EQ(workers[t].atoms[i], atom);
+    snprintf(buf, sizeof(buf), "word_%d", i);
+    ASSERT_TRUE(strcmp(x_atom_cstr(pool, atom), buf) == 0);
+  }
+
+  x_intern_destroy(pool);
+  return 0;
+}
+
+int main()
+{
+  STDXTestCase tests[] =
+  {
+    X_TEST(test_intern_basic),
+    X_TEST(test_intern_edge_cases),
+    X_TEST(test_intern_growth),
+    X_TEST(test_intern_atom_keys),
+    X_TEST(test_intern_concurrent),
+  };
+
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
+}
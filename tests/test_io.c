@@ -96,6 +96,115 @@ int test_allocator_usage()
   return 0;
 }
 
+int test_writev()
+{
+  XFile *f = x_io_open(TEMP_FILE, "wb");
+  ASSERT_TRUE(f);
+
+  // Buffered bytes written before the gather must stay ahead of it
+  ASSERT_TRUE(x_io_write(f, "<", 1) == 1);
+
+  XSlice parts[100];
+  for (int i = 0; i < 100; i++)
+  {
+    parts[i] = (i % 3 == 0) ? x_slice_init("", 0) : x_slice_init("ab", 2);
+  }
+  size_t written = x_io_writev(f, parts, 100);
+  ASSERT_TRUE(written == 66 * 2);
+  ASSERT_TRUE(x_io_write(f, ">", 1) == 1);
+  x_io_close(f);
+
+  size_t len = 0;
+  char *text = x_io_read_text(TEMP_FILE, &len);
+  ASSERT_TRUE(text);
+  ASSERT_TRUE(len == 134);
+  ASSERT_TRUE(text[0] == '<' && text[1] == 'a' && text[132] == 'b' && text[133] == '>');
+  free(text);
+  return 0;
+}
+
+int test_map()
+{
+  XFileMapping mapping;
+  ASSERT_TRUE(x_io_write_text(TEMP_FILE, STR1 STR2));
+  ASSERT_TRUE(x_io_map(TEMP_FILE, X_IO_MAP_SEQUENTIAL | X_IO_MAP_WILLNEED, &mapping));
+  ASSERT_TRUE(mapping.data != NULL);
+  ASSERT_TRUE(mapping.size == strlen(STR1 STR2));
+  ASSERT_TRUE(memcmp(mapping.data, STR1 STR2, mapping.size) == 0);
+  x_io_unmap(&mapping);
+  ASSERT_TRUE(mapping.data == NULL);
+
+  // Empty files succeed with no data; missing files fail
+  ASSERT_TRUE(x_io_write_text(TEMP_FILE, ""));
+  ASSERT_TRUE(x_io_map(TEMP_FILE, X_IO_MAP_DEFAULT, &mapping));
+  ASSERT_TRUE(mapping.data == NULL && mapping.size == 0);
+  x_io_unmap(&mapping);
+  ASSERT_FALSE(x_io_map("this_file_does_not_exist.txt", X_IO_MAP_RANDOM, &mapping));
+  return 0;
+}
+
+int test_reader_writer()
+{
+  XFile *f = x_io_open(TEMP_FILE, "wb");
+  ASSERT_TRUE(f);
+
+  // A tiny buffer forces compaction, growth and the large-write bypass
+  XWriter *w = x_writer_create(f, 16);
+  ASSERT_TRUE(w);
+  char line[64];
+  for (int i = 0; i < 100; i++)
+  {
+    int n = snprintf(line, sizeof(line), "line %d%s", i, (i % 2) ? "\r\n" : "\n");
+    ASSERT_TRUE(x_writer_write(w, line, (size_t)n));
+  }
+  ASSERT_TRUE(x_writer_write_slice(w, x_slice_init("a very long line without an end that overflows the buffer", 57)));
+  ASSERT_TRUE(x_writer_destroy(w));
+  x_io_close(f);
+
+  f = x_io_open(TEMP_FILE, "rb");
+  ASSERT_TRUE(f);
+  XReader *r = x_reader_create(f, 16);
+  ASSERT_TRUE(r);
+
+  XSlice s;
+  ASSERT_TRUE(x_reader_peek(r, 4, &s) == 4);
+  ASSERT_TRUE(memcmp(s.ptr, "line", 4) == 0);
+
+  int count = 0;
+  while (count < 100 && x_reader_next_line(r, &s))
+  {
+    int n = snprintf(line, sizeof(line), "line %d", count);
+    ASSERT_TRUE(s.length == (size_t)n);
+    ASSERT_TRUE(memcmp(s.ptr, line, s.length) == 0);
+    count++;
+  }
+  ASSERT_TRUE(count == 100);
+
+  // The last record has no delimiter and is longer than the buffer
+  ASSERT_TRUE(x_reader_next_record(r, 'w', &s));
+  ASSERT_TRUE(s.length == 17);
+  ASSERT_TRUE(x_reader_next_line(r, &s));
+  ASSERT_TRUE(s.length == 39);
+  ASSERT_TRUE(memcmp(s.ptr + s.length - 6, "buffer", 6) == 0);
+  ASSERT_FALSE(x_reader_next_line(r, &s));
+  ASSERT_TRUE(x_reader_eof(r));
+  ASSERT_FALSE(x_reader_error(r));
+  x_reader_destroy(r);
+
+  // Bulk reads mix buffered bytes with direct reads
+  x_io_seek(f, 0, SEEK_SET);
+  r = x_reader_create(f, 16);
+  ASSERT_TRUE(r);
+  ASSERT_TRUE(x_reader_peek(r, 2, NULL) == 2);
+  x_reader_consume(r, 5);
+  char big[64];
+  ASSERT_TRUE(x_reader_read(r, big, sizeof(big)) == sizeof(big));
+  ASSERT_TRUE(big[0] == '0' && big[1] == '\n' && big[2] == 'l');
+  x_reader_destroy(r);
+  x_io_close(f);
+  return 0;
+}
+
 int main()
 {
   STDXTestCase tests[] =
@@ -105,7 +214,10 @@ int main()
     X_TEST(test_read_all),
     X_TEST(test_seek_tell),
     X_TEST(test_eof_error),
-    X_TEST(test_allocator_usage)
+    X_TEST(test_allocator_usage),
+    X_TEST(test_writev),
+    X_TEST(test_map),
+    X_TEST(test_reader_writer)
   };
 
   return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
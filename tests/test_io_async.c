@@ -0,0 +1,255 @@
+#define X_IMPL_TEST
+#include <stdx_test.h>
+#define X_IMPL_IO
+#include <stdx_io.h>
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_IMPL_IO_ASYNC
+#include <stdx_io_async.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEMP_FILE "test_tmp_io_async_file.bin"
+#define FILE_SIZE (256 * 1024)
+#define CHUNK 4096
+#define CHUNKS (FILE_SIZE / CHUNK)
+
+typedef struct
+{
+  uint64_t offset;
+  int64_t result;
+  int32_t calls;
+} ReadJob;
+
+typedef struct
+{
+  XIOAsync* io;
+  XFile* file;
+  uint8_t* buf;
+  int32_t remaining;
+  int64_t total;
+} ChainJob;
+
+static uint8_t s_pattern(uint64_t i)
+{
+  return (uint8_t)((i * 31u) ^ (i >> 8));
+}
+
+static bool s_write_pattern(void)
+{
+  uint8_t* data = (uint8_t*)malloc(FILE_SIZE);
+  if (!data) return false;
+  for (uint64_t i = 0; i < FILE_SIZE; i++)
+    data[i] = s_pattern(i);
+  XFile* f = x_io_open(TEMP_FILE, "wb");
+  bool ok = f && x_io_write(f, data, FILE_SIZE) == FILE_SIZE;
+  x_io_close(f);
+  free(data);
+  return ok;
+}
+
+static void on_read(void* user, void* buffer, int64_t result)
+{
+  (void)buffer;
+  ReadJob* job = (ReadJob*)user;
+  job->result = result;
+  job->calls++;
+}
+
+static void on_chain(void* user, void* buffer, int64_t result)
+{
+  (void)buffer;
+  ChainJob* job = (ChainJob*)user;
+  job->total += result;
+  // The slot was released before the callback, so a depth-1 context can queue again
+  if (--job->remaining > 0)
+    x_io_async_read(job->io, job->file, (uint64_t)job->total, job->buf, CHUNK, on_chain, job);
+}
+
+static int s_scatter_reads(XIOAsyncBackend backend)
+{
+  ASSERT_TRUE(s_write_pattern());
+  XIOAsync* io = x_io_async_create_ex(CHUNKS, backend, NULL);
+  ASSERT_TRUE(io != NULL);
+  ASSERT_TRUE(x_io_async_backend(io) != X_IO_ASYNC_AUTO);
+
+  XFile* f = x_io_open(TEMP_FILE, "rb");
+  ASSERT_TRUE(f);
+  uint8_t* buf = (uint8_t*)malloc(FILE_SIZE);
+  ReadJob jobs[CHUNKS];
+
+  // Queue the chunks back to front so nothing depends on the file position
+  for (int32_t i = 0; i < CHUNKS; i++)
+  {
+    int32_t c = CHUNKS - 1 - i;
+    jobs[c].offset = (uint64_t)c * CHUNK;
+    jobs[c].result = -1;
+    jobs[c].calls = 0;
+    ASSERT_TRUE(x_io_async_read(io, f, jobs[c].offset, buf + jobs[c].offset, CHUNK, on_read, &jobs[c]));
+  }
+
+  // Context is full; queued reads never complete before submit
+  ReadJob extra;
+  ASSERT_FALSE(x_io_async_read(io, f, 0, buf, CHUNK, on_read, &extra));
+  ASSERT_EQ(x_io_async_poll(io, CHUNKS), 0);
+  ASSERT_EQ(x_io_async_pending(io), CHUNKS);
+
+  ASSERT_EQ(x_io_async_submit(io), CHUNKS);
+  uint32_t done = 0;
+  while (x_io_async_pending(io) > 0)
+    done += x_io_async_poll(io, 1);
+  ASSERT_EQ(done, CHUNKS);
+
+  for (int32_t c = 0; c < CHUNKS; c++)
+  {
+    ASSERT_EQ(jobs[c].calls, 1);
+    ASSERT_EQ(jobs[c].result, CHUNK);
+  }
+  for (uint64_t i = 0; i < FILE_SIZE; i++)
+  {
+    if (buf[i] != s_pattern(i))
+    {
+      ASSERT_EQ(buf[i], s_pattern(i));
+    }
+  }
+
+  // Short read at the end of the file, nothing past it
+  ReadJob tail = {0, -1, 0};
+  ReadJob past = {0, -1, 0};
+  ASSERT_TRUE(x_io_async_read(io, f, FILE_SIZE - 100, buf, CHUNK, on_read, &tail));
+  ASSERT_TRUE(x_io_async_read(io, f, FILE_SIZE + 100, buf + CHUNK, CHUNK, on_read, &past));
+  ASSERT_EQ(x_io_async_submit(io), 2);
+  ASSERT_EQ(x_io_async_poll(io, 2), 2);
+  ASSERT_EQ(tail.result, 100);
+  ASSERT_EQ(past.result, 0);
+
+  x_io_async_destroy(io);
+  x_io_close(f);
+  free(buf);
+  return 0;
+}
+
+static int s_chained_reads(XIOAsyncBackend backend)
+{
+  ASSERT_TRUE(s_write_pattern());
+  XIOAsync* io = x_io_async_create_ex(1, backend, NULL);
+  ASSERT_TRUE(io != NULL);
+
+  uint8_t buf[CHUNK];
+  ChainJob job;
+  job.io = io;
+  job.file = x_io_open(TEMP_FILE, "rb");
+  job.buf = buf;
+  job.remaining = 8;
+  job.total = 0;
+  ASSERT_TRUE(job.file);
+
+  ASSERT_TRUE(x_io_async_read(io, job.file, 0, buf, CHUNK, on_chain, &job));
+  while (x_io_async_pending(io) > 0)
+  {
+    x_io_async_submit(io);
+    x_io_async_poll(io, 1);
+  }
+  ASSERT_EQ(job.remaining, 0);
+  ASSERT_EQ(job.total, 8 * CHUNK);
+
+  // Destroy runs callbacks of reads that are still outstanding
+  ReadJob last = {0, -1, 0};
+  ASSERT_TRUE(x_io_async_read(io, job.file, 0, buf, 16, on_read, &last));
+  x_io_async_destroy(io);
+  ASSERT_EQ(last.calls, 1);
+  ASSERT_EQ(last.result, 16);
+
+  x_io_close(job.file);
+  return 0;
+}
+
+int test_io_async_native(void)
+{
+  return s_scatter_reads(X_IO_ASYNC_AUTO);
+}
+
+int test_io_async_threadpool(void)
+{
+  return s_scatter_reads(X_IO_ASYNC_THREADPOOL);
+}
+
+int test_io_async_chained(void)
+{
+  int r = s_chained_reads(X_IO_ASYNC_AUTO);
+  if (r != 0) return r;
+  return s_chained_reads(X_IO_ASYNC_THREADPOOL);
+}
+
+int test_io_async_errors(void)
+{
+  XIOAsync* io = x_io_async_create(4);
+  ASSERT_TRUE(io != NULL);
+
+  // Reading from a write-only file fails with a negative code
+  XFile* f = x_io_open(TEMP_FILE, "wb");
+  ASSERT_TRUE(f);
+  uint8_t buf[16];
+  ReadJob job = {0, 0, 0};
+  ASSERT_TRUE(x_io_async_read(io, f, 0, buf, sizeof(buf), on_read, &job));
+  ASSERT_FALSE(x_io_async_read(io, NULL, 0, buf, sizeof(buf), on_read, &job));
+  x_io_async_submit(io);
+  ASSERT_EQ(x_io_async_poll(io, 1), 1);
+  ASSERT_TRUE(job.result < 0);
+  x_io_close(f);
+
+  x_io_async_destroy(io);
+  remove(TEMP_FILE);
+  return 0;
+}
+
+// A ring that refuses submissions keeps the reads queued, and destroy
+// cancels them instead of waiting for completions that never come
+int test_io_async_submit_failure(void)
+{
+#if defined(X_IO_ASYNC_HAS_URING)
+  XIOAsync* io = x_io_async_create_ex(4, X_IO_ASYNC_URING, NULL);
+  if (!io) return 0;   // io_uring unavailable here
+
+  ASSERT_TRUE(s_write_pattern());
+  XFile* f = x_io_open(TEMP_FILE, "rb");
+  ASSERT_TRUE(f);
+  uint8_t buf[2][CHUNK];
+  ReadJob jobs[2] = { {0, 0, 0}, {CHUNK, 0, 0} };
+  for (int i = 0; i < 2; i++)
+    ASSERT_TRUE(x_io_async_read(io, f, jobs[i].offset, buf[i], CHUNK, on_read, &jobs[i]));
+
+  int ring_fd = io->ring_fd;
+  io->ring_fd = -1;   // io_uring_enter now fails with EBADF
+  ASSERT_EQ(x_io_async_submit(io), 0);
+  ASSERT_EQ(x_io_async_pending(io), 2);
+  ASSERT_EQ(x_io_async_poll(io, 2), 0);
+
+  x_io_async_destroy(io);
+  close(ring_fd);
+  for (int i = 0; i < 2; i++)
+  {
+    ASSERT_EQ(jobs[i].calls, 1);
+    ASSERT_EQ(jobs[i].result, -ECANCELED);
+  }
+  x_io_close(f);
+  remove(TEMP_FILE);
+#endif
+  return 0;
+}
+
+int main()
+{
+  STDXTestCase tests[] =
+  {
+    X_TEST(test_io_async_native),
+    X_TEST(test_io_async_threadpool),
+    X_TEST(test_io_async_chained),
+    X_TEST(test_io_async_errors),
+    X_TEST(test_io_async_submit_failure),
+  };
+
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
+}
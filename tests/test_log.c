@@ -0,0 +1,328 @@
+// The async logger includes stdx_thread.h itself, so its implementation is requested first
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_LOG_ASYNC
+#define X_IMPL_TEST
+#include <stdx_test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEMP_LOG "test_tmp_log.txt"
+#define PRODUCERS 4
+#define MESSAGES 5000
+
+typedef struct
+{
+  XLogger* logger;
+  int32_t id;
+} Producer;
+
+static void* s_produce(void* arg)
+{
+  Producer* p = (Producer*)arg;
+  for (int32_t i = 0; i < MESSAGES; i++)
+    x_log_print(p->logger, XLOG_LEVEL_INFO, "%d %d\n", p->id, i);
+  return NULL;
+}
+
+// Counts the lines of the log and checks each producer's lines come in order
+static int32_t s_check_log(int32_t* bad)
+{
+  int32_t next[PRODUCERS] = {0};
+  int32_t lines = 0;
+  int32_t id, seq;
+  FILE* f = fopen(TEMP_LOG, "r");
+  *bad = 0;
+  if (!f) return -1;
+  while (fscanf(f, "%d %d\n", &id, &seq) == 2)
+  {
+    if (id < 0 || id >= PRODUCERS || seq < next[id]) (*bad)++;
+    else next[id] = seq + 1;
+    lines++;
+  }
+  fclose(f);
+  return lines;
+}
+
+static int32_t s_run_producers(XLogger* logger)
+{
+  XThread* threads[PRODUCERS];
+  Producer producers[PRODUCERS];
+  for (int32_t i = 0; i < PRODUCERS; i++)
+  {
+    producers[i].logger = logger;
+    producers[i].id = i;
+    if (x_thread_create(&threads[i], s_produce, &producers[i]) != 0) return -1;
+  }
+  for (int32_t i = 0; i < PRODUCERS; i++)
+  {
+    x_thread_join(threads[i]);
+    x_thread_destroy(threads[i]);
+  }
+  return 0;
+}
+
+int test_log_sync(void)
+{
+  XLogger logger;
+  int32_t bad;
+  remove(TEMP_LOG);
+  x_log_init(&logger, XLOG_OUTPUT_FILE, XLOG_LEVEL_INFO, TEMP_LOG);
+  x_log_print(&logger, XLOG_LEVEL_DEBUG, "filtered\n");
+  x_log_print(&logger, XLOG_LEVEL_INFO, "0 0\n");
+  x_log_print(&logger, XLOG_LEVEL_INFO, "0 1\n");
+  x_log_close(&logger);
+
+  ASSERT_EQ(s_check_log(&bad), 2);
+  ASSERT_EQ(bad, 0);
+  return 0;
+}
+
+int test_log_async_block(void)
+{
+  XLogger logger;
+  int32_t bad;
+  remove(TEMP_LOG);
+  x_log_init(&logger, XLOG_OUTPUT_FILE, XLOG_LEVEL_INFO, TEMP_LOG);
+  // A small ring makes producers wait on the writer
+  ASSERT_TRUE(x_log_start_async(&logger, 2048, XLOG_ASYNC_BLOCK));
+  ASSERT_EQ(s_run_producers(&logger), 0);
+  x_log_close(&logger);
+
+  ASSERT_EQ(s_check_log(&bad), PRODUCERS * MESSAGES);
+  ASSERT_EQ(bad, 0);
+  return 0;
+}
+
+int test_log_async_drop(void)
+{
+  XLogger logger;
+  int32_t bad;
+  remove(TEMP_LOG);
+  x_log_init(&logger, XLOG_OUTPUT_FILE, XLOG_LEVEL_INFO, TEMP_LOG);
+  ASSERT_TRUE(x_log_start_async(&logger, 1024, XLOG_ASYNC_DROP));
+  ASSERT_EQ(s_run_producers(&logger), 0);
+  x_log_flush(&logger);
+  uint64_t dropped = x_log_dropped(&logger);
+  x_log_close(&logger);
+
+  // Every message is either written or counted as dropped
+  int32_t lines = s_check_log(&bad);
+  ASSERT_EQ(bad, 0);
+  ASSERT_EQ((uint64_t)lines + dropped, (uint64_t)(PRODUCERS * MESSAGES));
+  return 0;
+}
+
+int test_log_async_flush(void)
+{
+  XLogger logger;
+  int32_t bad;
+  remove(TEMP_LOG);
+  x_log_init(&logger, XLOG_OUTPUT_FILE, XLOG_LEVEL_INFO, TEMP_LOG);
+  ASSERT_TRUE(x_log_start_async(&logger, 0, XLOG_ASYNC_DROP));
+  x_log_print(&logger, XLOG_LEVEL_INFO, "0 0\n");
+  x_log_flush(&logger);
+  ASSERT_EQ(s_check_log(&bad), 1);
+
+  // Fatal messages are on disk as soon as the call returns
+  x_log_message(&logger, XLOG_LEVEL_FATAL, XLOG_COLOR_WHITE, XLOG_COLOR_RED, XLOG_PLAIN, __FILE__, __LINE__, __func__, "0 1\n");
+  ASSERT_EQ(s_check_log(&bad), 2);
+  ASSERT_EQ(bad, 0);
+  x_log_close(&logger);
+  ASSERT_TRUE(logger.async == NULL);
+  remove(TEMP_LOG);
+  return 0;
+}
+
+// Returns the message part of the last line of the log, after the source info
+static bool s_last_message(const char* path, char* out, size_t cap)
+{
+  char line[1024];
+  bool found = false;
+  FILE* f = fopen(path, "r");
+  if (!f) return false;
+  while (fgets(line, sizeof(line), f))
+  {
+    const char* msg = strstr(line, ") : ");
+    if (!msg) continue;
+    snprintf(out, cap, "%s", msg + 4);
+    found = true;
+  }
+  fclose(f);
+  return found;
+}
+
+#define BINARY_FORMAT "%d %5.2f [%s] %-4x| %lld %zu %c %*d %.3s %hhd %hu %p %e %%\n"
+#define BINARY_ARGS -42, 3.14159, "text", 0xbeefu, -1234567890123LL, (size_t)77, 'q', 6, 12, "abcdef", 300, 70000, (void*)&s_pointer_target, 1.5e-7
+static int s_pointer_target;
+
+int test_log_binary_format(void)
+{
+  XLogger logger;
+  char expected[512];
+  char actual[512];
+  remove(TEMP_LOG);
+  x_log_init(&logger, XLOG_OUTPUT_FILE, XLOG_LEVEL_INFO, TEMP_LOG);
+  ASSERT_TRUE(x_log_start_async(&logger, 0, XLOG_ASYNC_BLOCK));
+
+  // The writer thread formats the recorded values exactly like printf
+  x_log_binary(&logger, XLOG_LEVEL_INFO, BINARY_FORMAT, BINARY_ARGS);
+  x_log_flush(&logger);
+  snprintf(expected, sizeof(expected), BINARY_FORMAT, BINARY_ARGS);
+  ASSERT_TRUE(s_last_message(TEMP_LOG, actual, sizeof(actual)));
+  ASSERT_TRUE(strcmp(expected, actual) == 0);
+
+  // %n can't be deferred, so the call site formats it
+  x_log_binary(&logger, XLOG_LEVEL_INFO, "str %s %%n\n", "ok");
+  x_log_binary(&logger, XLOG_LEVEL_DEBUG, "filtered\n");
+  x_log_close(&logger);
+  ASSERT_TRUE(s_last_message(TEMP_LOG, actual, sizeof(actual)));
+  ASSERT_TRUE(strcmp(actual, "str ok %n\n") == 0);
+  remove(TEMP_LOG);
+  return 0;
+}
+
+#define TEMP_BINARY "test_tmp_log.bin"
+
+static void* s_produce_binary(void* arg)
+{
+  Producer* p = (Producer*)arg;
+  for (int32_t i = 0; i < MESSAGES; i++)
+    x_log_binary(p->logger, XLOG_LEVEL_INFO, "%d %d\n", p->id, i);
+  return NULL;
+}
+
+int test_log_binary_decode(void)
+{
+  XLogger logger;
+  XThread* threads[PRODUCERS];
+  Producer producers[PRODUCERS];
+  char actual[512];
+  char expected[512];
+  remove(TEMP_LOG);
+  x_log_init(&logger, XLOG_OUTPUT_NONE, XLOG_LEVEL_INFO, NULL);
+  ASSERT_TRUE(x_log_open_binary(&logger, TEMP_BINARY));
+  ASSERT_TRUE(x_log_start_async(&logger, 4096, XLOG_ASYNC_BLOCK));
+  for (int32_t i = 0; i < PRODUCERS; i++)
+  {
+    producers[i].logger = &logger;
+    producers[i].id = i;
+    ASSERT_EQ(x_thread_create(&threads[i], s_produce_binary, &producers[i]), 0);
+  }
+  for (int32_t i = 0; i < PRODUCERS; i++)
+  {
+    x_thread_join(threads[i]);
+    x_thread_destroy(threads[i]);
+  }
+  x_log_binary(&logger, XLOG_LEVEL_INFO, BINARY_FORMAT, BINARY_ARGS);
+  x_log_close(&logger);
+
+  FILE* in = fopen(TEMP_BINARY, "rb");
+  FILE* out = fopen(TEMP_LOG, "w");
+  ASSERT_TRUE(in && out);
+  ASSERT_TRUE(x_log_decode(in, out));
+  fclose(in);
+  fclose(out);
+
+  // Every line decodes to its message, each producer's in order. Rings are
+  // drained one after another, so the main thread's line can be anywhere.
+  int32_t next[PRODUCERS] = {0};
+  int32_t lines = 0;
+  char line[1024];
+  FILE* f = fopen(TEMP_LOG, "r");
+  ASSERT_TRUE(f);
+  while (fgets(line, sizeof(line), f))
+  {
+    int32_t id, seq;
+    const char* msg = strstr(line, ") : ");
+    ASSERT_TRUE(msg && strncmp(line, "INFO [", 6) == 0);
+    if (sscanf(msg + 4, "%d %d\n", &id, &seq) == 2 && id >= 0 && id < PRODUCERS)
+    {
+      ASSERT_EQ(seq, next[id]);
+      next[id]++;
+    }
+    else
+    {
+      snprintf(actual, sizeof(actual), "%s", msg + 4);
+    }
+    lines++;
+  }
+  fclose(f);
+  ASSERT_EQ(lines, PRODUCERS * MESSAGES + 1);
+  snprintf(expected, sizeof(expected), BINARY_FORMAT, BINARY_ARGS);
+  ASSERT_TRUE(strcmp(expected, actual) == 0);
+
+  // Anything else is rejected
+  in = fopen(TEMP_LOG, "rb");
+  out = fopen(TEMP_BINARY, "w");
+  ASSERT_FALSE(x_log_decode(in, out));
+  fclose(in);
+  fclose(out);
+  remove(TEMP_BINARY);
+  remove(TEMP_LOG);
+  return 0;
+}
+
+static int32_t s_evaluated;
+static int32_t s_count_evaluation(void)
+{
+  return ++s_evaluated;
+}
+
+int test_log_filter_and_timestamps(void)
+{
+  XLogger logger;
+  char line[256];
+  remove(TEMP_LOG);
+  x_log_init(&logger, XLOG_OUTPUT_FILE, XLOG_LEVEL_WARNING, TEMP_LOG);
+
+  // Filtered macros don't evaluate their arguments
+  s_evaluated = 0;
+  x_log_debug(&logger, "%d\n", s_count_evaluation());
+  x_log_info(&logger, "%d\n", s_count_evaluation());
+  x_log_binary(&logger, XLOG_LEVEL_INFO, "%d\n", s_count_evaluation());
+  ASSERT_EQ(s_evaluated, 0);
+  x_log_warning(&logger, "%d\n", s_count_evaluation());
+  ASSERT_EQ(s_evaluated, 1);
+  ASSERT_FALSE(x_log_enabled(&logger, XLOG_LEVEL_INFO));
+  ASSERT_TRUE(x_log_enabled(&logger, XLOG_LEVEL_ERROR));
+  ASSERT_TRUE(x_log_enabled(NULL, XLOG_LEVEL_DEBUG));
+
+  // Timestamps from the per-second cache, plus the monotonic clock
+  x_log_message(&logger, XLOG_LEVEL_ERROR, XLOG_COLOR_RED, XLOG_COLOR_BLACK, XLOG_TIMESTAMP | XLOG_MONOTONIC, __FILE__, __LINE__, __func__, "a\n");
+  x_log_message(&logger, XLOG_LEVEL_ERROR, XLOG_COLOR_RED, XLOG_COLOR_BLACK, XLOG_TIMESTAMP, __FILE__, __LINE__, __func__, "b\n");
+  x_log_close(&logger);
+
+  FILE* f = fopen(TEMP_LOG, "r");
+  ASSERT_TRUE(f);
+  ASSERT_TRUE(fgets(line, sizeof(line), f) != NULL);   // the warning
+  ASSERT_TRUE(fgets(line, sizeof(line), f) != NULL);
+  int y, mo, d, h, mi, sec;
+  unsigned long long mono;
+  unsigned micros;
+  ASSERT_EQ(sscanf(line, "[%d-%d-%d %d:%d:%d] [%llu.%u] a", &y, &mo, &d, &h, &mi, &sec, &mono, &micros), 8);
+  ASSERT_TRUE(y >= 2024 && micros < 1000000);
+  ASSERT_TRUE(fgets(line, sizeof(line), f) != NULL);
+  ASSERT_EQ(sscanf(line, "[%d-%d-%d %d:%d:%d] b", &y, &mo, &d, &h, &mi, &sec), 6);
+  fclose(f);
+  remove(TEMP_LOG);
+  return 0;
+}
+
+int main()
+{
+  STDXTestCase tests[] =
+  {
+    X_TEST(test_log_sync),
+    X_TEST(test_log_async_block),
+    X_TEST(test_log_async_drop),
+    X_TEST(test_log_async_flush),
+    X_TEST(test_log_binary_format),
+    X_TEST(test_log_binary_decode),
+    X_TEST(test_log_filter_and_timestamps),
+  };
+
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
+}
@@ -476,6 +476,308 @@ int test_mat4_minor_cofactor_out_of_range_returns_zero(void)
 }
 
 
+static int s_near_rel(float a, float b, float rel)
+{
+  float scale = fmaxf(1.0f, fmaxf(fabsf(a), fabsf(b)));
+  return fabsf(a - b) <= rel * scale;
+}
+
+/* Reference versions in plain scalar code, for the SIMD paths */
+static Mat4 s_ref_mat4_mul(Mat4 a, Mat4 b)
+{
+  Mat4 r;
+  for (int c = 0; c < 4; c++)
+    for (int i = 0; i < 4; i++)
+      r.m[c * 4 + i] = a.m[i] * b.m[c * 4] + a.m[4 + i] * b.m[c * 4 + 1]
+          + a.m[8 + i] * b.m[c * 4 + 2] + a.m[12 + i] * b.m[c * 4 + 3];
+  return r;
+}
+
+static Mat4 s_test_matrix(int i)
+{
+  float f = (float)i;
+  Mat4 trs = mat4_compose(vec3_make(f, -2.0f * f, 0.5f),
+      quat_axis_angle(vec3_norm(vec3_make(1.0f, f, 2.0f)), 0.37f * f),
+      vec3_make(1.0f + 0.1f * f, 2.0f, 0.5f + 0.05f * f));
+  return trs;
+}
+
+int test_simd_matches_scalar_reference(void)
+{
+  const float REL = 1e-6f;
+  for (int i = 0; i < 32; ++i)
+  {
+    Mat4 a = s_test_matrix(i);
+    Mat4 b = mat4_mul(mat4_perspective_rh_zo(0.9f, 1.5f, 0.1f, 100.0f), s_test_matrix(i + 7));
+    Mat4 r = mat4_mul(a, b);
+    Mat4 e = s_ref_mat4_mul(a, b);
+    Mat4 t = mat4_transpose(a);
+    for (int k = 0; k < 16; ++k)
+    {
+      X_CHECK(s_near_rel(r.m[k], e.m[k], REL));
+      X_CHECK(t.m[(k % 4) * 4 + k / 4] == a.m[k]);
+    }
+
+    Vec3 p = vec3_make(0.5f * (float)i, -1.0f, 3.0f);
+    Vec3 q = mat4_mul_point(b, p);
+    float w = b.m[3] * p.x + b.m[7] * p.y + b.m[11] * p.z + b.m[15];
+    X_CHECK(s_near_rel(q.x, (b.m[0] * p.x + b.m[4] * p.y + b.m[8] * p.z + b.m[12]) / w, REL));
+    X_CHECK(s_near_rel(q.z, (b.m[2] * p.x + b.m[6] * p.y + b.m[10] * p.z + b.m[14]) / w, REL));
+    Vec3 d = mat4_mul_dir(a, p);
+    X_CHECK(s_near_rel(d.y, a.m[1] * p.x + a.m[5] * p.y + a.m[9] * p.z, REL));
+
+    Quat qa = quat_make(0.1f * (float)i, -0.3f, 0.7f, 0.2f);
+    Quat qb = quat_make(-0.4f, 0.25f * (float)i, 0.1f, 0.9f);
+    Quat qm = quat_mul(qa, qb);
+    X_CHECK(s_near_rel(qm.x, qa.w * qb.x + qa.x * qb.w + qa.y * qb.z - qa.z * qb.y, REL));
+    X_CHECK(s_near_rel(qm.y, qa.w * qb.y - qa.x * qb.z + qa.y * qb.w + qa.z * qb.x, REL));
+    X_CHECK(s_near_rel(qm.z, qa.w * qb.z + qa.x * qb.y - qa.y * qb.x + qa.z * qb.w, REL));
+    X_CHECK(s_near_rel(qm.w, qa.w * qb.w - qa.x * qb.x - qa.y * qb.y - qa.z * qb.z, REL));
+    Quat qn = quat_norm(qa);
+    float len = sqrtf(qa.x * qa.x + qa.y * qa.y + qa.z * qa.z + qa.w * qa.w);
+    X_CHECK(s_near_rel(qn.y, qa.y / len, REL) && s_near_rel(qn.w, qa.w / len, REL));
+
+    Vec4 va = vec4_make(1.0f, -2.0f * (float)i, 3.5f, 0.25f);
+    Vec4 vb = vec4_make(-0.5f, 4.0f, (float)i, 8.0f);
+    X_CHECK(s_near_rel(vec4_dot(va, vb), va.x * vb.x + va.y * vb.y + va.z * vb.z + va.w * vb.w, REL));
+    Vec4 vl = vec4_lerp(va, vb, 0.3f);
+    X_CHECK(vl.y == va.y + (vb.y - va.y) * 0.3f);
+    Vec4 vabs = vec4_abs(va);
+    X_CHECK(vabs.y == fabsf(va.y) && vabs.x == 1.0f);
+    Vec4 vd = vec4_div(vb, 3.0f);
+    X_CHECK(vd.z == vb.z / 3.0f);
+  }
+  return 0;
+}
+
+/* Scalar reference for mat4_inverse_affine: inv = diag(1/s^2) * basis^T, t' = -inv * t */
+static Mat4 s_inverse_affine_ref(Mat4 m)
+{
+  Mat4 inv = mat4_identity();
+  float s[3];
+  for (int c = 0; c < 3; ++c)
+    s[c] = sqrtf(m.m[c * 4] * m.m[c * 4] + m.m[c * 4 + 1] * m.m[c * 4 + 1] + m.m[c * 4 + 2] * m.m[c * 4 + 2]);
+
+  for (int c = 0; c < 3; ++c)
+    for (int r = 0; r < 3; ++r)
+      inv.m[c * 4 + r] = m.m[r * 4 + c] / s[r] / s[r];
+
+  for (int r = 0; r < 3; ++r)
+    inv.m[12 + r] = -(inv.m[r] * m.m[12] + inv.m[4 + r] * m.m[13] + inv.m[8 + r] * m.m[14]);
+  return inv;
+}
+
+int test_mat4_inverse_affine_negative_translation(void)
+{
+  for (int i = 0; i < 32; ++i)
+  {
+    float f = (float)i;
+    /* All-negative translation makes the w lane 0 * t come out as -0 */
+    Mat4 M = mat4_compose(vec3_make(-1.0f - f, -0.5f * f - 2.0f, -3.0f),
+        quat_axis_angle(vec3_norm(vec3_make(1.0f, f, 2.0f)), 0.37f * f),
+        vec3_make(1.0f + 0.1f * f, 2.0f, 0.5f + 0.05f * f));
+    Mat4 A = mat4_inverse_affine(M);
+    Mat4 R = s_inverse_affine_ref(M);
+
+    X_CHECK(A.m[3] == 0.0f && A.m[7] == 0.0f && A.m[11] == 0.0f);
+    X_CHECK(A.m[15] == 1.0f);
+    for (int k = 0; k < 15; ++k)
+      X_CHECK(s_near_rel(A.m[k], R.m[k], 1e-6f));
+  }
+  return 0;
+}
+
+int test_mat4_inverse_general(void)
+{
+  const float EPS = 2e-4f;
+  for (int i = 0; i < 32; ++i)
+  {
+    /* Projective, not affine: exercises the full path */
+    Mat4 M = mat4_mul(mat4_perspective_rh_no(1.1f, 1.3f, 0.5f, 50.0f), s_test_matrix(i));
+    bool ok = false;
+    bool ok_full = false;
+    Mat4 F = mat4_inverse(M, &ok);
+    Mat4 R = mat4_inverse_full(M, &ok_full);
+    X_REQUIRE(ok && ok_full);
+
+    Mat4 I = mat4_mul(M, F);
+    for (int k = 0; k < 16; ++k)
+    {
+      X_CHECK_FLOAT_EQ(I.m[k], (k % 5 == 0) ? 1.0f : 0.0f, EPS);
+      X_CHECK(s_near_rel(F.m[k], R.m[k], 1e-3f));
+    }
+
+    /* Affine input agrees with the affine inverse */
+    Mat4 A = s_test_matrix(i);
+    Mat4 FA = mat4_inverse(A, &ok);
+    Mat4 AA = mat4_inverse_affine(A);
+    X_REQUIRE(ok);
+    for (int k = 0; k < 16; ++k)
+      X_CHECK_FLOAT_EQ(FA.m[k], AA.m[k], EPS);
+  }
+
+  Mat4 S = mat4_scale(vec3_make(1.0f, 0.0f, 1.0f));
+  bool ok = true;
+  Mat4 I = mat4_inverse(S, &ok);
+  X_CHECK(ok == false);
+  X_CHECK(I.m[0] == 1.0f && I.m[5] == 1.0f && I.m[1] == 0.0f);
+  return 0;
+}
+
+int test_batch_transform_matches_single(void)
+{
+  enum { N = 37 };
+  float xs[N], ys[N], zs[N], ox[N], oy[N], oz[N];
+  for (int i = 0; i < N; ++i) {
+    xs[i] = (float)i * 0.75f - 9.0f;
+    ys[i] = (float)(i % 7) - 3.0f;
+    zs[i] = -(float)i * 0.5f - 1.0f;
+  }
+
+  Mat4 affine = s_test_matrix(3);
+  Mat4 proj = mat4_mul(mat4_perspective_rh_no(1.0f, 1.5f, 0.1f, 100.0f), affine);
+  Mat4 ms[2] = { affine, proj };
+  for (int k = 0; k < 2; ++k) {
+    mat4_transform_points(ms[k], xs, ys, zs, ox, oy, oz, N);
+    for (int i = 0; i < N; ++i) {
+      Vec3 p = mat4_mul_point(ms[k], vec3_make(xs[i], ys[i], zs[i]));
+      X_CHECK(s_near_rel(ox[i], p.x, 1e-6f) && s_near_rel(oy[i], p.y, 1e-6f) && s_near_rel(oz[i], p.z, 1e-6f));
+    }
+
+    mat4_transform_dirs(ms[k], xs, ys, zs, ox, oy, oz, N);
+    for (int i = 0; i < N; ++i) {
+      Vec3 d = mat4_mul_dir(ms[k], vec3_make(xs[i], ys[i], zs[i]));
+      X_CHECK(s_near_rel(ox[i], d.x, 1e-6f) && s_near_rel(oy[i], d.y, 1e-6f) && s_near_rel(oz[i], d.z, 1e-6f));
+    }
+  }
+
+  /* In place */
+  mat4_transform_points(affine, xs, ys, zs, xs, ys, zs, N);
+  Vec3 p = mat4_mul_point(affine, vec3_make(-9.0f, -3.0f, -1.0f));
+  X_CHECK(s_near_rel(xs[0], p.x, 1e-6f) && s_near_rel(zs[0], p.z, 1e-6f));
+  return 0;
+}
+
+int test_frustum_cull(void)
+{
+  /* Camera at the origin looking down -Z, 90 degree vertical fov */
+  Mat4 vp = mat4_mul(mat4_perspective_rh_zo(STDXM_PI * 0.5f, 1.0f, 1.0f, 100.0f),
+      mat4_look_at_rh(vec3_make(0, 0, 0), vec3_make(0, 0, -1), vec3_make(0, 1, 0)));
+  Frustum f = frustum_from_mat4(vp, true);
+
+  enum { N = 40 };
+  float x[N], y[N], z[N], r[N], e[N];
+  bool expect[N];
+  for (int i = 0; i < N; ++i) {
+    switch (i % 5) {
+      case 0: x[i] = 0; y[i] = 0; z[i] = -10; expect[i] = true; break;   /* center */
+      case 1: x[i] = 0; y[i] = 0; z[i] = 10; expect[i] = false; break;   /* behind */
+      case 2: x[i] = 30; y[i] = 0; z[i] = -10; expect[i] = false; break; /* far right */
+      case 3: x[i] = 10.5f; y[i] = 0; z[i] = -10; expect[i] = true; break; /* straddles right */
+      default: x[i] = 0; y[i] = 0; z[i] = -150; expect[i] = false; break; /* past far */
+    }
+    r[i] = 1.0f;
+    e[i] = 1.0f;
+  }
+
+  uint32_t mask[2] = { 0xFFFFFFFFu, 0xFFFFFFFFu };
+  frustum_cull_spheres(&f, x, y, z, r, N, mask);
+  for (int i = 0; i < N; ++i)
+    X_CHECK(((mask[i / 32] >> (i % 32)) & 1u) == (uint32_t)expect[i]);
+  X_CHECK((mask[1] >> (N - 32)) == 0);
+
+  frustum_cull_aabbs(&f, x, y, z, e, e, e, N, mask);
+  for (int i = 0; i < N; ++i)
+    X_CHECK(((mask[i / 32] >> (i % 32)) & 1u) == (uint32_t)expect[i]);
+  return 0;
+}
+
+#if X_MATH_SIMD_SSE
+static void s_reset_batch_kernels(uint32_t mask)
+{
+  x_cpu_set_feature_mask(mask);
+  X_CPU_RESET(s_xm_transform_points_wide);
+  X_CPU_RESET(s_xm_transform_dirs_wide);
+  X_CPU_RESET(s_xm_cull_wide);
+}
+#endif
+
+/* The AVX2 and AVX-512F kernels give the same bits as the SSE2 and scalar loops */
+int test_batch_kernels_match_across_cpu_levels(void)
+{
+#if X_MATH_SIMD_SSE
+  static const uint32_t masks[] = { 0xFFFFFFFFu, ~(uint32_t)CPU_FEATURE_AVX512F, 0 };
+  enum { N = 77 };
+  float xs[N], ys[N], zs[N], rs[N];
+  float ref[3][3][N], out[3][N];
+  uint32_t ref_mask[2][3], mask[3];
+
+  for (int i = 0; i < N; ++i) {
+    xs[i] = (float)i * 0.37f - 12.0f;
+    ys[i] = (float)(i % 11) - 5.0f;
+    zs[i] = -(float)i * 0.9f + 4.0f;
+    rs[i] = 0.25f + (float)(i % 5);
+  }
+
+  Mat4 vp = mat4_mul(mat4_perspective_rh_zo(1.2f, 1.3f, 0.5f, 40.0f),
+      mat4_look_at_rh(vec3_make(0, 0, 0), vec3_make(0, 0, -1), vec3_make(0, 1, 0)));
+  Frustum f = frustum_from_mat4(vp, true);
+
+  for (size_t k = 0; k < sizeof(masks) / sizeof(masks[0]); k++) {
+    s_reset_batch_kernels(masks[k]);
+    float (*dst)[N] = k == 0 ? ref[0] : out;
+    mat4_transform_points(s_test_matrix(3), xs, ys, zs, dst[0], dst[1], dst[2], N);
+    if (k > 0)
+      X_CHECK(memcmp(out, ref[0], sizeof(out)) == 0);
+    dst = k == 0 ? ref[1] : out;
+    mat4_transform_points(vp, xs, ys, zs, dst[0], dst[1], dst[2], N);
+    if (k > 0)
+      X_CHECK(memcmp(out, ref[1], sizeof(out)) == 0);
+    dst = k == 0 ? ref[2] : out;
+    mat4_transform_dirs(vp, xs, ys, zs, dst[0], dst[1], dst[2], N);
+    if (k > 0)
+      X_CHECK(memcmp(out, ref[2], sizeof(out)) == 0);
+
+    frustum_cull_spheres(&f, xs, ys, zs, rs, N, k == 0 ? ref_mask[0] : mask);
+    if (k > 0)
+      X_CHECK(memcmp(mask, ref_mask[0], sizeof(mask)) == 0);
+    frustum_cull_aabbs(&f, xs, ys, zs, rs, rs, rs, N, k == 0 ? ref_mask[1] : mask);
+    if (k > 0)
+      X_CHECK(memcmp(mask, ref_mask[1], sizeof(mask)) == 0);
+  }
+  s_reset_batch_kernels(0xFFFFFFFFu);
+
+  /* Some of both outcomes, so the masks are worth comparing */
+  X_CHECK(ref_mask[0][0] != 0 && ref_mask[0][0] != 0xFFFFFFFFu);
+#endif
+  return 0;
+}
+
+int test_compose_and_slerp_arrays(void)
+{
+  enum { N = 9 };
+  Vec3 t[N], s[N];
+  Quat r[N], b[N], q[N];
+  Mat4 m[N];
+  for (int i = 0; i < N; ++i) {
+    t[i] = vec3_make((float)i, -2.0f * (float)i, 0.5f);
+    s[i] = vec3_make(1.0f + (float)i * 0.1f, 2.0f, 0.25f);
+    r[i] = quat_axis_angle(vec3_norm(vec3_make(1.0f, (float)i, 2.0f)), (float)i * 0.4f);
+    b[i] = quat_axis_angle(vec3_make(0, 1, 0), (float)i * -0.3f);
+  }
+
+  mat4_compose_array(t, r, s, N, m);
+  quat_slerp_array(r, b, 0.3f, N, q);
+  for (int i = 0; i < N; ++i) {
+    Mat4 ref = mat4_compose(t[i], r[i], s[i]);
+    for (int k = 0; k < 16; ++k)
+      X_CHECK_FLOAT_EQ(m[i].m[k], ref.m[k], X_TEST_EPS);
+    Quat qs = quat_slerp(r[i], b[i], 0.3f);
+    X_CHECK(q[i].x == qs.x && q[i].y == qs.y && q[i].z == qs.z && q[i].w == qs.w);
+  }
+  return 0;
+}
+
 int main(void)
 {
   STDXTestCase tests[] =
@@ -501,6 +803,13 @@ int main(void)
     X_TEST(test_mat4_det_identity_is_one),
     X_TEST(test_mat4_det_scale_product),
     X_TEST(test_mat4_minor_cofactor_out_of_range_returns_zero),
+    X_TEST(test_simd_matches_scalar_reference),
+    X_TEST(test_mat4_inverse_general),
+    X_TEST(test_mat4_inverse_affine_negative_translation),
+    X_TEST(test_batch_transform_matches_single),
+    X_TEST(test_frustum_cull),
+    X_TEST(test_batch_kernels_match_across_cpu_levels),
+    X_TEST(test_compose_and_slerp_arrays),
   };
 
   return x_tests_run(tests, sizeof(tests) / sizeof(tests[0]), NULL);
@@ -1,5 +1,7 @@
 #define X_IMPL_TEST
 #include <stdx_test.h>
+#define X_IMPL_IO
+#include <stdx_io.h>
 #define X_IMPL_NETWORK
 #include <stdx_network.h>
 #include <string.h>
@@ -78,6 +80,83 @@ int test_udp_send_recv() {
   return 0;
 }
 
+int test_udp_batch() {
+  XSocket sender = x_net_socket_udp4();
+  XSocket receiver = x_net_socket_udp4();
+  XAddress addr;
+  ASSERT_TRUE(x_net_resolve("127.0.0.1", "23457", X_NET_AF_IPV4, &addr));
+  ASSERT_TRUE(x_net_bind(receiver, &addr));
+
+  char payload[10][8];
+  XNetDatagram out[10];
+  for (int32_t i = 0; i < 10; i++)
+  {
+    snprintf(payload[i], sizeof(payload[i]), "msg %d", i);
+    out[i].data = payload[i];
+    out[i].length = strlen(payload[i]);
+    out[i].addr = &addr;
+  }
+  ASSERT_EQ(x_net_sendmmsg(sender, out, 10), 10);
+
+  char bufs[16][32];
+  XAddress from[16];
+  XNetDatagram in[16];
+  int32_t received = 0;
+  while (received < 10)
+  {
+    for (int32_t i = 0; i < 16; i++)
+    {
+      in[i].data = bufs[i];
+      in[i].length = sizeof(bufs[i]);
+      in[i].addr = &from[i];
+    }
+    int32_t n = x_net_recvmmsg(receiver, in, 16 - received);
+    ASSERT_TRUE(n > 0);
+    for (int32_t i = 0; i < n; i++, received++)
+    {
+      ASSERT_EQ(in[i].length, strlen(payload[received]));
+      ASSERT_TRUE(memcmp(bufs[i], payload[received], in[i].length) == 0);
+      ASSERT_EQ(in[i].segment_size, 0);
+      ASSERT_EQ(from[i].family, AF_INET);
+    }
+  }
+
+  // Nothing left: a non-blocking batch receive reports would-block
+  ASSERT_EQ(x_net_set_nonblocking(receiver, 1), 0);
+  ASSERT_EQ(x_net_recvmmsg(receiver, in, 16), -1);
+  ASSERT_TRUE(x_net_would_block());
+  ASSERT_EQ(x_net_set_nonblocking(receiver, 0), 0);
+
+  // One receive scattered over two buffers
+  ASSERT_TRUE(x_net_sendto(sender, "hello world", 11, &addr) == 11);
+  char head[5];
+  char tail[16];
+  XSlice parts[2] = { x_slice_init(head, sizeof(head)), x_slice_init(tail, sizeof(tail)) };
+  ASSERT_EQ(x_net_recvv(receiver, parts, 2), 11);
+  ASSERT_TRUE(memcmp(head, "hello", 5) == 0);
+  ASSERT_TRUE(memcmp(tail, " world", 6) == 0);
+
+  // With segmentation offload one send leaves as several datagrams
+  if (x_net_set_udp_segment(sender, 1000))
+  {
+    static char big[3000];
+    memset(big, 'x', sizeof(big));
+    XNetDatagram burst = { big, sizeof(big), &addr, 0 };
+    ASSERT_EQ(x_net_sendmmsg(sender, &burst, 1), 1);
+    for (int32_t i = 0; i < 3; i++)
+    {
+      char seg[2000];
+      XNetDatagram one = { seg, sizeof(seg), NULL, 0 };
+      ASSERT_EQ(x_net_recvmmsg(receiver, &one, 1), 1);
+      ASSERT_EQ(one.length, 1000);
+    }
+  }
+
+  x_net_close(sender);
+  x_net_close(receiver);
+  return 0;
+}
+
 int test_multicast_ipv4()
 {
   XSocket sock = x_net_socket_udp4();
@@ -136,6 +215,231 @@ int test_get_adapters_info(void)
   return 0;
 }
 
+int test_net_loop(void)
+{
+  int listener_tag = 1;
+  int server_tag = 2;
+  XNetEvent events[8];
+  XAddress addr;
+
+  XNetLoop* loop = x_net_loop_create(0);
+  ASSERT_TRUE(loop != NULL);
+
+  XSocket listener = x_net_socket_tcp4();
+  ASSERT_TRUE(x_net_socket_is_valid(listener));
+  ASSERT_TRUE(x_net_resolve("127.0.0.1", "34567", X_NET_AF_IPV4, &addr));
+  ASSERT_TRUE(x_net_bind(listener, &addr));
+  ASSERT_TRUE(x_net_listen(listener, 16));
+  ASSERT_EQ(x_net_set_nonblocking(listener, 1), 0);
+  ASSERT_TRUE(x_net_loop_add(loop, listener, X_NET_LOOP_READ, &listener_tag));
+  ASSERT_FALSE(x_net_loop_add(loop, listener, X_NET_LOOP_READ, &listener_tag));
+  ASSERT_EQ(x_net_loop_wait(loop, events, 8, 0), 0);
+
+  XSocket client = x_net_socket_tcp4();
+  ASSERT_EQ(x_net_connect(client, &addr), 0);
+
+  ASSERT_EQ(x_net_loop_wait(loop, events, 8, 1000), 1);
+  ASSERT_TRUE(events[0].sock == listener);
+  ASSERT_TRUE(events[0].user == &listener_tag);
+  ASSERT_TRUE(events[0].events & X_NET_LOOP_READ);
+
+  XAddress peer;
+  XSocket server = x_net_accept(listener, &peer);
+  ASSERT_TRUE(x_net_socket_is_valid(server));
+  ASSERT_TRUE(!x_net_socket_is_valid(x_net_accept(listener, &peer)) && x_net_would_block());
+  ASSERT_EQ(x_net_set_nonblocking(server, 1), 0);
+  ASSERT_TRUE(x_net_loop_add(loop, server, X_NET_LOOP_READ | X_NET_LOOP_WRITE, &server_tag));
+
+  // A fresh connection is writable right away
+  ASSERT_EQ(x_net_loop_wait(loop, events, 8, 1000), 1);
+  ASSERT_TRUE(events[0].user == &server_tag);
+  ASSERT_TRUE(events[0].events & X_NET_LOOP_WRITE);
+  ASSERT_TRUE(x_net_loop_modify(loop, server, X_NET_LOOP_READ, &server_tag));
+
+  ASSERT_EQ(x_net_send(client, "ping", 4), 4);
+  ASSERT_EQ(x_net_loop_wait(loop, events, 8, 1000), 1);
+  ASSERT_TRUE(events[0].sock == server);
+  ASSERT_TRUE(events[0].events & X_NET_LOOP_READ);
+
+  char buf[16];
+  ASSERT_EQ(x_net_recv(server, buf, sizeof(buf)), 4);
+  ASSERT_TRUE(memcmp(buf, "ping", 4) == 0);
+  ASSERT_TRUE(x_net_recv(server, buf, sizeof(buf)) == (size_t)-1 && x_net_would_block());
+
+  // Drained: nothing more until new data arrives
+  ASSERT_EQ(x_net_loop_wait(loop, events, 8, 50), 0);
+
+  // A wake-up ends an infinite wait without reporting events
+  ASSERT_TRUE(x_net_loop_wake(loop));
+  ASSERT_EQ(x_net_loop_wait(loop, events, 8, -1), 0);
+
+  // The peer closing shows up as a hangup
+  x_net_close(client);
+  ASSERT_EQ(x_net_loop_wait(loop, events, 8, 1000), 1);
+  ASSERT_TRUE(events[0].events & (X_NET_LOOP_HANGUP | X_NET_LOOP_READ));
+  ASSERT_EQ(x_net_recv(server, buf, sizeof(buf)), 0);
+
+  ASSERT_TRUE(x_net_loop_remove(loop, server));
+  ASSERT_FALSE(x_net_loop_remove(loop, server));
+  x_net_close(server);
+  ASSERT_TRUE(x_net_loop_remove(loop, listener));
+  x_net_close(listener);
+  x_net_loop_destroy(loop);
+  return 0;
+}
+
+int test_net_send_file(void)
+{
+  const char* temp_file = "test_tmp_net_send_file.bin";
+  static char data[200000];
+  static char got[200000];
+  for (size_t i = 0; i < sizeof(data); i++)
+    data[i] = (char)((i * 7u) ^ (i >> 9));
+  XFile* f = x_io_open(temp_file, "wb");
+  ASSERT_TRUE(f);
+  ASSERT_EQ(x_io_write(f, data, sizeof(data)), sizeof(data));
+  x_io_close(f);
+
+  XAddress addr;
+  XAddress peer;
+  XSocket listener = x_net_socket_tcp4();
+  ASSERT_TRUE(x_net_resolve("127.0.0.1", "34568", X_NET_AF_IPV4, &addr));
+  ASSERT_TRUE(x_net_bind(listener, &addr));
+  ASSERT_TRUE(x_net_listen(listener, 4));
+  XSocket client = x_net_socket_tcp4();
+  ASSERT_EQ(x_net_connect(client, &addr), 0);
+  XSocket server = x_net_accept(listener, &peer);
+  ASSERT_TRUE(x_net_socket_is_valid(server));
+
+  f = x_io_open(temp_file, "rb");
+  ASSERT_TRUE(f);
+
+  // A range from the middle, larger than the socket buffers, read as it arrives
+  ASSERT_EQ(x_net_set_nonblocking(server, 1), 0);
+  const uint64_t offset = 1234;
+  const size_t len = 150000;
+  size_t sent = 0;
+  size_t received = 0;
+  while (received < len)
+  {
+    if (sent < len)
+      sent += x_net_send_file(server, f, offset + sent, len - sent);
+    size_t n = x_net_recv(client, got + received, len - received);
+    ASSERT_TRUE(n != (size_t)-1 && n > 0);
+    received += n;
+  }
+  ASSERT_EQ(sent, len);
+  ASSERT_TRUE(memcmp(got, data + offset, len) == 0);
+
+  // Ranges past the end of the file stop at the end
+  ASSERT_EQ(x_net_set_nonblocking(server, 0), 0);
+  ASSERT_EQ(x_net_send_file(server, f, sizeof(data) - 10, 100), 10);
+  received = 0;
+  while (received < 10)
+    received += x_net_recv(client, got + received, 10 - received);
+  ASSERT_TRUE(memcmp(got, data + sizeof(data) - 10, 10) == 0);
+  ASSERT_EQ(x_net_send_file(server, f, sizeof(data) + 10, 100), 0);
+  ASSERT_EQ(x_net_send_file(server, NULL, 0, 100), 0);
+
+  x_io_close(f);
+  x_net_close(client);
+  x_net_close(server);
+  x_net_close(listener);
+  remove(temp_file);
+  return 0;
+}
+
+int test_net_buffers(void)
+{
+  // Sizes round up to the alignment, payloads are aligned, the limit holds
+  XNetBufferPool* pool = x_net_buffer_pool_create(100, 4);
+  ASSERT_TRUE(pool != NULL);
+  XNetBuffer* held[4];
+  for (int32_t i = 0; i < 4; i++)
+  {
+    held[i] = x_net_buffer_acquire(pool);
+    ASSERT_TRUE(held[i] != NULL);
+    ASSERT_EQ(held[i]->capacity, 128);
+    ASSERT_EQ((uintptr_t)held[i]->data % X_NET_BUFFER_ALIGN, 0);
+  }
+  ASSERT_TRUE(x_net_buffer_acquire(pool) == NULL);
+  ASSERT_EQ(x_net_buffer_pool_in_use(pool), 4);
+
+  // Extra references keep a buffer out of the pool
+  x_net_buffer_retain(held[0]);
+  x_net_buffer_release(held[0]);
+  ASSERT_EQ(x_net_buffer_pool_in_use(pool), 4);
+  for (int32_t i = 0; i < 4; i++)
+    x_net_buffer_release(held[i]);
+  ASSERT_EQ(x_net_buffer_pool_in_use(pool), 0);
+
+  XAddress addr;
+  XAddress peer;
+  XSocket listener = x_net_socket_tcp4();
+  ASSERT_TRUE(x_net_resolve("127.0.0.1", "34569", X_NET_AF_IPV4, &addr));
+  ASSERT_TRUE(x_net_bind(listener, &addr));
+  ASSERT_TRUE(x_net_listen(listener, 4));
+  XSocket client = x_net_socket_tcp4();
+  ASSERT_EQ(x_net_connect(client, &addr), 0);
+  XSocket server = x_net_accept(listener, &peer);
+  ASSERT_TRUE(x_net_socket_is_valid(server));
+  ASSERT_EQ(x_net_set_nonblocking(server, 1), 0);
+
+  // Nothing to read: no buffer stays allocated
+  XNetChain in = {0};
+  ASSERT_TRUE(x_net_recv_chain(server, pool, &in) == (size_t)-1 && x_net_would_block());
+  ASSERT_TRUE(in.head == NULL);
+  ASSERT_EQ(x_net_buffer_pool_in_use(pool), 0);
+
+  // 300 bytes span three buffers
+  char msg[300];
+  for (int32_t i = 0; i < 300; i++) msg[i] = (char)('a' + i % 26);
+  ASSERT_EQ(x_net_send(client, msg, sizeof(msg)), sizeof(msg));
+  size_t got = 0;
+  while (got < sizeof(msg))
+  {
+    size_t r = x_net_recv_chain(server, pool, &in);
+    if (r == (size_t)-1 && x_net_would_block()) continue;
+    ASSERT_TRUE(r != (size_t)-1 && r > 0);
+    got += r;
+  }
+  ASSERT_EQ(in.length, 300);
+  ASSERT_EQ(x_net_buffer_pool_in_use(pool), 3);
+
+  XSlice parts[8];
+  ASSERT_EQ(x_net_chain_gather(&in, parts, 8), 3);
+  ASSERT_EQ(parts[0].length + parts[1].length + parts[2].length, 300);
+  char flat[300];
+  ASSERT_EQ(x_net_chain_copy(&in, flat, sizeof(flat)), 300);
+  ASSERT_TRUE(memcmp(flat, msg, 300) == 0);
+
+  // Consuming past the first buffer hands it back
+  x_net_chain_consume(&in, 130);
+  ASSERT_EQ(in.length, 170);
+  ASSERT_EQ(x_net_buffer_pool_in_use(pool), 2);
+
+  // Echo the rest without copying, then nothing is in flight
+  XNetChain out = {0};
+  x_net_chain_move(&out, &in);
+  ASSERT_TRUE(in.head == NULL && in.length == 0);
+  ASSERT_EQ(x_net_send_chain(server, &out), 170);
+  ASSERT_EQ(out.length, 0);
+  ASSERT_EQ(x_net_buffer_pool_in_use(pool), 0);
+
+  char echo[170];
+  got = 0;
+  while (got < sizeof(echo))
+    got += x_net_recv(client, echo + got, sizeof(echo) - got);
+  ASSERT_TRUE(memcmp(echo, msg + 130, 170) == 0);
+
+  x_net_chain_release(&out);
+  x_net_close(client);
+  x_net_close(server);
+  x_net_close(listener);
+  x_net_buffer_pool_destroy(pool);
+  return 0;
+}
+
 int main()
 {
   ASSERT_TRUE(x_net_init());
@@ -148,8 +452,12 @@ int main()
     X_TEST(test_bind_listen_accept),
     X_TEST(test_address_resolution),
     X_TEST(test_udp_send_recv),
+    X_TEST(test_udp_batch),
     X_TEST(test_multicast_ipv4),
     X_TEST(test_multicast_ipv6),
+    X_TEST(test_net_loop),
+    X_TEST(test_net_send_file),
+    X_TEST(test_net_buffers),
   };
 
   int result = x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
@@ -0,0 +1,249 @@
+// The thread pool is instrumented, so the profiler implementation comes before stdx_thread.h
+#define X_PROFILE_LIBRARY
+#define X_IMPL_TIME
+#define X_IMPL_PROFILE
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#include <stdx_profile.h>
+#define X_IMPL_TEST
+#include <stdx_test.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEMP_TRACE "test_tmp_profile_trace.json"
+#define WORKERS 4
+#define ZONES_PER_WORKER 1000
+
+static void s_spin(int32_t n)
+{
+  volatile uint64_t sink = 0;
+  for (int32_t i = 0; i < n; i++)
+    sink += (uint64_t)i * 2654435761u;
+}
+
+static const XProfileStats* s_find(const XProfileStats* stats, size_t n, const char* name)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    if (strcmp(stats[i].name, name) == 0)
+      return &stats[i];
+  }
+  return NULL;
+}
+
+static void s_inner(void)
+{
+  X_PROFILE_BEGIN("inner");
+  s_spin(2000);
+  X_PROFILE_END();
+}
+
+static void* s_worker(void* arg)
+{
+  (void)arg;
+  x_profile_set_thread_name("worker");
+  for (int32_t i = 0; i < ZONES_PER_WORKER; i++)
+  {
+    X_PROFILE_BEGIN("worker zone");
+    s_spin(10);
+    X_PROFILE_END();
+  }
+  return NULL;
+}
+
+static void s_task(void* arg)
+{
+  (void)arg;
+  s_spin(100);
+}
+
+static int32_t s_count(const char* text, const char* needle)
+{
+  int32_t n = 0;
+  for (const char* p = strstr(text, needle); p; p = strstr(p + 1, needle))
+    n++;
+  return n;
+}
+
+static char* s_read_file(const char* path)
+{
+  FILE* f = fopen(path, "rb");
+  if (!f) return NULL;
+  fseek(f, 0, SEEK_END);
+  long len = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char* text = (char*)malloc((size_t)len + 1);
+  if (text && fread(text, 1, (size_t)len, f) != (size_t)len)
+  {
+    free(text);
+    text = NULL;
+  }
+  if (text) text[len] = 0;
+  fclose(f);
+  return text;
+}
+
+int test_profile_inactive(void)
+{
+  XProfileStats stats[4];
+  s_inner();
+  ASSERT_EQ(x_profile_stats(stats, 4), 0);
+  ASSERT_TRUE(x_profile_ticks_per_second() == 0.0);
+  ASSERT_FALSE(x_profile_write_chrome_trace(TEMP_TRACE));
+  return 0;
+}
+
+int test_profile_nesting(void)
+{
+  ASSERT_TRUE(x_profile_init(0));
+  ASSERT_TRUE(x_profile_ticks_per_second() > 0.0);
+
+  for (int32_t i = 0; i < 10; i++)
+  {
+    X_PROFILE_BEGIN("outer");
+    s_spin(1000);
+    s_inner();
+    s_inner();
+    X_PROFILE_END();
+  }
+  // Unmatched ends are ignored
+  X_PROFILE_END();
+
+  XProfileStats stats[8];
+  size_t n = x_profile_stats(stats, 8);
+  ASSERT_EQ(n, 2);
+  const XProfileStats* outer = s_find(stats, n, "outer");
+  const XProfileStats* inner = s_find(stats, n, "inner");
+  ASSERT_TRUE(outer && inner);
+  ASSERT_EQ(outer->count, 10);
+  ASSERT_EQ(inner->count, 20);
+  ASSERT_TRUE(inner->total_ns <= outer->total_ns);
+  ASSERT_TRUE(outer->self_ns + inner->total_ns <= outer->total_ns + 1000);
+  ASSERT_EQ(inner->self_ns, inner->total_ns);
+  ASSERT_TRUE(inner->min_ns <= inner->mean_ns && inner->mean_ns <= inner->max_ns);
+  ASSERT_TRUE(inner->min_ns <= inner->p99_ns && inner->p99_ns <= inner->max_ns);
+
+  x_profile_reset();
+  ASSERT_EQ(x_profile_stats(stats, 8), 0);
+
+  x_profile_shutdown();
+  return 0;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+static int32_t s_scoped(int32_t x)
+{
+  X_PROFILE_ZONE("scoped");
+  if (x > 0)
+    return x;
+  s_spin(10);
+  return 0;
+}
+
+int test_profile_scoped_zone(void)
+{
+  ASSERT_TRUE(x_profile_init(0));
+  s_scoped(1);
+  s_scoped(0);
+  XProfileStats stats[4];
+  size_t n = x_profile_stats(stats, 4);
+  ASSERT_EQ(n, 1);
+  ASSERT_EQ(stats[0].count, 2);
+  ASSERT_TRUE(strcmp(stats[0].name, "scoped") == 0);
+  x_profile_shutdown();
+  return 0;
+}
+#endif
+
+int test_profile_threads(void)
+{
+  ASSERT_TRUE(x_profile_init(16));
+  XThread* threads[WORKERS];
+  for (int32_t i = 0; i < WORKERS; i++)
+    ASSERT_EQ(x_thread_create(&threads[i], s_worker, NULL), 0);
+  for (int32_t i = 0; i < WORKERS; i++)
+  {
+    x_thread_join(threads[i]);
+    x_thread_destroy(threads[i]);
+  }
+
+  XProfileStats stats[8];
+  size_t n = x_profile_stats(stats, 8);
+  const XProfileStats* zone = s_find(stats, n, "worker zone");
+  ASSERT_TRUE(zone);
+  ASSERT_EQ(zone->count, WORKERS * ZONES_PER_WORKER);
+
+  // Each ring keeps only its 16 most recent zones
+  ASSERT_TRUE(x_profile_write_chrome_trace(TEMP_TRACE));
+  char* text = s_read_file(TEMP_TRACE);
+  ASSERT_TRUE(text);
+  ASSERT_TRUE(strncmp(text, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 39) == 0);
+  ASSERT_EQ(s_count(text, "\"ph\":\"X\""), WORKERS * 16);
+  ASSERT_EQ(s_count(text, "\"name\":\"worker\""), WORKERS);
+  free(text);
+  remove(TEMP_TRACE);
+
+  x_profile_shutdown();
+  return 0;
+}
+
+int test_profile_chrome_trace(void)
+{
+  ASSERT_TRUE(x_profile_init(X_PROFILE_DEFAULT_EVENTS));
+  x_profile_set_thread_name("main \"thread\"");
+  X_PROFILE_BEGIN("outer");
+  s_inner();
+  X_PROFILE_END();
+
+  ASSERT_TRUE(x_profile_write_chrome_trace(TEMP_TRACE));
+  char* text = s_read_file(TEMP_TRACE);
+  ASSERT_TRUE(text);
+  ASSERT_EQ(s_count(text, "\"ph\":\"X\""), 2);
+  ASSERT_EQ(s_count(text, "{\"name\":\"inner\",\"ph\":\"X\""), 1);
+  ASSERT_EQ(s_count(text, "{\"name\":\"outer\",\"ph\":\"X\""), 1);
+  ASSERT_TRUE(strstr(text, "\"args\":{\"name\":\"main \\\"thread\\\"\"}") != NULL);
+  ASSERT_TRUE(strcmp(text + strlen(text) - 4, "\n]}\n") == 0);
+  free(text);
+  remove(TEMP_TRACE);
+
+  x_profile_shutdown();
+  return 0;
+}
+
+int test_profile_threadpool(void)
+{
+  ASSERT_TRUE(x_profile_init(0));
+  XThreadPool* pool = x_threadpool_create(2);
+  ASSERT_TRUE(pool);
+  for (int32_t i = 0; i < 100; i++)
+    ASSERT_EQ(x_threadpool_enqueue(pool, s_task, NULL), 0);
+  x_threadpool_destroy(pool);
+
+  XProfileStats stats[8];
+  size_t n = x_profile_stats(stats, 8);
+  const XProfileStats* task = s_find(stats, n, "x_threadpool task");
+  ASSERT_TRUE(task);
+  ASSERT_EQ(task->count, 100);
+
+  x_profile_shutdown();
+  return 0;
+}
+
+int main()
+{
+  STDXTestCase tests[] =
+  {
+    X_TEST(test_profile_inactive),
+    X_TEST(test_profile_nesting),
+#if defined(__GNUC__) || defined(__clang__)
+    X_TEST(test_profile_scoped_zone),
+#endif
+    X_TEST(test_profile_threads),
+    X_TEST(test_profile_chrome_trace),
+    X_TEST(test_profile_threadpool),
+  };
+
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
+}
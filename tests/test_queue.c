@@ -0,0 +1,284 @@
+#define X_IMPL_TEST
+#include <stdx_test.h>
+#define X_IMPL_THREAD
+#include <stdx_thread.h>
+#define X_IMPL_QUEUE
+#include <stdx_queue.h>
+
+#include <stdint.h>
+
+X_QUEUE_TYPE(int)
+
+typedef struct
+{
+  uint32_t producer;
+  uint32_t seq;
+} QueueItem;
+
+int test_spsc_push_pop(void)
+{
+  XSpscQueue* q = x_spsc_queue_create(sizeof(int), 4);
+  ASSERT_TRUE(q != NULL);
+  ASSERT_EQ(x_spsc_queue_capacity(q), 4);
+
+  int v;
+  ASSERT_FALSE(x_spsc_queue_pop(q, &v));
+
+  for (int i = 0; i < 4; ++i)
+    ASSERT_TRUE(x_spsc_queue_push(q, &i));
+
+  int extra = 99;
+  ASSERT_FALSE(x_spsc_queue_push(q, &extra));
+  ASSERT_EQ(x_spsc_queue_count(q), 4);
+
+  for (int i = 0; i < 4; ++i)
+  {
+    ASSERT_TRUE(x_spsc_queue_pop(q, &v));
+    ASSERT_EQ(v, i);
+  }
+  ASSERT_FALSE(x_spsc_queue_pop(q, &v));
+  ASSERT_EQ(x_spsc_queue_count(q), 0);
+
+  x_spsc_queue_destroy(q);
+  return 0;
+}
+
+int test_spsc_wraparound(void)
+{
+  XSpscQueue* q = x_spsc_queue_create(sizeof(int), 3);
+  ASSERT_TRUE(q != NULL);
+  ASSERT_EQ(x_spsc_queue_capacity(q), 4);
+
+  int next_in = 0;
+  int next_out = 0;
+  for (int round = 0; round < 100; ++round)
+  {
+    for (int i = 0; i < 3; ++i, ++next_in)
+      ASSERT_TRUE(x_spsc_queue_push(q, &next_in));
+
+    for (int i = 0; i < 3; ++i, ++next_out)
+    {
+      int v;
+      ASSERT_TRUE(x_spsc_queue_pop(q, &v));
+      ASSERT_EQ(v, next_out);
+    }
+  }
+
+  x_spsc_queue_destroy(q);
+  return 0;
+}
+
+int test_queue_invalid_args(void)
+{
+  ASSERT_TRUE(x_spsc_queue_create(0, 8) == NULL);
+  ASSERT_TRUE(x_spsc_queue_create(4, 0) == NULL);
+  ASSERT_TRUE(x_mpmc_queue_create(0, 8) == NULL);
+  ASSERT_TRUE(x_mpmc_queue_create(4, 0) == NULL);
+  return 0;
+}
+
+int test_mpmc_push_pop(void)
+{
+  XMpmcQueue* q = x_mpmc_queue_create(sizeof(QueueItem), 8);
+  ASSERT_TRUE(q != NULL);
+  ASSERT_EQ(x_mpmc_queue_capacity(q), 8);
+
+  QueueItem item;
+  ASSERT_FALSE(x_mpmc_queue_pop(q, &item));
+
+  for (uint32_t i = 0; i < 8; ++i)
+  {
+    item.producer = 1;
+    item.seq = i;
+    ASSERT_TRUE(x_mpmc_queue_push(q, &item));
+  }
+  ASSERT_FALSE(x_mpmc_queue_push(q, &item));
+  ASSERT_EQ(x_mpmc_queue_count(q), 8);
+
+  for (uint32_t i = 0; i < 8; ++i)
+  {
+    ASSERT_TRUE(x_mpmc_queue_pop(q, &item));
+    ASSERT_EQ(item.seq, i);
+  }
+  ASSERT_FALSE(x_mpmc_queue_pop(q, &item));
+
+  x_mpmc_queue_destroy(q);
+  return 0;
+}
+
+int test_queue_typed_wrappers(void)
+{
+  XSpscQueue_int* s = x_spsc_queue_int_create(16);
+  XMpmcQueue_int* m = x_mpmc_queue_int_create(16);
+  ASSERT_TRUE(s != NULL && m != NULL);
+
+  ASSERT_TRUE(x_spsc_queue_int_push(s, 7));
+  ASSERT_TRUE(x_mpmc_queue_int_push(m, 11));
+  ASSERT_EQ(x_spsc_queue_int_count(s), 1);
+  ASSERT_EQ(x_mpmc_queue_int_count(m), 1);
+
+  int v = 0;
+  ASSERT_TRUE(x_spsc_queue_int_pop(s, &v));
+  ASSERT_EQ(v, 7);
+  ASSERT_TRUE(x_mpmc_queue_int_pop(m, &v));
+  ASSERT_EQ(v, 11);
+
+  x_spsc_queue_int_destroy(s);
+  x_mpmc_queue_int_destroy(m);
+  return 0;
+}
+
+#define SPSC_ITEMS 200000
+
+static void* spsc_producer(void* arg)
+{
+  XSpscQueue* q = (XSpscQueue*)arg;
+  for (uint32_t i = 0; i < SPSC_ITEMS; ++i)
+  {
+    while (!x_spsc_queue_push(q, &i))
+      x_thread_yield();
+  }
+  return NULL;
+}
+
+// Items must come out in order and without gaps
+int test_spsc_threaded(void)
+{
+  XSpscQueue* q = x_spsc_queue_create(sizeof(uint32_t), 64);
+  ASSERT_TRUE(q != NULL);
+
+  XThread* producer;
+  ASSERT_EQ(x_thread_create(&producer, spsc_producer, q), 0);
+
+  uint32_t expected = 0;
+  while (expected < SPSC_ITEMS)
+  {
+    uint32_t v;
+    if (!x_spsc_queue_pop(q, &v))
+    {
+      x_thread_yield();
+      continue;
+    }
+    ASSERT_EQ(v, expected);
+    expected++;
+  }
+
+  x_thread_join(producer);
+  x_thread_destroy(producer);
+  x_spsc_queue_destroy(q);
+  return 0;
+}
+
+#define MPMC_PRODUCERS 4
+#define MPMC_CONSUMERS 4
+#define MPMC_ITEMS_PER_PRODUCER 50000
+
+typedef struct
+{
+  XMpmcQueue* q;
+  uint32_t id;
+  volatile int32_t* consumed;
+  uint32_t last_seq[MPMC_PRODUCERS];
+  int64_t sum;
+  bool ordered;
+} MpmcWorker;
+
+static void* mpmc_producer(void* arg)
+{
+  MpmcWorker* w = (MpmcWorker*)arg;
+  for (uint32_t i = 1; i <= MPMC_ITEMS_PER_PRODUCER; ++i)
+  {
+    QueueItem item;
+    item.producer = w->id;
+    item.seq = i;
+    while (!x_mpmc_queue_push(w->q, &item))
+      x_thread_yield();
+  }
+  return NULL;
+}
+
+static void* mpmc_consumer(void* arg)
+{
+  MpmcWorker* w = (MpmcWorker*)arg;
+  while (x_atomic_load_i32(w->consumed) < MPMC_PRODUCERS * MPMC_ITEMS_PER_PRODUCER)
+  {
+    QueueItem item;
+    if (!x_mpmc_queue_pop(w->q, &item))
+    {
+      x_thread_yield();
+      continue;
+    }
+
+    // Items from one producer are seen in order by any single consumer
+    if (item.seq <= w->last_seq[item.producer])
+      w->ordered = false;
+    w->last_seq[item.producer] = item.seq;
+    w->sum += item.seq;
+    x_atomic_fetch_add_i32(w->consumed, 1);
+  }
+  return NULL;
+}
+
+int test_mpmc_threaded(void)
+{
+  XMpmcQueue* q = x_mpmc_queue_create(sizeof(QueueItem), 128);
+  ASSERT_TRUE(q != NULL);
+
+  volatile int32_t consumed = 0;
+  MpmcWorker producers[MPMC_PRODUCERS];
+  MpmcWorker consumers[MPMC_CONSUMERS];
+  XThread* threads[MPMC_PRODUCERS + MPMC_CONSUMERS];
+
+  for (uint32_t i = 0; i < MPMC_CONSUMERS; ++i)
+  {
+    memset(&consumers[i], 0, sizeof(consumers[i]));
+    consumers[i].q = q;
+    consumers[i].consumed = &consumed;
+    consumers[i].ordered = true;
+    ASSERT_EQ(x_thread_create(&threads[i], mpmc_consumer, &consumers[i]), 0);
+  }
+
+  for (uint32_t i = 0; i < MPMC_PRODUCERS; ++i)
+  {
+    memset(&producers[i], 0, sizeof(producers[i]));
+    producers[i].q = q;
+    producers[i].id = i;
+    ASSERT_EQ(x_thread_create(&threads[MPMC_CONSUMERS + i], mpmc_producer, &producers[i]), 0);
+  }
+
+  for (uint32_t i = 0; i < MPMC_PRODUCERS + MPMC_CONSUMERS; ++i)
+  {
+    x_thread_join(threads[i]);
+    x_thread_destroy(threads[i]);
+  }
+
+  int64_t total = 0;
+  for (uint32_t i = 0; i < MPMC_CONSUMERS; ++i)
+  {
+    ASSERT_TRUE(consumers[i].ordered);
+    total += consumers[i].sum;
+  }
+
+  int64_t per_producer = (int64_t)MPMC_ITEMS_PER_PRODUCER * (MPMC_ITEMS_PER_PRODUCER + 1) / 2;
+  ASSERT_EQ(total, per_producer * MPMC_PRODUCERS);
+  ASSERT_EQ(x_mpmc_queue_count(q), 0);
+
+  x_mpmc_queue_destroy(q);
+  return 0;
+}
+
+int main()
+{
+  STDXTestCase tests[] =
+  {
+    X_TEST(test_spsc_push_pop),
+    X_TEST(test_spsc_wraparound),
+    X_TEST(test_queue_invalid_args),
+    X_TEST(test_mpmc_push_pop),
+    X_TEST(test_queue_typed_wrappers),
+    X_TEST(test_spsc_threaded),
+    X_TEST(test_mpmc_threaded),
+  };
+
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
+}
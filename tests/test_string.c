@@ -702,6 +702,226 @@ int test_x_smallstr_try_append_cstr_null_input()
   return 0;
 }
 
+// Runs the find functions over every length and match position, with the
+// kernels of each feature level, against a plain loop
+static void s_reset_find_kernels(uint32_t mask)
+{
+  x_cpu_set_feature_mask(mask);
+  X_CPU_RESET(s_x_find_byte);
+  X_CPU_RESET(s_x_rfind_byte);
+  X_CPU_RESET(s_x_find_small);
+  X_CPU_RESET(s_x_find_nibble);
+  X_CPU_RESET(s_x_find_sub);
+}
+
+static int32_t s_ref_find_any(const char* p, size_t n, const char* set)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    if (p[i] && strchr(set, p[i])) return (int32_t)i;
+  }
+  return -1;
+}
+
+static int32_t s_ref_find_slice(const char* p, size_t n, const char* s, size_t m)
+{
+  for (size_t i = 0; i + m <= n; i++)
+  {
+    if (memcmp(p + i, s, m) == 0) return (int32_t)i;
+  }
+  return -1;
+}
+
+int test_x_slice_find_kernels(void)
+{
+  static const uint32_t masks[] = { 0xFFFFFFFFu, CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3, CPU_FEATURE_SSE2, 0 };
+  static const char* sets[] = { ",", "=;", " \t\r", "{}[]:,\"\\", "0123456789abcdefABCDEF\x80\xff", "\x01\x12\x23\x34\x45\x56\x67\x78\x89\x9a" };
+  char text[160];
+
+  for (size_t k = 0; k < sizeof(masks) / sizeof(masks[0]); k++)
+  {
+    s_reset_find_kernels(masks[k]);
+    for (size_t n = 0; n <= 100; n++)
+    {
+      for (size_t at = 0; at <= n; at++)
+      {
+        memset(text, 'x', sizeof(text));
+        if (at < n)
+        {
+          text[at] = '#';
+          memcpy(text + at, "#ab", at + 3 <= n ? 3 : n - at);
+        }
+        XSlice sv = { text, n };
+        int32_t expect = at < n ? (int32_t)at : -1;
+        ASSERT_EQ(x_slice_find(sv, '#'), expect);
+        ASSERT_EQ(x_slice_rfind(sv, '#'), expect);
+        ASSERT_EQ(x_slice_find_slice(sv, x_slice("#ab")), s_ref_find_slice(text, n, "#ab", 3));
+        ASSERT_EQ(x_slice_find_slice(sv, x_slice("#a")), s_ref_find_slice(text, n, "#a", 2));
+
+        if (at < n)
+          text[at] = '\t';
+        ASSERT_EQ(x_slice_find_white_space(sv), expect);
+
+        for (size_t s = 0; s < sizeof(sets) / sizeof(sets[0]); s++)
+        {
+          if (at < n)
+            text[at] = sets[s][strlen(sets[s]) - 1];
+          ASSERT_EQ(x_slice_find_any(sv, sets[s]), s_ref_find_any(text, n, sets[s]));
+        }
+      }
+    }
+  }
+  s_reset_find_kernels(0xFFFFFFFFu);
+  return 0;
+}
+
+int test_x_slice_find_any_and_slice(void)
+{
+  XSlice sv = x_slice("key = value; other=1");
+  ASSERT_EQ(x_slice_find_any(sv, "=;"), 4);
+  ASSERT_EQ(x_slice_find_any(sv, "!?"), -1);
+  ASSERT_EQ(x_slice_find_any(sv, ""), -1);
+  ASSERT_EQ(x_slice_find_slice(sv, x_slice("other")), 13);
+  ASSERT_EQ(x_slice_find_slice(sv, x_slice("otter")), -1);
+  ASSERT_EQ(x_slice_find_slice(sv, x_slice("")), 0);
+  ASSERT_EQ(x_slice_find_slice(x_slice("ab"), x_slice("abc")), -1);
+
+  // Repeated near-matches across vector boundaries
+  const char* hay = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab";
+  ASSERT_EQ(x_slice_find_slice(x_slice_from_cstr(hay), x_slice("aaab")), (int32_t)strlen(hay) - 4);
+  ASSERT_EQ(x_slice_find_slice(x_slice_from_cstr(hay), x_slice("aaac")), -1);
+  return 0;
+}
+
+static void s_reset_utf8_kernels(uint32_t mask)
+{
+  x_cpu_set_feature_mask(mask);
+  X_CPU_RESET(s_x_utf8_validate);
+  X_CPU_RESET(s_x_utf8_count);
+  X_CPU_RESET(s_x_ascii_widen);
+  X_CPU_RESET(s_x_ascii_narrow);
+}
+
+// Every lead byte followed by bytes from each nibble class, at offsets
+// around the 16 and 32 byte block edges, cut at every length
+int test_utf8_validate_kernels(void)
+{
+  static const uint32_t masks[] = { 0xFFFFFFFFu, CPU_FEATURE_SSE2 | CPU_FEATURE_SSSE3, CPU_FEATURE_SSE2, 0 };
+  static const uint8_t follow[] = { 0x00, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0, 0xBF, 0xC0, 0xFF };
+  static const size_t offsets[] = { 0, 13, 14, 15, 29, 30, 31, 44 };
+  char buf[64];
+
+  for (size_t k = 0; k < sizeof(masks) / sizeof(masks[0]); k++)
+  {
+    s_reset_utf8_kernels(masks[k]);
+    for (int32_t lead = 0x80; lead < 0x100; lead++)
+    {
+      for (size_t a = 0; a < sizeof(follow); a++)
+      {
+        for (size_t b = 0; b < sizeof(follow); b++)
+        {
+          for (size_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++)
+          {
+            size_t at = offsets[o];
+            memset(buf, 'a', sizeof(buf));
+            buf[at] = (char)lead;
+            buf[at + 1] = (char)follow[a];
+            buf[at + 2] = (char)follow[b];
+            buf[at + 3] = (char)follow[(a + b) % sizeof(follow)];
+            for (size_t n = at + 1; n <= at + 5; n++)
+              ASSERT_EQ(x_utf8_validate(buf, n, NULL), s_x_utf8_validate_scalar(buf, n));
+            ASSERT_EQ(x_utf8_validate(buf, sizeof(buf), NULL), s_x_utf8_validate_scalar(buf, sizeof(buf)));
+          }
+        }
+      }
+    }
+  }
+  s_reset_utf8_kernels(0xFFFFFFFFu);
+  return 0;
+}
+
+int test_utf8_validate(void)
+{
+  size_t valid = 0;
+  const char* mixed = "plain ascii, then \xC3\xA9t\xC3\xA9, \xE2\x82\xAC and \xF0\x9F\x98\x80 in a longer run of text";
+  ASSERT_TRUE(x_utf8_validate(mixed, strlen(mixed), &valid));
+  ASSERT_EQ(valid, strlen(mixed));
+  ASSERT_TRUE(x_utf8_validate("", 0, NULL));
+  ASSERT_TRUE(x_slice_utf8_is_valid(x_slice("\xE4\xB8\xAD\xE6\x96\x87")));
+
+  // Overlong, surrogate, out of range, stray continuation, truncated
+  const char* bad[] = { "\xC0\xAF", "\xE0\x80\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\x80", "\xE2\x82" };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+  {
+    char buf[80];
+    size_t n = (size_t)snprintf(buf, sizeof(buf), "0123456789abcdefghij%sklmnopqrstuvwxyz0123456789", bad[i]);
+    ASSERT_FALSE(x_utf8_validate(buf, n, &valid));
+    ASSERT_EQ(valid, 20);
+    ASSERT_FALSE(x_utf8_validate(bad[i], strlen(bad[i]), &valid));
+    ASSERT_EQ(valid, 0);
+  }
+  return 0;
+}
+
+int test_utf8_count(void)
+{
+  char buf[4096];
+  size_t n = 0, cps = 0;
+  static const char* pieces[] = { "a", "\xC3\xA9", "\xE2\x82\xAC", "\xF0\x9F\x98\x80", "text " };
+  static const size_t counts[] = { 1, 1, 1, 1, 5 };
+  for (int32_t i = 0; n + 8 < sizeof(buf); i++)
+  {
+    size_t len = strlen(pieces[i % 5]);
+    memcpy(buf + n, pieces[i % 5], len);
+    n += len;
+    cps += counts[i % 5];
+    ASSERT_EQ(x_utf8_count(buf, n), cps);
+  }
+  buf[n] = 0;
+  ASSERT_EQ(x_utf8_strlen(buf), cps);
+  ASSERT_TRUE(x_utf8_is_ascii("only ascii here, nothing else", 29));
+  ASSERT_FALSE(x_utf8_is_ascii(buf, n));
+  return 0;
+}
+
+int test_utf8_utf16_conversion(void)
+{
+  static const uint32_t masks[] = { 0xFFFFFFFFu, 0 };
+  char utf8[512];
+  char back[512];
+  uint16_t utf16[512];
+
+  for (size_t k = 0; k < sizeof(masks) / sizeof(masks[0]); k++)
+  {
+    s_reset_utf8_kernels(masks[k]);
+
+    // Long ASCII runs around multibyte codepoints
+    size_t n = (size_t)snprintf(utf8, sizeof(utf8),
+        "C:/Users/someone/Documents/projects/r\xC3\xA9sum\xC3\xA9/\xE2\x82\xAC/\xF0\x9F\x98\x80/a/rather/long/ascii/tail/file.txt");
+    ASSERT_EQ(x_utf8_to_utf16(utf8, n, NULL, 0), n - 6);
+    size_t units = x_utf8_to_utf16(utf8, n, utf16, 512);
+    ASSERT_EQ(units, n - 6);
+    ASSERT_EQ(utf16[0], 'C');
+    ASSERT_EQ(utf16[units], 0);
+    ASSERT_EQ(x_utf16_to_utf8(utf16, units, NULL, 0), n);
+    ASSERT_EQ(x_utf16_to_utf8(utf16, units, back, sizeof(back)), n);
+    ASSERT_TRUE(strcmp(back, utf8) == 0);
+
+    // Truncation keeps whole codepoints and the terminator
+    ASSERT_EQ(x_utf8_to_utf16("ab\xF0\x9F\x98\x80", 6, utf16, 4), 2);
+    ASSERT_EQ(utf16[2], 0);
+    ASSERT_EQ(x_utf16_to_utf8(utf16, 2, back, 2), 1);
+    ASSERT_TRUE(strcmp(back, "a") == 0);
+
+    // Invalid input
+    ASSERT_EQ(x_utf8_to_utf16("a\xC0\xAF" "b", 4, utf16, 16), (size_t)-1);
+    uint16_t lone[] = { 'a', 0xD800, 'b' };
+    ASSERT_EQ(x_utf16_to_utf8(lone, 3, back, sizeof(back)), (size_t)-1);
+  }
+  s_reset_utf8_kernels(0xFFFFFFFFu);
+  return 0;
+}
+
 int main()
 {
   x_set_locale(NULL);
@@ -746,6 +966,12 @@ int main()
     X_TEST(test_x_slice_substr),
     X_TEST(test_x_slice_trim),
     X_TEST(test_x_slice_find_and_rfind),
+    X_TEST(test_x_slice_find_kernels),
+    X_TEST(test_x_slice_find_any_and_slice),
+    X_TEST(test_utf8_validate_kernels),
+    X_TEST(test_utf8_validate),
+    X_TEST(test_utf8_count),
+    X_TEST(test_utf8_utf16_conversion),
     X_TEST(test_x_slice_split_at),
     X_TEST(test_x_wslice_next_token),
 
@@ -124,6 +124,150 @@ int test_x_wstrbuilder_format(void)
   return 0;
 }
 
+int test_strbuilder_append_numbers(void)
+{
+  XStrBuilder* sb = x_strbuilder_create();
+  x_strbuilder_append_i64(sb, 0);
+  x_strbuilder_append_char(sb, ' ');
+  x_strbuilder_append_i64(sb, -42);
+  x_strbuilder_append_char(sb, ' ');
+  x_strbuilder_append_i64(sb, INT64_MIN);
+  x_strbuilder_append_char(sb, ' ');
+  x_strbuilder_append_u64(sb, UINT64_MAX);
+  ASSERT_EQ(strcmp(x_strbuilder_to_string(sb), "0 -42 -9223372036854775808 18446744073709551615"), 0);
+
+  x_strbuilder_clear(sb);
+  x_strbuilder_append_f64(sb, 0.1);
+  x_strbuilder_append_char(sb, ' ');
+  x_strbuilder_append_f64(sb, -2.5);
+  x_strbuilder_append_char(sb, ' ');
+  x_strbuilder_append_f64(sb, 1024.0);
+  x_strbuilder_append_char(sb, ' ');
+  x_strbuilder_append_f64(sb, -0.0);
+  x_strbuilder_append_char(sb, ' ');
+  x_strbuilder_append_f64(sb, 1e300);
+  ASSERT_EQ(strcmp(x_strbuilder_to_string(sb), "0.1 -2.5 1024 -0 1e+300"), 0);
+
+  // Values needing 17 digits still round-trip
+  double values[] = { 1.0 / 3.0, 0.1 + 0.2, 5e-324, 1.7976931348623157e308 };
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++)
+  {
+    x_strbuilder_clear(sb);
+    x_strbuilder_append_f64(sb, values[i]);
+    ASSERT_TRUE(strtod(x_strbuilder_to_string(sb), NULL) == values[i]);
+  }
+
+  x_strbuilder_destroy(sb);
+  return 0;
+}
+
+int test_strbuilder_append_slices(void)
+{
+  XStrBuilder* sb = x_strbuilder_create();
+  XSlice parts[3];
+  parts[0] = x_slice("<li>");
+  parts[1] = x_slice("item");
+  parts[2] = x_slice("</li>");
+
+  for (int i = 0; i < 10; i++)
+    x_strbuilder_append_slices(sb, parts, 3);
+
+  ASSERT_EQ(x_strbuilder_length(sb), 130);
+  ASSERT_EQ(strncmp(x_strbuilder_to_string(sb), "<li>item</li><li>", 17), 0);
+  x_strbuilder_destroy(sb);
+  return 0;
+}
+
+int test_strbuilder_reserve_and_direct_write(void)
+{
+  XStrBuilder* sb = x_strbuilder_create();
+  ASSERT_TRUE(x_strbuilder_reserve(sb, 1000));
+  char* before = x_strbuilder_to_string(sb);
+  for (int i = 0; i < 100; i++)
+    x_strbuilder_append(sb, "0123456789");
+  ASSERT_TRUE(x_strbuilder_to_string(sb) == before);
+
+  x_strbuilder_clear(sb);
+  x_strbuilder_append(sb, "id=");
+  char* dst = x_strbuilder_begin_write(sb, 8);
+  ASSERT_TRUE(dst != NULL);
+  memcpy(dst, "abc", 3);
+  x_strbuilder_commit(sb, 3);
+  ASSERT_EQ(strcmp(x_strbuilder_to_string(sb), "id=abc"), 0);
+  ASSERT_EQ(x_strbuilder_length(sb), 6);
+
+  // A format longer than the spare capacity still comes out whole
+  x_strbuilder_clear(sb);
+  x_strbuilder_append_format(sb, "%s-%d", "a fairly long prefix that will not fit in place", 7);
+  ASSERT_EQ(strcmp(x_strbuilder_to_string(sb), "a fairly long prefix that will not fit in place-7"), 0);
+  x_strbuilder_destroy(sb);
+  return 0;
+}
+
+int test_strbuilder_segments(void)
+{
+  static const char big[] =
+    "<html><head><title>a literal long enough to be referenced, not copied</title></head>";
+  size_t big_len = sizeof(big) - 1;
+
+  XStrBuilder* sb = x_strbuilder_create();
+  ASSERT_EQ(x_strbuilder_segment_count(sb), 0);
+
+  x_strbuilder_append(sb, "A");
+  x_strbuilder_append_ref(sb, big, big_len);
+  x_strbuilder_append(sb, "B");
+  x_strbuilder_append_ref(sb, big, big_len);
+  x_strbuilder_append_ref(sb, "tiny", 4);   // copied, below X_STRBUILDER_REF_MIN
+  ASSERT_EQ(x_strbuilder_length(sb), 2 * big_len + 6);
+  ASSERT_EQ(x_strbuilder_segment_count(sb), 5);
+
+  XSlice parts[8];
+  ASSERT_EQ(x_strbuilder_gather(sb, 0, parts, 8), 5);
+  ASSERT_EQ(strncmp(parts[0].ptr, "A", 1), 0);
+  ASSERT_TRUE(parts[1].ptr == big);
+  ASSERT_EQ(strncmp(parts[2].ptr, "B", 1), 0);
+  ASSERT_TRUE(parts[3].ptr == big);
+
+  // Partial gathers resume where they stopped, including the trailing owned run
+  ASSERT_EQ(x_strbuilder_gather(sb, 3, parts, 1), 1);
+  ASSERT_TRUE(parts[0].ptr == big);
+  ASSERT_EQ(x_strbuilder_gather(sb, 4, parts, 8), 1);
+  ASSERT_EQ(parts[0].length, 4);
+  ASSERT_EQ(strncmp(parts[0].ptr, "tiny", 4), 0);
+  ASSERT_EQ(x_strbuilder_gather(sb, 5, parts, 8), 0);
+
+  const char* flat = x_strbuilder_to_string(sb);
+  ASSERT_EQ(strlen(flat), 2 * big_len + 6);
+  ASSERT_EQ(strncmp(flat, "A<html>", 7), 0);
+  ASSERT_EQ(strcmp(flat + strlen(flat) - 11, "</head>tiny"), 0);
+  ASSERT_EQ(x_strbuilder_segment_count(sb), 1);
+
+  x_strbuilder_clear(sb);
+  ASSERT_EQ(x_strbuilder_length(sb), 0);
+  ASSERT_EQ(x_strbuilder_segment_count(sb), 0);
+  x_strbuilder_destroy(sb);
+  return 0;
+}
+
+int test_strbuilder_custom_allocator(void)
+{
+  XTestAllocStats st = {0, 0};
+  XAllocator a = x_test_allocator(&st);
+
+  XStrBuilder* sb = x_strbuilder_create_with_allocator(&a);
+  ASSERT_TRUE(sb != NULL);
+  for (int i = 0; i < 100; i++)
+  {
+    x_strbuilder_append_format(sb, "%d,", i);
+  }
+  ASSERT_TRUE(strncmp(x_strbuilder_to_string(sb), "0,1,2,", 6) == 0);
+  ASSERT_TRUE(st.allocs > 2);
+
+  x_strbuilder_destroy(sb);
+  ASSERT_EQ(st.live, 0);
+  return 0;
+}
+
 int main()
 {
   STDXTestCase tests[] = {
@@ -136,6 +280,11 @@ int main()
     X_TEST(test_strbuilder_utf8_charlen_emoji),
     X_TEST(test_x_wstrbuilder_format),
     X_TEST(test_x_wstrbuilder_basic),
+    X_TEST(test_strbuilder_custom_allocator),
+    X_TEST(test_strbuilder_append_numbers),
+    X_TEST(test_strbuilder_append_slices),
+    X_TEST(test_strbuilder_reserve_and_direct_write),
+    X_TEST(test_strbuilder_segments),
   };
 
   return x_tests_run(tests, sizeof(tests) / sizeof(tests[0]), NULL);
@@ -2,6 +2,8 @@
 #include <stdx_test.h>
 #define X_IMPL_THREAD
 #include <stdx_thread.h>
+#define X_IMPL_CPUID
+#include <stdx_cpuid.h>
 
 // Threading globals
 XMutex* lock_a;
@@ -58,11 +60,62 @@ int test_producer_consumer(void)
   return 0;
 }
 
+static void* pinned_thread(void* arg)
+{
+  int32_t cpu = *(int32_t*)arg;
+  XCPUSet set;
+  x_cpuset_clear(&set);
+  x_cpuset_add(&set, cpu);
+  if (!x_thread_set_affinity(&set))
+    return NULL;
+  *(int32_t*)arg = x_thread_current_cpu();
+  return arg;
+}
+
+int test_thread_affinity(void)
+{
+  XCPUSet allowed;
+  if (!x_thread_get_affinity(&allowed))
+    return 0;   // not supported on this platform
+
+  int32_t current = x_thread_current_cpu();
+  ASSERT_TRUE(x_cpuset_count(&allowed) > 0);
+  ASSERT_TRUE(current < 0 || x_cpuset_has(&allowed, current));
+
+  // A thread pinned to the last allowed CPU runs there
+  int32_t last = -1;
+  for (int32_t cpu = x_cpuset_next(&allowed, -1); cpu >= 0; cpu = x_cpuset_next(&allowed, cpu))
+    last = cpu;
+  int32_t where = last;
+  XThread* t;
+  x_thread_create(&t, pinned_thread, &where);
+  x_thread_join(t);
+  x_thread_destroy(t);
+  ASSERT_TRUE(where == last);
+
+  // Pinning the calling thread and restoring it
+  XCPUSet one;
+  x_cpuset_clear(&one);
+  x_cpuset_add(&one, last);
+  ASSERT_TRUE(x_thread_set_affinity(&one));
+  XCPUSet now;
+  ASSERT_TRUE(x_thread_get_affinity(&now));
+  ASSERT_EQ(x_cpuset_count(&now), 1);
+  ASSERT_TRUE(x_cpuset_has(&now, last));
+  ASSERT_TRUE(x_thread_set_affinity(&allowed));
+
+  XCPUSet empty;
+  x_cpuset_clear(&empty);
+  ASSERT_FALSE(x_thread_set_affinity(&empty));
+  return 0;
+}
+
 int main()
 {
   STDXTestCase tests[] =
   {
     X_TEST(test_producer_consumer),
+    X_TEST(test_thread_affinity),
   };
 
   return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
@@ -4,6 +4,7 @@
 #define X_IMPL_THREAD
 #include <stdx_thread.h>
 #include <stdx_log.h>
+#include <string.h>
 
 #define NUM_TASKS 100
 
@@ -54,6 +55,346 @@ int test_threadpool_execution(void)
   return 0;
 }
 
+int test_threadpool_work_stealing_execution(void)
+{
+  completed_tasks = 0;
+
+  XThreadPool* pool = x_threadpool_create_ex(4, XTHREADPOOL_MODE_WORK_STEALING);
+  ASSERT_TRUE(pool != NULL);
+
+  int args[NUM_TASKS];
+  for (int i = 0; i < NUM_TASKS; ++i)
+  {
+    args[i] = i;
+    ASSERT_TRUE(x_threadpool_enqueue(pool, print_task, &args[i]) == 0);
+  }
+
+  x_thread_mutex_lock(count_lock);
+  while (completed_tasks < NUM_TASKS)
+    x_thread_condvar_wait(count_cv, count_lock);
+  x_thread_mutex_unlock(count_lock);
+
+  ASSERT_TRUE(completed_tasks == NUM_TASKS);
+
+  x_threadpool_destroy(pool);
+  return 0;
+}
+
+#define SPAWN_DEPTH 12
+
+typedef struct
+{
+  XThreadPool* pool;
+  volatile int32_t leaves;
+} SpawnCtx;
+
+static SpawnCtx spawn_ctx;
+static int spawn_depths[SPAWN_DEPTH + 1];
+
+// Every task below the maximum depth enqueues two children from inside a
+// worker, so the work-stealing pool has to balance them across deques.
+static void spawn_task(void* arg)
+{
+  int depth = *(int*)arg;
+  if (depth == SPAWN_DEPTH)
+  {
+    x_atomic_fetch_add_i32(&spawn_ctx.leaves, 1);
+    return;
+  }
+
+  x_threadpool_enqueue(spawn_ctx.pool, spawn_task, &spawn_depths[depth + 1]);
+  x_threadpool_enqueue(spawn_ctx.pool, spawn_task, &spawn_depths[depth + 1]);
+}
+
+int test_threadpool_work_stealing_nested(void)
+{
+  for (int i = 0; i <= SPAWN_DEPTH; ++i)
+    spawn_depths[i] = i;
+
+  spawn_ctx.leaves = 0;
+  spawn_ctx.pool = x_threadpool_create_ex(4, XTHREADPOOL_MODE_WORK_STEALING);
+  ASSERT_TRUE(spawn_ctx.pool != NULL);
+
+  ASSERT_TRUE(x_threadpool_enqueue(spawn_ctx.pool, spawn_task, &spawn_depths[0]) == 0);
+
+  while (x_atomic_load_i32(&spawn_ctx.leaves) < (1 << SPAWN_DEPTH))
+    x_thread_sleep_ms(1);
+
+  ASSERT_EQ(x_atomic_load_i32(&spawn_ctx.leaves), (1 << SPAWN_DEPTH));
+
+  x_threadpool_destroy(spawn_ctx.pool);
+  return 0;
+}
+
+int test_threadpool_work_stealing_destroy_drains(void)
+{
+  completed_tasks = 0;
+
+  XThreadPool* pool = x_threadpool_create_ex(2, XTHREADPOOL_MODE_WORK_STEALING);
+  ASSERT_TRUE(pool != NULL);
+
+  int args[NUM_TASKS];
+  for (int i = 0; i < NUM_TASKS; ++i)
+  {
+    args[i] = i;
+    ASSERT_TRUE(x_threadpool_enqueue(pool, print_task, &args[i]) == 0);
+  }
+
+  // Destroy must run every queued task before joining the workers
+  x_threadpool_destroy(pool);
+  ASSERT_EQ(completed_tasks, NUM_TASKS);
+  return 0;
+}
+
+#define INTRUSIVE_TASKS 64
+
+typedef struct
+{
+  XTask task;       // Embedded node, no allocation on submit
+  int value;
+  int result;
+} SquareJob;
+
+static volatile int32_t intrusive_done;
+
+static void square_job(void* arg)
+{
+  SquareJob* job = (SquareJob*)arg;
+  job->result = job->value * job->value;
+  x_atomic_fetch_add_i32(&intrusive_done, 1);
+}
+
+static int run_intrusive_jobs(XThreadPool* pool)
+{
+  SquareJob jobs[INTRUSIVE_TASKS];
+  intrusive_done = 0;
+
+  for (int i = 0; i < INTRUSIVE_TASKS; ++i)
+  {
+    jobs[i].value = i;
+    jobs[i].result = -1;
+    x_task_init(&jobs[i].task, square_job, &jobs[i]);
+    ASSERT_TRUE(x_threadpool_submit(pool, &jobs[i].task) == 0);
+  }
+
+  while (x_atomic_load_i32(&intrusive_done) < INTRUSIVE_TASKS)
+    x_thread_sleep_ms(1);
+
+  for (int i = 0; i < INTRUSIVE_TASKS; ++i)
+    ASSERT_EQ(jobs[i].result, i * i);
+
+  return 0;
+}
+
+int test_threadpool_submit_intrusive(void)
+{
+  XThreadPool* pool = x_threadpool_create(4);
+  ASSERT_TRUE(pool != NULL);
+  ASSERT_EQ(run_intrusive_jobs(pool), 0);
+  x_threadpool_destroy(pool);
+
+  pool = x_threadpool_create_ex(4, XTHREADPOOL_MODE_WORK_STEALING);
+  ASSERT_TRUE(pool != NULL);
+  ASSERT_EQ(run_intrusive_jobs(pool), 0);
+  x_threadpool_destroy(pool);
+  return 0;
+}
+
+int test_threadpool_submit_invalid(void)
+{
+  XThreadPool* pool = x_threadpool_create(1);
+  ASSERT_TRUE(pool != NULL);
+
+  XTask task;
+  x_task_init(&task, NULL, NULL);
+  ASSERT_TRUE(x_threadpool_submit(pool, &task) != 0);
+  ASSERT_TRUE(x_threadpool_submit(pool, NULL) != 0);
+
+  x_threadpool_destroy(pool);
+  return 0;
+}
+
+#define RECYCLE_TASKS 20000
+
+static volatile int32_t recycle_done;
+
+static void recycle_task(void* arg)
+{
+  X_UNUSED(arg);
+  x_atomic_fetch_add_i32(&recycle_done, 1);
+}
+
+// Far more tasks than X_THREADPOOL_TASK_BLOCK, so nodes must be recycled
+int test_threadpool_task_recycling(void)
+{
+  XThreadPoolMode modes[] = { XTHREADPOOL_MODE_SHARED_QUEUE, XTHREADPOOL_MODE_WORK_STEALING };
+  for (int m = 0; m < 2; ++m)
+  {
+    recycle_done = 0;
+    XThreadPool* pool = x_threadpool_create_ex(4, modes[m]);
+    ASSERT_TRUE(pool != NULL);
+
+    for (int i = 0; i < RECYCLE_TASKS; ++i)
+      ASSERT_TRUE(x_threadpool_enqueue(pool, recycle_task, NULL) == 0);
+
+    x_threadpool_destroy(pool);
+    ASSERT_EQ(recycle_done, RECYCLE_TASKS);
+  }
+  return 0;
+}
+
+static volatile int32_t group_counter;
+
+static void group_task(void* arg)
+{
+  X_UNUSED(arg);
+  x_atomic_fetch_add_i32(&group_counter, 1);
+}
+
+int test_taskgroup_wait(void)
+{
+  XThreadPoolMode modes[] = { XTHREADPOOL_MODE_SHARED_QUEUE, XTHREADPOOL_MODE_WORK_STEALING };
+  for (int m = 0; m < 2; ++m)
+  {
+    XThreadPool* pool = x_threadpool_create_ex(4, modes[m]);
+    ASSERT_TRUE(pool != NULL);
+
+    for (int round = 0; round < 10; ++round)
+    {
+      XTaskGroup group;
+      x_taskgroup_init(&group, pool);
+      group_counter = 0;
+
+      for (int i = 0; i < NUM_TASKS; ++i)
+        ASSERT_TRUE(x_taskgroup_run(&group, group_task, NULL) == 0);
+
+      x_taskgroup_wait(&group);
+      ASSERT_EQ(x_atomic_load_i32(&group_counter), NUM_TASKS);
+    }
+
+    x_threadpool_destroy(pool);
+  }
+  return 0;
+}
+
+typedef struct
+{
+  XThreadPool* pool;
+  volatile int32_t inner_done;
+} NestedCtx;
+
+// Each outer task fans out and joins on its own group from inside a worker
+static void nested_outer_task(void* arg)
+{
+  NestedCtx* ctx = (NestedCtx*)arg;
+  XTaskGroup inner;
+  x_taskgroup_init(&inner, ctx->pool);
+  for (int i = 0; i < 8; ++i)
+    x_taskgroup_run(&inner, group_task, NULL);
+  x_taskgroup_wait(&inner);
+  x_atomic_fetch_add_i32(&ctx->inner_done, 1);
+}
+
+int test_taskgroup_nested_wait(void)
+{
+  XThreadPoolMode modes[] = { XTHREADPOOL_MODE_SHARED_QUEUE, XTHREADPOOL_MODE_WORK_STEALING };
+  for (int m = 0; m < 2; ++m)
+  {
+    NestedCtx ctx;
+    ctx.pool = x_threadpool_create_ex(2, modes[m]);
+    ctx.inner_done = 0;
+    ASSERT_TRUE(ctx.pool != NULL);
+    group_counter = 0;
+
+    // More blocked outer tasks than workers: waiters must help, not block
+    XTaskGroup outer;
+    x_taskgroup_init(&outer, ctx.pool);
+    for (int i = 0; i < 16; ++i)
+      ASSERT_TRUE(x_taskgroup_run(&outer, nested_outer_task, &ctx) == 0);
+    x_taskgroup_wait(&outer);
+
+    ASSERT_EQ(x_atomic_load_i32(&ctx.inner_done), 16);
+    ASSERT_EQ(x_atomic_load_i32(&group_counter), 16 * 8);
+    x_threadpool_destroy(ctx.pool);
+  }
+  return 0;
+}
+
+int test_taskgroup_submit_intrusive(void)
+{
+  XThreadPool* pool = x_threadpool_create_ex(4, XTHREADPOOL_MODE_WORK_STEALING);
+  ASSERT_TRUE(pool != NULL);
+
+  SquareJob jobs[INTRUSIVE_TASKS];
+  XTaskGroup group;
+  x_taskgroup_init(&group, pool);
+  intrusive_done = 0;
+
+  for (int i = 0; i < INTRUSIVE_TASKS; ++i)
+  {
+    jobs[i].value = i;
+    jobs[i].result = -1;
+    x_task_init(&jobs[i].task, square_job, &jobs[i]);
+    ASSERT_TRUE(x_taskgroup_submit(&group, &jobs[i].task) == 0);
+  }
+  x_taskgroup_wait(&group);
+
+  for (int i = 0; i < INTRUSIVE_TASKS; ++i)
+    ASSERT_EQ(jobs[i].result, i * i);
+
+  x_threadpool_destroy(pool);
+  return 0;
+}
+
+#define PARALLEL_FOR_COUNT 100000
+
+static int32_t parallel_for_hits[PARALLEL_FOR_COUNT];
+
+static void parallel_for_body(int64_t begin, int64_t end, void* ctx)
+{
+  volatile int64_t* sum = (volatile int64_t*)ctx;
+  int64_t local = 0;
+  for (int64_t i = begin; i < end; ++i)
+  {
+    parallel_for_hits[i]++;
+    local += i;
+  }
+  x_atomic_fetch_add_i64(sum, local);
+}
+
+int test_threadpool_parallel_for(void)
+{
+  XThreadPoolMode modes[] = { XTHREADPOOL_MODE_SHARED_QUEUE, XTHREADPOOL_MODE_WORK_STEALING };
+  int64_t grains[] = { 0, 1, 333, PARALLEL_FOR_COUNT * 2 };
+  int64_t expected = (int64_t)PARALLEL_FOR_COUNT * (PARALLEL_FOR_COUNT - 1) / 2;
+
+  for (int m = 0; m < 2; ++m)
+  {
+    XThreadPool* pool = x_threadpool_create_ex(4, modes[m]);
+    ASSERT_TRUE(pool != NULL);
+
+    for (int g = 0; g < 4; ++g)
+    {
+      volatile int64_t sum = 0;
+      memset(parallel_for_hits, 0, sizeof(parallel_for_hits));
+      ASSERT_TRUE(x_threadpool_parallel_for(pool, 0, PARALLEL_FOR_COUNT, grains[g], parallel_for_body, (void*)&sum) == 0);
+      ASSERT_EQ(sum, expected);
+
+      // Every index is visited exactly once
+      for (int i = 0; i < PARALLEL_FOR_COUNT; ++i)
+        ASSERT_EQ(parallel_for_hits[i], 1);
+    }
+
+    // Empty range is a no-op
+    volatile int64_t sum = 0;
+    ASSERT_TRUE(x_threadpool_parallel_for(pool, 10, 10, 0, parallel_for_body, (void*)&sum) == 0);
+    ASSERT_EQ(sum, 0);
+
+    x_threadpool_destroy(pool);
+  }
+  return 0;
+}
+
 int test_enqueue_after_destroy(void)
 {
   XThreadPool* pool = x_threadpool_create(2);
@@ -74,6 +415,16 @@ int main()
   STDXTestCase tests[] =
   {
     X_TEST(test_threadpool_execution),
+    X_TEST(test_threadpool_work_stealing_execution),
+    X_TEST(test_threadpool_work_stealing_nested),
+    X_TEST(test_threadpool_work_stealing_destroy_drains),
+    X_TEST(test_threadpool_submit_intrusive),
+    X_TEST(test_threadpool_submit_invalid),
+    X_TEST(test_threadpool_task_recycling),
+    X_TEST(test_taskgroup_wait),
+    X_TEST(test_taskgroup_nested_wait),
+    X_TEST(test_taskgroup_submit_intrusive),
+    X_TEST(test_threadpool_parallel_for),
     X_TEST(test_enqueue_after_destroy),
   };
 
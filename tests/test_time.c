@@ -66,6 +66,52 @@ int test_time_now()
   return 0;
 }
 
+int test_time_ns()
+{
+  int64_t now_ns = x_time_now_ns();
+  double now = x_time_now().seconds;
+  ASSERT_TRUE(now_ns / 1000000000ll > 1600000000);
+  ASSERT_TRUE(now - now_ns / 1e9 < 1.0 && now_ns / 1e9 - now < 1.0);
+
+  ASSERT_EQ(x_time_to_ns((XTime){ .seconds = 1.5 }), 1500000000ll);
+  ASSERT_EQ(x_time_to_ns((XTime){ .seconds = -0.25 }), -250000000ll);
+  ASSERT_TRUE(x_time_from_ns(2500000000ll).seconds == 2.5);
+
+  uint64_t a = x_time_monotonic_ns();
+  x_time_sleep((XTime){ .seconds = 0.02 });
+  uint64_t b = x_time_monotonic_ns();
+  ASSERT_TRUE(b - a >= 18000000u);
+  return 0;
+}
+
+int test_ticks()
+{
+  uint64_t f = x_ticks_frequency();
+  ASSERT_TRUE(f >= 1000000u);
+  ASSERT_EQ(x_ticks_to_ns(f), 1000000000u);
+  ASSERT_EQ(x_ticks_to_ns(3 * f), 3000000000u);
+  ASSERT_EQ(x_ticks_from_ns(2000000000u), 2 * f);
+  ASSERT_TRUE(x_ticks_source() == X_TICKS_OS || x_ticks_source() == X_TICKS_TSC || x_ticks_source() == X_TICKS_CNTVCT);
+
+  // Ticks measure the same interval as the OS clock
+  uint64_t t0 = x_ticks_now();
+  uint64_t n0 = x_time_monotonic_ns();
+  x_time_sleep((XTime){ .seconds = 0.05 });
+  uint64_t t1 = x_ticks_now();
+  uint64_t n1 = x_time_monotonic_ns();
+  ASSERT_TRUE(t1 > t0);
+  int64_t error = (int64_t)x_ticks_to_ns(t1 - t0) - (int64_t)(n1 - n0);
+  ASSERT_TRUE(error < 1000000 && error > -1000000);
+
+  for (int32_t i = 0; i < 1000; i++)
+  {
+    uint64_t t = x_ticks_now();
+    ASSERT_TRUE(t >= t1);
+    t1 = t;
+  }
+  return 0;
+}
+
 int main()
 {
   STDXTestCase tests[] =
@@ -75,7 +121,9 @@ int main()
     X_TEST(test_time_arithmetic),
     X_TEST(test_time_comparisons),
     X_TEST(test_time_sleep),
-    X_TEST(test_time_now)
+    X_TEST(test_time_now),
+    X_TEST(test_time_ns),
+    X_TEST(test_ticks),
   };
 
   return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
@@ -1,9 +1,14 @@
 #define X_IMPL_TEST
 #include <stdx_test.h>
+#define X_IMPL_STRING
+#include <stdx_string.h>
+#define X_IMPL_IO
+#include <stdx_io.h>
 #define X_IMPL_TML
 #include <stdx_tml.h>
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
 
@@ -311,54 +316,453 @@ int test_tml_iteration_over_objects(void)
   return 0;
 }
 
-/* BTML round-trip: encode, load, navigate */
-int test_btml_roundtrip_and_nav(void)
+/* Indexed and linear lookups agree */
+int test_tml_index_matches_linear(void)
 {
+  XTml *plain = NULL;
+  XTml *indexed = NULL;
+  ASSERT_TRUE(x_tml_load(g_tml_src, (uint32_t)strlen(g_tml_src), XTML_OPEN_DEFAULT, &plain) == 1);
+  ASSERT_TRUE(x_tml_load(g_tml_src, (uint32_t)strlen(g_tml_src), XTML_OPEN_INDEX, &indexed) == 1);
+
+  const char *paths[] = { "level", "level.tutorial", "level.green_hills.objects",
+    "level.0.objects.1", "level.1", "level.2", "level.nope", "objects", "level.tutorial.objects.0.x" };
+
+  for (size_t i = 0; i < sizeof(paths) / sizeof(paths[0]); i++)
+  {
+    XTmlCursor a, b;
+    int ok_a = x_tml_get_section(plain, x_tml_root(plain), paths[i], &a);
+    int ok_b = x_tml_get_section(indexed, x_tml_root(indexed), paths[i], &b);
+    ASSERT_EQ(ok_a, ok_b);
+    if (ok_a)
+      ASSERT_EQ(a.node, b.node);
+  }
+
+  XTmlCursor obj;
+  ASSERT_TRUE(x_tml_get_section(indexed, x_tml_root(indexed), "level.tutorial.objects.0", &obj) == 1);
+  const int64_t *weights = NULL;
+  uint32_t w_n = 0;
+  ASSERT_TRUE(x_tml_get_array_i64(indexed, obj, "weights", &weights, &w_n) == 1);
+  ASSERT_TRUE(w_n == 12);
+  ASSERT_TRUE(x_tml_has_key(indexed, obj, "scale") == 1);
+  ASSERT_TRUE(x_tml_has_key(indexed, obj, "seed") == 0);
+
+  XTmlCursor tut;
+  ASSERT_TRUE(x_tml_get_section(indexed, x_tml_root(indexed), "level.tutorial", &tut) == 1);
+  int64_t seed = 0;
+  ASSERT_TRUE(x_tml_get_i64(indexed, tut, "seed", &seed) == 1);
+  ASSERT_TRUE(seed == 934784);
+  ASSERT_TRUE(x_tml_has_key(indexed, tut, "position") == 0);
+
+  uint32_t n = 0;
+  ASSERT_TRUE(x_tml_child_count(indexed, x_tml_root(indexed), &n) == 1);
+  ASSERT_TRUE(n == 1);
+
+  x_tml_unload(indexed);
+  x_tml_unload(plain);
+  return 0;
+}
+
+/* Thousands of children in one section */
+int test_tml_index_wide_section(void)
+{
+  enum { N = 3000 };
+  static char src[N * 48];
+  uint32_t len = 0;
+  len += (uint32_t)snprintf(src + len, sizeof(src) - len, "scene:\n");
+  for (int i = 0; i < N; i++)
+    len += (uint32_t)snprintf(src + len, sizeof(src) - len, "  node_%d:\n    id: %d\n    tag: \"t%d\"\n", i, i, i);
+
   XTml *doc = NULL;
-  int ok = x_tml_load(g_tml_src, (uint32_t)strlen(g_tml_src), 0, &doc);
-  ASSERT_TRUE(ok == 1);
+  ASSERT_TRUE(x_tml_load(src, len, XTML_OPEN_INDEX, &doc) == 1);
+
+  XTmlCursor scene;
+  ASSERT_TRUE(x_tml_get_section(doc, x_tml_root(doc), "scene", &scene) == 1);
+  uint32_t n = 0;
+  ASSERT_TRUE(x_tml_child_count(doc, scene, &n) == 1);
+  ASSERT_TRUE(n == N);
+
+  char name[32];
+  for (int i = 0; i < N; i += 7)
+  {
+    uint32_t nl = (uint32_t)snprintf(name, sizeof(name), "node_%d", i);
+    XTmlCursor child, at;
+    ASSERT_TRUE(x_tml_find_child(doc, scene, name, nl, &child) == 1);
+    ASSERT_TRUE(x_tml_child_at(doc, scene, (uint32_t)i, &at) == 1);
+    ASSERT_EQ(child.node, at.node);
+
+    int64_t id = -1;
+    ASSERT_TRUE(x_tml_get_i64(doc, child, "id", &id) == 1);
+    ASSERT_TRUE(id == i);
+  }
 
+  XTmlCursor missing;
+  ASSERT_TRUE(x_tml_find_child(doc, scene, "node_3000", 9, &missing) == 0);
+  ASSERT_TRUE(x_tml_child_at(doc, scene, N, &missing) == 0);
+
+  x_tml_unload(doc);
+
+  /* Duplicate sections are still rejected with the index */
+  const char *dup = "a:\n  b:\n    x: 1\n  b:\n    x: 2\n";
+  ASSERT_TRUE(x_tml_load(dup, (uint32_t)strlen(dup), XTML_OPEN_INDEX, &doc) == 0);
+  return 0;
+}
+
+/* Compiled paths resolve like x_tml_get_section */
+int test_tml_path_compile(void)
+{
+  XTmlPath path;
+  ASSERT_TRUE(x_tml_path_compile("level.tutorial.objects.1", &path) == 1);
+  ASSERT_TRUE(path.seg_count == 4);
+  ASSERT_TRUE(path.segs[3].index == 1);
+  ASSERT_TRUE(path.segs[0].index == UINT32_MAX);
+
+  for (int pass = 0; pass < 2; pass++)
+  {
+    XTml *doc = NULL;
+    ASSERT_TRUE(x_tml_load(g_tml_src, (uint32_t)strlen(g_tml_src), pass ? XTML_OPEN_INDEX : 0, &doc) == 1);
+
+    XTmlCursor a, b;
+    ASSERT_TRUE(x_tml_path_resolve(doc, x_tml_root(doc), &path, &a) == 1);
+    ASSERT_TRUE(x_tml_get_section(doc, x_tml_root(doc), "level.tutorial.objects.1", &b) == 1);
+    ASSERT_EQ(a.node, b.node);
+
+    XTmlPath rel;
+    ASSERT_TRUE(x_tml_path_compile("objects.0", &rel) == 1);
+    XTmlCursor tut, obj;
+    ASSERT_TRUE(x_tml_get_section(doc, x_tml_root(doc), "level.green_hills", &tut) == 1);
+    ASSERT_TRUE(x_tml_path_resolve(doc, tut, &rel, &obj) == 1);
+    ASSERT_TRUE(x_tml_has_key(doc, obj, "weights") == 1);
+
+    XTmlPath bad;
+    ASSERT_TRUE(x_tml_path_compile("level.missing", &bad) == 1);
+    ASSERT_TRUE(x_tml_path_resolve(doc, x_tml_root(doc), &bad, &obj) == 0);
+
+    x_tml_unload(doc);
+  }
+
+  char longpath[X_TML_PATH_MAX_LENGTH + 8];
+  memset(longpath, 'a', sizeof(longpath) - 1);
+  longpath[sizeof(longpath) - 1] = 0;
+  ASSERT_TRUE(x_tml_path_compile(longpath, &path) == 0);
+  ASSERT_TRUE(x_tml_path_compile("a.b.c.d.e.f.g.h.i.j.k.l.m.n.o.p.q", &path) == 0);
+  return 0;
+}
+
+/* Binary round-trip: save, map, navigate */
+int test_tml_binary_roundtrip_and_nav(void)
+{
   const char *tmp_path = "tmp_scene.btml";
 
-  ok = x_btml_encode_to_file(doc, tmp_path);
-  ASSERT_TRUE(ok == 1);
+  for (int pass = 0; pass < 2; pass++)
+  {
+    XTml *doc = NULL;
+    int ok = x_tml_load(g_tml_src, (uint32_t)strlen(g_tml_src), pass ? XTML_OPEN_INDEX : 0, &doc);
+    ASSERT_TRUE(ok == 1);
+
+    ok = x_tml_save_binary(doc, tmp_path);
+    ASSERT_TRUE(ok == 1);
+    x_tml_unload(doc);
+
+    XTml *bin = NULL;
+    ok = x_tml_load_binary(tmp_path, &bin);
+    ASSERT_TRUE(ok == 1);
+
+    XTmlCursor level;
+    ok = x_tml_get_section(bin, x_tml_root(bin), "level", &level);
+    ASSERT_TRUE(ok == 1);
+
+    uint32_t n_lv = 0;
+    ok = x_tml_child_count(bin, level, &n_lv);
+    ASSERT_TRUE(ok == 1);
+    ASSERT_TRUE(n_lv == 2);
+
+    XTmlCursor tut;
+    ok = x_tml_get_section(bin, level, "tutorial", &tut);
+    ASSERT_TRUE(ok == 1);
+
+    int64_t seed = 0;
+    ASSERT_TRUE(x_tml_get_i64(bin, tut, "seed", &seed) == 1);
+    ASSERT_TRUE(seed == 934784);
+
+    const char *desc = NULL;
+    uint32_t desc_len = 0;
+    ASSERT_TRUE(x_tml_get_str(bin, tut, "description", &desc, &desc_len) == 1);
+    ASSERT_TRUE(desc_len > 22 && memcmp(desc + 4, "Multi line strings are", 22) == 0);
+
+    XTmlCursor objs;
+    ok = x_tml_get_section(bin, tut, "objects", &objs);
+    ASSERT_TRUE(ok == 1);
+
+    uint32_t n_objs = 0;
+    ok = x_tml_child_count(bin, objs, &n_objs);
+    ASSERT_TRUE(ok == 1);
+    ASSERT_TRUE(n_objs == 2);
+
+    XTmlCursor obj1;
+    ok = x_tml_child_at(bin, objs, 1, &obj1);
+    ASSERT_TRUE(ok == 1);
+
+    const double *pos = NULL;
+    uint32_t pos_n = 0;
+    ASSERT_TRUE(x_tml_get_array_f64(bin, obj1, "position", &pos, &pos_n) == 1);
+    ASSERT_TRUE(pos_n == 3 && pos[0] == 7.0);
+
+    XTmlPath path;
+    XTmlCursor via_path;
+    ASSERT_TRUE(x_tml_path_compile("level.tutorial.objects.1", &path) == 1);
+    ASSERT_TRUE(x_tml_path_resolve(bin, x_tml_root(bin), &path, &via_path) == 1);
+    ASSERT_EQ(via_path.node, obj1.node);
+
+    x_tml_unload(bin);
+  }
 
-  XBtml bin;
-  memset(&bin, 0, sizeof(bin));
+  remove(tmp_path);
+  return 0;
+}
 
-  ok = x_btml_load_from_file(tmp_path, &bin);
-  ASSERT_TRUE(ok == 1);
+/* In-memory blobs, string arrays and rejected input */
+int test_tml_binary_mem(void)
+{
+  const char *src =
+    "enemy:\n"
+    "  tags: \"boss\", \"flying\", \"red\"\n"
+    "  hp: 250\n";
+  const char *tmp_path = "tmp_tags.btml";
 
-  int node_level = -1;
-  ok = x_btml_get_section_by_dotpath(&bin, -1, "level", &node_level);
-  ASSERT_TRUE(ok == 1);
-  ASSERT_TRUE(node_level >= 0);
+  XTml *doc = NULL;
+  ASSERT_TRUE(x_tml_load(src, (uint32_t)strlen(src), XTML_OPEN_INDEX, &doc) == 1);
+  ASSERT_TRUE(x_tml_save_binary(doc, tmp_path) == 1);
+  x_tml_unload(doc);
 
-  uint32_t n_lv = 0;
-  ok = x_btml_child_count(&bin, node_level, &n_lv);
-  ASSERT_TRUE(ok == 1);
-  ASSERT_TRUE(n_lv == 2);
+  size_t size = 0;
+  char *blob = x_io_read_text(tmp_path, &size);
+  ASSERT_TRUE(blob != NULL);
+  remove(tmp_path);
+
+  XTml *bin = NULL;
+  ASSERT_TRUE(x_tml_load_binary_mem(blob, size, &bin) == 1);
+
+  XTmlCursor enemy;
+  ASSERT_TRUE(x_tml_get_section(bin, x_tml_root(bin), "enemy", &enemy) == 1);
+  const XTmlStrSlice *tags = NULL;
+  uint32_t n_tags = 0;
+  ASSERT_TRUE(x_tml_get_array_str(bin, enemy, "tags", &tags, &n_tags) == 1);
+  ASSERT_TRUE(n_tags == 3);
+  ASSERT_TRUE(tags[1].len == 6 && memcmp(tags[1].ptr, "flying", 6) == 0);
+  int64_t hp = 0;
+  ASSERT_TRUE(x_tml_get_i64(bin, enemy, "hp", &hp) == 1);
+  ASSERT_TRUE(hp == 250);
+  x_tml_unload(bin);
+
+  /* Truncated, wrong version and plain text are all refused */
+  ASSERT_TRUE(x_tml_load_binary_mem(blob, size - 8, &bin) == 0);
+  blob[4] ^= 0x7f;
+  ASSERT_TRUE(x_tml_load_binary_mem(blob, size, &bin) == 0);
+  ASSERT_TRUE(x_tml_load_binary_mem(g_tml_src, strlen(g_tml_src), &bin) == 0);
+  ASSERT_TRUE(x_tml_load_binary("does_not_exist.btml", &bin) == 0);
+
+  free(blob);
+  return 0;
+}
 
-  int node_tut = -1;
-  ok = x_btml_get_section_by_dotpath(&bin, node_level, "tutorial", &node_tut);
-  ASSERT_TRUE(ok == 1);
+/* Stream events are logged as text so chunked and whole parses can be compared */
+typedef struct TmlStreamLog
+{
+  char     buf[8192];
+  uint32_t len;
+  uint32_t kv;
+  uint32_t elements;
+  uint32_t stop_after;  /* stop at this key/value when non-zero */
+  int64_t  seed;
+} TmlStreamLog;
+
+static void s_log(TmlStreamLog *log, const char *tag, const char *s, uint32_t n)
+{
+  int w = snprintf(log->buf + log->len, sizeof(log->buf) - log->len, "%s:%.*s;", tag, (int)n, s);
+  if (w > 0 && log->len + (uint32_t)w < sizeof(log->buf))
+    log->len += (uint32_t)w;
+}
 
-  int node_objs = -1;
-  ok = x_btml_get_section_by_dotpath(&bin, node_tut, "objects", &node_objs);
-  ASSERT_TRUE(ok == 1);
+static void s_log_scalar(TmlStreamLog *log, const XTmlScalar *v)
+{
+  char tmp[64];
+  switch (v->kind)
+  {
+    case XTML_V_STR:  s_log(log, "s", v->str, v->len); return;
+    case XTML_V_I64:  snprintf(tmp, sizeof(tmp), "%lld", (long long)v->i64); break;
+    case XTML_V_F64:  snprintf(tmp, sizeof(tmp), "%g", v->f64); break;
+    case XTML_V_BOOL: snprintf(tmp, sizeof(tmp), "%s", v->boolean ? "true" : "false"); break;
+    default:          snprintf(tmp, sizeof(tmp), "?"); break;
+  }
+  s_log(log, "v", tmp, (uint32_t)strlen(tmp));
+}
 
-  uint32_t n_objs = 0;
-  ok = x_btml_child_count(&bin, node_objs, &n_objs);
-  ASSERT_TRUE(ok == 1);
-  ASSERT_TRUE(n_objs == 2);
+static int s_on_section_begin(void *user, const char *name, uint32_t len)
+{
+  s_log((TmlStreamLog *)user, "{", name, len);
+  return 1;
+}
 
-  int node_obj1 = -1;
-  ok = x_btml_child_at(&bin, node_objs, 1, &node_obj1);
-  ASSERT_TRUE(ok == 1);
-  ASSERT_TRUE(node_obj1 >= 0);
+static int s_on_section_end(void *user)
+{
+  s_log((TmlStreamLog *)user, "}", "", 0);
+  return 1;
+}
+
+static int s_on_key_value(void *user, const char *key, uint32_t len, const XTmlScalar *v)
+{
+  TmlStreamLog *log = (TmlStreamLog *)user;
+  s_log(log, "k", key, len);
+  s_log_scalar(log, v);
+  if (len == 4 && memcmp(key, "seed", 4) == 0 && v->kind == XTML_V_I64)
+    log->seed = v->i64;
+  log->kv++;
+  return log->stop_after == 0 || log->kv < log->stop_after;
+}
+
+static int s_on_array_begin(void *user, const char *key, uint32_t len)
+{
+  s_log((TmlStreamLog *)user, "[", key, len);
+  ((TmlStreamLog *)user)->elements = 0;
+  return 1;
+}
 
-  x_btml_unload(&bin);
+static int s_on_array_element(void *user, const XTmlScalar *v)
+{
+  s_log_scalar((TmlStreamLog *)user, v);
+  ((TmlStreamLog *)user)->elements++;
+  return 1;
+}
+
+static int s_on_array_end(void *user)
+{
+  TmlStreamLog *log = (TmlStreamLog *)user;
+  char tmp[16];
+  snprintf(tmp, sizeof(tmp), "%u", log->elements);
+  s_log(log, "]", tmp, (uint32_t)strlen(tmp));
+  return 1;
+}
+
+static const XTmlStreamCallbacks s_log_callbacks =
+{
+  s_on_section_begin, s_on_section_end, s_on_key_value,
+  s_on_array_begin, s_on_array_element, s_on_array_end
+};
+
+static int s_stream_chunked(const char *src, size_t chunk, uint32_t max_record, TmlStreamLog *log)
+{
+  XTmlStream *st = x_tml_stream_create(&s_log_callbacks, log, max_record);
+  if (!st)
+    return 0;
+  size_t len = strlen(src);
+  int ok = 1;
+  for (size_t at = 0; at < len && ok; at += chunk)
+    ok = x_tml_stream_feed(st, src + at, (at + chunk <= len) ? chunk : len - at);
+  ok = ok && x_tml_stream_finish(st);
+  x_tml_stream_destroy(st);
+  return ok;
+}
+
+/* The same events come out whatever the chunk size, matching the loaded tree */
+int test_tml_stream_chunks(void)
+{
+  static TmlStreamLog whole, one, seven;
+  memset(&whole, 0, sizeof(whole));
+  memset(&one, 0, sizeof(one));
+  memset(&seven, 0, sizeof(seven));
+
+  ASSERT_TRUE(s_stream_chunked(g_tml_src, strlen(g_tml_src), 0, &whole) == 1);
+  ASSERT_TRUE(s_stream_chunked(g_tml_src, 1, 0, &one) == 1);
+  ASSERT_TRUE(s_stream_chunked(g_tml_src, 7, 0, &seven) == 1);
+  ASSERT_EQ(whole.len, one.len);
+  ASSERT_EQ(whole.len, seven.len);
+  ASSERT_TRUE(memcmp(whole.buf, one.buf, whole.len) == 0);
+  ASSERT_TRUE(memcmp(whole.buf, seven.buf, whole.len) == 0);
+
+  ASSERT_TRUE(whole.seed == 934784);
+  ASSERT_TRUE(strncmp(whole.buf, "{:level;{:tutorial;k:enabled;v:true;k:seed;v:934784;", 52) == 0);
+  ASSERT_TRUE(strstr(whole.buf, "{:objects;{:;[:position;v:1;v:2;v:0;]:3;") != NULL);
+  ASSERT_TRUE(strstr(whole.buf, "[:weights;v:10;v:20;v:40;v:103;v:99;v:71;v:44;v:-1;v:18;v:5;v:7;v:91;]:12;") != NULL);
+  ASSERT_TRUE(strstr(whole.buf, "]:12;}:;{:;") != NULL);
+
+  /* The triple-quoted string is the one x_tml_load produces */
+  XTml *doc = NULL;
+  XTmlCursor tut;
+  const char *desc = NULL;
+  uint32_t desc_len = 0;
+  ASSERT_TRUE(x_tml_load(g_tml_src, (uint32_t)strlen(g_tml_src), 0, &doc) == 1);
+  ASSERT_TRUE(x_tml_get_section(doc, x_tml_root(doc), "level", &tut) == 1);
+  ASSERT_TRUE(x_tml_get_section(doc, tut, "tutorial", &tut) == 1);
+  ASSERT_TRUE(x_tml_get_str(doc, tut, "description", &desc, &desc_len) == 1);
+  char expect[256];
+  snprintf(expect, sizeof(expect), "k:description;s:%.*s;", (int)desc_len, desc);
+  ASSERT_TRUE(strstr(whole.buf, expect) != NULL);
   x_tml_unload(doc);
+
+  /* Every section that opened has closed */
+  uint32_t opened = 0, closed = 0;
+  for (uint32_t i = 0; i + 1 < whole.len; i++)
+  {
+    if (whole.buf[i + 1] == ':' && (i == 0 || whole.buf[i - 1] == ';'))
+    {
+      opened += whole.buf[i] == '{';
+      closed += whole.buf[i] == '}';
+    }
+  }
+  ASSERT_TRUE(opened == 9);
+  ASSERT_EQ(opened, closed);
+  return 0;
+}
+
+/* Reader input, limits, invalid input and early stop */
+int test_tml_stream_reader_and_errors(void)
+{
+  static TmlStreamLog a, b;
+  const char *tmp_path = "tmp_stream.tml";
+  memset(&a, 0, sizeof(a));
+  memset(&b, 0, sizeof(b));
+
+  ASSERT_TRUE(x_io_write_text(tmp_path, g_tml_src));
+  XFile *f = x_io_open(tmp_path, "rb");
+  ASSERT_TRUE(f != NULL);
+  XReader *reader = x_reader_create(f, 64);
+  ASSERT_TRUE(reader != NULL);
+  XTmlStream *st = x_tml_stream_create(&s_log_callbacks, &a, 0);
+  ASSERT_TRUE(x_tml_stream_read(st, reader) == 1);
+  x_tml_stream_destroy(st);
+  x_reader_destroy(reader);
+  x_io_close(f);
+  remove(tmp_path);
+
+  ASSERT_TRUE(s_stream_chunked(g_tml_src, 64, 0, &b) == 1);
+  ASSERT_EQ(a.len, b.len);
+  ASSERT_TRUE(memcmp(a.buf, b.buf, a.len) == 0);
+
+  /* A line longer than max_record fails at that line */
+  memset(&a, 0, sizeof(a));
+  ASSERT_TRUE(s_stream_chunked("a:\n  b: 1\n  c: 0123456789012345678901234567890123456789\n", 5, 32, &a) == 0);
+  ASSERT_TRUE(a.kv == 1);
+
+  /* Tabs, odd indent units and numeric section names are rejected */
+  st = x_tml_stream_create(&s_log_callbacks, &a, 0);
+  ASSERT_TRUE(x_tml_stream_feed(st, "a:\n\tb: 1\n", 9) == 0);
+  ASSERT_TRUE(x_tml_stream_line(st) == 2);
+  x_tml_stream_destroy(st);
+  memset(&a, 0, sizeof(a));
+  ASSERT_TRUE(s_stream_chunked("a:\n   b: 1\n", 3, 0, &a) == 0);
+  ASSERT_TRUE(s_stream_chunked("1a:\n  b: 1\n", 3, 0, &a) == 0);
+
+  /* A callback returning 0 stops everything after it */
+  memset(&a, 0, sizeof(a));
+  a.stop_after = 2;
+  ASSERT_TRUE(s_stream_chunked(g_tml_src, 13, 0, &a) == 0);
+  ASSERT_TRUE(a.kv == 2);
+  ASSERT_TRUE(strstr(a.buf, "description") == NULL);
+
+  /* No trailing newline; an unterminated array and sections still close */
+  memset(&a, 0, sizeof(a));
+  ASSERT_TRUE(s_stream_chunked("a:\n  name: \"x.y, z\"\n  v: 1, 2,", 4, 0, &a) == 1);
+  ASSERT_TRUE(strcmp(a.buf, "{:a;k:name;s:x.y, z;[:v;v:1;v:2;]:2;}:;") == 0);
   return 0;
 }
 
@@ -374,10 +778,15 @@ int main()
     X_TEST(test_tml_arrays_numeric_single_and_multiline),
     X_TEST(test_tml_missing_and_error_paths),
     X_TEST(test_tml_iteration_over_objects),
-    X_TEST(test_btml_roundtrip_and_nav)
-
+    X_TEST(test_tml_index_matches_linear),
+    X_TEST(test_tml_index_wide_section),
+    X_TEST(test_tml_path_compile),
+    X_TEST(test_tml_binary_roundtrip_and_nav),
+    X_TEST(test_tml_binary_mem),
+    X_TEST(test_tml_stream_chunks),
+    X_TEST(test_tml_stream_reader_and_errors),
   };
 
-  return stdx_run_tests(tests, sizeof(tests)/sizeof(tests[0]));
+  return x_tests_run(tests, sizeof(tests)/sizeof(tests[0]), NULL);
 }
 